@@ -12,9 +12,35 @@ find_library(LIBSSH_LIBRARY
     libssh
 )
 
+if(LIBSSH_INCLUDE_DIR)
+  # Newer releases keep the version in a header of its own
+  if(EXISTS "${LIBSSH_INCLUDE_DIR}/libssh/libssh_version.h")
+    set(LIBSSH_VERSION_FILE "${LIBSSH_INCLUDE_DIR}/libssh/libssh_version.h")
+  else()
+    set(LIBSSH_VERSION_FILE "${LIBSSH_INCLUDE_DIR}/libssh/libssh.h")
+  endif()
+  file(STRINGS "${LIBSSH_VERSION_FILE}"
+    LIBSSH_VERSION_MAJOR REGEX "^#define[ \t]+LIBSSH_VERSION_MAJOR[ \t]+[0-9]+")
+  file(STRINGS "${LIBSSH_VERSION_FILE}"
+    LIBSSH_VERSION_MINOR REGEX "^#define[ \t]+LIBSSH_VERSION_MINOR[ \t]+[0-9]+")
+  file(STRINGS "${LIBSSH_VERSION_FILE}"
+    LIBSSH_VERSION_MICRO REGEX "^#define[ \t]+LIBSSH_VERSION_MICRO[ \t]+[0-9]+")
+  string(REGEX REPLACE "[^0-9]+" "" LIBSSH_VERSION_MAJOR "${LIBSSH_VERSION_MAJOR}")
+  string(REGEX REPLACE "[^0-9]+" "" LIBSSH_VERSION_MINOR "${LIBSSH_VERSION_MINOR}")
+  string(REGEX REPLACE "[^0-9]+" "" LIBSSH_VERSION_MICRO "${LIBSSH_VERSION_MICRO}")
+  set(LIBSSH_VERSION "${LIBSSH_VERSION_MAJOR}.${LIBSSH_VERSION_MINOR}.${LIBSSH_VERSION_MICRO}")
+  unset(LIBSSH_VERSION_MICRO)
+  unset(LIBSSH_VERSION_MINOR)
+  unset(LIBSSH_VERSION_MAJOR)
+  unset(LIBSSH_VERSION_FILE)
+endif()
+
 include(FindPackageHandleStandardArgs)
-find_package_handle_standard_args(Libssh DEFAULT_MSG
-                                  LIBSSH_LIBRARY LIBSSH_INCLUDE_DIR)
+# handle the QUIETLY and REQUIRED arguments and set LIBSSH_FOUND to TRUE
+# if all listed variables are TRUE and the requested version matches.
+find_package_handle_standard_args(Libssh REQUIRED_VARS
+                                  LIBSSH_LIBRARY LIBSSH_INCLUDE_DIR
+                                  VERSION_VAR LIBSSH_VERSION)
 
 if(LIBSSH_FOUND)
   set(LIBSSH_LIBRARIES ${LIBSSH_LIBRARY})
@@ -833,7 +833,7 @@ main(int argc, char** argv)
    else if (need_server_conn)
    {
       /* Remote connection (host/port supplied) */
-      if (pgmoneta_connect(host, atoi(port), &socket))
+      if (pgmoneta_connect(host, atoi(port), NULL, &socket))
       {
          warnx("pgmoneta-cli: Cannot reach the server at '%s:%s'. Check network connection and firewall settings.", host, port);
          exit_code = 1;
@@ -62,10 +62,12 @@ pgmoneta_archive(SSL* ssl, int client_fd, int server, uint8_t compression, uint8
  * @param buffer The stream buffer
  * @param basedir The base directory for the backup data
  * @param tablespaces The user level tablespaces
+ * @param file_digests [out] The digests of the written files, may be NULL
+ * @param file_trees [out] The tree digests of large files, may be NULL
  * @return 0 upon success, otherwise 1
  */
 int
-pgmoneta_receive_archive_files(int srv, SSL* ssl, int socket, struct stream_buffer* buffer, char* basedir, struct tablespace* tablespaces);
+pgmoneta_receive_archive_files(int srv, SSL* ssl, int socket, struct stream_buffer* buffer, char* basedir, struct tablespace* tablespaces, struct art* file_digests, struct art* file_trees);
 
 /**
  * Receive backup tar files from the copy stream and write to disk
@@ -76,10 +78,12 @@ pgmoneta_receive_archive_files(int srv, SSL* ssl, int socket, struct stream_buff
  * @param buffer The stream buffer
  * @param basedir The base directory for the backup data
  * @param tablespaces The user level tablespaces
+ * @param file_digests [out] The digests of the written files, may be NULL
+ * @param file_trees [out] The tree digests of large files, may be NULL
  * @return 0 upon success, otherwise 1
  */
 int
-pgmoneta_receive_archive_stream(int srv, SSL* ssl, int socket, struct stream_buffer* buffer, char* basedir, struct tablespace* tablespaces);
+pgmoneta_receive_archive_stream(int srv, SSL* ssl, int socket, struct stream_buffer* buffer, char* basedir, struct tablespace* tablespaces, struct art* file_digests, struct art* file_trees);
 
 /**
  * Extract from a tar file to a given directory
@@ -87,10 +91,12 @@ pgmoneta_receive_archive_stream(int srv, SSL* ssl, int socket, struct stream_buf
  * @param destination The destination to extract to
  * @param checksums [out] The file checksums
  * @param sizes [out] The file sizes
+ * @param file_digests [out] The digests of the written files, may be NULL
+ * @param file_trees [out] The tree digests of large files, may be NULL
  * @return 0 upon success, otherwise 1
  */
 int
-pgmoneta_extract_backup_tar_file(char* file_path, char* destination, struct art* file_checksums, struct art* file_sizes);
+pgmoneta_extract_backup_tar_file(char* file_path, char* destination, struct art* file_checksums, struct art* file_sizes, struct art* file_digests, struct art* file_trees);
 
 #ifdef __cplusplus
 }
@@ -38,6 +38,12 @@ extern "C" {
 #define GCM_TAG_LENGTH     16
 #define AES_GCM_IV_LENGTH  12
 
+#define AES_CHUNK_MAGIC         "PGMAESC"
+#define AES_CHUNK_MAGIC_LENGTH  7
+#define AES_CHUNK_VERSION       1
+#define AES_CHUNK_SIZE          (1024 * 1024)
+#define AES_CHUNK_HEADER_LENGTH (AES_CHUNK_MAGIC_LENGTH + 1 + 4 + PBKDF2_SALT_LENGTH + AES_GCM_IV_LENGTH)
+
 #include <pgmoneta.h>
 #include <json.h>
 #include <workers.h>
@@ -240,6 +246,27 @@ pgmoneta_decrypt_buffer(unsigned char* origin_buffer, size_t origin_size, unsign
 bool
 pgmoneta_is_encrypted(char* file_path);
 
+/**
+ * Is the file using the chunked encryption format
+ * @param file_path The file path
+ * @return True if chunked, otherwise false
+ */
+bool
+pgmoneta_is_encrypted_chunked(char* file_path);
+
+/**
+ * Decrypt a range of a chunked encrypted file. Only the chunks
+ * covering the range are read and authenticated
+ * @param from The encrypted file
+ * @param offset The plaintext offset
+ * @param length The plaintext length
+ * @param buffer [out] The plaintext, must be freed by the caller
+ * @param size [out] The plaintext size, smaller than length at the end of the file
+ * @return 0 upon success, otherwise 1
+ */
+int
+pgmoneta_decrypt_file_range(char* from, uint64_t offset, size_t length, unsigned char** buffer, size_t* size);
+
 #ifdef __cplusplus
 }
 #endif
@@ -49,8 +49,9 @@ typedef void (*value_destroy_callback)(void* value);
  */
 struct art
 {
-   struct art_node* root; /**< The root node of ART */
-   uint64_t size;         /**< The size of the ART */
+   struct art_node* root;   /**< The root node of ART */
+   uint64_t size;           /**< The size of the ART */
+   struct art_arena* arena; /**< The arena the nodes and leaves are allocated from */
 };
 
 /** @struct art_iterator
@@ -95,6 +96,20 @@ pgmoneta_art_insert(struct art* t, char* key, uintptr_t value, enum value_type t
 int
 pgmoneta_art_insert_with_config(struct art* t, char* key, uintptr_t value, struct value_config* config);
 
+/**
+ * Load keys sorted in ascending byte order into the ART tree.
+ * The nodes are built bottom up without intermediate node growth,
+ * input that isn't sorted or a tree that isn't empty falls back to regular inserts
+ * @param t The tree
+ * @param keys The keys
+ * @param values The value data
+ * @param type The value type
+ * @param count The number of keys
+ * @return 0 if the items were successfully inserted, otherwise 1
+ */
+int
+pgmoneta_art_bulk_load(struct art* t, char** keys, uintptr_t* values, enum value_type type, uint64_t count);
+
 /**
  * Check if a key exists in the ART tree
  * @param t The tree
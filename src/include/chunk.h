@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2026 The pgmoneta community
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or other
+ * materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may
+ * be used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PGMONETA_CHUNK_H
+#define PGMONETA_CHUNK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <pgmoneta.h>
+#include <deque.h>
+#include <workers.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/*
+ * Files are split with FastCDC into content-defined chunks, which are stored
+ * once by SHA-256 under <server>/chunks/<2 hex>/<64 hex>. A chunked backup has
+ * a backup.chunks index next to backup.manifest listing, for each chunked file,
+ *
+ *   <path>,<size>,<number of chunks>
+ *   <sha256>,<length>
+ *   ...
+ *
+ * with paths relative to the data directory. The chunked files are removed
+ * from the backup.
+ */
+#define CHUNK_MIN_SIZE       (16 * 1024)
+#define CHUNK_AVERAGE_SIZE   (64 * 1024)
+#define CHUNK_MAX_SIZE       (256 * 1024)
+#define CHUNK_MIN_FILE_SIZE  CHUNK_AVERAGE_SIZE
+
+#define CHUNK_INDEX          "backup.chunks"
+#define CHUNK_REHYDRATED     "chunks"
+
+/**
+ * Find the next chunk boundary
+ * @param data The data
+ * @param size The size of the data
+ * @return The length of the chunk starting at data
+ */
+size_t
+pgmoneta_chunk_cut(unsigned char* data, size_t size);
+
+/**
+ * Chunk the regular files of a directory into a chunk store. Symbolic
+ * links and files smaller than CHUNK_MIN_FILE_SIZE are left as they are
+ * @param store The chunk store
+ * @param directory The directory
+ * @param index The path of the index to write
+ * @param workers The optional workers
+ * @param chunked [out] The number of bytes chunked
+ * @param stored [out] The number of bytes added to the chunk store
+ * @return 0 upon success, otherwise 1
+ */
+int
+pgmoneta_chunk_directory(char* store, char* directory, char* index, struct workers* workers,
+                         uint64_t* chunked, uint64_t* stored);
+
+/**
+ * Restore the chunked files of an index into a directory
+ * @param store The chunk store
+ * @param index The path of the index
+ * @param directory The directory
+ * @param workers The optional workers
+ * @return 0 upon success, otherwise 1
+ */
+int
+pgmoneta_chunk_restore(char* store, char* index, char* directory, struct workers* workers);
+
+/**
+ * Remove the chunks that no index refers to
+ * @param store The chunk store
+ * @param indexes The paths of the indexes in use
+ * @param removed [out] The number of bytes removed
+ * @return 0 upon success, otherwise 1
+ */
+int
+pgmoneta_chunk_collect(char* store, struct deque* indexes, uint64_t* removed);
+
+/**
+ * Is a backup chunked
+ * @param server The server
+ * @param label The label
+ * @return True if chunked, otherwise false
+ */
+bool
+pgmoneta_chunk_is_chunked(int server, char* label);
+
+/**
+ * Get the directory in the workspace that a chunked backup is rehydrated into
+ * @param server The server
+ * @param label The label
+ * @return The directory
+ */
+char*
+pgmoneta_chunk_get_rehydrated(int server, char* label);
+
+/**
+ * Restore the chunked files of a backup into a temporary directory in the
+ * workspace. The backup stays chunked
+ * @param server The server
+ * @param label The label
+ * @return 0 upon success, otherwise 1
+ */
+int
+pgmoneta_chunk_rehydrate(int server, char* label);
+
+/**
+ * Remove the temporary directory of a rehydrated backup
+ * @param server The server
+ * @param label The label
+ */
+void
+pgmoneta_chunk_rehydrate_remove(int server, char* label);
+
+/**
+ * Remove the chunks that no backup of a server refers to
+ * @param server The server
+ * @return 0 upon success, otherwise 1
+ */
+int
+pgmoneta_chunk_collect_server(int server);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -48,13 +48,26 @@ extern "C" {
 /* Main configuration fields */
 #define CONFIGURATION_ARGUMENT_ADMIN_CONF_PATH         "admin_configuration_path"
 #define CONFIGURATION_ARGUMENT_AZURE_BASE_DIR          "azure_base_dir"
+#define CONFIGURATION_ARGUMENT_AZURE_BLOCK_SIZE        "azure_block_size"
 #define CONFIGURATION_ARGUMENT_AZURE_CONTAINER         "azure_container"
+#define CONFIGURATION_ARGUMENT_AZURE_ENDPOINT          "azure_endpoint"
+#define CONFIGURATION_ARGUMENT_AZURE_PORT              "azure_port"
 #define CONFIGURATION_ARGUMENT_AZURE_SHARED_KEY        "azure_shared_key"
 #define CONFIGURATION_ARGUMENT_AZURE_STORAGE_ACCOUNT   "azure_storage_account"
+#define CONFIGURATION_ARGUMENT_AZURE_USE_TLS           "azure_use_tls"
 #define CONFIGURATION_ARGUMENT_BACKLOG                 "backlog"
 #define CONFIGURATION_ARGUMENT_MAX_RATE                "max_rate"
+#define CONFIGURATION_ARGUMENT_SOCKET_RCVBUF           "socket_rcvbuf"
+#define CONFIGURATION_ARGUMENT_SOCKET_SNDBUF           "socket_sndbuf"
+#define CONFIGURATION_ARGUMENT_TCP_WINDOW_CLAMP        "tcp_window_clamp"
+#define CONFIGURATION_ARGUMENT_TCP_NOTSENT_LOWAT       "tcp_notsent_lowat"
+#define CONFIGURATION_ARGUMENT_BUSY_POLL               "busy_poll"
+#define CONFIGURATION_ARGUMENT_IO_MAX_RATE             "io_max_rate"
+#define CONFIGURATION_ARGUMENT_IO_MAX_IOPS             "io_max_iops"
 #define CONFIGURATION_ARGUMENT_BASE_DIR                "base_dir"
 #define CONFIGURATION_ARGUMENT_BLOCKING_TIMEOUT        "blocking_timeout"
+#define CONFIGURATION_ARGUMENT_CHUNK_STORE             "chunk_store"
+#define CONFIGURATION_ARGUMENT_CHUNK_STORE_SHARED      "chunk_store_shared"
 #define CONFIGURATION_ARGUMENT_COMPRESSION             "compression"
 #define CONFIGURATION_ARGUMENT_COMPRESSION_LEVEL       "compression_level"
 #define CONFIGURATION_ARGUMENT_CONSOLE                 "console"
@@ -70,6 +83,7 @@ extern "C" {
 #define CONFIGURATION_ARGUMENT_HUGEPAGE                "hugepage"
 #define CONFIGURATION_ARGUMENT_KEEP_ALIVE              "keep_alive"
 #define CONFIGURATION_ARGUMENT_LIBEV                   "libev"
+#define CONFIGURATION_ARGUMENT_LINK_PARANOID           "link_paranoid"
 #define CONFIGURATION_ARGUMENT_LOG_LEVEL               "log_level"
 #define CONFIGURATION_ARGUMENT_LOG_LINE_PREFIX         "log_line_prefix"
 #define CONFIGURATION_ARGUMENT_LOG_MODE                "log_mode"
@@ -96,6 +110,8 @@ extern "C" {
 #define CONFIGURATION_ARGUMENT_S3_USE_TLS              "s3_use_tls"
 #define CONFIGURATION_ARGUMENT_S3_ENDPOINT             "s3_endpoint"
 #define CONFIGURATION_ARGUMENT_S3_PORT                 "s3_port"
+#define CONFIGURATION_ARGUMENT_S3_PART_SIZE            "s3_part_size"
+#define CONFIGURATION_ARGUMENT_S3_DOWNLOAD_CONCURRENCY  "s3_download_concurrency"
 #define CONFIGURATION_ARGUMENT_S3_STORAGE_CLASS        "s3_storage_class"
 #define CONFIGURATION_ARGUMENT_S3_ACCESS_KEY_ID        "s3_access_key_id"
 #define CONFIGURATION_ARGUMENT_S3_REGION               "s3_region"
@@ -106,6 +122,7 @@ extern "C" {
 #define CONFIGURATION_ARGUMENT_SSH_CIPHERS             "ssh_ciphers"
 #define CONFIGURATION_ARGUMENT_SSH_PUBLIC_KEY_FILE     "ssh_public_key_file"
 #define CONFIGURATION_ARGUMENT_SSH_PRIVATE_KEY_FILE    "ssh_private_key_file"
+#define CONFIGURATION_ARGUMENT_SSH_INFLIGHT            "ssh_inflight"
 #define CONFIGURATION_ARGUMENT_SSH_HOSTNAME            "ssh_hostname"
 #define CONFIGURATION_ARGUMENT_SSH_USERNAME            "ssh_username"
 #define CONFIGURATION_ARGUMENT_STORAGE_ENGINE          "storage_engine"
@@ -113,11 +130,16 @@ extern "C" {
 #define CONFIGURATION_ARGUMENT_TLS_CA_FILE             "tls_ca_file"
 #define CONFIGURATION_ARGUMENT_TLS_CERT_FILE           "tls_cert_file"
 #define CONFIGURATION_ARGUMENT_TLS_KEY_FILE            "tls_key_file"
+#define CONFIGURATION_ARGUMENT_TLS_KTLS                "tls_ktls"
+#define CONFIGURATION_ARGUMENT_TREE_HASH               "tree_hash"
 #define CONFIGURATION_ARGUMENT_UNIX_SOCKET_DIR         "unix_socket_dir"
 #define CONFIGURATION_ARGUMENT_UPDATE_PROCESS_TITLE    "update_process_title"
 #define CONFIGURATION_ARGUMENT_USER                    "user"
 #define CONFIGURATION_ARGUMENT_USER_CONF_PATH          "users_configuration_path"
 #define CONFIGURATION_ARGUMENT_VERIFICATION            "verification"
+#define CONFIGURATION_ARGUMENT_VERIFICATION_BUDGET     "verification_budget"
+#define CONFIGURATION_ARGUMENT_WAL_BUNDLE_SIZE         "wal_bundle_size"
+#define CONFIGURATION_ARGUMENT_WAL_BUNDLE_TIMEOUT      "wal_bundle_timeout"
 #define CONFIGURATION_ARGUMENT_WAL_SHIPPING            "wal_shipping"
 #define CONFIGURATION_ARGUMENT_WAL_SLOT                "wal_slot"
 #define CONFIGURATION_ARGUMENT_WORKERS                 "workers"
@@ -37,8 +37,11 @@ extern "C" {
 
 #include <pthread.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
+struct region;
+
 /** @struct deque_node
  * Defines a deque node
  */
@@ -50,6 +53,15 @@ struct deque_node
    struct deque_node* prev; /**< The previous pointer */
 };
 
+/** @struct deque_slot
+ * Defines a slot of a ring buffer deque
+ */
+struct deque_slot
+{
+   struct value data; /**< The value */
+   char* tag;         /**< The tag */
+};
+
 /**
  * Compare two values in a deque
  * @param a The first value
@@ -69,6 +81,11 @@ struct deque
    pthread_rwlock_t mutex;   /**< The mutex of the deque */
    struct deque_node* start; /**< The start node */
    struct deque_node* end;   /**< The end node */
+   struct deque_slot* slots; /**< The ring buffer, NULL for a linked deque */
+   uint32_t capacity;        /**< The capacity of the ring buffer */
+   uint32_t head;            /**< The index of the first slot in the ring buffer */
+   bool intern_tags;         /**< If the tags are interned */
+   struct region* tags;      /**< The region of the interned tags */
 };
 
 /** @struct deque_iterator
@@ -78,6 +95,7 @@ struct deque_iterator
 {
    struct deque* deque;    /**< The deque */
    struct deque_node* cur; /**< The current deque node */
+   int64_t index;          /**< The current position, for a ring buffer deque */
    char* tag;              /**< The current tag */
    struct value* value;    /**< The current value */
 };
@@ -91,6 +109,21 @@ struct deque_iterator
 int
 pgmoneta_deque_create(bool thread_safe, struct deque** deque);
 
+/**
+ * Create a deque backed by a growable ring buffer.
+ * The values are stored inline in one contiguous array, and the tags
+ * can be interned into blocks that are freed together with the deque.
+ * Adding to the deque may move the values, so value pointers obtained
+ * from an iterator are only valid until the next add
+ * @param thread_safe If the deque needs to be thread safe
+ * @param capacity The initial capacity, 0 for the default
+ * @param intern_tags If the tags should be interned
+ * @param deque The deque
+ * @return 0 if success, otherwise 1
+ */
+int
+pgmoneta_deque_create_ring(bool thread_safe, uint32_t capacity, bool intern_tags, struct deque** deque);
+
 /**
  * Add a node to deque's tail, the tag will be copied
  * This function is thread safe
@@ -136,7 +169,8 @@ pgmoneta_deque_add_with_config(struct deque* deque, char* tag, uintptr_t data, s
  * Retrieve value and remove the node from deque's head.
  * Note that if the value was copied into node,
  * this function will return the original value and tag
- * rather than making a copy of it.
+ * rather than making a copy of it. Interned tags are
+ * returned as a copy, so the tag is always owned by the caller.
  * This function is thread safe, but the returned value is not protected
  * @param deque The deque
  * @param tag [out] Optional, tag will be returned through if not NULL
@@ -149,7 +183,8 @@ pgmoneta_deque_poll(struct deque* deque, char** tag);
  * Retrieve value and remove the node from deque's tail.
  * Note that if the value was copied into node,
  * this function will return the original value and tag
- * rather than making a copy of it.
+ * rather than making a copy of it. Interned tags are
+ * returned as a copy, so the tag is always owned by the caller.
  * This function is thread safe, but the returned value is not protected
  * @param deque The deque
  * @param tag [out] Optional, tag will be returned through if not NULL
@@ -72,6 +72,9 @@ struct http_request
    struct http_payload payload; /**< Request payload */
    int method;                  /**< HTTP method */
    char* path;                  /**< Request path */
+   char* file;                  /**< The file holding the request body, or NULL */
+   off_t file_offset;           /**< The offset of the request body in the file */
+   size_t file_size;            /**< The size of the request body in the file */
 };
 
 /** @struct http_response
@@ -164,6 +167,20 @@ pgmoneta_http_request_remove_header(struct http_request* request, char* name);
 int
 pgmoneta_http_set_data(struct http_request* request, void* data, size_t size);
 
+/**
+ * Send a range of a file as the body of the HTTP request. The file is only
+ * read when the request is invoked. A small body is sent with the header,
+ * a large one with sendfile when the connection is plain or has kTLS send
+ * offload
+ * @param request The HTTP request
+ * @param path The file path
+ * @param offset The offset of the body in the file
+ * @param size The size of the body
+ * @return PGMONETA_HTTP_STATUS_OK upon success, otherwise PGMONETA_HTTP_STATUS_ERROR
+ */
+int
+pgmoneta_http_set_file(struct http_request* request, char* path, off_t offset, size_t size);
+
 /**
  * Get a header value from the HTTP response
  * @param response The HTTP response
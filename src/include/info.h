@@ -35,6 +35,7 @@ extern "C" {
 
 /* pgmoneta */
 #include <pgmoneta.h>
+#include <art.h>
 #include <json.h>
 
 /* system */
@@ -45,6 +46,9 @@ extern "C" {
 #define INFO_BASEBACKUP_ELAPSED        "BASEBACKUP_ELAPSED"
 #define INFO_BIGGEST_FILE              "BIGGEST_FILE"
 #define INFO_CHKPT_WALPOS              "CHKPT_WALPOS"
+#define INFO_CHUNKED                   "CHUNKED"
+#define INFO_CHUNKED_SHARED            "CHUNKED_SHARED"
+#define INFO_CHUNKED_STORED            "CHUNKED_STORED"
 #define INFO_COMMENTS                  "COMMENTS"
 #define INFO_COMPRESSION               "COMPRESSION"
 #define INFO_COMPRESSION_BZIP2_ELAPSED "COMPRESSION_BZIP2_ELAPSED"
@@ -89,6 +93,9 @@ extern "C" {
 
 #define INFO_BUFFER_SIZE               8192
 
+#define CATALOG_FILE                   "backup.catalog"
+#define CATALOG_HEADER                 "PGMONETA_CATALOG=1\n"
+
 /**
  * @struct rfile
  * An rfile stores the metadata we need to use a file on disk for reconstruction.
@@ -125,6 +132,9 @@ struct backup
    uint64_t backup_size;                                          /**< The backup size */
    uint64_t restore_size;                                         /**< The restore size */
    uint64_t biggest_file_size;                                    /**< The biggest file */
+   uint64_t chunked_size;                                         /**< The bytes moved into the chunk store */
+   uint64_t chunked_stored_size;                                  /**< The bytes the chunk store grew by */
+   bool chunked_shared;                                           /**< Are the chunks in the shared chunk store */
    double total_elapsed_time;                                     /**< The total elapsed time in seconds */
    double basebackup_elapsed_time;                                /**< The basebackup elapsed time in seconds */
    double hash_elapsed_time;                                      /**< The hash elapsed time in seconds */
@@ -162,6 +172,17 @@ struct backup
    char parent_label[MISC_LENGTH];                                /**< The label of backup's parent, only used when backup is incremental */
 } __attribute__((aligned(64)));
 
+/** @struct catalog
+ * Defines the catalog of the backups in a directory
+ */
+struct catalog
+{
+   int number_of_backups;   /**< The number of backups */
+   struct backup** backups; /**< The backups ordered by label */
+   struct art* labels;      /**< The backups keyed by label */
+   struct art* children;    /**< The first child keyed by the label of its parent */
+};
+
 /**
  * Update backup information: annotate
  * @param server The server
@@ -184,6 +205,41 @@ pgmoneta_update_info_annotate(int server, struct backup* backup, char* action, c
 int
 pgmoneta_load_infos(char* directory, int* number_of_backups, struct backup*** backups);
 
+/**
+ * Load the catalog of a directory. The catalog file is reconciled against
+ * the backup directories, and rewritten if it is missing or out of date
+ * @param directory The directory
+ * @param catalog [out] The catalog
+ * @return 0 upon success, otherwise 1
+ */
+int
+pgmoneta_catalog_load(char* directory, struct catalog** catalog);
+
+/**
+ * Search for a backup in a catalog
+ * @param catalog The catalog
+ * @param identifier The label, or oldest / newest / latest
+ * @return The backup owned by the catalog, or NULL if not found
+ */
+struct backup*
+pgmoneta_catalog_search(struct catalog* catalog, char* identifier);
+
+/**
+ * Get the child of a backup in a catalog
+ * @param catalog The catalog
+ * @param label The label of the parent
+ * @return The backup owned by the catalog, or NULL if not found
+ */
+struct backup*
+pgmoneta_catalog_child(struct catalog* catalog, char* label);
+
+/**
+ * Destroy a catalog
+ * @param catalog The catalog
+ */
+void
+pgmoneta_catalog_destroy(struct catalog* catalog);
+
 /**
  * Get a backup
  * @param directory The directory
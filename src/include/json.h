@@ -119,6 +119,15 @@ pgmoneta_json_reader_close(struct json_reader* reader);
 int
 pgmoneta_json_create(struct json** object);
 
+/**
+ * Create an empty json array
+ * @param thread_safe Whether entries can be appended from several threads
+ * @param array [out] The json array
+ * @return 0 if success, 1 if otherwise
+ */
+int
+pgmoneta_json_create_array(bool thread_safe, struct json** array);
+
 /**
  * Put a key value pair into the json item,
  * if the key exists, value will be overwritten,
@@ -213,6 +222,15 @@ pgmoneta_json_append(struct json* array, uintptr_t entry, enum value_type type);
 bool
 pgmoneta_json_next_array_item(struct json_reader* reader, struct json** item);
 
+/**
+ * Parse the item the reader is positioned at, such as the root item of the file
+ * @param reader The json reader
+ * @param item [out] The item, parsed into json structure, all array and nested items will be ignored currently
+ * @return 0 if success, 1 if otherwise
+ */
+int
+pgmoneta_json_read_item(struct json_reader* reader, struct json** item);
+
 /**
  * Get json array length
  * @param array The json array
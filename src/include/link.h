@@ -63,9 +63,11 @@ int
 pgmoneta_relink(char* from, char* to, struct workers* workers);
 
 /**
- * Create link between two equal files
- * @param from The from directory
- * @param to The to directory
+ * Link the files of a backup that are equal to the files of an older backup.
+ * Files are equal when their manifest checksums and stored sizes match, and
+ * with link_paranoid also their content
+ * @param from The from backup directory (newer)
+ * @param to The to backup directory
  * @param workers The optional workers
  * @return 0 upon success, otherwise 1
  */
@@ -39,7 +39,7 @@ extern "C" {
 #include <deque.h>
 #include <json.h>
 
-#define MANIFEST_CHUNK_SIZE 8192
+#define MANIFEST_SORT_RUN 65536
 
 // simple manifest csv structure definition in case we want to change later
 #define MANIFEST_COLUMN_COUNT   2
@@ -55,15 +55,6 @@ struct manifest_file
    char* checksum; /**< The checksum of the manifest */
 };
 
-/** @struct manifest_chunk
- * Defines a manifest chunk
- */
-struct manifest_chunk
-{
-   struct manifest_file files[MANIFEST_CHUNK_SIZE]; /**< The chunk of the manifest */
-   int size;                                        /**< The size of the chunk */
-};
-
 /**
  * Verify checksum of the manifest and the checksum
  * @param root The root directory holding the manifest
@@ -75,7 +66,7 @@ int
 pgmoneta_manifest_checksum_verify(char* root, struct art* file_checksums, struct art* file_sizes);
 
 /**
- * Compare manifests
+ * Compare manifests with a merge join over the manifests sorted by path
  * @param manifest1 The path to the first manifest
  * @param manifest2 The path to the second manifest
  * @param deleted_files The deleted files
@@ -86,6 +77,15 @@ pgmoneta_manifest_checksum_verify(char* root, struct art* file_checksums, struct
 int
 pgmoneta_compare_manifests(char* old_manifest, char* new_manifest, struct art** deleted_files, struct art** changed_files, struct art** added_files);
 
+/**
+ * Sort a manifest by path. Large manifests are sorted in runs of
+ * MANIFEST_SORT_RUN entries that are spilled to disk and merged
+ * @param manifest The path to the manifest
+ * @return 0 on success, otherwise 1
+ */
+int
+pgmoneta_manifest_sort(char* manifest);
+
 /**
  * Generate the manifest on disk according to postgres manifest format
  * @param manifest The manifest
@@ -95,6 +95,18 @@ pgmoneta_compare_manifests(char* old_manifest, char* new_manifest, struct art**
 int
 pgmoneta_write_postgresql_manifest(struct json* manifest, char* path);
 
+/**
+ * Generate the manifest of a combined backup on disk. The header and the files
+ * are streamed from the source manifest, its incremental files are replaced by
+ * the reconstructed files
+ * @param source The path of the manifest of the incremental backup
+ * @param files The reconstructed files
+ * @param path The path
+ * @return 0 on success, otherwise 1
+ */
+int
+pgmoneta_write_combined_manifest(char* source, struct json* files, char* path);
+
 /**
  * Generate the manifest in memory (json format)
  * @param version The manifest file version
@@ -35,6 +35,7 @@ extern "C" {
 
 #include <pgmoneta.h>
 
+#include <stdint.h>
 #include <stdlib.h>
 
 /** @struct stream_buffer
@@ -49,6 +50,31 @@ struct stream_buffer
    size_t cursor; /**< next byte to consume */
 } __attribute__((aligned(64)));
 
+/** @struct region_block
+ * Defines a block of a region
+ */
+struct region_block
+{
+   struct region_block* next; /**< The next block */
+   size_t size;               /**< The size of the data */
+   size_t used;               /**< The number of used bytes */
+   char data[];               /**< The data */
+};
+
+/** @struct region
+ * Defines a region where allocations share one lifetime
+ */
+struct region
+{
+   struct region_block* blocks; /**< The blocks, newest first */
+   size_t block_size;           /**< The size of a regular block */
+#ifdef DEBUG
+   uint64_t allocations;      /**< The number of allocations */
+   uint64_t bytes;            /**< The number of bytes allocated */
+   uint64_t number_of_blocks; /**< The number of blocks */
+#endif
+};
+
 /**
  * Initialize a memory segment for the process local message structure
  */
@@ -117,6 +143,14 @@ pgmoneta_memory_stream_buffer_init(struct stream_buffer** buffer);
 int
 pgmoneta_memory_stream_buffer_enlarge(struct stream_buffer* buffer, int bytes_needed);
 
+/**
+ * Move the unconsumed data of a stream buffer to the front of the buffer.
+ * Any message view into the buffer is invalid afterwards
+ * @param buffer The stream buffer
+ */
+void
+pgmoneta_memory_stream_buffer_compact(struct stream_buffer* buffer);
+
 /**
  * Free a stream buffer
  * @param buffer The stream buffer to be freed
@@ -124,6 +158,76 @@ pgmoneta_memory_stream_buffer_enlarge(struct stream_buffer* buffer, int bytes_ne
 void
 pgmoneta_memory_stream_buffer_free(struct stream_buffer* buffer);
 
+/**
+ * Create a region. Memory allocated from a region is never freed
+ * individually, but all at once when the region is reset or destroyed
+ * @param block_size The size of a block, 0 for the default
+ * @param region [out] The region
+ * @return 0 upon success, otherwise 1
+ */
+int
+pgmoneta_memory_region_create(size_t block_size, struct region** region);
+
+/**
+ * Allocate memory from a region, aligned to 16 bytes
+ * @param region The region
+ * @param size The size
+ * @return The memory, or NULL
+ */
+void*
+pgmoneta_memory_region_alloc(struct region* region, size_t size);
+
+/**
+ * Copy a string into a region
+ * @param region The region
+ * @param s The string
+ * @return The copy, or NULL
+ */
+char*
+pgmoneta_memory_region_strdup(struct region* region, const char* s);
+
+/**
+ * Append a string to another in a region. The original string is
+ * left in place, so only use this for short chains of appends
+ * @param region The region
+ * @param orig The original string, may be NULL
+ * @param s The string to append
+ * @return The new string, or NULL
+ */
+char*
+pgmoneta_memory_region_append(struct region* region, const char* orig, const char* s);
+
+/**
+ * Format a string into a region
+ * @param region The region
+ * @param fmt The format
+ * @return The string, or NULL
+ */
+char*
+pgmoneta_memory_region_format(struct region* region, const char* fmt, ...);
+
+/**
+ * Release all the memory of a region, but keep the region
+ * @param region The region
+ */
+void
+pgmoneta_memory_region_reset(struct region* region);
+
+/**
+ * Destroy a region and all the memory allocated from it
+ * @param region The region
+ */
+void
+pgmoneta_memory_region_destroy(struct region* region);
+
+/**
+ * Log the allocation counters of a region, only in debug builds
+ * @param region The region
+ * @param name The name of the region
+ */
+void
+pgmoneta_memory_region_statistics(struct region* region, char* name);
+
 #ifdef __cplusplus
 }
 #endif
@@ -493,6 +493,10 @@ pgmoneta_consume_copy_stream(int srv, SSL* ssl, int socket, struct stream_buffer
  * pgmoneta_consume_copy_stream. Instead of creating a new message each time,
  * reuse the same message buffer each time Must be used with
  * pgmoneta_consume_copy_stream_end
+ *
+ * The message is a view into the stream buffer, its data isn't copied and
+ * is only valid until pgmoneta_consume_copy_stream_end is called, so the
+ * payload can be written out directly from the receive buffer
  * @param srv The server
  * @param ssl The SSL structure
  * @param socket The socket
@@ -40,6 +40,17 @@ extern "C" {
 #include <netinet/in.h>
 #include <sys/socket.h>
 
+/** @struct socket_options
+ * Defines the tuning of a TCP connection
+ */
+struct socket_options
+{
+   int rcvbuf;        /**< The SO_RCVBUF size, 0 for the kernel default */
+   int sndbuf;        /**< The SO_SNDBUF size, 0 for the kernel default */
+   int window_clamp;  /**< The TCP_WINDOW_CLAMP size, 0 to disable */
+   int notsent_lowat; /**< The TCP_NOTSENT_LOWAT size, 0 to disable */
+};
+
 /**
  * Bind sockets for a host
  * @param hostname The host name
@@ -74,11 +85,39 @@ pgmoneta_remove_unix_socket(char* directory, char* file);
  * Connect to a host
  * @param hostname The host name
  * @param port The port number
+ * @param options The socket options, or NULL for the defaults
  * @param fd The resulting descriptor
  * @return 0 upon success, otherwise 1
  */
 int
-pgmoneta_connect(char* hostname, int port, int* fd);
+pgmoneta_connect(char* hostname, int port, struct socket_options* options, int* fd);
+
+/**
+ * Get the socket options of a server
+ * @param server The server, or -1 for the global options
+ * @param options The resulting socket options
+ */
+void
+pgmoneta_socket_options(int server, struct socket_options* options);
+
+/**
+ * Apply the configured SO_BUSY_POLL of a server to a descriptor
+ * @param server The server
+ * @param fd The descriptor
+ * @return 0 upon success, otherwise 1
+ */
+int
+pgmoneta_socket_busy_poll(int server, int fd);
+
+/**
+ * Sample the kernel statistics of a TCP connection
+ * @param fd The descriptor
+ * @param cumulative Add the retransmits to the statistics instead of replacing them
+ * @param statistics The statistics
+ * @return 0 upon success, otherwise 1
+ */
+int
+pgmoneta_socket_statistics(int fd, bool cumulative, struct socket_statistics* statistics);
 
 /**
  * Connect to a Unix Domain Socket
@@ -35,6 +35,8 @@ extern "C" {
 
 /* pgmoneta */
 #include <progress.h>
+#include <throttle.h>
+#include <usage.h>
 
 /* system */
 #include <ev.h>
@@ -112,6 +114,13 @@ extern "C" {
 #define DIRECT_IO_AUTO               1
 #define DIRECT_IO_ON                 2
 
+#define TLS_KTLS_OFF                 0
+#define TLS_KTLS_AUTO                1
+#define TLS_KTLS_ON                  2
+
+#define KTLS_SEND                    1
+#define KTLS_RECEIVE                 2
+
 // clang-format on
 /* Compression type bits */
 #define COMPRESSION_TYPE_CLIENT 0x10
@@ -295,6 +304,27 @@ struct s3_configuration
    char base_dir[MAX_PATH];             /**< The S3 base directory */
 } __attribute__((aligned(64)));
 
+/** @struct tls_statistics
+ * Defines the statistics of TLS connections
+ */
+struct tls_statistics
+{
+   atomic_ulong connections;  /**< The number of TLS connections opened */
+   atomic_ulong ktls_send;    /**< The number of TLS connections opened with kTLS send offload */
+   atomic_ulong ktls_receive; /**< The number of TLS connections opened with kTLS receive offload */
+} __attribute__((aligned(64)));
+
+/** @struct socket_statistics
+ * Defines the statistics of a TCP connection, sampled from the kernel
+ */
+struct socket_statistics
+{
+   atomic_int rcvbuf;         /**< The effective receive buffer size */
+   atomic_int sndbuf;         /**< The effective send buffer size */
+   atomic_uint rtt;           /**< The smoothed round trip time in microseconds */
+   atomic_ulong retransmits;  /**< The number of retransmitted segments */
+} __attribute__((aligned(64)));
+
 /** @struct server
  * Defines a server
  */
@@ -318,6 +348,7 @@ struct server
    int create_slot;                                               /**< Create a slot */
    atomic_bool repository;                                        /**< Repository lock */
    atomic_bool wal_repository;                                    /**< WAL repository lock */
+   atomic_int wal_bundle;                                         /**< WAL bundle process id, 0 if none */
    bool active_backup;                                            /**< Is there an active backup */
    bool active_restore;                                           /**< Is there an active restore */
    bool active_archive;                                           /**< Is there an active archive */
@@ -328,6 +359,7 @@ struct server
    size_t segment_size;                                           /**< The max size of a relation file segment*/
    size_t relseg_size;                                            /**< The max number of blocks in a relation file segment */
    pid_t wal_streaming;                                           /**< WAL streaming process id */
+   atomic_int wal_ktls;                                           /**< The kTLS offload of the WAL streaming connection */
    bool checksums;                                                /**< Are checksums enabled */
    int fips_enabled;                                              /**< FIPS mode status */
    bool summarize_wal;                                            /**< Is summarize_wal enabled */
@@ -350,6 +382,11 @@ struct server
    char tls_ca_file[MAX_PATH];                                    /**< TLS CA certificate path */
    int workers;                                                   /**< The number of workers */
    int max_rate;                                                  /**< Maximum backup rate in bytes per second. */
+   int socket_rcvbuf;                                             /**< The SO_RCVBUF size */
+   int socket_sndbuf;                                             /**< The SO_SNDBUF size */
+   int tcp_window_clamp;                                          /**< The TCP_WINDOW_CLAMP size */
+   int tcp_notsent_lowat;                                         /**< The TCP_NOTSENT_LOWAT size */
+   int busy_poll;                                                 /**< The SO_BUSY_POLL time of the WAL receiver in microseconds */
    int number_of_extra;                                           /**< The number of source directory*/
    int progress_enabled;                                          /**< The progress status */
    char extra[MAX_EXTRA][MAX_EXTRA_PATH];                         /**< Source directory*/
@@ -357,7 +394,11 @@ struct server
    char ext_version[MISC_LENGTH];                                 /**< The major version of the extension*/
    struct extension_info extensions[NUMBER_OF_EXTENSIONS];        /**< The extensions */
    struct s3_configuration s3;                                    /**< The S3 configuration */
+   struct tls_statistics tls;                                     /**< The TLS statistics */
+   struct socket_statistics wal_socket;                           /**< The socket statistics of the WAL streaming connection */
+   struct socket_statistics backup_socket;                        /**< The socket statistics of the last backup connection */
    struct progress progress;                                      /**< The progress */
+   struct usage usage;                                            /**< The disk usage */
 } __attribute__((aligned(64)));
 
 /** @struct user
@@ -472,6 +513,7 @@ struct main_configuration
    char ssh_ciphers[MISC_LENGTH];       /**< The SSH supported ciphers */
    char ssh_public_key_file[MAX_PATH];  /**< The SSH public key path */
    char ssh_private_key_file[MAX_PATH]; /**< The SSH private key path */
+   int ssh_inflight;                    /**< The number of in-flight SFTP write requests */
 
    struct s3_configuration s3; /**< The S3 configuration */
 
@@ -479,6 +521,14 @@ struct main_configuration
    char azure_container[MISC_LENGTH];       /**< The Azure container name */
    char azure_shared_key[MISC_LENGTH];      /**< The Azure storage account key */
    char azure_base_dir[MAX_PATH];           /**< The Azure base directory */
+   char azure_endpoint[MISC_LENGTH];        /**< The Azure blob endpoint host */
+   int azure_port;                          /**< The Azure blob endpoint port */
+   bool azure_use_tls;                      /**< Use TLS for the Azure blob endpoint */
+   int azure_block_size;                    /**< The Azure block size */
+   int s3_part_size;                        /**< The size of a ranged S3 GET */
+   int s3_download_concurrency;             /**< The number of ranged S3 GETs in flight per object */
+   uint64_t wal_bundle_size;                /**< The size of a WAL bundle */
+   pgmoneta_time_t wal_bundle_timeout;      /**< The age of a WAL segment that ships a WAL bundle */
 
    int retention_days;     /**< The retention days for the server */
    int retention_weeks;    /**< The retention weeks for the server */
@@ -492,6 +542,7 @@ struct main_configuration
    char tls_cert_file[MAX_PATH]; /**< TLS certificate path */
    char tls_key_file[MAX_PATH];  /**< TLS key path */
    char tls_ca_file[MAX_PATH];   /**< TLS CA certificate path */
+   unsigned char tls_ktls;       /**< Kernel TLS offload (off, auto, on) */
 
    char metrics_cert_file[MAX_PATH]; /**< Metrics TLS certificate path */
    char metrics_key_file[MAX_PATH];  /**< Metrics TLS key path */
@@ -512,10 +563,34 @@ struct main_configuration
 
    int max_rate; /**< Maximum backup rate in bytes per second. */
 
+   int socket_rcvbuf;     /**< The SO_RCVBUF size */
+   int socket_sndbuf;     /**< The SO_SNDBUF size */
+   int tcp_window_clamp;  /**< The TCP_WINDOW_CLAMP size */
+   int tcp_notsent_lowat; /**< The TCP_NOTSENT_LOWAT size */
+   int busy_poll;         /**< The SO_BUSY_POLL time of the WAL receiver in microseconds */
+
+   uint64_t io_max_rate;     /**< Maximum I/O rate in bytes per second across all workflows */
+   int io_max_iops;          /**< Maximum I/O operations per second across all workflows */
+   struct throttle throttle; /**< The I/O scheduler */
+
+   atomic_ullong used_space;  /**< The disk space used under base_dir */
+   atomic_bool usage_active;  /**< Is the disk usage reconciler running */
+
+   struct tls_statistics http_tls;       /**< The TLS statistics of HTTP connections */
+   struct socket_statistics http_socket; /**< The socket statistics of HTTP connections */
+
    pgmoneta_time_t verification; /**< The sha512 verification interval */
+   uint64_t verification_budget; /**< The bytes verified per server in a verification cycle */
 
    bool progress; /**< Enable backup progress tracking */
 
+   bool tree_hash; /**< Calculate tree digests of large files during backup */
+
+   bool chunk_store;        /**< Move full backups into a deduplicating chunk store */
+   bool chunk_store_shared; /**< Share the chunk store between all servers */
+
+   bool link_paranoid; /**< Compare the content of files before linking them */
+
 #ifdef DEBUG
    bool link; /**< Do linking */
 #endif
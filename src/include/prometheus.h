@@ -34,6 +34,7 @@ extern "C" {
 #endif
 
 #include <pgmoneta.h>
+#include <info.h>
 
 #include <ev.h>
 #include <stdlib.h>
@@ -74,6 +75,17 @@ pgmoneta_prometheus(SSL* client_ssl, int fd);
 void
 pgmoneta_prometheus_reset(void);
 
+/**
+ * Write the metrics of the servers and their backups as HTTP chunks
+ * @param client_ssl The client SSL structure
+ * @param fd The client descriptor
+ * @param number_of_backups The number of backups of each server, or NULL
+ * @param backups The backups of each server, or NULL
+ * @return 0 on success, otherwise 1
+ */
+int
+pgmoneta_prometheus_metrics(SSL* client_ssl, int fd, int* number_of_backups, struct backup*** backups);
+
 /**
  * Allocates, for the first time, the Prometheus cache.
  *
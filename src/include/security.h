@@ -51,6 +51,24 @@ struct hasher
    unsigned char md_value[EVP_MAX_MD_SIZE]; /**< The hash value */
 };
 
+#define TREE_HASH_LEAF_SIZE (16 * 1024 * 1024)
+#define TREE_HASH_DIGEST_SIZE 64
+
+/** @struct tree_hasher
+ * Defines a SHA-512 tree hasher. The input is split into leaves of
+ * TREE_HASH_LEAF_SIZE bytes which are hashed independently, the root is the
+ * SHA-512 of the leaf size, the input size and the leaf digests
+ */
+struct tree_hasher
+{
+   EVP_MD_CTX* md_ctx;     /**< The context of the current leaf */
+   size_t leaf_fill;       /**< The bytes hashed into the current leaf */
+   uint64_t size;          /**< The total input size */
+   unsigned char* digests; /**< The leaf digests */
+   size_t leaves;          /**< The number of leaf digests */
+   size_t capacity;        /**< The capacity of the leaf digests */
+};
+
 /**
  * Authenticate a user
  * @param server The server
@@ -161,6 +179,54 @@ pgmoneta_generate_string_hmac_sha256_hash(char* key, int key_length, char* value
                                           int value_length, unsigned char** hmac,
                                           int* hmac_length);
 
+#define CRC32C_SOFTWARE         0
+#define CRC32C_SSE42            1
+#define CRC32C_SSE42_3WAY       2
+#define CRC32C_PCLMUL           3
+#define CRC32C_VPCLMUL          4
+#define CRC32C_ARMV8            5
+#define CRC32C_IMPLEMENTATIONS  6
+
+/**
+ * Select the fastest CRC32C implementation supported by the CPU
+ */
+void
+pgmoneta_crc_init(void);
+
+/**
+ * Get the active CRC32C implementation
+ * @return The implementation
+ */
+int
+pgmoneta_crc32c_implementation(void);
+
+/**
+ * Get the name of a CRC32C implementation
+ * @param implementation The implementation
+ * @return The name
+ */
+char*
+pgmoneta_crc32c_implementation_name(int implementation);
+
+/**
+ * Is a CRC32C implementation supported by the CPU
+ * @param implementation The implementation
+ * @return True if supported, otherwise false
+ */
+bool
+pgmoneta_crc32c_supported(int implementation);
+
+/**
+ * Generate CRC32C for a buffer using a specific implementation
+ * @param implementation The implementation
+ * @param buffer The buffer
+ * @param size The size of the buffer
+ * @param crc The hash value
+ * @return 0 upon success, otherwise 1
+ */
+int
+pgmoneta_create_crc32c_buffer_with(int implementation, void* buffer, size_t size, uint32_t* crc);
+
 /**
  * Generate CRC32C for a buffer
  * @param buffer The buffer
@@ -189,11 +255,31 @@ pgmoneta_close_ssl(SSL* ssl);
 /**
  * Create a SSL context
  * @param client True if client, false if server
+ * @param ktls The kernel TLS offload mode (TLS_KTLS_OFF, TLS_KTLS_AUTO, TLS_KTLS_ON)
  * @param ctx The SSL context
  * @return 0 upon success, otherwise 1
  */
 int
-pgmoneta_create_ssl_ctx(bool client, SSL_CTX** ctx);
+pgmoneta_create_ssl_ctx(bool client, int ktls, SSL_CTX** ctx);
+
+/**
+ * Get the kernel TLS offload of a connection
+ * @param ssl The SSL structure
+ * @return The KTLS_SEND and KTLS_RECEIVE flags that are active
+ */
+int
+pgmoneta_ssl_ktls(SSL* ssl);
+
+/**
+ * Account the kernel TLS offload of an established connection, and
+ * report when it was requested but isn't active
+ * @param ssl The SSL structure
+ * @param ktls The kernel TLS offload mode
+ * @param peer The name of the peer
+ * @param statistics The TLS statistics, or NULL
+ */
+void
+pgmoneta_ssl_ktls_account(SSL* ssl, int ktls, char* peer, struct tls_statistics* statistics);
 
 /**
  * Create a SSL server
@@ -268,6 +354,61 @@ pgmoneta_hasher_destroy(struct hasher* hasher);
 int
 pgmoneta_hasher_update(struct hasher* hasher, void* buffer, size_t size, bool last_chunk);
 
+/**
+ * Create a tree hasher
+ * @param hasher [out] The tree hasher
+ * @return 0 on success, otherwise 1
+ */
+int
+pgmoneta_tree_hasher_create(struct tree_hasher** hasher);
+
+/**
+ * Update a tree hasher with new input
+ * @param hasher The tree hasher
+ * @param buffer The input buffer
+ * @param size The input buffer data size
+ * @return 0 on success, otherwise 1
+ */
+int
+pgmoneta_tree_hasher_update(struct tree_hasher* hasher, void* buffer, size_t size);
+
+/**
+ * Finalize a tree hasher
+ * @param hasher The tree hasher
+ * @param hash [out] The root hash
+ * @return 0 on success, otherwise 1
+ */
+int
+pgmoneta_tree_hasher_final(struct tree_hasher* hasher, char** hash);
+
+/**
+ * Destroy a tree hasher
+ * @param hasher The tree hasher
+ */
+void
+pgmoneta_tree_hasher_destroy(struct tree_hasher* hasher);
+
+/**
+ * Create the SHA-512 of a single leaf of a file
+ * @param filename The file name
+ * @param leaf The leaf index
+ * @param digest [out] The raw digest of TREE_HASH_DIGEST_SIZE bytes
+ * @return 0 on success, otherwise 1
+ */
+int
+pgmoneta_create_sha512_leaf(char* filename, uint64_t leaf, unsigned char* digest);
+
+/**
+ * Create the root hash of a tree from its leaf digests
+ * @param digests The raw leaf digests
+ * @param leaves The number of leaves
+ * @param size The input size
+ * @param hash [out] The root hash
+ * @return 0 on success, otherwise 1
+ */
+int
+pgmoneta_create_sha512_tree_root(unsigned char* digests, size_t leaves, uint64_t size, char** hash);
+
 #ifdef __cplusplus
 }
 #endif
@@ -92,6 +92,47 @@ pgmoneta_sftp_wal_open(int server, char* filename, int segsize, sftp_file* file)
  */
 int
 pgmoneta_sftp_wal_close(int server, char* filename, bool partial, sftp_file* file);
+
+/**
+ * Ship the completed WAL segments of a server to S3 as WAL bundles. A bundle
+ * is uploaded once wal_bundle_size is reached, or when its oldest segment
+ * is older than wal_bundle_timeout
+ * @param server The server index
+ * @return 0 on success, otherwise 1
+ */
+int
+pgmoneta_s3_wal_bundle(int server);
+
+/**
+ * Fetch a single WAL segment, or a timeline history file, from the S3 WAL bundles.
+ * A segment is read with a ranged GET of its bundle entry
+ * @param server The server index
+ * @param segment The WAL segment name
+ * @param directory The target directory
+ * @return 0 on success, otherwise 1
+ */
+int
+pgmoneta_s3_wal_get(int server, char* segment, char* directory);
+
+/**
+ * Fetch the WAL segments from a start segment on that are missing in a directory
+ * from the S3 WAL bundles
+ * @param server The server index
+ * @param start The first WAL segment, or NULL for all
+ * @param directory The target directory
+ * @return 0 on success, otherwise 1
+ */
+int
+pgmoneta_s3_wal_restore(int server, char* start, char* directory);
+
+/**
+ * Delete the S3 WAL bundles that end before the oldest backup of a server
+ * @param server The server index
+ * @return 0 on success, otherwise 1
+ */
+int
+pgmoneta_s3_wal_retention(int server);
+
 #ifdef __cplusplus
 }
 #endif
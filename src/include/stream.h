@@ -34,15 +34,33 @@ extern "C" {
 #endif
 
 #include <aes.h>
+#include <art.h>
 #include <compression.h>
 #include <deque.h>
 #include <vfile.h>
+#include <workers.h>
+
+#include <stdint.h>
 
 #define BUFFER_SIZE           1024 * 1024
 #define STREAMER_MODE_NONE    0
 #define STREAMER_MODE_BACKUP  1
 #define STREAMER_MODE_RESTORE 2
 
+/** @struct stream_digests
+ * Defines the digests calculated while a file is streamed. They all describe
+ * the bytes written to the destination, so they match a later read of the file
+ */
+struct stream_digests
+{
+   char sha256[65];  /**< The SHA-256 of the written file */
+   char sha512[129]; /**< The SHA-512 of the written file */
+   uint32_t crc32c;  /**< The CRC32C of the written file */
+   size_t size;      /**< The size of the written file */
+   uint64_t inode;   /**< The inode of the written file */
+   int64_t mtime;    /**< The modification time of the written file in nanoseconds */
+};
+
 /** @struct streamer
  * Defines a streamer
  */
@@ -119,6 +137,72 @@ pgmoneta_streamer_add_destination(struct streamer* streamer, struct vfile* file)
 void
 pgmoneta_streamer_reset(struct streamer* streamer);
 
+/**
+ * Compress and encrypt a file in a single pass. The source is read once and
+ * only the final file is written, the source is removed upon success
+ * @param from The source file
+ * @param to The destination file
+ * @param compression The compression mode
+ * @param encryption The encryption mode
+ * @param digests [out] The digests of the destination file, may be NULL
+ * @return 0 upon success, 1 if otherwise
+ */
+int
+pgmoneta_stream_file(char* from, char* to, int compression, int encryption, struct stream_digests* digests);
+
+/**
+ * Compress and encrypt a directory recursively in a single pass per file
+ * @param server The server index for progress tracking, or -1 to disable
+ * @param directory The directory
+ * @param compression The compression mode
+ * @param encryption The encryption mode
+ * @param workers Optional worker pool. If NULL, runs synchronously.
+ * @param excludes Excluded file patterns
+ * @param digests The map of path to digests which the written files are added to, may be NULL
+ * @return 0 upon success, 1 if otherwise
+ */
+int
+pgmoneta_stream_directory(int server, char* directory, int compression, int encryption, struct workers* workers, struct deque* excludes, struct art* digests);
+
+/**
+ * Create a destination which hashes everything written to it. Add it to a streamer
+ * next to the real destination to get the digests of the file as it is written
+ * @param vfile [out] The vfile
+ * @return 0 upon success, 1 if otherwise
+ */
+int
+pgmoneta_stream_digest_create(struct vfile** vfile);
+
+/**
+ * Finalize the digests of a destination created by pgmoneta_stream_digest_create
+ * @param vfile The vfile
+ * @param digests [out] The digests
+ * @return 0 upon success, 1 if otherwise
+ */
+int
+pgmoneta_stream_digest_finish(struct vfile* vfile, struct stream_digests* digests);
+
+/**
+ * Remember the digests of a written file. The file must be closed, as its
+ * inode and modification time are recorded with the digests
+ * @param map The map of path to digests
+ * @param path The path of the file
+ * @param digests The digests
+ * @return 0 upon success, 1 if otherwise
+ */
+int
+pgmoneta_stream_digests_add(struct art* map, char* path, struct stream_digests* digests);
+
+/**
+ * Look up the digests of a file written earlier. The entry is only returned
+ * if the file still has the size, inode and modification time it was written with
+ * @param map The map of path to digests
+ * @param path The path of the file
+ * @return The digests, or NULL if they have to be calculated from disk
+ */
+struct stream_digests*
+pgmoneta_stream_digests_get(struct art* map, char* path);
+
 #ifdef __cplusplus
 }
 #endif
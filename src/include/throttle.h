@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2026 The pgmoneta community
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or other
+ * materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may
+ * be used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PGMONETA_THROTTLE_H
+#define PGMONETA_THROTTLE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* system */
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/* The I/O classes, in priority order */
+#define THROTTLE_WAL          0 /* WAL streaming */
+#define THROTTLE_BACKUP       1 /* Base backup receive */
+#define THROTTLE_DOWNLOAD     2 /* Remote storage engine downloads */
+#define THROTTLE_WAL_COMPRESS 3 /* WAL compression and encryption */
+#define THROTTLE_UPLOAD       4 /* Remote storage engine uploads */
+#define THROTTLE_VERIFY       5 /* Verification */
+#define THROTTLE_DELETE       6 /* Delete and retention */
+
+#define NUMBER_OF_THROTTLE_CLASSES 7
+
+/** @struct throttle_bucket
+ * A token bucket shared by all processes
+ */
+struct throttle_bucket
+{
+   atomic_llong tokens; /**< The available tokens, negative when in debt */
+   atomic_llong last;   /**< The time of the last refill in nanoseconds */
+};
+
+/** @struct throttle
+ * The I/O scheduler. A bucket of bytes and a bucket of operations are
+ * refilled at io_max_rate and io_max_iops. A class only takes tokens
+ * when the level is above the share reserved for the higher classes
+ * that did I/O within the last second. WAL streaming is accounted but
+ * never waits.
+ */
+struct throttle
+{
+   struct throttle_bucket bytes;                       /**< The bytes bucket */
+   struct throttle_bucket operations;                  /**< The operations bucket */
+   atomic_llong active[NUMBER_OF_THROTTLE_CLASSES];    /**< The last I/O of a class in nanoseconds */
+   atomic_llong waited[NUMBER_OF_THROTTLE_CLASSES];    /**< The time a class has waited in nanoseconds */
+};
+
+/**
+ * Initialize the I/O scheduler
+ * @param throttle The scheduler
+ */
+void
+pgmoneta_throttle_init(struct throttle* throttle);
+
+/**
+ * Account an I/O operation, and wait until its class may do it. A large
+ * request is charged in slices, so it waits in proportion to its size
+ * @param io_class The I/O class
+ * @param bytes The number of bytes
+ */
+void
+pgmoneta_throttle(int io_class, uint64_t bytes);
+
+/**
+ * Is the I/O scheduler enabled
+ * @return True if io_max_rate or io_max_iops is set, otherwise false
+ */
+bool
+pgmoneta_throttle_enabled(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
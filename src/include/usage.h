@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2026 The pgmoneta community
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or other
+ * materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may
+ * be used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PGMONETA_USAGE_H
+#define PGMONETA_USAGE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* system */
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/* The disk usage kept for a server */
+#define USAGE_BACKUP             0 /* The backup directory */
+#define USAGE_WAL                1 /* The WAL directory */
+#define USAGE_SERVER             2 /* The server directory */
+#define USAGE_WAL_SHIPPING_WAL   3 /* The WAL directory under WAL shipping */
+#define USAGE_WAL_SHIPPING       4 /* The WAL shipping directory */
+#define USAGE_WORKSPACE          5 /* The workspace */
+#define USAGE_HOT_STANDBY        6 /* The hot standby directories */
+
+#define NUMBER_OF_USAGES         7
+
+#define USAGE_RECONCILE_INTERVAL 300 /* Seconds between two directory walks */
+
+/** @struct usage
+ * The disk usage of a server. The workflows that add or remove files
+ * apply their delta, and a background process walks the directories
+ * every USAGE_RECONCILE_INTERVAL seconds to correct any drift.
+ */
+struct usage
+{
+   atomic_ullong size[NUMBER_OF_USAGES]; /**< The size of each directory in bytes */
+   atomic_llong reconciled;              /**< The time of the last directory walk */
+};
+
+/**
+ * Initialize the disk usage of a server
+ * @param usage The usage
+ */
+void
+pgmoneta_usage_init(struct usage* usage);
+
+/**
+ * Apply a change to the disk usage of a server. A change to the backup
+ * or WAL directory is applied to the server directory and the used
+ * space as well
+ * @param server The server
+ * @param type The directory
+ * @param delta The number of bytes added, or removed when negative
+ */
+void
+pgmoneta_usage_add(int server, int type, int64_t delta);
+
+/**
+ * Get the disk usage of a server
+ * @param server The server
+ * @param type The directory
+ * @return The size in bytes
+ */
+uint64_t
+pgmoneta_usage_get(int server, int type);
+
+/**
+ * Get the disk space used under base_dir
+ * @return The size in bytes
+ */
+uint64_t
+pgmoneta_usage_used_space(void);
+
+/**
+ * Walk the directories of all servers and correct their disk usage.
+ * Deltas added while a directory is walked are kept
+ * @return 0 upon success, otherwise 1
+ */
+int
+pgmoneta_usage_reconcile(void);
+
+/**
+ * Run the disk usage reconciler
+ * @param argv The argv
+ */
+void
+pgmoneta_usage(char** argv);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
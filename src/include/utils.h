@@ -133,6 +133,16 @@ struct pgmoneta_parsed_command
    char* args[MISC_LENGTH];      /**< The arguments */
 };
 
+/** @struct string_builder
+ * Defines a string that grows by doubling, and knows its length
+ */
+struct string_builder
+{
+   char* str;       /**< The string, always terminated */
+   size_t length;   /**< The length of the string */
+   size_t capacity; /**< The allocated size */
+};
+
 /**
  * Utility function to parse the command line
  * and search for a command.
@@ -651,6 +661,122 @@ pgmoneta_append_double_precision(char* orig, double d, int precision);
 char*
 pgmoneta_append_bool(char* orig, bool b);
 
+/**
+ * Create a string builder
+ * @param capacity The initial capacity, or 0 for the default
+ * @param sb [out] The string builder
+ * @return 0 upon success, otherwise 1
+ */
+int
+pgmoneta_string_builder_create(size_t capacity, struct string_builder** sb);
+
+/**
+ * Append a string to a string builder
+ * @param sb The string builder
+ * @param s The string
+ * @return 0 upon success, otherwise 1
+ */
+int
+pgmoneta_string_builder_append(struct string_builder* sb, const char* s);
+
+/**
+ * Append bytes to a string builder
+ * @param sb The string builder
+ * @param s The bytes
+ * @param length The number of bytes
+ * @return 0 upon success, otherwise 1
+ */
+int
+pgmoneta_string_builder_append_bytes(struct string_builder* sb, const char* s, size_t length);
+
+/**
+ * Append a char to a string builder
+ * @param sb The string builder
+ * @param c The char
+ * @return 0 upon success, otherwise 1
+ */
+int
+pgmoneta_string_builder_append_char(struct string_builder* sb, char c);
+
+/**
+ * Append an integer to a string builder
+ * @param sb The string builder
+ * @param i The integer
+ * @return 0 upon success, otherwise 1
+ */
+int
+pgmoneta_string_builder_append_int(struct string_builder* sb, int i);
+
+/**
+ * Append a long to a string builder
+ * @param sb The string builder
+ * @param l The long
+ * @return 0 upon success, otherwise 1
+ */
+int
+pgmoneta_string_builder_append_ulong(struct string_builder* sb, unsigned long l);
+
+/**
+ * Append a double to a string builder
+ * @param sb The string builder
+ * @param d The double
+ * @return 0 upon success, otherwise 1
+ */
+int
+pgmoneta_string_builder_append_double(struct string_builder* sb, double d);
+
+/**
+ * Append a double with set precision to a string builder
+ * @param sb The string builder
+ * @param d The double
+ * @param precision The number of digits after decimal
+ * @return 0 upon success, otherwise 1
+ */
+int
+pgmoneta_string_builder_append_double_precision(struct string_builder* sb, double d, int precision);
+
+/**
+ * Format a string and append it to a string builder
+ * @param sb The string builder
+ * @param format The format
+ * @param ... The arguments to be formatted
+ * @return 0 upon success, otherwise 1
+ */
+int
+pgmoneta_string_builder_format(struct string_builder* sb, char* format, ...);
+
+/**
+ * Indent a string builder
+ * @param sb The string builder
+ * @param tag [Optional] The tag, which will be applied after indentation if not NULL
+ * @param indent The indent
+ * @return 0 upon success, otherwise 1
+ */
+int
+pgmoneta_string_builder_indent(struct string_builder* sb, char* tag, int indent);
+
+/**
+ * Empty a string builder, keeping its memory
+ * @param sb The string builder
+ */
+void
+pgmoneta_string_builder_reset(struct string_builder* sb);
+
+/**
+ * Take the string out of a string builder, and destroy the builder
+ * @param sb The string builder
+ * @return The string, or NULL if nothing was appended
+ */
+char*
+pgmoneta_string_builder_release(struct string_builder* sb);
+
+/**
+ * Destroy a string builder
+ * @param sb The string builder
+ */
+void
+pgmoneta_string_builder_destroy(struct string_builder* sb);
+
 /**
  * Remove whitespace from a string
  * @param orig The original string
@@ -1091,6 +1217,15 @@ pgmoneta_get_server_wal(int server);
 char*
 pgmoneta_get_server_summary(int server);
 
+/**
+ * Get the chunk store directory for a server
+ * @param server The server
+ * @param shared Get the chunk store shared by all servers
+ * @return The chunk store directory
+ */
+char*
+pgmoneta_get_server_chunks(int server, bool shared);
+
 /**
  * Get the wal shipping directory for a server
  * @param server The server
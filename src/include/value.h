@@ -112,6 +112,25 @@ pgmoneta_value_create(enum value_type type, uintptr_t data, struct value** value
 int
 pgmoneta_value_create_with_config(uintptr_t data, struct value_config* config, struct value** value);
 
+/**
+ * Initialize a value in place, for values embedded in other structures
+ * @param type The value type
+ * @param data The value data, type cast it to uintptr_t before passing into function
+ * @param config The configuration, or NULL to use the defaults of the type
+ * @param value The value
+ * @return 0 on success, 1 if otherwise
+ */
+int
+pgmoneta_value_init(enum value_type type, uintptr_t data, struct value_config* config, struct value* value);
+
+/**
+ * Destroy the data within a value without freeing the value itself
+ * @param value The value
+ * @return 0 on success, 1 if otherwise
+ */
+int
+pgmoneta_value_release(struct value* value);
+
 /**
  * Destroy a value along with the data within
  * @param value The value
@@ -207,6 +207,14 @@ pgmoneta_get_relation_oid(char* name, char** oid);
 void
 pgmoneta_wal_server_compress_encrypt(int srv, char** argv, char* wal_file);
 
+/**
+ * WAL bundle, ship the completed WAL segments to the object store
+ * @param srv The server
+ * @param argv The argv
+ */
+void
+pgmoneta_wal_bundle(int srv, char** argv);
+
 #ifdef __cplusplus
 }
 #endif
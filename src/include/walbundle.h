@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2026 The pgmoneta community
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or other
+ * materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may
+ * be used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PGMONETA_WALBUNDLE_H
+#define PGMONETA_WALBUNDLE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <pgmoneta.h>
+#include <deque.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/*
+ * A WAL bundle packs consecutive WAL segments, as they are stored in the
+ * WAL repository, into a single object:
+ *
+ *   [segment]...[segment][index][index offset][magic]
+ *
+ * The index has a "name,offset,size" line per segment, the index offset
+ * is a big endian 64-bit integer and the magic is WAL_BUNDLE_MAGIC. A
+ * reader fetches the trailer, then the index and then a single segment.
+ */
+#define WAL_BUNDLE_MAGIC        "PGMWALB1"
+#define WAL_BUNDLE_TRAILER_SIZE 16
+#define WAL_BUNDLE_SUFFIX       ".bundle"
+
+/** @struct wal_bundle_entry
+ * Defines a segment in a WAL bundle
+ */
+struct wal_bundle_entry
+{
+   char name[MISC_LENGTH]; /**< The file name of the segment */
+   uint64_t offset;        /**< The offset of the segment in the bundle */
+   uint64_t size;          /**< The size of the segment */
+};
+
+/**
+ * Create a WAL bundle
+ * @param directory The WAL directory
+ * @param files The file names, in order
+ * @param path The path of the bundle
+ * @return 0 on success, otherwise 1
+ */
+int
+pgmoneta_wal_bundle_create(char* directory, struct deque* files, char* path);
+
+/**
+ * Get the name of a WAL bundle
+ * @param first The first WAL file in the bundle
+ * @param last The last WAL file in the bundle
+ * @return The name
+ */
+char*
+pgmoneta_wal_bundle_name(char* first, char* last);
+
+/**
+ * Does a WAL bundle end before a segment
+ * @param bundle The name of the bundle
+ * @param segment The WAL segment name
+ * @return True if the last segment of the bundle is older than the segment, otherwise false
+ */
+bool
+pgmoneta_wal_bundle_ends_before(char* bundle, char* segment);
+
+/**
+ * Does a WAL bundle contain a segment
+ * @param bundle The name of the bundle
+ * @param segment The WAL segment name
+ * @return True if the segment is within the range of the bundle, otherwise false
+ */
+bool
+pgmoneta_wal_bundle_covers(char* bundle, char* segment);
+
+/**
+ * Read the trailer of a WAL bundle
+ * @param data The last WAL_BUNDLE_TRAILER_SIZE bytes of the bundle
+ * @param size The size of the data
+ * @param total The size of the bundle
+ * @param offset [out] The offset of the index
+ * @param length [out] The length of the index
+ * @return 0 on success, otherwise 1
+ */
+int
+pgmoneta_wal_bundle_read_trailer(void* data, size_t size, uint64_t total, uint64_t* offset, uint64_t* length);
+
+/**
+ * Read the index of a WAL bundle
+ * @param data The index
+ * @param size The size of the index
+ * @param entries [out] The entries tagged by their segment name
+ * @return 0 on success, otherwise 1
+ */
+int
+pgmoneta_wal_bundle_read_index(char* data, size_t size, struct deque** entries);
+
+/**
+ * Find a segment in the index of a WAL bundle
+ * @param entries The entries
+ * @param segment The WAL segment name
+ * @return The entry, or NULL
+ */
+struct wal_bundle_entry*
+pgmoneta_wal_bundle_find(struct deque* entries, char* segment);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -36,6 +36,7 @@ extern "C" {
 #include <pgmoneta.h>
 #include <art.h>
 #include <info.h>
+#include <memory.h>
 
 #define WORKFLOW_TYPE_BACKUP             0
 #define WORKFLOW_TYPE_RESTORE            1
@@ -90,6 +91,7 @@ extern "C" {
 #define PHASE_NAME_SHA512                "SHA512"             /**< The name of SHA512 phase */
 #define PHASE_NAME_LINKING               "Linking"            /**< The name of linking phase */
 #define PHASE_NAME_LINK                  "Link"               /**< The name of link phase */
+#define PHASE_NAME_CHUNK                 "Chunk"              /**< The name of chunk phase */
 #define PHASE_NAME_COMPRESSION           "Compression"        /**< The name of compression phase */
 #define PHASE_NAME_ENCRYPTION            "Encryption"         /**< The name of encryption phase */
 #define PHASE_NAME_ZSTD                  "ZSTD"               /**< The name of ZSTD phase */
@@ -108,6 +110,7 @@ extern "C" {
 #define NODE_BACKUP                      "backup"              /* The backup structure */
 #define NODE_COMBINE_AS_IS               "combine_as_is"       /* Whether to combine the backups as is*/
 #define NODE_COPY_WAL                    "copy_wal"            /* Whether to copy WAL */
+#define NODE_DIGESTS                     "digests"             /* The digests of the files written during receive */
 #define NODE_BACKUP_BASE                 "backup_base"         /* The base directory of the backup */
 #define NODE_BACKUP_DATA                 "backup_data"         /* The data directory of the backup */
 #define NODE_ERROR_CODE                  "error_code"          /* The error code */
@@ -118,9 +121,9 @@ extern "C" {
 #define NODE_INCREMENTAL_LABEL           "incremental_label"   /* The label of the incremental backup */
 #define NODE_LABEL                       "label"               /* The backup label */
 #define NODE_LABELS                      "labels"              /* A list of backup labels */
-#define NODE_MANIFEST                    "manifest"            /* The manifest */
 #define NODE_PRIMARY                     "primary"             /* Is the server a primary */
 #define NODE_RECOVERY_INFO               "recovery_info"       /* The recovery information */
+#define NODE_REGION                      "region"              /* The memory region of the workflow */
 #define NODE_SERVER_BACKUP               "server_backup"       /* The backup directory of the server */
 #define NODE_S3_OBJECTS                  "s3_objects"          /* The list of S3 objects */
 #define NODE_SERVER_BASE                 "server_base"         /* The base directory of the server */
@@ -128,6 +131,7 @@ extern "C" {
 #define NODE_TARGET_BASE                 "target_base"         /* The target base directory */
 #define NODE_TARGET_FILE                 "target_file"         /* The target file */
 #define NODE_TARGET_ROOT                 "target_root"         /* The target root directory */
+#define NODE_TREES                       "trees"               /* The tree digests of large files */
 
 /* Supplied by the user */
 #define USER_DIRECTORY  "directory"  /* The target root directory */
@@ -176,6 +180,16 @@ pgmoneta_workflow_create(int workflow_type, struct backup* backup);
 int
 pgmoneta_workflow_nodes(int server, char* identifier, struct art* nodes, struct backup** backup);
 
+/**
+ * Get the memory region of the workflow, creating it on first use.
+ * The region is released together with the nodes, so strings allocated
+ * from it can be stored in the nodes as ValueStringRef
+ * @param nodes The nodes
+ * @return The region, or NULL
+ */
+struct region*
+pgmoneta_workflow_region(struct art* nodes);
+
 /**
  * Execute a workflow
  * @param workflow The workflow
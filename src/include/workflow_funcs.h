@@ -148,6 +148,13 @@ pgmoneta_create_bzip2(bool compress);
 struct workflow*
 pgmoneta_create_link(void);
 
+/**
+ * Create a workflow for moving the backup files into the chunk store
+ * @return The workflow
+ */
+struct workflow*
+pgmoneta_create_chunk(void);
+
 struct workflow*
 pgmoneta_create_copy_wal(void);
 
@@ -189,6 +196,13 @@ pgmoneta_create_cleanup(int type);
 struct workflow*
 pgmoneta_encryption(bool encrypt);
 
+/**
+ * Create a workflow that compresses and encrypts each file in a single pass
+ * @return The workflow
+ */
+struct workflow*
+pgmoneta_create_compression_encryption(void);
+
 /**
  * Create a workflow for manifest building
  * @return The workflow
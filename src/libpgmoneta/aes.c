@@ -38,12 +38,17 @@
 /* System */
 #include <dirent.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <limits.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <sys/stat.h>
 #include <openssl/evp.h>
 #include <openssl/rand.h>
 
-#define NAME         "aes"
-#define ENC_BUF_SIZE (1024 * 1024)
+#define NAME            "aes"
+#define ENC_BUF_SIZE    (1024 * 1024)
+#define CHUNKS_PER_TASK 64
 
 static _Thread_local unsigned char master_key_cache[EVP_MAX_KEY_LENGTH];
 static _Thread_local unsigned char cached_password_hash[EVP_MAX_MD_SIZE];
@@ -52,7 +57,9 @@ static _Thread_local bool master_key_cached = false;
 static unsigned char master_salt_cache[PBKDF2_SALT_LENGTH];
 static bool master_salt_cached = false;
 
-static void do_encrypt_file(struct worker_common* wc);
+struct aes_encryptor;
+struct chunked_file;
+
 static void do_decrypt_file(struct worker_common* wc);
 static int derive_key_iv(char* password, size_t password_length, unsigned char* salt, unsigned char* key, unsigned char* iv, int mode);
 static int aes_encrypt(char* plaintext, unsigned char* key, unsigned char* iv, char** ciphertext, int* ciphertext_length, int mode);
@@ -60,11 +67,20 @@ static int aes_decrypt(char* ciphertext, int ciphertext_length, unsigned char* k
 static const EVP_CIPHER* (*get_cipher(int mode))(void);
 static const EVP_CIPHER* (*get_cipher_buffer(int mode))(void);
 static int get_key_length(int mode);
-static int encrypt_file(char* from, char* to, int enc);
+static int legacy_decrypt_file(char* from, char* to);
+static int load_file_key(unsigned char* salt, unsigned char* key, int mode);
+static int cipher_file(char* from, char* to, int enc, struct workers* workers);
+static int chunked_file_prepare(char* from, char* to, int enc, struct workers* workers, int* result, struct chunked_file** file);
+static void chunked_file_finish(struct chunked_file* file);
+static void do_chunk_task(struct worker_common* wc);
+static void write_chunk_header(unsigned char* header, uint32_t chunk_size, unsigned char* salt, unsigned char* iv);
+static int read_chunk_header(unsigned char* header, uint32_t* chunk_size, unsigned char* salt);
+static int get_chunk_layout(uint64_t file_size, uint32_t chunk_size, uint64_t* number_of_chunks, uint64_t* plaintext_size);
+static int chunk_cipher(EVP_CIPHER_CTX* ctx, unsigned char* header, uint64_t index, bool final, unsigned char* in, size_t in_size, unsigned char* out, unsigned char* tag, int enc);
+static int read_fully(int fd, void* buf, size_t count, off_t offset);
+static int write_fully(int fd, void* buf, size_t count, off_t offset);
 static int pgmoneta_encrypt_data(int server, char* d, struct workers* workers, struct deque* excludes);
 static int decrypt_data(char* d, struct workers* workers, struct deque* excludes);
-static int dispatch_aes_operation(int server, char* from, char* to, int enc, struct workers* workers);
-static void do_aes_operation(struct worker_common* wc);
 
 static int encrypt_decrypt_buffer(unsigned char* origin_buffer, size_t origin_size, unsigned char** res_buffer, size_t* res_size, int enc, int mode);
 
@@ -76,6 +92,9 @@ static void aes_encryptor_close(struct encryptor* encryptor);
 static int aes_encryptor_encrypt(struct encryptor* encryptor, void* in_buf, size_t in_size, bool last_chunk, void** out_buf, size_t* out_size);
 static int aes_encryptor_decrypt(struct encryptor* encryptor, void* in_buf, size_t in_size, bool last_chunk, void** out_buf, size_t* out_size);
 static int aes_encryptor_process(struct encryptor* encryptor, void* in_buf, size_t in_size, bool last_chunk, int enc, void** out_buf, size_t* out_size);
+static int chunked_stream_process(struct aes_encryptor* this, unsigned char* in_buf, size_t in_size, bool last_chunk, int enc, bool write_header, size_t* out_size);
+static int chunked_stream_unit(struct aes_encryptor* this, unsigned char* data, size_t size, bool final, int enc, unsigned char* out, size_t* out_size);
+static int legacy_stream_decrypt(struct aes_encryptor* this, unsigned char* in_buf, size_t in_size, bool last_chunk, size_t* out_size);
 
 static void noop_encryptor_reset(struct encryptor* encryptor);
 static void noop_encryptor_close(struct encryptor* encryptor);
@@ -93,10 +112,17 @@ struct aes_encryptor
    unsigned char salt[PBKDF2_SALT_LENGTH];
    bool key_derived;
    int mode;
-   unsigned char* out_buf;                   /**< reusable output buffer */
-   size_t out_capacity;                      /**< allocated capacity of out_buf */
-   unsigned char tag_buffer[GCM_TAG_LENGTH]; /**< Buffer to hold the tag during streaming */
-   size_t tag_buffer_size;                   /**< Current size of data in tag_buffer */
+   unsigned char* out_buf;                        /**< reusable output buffer */
+   size_t out_capacity;                           /**< allocated capacity of out_buf */
+   unsigned char tag_buffer[GCM_TAG_LENGTH];      /**< Buffer to hold the tag during streaming */
+   size_t tag_buffer_size;                        /**< Current size of data in tag_buffer */
+   bool chunked;                                  /**< Is the stream in the chunked format */
+   unsigned char header[AES_CHUNK_HEADER_LENGTH]; /**< The chunked format header */
+   uint32_t chunk_size;                           /**< The plaintext size of a chunk */
+   uint64_t chunk_index;                          /**< The index of the next chunk */
+   unsigned char* pending;                        /**< Incomplete chunk waiting for more input */
+   size_t pending_capacity;                       /**< allocated capacity of pending */
+   size_t pending_size;                           /**< Current size of data in pending */
 };
 
 struct noop_encryptor
@@ -106,14 +132,36 @@ struct noop_encryptor
    size_t out_capacity;    /**< allocated capacity of out_buf */
 };
 
-struct aes_operation_task
+/** @struct chunked_file
+ * Defines a file being processed in the chunked format
+ */
+struct chunked_file
+{
+   char from[MAX_PATH];                           /**< The source file */
+   char to[MAX_PATH];                             /**< The destination file */
+   char tmp_to[MAX_PATH];                         /**< The temporary destination file */
+   int enc;                                       /**< 1 for encrypt, 0 for decrypt */
+   const EVP_CIPHER* (*cipher_fp)(void);          /**< The cipher */
+   unsigned char key[EVP_MAX_KEY_LENGTH];         /**< The file key */
+   unsigned char header[AES_CHUNK_HEADER_LENGTH]; /**< The header */
+   uint32_t chunk_size;                           /**< The plaintext size of a chunk */
+   uint64_t number_of_chunks;                     /**< The number of chunks */
+   uint64_t plaintext_size;                       /**< The plaintext size */
+   atomic_int remaining;                          /**< The number of unfinished tasks */
+   atomic_bool failed;                            /**< Has any task failed */
+   struct workers* workers;                       /**< The workers */
+   int* result;                                   /**< [out] The result when run synchronously */
+};
+
+/** @struct chunk_task
+ * Defines a range of chunks processed by one worker
+ */
+struct chunk_task
 {
-   struct worker_common common;
-   int enc;
-   char from[MAX_PATH];
-   char to[MAX_PATH];
-   int server;
-   bool progress_enabled;
+   struct worker_common common; /**< The common base */
+   struct chunked_file* file;   /**< The file */
+   uint64_t first;              /**< The first chunk */
+   uint64_t last;               /**< The chunk after the last one */
 };
 
 static int
@@ -226,34 +274,14 @@ pgmoneta_encrypt_data(int server, char* d, struct workers* workers, struct deque
 
             if (pgmoneta_exists(from))
             {
-               struct worker_input* wi = NULL;
-
-               if (!pgmoneta_create_worker_input(NULL, from, to, 0, workers, &wi))
+               if (cipher_file(from, to, 1, workers))
                {
-                  if (workers != NULL)
-                  {
-                     if (workers->outcome)
-                     {
-                        pgmoneta_workers_add(workers, do_encrypt_file, (struct worker_common*)wi);
-                     }
-                     else
-                     {
-                        do_encrypt_file((struct worker_common*)wi);
-                     }
-                  }
-                  else
-                  {
-                     do_encrypt_file((struct worker_common*)wi);
-                  }
-
-                  if (progress_enabled)
-                  {
-                     pgmoneta_progress_increment(server, 1);
-                  }
+                  pgmoneta_log_warn("pgmoneta_encrypt_data: %s -> %s", from, to);
                }
-               else
+
+               if (progress_enabled)
                {
-                  pgmoneta_log_error("Could not create a worker instance: %s -> %s", from, to);
+                  pgmoneta_progress_increment(server, 1);
                }
             }
 
@@ -280,34 +308,6 @@ error:
    return 1;
 }
 
-static void
-do_encrypt_file(struct worker_common* wc)
-{
-   struct worker_input* wi = (struct worker_input*)wc;
-
-   if (!encrypt_file(wi->from, wi->to, 1))
-   {
-      if (pgmoneta_exists(wi->from))
-      {
-         pgmoneta_delete_file(wi->from, NULL);
-      }
-      else
-      {
-         pgmoneta_log_debug("%s doesn't exists", wi->from);
-      }
-   }
-   else
-   {
-      pgmoneta_log_warn("do_encrypt_file: %s -> %s", wi->from, wi->to);
-      if (wi->common.workers != NULL)
-      {
-         wi->common.workers->outcome = false;
-      }
-   }
-
-   free(wi);
-}
-
 int
 pgmoneta_encrypt_directory(int server, char* d, struct workers* workers, struct deque* excludes)
 {
@@ -347,22 +347,13 @@ pgmoneta_encrypt_request(SSL* ssl, int client_fd, uint8_t compression, uint8_t e
    to = pgmoneta_append(to, from);
    to = pgmoneta_append(to, ".aes");
 
-   if (encrypt_file(from, to, 1))
+   if (cipher_file(from, to, 1, NULL))
    {
       ec = MANAGEMENT_ERROR_ENCRYPT_ERROR;
       pgmoneta_log_error("Encrypt: Error encrypting %s", from);
       goto error;
    }
 
-   if (pgmoneta_exists(from))
-   {
-      pgmoneta_delete_file(from, NULL);
-   }
-   else
-   {
-      pgmoneta_log_debug("%s doesn't exists", from);
-   }
-
    if (pgmoneta_management_create_response(payload, -1, &response))
    {
       ec = MANAGEMENT_ERROR_ALLOCATION;
@@ -425,39 +416,13 @@ pgmoneta_encrypt_file(char* from, char* to, struct workers* workers)
       flag = 1;
    }
 
-   if (workers != NULL)
-   {
-      ret = dispatch_aes_operation(-1, from, to, 1, workers);
-      if (flag)
-      {
-         free(to);
-      }
-      return ret;
-   }
-
-   if (encrypt_file(from, to, 1) != 0)
-   {
-      if (flag)
-      {
-         free(to);
-      }
-      return 1;
-   }
-
-   if (pgmoneta_exists(from))
-   {
-      pgmoneta_delete_file(from, NULL);
-   }
-   else
-   {
-      pgmoneta_log_debug("%s doesn't exists", from);
-   }
+   ret = cipher_file(from, to, 1, workers);
 
    if (flag)
    {
       free(to);
    }
-   return 0;
+   return ret;
 }
 
 int
@@ -481,38 +446,13 @@ pgmoneta_decrypt_file(char* from, char* to, struct workers* workers)
       flag = 1;
    }
 
-   if (workers != NULL)
-   {
-      ret = dispatch_aes_operation(-1, from, to, 0, workers);
-      if (flag)
-      {
-         free(to);
-      }
-      return ret;
-   }
-
-   if (encrypt_file(from, to, 0) != 0)
-   {
-      if (flag)
-      {
-         free(to);
-      }
-      return 1;
-   }
-   if (pgmoneta_exists(from))
-   {
-      pgmoneta_delete_file(from, NULL);
-   }
-   else
-   {
-      pgmoneta_log_debug("%s doesn't exists", from);
-   }
+   ret = cipher_file(from, to, 0, workers);
 
    if (flag)
    {
       free(to);
    }
-   return 0;
+   return ret;
 }
 
 static int
@@ -548,8 +488,6 @@ decrypt_data(char* d, struct workers* workers, struct deque* excludes)
       {
          if (pgmoneta_ends_with(entry->d_name, ".aes"))
          {
-            struct worker_input* wi = NULL;
-
             from = pgmoneta_append(from, d);
             from = pgmoneta_append(from, "/");
             from = pgmoneta_append(from, entry->d_name);
@@ -568,27 +506,9 @@ decrypt_data(char* d, struct workers* workers, struct deque* excludes)
             to = pgmoneta_append(to, "/");
             to = pgmoneta_append(to, name);
 
-            if (!pgmoneta_create_worker_input(NULL, from, to, 0, workers, &wi))
-            {
-               if (workers != NULL)
-               {
-                  if (workers->outcome)
-                  {
-                     pgmoneta_workers_add(workers, do_decrypt_file, (struct worker_common*)wi);
-                  }
-                  else
-                  {
-                     do_decrypt_file((struct worker_common*)wi);
-                  }
-               }
-               else
-               {
-                  do_decrypt_file((struct worker_common*)wi);
-               }
-            }
-            else
+            if (cipher_file(from, to, 0, workers))
             {
-               pgmoneta_log_error("Could not create a worker instance: %s -> %s", from, to);
+               pgmoneta_log_warn("decrypt_data: %s -> %s", from, to);
             }
 
             free(name);
@@ -650,7 +570,7 @@ do_decrypt_file(struct worker_common* wc)
 {
    struct worker_input* wi = (struct worker_input*)wc;
 
-   if (!encrypt_file(wi->from, wi->to, 0))
+   if (!legacy_decrypt_file(wi->from, wi->to))
    {
       if (pgmoneta_exists(wi->from))
       {
@@ -714,22 +634,13 @@ pgmoneta_decrypt_request(SSL* ssl, int client_fd, uint8_t compression, uint8_t e
    memset(to, 0, strlen(from) - 3);
    memcpy(to, from, strlen(from) - 4);
 
-   if (encrypt_file(from, to, 0))
+   if (cipher_file(from, to, 0, NULL))
    {
       ec = MANAGEMENT_ERROR_DECRYPT_ERROR;
       pgmoneta_log_error("Decrypt: Error decrypting %s", from);
       goto error;
    }
 
-   if (pgmoneta_exists(from))
-   {
-      pgmoneta_delete_file(from, NULL);
-   }
-   else
-   {
-      pgmoneta_log_debug("%s doesn't exists", from);
-   }
-
    if (pgmoneta_management_create_response(payload, -1, &response))
    {
       ec = MANAGEMENT_ERROR_ALLOCATION;
@@ -1189,229 +1100,821 @@ static const EVP_CIPHER* (*get_cipher(int mode))(void)
    return NULL;
 }
 
-/* enc: 1 for encrypt, 0 for decrypt */
 static int
-encrypt_file(char* from, char* to, int enc)
+cipher_file(char* from, char* to, int enc, struct workers* workers)
+{
+   struct chunked_file* file = NULL;
+   struct chunk_task* task = NULL;
+   struct worker_input* wi = NULL;
+   bool async = workers != NULL && workers->outcome;
+   uint64_t number_of_tasks = 0;
+   int result = 1;
+
+   if (!enc && !pgmoneta_is_encrypted_chunked(from))
+   {
+      if (async)
+      {
+         if (pgmoneta_create_worker_input(NULL, from, to, 0, workers, &wi))
+         {
+            pgmoneta_log_error("Could not create a worker instance: %s -> %s", from, to);
+            return 1;
+         }
+
+         if (pgmoneta_workers_add(workers, do_decrypt_file, (struct worker_common*)wi))
+         {
+            free(wi);
+            return 1;
+         }
+
+         return 0;
+      }
+
+      if (legacy_decrypt_file(from, to))
+      {
+         return 1;
+      }
+
+      if (pgmoneta_exists(from))
+      {
+         pgmoneta_delete_file(from, NULL);
+      }
+      else
+      {
+         pgmoneta_log_debug("%s doesn't exists", from);
+      }
+
+      return 0;
+   }
+
+   if (chunked_file_prepare(from, to, enc, workers, async ? NULL : &result, &file))
+   {
+      if (workers != NULL)
+      {
+         workers->outcome = false;
+      }
+      return 1;
+   }
+
+   number_of_tasks = (file->number_of_chunks + CHUNKS_PER_TASK - 1) / CHUNKS_PER_TASK;
+   atomic_store(&file->remaining, (int)number_of_tasks);
+
+   for (uint64_t i = 0; i < number_of_tasks; i++)
+   {
+      task = (struct chunk_task*)malloc(sizeof(struct chunk_task));
+      if (task == NULL)
+      {
+         pgmoneta_log_error("cipher_file: failed to allocate memory");
+         atomic_store(&file->failed, true);
+
+         /* Release the tasks that will never run, the last one finishes the file */
+         for (uint64_t j = i; j < number_of_tasks; j++)
+         {
+            if (atomic_fetch_sub(&file->remaining, 1) == 1)
+            {
+               chunked_file_finish(file);
+            }
+         }
+
+         return 1;
+      }
+
+      memset(task, 0, sizeof(struct chunk_task));
+      task->common.workers = workers;
+      task->file = file;
+      task->first = i * CHUNKS_PER_TASK;
+      task->last = MIN(task->first + CHUNKS_PER_TASK, file->number_of_chunks);
+
+      if (async)
+      {
+         if (pgmoneta_workers_add(workers, do_chunk_task, (struct worker_common*)task))
+         {
+            do_chunk_task((struct worker_common*)task);
+         }
+      }
+      else
+      {
+         do_chunk_task((struct worker_common*)task);
+      }
+   }
+
+   /* In the asynchronous case the outcome is reported through the workers */
+   return async ? 0 : result;
+}
+
+static int
+chunked_file_prepare(char* from, char* to, int enc, struct workers* workers, int* result, struct chunked_file** file)
 {
-   unsigned char key[EVP_MAX_KEY_LENGTH];
-   unsigned char iv[EVP_MAX_IV_LENGTH];
    unsigned char salt[PBKDF2_SALT_LENGTH];
-   unsigned char tag[GCM_TAG_LENGTH];
-   char* master_key = NULL;
-   EVP_CIPHER_CTX* ctx = NULL;
+   unsigned char iv[AES_GCM_IV_LENGTH];
+   struct chunked_file* f = NULL;
    struct main_configuration* config;
-   const EVP_CIPHER* (*cipher_fp)(void) = NULL;
-   int cipher_block_size = 0;
-   int inbuf_size = 0;
-   int outbuf_size = 0;
-   FILE* in = NULL;
-   FILE* out = NULL;
-   int inl = 0;
-   int outl = 0;
-   int f_len = 0;
-   int ret = 1;
-   char* tmp_to = NULL;
-
-   unsigned char* inbuf = NULL;
-   unsigned char* outbuf = NULL;
-   long remaining = 0;
+   struct stat st;
+   int in_fd = -1;
+   int out_fd = -1;
 
    config = (struct main_configuration*)shmem;
 
+   *file = NULL;
+
    if (config->common.encryption == ENCRYPTION_NONE)
    {
-      pgmoneta_log_error("encrypt_file: encryption is not configured (encryption = none)");
+      pgmoneta_log_error("chunked_file_prepare: encryption is not configured (encryption = none)");
       goto error;
    }
 
-   cipher_fp = get_cipher(config->common.encryption);
-   if (cipher_fp == NULL)
+   if (strlen(from) >= MAX_PATH || strlen(to) + strlen(".tmp") >= MAX_PATH)
    {
-      pgmoneta_log_error("encrypt_file: unsupported encryption mode: %d", config->common.encryption);
+      pgmoneta_log_error("chunked_file_prepare: path too long: %s -> %s", from, to);
       goto error;
    }
-   cipher_block_size = EVP_CIPHER_block_size(cipher_fp());
-   inbuf_size = ENC_BUF_SIZE;
-   outbuf_size = inbuf_size + cipher_block_size - 1;
-   inbuf = malloc(inbuf_size);
-   outbuf = malloc(outbuf_size);
-   if (inbuf == NULL || outbuf == NULL)
+
+   f = (struct chunked_file*)malloc(sizeof(struct chunked_file));
+   if (f == NULL)
    {
+      pgmoneta_log_error("chunked_file_prepare: failed to allocate memory");
       goto error;
    }
 
-   size_t master_key_length = 0;
-   unsigned char* master_salt = NULL;
-   size_t master_salt_length = 0;
+   memset(f, 0, sizeof(struct chunked_file));
+   pgmoneta_snprintf(f->from, sizeof(f->from), "%s", from);
+   pgmoneta_snprintf(f->to, sizeof(f->to), "%s", to);
+   pgmoneta_snprintf(f->tmp_to, sizeof(f->tmp_to), "%s.tmp", to);
+   f->enc = enc;
+   f->workers = workers;
+   f->result = result;
+   atomic_init(&f->remaining, 0);
+   atomic_init(&f->failed, false);
 
-   if (pgmoneta_get_master_key(&master_key, &master_key_length, &master_salt, &master_salt_length))
+   f->cipher_fp = get_cipher(config->common.encryption);
+   if (f->cipher_fp == NULL)
    {
-      pgmoneta_log_error("pgmoneta_get_master_key: Invalid master key");
+      pgmoneta_log_error("chunked_file_prepare: unsupported encryption mode: %d", config->common.encryption);
       goto error;
    }
 
-   if (master_salt != NULL)
+   in_fd = open(from, O_RDONLY);
+   if (in_fd == -1)
    {
-      pgmoneta_set_master_salt(master_salt);
-      free(master_salt);
+      pgmoneta_log_error("open: Could not open %s", from);
+      goto error;
    }
-   memset(&key, 0, sizeof(key));
-   memset(&iv, 0, sizeof(iv));
 
-   if (enc == 1)
+   if (fstat(in_fd, &st) != 0)
+   {
+      pgmoneta_log_error("fstat: Could not stat %s", from);
+      goto error;
+   }
+
+   if (enc)
    {
-      /* Encryption: generate a random salt */
       if (!RAND_bytes(salt, PBKDF2_SALT_LENGTH))
       {
          pgmoneta_log_error("RAND_bytes: Failed to generate salt");
          goto error;
       }
 
-      if (derive_key_iv(master_key, master_key_length, salt, key, NULL, config->common.encryption) != 0)
-      {
-         pgmoneta_log_error("derive_key_iv: Failed to derive key");
-         goto error;
-      }
-
       if (!RAND_bytes(iv, AES_GCM_IV_LENGTH))
       {
          pgmoneta_log_error("RAND_bytes: Failed to generate unique IV");
          goto error;
       }
+
+      f->chunk_size = AES_CHUNK_SIZE;
+      f->plaintext_size = (uint64_t)st.st_size;
+      f->number_of_chunks = f->plaintext_size == 0 ? 1 : (f->plaintext_size + f->chunk_size - 1) / f->chunk_size;
+      write_chunk_header(f->header, f->chunk_size, salt, iv);
    }
    else
    {
-      in = fopen(from, "rb");
-      if (in == NULL)
-      {
-         pgmoneta_log_error("fopen: Could not open %s", from);
-         goto error;
-      }
-
-      if (fread(salt, 1, PBKDF2_SALT_LENGTH, in) != PBKDF2_SALT_LENGTH)
-      {
-         pgmoneta_log_error("fread: failed to read salt from %s", from);
-         goto error;
-      }
-
-      if (fread(iv, 1, AES_GCM_IV_LENGTH, in) != AES_GCM_IV_LENGTH)
+      if (read_fully(in_fd, f->header, AES_CHUNK_HEADER_LENGTH, 0) ||
+          read_chunk_header(f->header, &f->chunk_size, salt))
       {
-         pgmoneta_log_error("fread: failed to read IV from %s", from);
+         pgmoneta_log_error("chunked_file_prepare: invalid header in %s", from);
          goto error;
       }
 
-      long file_size;
-      long header_size = PBKDF2_SALT_LENGTH + AES_GCM_IV_LENGTH;
-
-      if (fseek(in, 0L, SEEK_END) != 0)
-      {
-         pgmoneta_log_error("fseek: failed to seek to end of %s", from);
-         goto error;
-      }
-
-      file_size = ftell(in);
-      if (file_size < 0)
-      {
-         pgmoneta_log_error("ftell: failed to determine file size for %s", from);
-         goto error;
-      }
-
-      if (file_size < header_size + GCM_TAG_LENGTH)
+      if (get_chunk_layout((uint64_t)st.st_size, f->chunk_size, &f->number_of_chunks, &f->plaintext_size))
       {
          pgmoneta_log_error("Invalid encrypted file size for %s", from);
          goto error;
       }
-
-      remaining = file_size - header_size - GCM_TAG_LENGTH;
-
-      /* Seek to the end to read the GCM tag */
-      if (fseek(in, -((long)GCM_TAG_LENGTH), SEEK_END) != 0)
-      {
-         pgmoneta_log_error("fseek: failed to find GCM tag in %s", from);
-         goto error;
-      }
-      if (fread(tag, 1, GCM_TAG_LENGTH, in) != (size_t)GCM_TAG_LENGTH)
-      {
-         pgmoneta_log_error("fread: failed to read GCM tag from %s", from);
-         goto error;
-      }
-      /* Seek back to data start (after salt + IV) */
-      if (fseek(in, header_size, SEEK_SET) != 0)
-      {
-         pgmoneta_log_error("fseek: failed to return to data in %s", from);
-         goto error;
-      }
-
-      if (derive_key_iv(master_key, master_key_length, salt, key, NULL, config->common.encryption) != 0)
-      {
-         pgmoneta_log_error("derive_key_iv: Failed to derive key");
-         goto error;
-      }
    }
 
-   if (!(ctx = EVP_CIPHER_CTX_new()))
+   if (load_file_key(salt, f->key, config->common.encryption))
    {
-      pgmoneta_log_error("EVP_CIPHER_CTX_new: Failed to get context");
       goto error;
    }
 
-   if (enc == 1)
-   {
-      in = fopen(from, "rb");
-      if (in == NULL)
-      {
-         pgmoneta_log_error("fopen: Could not open %s", from);
-         goto error;
-      }
-   }
-
    if (pgmoneta_exists(to))
    {
-      pgmoneta_log_error("encrypt_file: destination file %s already exists", to);
+      pgmoneta_log_error("chunked_file_prepare: destination file %s already exists", to);
       goto error;
    }
 
-   tmp_to = pgmoneta_append(tmp_to, to);
-   tmp_to = pgmoneta_append(tmp_to, ".tmp");
-
-   out = fopen(tmp_to, "wb");
-   if (out == NULL)
+   out_fd = open(f->tmp_to, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+   if (out_fd == -1)
    {
-      pgmoneta_log_error("fopen: Could not open %s", tmp_to);
+      pgmoneta_log_error("open: Could not open %s", f->tmp_to);
       goto error;
    }
 
-   if (enc == 1)
+   if (enc && write_fully(out_fd, f->header, AES_CHUNK_HEADER_LENGTH, 0))
    {
-      /* Prepend salt and IV to the output file */
-      if (fwrite(salt, 1, PBKDF2_SALT_LENGTH, out) != PBKDF2_SALT_LENGTH)
-      {
-         pgmoneta_log_error("fwrite: failed to write salt");
-         goto error;
-      }
-      if (fwrite(iv, 1, AES_GCM_IV_LENGTH, out) != AES_GCM_IV_LENGTH)
-      {
-         pgmoneta_log_error("fwrite: failed to write IV");
-         goto error;
-      }
+      pgmoneta_log_error("write: failed to write header to %s", f->tmp_to);
+      goto error;
    }
 
-   if (EVP_CipherInit_ex(ctx, cipher_fp(), NULL, key, iv, enc) == 0)
+   close(in_fd);
+   close(out_fd);
+
+   pgmoneta_cleanse(salt, sizeof(salt));
+   pgmoneta_cleanse(iv, sizeof(iv));
+
+   *file = f;
+
+   return 0;
+
+error:
+
+   if (in_fd != -1)
+   {
+      close(in_fd);
+   }
+
+   if (out_fd != -1)
+   {
+      close(out_fd);
+      pgmoneta_delete_file(f->tmp_to, NULL);
+   }
+
+   if (f != NULL)
+   {
+      pgmoneta_cleanse(f->key, sizeof(f->key));
+      free(f);
+   }
+
+   pgmoneta_cleanse(salt, sizeof(salt));
+   pgmoneta_cleanse(iv, sizeof(iv));
+
+   return 1;
+}
+
+static void
+do_chunk_task(struct worker_common* wc)
+{
+   struct chunk_task* task = (struct chunk_task*)wc;
+   struct chunked_file* file = task->file;
+   size_t unit = (size_t)file->chunk_size + GCM_TAG_LENGTH;
+   EVP_CIPHER_CTX* ctx = NULL;
+   unsigned char* inbuf = NULL;
+   unsigned char* outbuf = NULL;
+   int in_fd = -1;
+   int out_fd = -1;
+
+   if (atomic_load(&file->failed))
+   {
+      goto done;
+   }
+
+   in_fd = open(file->from, O_RDONLY);
+   if (in_fd == -1)
+   {
+      pgmoneta_log_error("open: Could not open %s", file->from);
+      goto error;
+   }
+
+   out_fd = open(file->tmp_to, O_WRONLY);
+   if (out_fd == -1)
+   {
+      pgmoneta_log_error("open: Could not open %s", file->tmp_to);
+      goto error;
+   }
+
+   inbuf = malloc(unit);
+   outbuf = malloc(unit);
+   if (inbuf == NULL || outbuf == NULL)
+   {
+      pgmoneta_log_error("do_chunk_task: failed to allocate memory");
+      goto error;
+   }
+
+   if (!(ctx = EVP_CIPHER_CTX_new()))
+   {
+      pgmoneta_log_error("EVP_CIPHER_CTX_new: Failed to get context");
+      goto error;
+   }
+
+   if (EVP_CipherInit_ex(ctx, file->cipher_fp(), NULL, file->key, NULL, file->enc) == 0)
+   {
+      pgmoneta_log_error("EVP_CipherInit_ex: Failed to initialize context");
+      goto error;
+   }
+
+   for (uint64_t i = task->first; i < task->last; i++)
+   {
+      uint64_t plaintext_offset = i * file->chunk_size;
+      uint64_t ciphertext_offset = AES_CHUNK_HEADER_LENGTH + i * unit;
+      size_t length = (size_t)MIN((uint64_t)file->chunk_size, file->plaintext_size - plaintext_offset);
+      bool final = i == file->number_of_chunks - 1;
+
+      /* Another task found a problem, no need to continue */
+      if (atomic_load(&file->failed))
+      {
+         goto error;
+      }
+
+      if (file->enc)
+      {
+         if (read_fully(in_fd, inbuf, length, (off_t)plaintext_offset))
+         {
+            pgmoneta_log_error("read: failed to read chunk %" PRIu64 " from %s", i, file->from);
+            goto error;
+         }
+
+         if (chunk_cipher(ctx, file->header, i, final, inbuf, length, outbuf, outbuf + length, 1))
+         {
+            goto error;
+         }
+
+         if (write_fully(out_fd, outbuf, length + GCM_TAG_LENGTH, (off_t)ciphertext_offset))
+         {
+            pgmoneta_log_error("write: failed to write chunk %" PRIu64 " to %s", i, file->tmp_to);
+            goto error;
+         }
+      }
+      else
+      {
+         if (read_fully(in_fd, inbuf, length + GCM_TAG_LENGTH, (off_t)ciphertext_offset))
+         {
+            pgmoneta_log_error("read: failed to read chunk %" PRIu64 " from %s", i, file->from);
+            goto error;
+         }
+
+         if (chunk_cipher(ctx, file->header, i, final, inbuf, length, outbuf, inbuf + length, 0))
+         {
+            pgmoneta_log_error("do_chunk_task: authentication failed for chunk %" PRIu64 " of %s", i, file->from);
+            goto error;
+         }
+
+         if (write_fully(out_fd, outbuf, length, (off_t)plaintext_offset))
+         {
+            pgmoneta_log_error("write: failed to write chunk %" PRIu64 " to %s", i, file->tmp_to);
+            goto error;
+         }
+      }
+   }
+
+   goto done;
+
+error:
+
+   atomic_store(&file->failed, true);
+
+done:
+
+   if (ctx != NULL)
+   {
+      EVP_CIPHER_CTX_free(ctx);
+   }
+
+   if (inbuf != NULL)
+   {
+      pgmoneta_cleanse(inbuf, unit);
+      free(inbuf);
+   }
+
+   if (outbuf != NULL)
+   {
+      pgmoneta_cleanse(outbuf, unit);
+      free(outbuf);
+   }
+
+   if (in_fd != -1)
+   {
+      close(in_fd);
+   }
+
+   if (out_fd != -1)
+   {
+      close(out_fd);
+   }
+
+   if (atomic_fetch_sub(&file->remaining, 1) == 1)
+   {
+      chunked_file_finish(file);
+   }
+
+   free(task);
+}
+
+static void
+chunked_file_finish(struct chunked_file* file)
+{
+   bool failed = atomic_load(&file->failed);
+
+   if (!failed)
+   {
+      pgmoneta_permission(file->tmp_to, 6, 0, 0);
+      if (pgmoneta_move_file(file->tmp_to, file->to))
+      {
+         failed = true;
+      }
+   }
+
+   if (!failed)
+   {
+      if (pgmoneta_exists(file->from))
+      {
+         pgmoneta_delete_file(file->from, NULL);
+      }
+      else
+      {
+         pgmoneta_log_debug("%s doesn't exists", file->from);
+      }
+   }
+   else
+   {
+      pgmoneta_log_warn("chunked_file_finish: %s -> %s", file->from, file->to);
+      pgmoneta_delete_file(file->tmp_to, NULL);
+
+      if (file->workers != NULL)
+      {
+         file->workers->outcome = false;
+      }
+   }
+
+   if (file->result != NULL)
+   {
+      *file->result = failed ? 1 : 0;
+   }
+
+   pgmoneta_cleanse(file->key, sizeof(file->key));
+   free(file);
+}
+
+static void
+write_chunk_header(unsigned char* header, uint32_t chunk_size, unsigned char* salt, unsigned char* iv)
+{
+   memcpy(header, AES_CHUNK_MAGIC, AES_CHUNK_MAGIC_LENGTH);
+   pgmoneta_write_uint8(header + AES_CHUNK_MAGIC_LENGTH, AES_CHUNK_VERSION);
+   pgmoneta_write_uint32(header + AES_CHUNK_MAGIC_LENGTH + 1, chunk_size);
+   memcpy(header + AES_CHUNK_MAGIC_LENGTH + 5, salt, PBKDF2_SALT_LENGTH);
+   memcpy(header + AES_CHUNK_MAGIC_LENGTH + 5 + PBKDF2_SALT_LENGTH, iv, AES_GCM_IV_LENGTH);
+}
+
+static int
+read_chunk_header(unsigned char* header, uint32_t* chunk_size, unsigned char* salt)
+{
+   uint32_t size;
+
+   if (memcmp(header, AES_CHUNK_MAGIC, AES_CHUNK_MAGIC_LENGTH) != 0)
+   {
+      return 1;
+   }
+
+   if (pgmoneta_read_uint8(header + AES_CHUNK_MAGIC_LENGTH) != AES_CHUNK_VERSION)
+   {
+      pgmoneta_log_error("read_chunk_header: unsupported version %d", pgmoneta_read_uint8(header + AES_CHUNK_MAGIC_LENGTH));
+      return 1;
+   }
+
+   size = pgmoneta_read_uint32(header + AES_CHUNK_MAGIC_LENGTH + 1);
+   if (size == 0 || size > INT_MAX - GCM_TAG_LENGTH)
+   {
+      pgmoneta_log_error("read_chunk_header: invalid chunk size %u", size);
+      return 1;
+   }
+
+   *chunk_size = size;
+   memcpy(salt, header + AES_CHUNK_MAGIC_LENGTH + 5, PBKDF2_SALT_LENGTH);
+
+   return 0;
+}
+
+static int
+get_chunk_layout(uint64_t file_size, uint32_t chunk_size, uint64_t* number_of_chunks, uint64_t* plaintext_size)
+{
+   uint64_t unit = (uint64_t)chunk_size + GCM_TAG_LENGTH;
+   uint64_t body;
+   uint64_t n;
+
+   /* There is always at least one, possibly empty, chunk */
+   if (file_size < AES_CHUNK_HEADER_LENGTH + GCM_TAG_LENGTH)
+   {
+      return 1;
+   }
+
+   body = file_size - AES_CHUNK_HEADER_LENGTH;
+   n = (body + unit - 1) / unit;
+
+   if (body - (n - 1) * unit < GCM_TAG_LENGTH)
+   {
+      return 1;
+   }
+
+   *number_of_chunks = n;
+   *plaintext_size = body - n * GCM_TAG_LENGTH;
+
+   return 0;
+}
+
+static int
+chunk_cipher(EVP_CIPHER_CTX* ctx, unsigned char* header, uint64_t index, bool final, unsigned char* in, size_t in_size, unsigned char* out, unsigned char* tag, int enc)
+{
+   unsigned char nonce[AES_GCM_IV_LENGTH];
+   unsigned char final_flag = final ? 1 : 0;
+   int outl = 0;
+   int final_size = 0;
+
+   /* The nonce is the file IV with the chunk index mixed into the low 64 bits */
+   memcpy(nonce, header + AES_CHUNK_HEADER_LENGTH - AES_GCM_IV_LENGTH, AES_GCM_IV_LENGTH);
+   for (int i = 0; i < 8; i++)
+   {
+      nonce[AES_GCM_IV_LENGTH - 1 - i] ^= (unsigned char)(index >> (8 * i));
+   }
+
+   if (EVP_CipherInit_ex(ctx, NULL, NULL, NULL, nonce, enc) == 0)
+   {
+      pgmoneta_log_error("EVP_CipherInit_ex: Failed to set chunk nonce");
+      return 1;
+   }
+
+   /* The header and the final marker are authenticated with every chunk,
+      so chunks can't be reordered, moved between files or truncated */
+   if (EVP_CipherUpdate(ctx, NULL, &outl, header, AES_CHUNK_HEADER_LENGTH) == 0 ||
+       EVP_CipherUpdate(ctx, NULL, &outl, &final_flag, 1) == 0)
+   {
+      pgmoneta_log_error("EVP_CipherUpdate: failed to process additional data");
+      return 1;
+   }
+
+   if (!enc && EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, GCM_TAG_LENGTH, tag) == 0)
+   {
+      pgmoneta_log_error("EVP_CIPHER_CTX_ctrl: failed to set GCM tag");
+      return 1;
+   }
+
+   outl = 0;
+   if (in_size > 0 && EVP_CipherUpdate(ctx, out, &outl, in, (int)in_size) == 0)
+   {
+      pgmoneta_log_error("EVP_CipherUpdate: failed to process chunk %" PRIu64, index);
+      return 1;
+   }
+
+   if (EVP_CipherFinal_ex(ctx, out + outl, &final_size) == 0)
+   {
+      return 1;
+   }
+
+   if (enc && EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG, GCM_TAG_LENGTH, tag) == 0)
+   {
+      pgmoneta_log_error("EVP_CIPHER_CTX_ctrl: failed to get GCM tag");
+      return 1;
+   }
+
+   return 0;
+}
+
+static int
+read_fully(int fd, void* buf, size_t count, off_t offset)
+{
+   size_t done = 0;
+   ssize_t r;
+
+   while (done < count)
+   {
+      r = pread(fd, (unsigned char*)buf + done, count - done, offset + (off_t)done);
+      if (r < 0 && errno == EINTR)
+      {
+         continue;
+      }
+      if (r <= 0)
+      {
+         return 1;
+      }
+      done += (size_t)r;
+   }
+
+   return 0;
+}
+
+static int
+write_fully(int fd, void* buf, size_t count, off_t offset)
+{
+   size_t done = 0;
+   ssize_t w;
+
+   while (done < count)
+   {
+      w = pwrite(fd, (unsigned char*)buf + done, count - done, offset + (off_t)done);
+      if (w < 0 && errno == EINTR)
+      {
+         continue;
+      }
+      if (w <= 0)
+      {
+         return 1;
+      }
+      done += (size_t)w;
+   }
+
+   return 0;
+}
+
+static int
+load_file_key(unsigned char* salt, unsigned char* key, int mode)
+{
+   char* master_key = NULL;
+   size_t master_key_length = 0;
+   unsigned char* master_salt = NULL;
+   size_t master_salt_length = 0;
+   int ret = 1;
+
+   if (pgmoneta_get_master_key(&master_key, &master_key_length, &master_salt, &master_salt_length))
+   {
+      pgmoneta_log_error("pgmoneta_get_master_key: Invalid master key");
+      goto cleanup;
+   }
+
+   if (master_salt != NULL)
+   {
+      pgmoneta_set_master_salt(master_salt);
+      free(master_salt);
+   }
+
+   if (derive_key_iv(master_key, master_key_length, salt, key, NULL, mode) != 0)
+   {
+      pgmoneta_log_error("derive_key_iv: Failed to derive key");
+      goto cleanup;
+   }
+
+   ret = 0;
+
+cleanup:
+
+   if (master_key != NULL)
+   {
+      pgmoneta_cleanse(master_key, master_key_length);
+      free(master_key);
+   }
+
+   return ret;
+}
+
+static int
+legacy_decrypt_file(char* from, char* to)
+{
+   unsigned char key[EVP_MAX_KEY_LENGTH];
+   unsigned char iv[EVP_MAX_IV_LENGTH];
+   unsigned char salt[PBKDF2_SALT_LENGTH];
+   unsigned char tag[GCM_TAG_LENGTH];
+   EVP_CIPHER_CTX* ctx = NULL;
+   struct main_configuration* config;
+   const EVP_CIPHER* (*cipher_fp)(void) = NULL;
+   int cipher_block_size = 0;
+   int inbuf_size = 0;
+   int outbuf_size = 0;
+   FILE* in = NULL;
+   FILE* out = NULL;
+   int inl = 0;
+   int outl = 0;
+   int f_len = 0;
+   int ret = 1;
+   char* tmp_to = NULL;
+   long file_size;
+   long header_size = PBKDF2_SALT_LENGTH + AES_GCM_IV_LENGTH;
+
+   unsigned char* inbuf = NULL;
+   unsigned char* outbuf = NULL;
+   long remaining = 0;
+
+   config = (struct main_configuration*)shmem;
+
+   memset(&key, 0, sizeof(key));
+   memset(&iv, 0, sizeof(iv));
+   memset(&salt, 0, sizeof(salt));
+   memset(&tag, 0, sizeof(tag));
+
+   if (config->common.encryption == ENCRYPTION_NONE)
+   {
+      pgmoneta_log_error("legacy_decrypt_file: encryption is not configured (encryption = none)");
+      goto error;
+   }
+
+   cipher_fp = get_cipher(config->common.encryption);
+   if (cipher_fp == NULL)
+   {
+      pgmoneta_log_error("legacy_decrypt_file: unsupported encryption mode: %d", config->common.encryption);
+      goto error;
+   }
+   cipher_block_size = EVP_CIPHER_block_size(cipher_fp());
+   inbuf_size = ENC_BUF_SIZE;
+   outbuf_size = inbuf_size + cipher_block_size - 1;
+   inbuf = malloc(inbuf_size);
+   outbuf = malloc(outbuf_size);
+   if (inbuf == NULL || outbuf == NULL)
+   {
+      goto error;
+   }
+
+   in = fopen(from, "rb");
+   if (in == NULL)
+   {
+      pgmoneta_log_error("fopen: Could not open %s", from);
+      goto error;
+   }
+
+   if (fread(salt, 1, PBKDF2_SALT_LENGTH, in) != PBKDF2_SALT_LENGTH)
+   {
+      pgmoneta_log_error("fread: failed to read salt from %s", from);
+      goto error;
+   }
+
+   if (fread(iv, 1, AES_GCM_IV_LENGTH, in) != AES_GCM_IV_LENGTH)
+   {
+      pgmoneta_log_error("fread: failed to read IV from %s", from);
+      goto error;
+   }
+
+   if (fseek(in, 0L, SEEK_END) != 0)
+   {
+      pgmoneta_log_error("fseek: failed to seek to end of %s", from);
+      goto error;
+   }
+
+   file_size = ftell(in);
+   if (file_size < 0)
+   {
+      pgmoneta_log_error("ftell: failed to determine file size for %s", from);
+      goto error;
+   }
+
+   if (file_size < header_size + GCM_TAG_LENGTH)
+   {
+      pgmoneta_log_error("Invalid encrypted file size for %s", from);
+      goto error;
+   }
+
+   remaining = file_size - header_size - GCM_TAG_LENGTH;
+
+   /* Seek to the end to read the GCM tag */
+   if (fseek(in, -((long)GCM_TAG_LENGTH), SEEK_END) != 0)
+   {
+      pgmoneta_log_error("fseek: failed to find GCM tag in %s", from);
+      goto error;
+   }
+   if (fread(tag, 1, GCM_TAG_LENGTH, in) != (size_t)GCM_TAG_LENGTH)
+   {
+      pgmoneta_log_error("fread: failed to read GCM tag from %s", from);
+      goto error;
+   }
+   /* Seek back to data start (after salt + IV) */
+   if (fseek(in, header_size, SEEK_SET) != 0)
+   {
+      pgmoneta_log_error("fseek: failed to return to data in %s", from);
+      goto error;
+   }
+
+   if (load_file_key(salt, key, config->common.encryption))
+   {
+      goto error;
+   }
+
+   if (!(ctx = EVP_CIPHER_CTX_new()))
+   {
+      pgmoneta_log_error("EVP_CIPHER_CTX_new: Failed to get context");
+      goto error;
+   }
+
+   if (pgmoneta_exists(to))
+   {
+      pgmoneta_log_error("legacy_decrypt_file: destination file %s already exists", to);
+      goto error;
+   }
+
+   tmp_to = pgmoneta_append(tmp_to, to);
+   tmp_to = pgmoneta_append(tmp_to, ".tmp");
+
+   out = fopen(tmp_to, "wb");
+   if (out == NULL)
+   {
+      pgmoneta_log_error("fopen: Could not open %s", tmp_to);
+      goto error;
+   }
+
+   if (EVP_CipherInit_ex(ctx, cipher_fp(), NULL, key, iv, 0) == 0)
    {
       pgmoneta_log_error("EVP_CipherInit_ex: Failed to initialize context");
       goto error;
    }
 
-   if (!enc)
+   if (EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, GCM_TAG_LENGTH, tag) == 0)
    {
-      if (EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, GCM_TAG_LENGTH, tag) == 0)
-      {
-         pgmoneta_log_error("EVP_CIPHER_CTX_ctrl: failed to set GCM tag");
-         goto error;
-      }
+      pgmoneta_log_error("EVP_CIPHER_CTX_ctrl: failed to set GCM tag");
+      goto error;
    }
 
-   while ((inl = fread(inbuf, sizeof(char), (!enc && remaining < inbuf_size) ? remaining : inbuf_size, in)) > 0)
+   while (remaining > 0 && (inl = fread(inbuf, sizeof(char), remaining < inbuf_size ? remaining : inbuf_size, in)) > 0)
    {
       if (EVP_CipherUpdate(ctx, outbuf, &outl, inbuf, inl) == 0)
       {
@@ -1424,14 +1927,7 @@ encrypt_file(char* from, char* to, int enc)
          goto error;
       }
 
-      if (!enc)
-      {
-         remaining -= inl;
-         if (remaining == 0)
-         {
-            break;
-         }
-      }
+      remaining -= inl;
    }
 
    if (ferror(in))
@@ -1455,20 +1951,6 @@ encrypt_file(char* from, char* to, int enc)
       }
    }
 
-   if (enc)
-   {
-      if (EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG, GCM_TAG_LENGTH, tag) == 0)
-      {
-         pgmoneta_log_error("EVP_CIPHER_CTX_ctrl: failed to get GCM tag");
-         goto error;
-      }
-      if (fwrite(tag, sizeof(char), GCM_TAG_LENGTH, out) != (size_t)GCM_TAG_LENGTH)
-      {
-         pgmoneta_log_error("fwrite: failed to write GCM tag at the end");
-         goto error;
-      }
-   }
-
    ret = 0;
 
 cleanup:
@@ -1483,12 +1965,6 @@ cleanup:
    pgmoneta_cleanse(salt, sizeof(salt));
    pgmoneta_cleanse(tag, sizeof(tag));
 
-   if (master_key != NULL)
-   {
-      pgmoneta_cleanse(master_key, master_key_length);
-      free(master_key);
-   }
-
    if (in != NULL)
    {
       fclose(in);
@@ -1500,18 +1976,21 @@ cleanup:
       fclose(out);
    }
 
-   if (ret == 0)
+   if (tmp_to != NULL)
    {
-      pgmoneta_permission(tmp_to, 6, 0, 0);
-      if (pgmoneta_move_file(tmp_to, to))
+      if (ret == 0)
+      {
+         pgmoneta_permission(tmp_to, 6, 0, 0);
+         if (pgmoneta_move_file(tmp_to, to))
+         {
+            ret = 1;
+         }
+      }
+      else
       {
-         ret = 1;
+         pgmoneta_delete_file(tmp_to, NULL);
       }
    }
-   else
-   {
-      pgmoneta_delete_file(tmp_to, NULL);
-   }
 
    free(tmp_to);
    if (inbuf != NULL)
@@ -1891,6 +2370,9 @@ aes_encryptor_reset(struct encryptor* encryptor)
    }
    this->tag_buffer_size = 0;
    memset(this->tag_buffer, 0, sizeof(this->tag_buffer));
+   this->chunked = false;
+   this->chunk_index = 0;
+   this->pending_size = 0;
 }
 
 static void
@@ -1923,6 +2405,15 @@ aes_encryptor_close(struct encryptor* encryptor)
    }
    this->out_capacity = 0;
 
+   if (this->pending != NULL)
+   {
+      pgmoneta_cleanse(this->pending, this->pending_capacity);
+      free(this->pending);
+      this->pending = NULL;
+   }
+   this->pending_capacity = 0;
+   this->pending_size = 0;
+
    pgmoneta_cleanse(this->key, sizeof(this->key));
    pgmoneta_cleanse(this->iv, sizeof(this->iv));
    pgmoneta_cleanse(this->salt, sizeof(this->salt));
@@ -1945,13 +2436,9 @@ static int
 aes_encryptor_process(struct encryptor* encryptor, void* in_buf, size_t in_size, bool last_chunk, int enc, void** out_buf, size_t* out_size)
 {
    struct aes_encryptor* this = (struct aes_encryptor*)encryptor;
-   size_t required = 0;
-   int size = 0;
-   int final_size = 0;
+   size_t size = 0;
    bool write_header = false;
-   int offset = 0;
 
-   unsigned char tag[GCM_TAG_LENGTH];
    char* master_key = NULL;
    size_t master_key_length = 0;
 
@@ -1972,6 +2459,7 @@ aes_encryptor_process(struct encryptor* encryptor, void* in_buf, size_t in_size,
    {
       unsigned char* master_salt = NULL;
       size_t master_salt_length = 0;
+      unsigned char salt[PBKDF2_SALT_LENGTH];
 
       if (pgmoneta_get_master_key(&master_key, &master_key_length, &master_salt, &master_salt_length))
       {
@@ -2008,232 +2496,347 @@ aes_encryptor_process(struct encryptor* encryptor, void* in_buf, size_t in_size,
             goto error;
          }
 
+         /* New streams are always written in the chunked format */
+         this->chunked = true;
+         this->chunk_size = AES_CHUNK_SIZE;
+         write_chunk_header(this->header, this->chunk_size, this->salt, this->iv);
          write_header = true;
       }
+      else if (in_size >= AES_CHUNK_MAGIC_LENGTH && memcmp(in_buf, AES_CHUNK_MAGIC, AES_CHUNK_MAGIC_LENGTH) == 0)
+      {
+         if (in_size < AES_CHUNK_HEADER_LENGTH || read_chunk_header(in_buf, &this->chunk_size, salt))
+         {
+            pgmoneta_log_error("Unable to load chunked header");
+            goto error;
+         }
+
+         if (!this->key_derived || memcmp(this->salt, salt, PBKDF2_SALT_LENGTH) != 0)
+         {
+            memcpy(this->salt, salt, PBKDF2_SALT_LENGTH);
+            if (derive_key_iv(master_key, master_key_length, this->salt, this->key, NULL, this->mode) != 0)
+            {
+               pgmoneta_log_error("derive_key_iv: Failed to derive master key");
+               goto error;
+            }
+            this->key_derived = true;
+         }
+
+         this->chunked = true;
+         memcpy(this->header, in_buf, AES_CHUNK_HEADER_LENGTH);
+         in_buf = (unsigned char*)in_buf + AES_CHUNK_HEADER_LENGTH;
+         in_size -= AES_CHUNK_HEADER_LENGTH;
+      }
       else
       {
          size_t header_len = PBKDF2_SALT_LENGTH + AES_GCM_IV_LENGTH;
 
-         if (in_size < header_len)
+         if (in_size < header_len)
+         {
+            pgmoneta_log_error("Unable to load Salt+IV header");
+            goto error;
+         }
+
+         /* Only re-derive the key if we haven't already, or if the stream salt changed somehow */
+         if (!this->key_derived || memcmp(this->salt, in_buf, PBKDF2_SALT_LENGTH) != 0)
+         {
+            memcpy(this->salt, in_buf, PBKDF2_SALT_LENGTH);
+            if (derive_key_iv(master_key, master_key_length, this->salt, this->key, NULL, this->mode) != 0)
+            {
+               pgmoneta_log_error("derive_key_iv: Failed to derive master key");
+               goto error;
+            }
+            this->key_derived = true;
+         }
+
+         memcpy(this->iv, (unsigned char*)in_buf + PBKDF2_SALT_LENGTH, (size_t)AES_GCM_IV_LENGTH);
+         in_buf = (unsigned char*)in_buf + PBKDF2_SALT_LENGTH + AES_GCM_IV_LENGTH;
+         in_size -= (PBKDF2_SALT_LENGTH + AES_GCM_IV_LENGTH);
+      }
+
+      pgmoneta_cleanse(salt, sizeof(salt));
+
+      if (!(this->ctx = EVP_CIPHER_CTX_new()))
+      {
+         pgmoneta_log_error("EVP_CIPHER_CTX_new: Failed to get context");
+         goto error;
+      }
+
+      /* Chunked streams set a nonce per chunk */
+      if (EVP_CipherInit_ex(this->ctx, this->cipher_fp(), NULL, this->key, this->chunked ? NULL : this->iv, enc) == 0)
+      {
+         pgmoneta_log_error("EVP_CipherInit_ex: failed to initialize context");
+         goto error;
+      }
+   }
+
+   if (in_size > INT_MAX)
+   {
+      pgmoneta_log_error("aes_encryptor_process: input size exceeds INT_MAX");
+      goto error;
+   }
+
+   if (this->chunked)
+   {
+      if (chunked_stream_process(this, (unsigned char*)in_buf, in_size, last_chunk, enc, write_header, &size))
+      {
+         goto error;
+      }
+   }
+   else
+   {
+      if (enc || legacy_stream_decrypt(this, (unsigned char*)in_buf, in_size, last_chunk, &size))
+      {
+         goto error;
+      }
+   }
+
+   *out_buf = (void*)this->out_buf;
+   *out_size = size;
+
+   if (master_key != NULL)
+   {
+      pgmoneta_cleanse(master_key, master_key_length);
+      free(master_key);
+   }
+
+   return 0;
+
+error:
+
+   if (master_key != NULL)
+   {
+      pgmoneta_cleanse(master_key, master_key_length);
+      free(master_key);
+   }
+   if (out_buf != NULL)
+   {
+      *out_buf = NULL;
+   }
+   if (out_size != NULL)
+   {
+      *out_size = 0;
+   }
+
+   return 1;
+}
+
+static int
+chunked_stream_process(struct aes_encryptor* this, unsigned char* in_buf, size_t in_size, bool last_chunk, int enc, bool write_header, size_t* out_size)
+{
+   size_t unit = enc ? (size_t)this->chunk_size : (size_t)this->chunk_size + GCM_TAG_LENGTH;
+   size_t total = this->pending_size + in_size;
+   size_t required = 0;
+   size_t offset = 0;
+   size_t size = 0;
+   size_t n = 0;
+
+   *out_size = 0;
+
+   /* Output never exceeds the input plus one tag for each chunk */
+   if (total > (SIZE_MAX - AES_CHUNK_HEADER_LENGTH) / 2)
+   {
+      return 1;
+   }
+   required = AES_CHUNK_HEADER_LENGTH + total + (total / this->chunk_size + 2) * GCM_TAG_LENGTH;
+
+   if (ensure_capacity(&this->out_buf, &this->out_capacity, required) ||
+       ensure_capacity(&this->pending, &this->pending_capacity, unit))
+   {
+      pgmoneta_log_error("aes_encryptor_process: failed to ensure buffer capacity");
+      return 1;
+   }
+
+   if (write_header)
+   {
+      memcpy(this->out_buf, this->header, AES_CHUNK_HEADER_LENGTH);
+      offset += AES_CHUNK_HEADER_LENGTH;
+   }
+
+   while (in_size > 0)
+   {
+      /* A full chunk is only known not to be the last one once more data arrives */
+      if (this->pending_size == unit)
+      {
+         if (chunked_stream_unit(this, this->pending, this->pending_size, false, enc, this->out_buf + offset, &size))
          {
-            pgmoneta_log_error("Unable to load Salt+IV header");
-            goto error;
+            return 1;
          }
+         offset += size;
+         this->pending_size = 0;
+      }
 
-         /* Only re-derive the key if we haven't already, or if the stream salt changed somehow */
-         if (!this->key_derived || memcmp(this->salt, in_buf, PBKDF2_SALT_LENGTH) != 0)
+      if (this->pending_size == 0 && in_size > unit)
+      {
+         if (chunked_stream_unit(this, in_buf, unit, false, enc, this->out_buf + offset, &size))
          {
-            memcpy(this->salt, in_buf, PBKDF2_SALT_LENGTH);
-            if (derive_key_iv(master_key, master_key_length, this->salt, this->key, NULL, this->mode) != 0)
-            {
-               pgmoneta_log_error("derive_key_iv: Failed to derive master key");
-               goto error;
-            }
-            this->key_derived = true;
+            return 1;
          }
-
-         memcpy(this->iv, (unsigned char*)in_buf + PBKDF2_SALT_LENGTH, (size_t)AES_GCM_IV_LENGTH);
-         in_buf = (unsigned char*)in_buf + PBKDF2_SALT_LENGTH + AES_GCM_IV_LENGTH;
-         in_size -= (PBKDF2_SALT_LENGTH + AES_GCM_IV_LENGTH);
+         offset += size;
+         in_buf += unit;
+         in_size -= unit;
+         continue;
       }
 
-      if (!(this->ctx = EVP_CIPHER_CTX_new()))
-      {
-         pgmoneta_log_error("EVP_CIPHER_CTX_new: Failed to get context");
-         goto error;
-      }
+      n = MIN(unit - this->pending_size, in_size);
+      memcpy(this->pending + this->pending_size, in_buf, n);
+      this->pending_size += n;
+      in_buf += n;
+      in_size -= n;
+   }
 
-      if (EVP_CipherInit_ex(this->ctx, this->cipher_fp(), NULL, this->key, this->iv, enc) == 0)
+   if (last_chunk)
+   {
+      if (chunked_stream_unit(this, this->pending, this->pending_size, true, enc, this->out_buf + offset, &size))
       {
-         pgmoneta_log_error("EVP_CipherInit_ex: failed to initialize context");
-         goto error;
+         return 1;
       }
+      offset += size;
+      this->pending_size = 0;
    }
 
-   if (in_size > INT_MAX)
-   {
-      pgmoneta_log_error("aes_encryptor_process: input size exceeds INT_MAX");
-      goto error;
-   }
+   *out_size = offset;
 
-   required = in_size;
+   return 0;
+}
+
+static int
+chunked_stream_unit(struct aes_encryptor* this, unsigned char* data, size_t size, bool final, int enc, unsigned char* out, size_t* out_size)
+{
+   *out_size = 0;
 
-   if (required > SIZE_MAX - (size_t)this->cipher_block_size)
+   if (enc)
    {
-      goto error;
+      if (chunk_cipher(this->ctx, this->header, this->chunk_index, final, data, size, out, out + size, 1))
+      {
+         pgmoneta_log_error("aes_encryptor_process: failed to encrypt chunk %" PRIu64, this->chunk_index);
+         return 1;
+      }
+      *out_size = size + GCM_TAG_LENGTH;
    }
-   required += (size_t)this->cipher_block_size;
-
-   if (last_chunk)
+   else
    {
-      if (required > SIZE_MAX - (size_t)this->cipher_block_size)
+      if (size < (size_t)GCM_TAG_LENGTH)
       {
-         goto error;
+         pgmoneta_log_error("aes_encryptor_process: GCM tag missing or truncated");
+         return 1;
       }
-      required += (size_t)this->cipher_block_size;
-      if (required > SIZE_MAX - (size_t)GCM_TAG_LENGTH)
+
+      if (chunk_cipher(this->ctx, this->header, this->chunk_index, final, data, size - GCM_TAG_LENGTH, out, data + size - GCM_TAG_LENGTH, 0))
       {
-         goto error;
+         pgmoneta_log_error("aes_encryptor_process: authentication failed for chunk %" PRIu64, this->chunk_index);
+         return 1;
       }
-      required += (size_t)GCM_TAG_LENGTH;
+      *out_size = size - GCM_TAG_LENGTH;
    }
 
-   if (write_header)
+   this->chunk_index++;
+
+   return 0;
+}
+
+static int
+legacy_stream_decrypt(struct aes_encryptor* this, unsigned char* in_buf, size_t in_size, bool last_chunk, size_t* out_size)
+{
+   size_t required = 0;
+   int size = 0;
+   int final_size = 0;
+
+   *out_size = 0;
+
+   required = in_size;
+
+   if (required > SIZE_MAX - 2 * (size_t)this->cipher_block_size - (size_t)GCM_TAG_LENGTH)
    {
-      if (required > SIZE_MAX - (PBKDF2_SALT_LENGTH + AES_GCM_IV_LENGTH))
-      {
-         goto error;
-      }
-      required += PBKDF2_SALT_LENGTH + AES_GCM_IV_LENGTH;
+      return 1;
    }
+   required += 2 * (size_t)this->cipher_block_size + GCM_TAG_LENGTH;
 
    if (ensure_capacity(&this->out_buf, &this->out_capacity, required))
    {
       pgmoneta_log_error("aes_encryptor_process: failed to ensure buffer capacity");
-      goto error;
+      return 1;
    }
 
-   if (write_header)
+   /* Decryption sliding window for GCM tag */
+   size_t total_in = this->tag_buffer_size + in_size;
+   if (total_in <= (size_t)GCM_TAG_LENGTH)
    {
-      memcpy(this->out_buf, this->salt, PBKDF2_SALT_LENGTH);
-      memcpy(this->out_buf + PBKDF2_SALT_LENGTH, this->iv, (size_t)AES_GCM_IV_LENGTH);
-      offset += PBKDF2_SALT_LENGTH + AES_GCM_IV_LENGTH;
+      /* All current input + what we had is still potentially just the tag */
+      memcpy(this->tag_buffer + this->tag_buffer_size, in_buf, in_size);
+      this->tag_buffer_size += in_size;
+      size = 0;
    }
-
-   if (enc)
+   else
    {
-      if (EVP_CipherUpdate(this->ctx, this->out_buf + offset, &size, in_buf, (int)in_size) == 0)
-      {
-         pgmoneta_log_error("EVP_CipherUpdate: failed to process block");
-         goto error;
-      }
+      /* We have more than GCM_TAG_LENGTH bytes. */
+      size_t to_decrypt = total_in - (size_t)GCM_TAG_LENGTH;
+      size_t from_tag_buf = (to_decrypt < this->tag_buffer_size) ? to_decrypt : this->tag_buffer_size;
+      size_t from_in_buf = to_decrypt - from_tag_buf;
+      int out_len;
 
-      if (last_chunk)
+      size = 0;
+      /* Decrypt from tag_buffer */
+      if (from_tag_buf > 0)
       {
-         if (EVP_CipherFinal_ex(this->ctx, this->out_buf + size + offset, &final_size) == 0)
+         if (EVP_CipherUpdate(this->ctx, this->out_buf, &out_len, this->tag_buffer, (int)from_tag_buf) == 0)
          {
-            pgmoneta_log_error("EVP_CipherFinal_ex: failed to process final cipher block");
-            goto error;
+            pgmoneta_log_error("EVP_CipherUpdate: failed to process tag_buffer block");
+            return 1;
          }
-         size += final_size;
+         size += out_len;
+      }
 
-         if (EVP_CIPHER_CTX_ctrl(this->ctx, EVP_CTRL_GCM_GET_TAG, GCM_TAG_LENGTH, tag) == 0)
+      /* Decrypt from in_buf */
+      if (from_in_buf > 0)
+      {
+         if (EVP_CipherUpdate(this->ctx, this->out_buf + size, &out_len, in_buf, (int)from_in_buf) == 0)
          {
-            pgmoneta_log_error("EVP_CIPHER_CTX_ctrl: failed to get GCM tag");
-            goto error;
+            pgmoneta_log_error("EVP_CipherUpdate: failed to process in_buf block");
+            return 1;
          }
-         memcpy(this->out_buf + size + offset, tag, (size_t)GCM_TAG_LENGTH);
-         size += GCM_TAG_LENGTH;
+         size += out_len;
       }
-   }
-   else
-   {
-      /* Decryption sliding window for GCM tag */
-      size_t total_in = this->tag_buffer_size + in_size;
-      if (total_in <= (size_t)GCM_TAG_LENGTH)
+
+      /* Update tag_buffer to hold the last GCM_TAG_LENGTH bytes */
+      if (in_size >= (size_t)GCM_TAG_LENGTH)
       {
-         /* All current input + what we had is still potentially just the tag */
-         memcpy(this->tag_buffer + this->tag_buffer_size, in_buf, in_size);
-         this->tag_buffer_size += in_size;
-         size = 0;
+         /* All new tag_buffer bytes come from the end of in_buf */
+         memcpy(this->tag_buffer, in_buf + (in_size - GCM_TAG_LENGTH), (size_t)GCM_TAG_LENGTH);
       }
       else
       {
-         /* We have more than GCM_TAG_LENGTH bytes. */
-         size_t to_decrypt = total_in - (size_t)GCM_TAG_LENGTH;
-         size_t from_tag_buf = (to_decrypt < this->tag_buffer_size) ? to_decrypt : this->tag_buffer_size;
-         size_t from_in_buf = to_decrypt - from_tag_buf;
-         int out_len;
-
-         size = 0;
-         /* Decrypt from tag_buffer */
-         if (from_tag_buf > 0)
-         {
-            if (EVP_CipherUpdate(this->ctx, this->out_buf + offset, &out_len, this->tag_buffer, (int)from_tag_buf) == 0)
-            {
-               pgmoneta_log_error("EVP_CipherUpdate: failed to process tag_buffer block");
-               goto error;
-            }
-            size += out_len;
-         }
-
-         /* Decrypt from in_buf */
-         if (from_in_buf > 0)
-         {
-            if (EVP_CipherUpdate(this->ctx, this->out_buf + offset + size, &out_len, in_buf, (int)from_in_buf) == 0)
-            {
-               pgmoneta_log_error("EVP_CipherUpdate: failed to process in_buf block");
-               goto error;
-            }
-            size += out_len;
-         }
-
-         /* Update tag_buffer to hold the last GCM_TAG_LENGTH bytes */
-         if (in_size >= (size_t)GCM_TAG_LENGTH)
-         {
-            /* All new tag_buffer bytes come from the end of in_buf */
-            memcpy(this->tag_buffer, (unsigned char*)in_buf + (in_size - GCM_TAG_LENGTH), (size_t)GCM_TAG_LENGTH);
-         }
-         else
-         {
-            /* New tag_buffer is a mix of old tag_buffer and in_buf */
-            size_t keep_old = (size_t)GCM_TAG_LENGTH - in_size;
-            memmove(this->tag_buffer, this->tag_buffer + (this->tag_buffer_size - keep_old), keep_old);
-            memcpy(this->tag_buffer + keep_old, in_buf, in_size);
-         }
-         this->tag_buffer_size = (size_t)GCM_TAG_LENGTH;
+         /* New tag_buffer is a mix of old tag_buffer and in_buf */
+         size_t keep_old = (size_t)GCM_TAG_LENGTH - in_size;
+         memmove(this->tag_buffer, this->tag_buffer + (this->tag_buffer_size - keep_old), keep_old);
+         memcpy(this->tag_buffer + keep_old, in_buf, in_size);
       }
+      this->tag_buffer_size = (size_t)GCM_TAG_LENGTH;
+   }
 
-      if (last_chunk)
+   if (last_chunk)
+   {
+      if (this->tag_buffer_size != (size_t)GCM_TAG_LENGTH)
       {
-         if (this->tag_buffer_size != (size_t)GCM_TAG_LENGTH)
-         {
-            pgmoneta_log_error("aes_encryptor_process: GCM tag missing or truncated");
-            goto error;
-         }
-         if (EVP_CIPHER_CTX_ctrl(this->ctx, EVP_CTRL_GCM_SET_TAG, GCM_TAG_LENGTH, this->tag_buffer) == 0)
-         {
-            pgmoneta_log_error("EVP_CIPHER_CTX_ctrl: failed to set GCM tag");
-            goto error;
-         }
+         pgmoneta_log_error("aes_encryptor_process: GCM tag missing or truncated");
+         return 1;
+      }
+      if (EVP_CIPHER_CTX_ctrl(this->ctx, EVP_CTRL_GCM_SET_TAG, GCM_TAG_LENGTH, this->tag_buffer) == 0)
+      {
+         pgmoneta_log_error("EVP_CIPHER_CTX_ctrl: failed to set GCM tag");
+         return 1;
+      }
 
-         if (EVP_CipherFinal_ex(this->ctx, this->out_buf + size + offset, &final_size) == 0)
-         {
-            pgmoneta_log_error("EVP_CipherFinal_ex: failed to process final cipher block");
-            goto error;
-         }
-         size += final_size;
+      if (EVP_CipherFinal_ex(this->ctx, this->out_buf + size, &final_size) == 0)
+      {
+         pgmoneta_log_error("EVP_CipherFinal_ex: failed to process final cipher block");
+         return 1;
       }
+      size += final_size;
    }
 
-   *out_buf = (void*)this->out_buf;
-   *out_size = (size_t)(size + offset);
-
-   if (master_key != NULL)
-   {
-      pgmoneta_cleanse(master_key, master_key_length);
-      free(master_key);
-   }
+   *out_size = (size_t)size;
 
    return 0;
-
-error:
-
-   if (master_key != NULL)
-   {
-      pgmoneta_cleanse(master_key, master_key_length);
-      free(master_key);
-   }
-   if (out_buf != NULL)
-   {
-      *out_buf = NULL;
-   }
-   if (out_size != NULL)
-   {
-      *out_size = 0;
-   }
-
-   return 1;
 }
 
 static void
@@ -2354,75 +2957,187 @@ pgmoneta_is_encrypted(char* file_path)
    return false;
 }
 
-static int
-dispatch_aes_operation(int server, char* from, char* to, int enc, struct workers* workers)
+bool
+pgmoneta_is_encrypted_chunked(char* file_path)
 {
-   struct aes_operation_task* task = NULL;
+   unsigned char magic[AES_CHUNK_MAGIC_LENGTH];
+   bool chunked = false;
+   int fd = -1;
 
-   task = (struct aes_operation_task*)malloc(sizeof(struct aes_operation_task));
-   if (task == NULL)
+   if (file_path == NULL)
    {
-      return 1;
+      return false;
+   }
+
+   fd = open(file_path, O_RDONLY);
+   if (fd == -1)
+   {
+      return false;
+   }
+
+   if (!read_fully(fd, magic, AES_CHUNK_MAGIC_LENGTH, 0))
+   {
+      chunked = memcmp(magic, AES_CHUNK_MAGIC, AES_CHUNK_MAGIC_LENGTH) == 0;
    }
 
-   memset(task, 0, sizeof(struct aes_operation_task));
+   close(fd);
+
+   return chunked;
+}
+
+int
+pgmoneta_decrypt_file_range(char* from, uint64_t offset, size_t length, unsigned char** buffer, size_t* size)
+{
+   unsigned char header[AES_CHUNK_HEADER_LENGTH];
+   unsigned char salt[PBKDF2_SALT_LENGTH];
+   unsigned char key[EVP_MAX_KEY_LENGTH];
+   const EVP_CIPHER* (*cipher_fp)(void) = NULL;
+   struct main_configuration* config;
+   EVP_CIPHER_CTX* ctx = NULL;
+   unsigned char* inbuf = NULL;
+   unsigned char* outbuf = NULL;
+   unsigned char* result = NULL;
+   uint32_t chunk_size = 0;
+   uint64_t number_of_chunks = 0;
+   uint64_t plaintext_size = 0;
+   uint64_t end = 0;
+   size_t unit = 0;
+   size_t result_size = 0;
+   struct stat st;
+   int fd = -1;
+
+   config = (struct main_configuration*)shmem;
 
-   memcpy(task->from, from, strlen(from));
-   memcpy(task->to, to, strlen(to));
-   task->enc = enc;
-   task->common.workers = workers;
-   task->server = server;
-   task->progress_enabled = (server >= 0 && pgmoneta_is_progress_enabled(server));
+   *buffer = NULL;
+   *size = 0;
 
-   if (workers != NULL)
+   fd = open(from, O_RDONLY);
+   if (fd == -1)
    {
-      if (workers->outcome)
-      {
-         if (pgmoneta_workers_add(workers, do_aes_operation, (struct worker_common*)task))
-         {
-            free(task);
-            return 1;
-         }
-      }
-      else
+      pgmoneta_log_error("open: Could not open %s", from);
+      goto error;
+   }
+
+   if (fstat(fd, &st) != 0 ||
+       read_fully(fd, header, AES_CHUNK_HEADER_LENGTH, 0) ||
+       read_chunk_header(header, &chunk_size, salt))
+   {
+      pgmoneta_log_error("pgmoneta_decrypt_file_range: %s is not a chunked encrypted file", from);
+      goto error;
+   }
+
+   if (get_chunk_layout((uint64_t)st.st_size, chunk_size, &number_of_chunks, &plaintext_size))
+   {
+      pgmoneta_log_error("Invalid encrypted file size for %s", from);
+      goto error;
+   }
+
+   if (offset >= plaintext_size || length == 0)
+   {
+      result = malloc(1);
+      if (result == NULL)
       {
-         do_aes_operation((struct worker_common*)task);
+         goto error;
       }
+      goto done;
    }
-   else
+
+   end = MIN(plaintext_size, offset + MIN((uint64_t)length, plaintext_size - offset));
+
+   cipher_fp = get_cipher(config->common.encryption);
+   if (cipher_fp == NULL)
    {
-      do_aes_operation((struct worker_common*)task);
+      pgmoneta_log_error("pgmoneta_decrypt_file_range: unsupported encryption mode: %d", config->common.encryption);
+      goto error;
    }
 
-   return 0;
-}
+   if (load_file_key(salt, key, config->common.encryption))
+   {
+      goto error;
+   }
 
-static void
-do_aes_operation(struct worker_common* wc)
-{
-   struct aes_operation_task* task = (struct aes_operation_task*)wc;
-   int result;
+   unit = (size_t)chunk_size + GCM_TAG_LENGTH;
+   result = malloc(end - offset);
+   inbuf = malloc(unit);
+   outbuf = malloc(unit);
+   if (result == NULL || inbuf == NULL || outbuf == NULL)
+   {
+      pgmoneta_log_error("pgmoneta_decrypt_file_range: failed to allocate memory");
+      goto error;
+   }
 
-   if (task->enc)
+   if (!(ctx = EVP_CIPHER_CTX_new()) ||
+       EVP_CipherInit_ex(ctx, cipher_fp(), NULL, key, NULL, 0) == 0)
    {
-      result = pgmoneta_encrypt_file(task->from, task->to, NULL);
+      pgmoneta_log_error("EVP_CipherInit_ex: Failed to initialize context");
+      goto error;
    }
-   else
+
+   for (uint64_t i = offset / chunk_size; i <= (end - 1) / chunk_size; i++)
    {
-      result = pgmoneta_decrypt_file(task->from, task->to, NULL);
+      uint64_t chunk_start = i * chunk_size;
+      size_t chunk_length = (size_t)MIN((uint64_t)chunk_size, plaintext_size - chunk_start);
+      uint64_t from_offset = MAX(offset, chunk_start);
+      uint64_t to_offset = MIN(end, chunk_start + chunk_length);
+
+      if (read_fully(fd, inbuf, chunk_length + GCM_TAG_LENGTH, (off_t)(AES_CHUNK_HEADER_LENGTH + i * unit)))
+      {
+         pgmoneta_log_error("read: failed to read chunk %" PRIu64 " from %s", i, from);
+         goto error;
+      }
+
+      if (chunk_cipher(ctx, header, i, i == number_of_chunks - 1, inbuf, chunk_length, outbuf, inbuf + chunk_length, 0))
+      {
+         pgmoneta_log_error("pgmoneta_decrypt_file_range: authentication failed for chunk %" PRIu64 " of %s", i, from);
+         goto error;
+      }
+
+      memcpy(result + result_size, outbuf + (from_offset - chunk_start), (size_t)(to_offset - from_offset));
+      result_size += (size_t)(to_offset - from_offset);
    }
 
-   if (result != 0 && task->common.workers != NULL)
+done:
+
+   *buffer = result;
+   *size = result_size;
+
+   if (ctx != NULL)
+   {
+      EVP_CIPHER_CTX_free(ctx);
+   }
+   if (outbuf != NULL)
    {
-      task->common.workers->outcome = false;
+      pgmoneta_cleanse(outbuf, unit);
+      free(outbuf);
    }
+   free(inbuf);
+   pgmoneta_cleanse(key, sizeof(key));
+   pgmoneta_cleanse(salt, sizeof(salt));
+   close(fd);
+
+   return 0;
+
+error:
 
-   if (task->progress_enabled)
+   if (ctx != NULL)
+   {
+      EVP_CIPHER_CTX_free(ctx);
+   }
+   if (outbuf != NULL)
+   {
+      pgmoneta_cleanse(outbuf, unit);
+      free(outbuf);
+   }
+   free(inbuf);
+   free(result);
+   pgmoneta_cleanse(key, sizeof(key));
+   pgmoneta_cleanse(salt, sizeof(salt));
+   if (fd != -1)
    {
-      pgmoneta_progress_increment(task->server, 1);
+      close(fd);
    }
 
-   free(task);
+   return 1;
 }
 
 /**
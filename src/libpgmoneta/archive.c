@@ -267,7 +267,7 @@ error:
 }
 
 int
-pgmoneta_receive_archive_files(int srv, SSL* ssl, int socket, struct stream_buffer* buffer, char* basedir, struct tablespace* tablespaces)
+pgmoneta_receive_archive_files(int srv, SSL* ssl, int socket, struct stream_buffer* buffer, char* basedir, struct tablespace* tablespaces, struct art* file_digests, struct art* file_trees)
 {
    char directory[MAX_PATH];
    char link_path[MAX_PATH];
@@ -371,6 +371,7 @@ pgmoneta_receive_archive_files(int srv, SSL* ssl, int socket, struct stream_buff
          if (msg->kind == 'd' && msg->length > 0)
          {
             // copy data
+            pgmoneta_throttle(THROTTLE_BACKUP, msg->length);
             if (fwrite(msg->data, msg->length, 1, file) != 1)
             {
                pgmoneta_log_error("could not write to file %s", file_path);
@@ -394,7 +395,7 @@ pgmoneta_receive_archive_files(int srv, SSL* ssl, int socket, struct stream_buff
       fclose(file);
 
       // extract the file
-      if (pgmoneta_extract_backup_tar_file(file_path, directory, file_checksums, file_sizes))
+      if (pgmoneta_extract_backup_tar_file(file_path, directory, file_checksums, file_sizes, file_digests, file_trees))
       {
          goto error;
       }
@@ -469,7 +470,7 @@ error:
 }
 
 int
-pgmoneta_receive_archive_stream(int srv, SSL* ssl, int socket, struct stream_buffer* buffer, char* basedir, struct tablespace* tablespaces)
+pgmoneta_receive_archive_stream(int srv, SSL* ssl, int socket, struct stream_buffer* buffer, char* basedir, struct tablespace* tablespaces, struct art* file_digests, struct art* file_trees)
 {
    struct query_response* response = NULL;
    struct message* msg = (struct message*)malloc(sizeof(struct message));
@@ -568,7 +569,7 @@ pgmoneta_receive_archive_stream(int srv, SSL* ssl, int socket, struct stream_buf
                   fflush(file);
                   fclose(file);
                   file = NULL;
-                  if (pgmoneta_extract_backup_tar_file(file_path, directory, file_checksums, file_sizes))
+                  if (pgmoneta_extract_backup_tar_file(file_path, directory, file_checksums, file_sizes, file_digests, file_trees))
                   {
                      goto error;
                   }
@@ -655,7 +656,7 @@ pgmoneta_receive_archive_stream(int srv, SSL* ssl, int socket, struct stream_buf
                   fflush(file);
                   fclose(file);
                   file = NULL;
-                  if (pgmoneta_extract_backup_tar_file(file_path, directory, file_checksums, file_sizes))
+                  if (pgmoneta_extract_backup_tar_file(file_path, directory, file_checksums, file_sizes, file_digests, file_trees))
                   {
                      goto error;
                   }
@@ -682,6 +683,7 @@ pgmoneta_receive_archive_stream(int srv, SSL* ssl, int socket, struct stream_buf
                   break;
                }
 
+               pgmoneta_throttle(THROTTLE_BACKUP, msg->length - 1);
                if (fwrite(msg->data + 1, msg->length - 1, 1, file) != 1)
                {
                   pgmoneta_log_error("could not write to file %s", file_path);
@@ -795,7 +797,7 @@ error:
 }
 
 int
-pgmoneta_extract_backup_tar_file(char* file_path, char* destination, struct art* file_checksums, struct art* file_sizes)
+pgmoneta_extract_backup_tar_file(char* file_path, char* destination, struct art* file_checksums, struct art* file_sizes, struct art* file_digests, struct art* file_trees)
 {
    char* archive_name = NULL;
    struct archive* a;
@@ -807,7 +809,11 @@ pgmoneta_extract_backup_tar_file(char* file_path, char* destination, struct art*
    struct streamer* strm = NULL;
    struct vfile* reader = NULL;
    struct vfile* writer = NULL;
+   struct vfile* digest = NULL;
    struct hasher* hasher = NULL;
+   struct tree_hasher* tree = NULL;
+   char* tree_hash = NULL;
+   struct stream_digests digests;
    char* entry_path_cpy = NULL;
    char buf[10240];
    size_t size = 0;
@@ -964,8 +970,28 @@ pgmoneta_extract_backup_tar_file(char* file_path, char* destination, struct art*
             pgmoneta_log_error("Failed to create SHA512 hasher at %s", entry_path);
             goto error;
          }
+
+         /* Only files spanning several leaves benefit from a tree digest */
+         if (file_trees != NULL && config->tree_hash && archive_entry_size(entry) > TREE_HASH_LEAF_SIZE)
+         {
+            if (pgmoneta_tree_hasher_create(&tree))
+            {
+               pgmoneta_log_error("Failed to create tree hasher at %s", entry_path);
+               goto error;
+            }
+         }
          pgmoneta_streamer_add_destination(strm, writer);
 
+         if (file_digests != NULL)
+         {
+            if (pgmoneta_stream_digest_create(&digest))
+            {
+               pgmoneta_log_error("Failed to create digest for %s", entry_path);
+               goto error;
+            }
+            pgmoneta_streamer_add_destination(strm, digest);
+         }
+
          do
          {
             asize = archive_read_data(a, buf, sizeof(buf));
@@ -979,6 +1005,11 @@ pgmoneta_extract_backup_tar_file(char* file_path, char* destination, struct art*
                pgmoneta_log_error("Failed to hash data at entry %s", entry_path);
                goto error;
             }
+            if (tree != NULL && pgmoneta_tree_hasher_update(tree, buf, (size_t)asize))
+            {
+               pgmoneta_log_error("Failed to tree hash data at entry %s", entry_path);
+               goto error;
+            }
             if (pgmoneta_streamer_write(strm, buf, (size_t)asize, asize == 0))
             {
                pgmoneta_log_error("Failed to stream data at entry %s", entry_path);
@@ -991,11 +1022,44 @@ pgmoneta_extract_backup_tar_file(char* file_path, char* destination, struct art*
          pgmoneta_art_insert(file_sizes, entry_path_cpy, (uintptr_t)strm->written, ValueUInt64);
          pgmoneta_art_insert(file_checksums, entry_path_cpy, (uintptr_t)hasher->hash, ValueString);
 
-         free(dest);
-         dest = NULL;
+         if (tree != NULL)
+         {
+            if (pgmoneta_tree_hasher_final(tree, &tree_hash))
+            {
+               pgmoneta_log_error("Failed to tree hash data at entry %s", entry_path);
+               goto error;
+            }
+            pgmoneta_art_insert(file_trees, entry_path_cpy, (uintptr_t)tree_hash, ValueString);
+            pgmoneta_tree_hasher_destroy(tree);
+            tree = NULL;
+            free(tree_hash);
+            tree_hash = NULL;
+         }
+
+         if (digest != NULL)
+         {
+            memset(&digests, 0, sizeof(struct stream_digests));
+            if (pgmoneta_stream_digest_finish(digest, &digests))
+            {
+               pgmoneta_log_error("Failed to record digests for %s", dest);
+               goto error;
+            }
+         }
+
+         /* Closes the file, so the digests can record its final state */
          pgmoneta_streamer_reset(strm);
          strm = NULL;
          writer = NULL;
+
+         if (digest != NULL && pgmoneta_stream_digests_add(file_digests, dest, &digests))
+         {
+            pgmoneta_log_error("Failed to record digests for %s", dest);
+            goto error;
+         }
+
+         free(dest);
+         dest = NULL;
+         digest = NULL;
          pgmoneta_hasher_destroy(hasher);
          hasher = NULL;
          free(entry_path_cpy);
@@ -1021,6 +1085,8 @@ pgmoneta_extract_backup_tar_file(char* file_path, char* destination, struct art*
    pgmoneta_streamer_destroy(noop_strm);
    pgmoneta_vfile_destroy(reader);
    pgmoneta_hasher_destroy(hasher);
+   pgmoneta_tree_hasher_destroy(tree);
+   free(tree_hash);
    free(entry_path_cpy);
    return 0;
 
@@ -1035,6 +1101,8 @@ error:
    pgmoneta_streamer_destroy(noop_strm);
    pgmoneta_vfile_destroy(reader);
    pgmoneta_hasher_destroy(hasher);
+   pgmoneta_tree_hasher_destroy(tree);
+   free(tree_hash);
    free(entry_path_cpy);
    return 1;
 }
@@ -31,8 +31,21 @@
 #include <logging.h>
 #include <utils.h>
 
+#include <stddef.h>
+#include <stdlib.h>
 #include <string.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#define ART_ARENA_ALIGNMENT 64
+#define ART_ARENA_BLOCK_MIN 1024
+#define ART_ARENA_BLOCK_MAX 65536
+#define ART_ARENA_CLASSES   12
+
 #define IS_LEAF(x)  (((uintptr_t)(x) & 1))
 #define SET_LEAF(x) ((void*)((uintptr_t)(x) | 1))
 #define GET_LEAF(x) ((struct art_leaf*)((void*)((uintptr_t)(x) & ~1)))
@@ -65,7 +78,7 @@ struct art_node
  */
 struct art_leaf
 {
-   struct value* value;
+   struct value value;
    uint32_t key_len;
    unsigned char key[];
 } __attribute__((aligned(64)));
@@ -116,9 +129,34 @@ struct art_node256
    struct art_node* children[256];
 } __attribute__((aligned(64)));
 
+/**
+ * A block of the arena, the chunks follow the header
+ */
+struct art_arena_block
+{
+   struct art_arena_block* next; /**< The next (older) block */
+} __attribute__((aligned(64)));
+
+/**
+ * The per tree allocator for nodes and leaves.
+ * Chunks are carved in multiples of 64 bytes out of blocks that double in size,
+ * freed chunks are kept on a free list per size class for reuse,
+ * and all blocks are released at once when the tree is destroyed.
+ * Chunks larger than the biggest size class, like node256, are allocated on their own.
+ * The arena itself lives in the first block, so an empty tree costs nothing.
+ */
+struct art_arena
+{
+   struct art_arena_block* blocks;      /**< The blocks, newest first */
+   char* cursor;                        /**< The next free byte of the newest block */
+   char* end;                           /**< The end of the newest block */
+   size_t block_size;                   /**< The size of the next block */
+   void* free_lists[ART_ARENA_CLASSES]; /**< The freed chunks per size class */
+};
+
 struct to_string_param
 {
-   char* str;
+   struct string_builder* str;
    int indent;
    uint64_t cnt;
    char* tag;
@@ -128,31 +166,49 @@ struct to_string_param
 static struct art_node**
 node_get_child(struct art_node* node, unsigned char ch);
 
+static void*
+arena_alloc(struct art* t, size_t size);
+
+static void
+arena_free(struct art* t, void* chunk, size_t size);
+
+static void
+arena_destroy(struct art* t);
+
+static size_t
+node_size(enum art_node_type type);
+
+static size_t
+leaf_size(uint32_t key_len);
+
+static struct art_node*
+art_bulk_build(struct art* t, char** keys, uintptr_t* values, enum value_type type, uint64_t start, uint64_t end, uint32_t depth);
+
 // Get the left most leaf of a child
 static struct art_leaf*
 node_get_minimum(struct art_node* node);
 
 static void
-create_art_leaf(struct art_leaf** leaf, unsigned char* key, uint32_t key_len, uintptr_t value, enum value_type type, struct value_config* config);
+create_art_leaf(struct art* t, struct art_leaf** leaf, unsigned char* key, uint32_t key_len, uintptr_t value, enum value_type type, struct value_config* config);
 
 static void
-create_art_node(struct art_node** node, enum art_node_type type);
+create_art_node(struct art* t, struct art_node** node, enum art_node_type type);
 
 static void
-create_art_node4(struct art_node4** node);
+create_art_node4(struct art* t, struct art_node4** node);
 
 static void
-create_art_node16(struct art_node16** node);
+create_art_node16(struct art* t, struct art_node16** node);
 
 static void
-create_art_node48(struct art_node48** node);
+create_art_node48(struct art* t, struct art_node48** node);
 
 static void
-create_art_node256(struct art_node256** node);
+create_art_node256(struct art* t, struct art_node256** node);
 
 // Destroy ART nodes/leaves recursively
 static void
-destroy_art_node(struct art_node* node);
+destroy_art_node(struct art* t, struct art_node* node);
 
 static int
 art_iterate(struct art* t, art_callback cb, void* data);
@@ -203,9 +259,19 @@ leaf_match(struct art_leaf* leaf, unsigned char* key, uint32_t key_len);
 static int
 find_index(unsigned char ch, unsigned char* keys, int length);
 
+/**
+ * Same as find_index for node16, comparing all 16 keys at once with SSE2 or NEON when available
+ * @param ch
+ * @param node
+ * @return The index
+ */
+static int
+node16_find_index(unsigned char ch, struct art_node16* node);
+
 /**
  * Insert a value into a node recursively, adopting lazy expansion and path compression --
  * Expand the leaf, or split inner node should keys diverge within node's prefix range
+ * @param t The tree
  * @param node The node
  * @param node_ref The reference to node pointer
  * @param depth The depth into the node, which is the same as the total prefix length
@@ -215,13 +281,13 @@ find_index(unsigned char ch, unsigned char* keys, int length);
  * @param type The value type
  * @param config The config
  * @param new If the key value is newly inserted (not replaced)
- * @return Old value if the key exists, otherwise NULL
  */
-static struct value*
-art_node_insert(struct art_node* node, struct art_node** node_ref, uint32_t depth, unsigned char* key, uint32_t key_len, uintptr_t value, enum value_type type, struct value_config* config, bool* new);
+static void
+art_node_insert(struct art* t, struct art_node* node, struct art_node** node_ref, uint32_t depth, unsigned char* key, uint32_t key_len, uintptr_t value, enum value_type type, struct value_config* config, bool* new);
 
 /**
  * Delete a value from a node recursively.
+ * @param t The tree
  * @param node The node
  * @param node_ref The reference to node pointer
  * @param depth The depth into the node
@@ -230,13 +296,13 @@ art_node_insert(struct art_node* node, struct art_node** node_ref, uint32_t dept
  * @return Deleted value if the key exists, otherwise NULL
  */
 static struct art_leaf*
-art_node_delete(struct art_node* node, struct art_node** node_ref, uint32_t depth, unsigned char* key, uint32_t key_len);
+art_node_delete(struct art* t, struct art_node* node, struct art_node** node_ref, uint32_t depth, unsigned char* key, uint32_t key_len);
 
 static int
 art_node_iterate(struct art_node* node, art_callback cb, void* data);
 
 static void
-node_add_child(struct art_node* node, struct art_node** node_ref, unsigned char ch, void* child);
+node_add_child(struct art* t, struct art_node* node, struct art_node** node_ref, unsigned char ch, void* child);
 
 /**
  * Add a child to the node. The function assumes node is not NULL,
@@ -249,13 +315,13 @@ node_add_child(struct art_node* node, struct art_node** node_ref, unsigned char
  * @param child The child
  */
 static void
-node4_add_child(struct art_node4* node, struct art_node** node_ref, unsigned char ch, void* child);
+node4_add_child(struct art* t, struct art_node4* node, struct art_node** node_ref, unsigned char ch, void* child);
 
 static void
-node16_add_child(struct art_node16* node, struct art_node** node_ref, unsigned char ch, void* child);
+node16_add_child(struct art* t, struct art_node16* node, struct art_node** node_ref, unsigned char ch, void* child);
 
 static void
-node48_add_child(struct art_node48* node, struct art_node** node_ref, unsigned char ch, void* child);
+node48_add_child(struct art* t, struct art_node48* node, struct art_node** node_ref, unsigned char ch, void* child);
 
 static void
 node256_add_child(struct art_node256* node, unsigned char ch, void* child);
@@ -264,19 +330,19 @@ node256_add_child(struct art_node256* node, unsigned char ch, void* child);
 // They also do not free the leaf node for bookkeeping purpose. The key insight is that due to path compression,
 // no node will have only one child, if node has only one child after deletion, it merges with this child
 static void
-node_remove_child(struct art_node* node, struct art_node** node_ref, unsigned char ch);
+node_remove_child(struct art* t, struct art_node* node, struct art_node** node_ref, unsigned char ch);
 
 static void
-node4_remove_child(struct art_node4* node, struct art_node** node_ref, unsigned char ch);
+node4_remove_child(struct art* t, struct art_node4* node, struct art_node** node_ref, unsigned char ch);
 
 static void
-node16_remove_child(struct art_node16* node, struct art_node** node_ref, unsigned char ch);
+node16_remove_child(struct art* t, struct art_node16* node, struct art_node** node_ref, unsigned char ch);
 
 static void
-node48_remove_child(struct art_node48* node, struct art_node** node_ref, unsigned char ch);
+node48_remove_child(struct art* t, struct art_node48* node, struct art_node** node_ref, unsigned char ch);
 
 static void
-node256_remove_child(struct art_node256* node, struct art_node** node_ref, unsigned char ch);
+node256_remove_child(struct art* t, struct art_node256* node, struct art_node** node_ref, unsigned char ch);
 
 static void
 copy_header(struct art_node* dest, struct art_node* src);
@@ -312,6 +378,7 @@ pgmoneta_art_create(struct art** tree)
    t = malloc(sizeof(struct art));
    t->size = 0;
    t->root = NULL;
+   t->arena = NULL;
    *tree = t;
    return 0;
 }
@@ -323,7 +390,8 @@ pgmoneta_art_destroy(struct art* tree)
    {
       return 0;
    }
-   destroy_art_node(tree->root);
+   destroy_art_node(tree, tree->root);
+   arena_destroy(tree);
    free(tree);
    return 0;
 }
@@ -442,7 +510,7 @@ pgmoneta_art_prefix_search(struct art* t, char* prefix, char*** matches, int max
          struct art_leaf* leaf = GET_LEAF(node);
          if (leaf->key_len >= key_len && strncmp((char*)leaf->key, prefix, key_len) == 0)
          {
-            prefix_search_cb(&state, (char*)leaf->key, leaf->value);
+            prefix_search_cb(&state, (char*)leaf->key, &leaf->value);
          }
          return state.current_count;
       }
@@ -475,7 +543,6 @@ pgmoneta_art_prefix_search(struct art* t, char* prefix, char*** matches, int max
 int
 pgmoneta_art_insert(struct art* t, char* key, uintptr_t value, enum value_type type)
 {
-   struct value* old_val = NULL;
    bool new = false;
 
    if (t == NULL || key == NULL || type == ValueNone)
@@ -483,8 +550,7 @@ pgmoneta_art_insert(struct art* t, char* key, uintptr_t value, enum value_type t
       // c'mon, at least create a tree first...
       goto error;
    }
-   old_val = art_node_insert(t->root, &t->root, 0, (unsigned char*)key, strlen(key) + 1, value, type, NULL, &new);
-   pgmoneta_value_destroy(old_val);
+   art_node_insert(t, t->root, &t->root, 0, (unsigned char*)key, strlen(key) + 1, value, type, NULL, &new);
    if (new)
    {
       t->size++;
@@ -497,14 +563,12 @@ error:
 int
 pgmoneta_art_insert_with_config(struct art* t, char* key, uintptr_t value, struct value_config* config)
 {
-   struct value* old_val = NULL;
    bool new = false;
    if (t == NULL || key == NULL)
    {
       goto error;
    }
-   old_val = art_node_insert(t->root, &t->root, 0, (unsigned char*)key, strlen(key) + 1, value, ValueRef, config, &new);
-   pgmoneta_value_destroy(old_val);
+   art_node_insert(t, t->root, &t->root, 0, (unsigned char*)key, strlen(key) + 1, value, ValueRef, config, &new);
    if (new)
    {
       t->size++;
@@ -514,6 +578,53 @@ error:
    return 1;
 }
 
+int
+pgmoneta_art_bulk_load(struct art* t, char** keys, uintptr_t* values, enum value_type type, uint64_t count)
+{
+   bool sorted = true;
+
+   if (t == NULL || keys == NULL || values == NULL || type == ValueNone)
+   {
+      goto error;
+   }
+
+   for (uint64_t i = 0; i < count; i++)
+   {
+      if (keys[i] == NULL)
+      {
+         goto error;
+      }
+      if (i > 0 && strcmp(keys[i - 1], keys[i]) >= 0)
+      {
+         sorted = false;
+      }
+   }
+
+   if (count == 0)
+   {
+      return 0;
+   }
+
+   if (t->root != NULL || !sorted)
+   {
+      for (uint64_t i = 0; i < count; i++)
+      {
+         if (pgmoneta_art_insert(t, keys[i], values[i], type))
+         {
+            goto error;
+         }
+      }
+      return 0;
+   }
+
+   t->root = art_bulk_build(t, keys, values, type, 0, count, 0);
+   t->size = count;
+
+   return 0;
+error:
+   return 1;
+}
+
 int
 pgmoneta_art_delete(struct art* t, char* key)
 {
@@ -522,14 +633,14 @@ pgmoneta_art_delete(struct art* t, char* key)
    {
       return 1;
    }
-   l = art_node_delete(t->root, &t->root, 0, (unsigned char*)key, strlen(key) + 1);
+   l = art_node_delete(t, t->root, &t->root, 0, (unsigned char*)key, strlen(key) + 1);
    if (l != NULL)
    {
       t->size--;
-      pgmoneta_value_destroy(l->value);
+      pgmoneta_value_release(&l->value);
+      arena_free(t, l, leaf_size(l->key_len));
    }
 
-   free(l);
    return 0;
 }
 
@@ -540,7 +651,8 @@ pgmoneta_art_clear(struct art* t)
    {
       return 0;
    }
-   destroy_art_node(t->root);
+   destroy_art_node(t, t->root);
+   arena_destroy(t);
    t->root = NULL;
    t->size = 0;
    return 0;
@@ -574,20 +686,162 @@ min(uint32_t a, uint32_t b)
    return a;
 }
 
+static void*
+arena_alloc(struct art* t, size_t size)
+{
+   struct art_arena* a = NULL;
+   struct art_arena_block* b = NULL;
+   size_t rest = 0;
+   size_t cls = 0;
+   void* chunk = NULL;
+
+   size = (size + ART_ARENA_ALIGNMENT - 1) & ~((size_t)ART_ARENA_ALIGNMENT - 1);
+   cls = size / ART_ARENA_ALIGNMENT;
+
+   if (cls > ART_ARENA_CLASSES)
+   {
+      chunk = aligned_alloc(ART_ARENA_ALIGNMENT, size);
+      goto done;
+   }
+
+   if (t->arena == NULL)
+   {
+      b = aligned_alloc(ART_ARENA_ALIGNMENT, ART_ARENA_BLOCK_MIN);
+      if (b == NULL)
+      {
+         return NULL;
+      }
+      b->next = NULL;
+
+      a = (struct art_arena*)(b + 1);
+      memset(a, 0, sizeof(struct art_arena));
+      a->blocks = b;
+      a->cursor = (char*)a + ((sizeof(struct art_arena) + ART_ARENA_ALIGNMENT - 1) & ~((size_t)ART_ARENA_ALIGNMENT - 1));
+      a->end = (char*)b + ART_ARENA_BLOCK_MIN;
+      a->block_size = ART_ARENA_BLOCK_MIN * 2;
+      t->arena = a;
+   }
+
+   a = t->arena;
+
+   if (a->free_lists[cls - 1] != NULL)
+   {
+      chunk = a->free_lists[cls - 1];
+      a->free_lists[cls - 1] = *(void**)chunk;
+      goto done;
+   }
+
+   if (a->cursor + size > a->end)
+   {
+      b = aligned_alloc(ART_ARENA_ALIGNMENT, a->block_size);
+      if (b == NULL)
+      {
+         return NULL;
+      }
+
+      // keep the tail of the current block for a smaller chunk
+      rest = (size_t)(a->end - a->cursor);
+      if (rest >= ART_ARENA_ALIGNMENT)
+      {
+         *(void**)a->cursor = a->free_lists[rest / ART_ARENA_ALIGNMENT - 1];
+         a->free_lists[rest / ART_ARENA_ALIGNMENT - 1] = a->cursor;
+      }
+
+      b->next = a->blocks;
+      a->blocks = b;
+      a->cursor = (char*)(b + 1);
+      a->end = (char*)b + a->block_size;
+      if (a->block_size < ART_ARENA_BLOCK_MAX)
+      {
+         a->block_size *= 2;
+      }
+   }
+
+   chunk = a->cursor;
+   a->cursor += size;
+
+done:
+   if (chunk != NULL)
+   {
+      memset(chunk, 0, size);
+   }
+   return chunk;
+}
+
 static void
-create_art_leaf(struct art_leaf** leaf, unsigned char* key, uint32_t key_len, uintptr_t value, enum value_type type, struct value_config* config)
+arena_free(struct art* t, void* chunk, size_t size)
 {
-   struct art_leaf* l = NULL;
-   l = malloc(sizeof(struct art_leaf) + key_len);
-   memset(l, 0, sizeof(struct art_leaf) + key_len);
-   if (config != NULL)
+   size_t cls = 0;
+
+   if (chunk == NULL)
    {
-      pgmoneta_value_create_with_config(value, config, &l->value);
+      return;
    }
-   else
+
+   size = (size + ART_ARENA_ALIGNMENT - 1) & ~((size_t)ART_ARENA_ALIGNMENT - 1);
+   cls = size / ART_ARENA_ALIGNMENT;
+
+   if (cls > ART_ARENA_CLASSES || t->arena == NULL)
    {
-      pgmoneta_value_create(type, value, &l->value);
+      free(chunk);
+      return;
+   }
+
+   *(void**)chunk = t->arena->free_lists[cls - 1];
+   t->arena->free_lists[cls - 1] = chunk;
+}
+
+static void
+arena_destroy(struct art* t)
+{
+   struct art_arena_block* b = NULL;
+   struct art_arena_block* next = NULL;
+
+   if (t->arena == NULL)
+   {
+      return;
+   }
+
+   // the arena lives in the oldest block, so it is freed last
+   b = t->arena->blocks;
+   t->arena = NULL;
+   while (b != NULL)
+   {
+      next = b->next;
+      free(b);
+      b = next;
    }
+}
+
+static size_t
+node_size(enum art_node_type type)
+{
+   switch (type)
+   {
+      case Node4:
+         return sizeof(struct art_node4);
+      case Node16:
+         return sizeof(struct art_node16);
+      case Node48:
+         return sizeof(struct art_node48);
+      case Node256:
+         return sizeof(struct art_node256);
+   }
+   return 0;
+}
+
+static size_t
+leaf_size(uint32_t key_len)
+{
+   return offsetof(struct art_leaf, key) + key_len;
+}
+
+static void
+create_art_leaf(struct art* t, struct art_leaf** leaf, unsigned char* key, uint32_t key_len, uintptr_t value, enum value_type type, struct value_config* config)
+{
+   struct art_leaf* l = NULL;
+   l = arena_alloc(t, leaf_size(key_len));
+   pgmoneta_value_init(config != NULL ? ValueRef : type, value, config, &l->value);
 
    l->key_len = key_len;
    memcpy(l->key, key, key_len);
@@ -595,39 +849,35 @@ create_art_leaf(struct art_leaf** leaf, unsigned char* key, uint32_t key_len, ui
 }
 
 static void
-create_art_node(struct art_node** node, enum art_node_type type)
+create_art_node(struct art* t, struct art_node** node, enum art_node_type type)
 {
    struct art_node* n = NULL;
    switch (type)
    {
       case Node4:
       {
-         struct art_node4* n4 = malloc(sizeof(struct art_node4));
-         memset(n4, 0, sizeof(struct art_node4));
+         struct art_node4* n4 = arena_alloc(t, sizeof(struct art_node4));
          n4->node.type = Node4;
          n = (struct art_node*)n4;
          break;
       }
       case Node16:
       {
-         struct art_node16* n16 = malloc(sizeof(struct art_node16));
-         memset(n16, 0, sizeof(struct art_node16));
+         struct art_node16* n16 = arena_alloc(t, sizeof(struct art_node16));
          n16->node.type = Node16;
          n = (struct art_node*)n16;
          break;
       }
       case Node48:
       {
-         struct art_node48* n48 = malloc(sizeof(struct art_node48));
-         memset(n48, 0, sizeof(struct art_node48));
+         struct art_node48* n48 = arena_alloc(t, sizeof(struct art_node48));
          n48->node.type = Node48;
          n = (struct art_node*)n48;
          break;
       }
       case Node256:
       {
-         struct art_node256* n256 = malloc(sizeof(struct art_node256));
-         memset(n256, 0, sizeof(struct art_node256));
+         struct art_node256* n256 = arena_alloc(t, sizeof(struct art_node256));
          n256->node.type = Node256;
          n = (struct art_node*)n256;
          break;
@@ -637,39 +887,39 @@ create_art_node(struct art_node** node, enum art_node_type type)
 }
 
 static void
-create_art_node4(struct art_node4** node)
+create_art_node4(struct art* t, struct art_node4** node)
 {
    struct art_node* n = NULL;
-   create_art_node(&n, Node4);
+   create_art_node(t, &n, Node4);
    *node = (struct art_node4*)n;
 }
 
 static void
-create_art_node16(struct art_node16** node)
+create_art_node16(struct art* t, struct art_node16** node)
 {
    struct art_node* n = NULL;
-   create_art_node(&n, Node16);
+   create_art_node(t, &n, Node16);
    *node = (struct art_node16*)n;
 }
 
 static void
-create_art_node48(struct art_node48** node)
+create_art_node48(struct art* t, struct art_node48** node)
 {
    struct art_node* n = NULL;
-   create_art_node(&n, Node48);
+   create_art_node(t, &n, Node48);
    *node = (struct art_node48*)n;
 }
 
 static void
-create_art_node256(struct art_node256** node)
+create_art_node256(struct art* t, struct art_node256** node)
 {
    struct art_node* n = NULL;
-   create_art_node(&n, Node256);
+   create_art_node(t, &n, Node256);
    *node = (struct art_node256*)n;
 }
 
 static void
-destroy_art_node(struct art_node* node)
+destroy_art_node(struct art* t, struct art_node* node)
 {
    if (node == NULL)
    {
@@ -677,8 +927,8 @@ destroy_art_node(struct art_node* node)
    }
    if (IS_LEAF(node))
    {
-      pgmoneta_value_destroy(GET_LEAF(node)->value);
-      free(GET_LEAF(node));
+      pgmoneta_value_release(&GET_LEAF(node)->value);
+      arena_free(t, GET_LEAF(node), leaf_size(GET_LEAF(node)->key_len));
       return;
    }
    switch (node->type)
@@ -688,7 +938,7 @@ destroy_art_node(struct art_node* node)
          struct art_node4* n = (struct art_node4*)node;
          for (int i = 0; i < node->num_children; i++)
          {
-            destroy_art_node(n->children[i]);
+            destroy_art_node(t, n->children[i]);
          }
          break;
       }
@@ -697,7 +947,7 @@ destroy_art_node(struct art_node* node)
          struct art_node16* n = (struct art_node16*)node;
          for (int i = 0; i < node->num_children; i++)
          {
-            destroy_art_node(n->children[i]);
+            destroy_art_node(t, n->children[i]);
          }
          break;
       }
@@ -711,7 +961,7 @@ destroy_art_node(struct art_node* node)
             {
                continue;
             }
-            destroy_art_node(n->children[idx - 1]);
+            destroy_art_node(t, n->children[idx - 1]);
          }
          break;
       }
@@ -725,12 +975,12 @@ destroy_art_node(struct art_node* node)
             {
                continue;
             }
-            destroy_art_node(n->children[i]);
+            destroy_art_node(t, n->children[i]);
          }
          break;
       }
    }
-   free(node);
+   arena_free(t, node, node_size(node->type));
 }
 
 static struct art_node**
@@ -751,7 +1001,7 @@ node_get_child(struct art_node* node, unsigned char ch)
       case Node16:
       {
          struct art_node16* n = (struct art_node16*)node;
-         int idx = find_index(ch, n->keys, n->node.num_children);
+         int idx = node16_find_index(ch, n);
          if (idx == -1 || n->keys[idx] != ch)
          {
             goto error;
@@ -777,8 +1027,8 @@ error:
    return NULL;
 }
 
-static struct value*
-art_node_insert(struct art_node* node, struct art_node** node_ref, uint32_t depth, unsigned char* key, uint32_t key_len, uintptr_t value, enum value_type type, struct value_config* config, bool* new)
+static void
+art_node_insert(struct art* t, struct art_node* node, struct art_node** node_ref, uint32_t depth, unsigned char* key, uint32_t key_len, uintptr_t value, enum value_type type, struct value_config* config, bool* new)
 {
    struct art_leaf* leaf = NULL;
    struct art_leaf* min_leaf = NULL;
@@ -787,33 +1037,28 @@ art_node_insert(struct art_node* node, struct art_node** node_ref, uint32_t dept
    struct art_node* new_node = NULL;
    struct art_node** next = NULL;
    unsigned char* leaf_key = NULL;
-   void* old_val = NULL;
+   struct value val;
    if (node == NULL)
    {
       // Lazy expansion, skip creating an inner node since it currently will have only this one leaf.
       // We will compare keys when reach leaf anyway, the path doesn't need to 100% match the key along the way
-      create_art_leaf(&leaf, key, key_len, value, type, config);
+      create_art_leaf(t, &leaf, key, key_len, value, type, config);
       *node_ref = SET_LEAF(leaf);
       *new = true;
-      return NULL;
+      return;
    }
    // base case, reaching leaf, either replace or expand
    if (IS_LEAF(node))
    {
       // Lazy expansion, expand the leaf node to an inner node with 2 leaves
-      // If the key already exists, replace with new value and return old value
+      // If the key already exists, replace with new value and destroy the old value.
+      // The new value is created first since its data may be copied from the old one
       if (leaf_match(GET_LEAF(node), key, key_len))
       {
-         old_val = GET_LEAF(node)->value;
-         if (config != NULL)
-         {
-            pgmoneta_value_create_with_config(value, config, &(GET_LEAF(node)->value));
-         }
-         else
-         {
-            pgmoneta_value_create(type, value, &(GET_LEAF(node)->value));
-         }
-         return old_val;
+         pgmoneta_value_init(config != NULL ? ValueRef : type, value, config, &val);
+         pgmoneta_value_release(&GET_LEAF(node)->value);
+         GET_LEAF(node)->value = val;
+         return;
       }
       // If the key does not match with existing key, old key and new key diverged some point after depth
       // Even if we merely store a partial prefix for each node, it couldn't have diverged before depth.
@@ -821,8 +1066,8 @@ art_node_insert(struct art_node* node, struct art_node** node_ref, uint32_t dept
       // we compare with the existing key in the left most leaf and find an exact diverging point to split the node (see details below).
       // This way we inductively guarantee that all children to a parent share the same prefix even if it's only partially stored
       leaf_key = GET_LEAF(node)->key;
-      create_art_node(&new_node, Node4);
-      create_art_leaf(&leaf, key, key_len, value, type, config);
+      create_art_node(t, &new_node, Node4);
+      create_art_leaf(t, &leaf, key, key_len, value, type, config);
       // Get the diverging index after point of depth
       for (idx = depth; idx < min(key_len, GET_LEAF(node)->key_len); idx++)
       {
@@ -837,12 +1082,12 @@ art_node_insert(struct art_node* node, struct art_node** node_ref, uint32_t dept
       }
       new_node->prefix_len = idx - depth;
       depth += new_node->prefix_len;
-      node_add_child(new_node, &new_node, key[depth], SET_LEAF(leaf));
-      node_add_child(new_node, &new_node, leaf_key[depth], (void*)node);
+      node_add_child(t, new_node, &new_node, key[depth], SET_LEAF(leaf));
+      node_add_child(t, new_node, &new_node, leaf_key[depth], (void*)node);
       // replace with new node
       *node_ref = new_node;
       *new = true;
-      return NULL;
+      return;
    }
 
    // There are several cases,
@@ -863,8 +1108,8 @@ art_node_insert(struct art_node* node, struct art_node** node_ref, uint32_t dept
    if (diff_len < node->prefix_len)
    {
       // case 2, split the node
-      create_art_node(&new_node, Node4);
-      create_art_leaf(&leaf, key, key_len, value, type, config);
+      create_art_node(t, &new_node, Node4);
+      create_art_leaf(t, &leaf, key, key_len, value, type, config);
       new_node->prefix_len = diff_len;
       memcpy(new_node->prefix, node->prefix, min(MAX_PREFIX_LEN, diff_len));
       // We need to know if new bytes that were once outside the partial prefix range will now come into the range
@@ -873,8 +1118,8 @@ art_node_insert(struct art_node* node, struct art_node** node_ref, uint32_t dept
       if (node->prefix_len <= MAX_PREFIX_LEN)
       {
          node->prefix_len = node->prefix_len - (diff_len + 1);
-         node_add_child(new_node, &new_node, key[depth + diff_len], SET_LEAF(leaf));
-         node_add_child(new_node, &new_node, node->prefix[diff_len], node);
+         node_add_child(t, new_node, &new_node, key[depth + diff_len], SET_LEAF(leaf));
+         node_add_child(t, new_node, &new_node, node->prefix[diff_len], node);
          // Update node's prefix info since we move it downwards
          // The first diverging character serves as the key byte in keys array,
          // so we don't duplicate store it in the prefix.
@@ -888,15 +1133,15 @@ art_node_insert(struct art_node* node, struct art_node** node_ref, uint32_t dept
       {
          node->prefix_len = node->prefix_len - (diff_len + 1);
          min_leaf = node_get_minimum(node);
-         node_add_child(new_node, &new_node, key[depth + diff_len], SET_LEAF(leaf));
-         node_add_child(new_node, &new_node, min_leaf->key[depth + diff_len], node);
+         node_add_child(t, new_node, &new_node, key[depth + diff_len], SET_LEAF(leaf));
+         node_add_child(t, new_node, &new_node, min_leaf->key[depth + diff_len], node);
          // node is moved downwards
          memmove(node->prefix, min_leaf->key + depth + diff_len + 1, min(MAX_PREFIX_LEN, node->prefix_len));
       }
       // replace
       *node_ref = new_node;
       *new = true;
-      return NULL;
+      return;
    }
    else
    {
@@ -910,21 +1155,94 @@ art_node_insert(struct art_node* node, struct art_node** node_ref, uint32_t dept
          {
             node->num_children++;
          }
-         return art_node_insert(*next, next, depth + 1, key, key_len, value, type, config, new);
+         art_node_insert(t, *next, next, depth + 1, key, key_len, value, type, config, new);
+         return;
       }
       else
       {
          // add a child to current node since the spot is available
-         create_art_leaf(&leaf, key, key_len, value, type, config);
-         node_add_child(node, node_ref, key[depth], SET_LEAF(leaf));
+         create_art_leaf(t, &leaf, key, key_len, value, type, config);
+         node_add_child(t, node, node_ref, key[depth], SET_LEAF(leaf));
          *new = true;
-         return NULL;
+         return;
       }
    }
 }
 
+static struct art_node*
+art_bulk_build(struct art* t, char** keys, uintptr_t* values, enum value_type type, uint64_t start, uint64_t end, uint32_t depth)
+{
+   struct art_leaf* leaf = NULL;
+   struct art_node* node = NULL;
+   unsigned char* first = NULL;
+   unsigned char* last = NULL;
+   uint32_t prefix_len = 0;
+   uint32_t children = 0;
+   unsigned char ch = 0;
+   uint64_t next = 0;
+
+   if (end - start == 1)
+   {
+      create_art_leaf(t, &leaf, (unsigned char*)keys[start], strlen(keys[start]) + 1, values[start], type, NULL);
+      return SET_LEAF(leaf);
+   }
+
+   // The keys are sorted, so the prefix the first and the last key share is shared by all of them.
+   // They always diverge before the end since no key is a prefix of another including the terminator
+   first = (unsigned char*)keys[start];
+   last = (unsigned char*)keys[end - 1];
+   while (first[depth + prefix_len] == last[depth + prefix_len])
+   {
+      prefix_len++;
+   }
+
+   for (uint64_t i = start; i < end; i = next)
+   {
+      ch = (unsigned char)keys[i][depth + prefix_len];
+      next = i + 1;
+      while (next < end && (unsigned char)keys[next][depth + prefix_len] == ch)
+      {
+         next++;
+      }
+      children++;
+   }
+
+   // Size the node for its children up front, so adding them never grows it
+   if (children <= 4)
+   {
+      create_art_node(t, &node, Node4);
+   }
+   else if (children <= 16)
+   {
+      create_art_node(t, &node, Node16);
+   }
+   else if (children <= 48)
+   {
+      create_art_node(t, &node, Node48);
+   }
+   else
+   {
+      create_art_node(t, &node, Node256);
+   }
+   node->prefix_len = prefix_len;
+   memcpy(node->prefix, first + depth, min(MAX_PREFIX_LEN, prefix_len));
+
+   for (uint64_t i = start; i < end; i = next)
+   {
+      ch = (unsigned char)keys[i][depth + prefix_len];
+      next = i + 1;
+      while (next < end && (unsigned char)keys[next][depth + prefix_len] == ch)
+      {
+         next++;
+      }
+      node_add_child(t, node, &node, ch, art_bulk_build(t, keys, values, type, i, next, depth + prefix_len + 1));
+   }
+
+   return node;
+}
+
 static struct art_leaf*
-art_node_delete(struct art_node* node, struct art_node** node_ref, uint32_t depth, unsigned char* key, uint32_t key_len)
+art_node_delete(struct art* t, struct art_node* node, struct art_node** node_ref, uint32_t depth, unsigned char* key, uint32_t key_len)
 {
    struct art_leaf* l = NULL;
    struct art_node** child = NULL;
@@ -967,7 +1285,7 @@ art_node_delete(struct art_node* node, struct art_node** node_ref, uint32_t dept
          if (leaf_match(GET_LEAF(*child), key, key_len))
          {
             l = GET_LEAF(*child);
-            node_remove_child(node, node_ref, key[depth]);
+            node_remove_child(t, node, node_ref, key[depth]);
             return l;
          }
          else
@@ -977,7 +1295,7 @@ art_node_delete(struct art_node* node, struct art_node** node_ref, uint32_t dept
       }
       else
       {
-         return art_node_delete(*child, child, depth + 1, key, key_len);
+         return art_node_delete(t, *child, child, depth + 1, key, key_len);
       }
    }
 }
@@ -996,7 +1314,7 @@ art_node_iterate(struct art_node* node, art_callback cb, void* data)
    if (IS_LEAF(node))
    {
       l = GET_LEAF(node);
-      return cb(data, (char*)l->key, l->value);
+      return cb(data, (char*)l->key, &l->value);
    }
    switch (node->type)
    {
@@ -1070,18 +1388,18 @@ art_node_iterate(struct art_node* node, art_callback cb, void* data)
 }
 
 static void
-node_add_child(struct art_node* node, struct art_node** node_ref, unsigned char ch, void* child)
+node_add_child(struct art* t, struct art_node* node, struct art_node** node_ref, unsigned char ch, void* child)
 {
    switch (node->type)
    {
       case Node4:
-         node4_add_child((struct art_node4*)node, node_ref, ch, child);
+         node4_add_child(t, (struct art_node4*)node, node_ref, ch, child);
          break;
       case Node16:
-         node16_add_child((struct art_node16*)node, node_ref, ch, child);
+         node16_add_child(t, (struct art_node16*)node, node_ref, ch, child);
          break;
       case Node48:
-         node48_add_child((struct art_node48*)node, node_ref, ch, child);
+         node48_add_child(t, (struct art_node48*)node, node_ref, ch, child);
          break;
       case Node256:
          node256_add_child((struct art_node256*)node, ch, child);
@@ -1090,7 +1408,7 @@ node_add_child(struct art_node* node, struct art_node** node_ref, unsigned char
 }
 
 static void
-node4_add_child(struct art_node4* node, struct art_node** node_ref, unsigned char ch, void* child)
+node4_add_child(struct art* t, struct art_node4* node, struct art_node** node_ref, unsigned char ch, void* child)
 {
    if (node->node.num_children < 4)
    {
@@ -1107,24 +1425,24 @@ node4_add_child(struct art_node4* node, struct art_node** node_ref, unsigned cha
    {
       // expand
       struct art_node16* new_node = NULL;
-      create_art_node16(&new_node);
+      create_art_node16(t, &new_node);
       copy_header((struct art_node*)new_node, (struct art_node*)node);
       memcpy(new_node->children, node->children, node->node.num_children * sizeof(void*));
       memcpy(new_node->keys, node->keys, node->node.num_children);
       // replace the node through node reference
       *node_ref = (struct art_node*)new_node;
-      free(node);
+      arena_free(t, node, sizeof(struct art_node4));
 
-      node16_add_child(new_node, node_ref, ch, child);
+      node16_add_child(t, new_node, node_ref, ch, child);
    }
 }
 
 static void
-node16_add_child(struct art_node16* node, struct art_node** node_ref, unsigned char ch, void* child)
+node16_add_child(struct art* t, struct art_node16* node, struct art_node** node_ref, unsigned char ch, void* child)
 {
    if (node->node.num_children < 16)
    {
-      int idx = find_index(ch, node->keys, node->node.num_children);
+      int idx = node16_find_index(ch, node);
       // right shift the right part to make space for the key, so that we keep the keys in order
       memmove(node->keys + (idx + 1) + 1, node->keys + (idx + 1), node->node.num_children - (idx + 1));
       memmove(node->children + (idx + 1) + 1, node->children + (idx + 1), (node->node.num_children - (idx + 1)) * sizeof(void*));
@@ -1137,7 +1455,7 @@ node16_add_child(struct art_node16* node, struct art_node** node_ref, unsigned c
    {
       // expand
       struct art_node48* new_node = NULL;
-      create_art_node48(&new_node);
+      create_art_node48(t, &new_node);
       copy_header((struct art_node*)new_node, (struct art_node*)node);
       memcpy(new_node->children, node->children, node->node.num_children * sizeof(void*));
       for (int i = 0; i < node->node.num_children; i++)
@@ -1146,13 +1464,13 @@ node16_add_child(struct art_node16* node, struct art_node** node_ref, unsigned c
       }
       // replace the node through node reference
       *node_ref = (struct art_node*)new_node;
-      free(node);
-      node48_add_child(new_node, node_ref, ch, child);
+      arena_free(t, node, sizeof(struct art_node16));
+      node48_add_child(t, new_node, node_ref, ch, child);
    }
 }
 
 static void
-node48_add_child(struct art_node48* node, struct art_node** node_ref, unsigned char ch, void* child)
+node48_add_child(struct art* t, struct art_node48* node, struct art_node** node_ref, unsigned char ch, void* child)
 {
    if (node->node.num_children < 48)
    {
@@ -1170,7 +1488,7 @@ node48_add_child(struct art_node48* node, struct art_node** node_ref, unsigned c
    {
       // expand
       struct art_node256* new_node = NULL;
-      create_art_node256(&new_node);
+      create_art_node256(t, &new_node);
       copy_header((struct art_node*)new_node, (struct art_node*)node);
       for (int i = 0; i < 256; i++)
       {
@@ -1182,7 +1500,7 @@ node48_add_child(struct art_node48* node, struct art_node** node_ref, unsigned c
       }
       // replace the node through node reference
       *node_ref = (struct art_node*)new_node;
-      free(node);
+      arena_free(t, node, sizeof(struct art_node48));
       node256_add_child(new_node, ch, child);
    }
 }
@@ -1231,6 +1549,41 @@ find_index(unsigned char ch, unsigned char* keys, int length)
    return -1;
 }
 
+static int
+node16_find_index(unsigned char ch, struct art_node16* node)
+{
+#if defined(__SSE2__)
+   __m128i keys;
+   __m128i key;
+   __m128i le;
+   unsigned int mask = 0;
+
+   // keys[i] <= ch exactly when max(keys[i], ch) == ch, and the keys are sorted,
+   // so the number of such keys is one past the index we are looking for
+   keys = _mm_loadu_si128((__m128i*)node->keys);
+   key = _mm_set1_epi8((char)ch);
+   le = _mm_cmpeq_epi8(_mm_max_epu8(keys, key), key);
+   mask = (unsigned int)_mm_movemask_epi8(le) & ((1U << node->node.num_children) - 1);
+
+   return __builtin_popcount(mask) - 1;
+#elif defined(__ARM_NEON)
+   uint8x16_t le;
+   uint64_t mask = 0;
+
+   // Narrow the comparison to 4 bits per key, then count the keys <= ch
+   le = vcleq_u8(vld1q_u8(node->keys), vdupq_n_u8(ch));
+   mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(le), 4)), 0);
+   if (node->node.num_children < 16)
+   {
+      mask &= (1ULL << (node->node.num_children * 4)) - 1;
+   }
+
+   return __builtin_popcountll(mask) / 4 - 1;
+#else
+   return find_index(ch, node->keys, node->node.num_children);
+#endif
+}
+
 static void
 copy_header(struct art_node* dest, struct art_node* src)
 {
@@ -1342,27 +1695,27 @@ node_get_minimum(struct art_node* node)
 }
 
 static void
-node_remove_child(struct art_node* node, struct art_node** node_ref, unsigned char ch)
+node_remove_child(struct art* t, struct art_node* node, struct art_node** node_ref, unsigned char ch)
 {
    switch (node->type)
    {
       case Node4:
-         node4_remove_child((struct art_node4*)node, node_ref, ch);
+         node4_remove_child(t, (struct art_node4*)node, node_ref, ch);
          break;
       case Node16:
-         node16_remove_child((struct art_node16*)node, node_ref, ch);
+         node16_remove_child(t, (struct art_node16*)node, node_ref, ch);
          break;
       case Node48:
-         node48_remove_child((struct art_node48*)node, node_ref, ch);
+         node48_remove_child(t, (struct art_node48*)node, node_ref, ch);
          break;
       case Node256:
-         node256_remove_child((struct art_node256*)node, node_ref, ch);
+         node256_remove_child(t, (struct art_node256*)node, node_ref, ch);
          break;
    }
 }
 
 static void
-node4_remove_child(struct art_node4* node, struct art_node** node_ref, unsigned char ch)
+node4_remove_child(struct art* t, struct art_node4* node, struct art_node** node_ref, unsigned char ch)
 {
    int idx = 0;
    uint32_t len = 0;
@@ -1378,7 +1731,7 @@ node4_remove_child(struct art_node4* node, struct art_node** node_ref, unsigned
       if (IS_LEAF(child))
       {
          // replace directly
-         free(node);
+         arena_free(t, node, sizeof(struct art_node4));
          *node_ref = child;
          return;
       }
@@ -1396,18 +1749,18 @@ node4_remove_child(struct art_node4* node, struct art_node** node_ref, unsigned
       }
       child->prefix_len = node->node.prefix_len + 1 + child->prefix_len;
       memcpy(child->prefix, node->node.prefix, min(child->prefix_len, MAX_PREFIX_LEN));
-      free(node);
+      arena_free(t, node, sizeof(struct art_node4));
       // replace
       *node_ref = child;
    }
 }
 
 static void
-node16_remove_child(struct art_node16* node, struct art_node** node_ref, unsigned char ch)
+node16_remove_child(struct art* t, struct art_node16* node, struct art_node** node_ref, unsigned char ch)
 {
    int idx = 0;
    struct art_node4* new_node = NULL;
-   idx = find_index(ch, node->keys, node->node.num_children);
+   idx = node16_find_index(ch, node);
    memmove(node->keys + idx, node->keys + idx + 1, node->node.num_children - (idx + 1));
    memmove(node->children + idx, node->children + idx + 1, sizeof(void*) * (node->node.num_children - (idx + 1)));
    node->node.num_children--;
@@ -1415,17 +1768,17 @@ node16_remove_child(struct art_node16* node, struct art_node** node_ref, unsigne
    // Trick from libart, do not downgrade immediately to avoid jumping on 4/5 boundary
    if (node->node.num_children <= 3)
    {
-      create_art_node4(&new_node);
+      create_art_node4(t, &new_node);
       copy_header((struct art_node*)new_node, (struct art_node*)node);
       memcpy(new_node->keys, node->keys, node->node.num_children);
       memcpy(new_node->children, node->children, node->node.num_children * sizeof(void*));
-      free(node);
+      arena_free(t, node, sizeof(struct art_node16));
       *node_ref = (struct art_node*)new_node;
    }
 }
 
 static void
-node48_remove_child(struct art_node48* node, struct art_node** node_ref, unsigned char ch)
+node48_remove_child(struct art* t, struct art_node48* node, struct art_node** node_ref, unsigned char ch)
 {
    int idx = node->keys[ch];
    int cnt = 0;
@@ -1436,7 +1789,7 @@ node48_remove_child(struct art_node48* node, struct art_node** node_ref, unsigne
 
    if (node->node.num_children <= 12)
    {
-      create_art_node16(&new_node);
+      create_art_node16(t, &new_node);
       copy_header((struct art_node*)new_node, (struct art_node*)node);
       for (int i = 0; i < 256; i++)
       {
@@ -1447,13 +1800,13 @@ node48_remove_child(struct art_node48* node, struct art_node** node_ref, unsigne
             cnt++;
          }
       }
-      free(node);
+      arena_free(t, node, sizeof(struct art_node48));
       *node_ref = (struct art_node*)new_node;
    }
 }
 
 static void
-node256_remove_child(struct art_node256* node, struct art_node** node_ref, unsigned char ch)
+node256_remove_child(struct art* t, struct art_node256* node, struct art_node** node_ref, unsigned char ch)
 {
    int num = 0;
    for (int i = 0; i < 48; i++)
@@ -1474,7 +1827,7 @@ node256_remove_child(struct art_node256* node, struct art_node** node_ref, unsig
 
    if (node->node.num_children <= 37)
    {
-      create_art_node48(&new_node);
+      create_art_node48(t, &new_node);
       copy_header((struct art_node*)new_node, (struct art_node*)node);
       for (int i = 0; i < 256; i++)
       {
@@ -1485,7 +1838,7 @@ node256_remove_child(struct art_node256* node, struct art_node** node_ref, unsig
             cnt++;
          }
       }
-      free(node);
+      arena_free(t, node, sizeof(struct art_node256));
       *node_ref = (struct art_node*)new_node;
    }
 }
@@ -1533,7 +1886,7 @@ pgmoneta_art_iterator_next(struct art_iterator* iter)
       {
          iter->count++;
          iter->key = (char*)GET_LEAF(node)->key;
-         iter->value = GET_LEAF(node)->value;
+         iter->value = &GET_LEAF(node)->value;
          return true;
       }
       switch (node->type)
@@ -1658,7 +2011,7 @@ art_search(struct art* t, unsigned char* key, uint32_t key_len)
          {
             return NULL;
          }
-         return GET_LEAF(node)->value;
+         return &GET_LEAF(node)->value;
       }
       // optimistically check the prefix,
       // we move forward as long as up to MAX_PREFIX_LEN characters match
@@ -1697,8 +2050,8 @@ art_to_json_string_cb(void* param, char* key, struct value* value)
    tag = pgmoneta_append(tag, ": ");
    str = pgmoneta_value_to_string(value, FORMAT_JSON, tag, p->indent);
    free(tag);
-   p->str = pgmoneta_append(p->str, str);
-   p->str = pgmoneta_append(p->str, has_next ? ",\n" : "\n");
+   pgmoneta_string_builder_append(p->str, str);
+   pgmoneta_string_builder_append(p->str, has_next ? ",\n" : "\n");
 
    free(str);
    return 0;
@@ -1721,8 +2074,8 @@ art_to_compact_json_string_cb(void* param, char* key, struct value* value)
    tag = pgmoneta_append(tag, ":");
    str = pgmoneta_value_to_string(value, FORMAT_JSON_COMPACT, tag, p->indent);
    free(tag);
-   p->str = pgmoneta_append(p->str, str);
-   p->str = pgmoneta_append(p->str, has_next ? "," : "");
+   pgmoneta_string_builder_append(p->str, str);
+   pgmoneta_string_builder_append(p->str, has_next ? "," : "");
 
    free(str);
    return 0;
@@ -1756,7 +2109,7 @@ art_to_text_string_cb(void* param, char* key, struct value* value)
          }
          else
          {
-            p->str = pgmoneta_indent(p->str, tag, 0);
+            pgmoneta_string_builder_indent(p->str, tag, 0);
             str = pgmoneta_value_to_string(value, FORMAT_TEXT, NULL, p->indent + INDENT_PER_LEVEL);
          }
       }
@@ -1770,8 +2123,8 @@ art_to_text_string_cb(void* param, char* key, struct value* value)
       str = pgmoneta_value_to_string(value, FORMAT_TEXT, tag, p->indent);
    }
    free(tag);
-   p->str = pgmoneta_append(p->str, str);
-   p->str = pgmoneta_append(p->str, has_next ? "\n" : "");
+   pgmoneta_string_builder_append(p->str, str);
+   pgmoneta_string_builder_append(p->str, has_next ? "\n" : "");
 
    free(str);
    return 0;
@@ -1780,74 +2133,83 @@ art_to_text_string_cb(void* param, char* key, struct value* value)
 static char*
 to_json_string(struct art* t, char* tag, int indent)
 {
-   char* ret = NULL;
-   ret = pgmoneta_indent(ret, tag, indent);
+   struct string_builder* sb = NULL;
+   if (pgmoneta_string_builder_create(0, &sb))
+   {
+      return NULL;
+   }
+   pgmoneta_string_builder_indent(sb, tag, indent);
    if (t == NULL || t->size == 0)
    {
-      ret = pgmoneta_append(ret, "{}");
-      return ret;
+      pgmoneta_string_builder_append(sb, "{}");
+      return pgmoneta_string_builder_release(sb);
    }
-   ret = pgmoneta_append(ret, "{\n");
+   pgmoneta_string_builder_append(sb, "{\n");
    struct to_string_param param = {
       .indent = indent + INDENT_PER_LEVEL,
-      .str = ret,
+      .str = sb,
       .t = t,
       .cnt = 0,
    };
    art_iterate(t, art_to_json_string_cb, &param);
-   ret = param.str;
-   ret = pgmoneta_indent(ret, NULL, indent);
-   ret = pgmoneta_append(ret, "}");
-   return ret;
+   pgmoneta_string_builder_indent(sb, NULL, indent);
+   pgmoneta_string_builder_append(sb, "}");
+   return pgmoneta_string_builder_release(sb);
 }
 
 static char*
 to_compact_json_string(struct art* t, char* tag, int indent)
 {
-   char* ret = NULL;
-   ret = pgmoneta_indent(ret, tag, indent);
+   struct string_builder* sb = NULL;
+   if (pgmoneta_string_builder_create(0, &sb))
+   {
+      return NULL;
+   }
+   pgmoneta_string_builder_indent(sb, tag, indent);
    if (t == NULL || t->size == 0)
    {
-      ret = pgmoneta_append(ret, "{}");
-      return ret;
+      pgmoneta_string_builder_append(sb, "{}");
+      return pgmoneta_string_builder_release(sb);
    }
-   ret = pgmoneta_append(ret, "{");
+   pgmoneta_string_builder_append(sb, "{");
    struct to_string_param param = {
       .indent = indent,
-      .str = ret,
+      .str = sb,
       .t = t,
       .cnt = 0,
    };
    art_iterate(t, art_to_compact_json_string_cb, &param);
-   ret = param.str;
-   ret = pgmoneta_append(ret, "}");
-   return ret;
+   pgmoneta_string_builder_append(sb, "}");
+   return pgmoneta_string_builder_release(sb);
 }
 
 static char*
 to_text_string(struct art* t, char* tag, int indent)
 {
-   char* ret = NULL;
+   struct string_builder* sb = NULL;
    int next_indent = indent;
+   if (pgmoneta_string_builder_create(0, &sb))
+   {
+      return NULL;
+   }
    if (tag != NULL && !pgmoneta_compare_string(tag, BULLET_POINT))
    {
-      ret = pgmoneta_indent(ret, tag, indent);
+      pgmoneta_string_builder_indent(sb, tag, indent);
       next_indent += INDENT_PER_LEVEL;
    }
    if (t == NULL || t->size == 0)
    {
-      ret = pgmoneta_append(ret, "");
-      return ret;
+      pgmoneta_string_builder_append(sb, "");
+      return pgmoneta_string_builder_release(sb);
    }
    struct to_string_param param = {
       .indent = next_indent,
-      .str = ret,
+      .str = sb,
       .t = t,
       .cnt = 0,
       .tag = tag};
    art_iterate(t, art_to_text_string_cb, &param);
-   ret = param.str;
-   return ret;
+   return pgmoneta_string_builder_release(sb);
 }
 
 static int
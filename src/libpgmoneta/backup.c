@@ -233,7 +233,8 @@ pgmoneta_backup(int client_fd, int server, uint8_t compression, uint8_t encrypti
       pgmoneta_progress_teardown(server);
    }
 
-   backup->backup_size = pgmoneta_directory_size(backup_data);
+   backup->backup_size = pgmoneta_directory_size(backup_data) + backup->chunked_stored_size;
+   pgmoneta_usage_add(server, USAGE_BACKUP, backup->backup_size - backup->chunked_stored_size);
 
    if (pgmoneta_save_info(server_backup, backup))
    {
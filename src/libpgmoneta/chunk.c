@@ -0,0 +1,1423 @@
+/*
+ * Copyright (C) 2026 The pgmoneta community
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or other
+ * materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may
+ * be used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* pgmoneta */
+#include <pgmoneta.h>
+#include <art.h>
+#include <chunk.h>
+#include <deque.h>
+#include <info.h>
+#include <logging.h>
+#include <utils.h>
+#include <workers.h>
+
+/* system */
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <openssl/evp.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+
+#define CHUNK_BUFFER_SIZE (1024 * 1024)
+#define CHUNK_HASH_LENGTH 64
+#define CHUNK_LOCK        ".lock"
+
+/* FastCDC masks: more bits before the average chunk size, fewer after */
+#define CHUNK_MASK_S 0xFFFFC00000000000ULL
+#define CHUNK_MASK_L 0xFFFC000000000000ULL
+
+/** @struct chunk_ref
+ * Defines a chunk of a file
+ */
+struct chunk_ref
+{
+   char hash[CHUNK_HASH_LENGTH + 1]; /**< The SHA-256 of the chunk */
+   size_t length;                    /**< The length of the chunk */
+};
+
+/** @struct chunk_file
+ * Defines a chunked file
+ */
+struct chunk_file
+{
+   char path[MAX_PATH];       /**< The path relative to the directory */
+   uint64_t size;             /**< The size of the file */
+   int number_of_chunks;      /**< The number of chunks */
+   int capacity;              /**< The capacity of the chunk array */
+   struct chunk_ref* chunks;  /**< The chunks */
+   uint64_t stored;           /**< The bytes added to the store */
+   bool failed;               /**< Did the file fail */
+};
+
+/** @struct chunk_input
+ * Defines the input of a chunk task
+ */
+struct chunk_input
+{
+   struct worker_common common; /**< The common base */
+   char* store;                 /**< The chunk store */
+   char* directory;             /**< The directory */
+   struct chunk_file* file;     /**< The file */
+};
+
+static const uint64_t gear[256] = {
+   0x3EACB6EF564614A7ULL, 0x5397164EC71ACF4FULL, 0x0E33D0B2A988AE27ULL, 0x975DC1CCC45F6986ULL,
+   0x15904EF0F40514B2ULL, 0x2880AB3C816E580CULL, 0x48D294F8D5A73CEBULL, 0x10DA878821736F22ULL,
+   0x1C7130A5A921578CULL, 0xCABF5C20186FF915ULL, 0x0A242FA82C55D7A6ULL, 0x9F2110F9327CF96DULL,
+   0x5C633C789F8522BFULL, 0x99C0809A7C447A60ULL, 0x32369BD0E1246AB3ULL, 0xBB0354D93E896F57ULL,
+   0x2960FBC8C4089955ULL, 0xE047FB3E2EC38592ULL, 0x003DD9A744A7113FULL, 0xBDA4D423AE2CD546ULL,
+   0xE55027FADE4B8D9DULL, 0x499D2CD9111EDF27ULL, 0x24B5938DFF7B48FAULL, 0x5D2F504097C3E6B4ULL,
+   0x7DAE9962674DB97AULL, 0xAEED36E209403580ULL, 0x0CA6C86368CB1573ULL, 0x84E1349AFCF88C42ULL,
+   0x9B4173B5B841FFE6ULL, 0xABBFE46F0D5EAA26ULL, 0x76E21F0575FB4633ULL, 0xFB10830BCFA22011ULL,
+   0xE5FC8B49124AA41FULL, 0x558B940592AE1ADDULL, 0x5935B5F2EBF45CC9ULL, 0x15A01C0DFBC29D3CULL,
+   0xD3BD20D201713826ULL, 0x5F0D17CD1A804F8EULL, 0xE7F48774C5A4D84AULL, 0xEE842D7E965CB106ULL,
+   0xF5B60521051785BDULL, 0xAA36C637D0CAECB6ULL, 0xBB3523475F5BD75DULL, 0xA7D33AEE98CA6F55ULL,
+   0xDFEA1B2D322BC8EAULL, 0x3A78C5811B0F4F9DULL, 0x0B7C6DD5519790DBULL, 0x3F690ACB584DA34EULL,
+   0x8A47D543BD7F1A90ULL, 0x4DCF43FF0F5837D8ULL, 0x222279C2AA95CAA0ULL, 0xDC260DE2C85BBBD3ULL,
+   0x10B6BF750FFC9BEAULL, 0x6F8E26DC13FD59F1ULL, 0xA11C446754924F01ULL, 0x91BDC46537A40B32ULL,
+   0x405998E762A329B7ULL, 0xC0D0B553EE4F4C3BULL, 0x5DDB7802FB0CB217ULL, 0x898977F81AA47A47ULL,
+   0x0A345844D06BEF14ULL, 0x8DBE1FC4C6A514EFULL, 0x42614A82FBC63966ULL, 0x8D1EE31D997CA43EULL,
+   0x036584A2B8EADC72ULL, 0x2D6B3D7E7555368AULL, 0x805BB2CBAE662FA0ULL, 0x0CAA1E5055DE2B48ULL,
+   0x8B3DAF35F5E92212ULL, 0x645EA9CFCAC82B18ULL, 0x7D3776797595A796ULL, 0x3AFE511162E7E1BCULL,
+   0x9C74059EC7352EBEULL, 0xCDD8B521AA1C7D45ULL, 0x3AEF8BF93F34EF0CULL, 0x2A8AEFB1297BBEE3ULL,
+   0x7EC24C0514C8D553ULL, 0x54BE94EF1B0FB73EULL, 0xE3C2E2D73D339639ULL, 0xAC84ED97B9E7CC80ULL,
+   0x28EAD99AF02D9018ULL, 0x5991FB2AAC7AE1DEULL, 0x292964BC5AAEA9DDULL, 0xF964D84F34BA91BFULL,
+   0x638ED5581724FA63ULL, 0x9DE9EE7BF411D05BULL, 0xF78DF2E2F2D7B903ULL, 0xFB7BF08B13BFB928ULL,
+   0x6678F2D9AAA5282AULL, 0x6CFDA3815FEC1A13ULL, 0x18366BAE68272FBFULL, 0x1063B7F0C8C31089ULL,
+   0x4B7042ED08945B94ULL, 0x1AA65F4EF98D4EA4ULL, 0xD6F45D783A64AC03ULL, 0x001441149BCE210AULL,
+   0x6FE83A29FEF4604BULL, 0xF391C5EB88A9B0D0ULL, 0xDD762760108B7AAAULL, 0x68851F2AE0EFD1ECULL,
+   0x3769901FB9285BD8ULL, 0xFE82FD8D1C49B1EDULL, 0x536173A2B11EE503ULL, 0xD1E0871E0A493C76ULL,
+   0x12797FA9AD703AD1ULL, 0xAE29006223638470ULL, 0x98592DE20F44FB29ULL, 0xEE394E7C8B5483DEULL,
+   0x8EED27A8638E511FULL, 0xAA34F43617E5B8B9ULL, 0x841469678EFE79EDULL, 0x818D3DB47CAE7595ULL,
+   0xA05EB5BF7E142483ULL, 0x33421CFF75B75DCDULL, 0xF384EE1D9133422EULL, 0xC9A9F80EE689BBF2ULL,
+   0xDA17F77E587A3331ULL, 0x26D8CAF4E8EB16C5ULL, 0x079567D0A678EF06ULL, 0xB5FA931039EACC3AULL,
+   0xB172C411EC0C66C1ULL, 0x9E2F4BD710DC8855ULL, 0xFB632E55F01B11D8ULL, 0x072544DA7D437748ULL,
+   0xD3F2DC61E33B0B9AULL, 0xF01AC9641225F43CULL, 0xA58B3FDC24198CD9ULL, 0x8C6E5D8EA4684DD3ULL,
+   0x624E828C17B1F163ULL, 0x68B3268A74AE3707ULL, 0x79602FD653A22F4CULL, 0x7B03FC2982AAC171ULL,
+   0xAB42797D252BA4D1ULL, 0x610E659CACFEDC9FULL, 0x1DF318C751BCA8DEULL, 0xD5D7EF29B9AC1852ULL,
+   0xD7CD317910EB4EE4ULL, 0xF1FBB13E667B0113ULL, 0xCD915FBAA6DCE77AULL, 0x3FB617A722B7A67EULL,
+   0x0C27A1853570D7BEULL, 0xBEEFBF34CD2FD0DEULL, 0x8687609B7793BA83ULL, 0x92B53E8DF3D1B032ULL,
+   0x68BA28C28AF73AA4ULL, 0x90D855353DD72EFDULL, 0x340BB109FF1BB8BFULL, 0xFC5E53AE7555A659ULL,
+   0x46323E14B7B5924DULL, 0x44FFB66B443147D3ULL, 0xD10DC0CF5FA890F3ULL, 0xFBBCECA506053AEBULL,
+   0x4CDFF10C46C91B09ULL, 0x3A84A4B724E6C6BFULL, 0x54EF19F09EF5B783ULL, 0xBFBBE9B393AFC41EULL,
+   0xF300E47F338E84CEULL, 0xAD7A32602CD32DAAULL, 0xCC9AA6B0A1066E71ULL, 0xB82BFA9502319320ULL,
+   0x916BEFB5F557E142ULL, 0x2D89A71A942782E4ULL, 0x6CBBC8D93B2B2846ULL, 0x76F9626CE486E8DAULL,
+   0x72A2A720875730C6ULL, 0xA45A51142E232A48ULL, 0x1A3C14F6C25E1C47ULL, 0x023C6F9EBD774FB4ULL,
+   0x4BFBF0BBDFF7B1CBULL, 0x7BE187803E00AC47ULL, 0x20EFB2697F957ED3ULL, 0x89F984BDCC0D8A1BULL,
+   0xD620EA8D917EB768ULL, 0x7B45D2A2D3EC771CULL, 0xFA4B38737855EB3EULL, 0xDFBDD96CD40F527BULL,
+   0xAB8CA5FDF7EE06C6ULL, 0x75969D04AB256CBCULL, 0x8CD3711E48075B2FULL, 0x91C9235D35797CD1ULL,
+   0xCB3E653D354F19D6ULL, 0x688B9DC4C4E3B3D5ULL, 0x22B702B90E4CE208ULL, 0x8CBEB9518005D462ULL,
+   0xE6A9013DF46D2110ULL, 0x42BC79F2CEF9267FULL, 0xC2B8E91CA4D5F5C9ULL, 0x8B0B468140D7EDC7ULL,
+   0x7563AED90A29352DULL, 0x7E26BBDF00F00FC8ULL, 0x15ADC2C92056ED12ULL, 0xE7CFD024299FB280ULL,
+   0x9831B2406DF94A28ULL, 0xAE25BDD50BB9E99AULL, 0x18C2324EFCC3F416ULL, 0xFC91AE98060EFF29ULL,
+   0x6DE7FEB22F3BED76ULL, 0x944D5439399B14CBULL, 0xD7A9C31E1D1476B8ULL, 0x508B1DF5BE8EB4D2ULL,
+   0x7F062E8750088C96ULL, 0xD2514B21177F71B9ULL, 0x79075CA65FD47E0EULL, 0xBFC1AE3FDEB39EB9ULL,
+   0x3CF9AA7722BEA981ULL, 0x180CA19DFADDD121ULL, 0x8299ED57F761F0CAULL, 0x64982EDCEFF009B3ULL,
+   0x2287C5E6C0B246ECULL, 0x86248842F636DE94ULL, 0xBA5C521AD6F553E0ULL, 0x0BDC20BFCA7037B8ULL,
+   0x982FFF260B79D363ULL, 0x7F478BD1F9EE7C82ULL, 0xA42ED761FD526751ULL, 0x9EA1ADC3A5B64C10ULL,
+   0x8479D3A55B20C3FFULL, 0x5BC677C647E3FD0AULL, 0x90ED04AB891E27E1ULL, 0x3F2A0BDE7A64E113ULL,
+   0xD06F2A89750ACA12ULL, 0x6589E838D0A6EEDAULL, 0x138A9B3C4FA1AFC7ULL, 0x6FE12815076CE7BDULL,
+   0x6EACD23A9BB848E6ULL, 0x4AC84D37ACA664ABULL, 0x01E2E5D20EFE9EB1ULL, 0x4190B44AB4E49430ULL,
+   0xA7872755312B7410ULL, 0xB0D2C1A3ABE1DE3FULL, 0x14FA4A821A02042DULL, 0x90E032EFA73E4744ULL,
+   0x945178C00C923348ULL, 0x6D12105D7C9379F1ULL, 0x293DE50E40E62C6BULL, 0xB27D1BFF9824DD20ULL,
+   0xFC19B71C5EA528FBULL, 0x73A2FE29A89FCC4AULL, 0xB0E8FD5379A43545ULL, 0x94C5B10DE228D65DULL,
+   0x845F22CA5E8A7C80ULL, 0xFAD915EB50CF126EULL, 0xAF76930BCBE07196ULL, 0x7A8609C85CDC9CE1ULL,
+   0xDEE9AB4935BACD17ULL, 0x5B0B82BCF79BCA14ULL, 0xE6469D0133435BE9ULL, 0x2F541CDFABB532CDULL,
+   0x8959342BAE845C6DULL, 0x34A586D6422F5A74ULL, 0xC7D5446F066E7C40ULL, 0x52717C1C6599F05EULL,
+   0xD6D89E957FEC1223ULL, 0xB2B36B5AFFCCEE4EULL, 0x397592C69C64974FULL, 0xDB3E7BBC30FF2346ULL
+};
+
+static int prepare_store(char* store);
+static int lock_store(char* store, int operation);
+static void unlock_store(int fd);
+static int collect_store(int server, bool shared);
+static int add_indexes(int server, struct deque* indexes);
+static int find_files(char* directory, char* relative, struct deque* files);
+static char* chunk_path(char* store, char* hash);
+static int store_chunk(char* store, unsigned char* data, size_t length, struct chunk_ref* ref, uint64_t* stored);
+static int add_chunk(struct chunk_file* file, struct chunk_ref* ref);
+static void do_chunk_file(struct worker_common* wc);
+static void do_restore_file(struct worker_common* wc);
+static int dispatch(char* store, char* directory, struct chunk_file* files, int number_of_files,
+                    void (*function)(struct worker_common*), struct workers* workers);
+static int write_index(char* index, struct chunk_file* files, int number_of_files);
+static int read_index(char* index, struct chunk_file** files, int* number_of_files);
+static int mark_index(char* index, struct art* marks);
+static void free_files(struct chunk_file* files, int number_of_files);
+static void to_hex(unsigned char* digest, char* hex);
+
+size_t
+pgmoneta_chunk_cut(unsigned char* data, size_t size)
+{
+   uint64_t fp = 0;
+   size_t i = CHUNK_MIN_SIZE;
+   size_t normal = CHUNK_AVERAGE_SIZE;
+
+   if (size <= CHUNK_MIN_SIZE)
+   {
+      return size;
+   }
+
+   if (size > CHUNK_MAX_SIZE)
+   {
+      size = CHUNK_MAX_SIZE;
+   }
+
+   if (size < normal)
+   {
+      normal = size;
+   }
+
+   for (; i < normal; i++)
+   {
+      fp = (fp << 1) + gear[data[i]];
+      if (!(fp & CHUNK_MASK_S))
+      {
+         return i + 1;
+      }
+   }
+
+   for (; i < size; i++)
+   {
+      fp = (fp << 1) + gear[data[i]];
+      if (!(fp & CHUNK_MASK_L))
+      {
+         return i + 1;
+      }
+   }
+
+   return size;
+}
+
+int
+pgmoneta_chunk_directory(char* store, char* directory, char* index, struct workers* workers,
+                         uint64_t* chunked, uint64_t* stored)
+{
+   int number_of_files = 0;
+   int i = 0;
+   int lock = -1;
+   char* tag = NULL;
+   struct deque* candidates = NULL;
+   struct chunk_file* files = NULL;
+
+   *chunked = 0;
+   *stored = 0;
+
+   if (prepare_store(store))
+   {
+      pgmoneta_log_error("Chunk: Could not create %s", store);
+      goto error;
+   }
+
+   /* Shared, so a collection can not sweep chunks before the index refers to them */
+   lock = lock_store(store, LOCK_SH);
+   if (lock == -1)
+   {
+      goto error;
+   }
+
+   if (pgmoneta_deque_create(false, &candidates))
+   {
+      goto error;
+   }
+
+   if (find_files(directory, "", candidates))
+   {
+      goto error;
+   }
+
+   number_of_files = (int)pgmoneta_deque_size(candidates);
+   if (number_of_files > 0)
+   {
+      files = (struct chunk_file*)calloc(number_of_files, sizeof(struct chunk_file));
+      if (files == NULL)
+      {
+         goto error;
+      }
+
+      while (!pgmoneta_deque_empty(candidates))
+      {
+         files[i].size = (uint64_t)pgmoneta_deque_poll(candidates, &tag);
+         pgmoneta_snprintf(files[i].path, sizeof(files[i].path), "%s", tag);
+         free(tag);
+         tag = NULL;
+         i++;
+      }
+   }
+
+   if (dispatch(store, directory, files, number_of_files, do_chunk_file, workers))
+   {
+      goto error;
+   }
+
+   /* The originals are only removed once the index describing them is durable */
+   if (write_index(index, files, number_of_files))
+   {
+      pgmoneta_log_error("Chunk: Could not write %s", index);
+      goto error;
+   }
+
+   for (i = 0; i < number_of_files; i++)
+   {
+      char path[MAX_PATH];
+
+      pgmoneta_snprintf(path, sizeof(path), "%s/%s", directory, files[i].path);
+      if (unlink(path))
+      {
+         pgmoneta_log_warn("Chunk: Could not remove %s (%s)", path, strerror(errno));
+      }
+
+      *chunked += files[i].size;
+      *stored += files[i].stored;
+   }
+
+   unlock_store(lock);
+   free_files(files, number_of_files);
+   pgmoneta_deque_destroy(candidates);
+
+   return 0;
+
+error:
+
+   unlock_store(lock);
+   free_files(files, number_of_files);
+   pgmoneta_deque_destroy(candidates);
+
+   return 1;
+}
+
+int
+pgmoneta_chunk_restore(char* store, char* index, char* directory, struct workers* workers)
+{
+   int number_of_files = 0;
+   struct chunk_file* files = NULL;
+
+   if (read_index(index, &files, &number_of_files))
+   {
+      pgmoneta_log_error("Chunk: Could not read %s", index);
+      goto error;
+   }
+
+   if (dispatch(store, directory, files, number_of_files, do_restore_file, workers))
+   {
+      goto error;
+   }
+
+   free_files(files, number_of_files);
+
+   return 0;
+
+error:
+
+   free_files(files, number_of_files);
+
+   return 1;
+}
+
+int
+pgmoneta_chunk_collect(char* store, struct deque* indexes, uint64_t* removed)
+{
+   int lock = -1;
+   char sub[MAX_PATH];
+   char path[MAX_PATH];
+   DIR* dir = NULL;
+   struct dirent* entry = NULL;
+   struct stat st;
+   struct art* marks = NULL;
+   struct deque_iterator* iter = NULL;
+
+   *removed = 0;
+
+   /* A backup is adding chunks, so collect the next time */
+   lock = lock_store(store, LOCK_EX | LOCK_NB);
+   if (lock == -1)
+   {
+      pgmoneta_log_debug("Chunk: %s is in use", store);
+      return 0;
+   }
+
+   if (pgmoneta_art_create(&marks))
+   {
+      goto error;
+   }
+
+   if (indexes != NULL)
+   {
+      if (pgmoneta_deque_iterator_create(indexes, &iter))
+      {
+         goto error;
+      }
+
+      while (pgmoneta_deque_iterator_next(iter))
+      {
+         if (mark_index(iter->tag, marks))
+         {
+            /* Never sweep with an incomplete mark set */
+            pgmoneta_log_error("Chunk: Could not read %s", iter->tag);
+            goto error;
+         }
+      }
+   }
+
+   for (int i = 0; i < 256; i++)
+   {
+      pgmoneta_snprintf(sub, sizeof(sub), "%s/%02x", store, i);
+
+      dir = opendir(sub);
+      if (dir == NULL)
+      {
+         continue;
+      }
+
+      while ((entry = readdir(dir)) != NULL)
+      {
+         if (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, ".."))
+         {
+            continue;
+         }
+
+         if (pgmoneta_art_contains_key(marks, entry->d_name))
+         {
+            continue;
+         }
+
+         pgmoneta_snprintf(path, sizeof(path), "%s/%s", sub, entry->d_name);
+         if (!lstat(path, &st) && S_ISREG(st.st_mode) && !unlink(path))
+         {
+            *removed += st.st_size;
+         }
+      }
+
+      closedir(dir);
+      dir = NULL;
+   }
+
+   unlock_store(lock);
+   pgmoneta_deque_iterator_destroy(iter);
+   pgmoneta_art_destroy(marks);
+
+   return 0;
+
+error:
+
+   unlock_store(lock);
+   pgmoneta_deque_iterator_destroy(iter);
+   pgmoneta_art_destroy(marks);
+
+   return 1;
+}
+
+bool
+pgmoneta_chunk_is_chunked(int server, char* label)
+{
+   bool chunked = false;
+   char* index = NULL;
+
+   index = pgmoneta_get_server_backup_identifier(server, label);
+   index = pgmoneta_append(index, CHUNK_INDEX);
+
+   chunked = pgmoneta_exists(index);
+
+   free(index);
+
+   return chunked;
+}
+
+char*
+pgmoneta_chunk_get_rehydrated(int server, char* label)
+{
+   char* d = NULL;
+
+   d = pgmoneta_get_server_workspace(server);
+   if (d == NULL)
+   {
+      return NULL;
+   }
+
+   d = pgmoneta_append(d, label);
+   d = pgmoneta_append(d, "/");
+   d = pgmoneta_append(d, CHUNK_REHYDRATED);
+   d = pgmoneta_append(d, "/");
+
+   return d;
+}
+
+int
+pgmoneta_chunk_rehydrate(int server, char* label)
+{
+   int number_of_workers = 0;
+   unsigned long free_space = 0;
+   char* store = NULL;
+   char* index = NULL;
+   char* directory = NULL;
+   char* server_backup = NULL;
+   struct backup* backup = NULL;
+   struct workers* workers = NULL;
+   struct main_configuration* config;
+
+   config = (struct main_configuration*)shmem;
+
+   server_backup = pgmoneta_get_server_backup(server);
+   index = pgmoneta_get_server_backup_identifier(server, label);
+   index = pgmoneta_append(index, CHUNK_INDEX);
+
+   if (!pgmoneta_exists(index))
+   {
+      goto done;
+   }
+
+   if (pgmoneta_load_info(server_backup, label, &backup) || backup == NULL)
+   {
+      pgmoneta_log_error("Chunk: Could not load %s/%s", config->common.servers[server].name, label);
+      goto error;
+   }
+
+   directory = pgmoneta_chunk_get_rehydrated(server, label);
+   if (directory == NULL)
+   {
+      goto error;
+   }
+
+   pgmoneta_delete_directory(directory);
+   if (pgmoneta_mkdir(directory))
+   {
+      pgmoneta_log_error("Chunk: Could not create %s", directory);
+      goto error;
+   }
+
+   free_space = pgmoneta_free_space(directory);
+   if (free_space < backup->chunked_size)
+   {
+      pgmoneta_log_error("Chunk: Not enough space to rehydrate %s/%s in %s (%lu bytes, %lu free)",
+                         config->common.servers[server].name, label, directory,
+                         backup->chunked_size, free_space);
+      goto error;
+   }
+
+   /* The backup records the store it was chunked into */
+   store = pgmoneta_get_server_chunks(server, backup->chunked_shared);
+
+   pgmoneta_log_debug("Chunk: Rehydrate %s/%s into %s (%lu bytes)", config->common.servers[server].name,
+                      label, directory, backup->chunked_size);
+
+   number_of_workers = pgmoneta_get_number_of_workers(server);
+   if (number_of_workers > 0)
+   {
+      pgmoneta_workers_initialize(number_of_workers, &workers);
+   }
+
+   if (pgmoneta_chunk_restore(store, index, directory, workers))
+   {
+      pgmoneta_log_error("Chunk: Could not rehydrate %s/%s", config->common.servers[server].name, label);
+      goto error;
+   }
+
+done:
+
+   pgmoneta_workers_destroy(workers);
+   free(backup);
+   free(store);
+   free(index);
+   free(directory);
+   free(server_backup);
+
+   return 0;
+
+error:
+
+   if (directory != NULL)
+   {
+      pgmoneta_delete_directory(directory);
+   }
+
+   pgmoneta_workers_destroy(workers);
+   free(backup);
+   free(store);
+   free(index);
+   free(directory);
+   free(server_backup);
+
+   return 1;
+}
+
+void
+pgmoneta_chunk_rehydrate_remove(int server, char* label)
+{
+   char* directory = NULL;
+
+   directory = pgmoneta_chunk_get_rehydrated(server, label);
+
+   if (directory != NULL && pgmoneta_exists(directory))
+   {
+      pgmoneta_delete_directory(directory);
+   }
+
+   free(directory);
+}
+
+int
+pgmoneta_chunk_collect_server(int server)
+{
+   /* Each backup records the store it was chunked into, so both are collected */
+   if (collect_store(server, false) || collect_store(server, true))
+   {
+      return 1;
+   }
+
+   return 0;
+}
+
+static int
+prepare_store(char* store)
+{
+   char sub[MAX_PATH];
+
+   for (int i = 0; i < 256; i++)
+   {
+      pgmoneta_snprintf(sub, sizeof(sub), "%s/%02x", store, i);
+      if (pgmoneta_mkdir(sub))
+      {
+         return 1;
+      }
+   }
+
+   return 0;
+}
+
+static int
+lock_store(char* store, int operation)
+{
+   int fd = -1;
+   char path[MAX_PATH];
+
+   pgmoneta_snprintf(path, sizeof(path), "%s/%s", store, CHUNK_LOCK);
+
+   fd = open(path, O_RDONLY | O_CREAT, S_IRUSR | S_IWUSR);
+   if (fd == -1)
+   {
+      pgmoneta_log_error("Chunk: Could not open %s (%s)", path, strerror(errno));
+      return -1;
+   }
+
+   if (flock(fd, operation))
+   {
+      close(fd);
+      return -1;
+   }
+
+   return fd;
+}
+
+static void
+unlock_store(int fd)
+{
+   if (fd != -1)
+   {
+      flock(fd, LOCK_UN);
+      close(fd);
+   }
+}
+
+static int
+collect_store(int server, bool shared)
+{
+   uint64_t removed = 0;
+   char* store = NULL;
+   struct deque* indexes = NULL;
+   struct main_configuration* config;
+
+   config = (struct main_configuration*)shmem;
+
+   store = pgmoneta_get_server_chunks(server, shared);
+
+   if (!pgmoneta_exists(store))
+   {
+      goto done;
+   }
+
+   if (pgmoneta_deque_create(false, &indexes))
+   {
+      goto error;
+   }
+
+   /* A shared store keeps every chunk that a backup of any server refers to */
+   for (int i = 0; i < config->common.number_of_servers; i++)
+   {
+      if (i == server || shared)
+      {
+         if (add_indexes(i, indexes))
+         {
+            goto error;
+         }
+      }
+   }
+
+   if (pgmoneta_chunk_collect(store, indexes, &removed))
+   {
+      goto error;
+   }
+
+   if (removed > 0)
+   {
+      pgmoneta_log_debug("Chunk: Removed %lu bytes from %s", removed, store);
+   }
+
+done:
+
+   pgmoneta_deque_destroy(indexes);
+   free(store);
+
+   return 0;
+
+error:
+
+   pgmoneta_deque_destroy(indexes);
+   free(store);
+
+   return 1;
+}
+
+static int
+add_indexes(int server, struct deque* indexes)
+{
+   int number_of_backups = 0;
+   char* server_backup = NULL;
+   char* index = NULL;
+   struct backup** backups = NULL;
+
+   server_backup = pgmoneta_get_server_backup(server);
+
+   if (pgmoneta_load_infos(server_backup, &number_of_backups, &backups))
+   {
+      free(server_backup);
+      return 1;
+   }
+
+   /* Every index is marked whatever store it records, since a backup being
+    * chunked may not have recorded its store yet */
+   for (int i = 0; i < number_of_backups; i++)
+   {
+      index = pgmoneta_get_server_backup_identifier(server, backups[i]->label);
+      index = pgmoneta_append(index, CHUNK_INDEX);
+
+      if (pgmoneta_exists(index))
+      {
+         pgmoneta_deque_add(indexes, index, (uintptr_t)index, ValueString);
+      }
+
+      free(index);
+      index = NULL;
+   }
+
+   for (int i = 0; i < number_of_backups; i++)
+   {
+      free(backups[i]);
+   }
+   free(backups);
+   free(server_backup);
+
+   return 0;
+}
+
+static int
+find_files(char* directory, char* relative, struct deque* files)
+{
+   char path[MAX_PATH];
+   char rel[MAX_PATH];
+   DIR* dir = NULL;
+   struct dirent* entry = NULL;
+   struct stat st;
+
+   pgmoneta_snprintf(path, sizeof(path), "%s/%s", directory, relative);
+
+   dir = opendir(path);
+   if (dir == NULL)
+   {
+      pgmoneta_log_error("Chunk: Could not open %s (%s)", path, strerror(errno));
+      return 1;
+   }
+
+   while ((entry = readdir(dir)) != NULL)
+   {
+      if (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, ".."))
+      {
+         continue;
+      }
+
+      if (*relative == '\0')
+      {
+         pgmoneta_snprintf(rel, sizeof(rel), "%s", entry->d_name);
+      }
+      else
+      {
+         pgmoneta_snprintf(rel, sizeof(rel), "%s/%s", relative, entry->d_name);
+      }
+
+      pgmoneta_snprintf(path, sizeof(path), "%s/%s", directory, rel);
+
+      /* Links point into other backups and are left alone */
+      if (lstat(path, &st))
+      {
+         continue;
+      }
+
+      if (S_ISDIR(st.st_mode))
+      {
+         if (find_files(directory, rel, files))
+         {
+            closedir(dir);
+            return 1;
+         }
+      }
+      else if (S_ISREG(st.st_mode) && st.st_size >= CHUNK_MIN_FILE_SIZE &&
+               strcmp(rel, "backup_label") && strcmp(rel, "backup_manifest"))
+      {
+         pgmoneta_deque_add(files, rel, (uintptr_t)st.st_size, ValueUInt64);
+      }
+   }
+
+   closedir(dir);
+
+   return 0;
+}
+
+static char*
+chunk_path(char* store, char* hash)
+{
+   char* p = NULL;
+
+   p = pgmoneta_append(p, store);
+   if (!pgmoneta_ends_with(p, "/"))
+   {
+      p = pgmoneta_append(p, "/");
+   }
+   p = pgmoneta_append_char(p, hash[0]);
+   p = pgmoneta_append_char(p, hash[1]);
+   p = pgmoneta_append(p, "/");
+   p = pgmoneta_append(p, hash);
+
+   return p;
+}
+
+static int
+store_chunk(char* store, unsigned char* data, size_t length, struct chunk_ref* ref, uint64_t* stored)
+{
+   int fd = -1;
+   unsigned char digest[EVP_MAX_MD_SIZE];
+   unsigned int digest_length = 0;
+   char* path = NULL;
+   char temp[MAX_PATH];
+   struct stat st;
+
+   if (!EVP_Digest(data, length, digest, &digest_length, EVP_sha256(), NULL))
+   {
+      goto error;
+   }
+
+   to_hex(digest, ref->hash);
+   ref->length = length;
+
+   path = chunk_path(store, ref->hash);
+
+   if (!stat(path, &st) && (size_t)st.st_size == length)
+   {
+      free(path);
+      return 0;
+   }
+
+   /* Concurrent writers of the same chunk race harmlessly on the rename */
+   pgmoneta_snprintf(temp, sizeof(temp), "%s.XXXXXX", path);
+   fd = mkstemp(temp);
+   if (fd == -1)
+   {
+      goto error;
+   }
+
+   for (size_t written = 0; written < length;)
+   {
+      ssize_t w = write(fd, data + written, length - written);
+      if (w <= 0)
+      {
+         goto error;
+      }
+      written += (size_t)w;
+   }
+
+   if (fsync(fd) || close(fd))
+   {
+      fd = -1;
+      goto error;
+   }
+   fd = -1;
+
+   if (rename(temp, path))
+   {
+      goto error;
+   }
+
+   *stored += length;
+
+   free(path);
+
+   return 0;
+
+error:
+
+   if (fd != -1)
+   {
+      close(fd);
+   }
+   if (path != NULL)
+   {
+      unlink(temp);
+      pgmoneta_log_error("Chunk: Could not store %s (%s)", path, strerror(errno));
+   }
+   free(path);
+
+   return 1;
+}
+
+static int
+add_chunk(struct chunk_file* file, struct chunk_ref* ref)
+{
+   struct chunk_ref* chunks = NULL;
+
+   if (file->number_of_chunks == file->capacity)
+   {
+      int capacity = file->capacity == 0 ? 16 : file->capacity * 2;
+
+      chunks = (struct chunk_ref*)realloc(file->chunks, capacity * sizeof(struct chunk_ref));
+      if (chunks == NULL)
+      {
+         return 1;
+      }
+
+      file->chunks = chunks;
+      file->capacity = capacity;
+   }
+
+   memcpy(&file->chunks[file->number_of_chunks], ref, sizeof(struct chunk_ref));
+   file->number_of_chunks++;
+
+   return 0;
+}
+
+static void
+do_chunk_file(struct worker_common* wc)
+{
+   int fd = -1;
+   size_t start = 0;
+   size_t end = 0;
+   size_t length = 0;
+   ssize_t r = 0;
+   bool eof = false;
+   char path[MAX_PATH];
+   unsigned char* buffer = NULL;
+   struct chunk_ref ref;
+   struct chunk_input* ci = (struct chunk_input*)wc;
+   struct chunk_file* file = ci->file;
+
+   pgmoneta_snprintf(path, sizeof(path), "%s/%s", ci->directory, file->path);
+
+   buffer = (unsigned char*)malloc(CHUNK_BUFFER_SIZE);
+   if (buffer == NULL)
+   {
+      goto error;
+   }
+
+   fd = open(path, O_RDONLY);
+   if (fd == -1)
+   {
+      pgmoneta_log_error("Chunk: Could not open %s (%s)", path, strerror(errno));
+      goto error;
+   }
+
+   while (!eof || start < end)
+   {
+      /* Keep at least a maximum sized chunk in the buffer */
+      if (!eof && end - start < CHUNK_MAX_SIZE)
+      {
+         memmove(buffer, buffer + start, end - start);
+         end -= start;
+         start = 0;
+
+         while (!eof && end < CHUNK_BUFFER_SIZE)
+         {
+            r = read(fd, buffer + end, CHUNK_BUFFER_SIZE - end);
+            if (r < 0)
+            {
+               pgmoneta_log_error("Chunk: Could not read %s (%s)", path, strerror(errno));
+               goto error;
+            }
+            else if (r == 0)
+            {
+               eof = true;
+            }
+            end += (size_t)r;
+         }
+      }
+
+      if (start == end)
+      {
+         break;
+      }
+
+      length = pgmoneta_chunk_cut(buffer + start, end - start);
+
+      if (store_chunk(ci->store, buffer + start, length, &ref, &file->stored) ||
+          add_chunk(file, &ref))
+      {
+         goto error;
+      }
+
+      start += length;
+   }
+
+   close(fd);
+   free(buffer);
+   free(ci);
+
+   return;
+
+error:
+
+   if (fd != -1)
+   {
+      close(fd);
+   }
+   file->failed = true;
+   if (ci->common.workers != NULL)
+   {
+      ci->common.workers->outcome = false;
+   }
+   free(buffer);
+   free(ci);
+}
+
+static void
+do_restore_file(struct worker_common* wc)
+{
+   int in = -1;
+   int out = -1;
+   ssize_t r = 0;
+   size_t got = 0;
+   unsigned char digest[EVP_MAX_MD_SIZE];
+   unsigned int digest_length = 0;
+   char hash[CHUNK_HASH_LENGTH + 1];
+   char path[MAX_PATH];
+   char* parent = NULL;
+   char* source = NULL;
+   unsigned char* buffer = NULL;
+   struct chunk_input* ci = (struct chunk_input*)wc;
+   struct chunk_file* file = ci->file;
+
+   pgmoneta_snprintf(path, sizeof(path), "%s/%s", ci->directory, file->path);
+
+   parent = pgmoneta_append(parent, path);
+   if (strrchr(parent, '/') != NULL)
+   {
+      *strrchr(parent, '/') = '\0';
+      pgmoneta_mkdir(parent);
+   }
+
+   buffer = (unsigned char*)malloc(CHUNK_MAX_SIZE);
+   if (buffer == NULL)
+   {
+      goto error;
+   }
+
+   out = open(path, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+   if (out == -1)
+   {
+      pgmoneta_log_error("Chunk: Could not create %s (%s)", path, strerror(errno));
+      goto error;
+   }
+
+   for (int i = 0; i < file->number_of_chunks; i++)
+   {
+      struct chunk_ref* ref = &file->chunks[i];
+
+      if (ref->length > CHUNK_MAX_SIZE)
+      {
+         goto error;
+      }
+
+      source = chunk_path(ci->store, ref->hash);
+      in = open(source, O_RDONLY);
+      if (in == -1)
+      {
+         pgmoneta_log_error("Chunk: Missing %s for %s", source, path);
+         goto error;
+      }
+
+      got = 0;
+      while (got < ref->length)
+      {
+         r = read(in, buffer + got, ref->length - got);
+         if (r <= 0)
+         {
+            break;
+         }
+         got += (size_t)r;
+      }
+      close(in);
+      in = -1;
+
+      /* A chunk is only trusted when it still matches its name */
+      if (got != ref->length ||
+          !EVP_Digest(buffer, got, digest, &digest_length, EVP_sha256(), NULL))
+      {
+         pgmoneta_log_error("Chunk: Short chunk %s for %s", source, path);
+         goto error;
+      }
+
+      to_hex(digest, hash);
+      if (strcmp(hash, ref->hash))
+      {
+         pgmoneta_log_error("Chunk: Corrupt chunk %s for %s", source, path);
+         goto error;
+      }
+
+      for (size_t written = 0; written < got;)
+      {
+         ssize_t w = write(out, buffer + written, got - written);
+         if (w <= 0)
+         {
+            pgmoneta_log_error("Chunk: Could not write %s (%s)", path, strerror(errno));
+            goto error;
+         }
+         written += (size_t)w;
+      }
+
+      free(source);
+      source = NULL;
+   }
+
+   if (close(out))
+   {
+      out = -1;
+      goto error;
+   }
+
+   free(parent);
+   free(buffer);
+   free(ci);
+
+   return;
+
+error:
+
+   if (in != -1)
+   {
+      close(in);
+   }
+   if (out != -1)
+   {
+      close(out);
+   }
+   file->failed = true;
+   if (ci->common.workers != NULL)
+   {
+      ci->common.workers->outcome = false;
+   }
+   free(source);
+   free(parent);
+   free(buffer);
+   free(ci);
+}
+
+static int
+dispatch(char* store, char* directory, struct chunk_file* files, int number_of_files,
+         void (*function)(struct worker_common*), struct workers* workers)
+{
+   struct chunk_input* ci = NULL;
+
+   for (int i = 0; i < number_of_files; i++)
+   {
+      ci = (struct chunk_input*)calloc(1, sizeof(struct chunk_input));
+      if (ci == NULL)
+      {
+         return 1;
+      }
+
+      ci->common.workers = workers;
+      ci->store = store;
+      ci->directory = directory;
+      ci->file = &files[i];
+
+      if (workers != NULL)
+      {
+         if (workers->outcome)
+         {
+            pgmoneta_workers_add(workers, function, (struct worker_common*)ci);
+         }
+         else
+         {
+            free(ci);
+         }
+      }
+      else
+      {
+         function((struct worker_common*)ci);
+      }
+   }
+
+   pgmoneta_workers_wait(workers);
+   if (workers != NULL && !workers->outcome)
+   {
+      return 1;
+   }
+
+   for (int i = 0; i < number_of_files; i++)
+   {
+      if (files[i].failed)
+      {
+         return 1;
+      }
+   }
+
+   return 0;
+}
+
+static int
+write_index(char* index, struct chunk_file* files, int number_of_files)
+{
+   char temp[MAX_PATH];
+   FILE* f = NULL;
+
+   pgmoneta_snprintf(temp, sizeof(temp), "%s.tmp", index);
+
+   f = fopen(temp, "w");
+   if (f == NULL)
+   {
+      goto error;
+   }
+
+   for (int i = 0; i < number_of_files; i++)
+   {
+      if (fprintf(f, "%s,%lu,%d\n", files[i].path, files[i].size, files[i].number_of_chunks) < 0)
+      {
+         goto error;
+      }
+
+      for (int j = 0; j < files[i].number_of_chunks; j++)
+      {
+         if (fprintf(f, "%s,%zu\n", files[i].chunks[j].hash, files[i].chunks[j].length) < 0)
+         {
+            goto error;
+         }
+      }
+   }
+
+   if (fflush(f) || fsync(fileno(f)))
+   {
+      goto error;
+   }
+
+   if (fclose(f))
+   {
+      f = NULL;
+      goto error;
+   }
+   f = NULL;
+
+   if (rename(temp, index))
+   {
+      goto error;
+   }
+
+   pgmoneta_permission(index, 6, 0, 0);
+
+   return 0;
+
+error:
+
+   if (f != NULL)
+   {
+      fclose(f);
+   }
+   unlink(temp);
+
+   return 1;
+}
+
+static int
+read_index(char* index, struct chunk_file** files, int* number_of_files)
+{
+   int n = 0;
+   int capacity = 0;
+   char line[MAX_PATH + 64];
+   char* comma = NULL;
+   char* count = NULL;
+   FILE* f = NULL;
+   struct chunk_file* fs = NULL;
+   struct chunk_file* tmp = NULL;
+   struct chunk_ref ref;
+
+   *files = NULL;
+   *number_of_files = 0;
+
+   f = fopen(index, "r");
+   if (f == NULL)
+   {
+      goto error;
+   }
+
+   while (fgets(line, sizeof(line), f) != NULL)
+   {
+      line[strcspn(line, "\n")] = '\0';
+
+      /* <path>,<size>,<count> where the path may hold commas */
+      count = strrchr(line, ',');
+      if (count == NULL)
+      {
+         goto error;
+      }
+      *count++ = '\0';
+
+      comma = strrchr(line, ',');
+      if (comma == NULL)
+      {
+         goto error;
+      }
+      *comma++ = '\0';
+
+      if (n == capacity)
+      {
+         capacity = capacity == 0 ? 64 : capacity * 2;
+         tmp = (struct chunk_file*)realloc(fs, capacity * sizeof(struct chunk_file));
+         if (tmp == NULL)
+         {
+            goto error;
+         }
+         fs = tmp;
+      }
+
+      memset(&fs[n], 0, sizeof(struct chunk_file));
+      pgmoneta_snprintf(fs[n].path, sizeof(fs[n].path), "%s", line);
+      fs[n].size = strtoull(comma, NULL, 10);
+      n++;
+
+      for (int i = atoi(count); i > 0; i--)
+      {
+         if (fgets(line, sizeof(line), f) == NULL)
+         {
+            goto error;
+         }
+
+         comma = strchr(line, ',');
+         if (comma == NULL || comma - line != CHUNK_HASH_LENGTH)
+         {
+            goto error;
+         }
+
+         memset(&ref, 0, sizeof(ref));
+         memcpy(ref.hash, line, CHUNK_HASH_LENGTH);
+         ref.length = (size_t)strtoull(comma + 1, NULL, 10);
+
+         if (add_chunk(&fs[n - 1], &ref))
+         {
+            goto error;
+         }
+      }
+   }
+
+   fclose(f);
+
+   *files = fs;
+   *number_of_files = n;
+
+   return 0;
+
+error:
+
+   if (f != NULL)
+   {
+      fclose(f);
+   }
+   free_files(fs, n);
+
+   return 1;
+}
+
+static int
+mark_index(char* index, struct art* marks)
+{
+   int number_of_files = 0;
+   struct chunk_file* files = NULL;
+
+   if (read_index(index, &files, &number_of_files))
+   {
+      return 1;
+   }
+
+   for (int i = 0; i < number_of_files; i++)
+   {
+      for (int j = 0; j < files[i].number_of_chunks; j++)
+      {
+         pgmoneta_art_insert(marks, files[i].chunks[j].hash, 1, ValueBool);
+      }
+   }
+
+   free_files(files, number_of_files);
+
+   return 0;
+}
+
+static void
+free_files(struct chunk_file* files, int number_of_files)
+{
+   if (files == NULL)
+   {
+      return;
+   }
+
+   for (int i = 0; i < number_of_files; i++)
+   {
+      free(files[i].chunks);
+   }
+   free(files);
+}
+
+static void
+to_hex(unsigned char* digest, char* hex)
+{
+   static const char digits[] = "0123456789abcdef";
+
+   for (int i = 0; i < CHUNK_HASH_LENGTH / 2; i++)
+   {
+      hex[i * 2] = digits[digest[i] >> 4];
+      hex[i * 2 + 1] = digits[digest[i] & 0xF];
+   }
+   hex[CHUNK_HASH_LENGTH] = '\0';
+}
@@ -47,6 +47,7 @@
 #include <ctype.h>
 #include <err.h>
 #include <errno.h>
+#include <limits.h>
 #include <stdatomic.h>
 #include <stdbool.h>
 #include <stdio.h>
@@ -72,6 +73,7 @@ static int as_logging_level(char* str);
 static int as_logging_mode(char* str);
 static int as_hugepage(char* str);
 static int as_direct_io(char* str);
+static int as_tls_ktls(char* str);
 static int as_compression(char* str);
 static int as_storage_engine(char* str);
 static char* as_ciphers(char* str);
@@ -83,6 +85,7 @@ static unsigned int as_update_process_title(char* str, unsigned int default_poli
 static int as_logging_rotation_size(char* str, int* size);
 static int as_seconds(char* str, pgmoneta_time_t* time, pgmoneta_time_t default_age);
 static int as_bytes(char* str, int* bytes, int default_bytes);
+static int as_bytes64(char* str, uint64_t* bytes, uint64_t default_bytes);
 static int as_retention(char* str, int* days, int* weeks, int* months, int* years);
 static int as_create_slot(char* str, int* create_slot);
 static char* get_retention_string(int rt_days, int rt_weeks, int rt_months, int rt_year);
@@ -104,6 +107,7 @@ static int to_storage_engine(char* where, int value);
 static int to_create_slot(char* where, int value);
 static int to_hugepage(char* where, int value);
 static int to_direct_io(char* where, int value);
+static int to_tls_ktls(char* where, int value);
 static int to_log_type(char* where, int value);
 static int to_log_level(char* where, int value);
 static int to_log_mode(char* where, int value);
@@ -183,6 +187,7 @@ pgmoneta_init_main_configuration(void* shm)
    config->retention_interval = 300;
 
    config->tls = false;
+   config->tls_ktls = TLS_KTLS_OFF;
 
    config->blocking_timeout = PGMONETA_TIME_SEC(DEFAULT_BLOCKING_TIMEOUT);
    config->authentication_timeout = PGMONETA_TIME_SEC(5);
@@ -194,6 +199,11 @@ pgmoneta_init_main_configuration(void* shm)
    config->common.nodelay = true;
    config->common.non_blocking = true;
    config->backlog = 16;
+   config->socket_rcvbuf = DEFAULT_BUFFER_SIZE;
+   config->socket_sndbuf = DEFAULT_BUFFER_SIZE;
+   config->tcp_window_clamp = 0;
+   config->tcp_notsent_lowat = 0;
+   config->busy_poll = 0;
    config->hugepage = HUGEPAGE_TRY;
    config->direct_io = DIRECT_IO_OFF;
 
@@ -205,8 +215,29 @@ pgmoneta_init_main_configuration(void* shm)
    atomic_init(&config->common.log_lock, STATE_FREE);
 
    config->max_rate = 0;
+   config->io_max_rate = 0;
+   config->io_max_iops = 0;
+   pgmoneta_throttle_init(&config->throttle);
+   atomic_init(&config->used_space, 0);
+   atomic_init(&config->usage_active, false);
 
    config->verification = PGMONETA_TIME_DISABLED;
+   config->verification_budget = 0;
+
+   config->tree_hash = false;
+
+   config->chunk_store = false;
+   config->chunk_store_shared = false;
+
+   config->link_paranoid = false;
+   config->ssh_inflight = 16;
+   config->azure_port = 0;
+   config->azure_use_tls = true;
+   config->azure_block_size = 8 * 1024 * 1024;
+   config->s3_part_size = 16 * 1024 * 1024;
+   config->s3_download_concurrency = 4;
+   config->wal_bundle_size = 0;
+   config->wal_bundle_timeout = PGMONETA_TIME_MIN(5);
 
 #ifdef DEBUG
    config->link = true;
@@ -295,6 +326,8 @@ pgmoneta_read_main_configuration(void* shm, char* filename)
                   srv.primary = false;
                   atomic_init(&srv.repository, false);
                   atomic_init(&srv.wal_repository, false);
+                  atomic_init(&srv.wal_bundle, 0);
+                  pgmoneta_usage_init(&srv.usage);
                   srv.active_backup = false;
                   srv.active_restore = false;
                   srv.active_archive = false;
@@ -311,6 +344,11 @@ pgmoneta_read_main_configuration(void* shm, char* filename)
                   memset(srv.wal_shipping, 0, MAX_PATH);
                   srv.workers = -1;
                   srv.max_rate = -1;
+                  srv.socket_rcvbuf = -1;
+                  srv.socket_sndbuf = -1;
+                  srv.tcp_window_clamp = -1;
+                  srv.tcp_notsent_lowat = -1;
+                  srv.busy_poll = -1;
                   srv.progress_enabled = -1;
 
                   idx_server++;
@@ -760,6 +798,17 @@ pgmoneta_read_main_configuration(void* shm, char* filename)
                      unknown = true;
                   }
                }
+               else if (!strcmp(key, "tls_ktls"))
+               {
+                  if (!strcmp(section, "pgmoneta"))
+                  {
+                     config->tls_ktls = as_tls_ktls(value);
+                  }
+                  else
+                  {
+                     unknown = true;
+                  }
+               }
                else if (!strcmp(key, "tls_ca_file"))
                {
                   if (!strcmp(section, "pgmoneta"))
@@ -1302,6 +1351,20 @@ pgmoneta_read_main_configuration(void* shm, char* filename)
                      unknown = true;
                   }
                }
+               else if (!strcmp(key, "ssh_inflight"))
+               {
+                  if (!strcmp(section, "pgmoneta"))
+                  {
+                     if (as_int(value, &config->ssh_inflight))
+                     {
+                        unknown = true;
+                     }
+                  }
+                  else
+                  {
+                     unknown = true;
+                  }
+               }
                else if (!strcmp(key, "s3_use_tls"))
                {
                   if (!strcmp(section, "pgmoneta"))
@@ -1583,6 +1646,120 @@ pgmoneta_read_main_configuration(void* shm, char* filename)
                      unknown = true;
                   }
                }
+               else if (!strcmp(key, "s3_part_size"))
+               {
+                  if (!strcmp(section, "pgmoneta"))
+                  {
+                     if (as_bytes(value, &config->s3_part_size, 16 * 1024 * 1024))
+                     {
+                        unknown = true;
+                     }
+                  }
+                  else
+                  {
+                     unknown = true;
+                  }
+               }
+               else if (!strcmp(key, "s3_download_concurrency"))
+               {
+                  if (!strcmp(section, "pgmoneta"))
+                  {
+                     if (as_int(value, &config->s3_download_concurrency))
+                     {
+                        unknown = true;
+                     }
+                  }
+                  else
+                  {
+                     unknown = true;
+                  }
+               }
+               else if (!strcmp(key, "wal_bundle_size"))
+               {
+                  if (!strcmp(section, "pgmoneta"))
+                  {
+                     if (as_bytes64(value, &config->wal_bundle_size, 0))
+                     {
+                        unknown = true;
+                     }
+                  }
+                  else
+                  {
+                     unknown = true;
+                  }
+               }
+               else if (!strcmp(key, "wal_bundle_timeout"))
+               {
+                  if (!strcmp(section, "pgmoneta"))
+                  {
+                     if (as_seconds(value, &config->wal_bundle_timeout, PGMONETA_TIME_MIN(5)))
+                     {
+                        unknown = true;
+                     }
+                  }
+                  else
+                  {
+                     unknown = true;
+                  }
+               }
+               else if (!strcmp(key, "azure_endpoint"))
+               {
+                  if (!strcmp(section, "pgmoneta"))
+                  {
+                     max = strlen(value);
+                     if (max > MISC_LENGTH - 1)
+                     {
+                        max = MISC_LENGTH - 1;
+                     }
+                     memcpy(config->azure_endpoint, value, max);
+                  }
+                  else
+                  {
+                     unknown = true;
+                  }
+               }
+               else if (!strcmp(key, "azure_port"))
+               {
+                  if (!strcmp(section, "pgmoneta"))
+                  {
+                     if (as_int(value, &config->azure_port))
+                     {
+                        unknown = true;
+                     }
+                  }
+                  else
+                  {
+                     unknown = true;
+                  }
+               }
+               else if (!strcmp(key, "azure_use_tls"))
+               {
+                  if (!strcmp(section, "pgmoneta"))
+                  {
+                     if (as_bool(value, &config->azure_use_tls))
+                     {
+                        unknown = true;
+                     }
+                  }
+                  else
+                  {
+                     unknown = true;
+                  }
+               }
+               else if (!strcmp(key, "azure_block_size"))
+               {
+                  if (!strcmp(section, "pgmoneta"))
+                  {
+                     if (as_bytes(value, &config->azure_block_size, 8 * 1024 * 1024))
+                     {
+                        unknown = true;
+                     }
+                  }
+                  else
+                  {
+                     unknown = true;
+                  }
+               }
                else if (!strcmp(key, "workspace"))
                {
                   if (!strcmp(section, "pgmoneta"))
@@ -1631,16 +1808,248 @@ pgmoneta_read_main_configuration(void* shm, char* filename)
                         unknown = true;
                      }
                   }
-                  else if (strlen(section) > 0)
+                  else if (strlen(section) > 0)
+                  {
+                     srv.retention_days = -1;
+                     srv.retention_weeks = -1;
+                     srv.retention_months = -1;
+                     srv.retention_years = -1;
+                     if (as_retention(value, &srv.retention_days,
+                                      &srv.retention_weeks,
+                                      &srv.retention_months,
+                                      &srv.retention_years))
+                     {
+                        unknown = true;
+                     }
+                  }
+                  else
+                  {
+                     unknown = true;
+                  }
+               }
+               else if (!strcmp(key, "retention_interval"))
+               {
+                  if (!strcmp(section, "pgmoneta"))
+                  {
+                     if (as_int(value, &config->retention_interval))
+                     {
+                        unknown = true;
+                     }
+                  }
+                  else
+                  {
+                     unknown = true;
+                  }
+               }
+               else if (!strcmp(key, "encryption"))
+               {
+                  if (!strcmp(section, "pgmoneta"))
+                  {
+                     if (as_encryption_mode(value, &config->common.encryption) != 0)
+                     {
+                        unknown = true;
+                     }
+                  }
+                  else
+                  {
+                     unknown = true;
+                  }
+               }
+               else if (!strcmp(key, "io_max_rate"))
+               {
+                  if (!strcmp(section, "pgmoneta"))
+                  {
+                     if (as_bytes64(value, &config->io_max_rate, 0))
+                     {
+                        unknown = true;
+                     }
+                  }
+                  else
+                  {
+                     unknown = true;
+                  }
+               }
+               else if (!strcmp(key, "io_max_iops"))
+               {
+                  if (!strcmp(section, "pgmoneta"))
+                  {
+                     if (as_int(value, &config->io_max_iops))
+                     {
+                        unknown = true;
+                     }
+                  }
+                  else
+                  {
+                     unknown = true;
+                  }
+               }
+               else if (!strcmp(key, "max_rate"))
+               {
+                  if (!strcmp(section, "pgmoneta"))
+                  {
+                     if (as_int(value, &config->max_rate))
+                     {
+                        unknown = true;
+                     }
+                  }
+                  else if (strlen(section) > 0)
+                  {
+                     max = strlen(section);
+                     if (max > MISC_LENGTH - 1)
+                     {
+                        max = MISC_LENGTH - 1;
+                     }
+                     memcpy(&srv.name, section, max);
+                     if (as_int(value, &srv.max_rate))
+                     {
+                        unknown = true;
+                     }
+                  }
+                  else
+                  {
+                     unknown = true;
+                  }
+               }
+               else if (!strcmp(key, "socket_rcvbuf"))
+               {
+                  if (!strcmp(section, "pgmoneta"))
+                  {
+                     if (as_bytes(value, &config->socket_rcvbuf, 0))
+                     {
+                        unknown = true;
+                     }
+                  }
+                  else if (strlen(section) > 0)
+                  {
+                     max = strlen(section);
+                     if (max > MISC_LENGTH - 1)
+                     {
+                        max = MISC_LENGTH - 1;
+                     }
+                     memcpy(&srv.name, section, max);
+                     if (as_bytes(value, &srv.socket_rcvbuf, 0))
+                     {
+                        unknown = true;
+                     }
+                  }
+                  else
+                  {
+                     unknown = true;
+                  }
+               }
+               else if (!strcmp(key, "socket_sndbuf"))
+               {
+                  if (!strcmp(section, "pgmoneta"))
+                  {
+                     if (as_bytes(value, &config->socket_sndbuf, 0))
+                     {
+                        unknown = true;
+                     }
+                  }
+                  else if (strlen(section) > 0)
+                  {
+                     max = strlen(section);
+                     if (max > MISC_LENGTH - 1)
+                     {
+                        max = MISC_LENGTH - 1;
+                     }
+                     memcpy(&srv.name, section, max);
+                     if (as_bytes(value, &srv.socket_sndbuf, 0))
+                     {
+                        unknown = true;
+                     }
+                  }
+                  else
+                  {
+                     unknown = true;
+                  }
+               }
+               else if (!strcmp(key, "tcp_window_clamp"))
+               {
+                  if (!strcmp(section, "pgmoneta"))
+                  {
+                     if (as_bytes(value, &config->tcp_window_clamp, 0))
+                     {
+                        unknown = true;
+                     }
+                  }
+                  else if (strlen(section) > 0)
+                  {
+                     max = strlen(section);
+                     if (max > MISC_LENGTH - 1)
+                     {
+                        max = MISC_LENGTH - 1;
+                     }
+                     memcpy(&srv.name, section, max);
+                     if (as_bytes(value, &srv.tcp_window_clamp, 0))
+                     {
+                        unknown = true;
+                     }
+                  }
+                  else
+                  {
+                     unknown = true;
+                  }
+               }
+               else if (!strcmp(key, "tcp_notsent_lowat"))
+               {
+                  if (!strcmp(section, "pgmoneta"))
+                  {
+                     if (as_bytes(value, &config->tcp_notsent_lowat, 0))
+                     {
+                        unknown = true;
+                     }
+                  }
+                  else if (strlen(section) > 0)
+                  {
+                     max = strlen(section);
+                     if (max > MISC_LENGTH - 1)
+                     {
+                        max = MISC_LENGTH - 1;
+                     }
+                     memcpy(&srv.name, section, max);
+                     if (as_bytes(value, &srv.tcp_notsent_lowat, 0))
+                     {
+                        unknown = true;
+                     }
+                  }
+                  else
+                  {
+                     unknown = true;
+                  }
+               }
+               else if (!strcmp(key, "busy_poll"))
+               {
+                  if (!strcmp(section, "pgmoneta"))
+                  {
+                     if (as_int(value, &config->busy_poll))
+                     {
+                        unknown = true;
+                     }
+                  }
+                  else if (strlen(section) > 0)
+                  {
+                     max = strlen(section);
+                     if (max > MISC_LENGTH - 1)
+                     {
+                        max = MISC_LENGTH - 1;
+                     }
+                     memcpy(&srv.name, section, max);
+                     if (as_int(value, &srv.busy_poll))
+                     {
+                        unknown = true;
+                     }
+                  }
+                  else
                   {
-                     srv.retention_days = -1;
-                     srv.retention_weeks = -1;
-                     srv.retention_months = -1;
-                     srv.retention_years = -1;
-                     if (as_retention(value, &srv.retention_days,
-                                      &srv.retention_weeks,
-                                      &srv.retention_months,
-                                      &srv.retention_years))
+                     unknown = true;
+                  }
+               }
+               else if (!strcmp(key, "verification"))
+               {
+                  if (!strcmp(section, "pgmoneta"))
+                  {
+                     if (as_seconds(value, &config->verification, PGMONETA_TIME_DISABLED))
                      {
                         unknown = true;
                      }
@@ -1650,11 +2059,11 @@ pgmoneta_read_main_configuration(void* shm, char* filename)
                      unknown = true;
                   }
                }
-               else if (!strcmp(key, "retention_interval"))
+               else if (!strcmp(key, "verification_budget"))
                {
                   if (!strcmp(section, "pgmoneta"))
                   {
-                     if (as_int(value, &config->retention_interval))
+                     if (as_bytes64(value, &config->verification_budget, 0))
                      {
                         unknown = true;
                      }
@@ -1664,11 +2073,11 @@ pgmoneta_read_main_configuration(void* shm, char* filename)
                      unknown = true;
                   }
                }
-               else if (!strcmp(key, "encryption"))
+               else if (!strcmp(key, "tree_hash"))
                {
                   if (!strcmp(section, "pgmoneta"))
                   {
-                     if (as_encryption_mode(value, &config->common.encryption) != 0)
+                     if (as_bool(value, &config->tree_hash))
                      {
                         unknown = true;
                      }
@@ -1678,24 +2087,25 @@ pgmoneta_read_main_configuration(void* shm, char* filename)
                      unknown = true;
                   }
                }
-               else if (!strcmp(key, "max_rate"))
+               else if (!strcmp(key, "chunk_store"))
                {
                   if (!strcmp(section, "pgmoneta"))
                   {
-                     if (as_int(value, &config->max_rate))
+                     if (as_bool(value, &config->chunk_store))
                      {
                         unknown = true;
                      }
                   }
-                  else if (strlen(section) > 0)
+                  else
                   {
-                     max = strlen(section);
-                     if (max > MISC_LENGTH - 1)
-                     {
-                        max = MISC_LENGTH - 1;
-                     }
-                     memcpy(&srv.name, section, max);
-                     if (as_int(value, &srv.max_rate))
+                     unknown = true;
+                  }
+               }
+               else if (!strcmp(key, "chunk_store_shared"))
+               {
+                  if (!strcmp(section, "pgmoneta"))
+                  {
+                     if (as_bool(value, &config->chunk_store_shared))
                      {
                         unknown = true;
                      }
@@ -1705,11 +2115,11 @@ pgmoneta_read_main_configuration(void* shm, char* filename)
                      unknown = true;
                   }
                }
-               else if (!strcmp(key, "verification"))
+               else if (!strcmp(key, "link_paranoid"))
                {
                   if (!strcmp(section, "pgmoneta"))
                   {
-                     if (as_seconds(value, &config->verification, PGMONETA_TIME_DISABLED))
+                     if (as_bool(value, &config->link_paranoid))
                      {
                         unknown = true;
                      }
@@ -1915,6 +2325,18 @@ pgmoneta_validate_main_configuration(void* shm)
       config->workers = 0;
    }
 
+   if (config->io_max_iops < 0)
+   {
+      pgmoneta_log_warn("io_max_iops must be at least 0, using 0");
+      config->io_max_iops = 0;
+   }
+
+   if (config->busy_poll < 0)
+   {
+      pgmoneta_log_warn("busy_poll must be at least 0, using 0");
+      config->busy_poll = 0;
+   }
+
    if (strlen(config->metrics_cert_file) > 0)
    {
       if (!pgmoneta_exists(config->metrics_cert_file))
@@ -1998,6 +2420,42 @@ pgmoneta_validate_main_configuration(void* shm)
          pgmoneta_log_fatal("ssh_private_key_file does not exist: %s", config->ssh_private_key_file);
          return 1;
       }
+
+      if (config->ssh_inflight < 1)
+      {
+         pgmoneta_log_warn("ssh_inflight must be at least 1, using 1");
+         config->ssh_inflight = 1;
+      }
+   }
+
+   if (config->storage_engine & STORAGE_ENGINE_S3)
+   {
+      if (config->s3_part_size < 1024 * 1024)
+      {
+         pgmoneta_log_warn("s3_part_size must be at least 1MB, using 1MB");
+         config->s3_part_size = 1024 * 1024;
+      }
+
+      if (config->s3_download_concurrency < 1)
+      {
+         pgmoneta_log_warn("s3_download_concurrency must be at least 1, using 1");
+         config->s3_download_concurrency = 1;
+      }
+
+      if (config->wal_bundle_size > 0 && config->wal_bundle_size < 16 * 1024 * 1024)
+      {
+         pgmoneta_log_warn("wal_bundle_size must be at least 16MB, using 16MB");
+         config->wal_bundle_size = 16 * 1024 * 1024;
+      }
+   }
+
+   if (config->storage_engine & STORAGE_ENGINE_AZURE)
+   {
+      if (config->azure_block_size < 64 * 1024)
+      {
+         pgmoneta_log_warn("azure_block_size must be at least 64KB, using 64KB");
+         config->azure_block_size = 64 * 1024;
+      }
    }
 
    for (int i = 0; i < config->common.number_of_servers; i++)
@@ -2065,6 +2523,11 @@ pgmoneta_validate_main_configuration(void* shm)
       {
          config->common.servers[i].max_rate = -1;
       }
+
+      if (config->common.servers[i].busy_poll < -1)
+      {
+         config->common.servers[i].busy_poll = -1;
+      }
    }
 
    if (pgmoneta_time_convert(config->verification, FORMAT_TIME_S) < 0)
@@ -2072,6 +2535,7 @@ pgmoneta_validate_main_configuration(void* shm)
       pgmoneta_log_fatal("verification cannot be less than 0");
       return 1;
    }
+
    return 0;
 }
 
@@ -3531,6 +3995,30 @@ to_direct_io(char* where, int value)
    return 0;
 }
 
+static int
+to_tls_ktls(char* where, int value)
+{
+   if (!where)
+   {
+      return 1;
+   }
+   switch (value)
+   {
+      case TLS_KTLS_OFF:
+         snprintf(where, MISC_LENGTH, "%s", "off");
+         break;
+      case TLS_KTLS_AUTO:
+         snprintf(where, MISC_LENGTH, "%s", "auto");
+         break;
+      case TLS_KTLS_ON:
+         snprintf(where, MISC_LENGTH, "%s", "on");
+         break;
+      default:
+         return 1;
+   }
+   return 0;
+}
+
 static int
 to_log_type(char* where, int value)
 {
@@ -3655,6 +4143,10 @@ add_configuration_response(struct json* res)
    pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_COMPRESSION_LEVEL, (uintptr_t)config->compression_level, ValueInt64);
    pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_WORKERS, (uintptr_t)config->workers, ValueInt64);
    pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_PROGRESS, (uintptr_t)config->progress, ValueBool);
+   pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_TREE_HASH, (uintptr_t)config->tree_hash, ValueBool);
+   pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_CHUNK_STORE, (uintptr_t)config->chunk_store, ValueBool);
+   pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_CHUNK_STORE_SHARED, (uintptr_t)config->chunk_store_shared, ValueBool);
+   pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_LINK_PARANOID, (uintptr_t)config->link_paranoid, ValueBool);
    pgmoneta_json_put_enum_value(res, CONFIGURATION_ARGUMENT_STORAGE_ENGINE, config->storage_engine, to_storage_engine);
    pgmoneta_json_put_enum_value(res, CONFIGURATION_ARGUMENT_ENCRYPTION, config->common.encryption, to_encryption);
    pgmoneta_json_put_enum_value(res, CONFIGURATION_ARGUMENT_CREATE_SLOT, config->create_slot, to_create_slot);
@@ -3664,8 +4156,13 @@ add_configuration_response(struct json* res)
    pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_SSH_CIPHERS, (uintptr_t)config->ssh_ciphers, ValueString);
    pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_SSH_PUBLIC_KEY_FILE, (uintptr_t)config->ssh_public_key_file, ValueString);
    pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_SSH_PRIVATE_KEY_FILE, (uintptr_t)config->ssh_private_key_file, ValueString);
+   pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_SSH_INFLIGHT, (uintptr_t)config->ssh_inflight, ValueInt64);
    pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_S3_USE_TLS, (uintptr_t)config->s3.use_tls, ValueInt32);
    pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_S3_STORAGE_CLASS, (uintptr_t)config->s3.storage_class, ValueString);
+   pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_S3_PART_SIZE, (uintptr_t)config->s3_part_size, ValueInt64);
+   pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_S3_DOWNLOAD_CONCURRENCY, (uintptr_t)config->s3_download_concurrency, ValueInt64);
+   pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_WAL_BUNDLE_SIZE, (uintptr_t)config->wal_bundle_size, ValueUInt64);
+   pgmoneta_json_put_time_value(res, CONFIGURATION_ARGUMENT_WAL_BUNDLE_TIMEOUT, config->wal_bundle_timeout, FORMAT_TIME_S);
    pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_S3_ENDPOINT, (uintptr_t)config->s3.endpoint, ValueString);
    pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_S3_PORT, (uintptr_t)config->s3.port, ValueInt32);
    pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_S3_REGION, (uintptr_t)config->s3.region, ValueString);
@@ -3677,6 +4174,10 @@ add_configuration_response(struct json* res)
    pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_AZURE_STORAGE_ACCOUNT, (uintptr_t)config->azure_storage_account, ValueString);
    pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_AZURE_CONTAINER, (uintptr_t)config->azure_container, ValueString);
    pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_AZURE_SHARED_KEY, (uintptr_t)config->azure_shared_key, ValueString);
+   pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_AZURE_ENDPOINT, (uintptr_t)config->azure_endpoint, ValueString);
+   pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_AZURE_PORT, (uintptr_t)config->azure_port, ValueInt32);
+   pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_AZURE_USE_TLS, (uintptr_t)config->azure_use_tls, ValueInt32);
+   pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_AZURE_BLOCK_SIZE, (uintptr_t)config->azure_block_size, ValueInt64);
    pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_WORKSPACE, (uintptr_t)config->workspace, ValueString);
    pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_RETENTION, (uintptr_t)ret, ValueString);
    pgmoneta_json_put_enum_value(res, CONFIGURATION_ARGUMENT_LOG_TYPE, config->common.log_type, to_log_type);
@@ -3690,17 +4191,25 @@ add_configuration_response(struct json* res)
    pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_TLS, (uintptr_t)config->tls, ValueBool);
    pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_TLS_CERT_FILE, (uintptr_t)config->tls_cert_file, ValueString);
    pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_TLS_CA_FILE, (uintptr_t)config->tls_ca_file, ValueString);
+   pgmoneta_json_put_enum_value(res, CONFIGURATION_ARGUMENT_TLS_KTLS, config->tls_ktls, to_tls_ktls);
    pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_TLS_KEY_FILE, (uintptr_t)config->tls_key_file, ValueString);
    pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_METRICS_CERT_FILE, (uintptr_t)config->metrics_cert_file, ValueString);
    pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_METRICS_KEY_FILE, (uintptr_t)config->metrics_key_file, ValueString);
    pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_METRICS_CA_FILE, (uintptr_t)config->metrics_ca_file, ValueString);
    pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_LIBEV, (uintptr_t)config->libev, ValueString);
    pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_MAX_RATE, (uintptr_t)config->max_rate, ValueInt64);
+   pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_IO_MAX_RATE, (uintptr_t)config->io_max_rate, ValueUInt64);
+   pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_IO_MAX_IOPS, (uintptr_t)config->io_max_iops, ValueInt64);
    pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_MANIFEST, (uintptr_t)"SHA512", ValueString);
    pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_KEEP_ALIVE, (uintptr_t)config->common.keep_alive, ValueBool);
    pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_NODELAY, (uintptr_t)config->common.nodelay, ValueBool);
    pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_NON_BLOCKING, (uintptr_t)config->common.non_blocking, ValueBool);
    pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_BACKLOG, (uintptr_t)config->backlog, ValueInt64);
+   pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_SOCKET_RCVBUF, (uintptr_t)config->socket_rcvbuf, ValueInt64);
+   pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_SOCKET_SNDBUF, (uintptr_t)config->socket_sndbuf, ValueInt64);
+   pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_TCP_WINDOW_CLAMP, (uintptr_t)config->tcp_window_clamp, ValueInt64);
+   pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_TCP_NOTSENT_LOWAT, (uintptr_t)config->tcp_notsent_lowat, ValueInt64);
+   pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_BUSY_POLL, (uintptr_t)config->busy_poll, ValueInt64);
    pgmoneta_json_put_enum_value(res, CONFIGURATION_ARGUMENT_HUGEPAGE, config->hugepage, to_hugepage);
    pgmoneta_json_put_enum_value(res, CONFIGURATION_ARGUMENT_DIRECT_IO, config->direct_io, to_direct_io);
    pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_PIDFILE, (uintptr_t)config->pidfile, ValueString);
@@ -3709,6 +4218,7 @@ add_configuration_response(struct json* res)
    pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_USER_CONF_PATH, (uintptr_t)config->common.users_path, ValueString);
    pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_ADMIN_CONF_PATH, (uintptr_t)config->common.admins_path, ValueString);
    pgmoneta_json_put_time_value(res, CONFIGURATION_ARGUMENT_VERIFICATION, config->verification, FORMAT_TIME_S);
+   pgmoneta_json_put(res, CONFIGURATION_ARGUMENT_VERIFICATION_BUDGET, (uintptr_t)config->verification_budget, ValueUInt64);
 
    free(ret);
 }
@@ -3784,6 +4294,11 @@ add_servers_configuration_response(struct json* res)
       pgmoneta_json_put(server_conf, CONFIGURATION_ARGUMENT_HOT_STANDBY_TABLESPACES, (uintptr_t)config->common.servers[i].hot_standby_tablespaces, ValueString);
       pgmoneta_json_put(server_conf, CONFIGURATION_ARGUMENT_WORKERS, (uintptr_t)config->common.servers[i].workers, ValueInt64);
       pgmoneta_json_put(server_conf, CONFIGURATION_ARGUMENT_MAX_RATE, (uintptr_t)config->common.servers[i].max_rate, ValueInt64);
+      pgmoneta_json_put(server_conf, CONFIGURATION_ARGUMENT_SOCKET_RCVBUF, (uintptr_t)config->common.servers[i].socket_rcvbuf, ValueInt64);
+      pgmoneta_json_put(server_conf, CONFIGURATION_ARGUMENT_SOCKET_SNDBUF, (uintptr_t)config->common.servers[i].socket_sndbuf, ValueInt64);
+      pgmoneta_json_put(server_conf, CONFIGURATION_ARGUMENT_TCP_WINDOW_CLAMP, (uintptr_t)config->common.servers[i].tcp_window_clamp, ValueInt64);
+      pgmoneta_json_put(server_conf, CONFIGURATION_ARGUMENT_TCP_NOTSENT_LOWAT, (uintptr_t)config->common.servers[i].tcp_notsent_lowat, ValueInt64);
+      pgmoneta_json_put(server_conf, CONFIGURATION_ARGUMENT_BUSY_POLL, (uintptr_t)config->common.servers[i].busy_poll, ValueInt64);
       pgmoneta_json_put(server_conf, CONFIGURATION_ARGUMENT_PROGRESS, pgmoneta_is_progress_enabled(i), ValueBool);
       pgmoneta_json_put(server_conf, CONFIGURATION_ARGUMENT_MANIFEST, (uintptr_t)"SHA512", ValueString);
       pgmoneta_json_put(server_conf, CONFIGURATION_ARGUMENT_TLS_CERT_FILE, (uintptr_t)config->common.servers[i].tls_cert_file, ValueString);
@@ -4384,6 +4899,41 @@ apply_main_configuration(struct main_configuration* config, struct server* srv,
             unknown = true;
          }
       }
+      else if (!strcmp(key, "socket_rcvbuf"))
+      {
+         if (as_bytes(value, &srv->socket_rcvbuf, 0))
+         {
+            unknown = true;
+         }
+      }
+      else if (!strcmp(key, "socket_sndbuf"))
+      {
+         if (as_bytes(value, &srv->socket_sndbuf, 0))
+         {
+            unknown = true;
+         }
+      }
+      else if (!strcmp(key, "tcp_window_clamp"))
+      {
+         if (as_bytes(value, &srv->tcp_window_clamp, 0))
+         {
+            unknown = true;
+         }
+      }
+      else if (!strcmp(key, "tcp_notsent_lowat"))
+      {
+         if (as_bytes(value, &srv->tcp_notsent_lowat, 0))
+         {
+            unknown = true;
+         }
+      }
+      else if (!strcmp(key, "busy_poll"))
+      {
+         if (as_int(value, &srv->busy_poll))
+         {
+            unknown = true;
+         }
+      }
       else if (!strcmp(key, "retention"))
       {
          srv->retention_days = -1;
@@ -4499,6 +5049,41 @@ apply_main_configuration(struct main_configuration* config, struct server* srv,
             unknown = true;
          }
       }
+      else if (!strcmp(key, "socket_rcvbuf"))
+      {
+         if (as_bytes(value, &config->socket_rcvbuf, 0))
+         {
+            unknown = true;
+         }
+      }
+      else if (!strcmp(key, "socket_sndbuf"))
+      {
+         if (as_bytes(value, &config->socket_sndbuf, 0))
+         {
+            unknown = true;
+         }
+      }
+      else if (!strcmp(key, "tcp_window_clamp"))
+      {
+         if (as_bytes(value, &config->tcp_window_clamp, 0))
+         {
+            unknown = true;
+         }
+      }
+      else if (!strcmp(key, "tcp_notsent_lowat"))
+      {
+         if (as_bytes(value, &config->tcp_notsent_lowat, 0))
+         {
+            unknown = true;
+         }
+      }
+      else if (!strcmp(key, "busy_poll"))
+      {
+         if (as_int(value, &config->busy_poll))
+         {
+            unknown = true;
+         }
+      }
       else if (!strcmp(key, "verification"))
       {
          if (as_seconds(value, &config->verification, PGMONETA_TIME_DISABLED))
@@ -4506,6 +5091,13 @@ apply_main_configuration(struct main_configuration* config, struct server* srv,
             unknown = true;
          }
       }
+      else if (!strcmp(key, "verification_budget"))
+      {
+         if (as_bytes64(value, &config->verification_budget, 0))
+         {
+            unknown = true;
+         }
+      }
       else if (!strcmp(key, "blocking_timeout"))
       {
          if (as_seconds(value, &config->blocking_timeout, PGMONETA_TIME_SEC(DEFAULT_BLOCKING_TIMEOUT)))
@@ -4538,6 +5130,27 @@ apply_main_configuration(struct main_configuration* config, struct server* srv,
             config->progress = false;
          }
       }
+      else if (!strcmp(key, "tree_hash"))
+      {
+         if (as_bool(value, &config->tree_hash))
+         {
+            unknown = true;
+         }
+      }
+      else if (!strcmp(key, "chunk_store"))
+      {
+         if (as_bool(value, &config->chunk_store))
+         {
+            unknown = true;
+         }
+      }
+      else if (!strcmp(key, "link_paranoid"))
+      {
+         if (as_bool(value, &config->link_paranoid))
+         {
+            unknown = true;
+         }
+      }
       else
       {
          unknown = true;
@@ -4624,10 +5237,34 @@ write_config_value(char* buffer, char* config_key, size_t buffer_size)
          {
             pgmoneta_snprintf(buffer, buffer_size, "%d", config->max_rate);
          }
+         else if (!strcmp(key_info.key, "socket_rcvbuf"))
+         {
+            pgmoneta_snprintf(buffer, buffer_size, "%d", config->socket_rcvbuf);
+         }
+         else if (!strcmp(key_info.key, "socket_sndbuf"))
+         {
+            pgmoneta_snprintf(buffer, buffer_size, "%d", config->socket_sndbuf);
+         }
+         else if (!strcmp(key_info.key, "tcp_window_clamp"))
+         {
+            pgmoneta_snprintf(buffer, buffer_size, "%d", config->tcp_window_clamp);
+         }
+         else if (!strcmp(key_info.key, "tcp_notsent_lowat"))
+         {
+            pgmoneta_snprintf(buffer, buffer_size, "%d", config->tcp_notsent_lowat);
+         }
+         else if (!strcmp(key_info.key, "busy_poll"))
+         {
+            pgmoneta_snprintf(buffer, buffer_size, "%d", config->busy_poll);
+         }
          else if (!strcmp(key_info.key, "verification"))
          {
             pgmoneta_snprintf(buffer, buffer_size, "%" PRId64, pgmoneta_time_convert(config->verification, FORMAT_TIME_S));
          }
+         else if (!strcmp(key_info.key, "verification_budget"))
+         {
+            pgmoneta_snprintf(buffer, buffer_size, "%" PRIu64, config->verification_budget);
+         }
          else if (!strcmp(key_info.key, "retention"))
          {
             char* ret = get_retention_string(config->retention_days, config->retention_weeks, config->retention_months, config->retention_years);
@@ -4638,6 +5275,22 @@ write_config_value(char* buffer, char* config_key, size_t buffer_size)
          {
             pgmoneta_snprintf(buffer, buffer_size, "%s", config->progress ? "on" : "off");
          }
+         else if (!strcmp(key_info.key, "tree_hash"))
+         {
+            pgmoneta_snprintf(buffer, buffer_size, "%s", config->tree_hash ? "on" : "off");
+         }
+         else if (!strcmp(key_info.key, "chunk_store"))
+         {
+            pgmoneta_snprintf(buffer, buffer_size, "%s", config->chunk_store ? "on" : "off");
+         }
+         else if (!strcmp(key_info.key, "chunk_store_shared"))
+         {
+            pgmoneta_snprintf(buffer, buffer_size, "%s", config->chunk_store_shared ? "on" : "off");
+         }
+         else if (!strcmp(key_info.key, "link_paranoid"))
+         {
+            pgmoneta_snprintf(buffer, buffer_size, "%s", config->link_paranoid ? "on" : "off");
+         }
          else
          {
             pgmoneta_log_debug("Unknown main configuration key: %s", key_info.key);
@@ -4687,6 +5340,26 @@ write_config_value(char* buffer, char* config_key, size_t buffer_size)
                {
                   pgmoneta_snprintf(buffer, buffer_size, "%d", srv->max_rate);
                }
+               else if (!strcmp(key_info.key, "socket_rcvbuf"))
+               {
+                  pgmoneta_snprintf(buffer, buffer_size, "%d", srv->socket_rcvbuf);
+               }
+               else if (!strcmp(key_info.key, "socket_sndbuf"))
+               {
+                  pgmoneta_snprintf(buffer, buffer_size, "%d", srv->socket_sndbuf);
+               }
+               else if (!strcmp(key_info.key, "tcp_window_clamp"))
+               {
+                  pgmoneta_snprintf(buffer, buffer_size, "%d", srv->tcp_window_clamp);
+               }
+               else if (!strcmp(key_info.key, "tcp_notsent_lowat"))
+               {
+                  pgmoneta_snprintf(buffer, buffer_size, "%d", srv->tcp_notsent_lowat);
+               }
+               else if (!strcmp(key_info.key, "busy_poll"))
+               {
+                  pgmoneta_snprintf(buffer, buffer_size, "%d", srv->busy_poll);
+               }
                else if (!strcmp(key_info.key, "retention"))
                {
                   char* ret = get_retention_string(srv->retention_days, srv->retention_weeks, srv->retention_months, srv->retention_years);
@@ -5217,6 +5890,27 @@ as_direct_io(char* str)
    return DIRECT_IO_OFF;
 }
 
+static int
+as_tls_ktls(char* str)
+{
+   if (!strcasecmp(str, "off"))
+   {
+      return TLS_KTLS_OFF;
+   }
+
+   if (!strcasecmp(str, "auto"))
+   {
+      return TLS_KTLS_AUTO;
+   }
+
+   if (!strcasecmp(str, "on"))
+   {
+      return TLS_KTLS_ON;
+   }
+
+   return TLS_KTLS_OFF;
+}
+
 static int
 as_compression(char* str)
 {
@@ -5744,11 +6438,28 @@ error:
 static int
 as_bytes(char* str, int* bytes, int default_bytes)
 {
-   int multiplier = 1;
+   uint64_t value = 0;
+
+   if (as_bytes64(str, &value, (uint64_t)default_bytes) || value > INT_MAX)
+   {
+      *bytes = default_bytes;
+      return 1;
+   }
+
+   *bytes = (int)value;
+
+   return 0;
+}
+
+static int
+as_bytes64(char* str, uint64_t* bytes, uint64_t default_bytes)
+{
+   uint64_t multiplier = 1;
    int index;
    char value[MISC_LENGTH];
    bool multiplier_set = false;
-   int i_value = default_bytes;
+   char* end = NULL;
+   unsigned long long u_value = 0;
 
    if (is_empty_string(str))
    {
@@ -5761,6 +6472,10 @@ as_bytes(char* str, int* bytes, int default_bytes)
    {
       if (isdigit(str[i]))
       {
+         if (index >= MISC_LENGTH - 1)
+         {
+            goto error;
+         }
          value[index++] = str[i];
       }
       else if (isalpha(str[i]) && multiplier_set)
@@ -5786,6 +6501,11 @@ as_bytes(char* str, int* bytes, int default_bytes)
             multiplier = 1024 * 1024 * 1024;
             multiplier_set = true;
          }
+         else if (str[i] == 'T' || str[i] == 't')
+         {
+            multiplier = 1024ULL * 1024 * 1024 * 1024;
+            multiplier_set = true;
+         }
          else if (str[i] == 'K' || str[i] == 'k')
          {
             multiplier = 1024;
@@ -5805,27 +6525,26 @@ as_bytes(char* str, int* bytes, int default_bytes)
    }
 
    value[index] = '\0';
-   if (!as_int(value, &i_value))
+   if (index == 0)
    {
-      // sanity check: the value
-      // must be a positive number!
-      if (i_value >= 0)
-      {
-         *bytes = i_value * multiplier;
-      }
-      else
-      {
-         goto error;
-      }
-
-      return 0;
+      goto error;
    }
-   else
+
+   errno = 0;
+   u_value = strtoull(value, &end, 10);
+   if (errno != 0 || *end != '\0' || u_value > UINT64_MAX / multiplier)
    {
-error:
-      *bytes = default_bytes;
-      return 1;
+      errno = 0;
+      goto error;
    }
+
+   *bytes = (uint64_t)u_value * multiplier;
+
+   return 0;
+
+error:
+   *bytes = default_bytes;
+   return 1;
 }
 
 static int
@@ -6099,6 +6818,7 @@ transfer_configuration(struct main_configuration* config, struct main_configurat
    {
       changed = true;
    }
+   config->tls_ktls = reload->tls_ktls;
    if (restart_string("metrics_cert_file", config->metrics_cert_file, reload->metrics_cert_file))
    {
       changed = true;
@@ -6178,7 +6898,22 @@ transfer_configuration(struct main_configuration* config, struct main_configurat
 
    config->workers = reload->workers;
    config->progress = reload->progress;
+   config->tree_hash = reload->tree_hash;
+   config->chunk_store = reload->chunk_store;
+   if (restart_bool("chunk_store_shared", config->chunk_store_shared, reload->chunk_store_shared))
+   {
+      changed = true;
+   }
+   config->link_paranoid = reload->link_paranoid;
+   config->verification_budget = reload->verification_budget;
    config->max_rate = reload->max_rate;
+   config->io_max_rate = reload->io_max_rate;
+   config->socket_rcvbuf = reload->socket_rcvbuf;
+   config->socket_sndbuf = reload->socket_sndbuf;
+   config->tcp_window_clamp = reload->tcp_window_clamp;
+   config->tcp_notsent_lowat = reload->tcp_notsent_lowat;
+   config->busy_poll = reload->busy_poll;
+   config->io_max_iops = reload->io_max_iops;
 
    /* prometheus */
    atomic_init(&config->common.prometheus.logging_info, 0);
@@ -6274,6 +7009,11 @@ copy_server(struct server* dst, struct server* src)
    dst->workers = src->workers;
    dst->progress = src->progress;
    dst->max_rate = src->max_rate;
+   dst->socket_rcvbuf = src->socket_rcvbuf;
+   dst->socket_sndbuf = src->socket_sndbuf;
+   dst->tcp_window_clamp = src->tcp_window_clamp;
+   dst->tcp_notsent_lowat = src->tcp_notsent_lowat;
+   dst->busy_poll = src->busy_poll;
 
    if (restart_string("tls_cert_file", dst->tls_cert_file, src->tls_cert_file))
    {
@@ -878,7 +878,7 @@ error:
 static int
 console_generate_json(struct console_page* console, char** json, size_t* json_size)
 {
-   char* json_buffer = NULL;
+   struct string_builder* json_buffer = NULL;
    int status = 0;
 
    if (console == NULL || json == NULL || json_size == NULL)
@@ -888,7 +888,13 @@ console_generate_json(struct console_page* console, char** json, size_t* json_si
       goto error;
    }
 
-   json_buffer = pgmoneta_append(json_buffer, "{\"categories\":[");
+   if (pgmoneta_string_builder_create(0, &json_buffer))
+   {
+      status = 1;
+      goto error;
+   }
+
+   pgmoneta_string_builder_append(json_buffer, "{\"categories\":[");
 
    for (int i = 0; i < console->category_count; i++)
    {
@@ -896,12 +902,12 @@ console_generate_json(struct console_page* console, char** json, size_t* json_si
 
       if (i > 0)
       {
-         json_buffer = pgmoneta_append(json_buffer, ",");
+         pgmoneta_string_builder_append(json_buffer, ",");
       }
 
-      json_buffer = pgmoneta_format_and_append(json_buffer,
-                                               "{\"name\":\"%s\",\"metrics\":[",
-                                               cat->name);
+      pgmoneta_string_builder_format(json_buffer,
+                                     "{\"name\":\"%s\",\"metrics\":[",
+                                     cat->name);
 
       for (int j = 0; j < cat->metric_count; j++)
       {
@@ -909,31 +915,28 @@ console_generate_json(struct console_page* console, char** json, size_t* json_si
 
          if (j > 0)
          {
-            json_buffer = pgmoneta_append(json_buffer, ",");
+            pgmoneta_string_builder_append(json_buffer, ",");
          }
 
-         json_buffer = pgmoneta_format_and_append(json_buffer,
-                                                  "{\"name\":\"%s\",\"type\":\"%s\",\"value\":%.2f}",
-                                                  metric->name,
-                                                  metric->type,
-                                                  metric->value);
+         pgmoneta_string_builder_format(json_buffer,
+                                        "{\"name\":\"%s\",\"type\":\"%s\",\"value\":%.2f}",
+                                        metric->name,
+                                        metric->type,
+                                        metric->value);
       }
 
-      json_buffer = pgmoneta_append(json_buffer, "]}");
+      pgmoneta_string_builder_append(json_buffer, "]}");
    }
 
-   json_buffer = pgmoneta_append(json_buffer, "]}");
+   pgmoneta_string_builder_append(json_buffer, "]}");
 
-   *json = json_buffer;
-   *json_size = strlen(json_buffer);
+   *json_size = json_buffer->length;
+   *json = pgmoneta_string_builder_release(json_buffer);
 
    return 0;
 
 error:
-   if (json_buffer != NULL)
-   {
-      free(json_buffer);
-   }
+   pgmoneta_string_builder_destroy(json_buffer);
    return status;
 }
 
@@ -1792,7 +1795,7 @@ find_best_category(const char* metric_name, char** categories, int category_coun
 static char*
 generate_metrics_table(struct console_category* category)
 {
-   char* table_html = NULL;
+   struct string_builder* table_html = NULL;
    char** label_keys = NULL;
    int label_key_count = 0;
 
@@ -1801,23 +1804,28 @@ generate_metrics_table(struct console_category* category)
       return pgmoneta_append(NULL, "<p>No metrics</p>\n");
    }
 
+   if (pgmoneta_string_builder_create(0, &table_html))
+   {
+      return NULL;
+   }
+
    if (collect_simple_label_columns(category, &label_keys, &label_key_count))
    {
       pgmoneta_log_warn("Failed to collect simple view label columns for category %s", category->name != NULL ? category->name : "unknown");
    }
 
-   table_html = pgmoneta_append(table_html,
-                                "<table class=\"metrics-table\">\n"
-                                "<tr><th class=\"col-name\">Name</th><th class=\"col-type\">Type</th><th class=\"col-value\">Value</th><th class=\"col-labels\">Labels</th>");
+   pgmoneta_string_builder_append(table_html,
+                                  "<table class=\"metrics-table\">\n"
+                                  "<tr><th class=\"col-name\">Name</th><th class=\"col-type\">Type</th><th class=\"col-value\">Value</th><th class=\"col-labels\">Labels</th>");
 
    for (int i = 0; i < label_key_count; i++)
    {
-      table_html = pgmoneta_format_and_append(table_html,
-                                              "<th class=\"col-simple-label\">%s</th>",
-                                              label_keys[i]);
+      pgmoneta_string_builder_format(table_html,
+                                     "<th class=\"col-simple-label\">%s</th>",
+                                     label_keys[i]);
    }
 
-   table_html = pgmoneta_append(table_html, "</tr>\n");
+   pgmoneta_string_builder_append(table_html, "</tr>\n");
 
    for (int m_idx = 0; m_idx < category->metric_count; m_idx++)
    {
@@ -1857,28 +1865,28 @@ generate_metrics_table(struct console_category* category)
          pgmoneta_snprintf(value_str, sizeof(value_str), "%.2f", metric->value);
       }
 
-      table_html = pgmoneta_format_and_append(table_html,
-                                              "<tr data-server=\"%s\"><td class=\"col-name\">%s</td><td class=\"col-type\">%s</td><td class=\"col-value\">%s</td><td class=\"col-labels\">%s</td>",
-                                              metric->server != NULL ? metric->server : "all",
-                                              metric->name,
-                                              metric->type,
-                                              value_str,
-                                              labels_str != NULL ? labels_str : "");
+      pgmoneta_string_builder_format(table_html,
+                                     "<tr data-server=\"%s\"><td class=\"col-name\">%s</td><td class=\"col-type\">%s</td><td class=\"col-value\">%s</td><td class=\"col-labels\">%s</td>",
+                                     metric->server != NULL ? metric->server : "all",
+                                     metric->name,
+                                     metric->type,
+                                     value_str,
+                                     labels_str != NULL ? labels_str : "");
 
       for (int k = 0; k < label_key_count; k++)
       {
          const char* label_value = find_metric_label_value(metric, label_keys[k]);
-         table_html = pgmoneta_format_and_append(table_html,
-                                                 "<td class=\"col-simple-label\">%s</td>",
-                                                 label_value != NULL ? label_value : "");
+         pgmoneta_string_builder_format(table_html,
+                                        "<td class=\"col-simple-label\">%s</td>",
+                                        label_value != NULL ? label_value : "");
       }
 
-      table_html = pgmoneta_append(table_html, "</tr>\n");
+      pgmoneta_string_builder_append(table_html, "</tr>\n");
 
       free(labels_str);
    }
 
-   table_html = pgmoneta_append(table_html, "</table>\n");
+   pgmoneta_string_builder_append(table_html, "</table>\n");
 
    if (label_keys != NULL)
    {
@@ -1889,7 +1897,7 @@ generate_metrics_table(struct console_category* category)
       free(label_keys);
    }
 
-   return table_html;
+   return pgmoneta_string_builder_release(table_html);
 }
 
 static int
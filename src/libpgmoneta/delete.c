@@ -45,9 +45,10 @@
  * @param srv The server
  * @param srv_wal The oldest wal segment file we would like to keep
  * @param base The base directory holding the wal segments
+ * @param usage The disk usage of the base directory
  */
 static void
-delete_wal_older_than(int srv, char* srv_wal, char* base);
+delete_wal_older_than(int srv, char* srv_wal, char* base, int usage);
 
 int
 pgmoneta_delete(int srv, char* label)
@@ -135,7 +136,7 @@ pgmoneta_delete_wal(int srv)
    if (backup == NULL)
    {
       d = pgmoneta_get_server_wal(srv);
-      delete_wal_older_than(srv, srv_wal, d);
+      delete_wal_older_than(srv, srv_wal, d, USAGE_WAL);
       free(d);
       d = NULL;
 
@@ -143,7 +144,7 @@ pgmoneta_delete_wal(int srv)
       wal_shipping = pgmoneta_get_server_wal_shipping_wal(srv);
       if (wal_shipping != NULL)
       {
-         delete_wal_older_than(srv, srv_wal, wal_shipping);
+         delete_wal_older_than(srv, srv_wal, wal_shipping, USAGE_WAL_SHIPPING_WAL);
       }
 
       free(wal_shipping);
@@ -169,7 +170,7 @@ error:
 }
 
 static void
-delete_wal_older_than(int srv, char* srv_wal, char* base)
+delete_wal_older_than(int srv, char* srv_wal, char* base, int usage)
 {
    struct deque* wal_files = NULL;
    struct deque_iterator* iter = NULL;
@@ -222,6 +223,7 @@ delete_wal_older_than(int srv, char* srv_wal, char* base)
             pgmoneta_log_trace("WAL: Deleting %s", wal_address);
             if (pgmoneta_exists(wal_address))
             {
+               pgmoneta_usage_add(srv, usage, -(int64_t)pgmoneta_get_file_size(wal_address));
                pgmoneta_delete_file(wal_address, NULL);
             }
             else
@@ -29,11 +29,14 @@
 #include <pgmoneta.h>
 #include <deque.h>
 #include <logging.h>
+#include <memory.h>
 #include <utils.h>
 
 #include <stdlib.h>
 #include <string.h>
 
+#define DEQUE_RING_CAPACITY 16
+
 // tag is copied if not NULL
 static void
 deque_offer(struct deque* deque, char* tag, uintptr_t data, enum value_type type, struct value_config* config);
@@ -85,11 +88,52 @@ deque_merge(struct deque_node* node1, struct deque_node* node2, compare_cb cmp);
 static int
 tag_compare(char* tag1, char* tag2);
 
+static struct value*
+deque_find_value(struct deque* deque, char* tag);
+
+// tag is copied or interned if not NULL
+static void
+ring_offer(struct deque* deque, char* tag, uintptr_t data, enum value_type type, struct value_config* config);
+
+static struct deque_slot*
+ring_slot(struct deque* deque, uint32_t index);
+
+static void
+ring_unwrap(struct deque* deque, struct deque_slot* slots);
+
+static int
+ring_grow(struct deque* deque);
+
+static uintptr_t
+ring_poll(struct deque* deque, bool last, char** tag);
+
+static uintptr_t
+ring_peek(struct deque* deque, bool last, char** tag);
+
+static void
+ring_remove(struct deque* deque, uint32_t index);
+
+static void
+ring_clear(struct deque* deque);
+
+static void
+ring_sort(struct deque* deque, compare_cb cmp);
+
+static void
+ring_merge_sort(struct deque_slot* slots, struct deque_slot* tmp, uint32_t n, compare_cb cmp);
+
+static char*
+tag_copy(struct deque* deque, char* tag);
+
+static void
+tag_free(struct deque* deque, char* tag);
+
 int
 pgmoneta_deque_create(bool thread_safe, struct deque** deque)
 {
    struct deque* q = NULL;
    q = malloc(sizeof(struct deque));
+   memset(q, 0, sizeof(struct deque));
    q->size = 0;
    q->thread_safe = thread_safe;
    if (thread_safe)
@@ -104,6 +148,55 @@ pgmoneta_deque_create(bool thread_safe, struct deque** deque)
    return 0;
 }
 
+int
+pgmoneta_deque_create_ring(bool thread_safe, uint32_t capacity, bool intern_tags, struct deque** deque)
+{
+   struct deque* q = NULL;
+   uint32_t cap = DEQUE_RING_CAPACITY;
+
+   *deque = NULL;
+
+   while (cap < capacity && cap <= UINT32_MAX / 2)
+   {
+      cap <<= 1;
+   }
+
+   q = malloc(sizeof(struct deque));
+   if (q == NULL)
+   {
+      goto error;
+   }
+   memset(q, 0, sizeof(struct deque));
+
+   q->slots = malloc((size_t)cap * sizeof(struct deque_slot));
+   if (q->slots == NULL)
+   {
+      goto error;
+   }
+   q->capacity = cap;
+   q->intern_tags = intern_tags;
+   if (intern_tags && pgmoneta_memory_region_create(0, &q->tags))
+   {
+      goto error;
+   }
+   q->thread_safe = thread_safe;
+   if (thread_safe)
+   {
+      pthread_rwlock_init(&q->mutex, NULL);
+   }
+
+   *deque = q;
+   return 0;
+
+error:
+   if (q != NULL)
+   {
+      free(q->slots);
+   }
+   free(q);
+   return 1;
+}
+
 int
 pgmoneta_deque_add(struct deque* deque, char* tag, uintptr_t data, enum value_type type)
 {
@@ -141,6 +234,13 @@ pgmoneta_deque_clear(struct deque* deque)
    {
       return 0;
    }
+   if (deque->slots != NULL)
+   {
+      deque_write_lock(deque);
+      ring_clear(deque);
+      deque_unlock(deque);
+      return 0;
+   }
    pgmoneta_deque_iterator_create(deque, &iter);
    while (pgmoneta_deque_iterator_next(iter))
    {
@@ -167,6 +267,10 @@ pgmoneta_deque_poll(struct deque* deque, char** tag)
    {
       return 0;
    }
+   if (deque->slots != NULL)
+   {
+      return ring_poll(deque, false, tag);
+   }
    deque_write_lock(deque);
    head = deque->start->next;
    // this should not happen when size is not 0, but just in case
@@ -184,6 +288,10 @@ pgmoneta_deque_poll(struct deque* deque, char** tag)
    {
       *tag = head->tag;
    }
+   else
+   {
+      free(head->tag);
+   }
    free(head);
 
    data = pgmoneta_value_data(val);
@@ -203,6 +311,10 @@ pgmoneta_deque_poll_last(struct deque* deque, char** tag)
    {
       return 0;
    }
+   if (deque->slots != NULL)
+   {
+      return ring_poll(deque, true, tag);
+   }
    deque_write_lock(deque);
    tail = deque->end->prev;
    if (tail == deque->start)
@@ -220,6 +332,10 @@ pgmoneta_deque_poll_last(struct deque* deque, char** tag)
    {
       *tag = tail->tag;
    }
+   else
+   {
+      free(tail->tag);
+   }
    free(tail);
 
    data = pgmoneta_value_data(val);
@@ -238,6 +354,10 @@ pgmoneta_deque_peek(struct deque* deque, char** tag)
    {
       return 0;
    }
+   if (deque->slots != NULL)
+   {
+      return ring_peek(deque, false, tag);
+   }
    deque_read_lock(deque);
    head = deque->start->next;
    // this should not happen when size is not 0, but just in case
@@ -264,6 +384,10 @@ pgmoneta_deque_peek_last(struct deque* deque, char** tag)
    {
       return 0;
    }
+   if (deque->slots != NULL)
+   {
+      return ring_peek(deque, true, tag);
+   }
    deque_read_lock(deque);
    tail = deque->end->prev;
    // this should not happen when size is not 0, but just in case
@@ -284,16 +408,16 @@ pgmoneta_deque_peek_last(struct deque* deque, char** tag)
 uintptr_t
 pgmoneta_deque_get(struct deque* deque, char* tag)
 {
-   struct deque_node* n = NULL;
+   struct value* v = NULL;
    uintptr_t ret = 0;
 
    deque_read_lock(deque);
-   n = deque_find(deque, tag);
-   if (n == NULL)
+   v = deque_find_value(deque, tag);
+   if (v == NULL)
    {
       goto error;
    }
-   ret = pgmoneta_value_data(n->data);
+   ret = pgmoneta_value_data(v);
    deque_unlock(deque);
    return ret;
 error:
@@ -305,12 +429,12 @@ bool
 pgmoneta_deque_exists(struct deque* deque, char* tag)
 {
    bool ret = false;
-   struct deque_node* n = NULL;
+   struct value* v = NULL;
 
    deque_read_lock(deque);
 
-   n = deque_find(deque, tag);
-   if (n != NULL)
+   v = deque_find_value(deque, tag);
+   if (v != NULL)
    {
       ret = true;
    }
@@ -342,6 +466,12 @@ void
 pgmoneta_deque_sort(struct deque* deque, compare_cb compare)
 {
    deque_write_lock(deque);
+   if (deque != NULL && deque->slots != NULL && deque->size > 1)
+   {
+      ring_sort(deque, compare);
+      deque_unlock(deque);
+      return;
+   }
    if (deque == NULL || deque->start == NULL || deque->end == NULL || deque->size <= 1)
    {
       deque_unlock(deque);
@@ -383,6 +513,12 @@ pgmoneta_deque_destroy(struct deque* deque)
       deque_node_destroy(n);
       n = next;
    }
+   if (deque->slots != NULL)
+   {
+      ring_clear(deque);
+      free(deque->slots);
+      pgmoneta_memory_region_destroy(deque->tags);
+   }
    if (deque->thread_safe)
    {
       pthread_rwlock_destroy(&deque->mutex);
@@ -444,6 +580,7 @@ pgmoneta_deque_iterator_create(struct deque* deque, struct deque_iterator** iter
    i = malloc(sizeof(struct deque_iterator));
    i->deque = deque;
    i->cur = deque->start;
+   i->index = -1;
    i->tag = NULL;
    i->value = NULL;
    *iter = i;
@@ -453,6 +590,27 @@ pgmoneta_deque_iterator_create(struct deque* deque, struct deque_iterator** iter
 void
 pgmoneta_deque_iterator_remove(struct deque_iterator* iter)
 {
+   struct deque_slot* slot = NULL;
+
+   if (iter != NULL && iter->deque != NULL && iter->deque->slots != NULL)
+   {
+      if (iter->index < 0 || iter->index >= (int64_t)iter->deque->size)
+      {
+         return;
+      }
+      ring_remove(iter->deque, (uint32_t)iter->index);
+      iter->index--;
+      if (iter->index < 0)
+      {
+         iter->value = NULL;
+         iter->tag = NULL;
+         return;
+      }
+      slot = ring_slot(iter->deque, (uint32_t)iter->index);
+      iter->value = &slot->data;
+      iter->tag = slot->tag;
+      return;
+   }
    if (iter == NULL || iter->cur == NULL || iter->deque == NULL ||
        iter->cur == iter->deque->start || iter->cur == iter->deque->end)
    {
@@ -483,10 +641,25 @@ pgmoneta_deque_iterator_destroy(struct deque_iterator* iter)
 bool
 pgmoneta_deque_iterator_next(struct deque_iterator* iter)
 {
+   struct deque_slot* slot = NULL;
+
    if (iter == NULL)
    {
       return false;
    }
+   if (iter->deque->slots != NULL)
+   {
+      if (iter->index + 1 >= (int64_t)iter->deque->size)
+      {
+         iter->index = iter->deque->size;
+         return false;
+      }
+      iter->index++;
+      slot = ring_slot(iter->deque, (uint32_t)iter->index);
+      iter->value = &slot->data;
+      iter->tag = slot->tag;
+      return true;
+   }
    iter->cur = deque_next(iter->deque, iter->cur);
    if (iter->cur == NULL)
    {
@@ -504,6 +677,10 @@ pgmoneta_deque_iterator_has_next(struct deque_iterator* iter)
    {
       return false;
    }
+   if (iter->deque->slots != NULL)
+   {
+      return iter->index + 1 < (int64_t)iter->deque->size;
+   }
    return deque_next(iter->deque, iter->cur) != NULL;
 }
 
@@ -518,6 +695,12 @@ deque_offer(struct deque* deque, char* tag, uintptr_t data, enum value_type type
       return;
    }
 
+   if (deque->slots != NULL)
+   {
+      ring_offer(deque, tag, data, type, config);
+      return;
+   }
+
    deque_node_create(data, type, tag, config, &n);
    deque_write_lock(deque);
    deque->size++;
@@ -637,101 +820,113 @@ deque_find(struct deque* deque, char* tag)
 static char*
 to_json_string(struct deque* deque, char* tag, int indent)
 {
-   char* ret = NULL;
-   ret = pgmoneta_indent(ret, tag, indent);
-   struct deque_node* cur = NULL;
+   struct string_builder* sb = NULL;
+   if (pgmoneta_string_builder_create(0, &sb))
+   {
+      return NULL;
+   }
+   pgmoneta_string_builder_indent(sb, tag, indent);
+   struct deque_iterator* iter = NULL;
    if (deque == NULL || pgmoneta_deque_empty(deque))
    {
-      ret = pgmoneta_append(ret, "[]");
-      return ret;
+      pgmoneta_string_builder_append(sb, "[]");
+      return pgmoneta_string_builder_release(sb);
    }
    deque_read_lock(deque);
-   ret = pgmoneta_append(ret, "[\n");
-   cur = deque_next(deque, deque->start);
-   while (cur != NULL)
+   pgmoneta_string_builder_append(sb, "[\n");
+   pgmoneta_deque_iterator_create(deque, &iter);
+   while (pgmoneta_deque_iterator_next(iter))
    {
-      bool has_next = cur->next != deque->end;
+      bool has_next = pgmoneta_deque_iterator_has_next(iter);
       char* str = NULL;
       char* t = NULL;
-      if (cur->tag != NULL)
+      if (iter->tag != NULL)
       {
-         t = pgmoneta_append(t, cur->tag);
+         t = pgmoneta_append(t, iter->tag);
          t = pgmoneta_append(t, ": ");
       }
-      str = pgmoneta_value_to_string(cur->data, FORMAT_JSON, t, indent + INDENT_PER_LEVEL);
+      str = pgmoneta_value_to_string(iter->value, FORMAT_JSON, t, indent + INDENT_PER_LEVEL);
       free(t);
-      ret = pgmoneta_append(ret, str);
-      ret = pgmoneta_append(ret, has_next ? ",\n" : "\n");
+      pgmoneta_string_builder_append(sb, str);
+      pgmoneta_string_builder_append(sb, has_next ? ",\n" : "\n");
       free(str);
-      cur = deque_next(deque, cur);
    }
-   ret = pgmoneta_indent(ret, NULL, indent);
-   ret = pgmoneta_append(ret, "]");
+   pgmoneta_deque_iterator_destroy(iter);
+   pgmoneta_string_builder_indent(sb, NULL, indent);
+   pgmoneta_string_builder_append(sb, "]");
    deque_unlock(deque);
-   return ret;
+   return pgmoneta_string_builder_release(sb);
 }
 
 static char*
 to_compact_json_string(struct deque* deque, char* tag, int indent)
 {
-   char* ret = NULL;
-   ret = pgmoneta_indent(ret, tag, indent);
-   struct deque_node* cur = NULL;
+   struct string_builder* sb = NULL;
+   if (pgmoneta_string_builder_create(0, &sb))
+   {
+      return NULL;
+   }
+   pgmoneta_string_builder_indent(sb, tag, indent);
+   struct deque_iterator* iter = NULL;
    if (deque == NULL || pgmoneta_deque_empty(deque))
    {
-      ret = pgmoneta_append(ret, "[]");
-      return ret;
+      pgmoneta_string_builder_append(sb, "[]");
+      return pgmoneta_string_builder_release(sb);
    }
    deque_read_lock(deque);
-   ret = pgmoneta_append(ret, "[");
-   cur = deque_next(deque, deque->start);
-   while (cur != NULL)
+   pgmoneta_string_builder_append(sb, "[");
+   pgmoneta_deque_iterator_create(deque, &iter);
+   while (pgmoneta_deque_iterator_next(iter))
    {
-      bool has_next = cur->next != deque->end;
+      bool has_next = pgmoneta_deque_iterator_has_next(iter);
       char* str = NULL;
       char* t = NULL;
-      if (cur->tag != NULL)
+      if (iter->tag != NULL)
       {
-         t = pgmoneta_append(t, cur->tag);
+         t = pgmoneta_append(t, iter->tag);
          t = pgmoneta_append(t, ":");
       }
-      str = pgmoneta_value_to_string(cur->data, FORMAT_JSON_COMPACT, t, indent);
+      str = pgmoneta_value_to_string(iter->value, FORMAT_JSON_COMPACT, t, indent);
       free(t);
-      ret = pgmoneta_append(ret, str);
-      ret = pgmoneta_append(ret, has_next ? "," : "");
+      pgmoneta_string_builder_append(sb, str);
+      pgmoneta_string_builder_append(sb, has_next ? "," : "");
       free(str);
-      cur = deque_next(deque, cur);
    }
-   ret = pgmoneta_append(ret, "]");
+   pgmoneta_deque_iterator_destroy(iter);
+   pgmoneta_string_builder_append(sb, "]");
    deque_unlock(deque);
-   return ret;
+   return pgmoneta_string_builder_release(sb);
 }
 
 static char*
 to_text_string(struct deque* deque, char* tag, int indent)
 {
-   char* ret = NULL;
+   struct string_builder* sb = NULL;
    int cnt = 0;
    int next_indent = pgmoneta_compare_string(tag, BULLET_POINT) ? 0 : indent;
+   if (pgmoneta_string_builder_create(0, &sb))
+   {
+      return NULL;
+   }
    // we have a tag and it's not the bullet point, so that means another line
    if (tag != NULL && !pgmoneta_compare_string(tag, BULLET_POINT))
    {
-      ret = pgmoneta_indent(ret, tag, indent);
+      pgmoneta_string_builder_indent(sb, tag, indent);
       next_indent += INDENT_PER_LEVEL;
    }
-   struct deque_node* cur = NULL;
+   struct deque_iterator* iter = NULL;
    if (deque == NULL || pgmoneta_deque_empty(deque))
    {
-      ret = pgmoneta_append(ret, "[]");
-      return ret;
+      pgmoneta_string_builder_append(sb, "[]");
+      return pgmoneta_string_builder_release(sb);
    }
    deque_read_lock(deque);
-   cur = deque_next(deque, deque->start);
-   while (cur != NULL)
+   pgmoneta_deque_iterator_create(deque, &iter);
+   while (pgmoneta_deque_iterator_next(iter))
    {
-      bool has_next = cur->next != deque->end;
+      bool has_next = pgmoneta_deque_iterator_has_next(iter);
       char* str = NULL;
-      str = pgmoneta_value_to_string(cur->data, FORMAT_TEXT, BULLET_POINT, next_indent);
+      str = pgmoneta_value_to_string(iter->value, FORMAT_TEXT, BULLET_POINT, next_indent);
       if (cnt == 0)
       {
          cnt++;
@@ -740,17 +935,17 @@ to_text_string(struct deque* deque, char* tag, int indent)
             next_indent = indent + INDENT_PER_LEVEL;
          }
       }
-      if (cur->data->type == ValueJSON)
+      if (iter->value->type == ValueJSON)
       {
-         ret = pgmoneta_indent(ret, BULLET_POINT, next_indent);
+         pgmoneta_string_builder_indent(sb, BULLET_POINT, next_indent);
       }
-      ret = pgmoneta_append(ret, str);
-      ret = pgmoneta_append(ret, has_next ? "\n" : "");
+      pgmoneta_string_builder_append(sb, str);
+      pgmoneta_string_builder_append(sb, has_next ? "\n" : "");
       free(str);
-      cur = deque_next(deque, cur);
    }
+   pgmoneta_deque_iterator_destroy(iter);
    deque_unlock(deque);
-   return ret;
+   return pgmoneta_string_builder_release(sb);
 }
 
 static struct deque_node*
@@ -901,3 +1096,291 @@ tag_compare(char* tag1, char* tag2)
    }
    return strcmp(tag1, tag2);
 }
+
+static struct value*
+deque_find_value(struct deque* deque, char* tag)
+{
+   struct deque_node* n = NULL;
+   struct deque_slot* slot = NULL;
+
+   if (deque != NULL && deque->slots != NULL)
+   {
+      if (tag == NULL || strlen(tag) == 0)
+      {
+         return NULL;
+      }
+      for (uint32_t i = 0; i < deque->size; i++)
+      {
+         slot = ring_slot(deque, i);
+         if (pgmoneta_compare_string(tag, slot->tag))
+         {
+            return &slot->data;
+         }
+      }
+      return NULL;
+   }
+
+   n = deque_find(deque, tag);
+   return n != NULL ? n->data : NULL;
+}
+
+static void
+ring_offer(struct deque* deque, char* tag, uintptr_t data, enum value_type type, struct value_config* config)
+{
+   struct deque_slot* slot = NULL;
+
+   deque_write_lock(deque);
+   if (deque->size == deque->capacity && ring_grow(deque))
+   {
+      pgmoneta_log_error("Unable to grow deque to %u entries", deque->size + 1);
+      deque_unlock(deque);
+      return;
+   }
+   slot = ring_slot(deque, deque->size);
+   pgmoneta_value_init(type, data, config, &slot->data);
+   slot->tag = tag_copy(deque, tag);
+   deque->size++;
+   deque_unlock(deque);
+}
+
+static struct deque_slot*
+ring_slot(struct deque* deque, uint32_t index)
+{
+   return &deque->slots[(deque->head + index) & (deque->capacity - 1)];
+}
+
+static void
+ring_unwrap(struct deque* deque, struct deque_slot* slots)
+{
+   uint32_t first = deque->capacity - deque->head;
+
+   if (first > deque->size)
+   {
+      first = deque->size;
+   }
+   memcpy(slots, deque->slots + deque->head, first * sizeof(struct deque_slot));
+   memcpy(slots + first, deque->slots, (deque->size - first) * sizeof(struct deque_slot));
+}
+
+static int
+ring_grow(struct deque* deque)
+{
+   struct deque_slot* slots = NULL;
+
+   if (deque->capacity > UINT32_MAX / 2)
+   {
+      return 1;
+   }
+
+   slots = malloc((size_t)deque->capacity * 2 * sizeof(struct deque_slot));
+   if (slots == NULL)
+   {
+      return 1;
+   }
+
+   ring_unwrap(deque, slots);
+   free(deque->slots);
+   deque->slots = slots;
+   deque->capacity *= 2;
+   deque->head = 0;
+   return 0;
+}
+
+static uintptr_t
+ring_poll(struct deque* deque, bool last, char** tag)
+{
+   struct deque_slot* slot = NULL;
+   uintptr_t data = 0;
+
+   deque_write_lock(deque);
+   if (deque->size == 0)
+   {
+      deque_unlock(deque);
+      return 0;
+   }
+
+   if (last)
+   {
+      slot = ring_slot(deque, deque->size - 1);
+   }
+   else
+   {
+      slot = ring_slot(deque, 0);
+      deque->head = (deque->head + 1) & (deque->capacity - 1);
+   }
+   deque->size--;
+
+   if (tag != NULL)
+   {
+      // interned tags die with the deque, so hand out a copy
+      *tag = deque->intern_tags ? pgmoneta_append(NULL, slot->tag) : slot->tag;
+   }
+   else
+   {
+      tag_free(deque, slot->tag);
+   }
+
+   // the data is handed over to the caller, so the value is not released
+   data = pgmoneta_value_data(&slot->data);
+
+   deque_unlock(deque);
+   return data;
+}
+
+static uintptr_t
+ring_peek(struct deque* deque, bool last, char** tag)
+{
+   struct deque_slot* slot = NULL;
+   uintptr_t data = 0;
+
+   deque_read_lock(deque);
+   if (deque->size == 0)
+   {
+      deque_unlock(deque);
+      return 0;
+   }
+
+   slot = ring_slot(deque, last ? deque->size - 1 : 0);
+   if (tag != NULL)
+   {
+      *tag = slot->tag;
+   }
+   data = pgmoneta_value_data(&slot->data);
+
+   deque_unlock(deque);
+   return data;
+}
+
+static void
+ring_remove(struct deque* deque, uint32_t index)
+{
+   struct deque_slot* slot = ring_slot(deque, index);
+
+   pgmoneta_value_release(&slot->data);
+   tag_free(deque, slot->tag);
+
+   // close the gap from the shorter side
+   if (index < deque->size / 2)
+   {
+      for (uint32_t i = index; i > 0; i--)
+      {
+         *ring_slot(deque, i) = *ring_slot(deque, i - 1);
+      }
+      deque->head = (deque->head + 1) & (deque->capacity - 1);
+   }
+   else
+   {
+      for (uint32_t i = index; i + 1 < deque->size; i++)
+      {
+         *ring_slot(deque, i) = *ring_slot(deque, i + 1);
+      }
+   }
+   deque->size--;
+}
+
+static void
+ring_clear(struct deque* deque)
+{
+   struct deque_slot* slot = NULL;
+
+   for (uint32_t i = 0; i < deque->size; i++)
+   {
+      slot = ring_slot(deque, i);
+      pgmoneta_value_release(&slot->data);
+      tag_free(deque, slot->tag);
+   }
+   deque->size = 0;
+   deque->head = 0;
+
+   pgmoneta_memory_region_reset(deque->tags);
+}
+
+static void
+ring_sort(struct deque* deque, compare_cb cmp)
+{
+   struct deque_slot* slots = NULL;
+   struct deque_slot* tmp = NULL;
+
+   slots = malloc((size_t)deque->capacity * sizeof(struct deque_slot));
+   tmp = malloc((size_t)deque->size * sizeof(struct deque_slot));
+   if (slots == NULL || tmp == NULL)
+   {
+      pgmoneta_log_error("Unable to sort deque of %u entries", deque->size);
+      free(slots);
+      free(tmp);
+      return;
+   }
+
+   ring_unwrap(deque, slots);
+   free(deque->slots);
+   deque->slots = slots;
+   deque->head = 0;
+
+   ring_merge_sort(deque->slots, tmp, deque->size, cmp);
+
+   free(tmp);
+}
+
+static void
+ring_merge_sort(struct deque_slot* slots, struct deque_slot* tmp, uint32_t n, compare_cb cmp)
+{
+   uint32_t mid = n / 2;
+   uint32_t i = 0;
+   uint32_t j = mid;
+   uint32_t k = 0;
+   int cmp_result = 0;
+
+   if (n <= 1)
+   {
+      return;
+   }
+
+   ring_merge_sort(slots, tmp, mid, cmp);
+   ring_merge_sort(slots + mid, tmp, n - mid, cmp);
+
+   while (i < mid && j < n)
+   {
+      if (cmp != NULL)
+      {
+         cmp_result = cmp(&slots[i].data, &slots[j].data);
+      }
+      else
+      {
+         cmp_result = tag_compare(slots[i].tag, slots[j].tag);
+      }
+
+      tmp[k++] = cmp_result <= 0 ? slots[i++] : slots[j++];
+   }
+   while (i < mid)
+   {
+      tmp[k++] = slots[i++];
+   }
+
+   // whatever is left of the right half is already in place
+   memcpy(slots, tmp, k * sizeof(struct deque_slot));
+}
+
+static char*
+tag_copy(struct deque* deque, char* tag)
+{
+   if (tag == NULL)
+   {
+      return NULL;
+   }
+
+   if (!deque->intern_tags)
+   {
+      return pgmoneta_append(NULL, tag);
+   }
+
+   return pgmoneta_memory_region_strdup(deque->tags, tag);
+}
+
+static void
+tag_free(struct deque* deque, char* tag)
+{
+   if (!deque->intern_tags)
+   {
+      free(tag);
+   }
+}
@@ -27,6 +27,7 @@
  */
 
 /* pgmoneta */
+#include <chunk.h>
 #include <compression.h>
 #include <extraction.h>
 #include <logging.h>
@@ -647,9 +648,17 @@ pgmoneta_extract_backup_file(int server, char* label, char* relative_file_path,
    }
    from = pgmoneta_append(from, relative_file_path);
 
+   /* A chunked file is read from the rehydrated copy of its backup */
    if (!pgmoneta_exists(from))
    {
-      goto error;
+      free(from);
+      from = pgmoneta_chunk_get_rehydrated(server, label);
+      from = pgmoneta_append(from, relative_file_path);
+
+      if (from == NULL || !pgmoneta_exists(from))
+      {
+         goto error;
+      }
    }
 
    if (target_directory == NULL || strlen(target_directory) == 0)
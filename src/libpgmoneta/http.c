@@ -37,15 +37,22 @@
 
 /* system */
 #include <errno.h>
+#include <fcntl.h>
 #include <string.h>
 #include <unistd.h>
 #include <openssl/err.h>
+#ifdef HAVE_LINUX
+#include <sys/sendfile.h>
+#endif
+
+#define HTTP_FILE_BUFFER_SIZE 65536
 
 static int http_parse_header(char** header, struct http_response* http_response);
 static int http_read_response_body(SSL* ssl, int socket, struct http_response* http_response);
 static int http_read_response_header(SSL* ssl, int socket, char** header_text, struct http_response* http_response);
 static int http_build_request(struct http* connection, struct http_request* request, char** full_request, size_t* full_request_size);
 static char* http_method_to_string(int method);
+static int http_send_file(struct http* connection, struct http_request* request);
 
 int
 pgmoneta_http_create(char* hostname, int port, bool secure, struct http** result)
@@ -54,6 +61,10 @@ pgmoneta_http_create(char* hostname, int port, bool secure, struct http** result
    int socket_fd = -1;
    SSL* ssl = NULL;
    SSL_CTX* ctx = NULL;
+   struct socket_options options;
+   struct main_configuration* config;
+
+   config = (struct main_configuration*)shmem;
 
    if (hostname == NULL || result == NULL)
    {
@@ -72,7 +83,9 @@ pgmoneta_http_create(char* hostname, int port, bool secure, struct http** result
 
    memset(connection, 0, sizeof(struct http));
 
-   if (pgmoneta_connect(hostname, port, &socket_fd))
+   pgmoneta_socket_options(-1, &options);
+
+   if (pgmoneta_connect(hostname, port, &options, &socket_fd))
    {
       pgmoneta_log_error("Failed to connect to %s:%d", hostname, port);
       goto error;
@@ -85,7 +98,7 @@ pgmoneta_http_create(char* hostname, int port, bool secure, struct http** result
 
    if (secure)
    {
-      if (pgmoneta_create_ssl_ctx(true, &ctx))
+      if (pgmoneta_create_ssl_ctx(true, config->tls_ktls, &ctx))
       {
          pgmoneta_log_error("Failed to create SSL context");
          goto error;
@@ -137,6 +150,8 @@ pgmoneta_http_create(char* hostname, int port, bool secure, struct http** result
       }
       while (connect_result != 1);
 
+      pgmoneta_ssl_ktls_account(ssl, config->tls_ktls, hostname, &config->http_tls);
+
       connection->ssl = ssl;
    }
 
@@ -351,6 +366,36 @@ error:
    return PGMONETA_HTTP_STATUS_ERROR;
 }
 
+int
+pgmoneta_http_set_file(struct http_request* request, char* path, off_t offset, size_t size)
+{
+   if (request == NULL || path == NULL)
+   {
+      pgmoneta_log_error("Invalid request parameter");
+      goto error;
+   }
+
+   free(request->payload.data);
+   request->payload.data = NULL;
+   request->payload.data_size = 0;
+
+   free(request->file);
+   request->file = strdup(path);
+   if (request->file == NULL)
+   {
+      pgmoneta_log_error("Failed to allocate memory for request file");
+      goto error;
+   }
+
+   request->file_offset = offset;
+   request->file_size = size;
+
+   return PGMONETA_HTTP_STATUS_OK;
+
+error:
+   return PGMONETA_HTTP_STATUS_ERROR;
+}
+
 char*
 pgmoneta_http_get_response_header(struct http_response* response, char* name)
 {
@@ -436,6 +481,12 @@ req:
       goto error;
    }
 
+   if (request->file != NULL && request->file_size > HTTP_FILE_BUFFER_SIZE && http_send_file(connection, request))
+   {
+      pgmoneta_log_error("Failed to send %s", request->file);
+      goto error;
+   }
+
    status = http_read_response_header(connection->ssl, connection->socket, &header_text, http_response);
    if (status != MESSAGE_STATUS_OK)
    {
@@ -483,6 +534,7 @@ pgmoneta_http_request_destroy(struct http_request* request)
       free(request->path);
       pgmoneta_deque_destroy(request->payload.headers);
       free(request->payload.data);
+      free(request->file);
       free(request);
    }
 
@@ -505,8 +557,17 @@ pgmoneta_http_response_destroy(struct http_response* response)
 int
 pgmoneta_http_destroy(struct http* connection)
 {
+   struct main_configuration* config;
+
+   config = (struct main_configuration*)shmem;
+
    if (connection != NULL)
    {
+      if (connection->socket != -1)
+      {
+         pgmoneta_socket_statistics(connection->socket, true, &config->http_socket);
+      }
+
       if (connection->ssl != NULL)
       {
          pgmoneta_close_ssl(connection->ssl);
@@ -940,7 +1001,9 @@ http_build_request(struct http* connection, struct http_request* request, char**
    char* user_agent = NULL;
    char content_length[32];
    size_t header_len = 0;
+   size_t body_len = 0;
    size_t total_len = 0;
+   int fd = -1;
 
    if (connection == NULL || request == NULL || full_request == NULL || full_request_size == NULL)
    {
@@ -972,7 +1035,7 @@ http_build_request(struct http* connection, struct http_request* request, char**
 
    headers = pgmoneta_append(headers, "Connection: close\r\n");
 
-   sprintf(content_length, "%zu", request->payload.data_size);
+   sprintf(content_length, "%zu", request->file != NULL ? request->file_size : request->payload.data_size);
    headers = pgmoneta_append(headers, "Content-Length: ");
    headers = pgmoneta_append(headers, content_length);
    headers = pgmoneta_append(headers, "\r\n");
@@ -996,7 +1059,17 @@ http_build_request(struct http* connection, struct http_request* request, char**
    headers = pgmoneta_append(headers, "\r\n");
 
    header_len = strlen(request_line) + strlen(headers);
-   total_len = header_len + request->payload.data_size;
+
+   /* A small file goes out with the header, a large one is sent by http_send_file */
+   if (request->file != NULL)
+   {
+      body_len = request->file_size <= HTTP_FILE_BUFFER_SIZE ? request->file_size : 0;
+   }
+   else
+   {
+      body_len = request->payload.data_size;
+   }
+   total_len = header_len + body_len;
 
    *full_request = malloc(total_len + 1);
    if (*full_request == NULL)
@@ -1008,7 +1081,20 @@ http_build_request(struct http* connection, struct http_request* request, char**
    memcpy(*full_request, request_line, strlen(request_line));
    memcpy(*full_request + strlen(request_line), headers, strlen(headers));
 
-   if (request->payload.data_size > 0)
+   if (request->file != NULL && body_len > 0)
+   {
+      fd = open(request->file, O_RDONLY);
+      if (fd < 0 || pread(fd, *full_request + header_len, body_len, request->file_offset) != (ssize_t)body_len)
+      {
+         pgmoneta_log_error("Failed to read %s", request->file);
+         free(*full_request);
+         *full_request = NULL;
+         goto error;
+      }
+      close(fd);
+      fd = -1;
+   }
+   else if (request->payload.data_size > 0)
    {
       memcpy(*full_request + header_len, request->payload.data, request->payload.data_size);
    }
@@ -1023,6 +1109,10 @@ http_build_request(struct http* connection, struct http_request* request, char**
    return PGMONETA_HTTP_STATUS_OK;
 
 error:
+   if (fd >= 0)
+   {
+      close(fd);
+   }
    free(request_line);
    free(headers);
    free(user_agent);
@@ -1030,6 +1120,125 @@ error:
    return PGMONETA_HTTP_STATUS_ERROR;
 }
 
+static int
+http_send_file(struct http* connection, struct http_request* request)
+{
+   int fd = -1;
+   off_t offset = request->file_offset;
+   size_t remaining = request->file_size;
+   ssize_t numbytes = 0;
+   char* buffer = NULL;
+   struct message msg;
+
+   fd = open(request->file, O_RDONLY);
+   if (fd < 0)
+   {
+      goto error;
+   }
+
+   if (connection->ssl != NULL && (pgmoneta_ssl_ktls(connection->ssl) & KTLS_SEND))
+   {
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+      /* The kernel encrypts the records, so the file never enters user space */
+      while (remaining > 0)
+      {
+         numbytes = SSL_sendfile(connection->ssl, fd, offset, remaining, 0);
+         if (numbytes <= 0)
+         {
+            int err = SSL_get_error(connection->ssl, (int)numbytes);
+
+            if (err == SSL_ERROR_WANT_WRITE || err == SSL_ERROR_WANT_READ)
+            {
+               ERR_clear_error();
+               continue;
+            }
+
+            /* Nothing was sent yet, so the buffered path can take over */
+            if (offset == request->file_offset)
+            {
+               ERR_clear_error();
+               break;
+            }
+
+            goto error;
+         }
+
+         offset += numbytes;
+         remaining -= (size_t)numbytes;
+      }
+#endif
+   }
+#ifdef HAVE_LINUX
+   else if (connection->ssl == NULL)
+   {
+      while (remaining > 0)
+      {
+         numbytes = sendfile(connection->socket, fd, &offset, remaining);
+         if (numbytes < 0)
+         {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+            {
+               errno = 0;
+               continue;
+            }
+
+            goto error;
+         }
+         else if (numbytes == 0)
+         {
+            goto error;
+         }
+
+         remaining -= (size_t)numbytes;
+      }
+   }
+#endif
+
+   if (remaining > 0)
+   {
+      buffer = (char*)malloc(HTTP_FILE_BUFFER_SIZE);
+      if (buffer == NULL)
+      {
+         goto error;
+      }
+
+      while (remaining > 0)
+      {
+         numbytes = pread(fd, buffer, MIN(remaining, (size_t)HTTP_FILE_BUFFER_SIZE), offset);
+         if (numbytes <= 0)
+         {
+            goto error;
+         }
+
+         memset(&msg, 0, sizeof(struct message));
+         msg.data = buffer;
+         msg.length = numbytes;
+
+         if (pgmoneta_write_message(connection->ssl, connection->socket, &msg) != MESSAGE_STATUS_OK)
+         {
+            goto error;
+         }
+
+         offset += numbytes;
+         remaining -= (size_t)numbytes;
+      }
+   }
+
+   free(buffer);
+   close(fd);
+
+   return 0;
+
+error:
+   free(buffer);
+   if (fd >= 0)
+   {
+      close(fd);
+   }
+
+   return 1;
+}
+
 static char*
 http_method_to_string(int method)
 {
@@ -29,6 +29,7 @@
 /* pgmoneta */
 #include <assert.h>
 #include <pgmoneta.h>
+#include <art.h>
 #include <backup.h>
 #include <extraction.h>
 #include <info.h>
@@ -42,11 +43,15 @@
 
 /* system */
 #include <errno.h>
+#include <fcntl.h>
 #include <libgen.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <time.h>
 
 #define NAME "info"
 
@@ -74,6 +79,90 @@ file_final_name(char* file, int encryption, int compression, char** finalname);
 static int
 split_file_path(char* path, char** relative_path, char** bare_file_name);
 
+/**
+ * Read the keys of a backup until the end of the file, or a blank line
+ * @param file The file
+ * @param bck The backup
+ * @return 0 on success, 1 if otherwise
+ */
+static int
+read_backup(FILE* file, struct backup* bck);
+
+/**
+ * Write the keys of a backup
+ * @param sfile The file
+ * @param backup The backup
+ */
+static void
+write_backup(FILE* sfile, struct backup* backup);
+
+/**
+ * Lock the catalog of a directory
+ * @param directory The directory
+ * @return The file descriptor holding the lock, or -1 upon error
+ */
+static int
+catalog_lock(char* directory);
+
+/**
+ * Unlock the catalog of a directory
+ * @param fd The file descriptor holding the lock
+ */
+static void
+catalog_unlock(int fd);
+
+/**
+ * Read the catalog of a directory
+ * @param directory The directory
+ * @param records [out] The records keyed by label, or NULL if there is no catalog
+ * @return 0 on success, 1 if the catalog is corrupted
+ */
+static int
+catalog_read(char* directory, struct art** records);
+
+/**
+ * Write the catalog of a directory
+ * @param directory The directory
+ * @param number_of_backups The number of backups
+ * @param backups The backups
+ * @return 0 on success, 1 if otherwise
+ */
+static int
+catalog_write(char* directory, int number_of_backups, struct backup** backups);
+
+/**
+ * Update a backup in the catalog of a directory
+ * @param directory The directory
+ * @param backup The backup
+ * @return 0 on success, 1 if otherwise
+ */
+static int
+catalog_update(char* directory, struct backup* backup);
+
+/**
+ * Is the catalog of a directory stamped with the current state of the directory
+ * @param directory The directory
+ * @param mtime [out] The modification time of the directory
+ * @return True if no backup was added or removed since the catalog was stamped, otherwise false
+ */
+static bool
+catalog_current(char* directory, struct timespec* mtime);
+
+/**
+ * Stamp the catalog of a directory with the state of the directory it was built from
+ * @param directory The directory
+ * @param mtime The modification time of the directory before the scan
+ */
+static void
+catalog_stamp(char* directory, struct timespec* mtime);
+
+/**
+ * Destroy the records of a catalog
+ * @param records The records
+ */
+static void
+catalog_records_destroy(struct art* records);
+
 static void
 write_info(FILE* sfile, const char* fmt, ...);
 
@@ -352,10 +441,7 @@ error:
 int
 pgmoneta_load_infos(char* directory, int* number_of_backups, struct backup*** backups)
 {
-   char* d = NULL;
-   struct backup** bcks = NULL;
-   int number_of_bcks = 0;
-   char** dirs = NULL;
+   struct catalog* catalog = NULL;
 
 #ifdef DEBUG
    assert(directory != NULL);
@@ -365,81 +451,313 @@ pgmoneta_load_infos(char* directory, int* number_of_backups, struct backup*** ba
    *number_of_backups = 0;
    *backups = NULL;
 
-   pgmoneta_get_directories(directory, &number_of_bcks, &dirs);
+   if (pgmoneta_catalog_load(directory, &catalog))
+   {
+      goto error;
+   }
+
+   if (catalog->number_of_backups > 0)
+   {
+      *number_of_backups = catalog->number_of_backups;
+      *backups = catalog->backups;
+
+      catalog->number_of_backups = 0;
+      catalog->backups = NULL;
+   }
+
+   pgmoneta_catalog_destroy(catalog);
+
+   return 0;
+
+error:
+
+   pgmoneta_catalog_destroy(catalog);
+
+   return 1;
+}
+
+int
+pgmoneta_catalog_load(char* directory, struct catalog** catalog)
+{
+   int fd = -1;
+   bool locked = false;
+   bool changed = false;
+   bool current = false;
+   bool scanned = false;
+   bool complete = true;
+   int number_of_directories = 0;
+   char** dirs = NULL;
+   struct timespec mtime;
+   struct art* records = NULL;
+   struct art_iterator* iter = NULL;
+   struct backup* bck = NULL;
+   struct catalog* c = NULL;
+
+#ifdef DEBUG
+   assert(directory != NULL);
+   assert(strlen(directory) > 0);
+#endif
+
+   *catalog = NULL;
+
+   /* The directory is only scanned when a backup was added or removed since the catalog was stamped */
+   current = catalog_current(directory, &mtime);
 
-   if (number_of_bcks > 0)
+retry:
+
+   changed = false;
+   complete = true;
+
+   if (catalog_read(directory, &records))
+   {
+      pgmoneta_log_warn("Rebuilding the catalog in %s", directory);
+   }
+
+   if (records == NULL)
    {
-      bcks = (struct backup**)malloc(number_of_bcks * sizeof(struct backup*));
+      changed = true;
+      current = false;
 
-      if (bcks == NULL)
+      if (pgmoneta_art_create(&records))
       {
          goto error;
       }
+   }
+
+   if (!current && !scanned)
+   {
+      pgmoneta_get_directories(directory, &number_of_directories, &dirs);
+      scanned = true;
+   }
+
+   c = (struct catalog*)malloc(sizeof(struct catalog));
+
+   if (c == NULL)
+   {
+      goto error;
+   }
 
-      memset(bcks, 0, number_of_bcks * sizeof(struct backup*));
+   memset(c, 0, sizeof(struct catalog));
+
+   if (pgmoneta_art_create(&c->labels) || pgmoneta_art_create(&c->children))
+   {
+      goto error;
+   }
 
-      for (int i = 0; i < number_of_bcks; i++)
+   if (current)
+   {
+      if (records->size > 0)
       {
-         d = pgmoneta_append(d, directory);
+         c->backups = (struct backup**)malloc(records->size * sizeof(struct backup*));
 
-         if (pgmoneta_load_info(d, dirs[i], &bcks[i]))
+         if (c->backups == NULL || pgmoneta_art_iterator_create(records, &iter))
          {
-            pgmoneta_log_error("Unable to load backup for %s", d);
             goto error;
          }
 
-         free(d);
-         d = NULL;
+         /* The records are ordered by label, and now owned by the catalog */
+         while (pgmoneta_art_iterator_next(iter))
+         {
+            c->backups[c->number_of_backups++] = (struct backup*)iter->value->data;
+         }
+
+         pgmoneta_art_iterator_destroy(iter);
+         iter = NULL;
+      }
+
+      pgmoneta_art_destroy(records);
+      records = NULL;
+
+      goto index;
+   }
+
+   if (number_of_directories > 0)
+   {
+      c->backups = (struct backup**)malloc(number_of_directories * sizeof(struct backup*));
+
+      if (c->backups == NULL)
+      {
+         goto error;
       }
 
-      for (int i = 0; i < number_of_bcks; i++)
+      memset(c->backups, 0, number_of_directories * sizeof(struct backup*));
+   }
+
+   for (int i = 0; i < number_of_directories; i++)
+   {
+      bck = (struct backup*)pgmoneta_art_search(records, dirs[i]);
+
+      if (bck != NULL)
+      {
+         pgmoneta_art_delete(records, dirs[i]);
+      }
+      else
       {
-         free(dirs[i]);
+         if (pgmoneta_load_info(directory, dirs[i], &bck))
+         {
+            pgmoneta_log_error("Unable to load backup for %s%s", directory, dirs[i]);
+            goto error;
+         }
+
+         /* A backup in progress has no information yet, so it stays out of the catalog */
+         if (bck->valid != VALID_UNKNOWN)
+         {
+            changed = true;
+         }
+         else
+         {
+            complete = false;
+         }
       }
-      free(dirs);
+
+      c->backups[c->number_of_backups++] = bck;
+      bck = NULL;
    }
 
-   *number_of_backups = number_of_bcks;
-   *backups = bcks;
+   /* Records left over belong to backups that were deleted */
+   if (records->size > 0)
+   {
+      changed = true;
+   }
 
-   return 0;
+   if (changed && !locked)
+   {
+      /* Reconcile again under the lock as another process may have updated the catalog */
+      locked = true;
+      fd = catalog_lock(directory);
 
-error:
+      catalog_records_destroy(records);
+      records = NULL;
+      pgmoneta_catalog_destroy(c);
+      c = NULL;
 
-   free(d);
+      goto retry;
+   }
 
-   if (dirs != NULL)
+   if (changed && fd != -1)
    {
-      for (int i = 0; i < number_of_bcks; i++)
+      if (catalog_write(directory, c->number_of_backups, c->backups))
       {
-         free(dirs[i]);
+         pgmoneta_log_warn("Could not write the catalog in %s", directory);
+         complete = false;
       }
-      free(dirs);
    }
 
-   if (bcks != NULL)
+   /* A backup in progress is only found by a scan, so the catalog is not stamped while one exists */
+   if (complete && (!changed || fd != -1))
+   {
+      catalog_stamp(directory, &mtime);
+   }
+
+index:
+
+   for (int i = 0; i < c->number_of_backups; i++)
    {
-      for (int i = 0; i < number_of_bcks; i++)
+      if (pgmoneta_art_insert(c->labels, scanned ? dirs[i] : c->backups[i]->label, (uintptr_t)c->backups[i], ValueRef))
+      {
+         goto error;
+      }
+
+      /* Backups are ordered by label, so the first child found is the oldest */
+      if (strlen(c->backups[i]->parent_label) > 0 &&
+          !pgmoneta_art_contains_key(c->children, c->backups[i]->parent_label))
       {
-         free(bcks[i]);
+         if (pgmoneta_art_insert(c->children, c->backups[i]->parent_label, (uintptr_t)c->backups[i], ValueRef))
+         {
+            goto error;
+         }
       }
-      free(bcks);
    }
 
+   catalog_unlock(fd);
+   catalog_records_destroy(records);
+
+   for (int i = 0; i < number_of_directories; i++)
+   {
+      free(dirs[i]);
+   }
+   free(dirs);
+
+   *catalog = c;
+
+   return 0;
+
+error:
+
+   pgmoneta_art_iterator_destroy(iter);
+   catalog_unlock(fd);
+   catalog_records_destroy(records);
+   pgmoneta_catalog_destroy(c);
+
+   for (int i = 0; i < number_of_directories; i++)
+   {
+      free(dirs[i]);
+   }
+   free(dirs);
+
    return 1;
 }
 
+struct backup*
+pgmoneta_catalog_search(struct catalog* catalog, char* identifier)
+{
+   if (catalog == NULL || identifier == NULL || catalog->number_of_backups == 0)
+   {
+      return NULL;
+   }
+
+   if (!strcmp(identifier, "oldest"))
+   {
+      return catalog->backups[0];
+   }
+   else if (!strcmp(identifier, "latest") || !strcmp(identifier, "newest"))
+   {
+      return catalog->backups[catalog->number_of_backups - 1];
+   }
+
+   return (struct backup*)pgmoneta_art_search(catalog->labels, identifier);
+}
+
+struct backup*
+pgmoneta_catalog_child(struct catalog* catalog, char* label)
+{
+   if (catalog == NULL || label == NULL)
+   {
+      return NULL;
+   }
+
+   return (struct backup*)pgmoneta_art_search(catalog->children, label);
+}
+
+void
+pgmoneta_catalog_destroy(struct catalog* catalog)
+{
+   if (catalog == NULL)
+   {
+      return;
+   }
+
+   pgmoneta_art_destroy(catalog->labels);
+   pgmoneta_art_destroy(catalog->children);
+
+   for (int i = 0; i < catalog->number_of_backups; i++)
+   {
+      free(catalog->backups[i]);
+   }
+   free(catalog->backups);
+
+   free(catalog);
+}
+
 int
 pgmoneta_load_info(char* directory, char* identifier, struct backup** backup)
 {
    char* label = NULL;
    char* fn = NULL;
-   char buffer[INFO_BUFFER_SIZE];
    FILE* file = NULL;
-   int tbl_idx = 0;
    struct backup* bck = NULL;
-   int number_of_backups = 0;
-   struct backup** backups = NULL;
+   int number_of_directories = 0;
+   char** dirs = NULL;
 
    *backup = NULL;
 
@@ -452,34 +770,22 @@ pgmoneta_load_info(char* directory, char* identifier, struct backup** backup)
 
    if (!strcmp(identifier, "oldest") || !strcmp(identifier, "newest") || !strcmp(identifier, "latest"))
    {
-      int number_of_backups = 0;
-      struct backup** backups = NULL;
+      /* Labels sort by time, so the directory listing is enough */
+      pgmoneta_get_directories(directory, &number_of_directories, &dirs);
 
-      if (pgmoneta_load_infos(directory, &number_of_backups, &backups))
-      {
-         goto error;
-      }
-
-      if (number_of_backups == 0)
+      if (number_of_directories == 0)
       {
          goto error;
       }
 
       if (!strcmp(identifier, "oldest"))
       {
-         label = pgmoneta_append(label, backups[0]->label);
+         label = pgmoneta_append(label, dirs[0]);
       }
       else if (!strcmp(identifier, "latest") || !strcmp(identifier, "newest"))
       {
-         label = pgmoneta_append(label, backups[number_of_backups - 1]->label);
+         label = pgmoneta_append(label, dirs[number_of_directories - 1]);
       }
-
-      for (int i = 0; i < number_of_backups; i++)
-      {
-         free(backups[i]);
-      }
-      free(backups);
-      backups = NULL;
    }
    else
    {
@@ -515,233 +821,42 @@ pgmoneta_load_info(char* directory, char* identifier, struct backup** backup)
 
    if (file != NULL)
    {
-      while ((fgets(&buffer[0], sizeof(buffer), file)) != NULL)
+      if (read_backup(file, bck))
       {
-         char key[INFO_BUFFER_SIZE];
-         char value[INFO_BUFFER_SIZE];
-         char* ptr = NULL;
+         goto error;
+      }
+   }
 
-         memset(&key[0], 0, sizeof(key));
-         memset(&value[0], 0, sizeof(value));
+   *backup = bck;
 
-         ptr = strtok(&buffer[0], "=");
+   if (file != NULL)
+   {
+      fsync(fileno(file));
+      fclose(file);
+   }
 
-         if (ptr == NULL)
-         {
-            goto error;
-         }
+   free(fn);
 
-         memcpy(&key[0], ptr, strlen(ptr));
+   for (int i = 0; i < number_of_directories; i++)
+   {
+      free(dirs[i]);
+   }
+   free(dirs);
 
-         ptr = strtok(NULL, "=");
+   if (identifier != label)
+   {
+      free(label);
+   }
 
-         if (ptr == NULL)
-         {
-            goto error;
-         }
+   return 0;
 
-         memcpy(&value[0], ptr, strlen(ptr) - 1);
+error:
 
-         if (!strcmp(INFO_PGMONETA_VERSION, &key[0]))
-         {
-            memcpy(&bck->version[0], &value[0], strlen(&value[0]));
-         }
-         else if (!strcmp(INFO_STATUS, &key[0]))
-         {
-            if (!strcmp("1", &value[0]))
-            {
-               bck->valid = VALID_TRUE;
-            }
-            else
-            {
-               bck->valid = VALID_FALSE;
-            }
-         }
-         else if (!strcmp(INFO_LABEL, &key[0]))
-         {
-            memcpy(&bck->label[0], &value[0], strlen(&value[0]));
-         }
-         else if (!strcmp(INFO_WAL, &key[0]))
-         {
-            memcpy(&bck->wal[0], &value[0], strlen(&value[0]));
-         }
-         else if (!strcmp(INFO_BACKUP, &key[0]))
-         {
-            bck->backup_size = strtoul(&value[0], &ptr, 10);
-         }
-         else if (!strcmp(INFO_RESTORE, &key[0]))
-         {
-            bck->restore_size = strtoul(&value[0], &ptr, 10);
-         }
-         else if (!strcmp(INFO_BIGGEST_FILE, &key[0]))
-         {
-            bck->biggest_file_size = strtoul(&value[0], &ptr, 10);
-         }
-         else if (!strcmp(INFO_ELAPSED, &key[0]))
-         {
-            bck->total_elapsed_time = atof(&value[0]);
-         }
-         else if (!strcmp(INFO_BASEBACKUP_ELAPSED, &key[0]))
-         {
-            bck->basebackup_elapsed_time = atof(&value[0]);
-         }
-         else if (!strcmp(INFO_HASH_ELAPSED, &key[0]))
-         {
-            bck->hash_elapsed_time = atof(&value[0]);
-         }
-         else if (!strcmp(INFO_MANIFEST_ELAPSED, &key[0]))
-         {
-            bck->manifest_elapsed_time = atof(&value[0]);
-         }
-         else if (!strcmp(INFO_COMPRESSION_ZSTD_ELAPSED, &key[0]))
-         {
-            bck->compression_zstd_elapsed_time = atof(&value[0]);
-         }
-         else if (!strcmp(INFO_COMPRESSION_BZIP2_ELAPSED, &key[0]))
-         {
-            bck->compression_bzip2_elapsed_time = atof(&value[0]);
-         }
-         else if (!strcmp(INFO_COMPRESSION_GZIP_ELAPSED, &key[0]))
-         {
-            bck->compression_gzip_elapsed_time = atof(&value[0]);
-         }
-         else if (!strcmp(INFO_COMPRESSION_LZ4_ELAPSED, &key[0]))
-         {
-            bck->compression_lz4_elapsed_time = atof(&value[0]);
-         }
-         else if (!strcmp(INFO_ENCRYPTION_ELAPSED, &key[0]))
-         {
-            bck->encryption_elapsed_time = atof(&value[0]);
-         }
-         else if (!strcmp(INFO_LINKING_ELAPSED, &key[0]))
-         {
-            bck->linking_elapsed_time = atof(&value[0]);
-         }
-         else if (!strcmp(INFO_REMOTE_SSH_ELAPSED, &key[0]))
-         {
-            bck->remote_ssh_elapsed_time = atof(&value[0]);
-         }
-         else if (!strcmp(INFO_REMOTE_AZURE_ELAPSED, &key[0]))
-         {
-            bck->remote_azure_elapsed_time = atof(&value[0]);
-         }
-         else if (!strcmp(INFO_REMOTE_S3_ELAPSED, &key[0]))
-         {
-            bck->remote_s3_elapsed_time = atof(&value[0]);
-         }
-         else if (!strcmp(INFO_MAJOR_VERSION, &key[0]))
-         {
-            bck->major_version = atoi(&value[0]);
-         }
-         else if (!strcmp(INFO_MINOR_VERSION, &key[0]))
-         {
-            bck->minor_version = atoi(&value[0]);
-         }
-         else if (!strcmp(INFO_KEEP, &key[0]))
-         {
-            bck->keep = atoi(&value[0]) == 1 ? true : false;
-         }
-         else if (!strcmp(INFO_TABLESPACES, &key[0]))
-         {
-            bck->number_of_tablespaces = strtoul(&value[0], &ptr, 10);
-         }
-         else if (pgmoneta_starts_with(&key[0], "TABLESPACE_OID"))
-         {
-            memcpy(&bck->tablespaces_oids[tbl_idx], &value[0], strlen(&value[0]));
-         }
-         else if (pgmoneta_starts_with(&key[0], "TABLESPACE_PATH"))
-         {
-            memcpy(&bck->tablespaces_paths[tbl_idx], &value[0], strlen(&value[0]));
-            /* This one is last */
-            tbl_idx++;
-         }
-         else if (pgmoneta_starts_with(&key[0], "TABLESPACE"))
-         {
-            memcpy(&bck->tablespaces[tbl_idx], &value[0], strlen(&value[0]));
-         }
-         else if (pgmoneta_starts_with(&key[0], INFO_START_WALPOS))
-         {
-            sscanf(&value[0], "%X/%X", &bck->start_lsn_hi32, &bck->start_lsn_lo32);
-         }
-         else if (pgmoneta_starts_with(&key[0], INFO_END_WALPOS))
-         {
-            sscanf(&value[0], "%X/%X", &bck->end_lsn_hi32, &bck->end_lsn_lo32);
-         }
-         else if (pgmoneta_starts_with(&key[0], INFO_CHKPT_WALPOS))
-         {
-            sscanf(&value[0], "%X/%X", &bck->checkpoint_lsn_hi32, &bck->checkpoint_lsn_lo32);
-         }
-         else if (pgmoneta_starts_with(&key[0], INFO_START_TIMELINE))
-         {
-            bck->start_timeline = atoi(&value[0]);
-         }
-         else if (pgmoneta_starts_with(&key[0], INFO_END_TIMELINE))
-         {
-            bck->end_timeline = atoi(&value[0]);
-         }
-         else if (pgmoneta_starts_with(&key[0], INFO_COMMENTS))
-         {
-            memcpy(&bck->comments[0], &value[0], strlen(&value[0]));
-         }
-         else if (pgmoneta_starts_with(&key[0], INFO_EXTRA))
-         {
-            memcpy(&bck->comments[0], &value[0], strlen(&value[0]));
-         }
-         else if (pgmoneta_starts_with(&key[0], INFO_COMPRESSION))
-         {
-            bck->compression = migrate_compression_value(atoi(&value[0]));
-         }
-         else if (pgmoneta_starts_with(&key[0], INFO_ENCRYPTION))
-         {
-            bck->encryption = atoi(&value[0]);
-         }
-         else if (pgmoneta_starts_with(&key[0], INFO_TYPE))
-         {
-            bck->type = atoi(&value[0]);
-         }
-         else if (pgmoneta_starts_with(&key[0], INFO_PARENT))
-         {
-            memcpy(&bck->parent_label[0], &value[0], strlen(&value[0]));
-         }
-      }
-   }
-
-   *backup = bck;
-
-   if (file != NULL)
-   {
-      fsync(fileno(file));
-      fclose(file);
-   }
-
-   free(fn);
-
-   if (backups != NULL)
-   {
-      for (int i = 0; i < number_of_backups; i++)
-      {
-         free(backups[i]);
-      }
-      free(backups);
-   }
-
-   if (identifier != label)
-   {
-      free(label);
-   }
-
-   return 0;
-
-error:
-
-   if (backups != NULL)
+   for (int i = 0; i < number_of_directories; i++)
    {
-      for (int i = 0; i < number_of_backups; i++)
-      {
-         free(backups[i]);
-      }
-      free(backups);
+      free(dirs[i]);
    }
+   free(dirs);
 
    free(bck);
 
@@ -807,6 +922,8 @@ int
 pgmoneta_get_backup_parent(int server, struct backup* backup, struct backup** parent)
 {
    char* d = NULL;
+   struct catalog* catalog = NULL;
+   struct backup* found = NULL;
    struct backup* p = NULL;
 
    *parent = NULL;
@@ -823,25 +940,38 @@ pgmoneta_get_backup_parent(int server, struct backup* backup, struct backup** pa
 
    d = pgmoneta_get_server_backup(server);
 
-   if (pgmoneta_load_info(d, backup->parent_label, &p))
+   if (pgmoneta_catalog_load(d, &catalog))
+   {
+      goto error;
+   }
+
+   found = pgmoneta_catalog_search(catalog, backup->parent_label);
+
+   if (found == NULL)
    {
       goto error;
    }
 
+   p = (struct backup*)malloc(sizeof(struct backup));
+
    if (p == NULL)
    {
       goto error;
    }
 
+   memcpy(p, found, sizeof(struct backup));
+
    *parent = p;
 
    free(d);
+   pgmoneta_catalog_destroy(catalog);
 
    return 0;
 
 error:
 
    free(d);
+   pgmoneta_catalog_destroy(catalog);
 
    return 1;
 }
@@ -849,8 +979,10 @@ error:
 int
 pgmoneta_get_backup_root(int server, struct backup* backup, struct backup** root)
 {
-   struct backup* p = NULL;
-   struct backup* bck = NULL;
+   char* d = NULL;
+   struct catalog* catalog = NULL;
+   struct backup* found = NULL;
+   struct backup* r = NULL;
 
    *root = NULL;
 
@@ -864,27 +996,54 @@ pgmoneta_get_backup_root(int server, struct backup* backup, struct backup** root
       goto error;
    }
 
-   if (pgmoneta_get_backup_parent(server, backup, &p))
+   d = pgmoneta_get_server_backup(server);
+
+   /* The whole chain is resolved from a single catalog */
+   if (pgmoneta_catalog_load(d, &catalog))
    {
       goto error;
    }
 
-   while (p->type != TYPE_FULL)
+   found = pgmoneta_catalog_search(catalog, backup->parent_label);
+
+   /* A chain is never longer than the catalog */
+   for (int i = 0; found != NULL && found->type != TYPE_FULL; i++)
    {
-      if (pgmoneta_get_backup_parent(server, p, &bck))
+      if (i >= catalog->number_of_backups || strlen(found->parent_label) == 0)
       {
-         goto error;
+         found = NULL;
       }
-      free(p);
-      p = bck;
+      else
+      {
+         found = pgmoneta_catalog_search(catalog, found->parent_label);
+      }
+   }
+
+   if (found == NULL)
+   {
+      goto error;
+   }
+
+   r = (struct backup*)malloc(sizeof(struct backup));
+
+   if (r == NULL)
+   {
+      goto error;
    }
 
-   *root = p;
+   memcpy(r, found, sizeof(struct backup));
+
+   *root = r;
+
+   free(d);
+   pgmoneta_catalog_destroy(catalog);
 
    return 0;
 
 error:
-   free(p);
+
+   free(d);
+   pgmoneta_catalog_destroy(catalog);
 
    return 1;
 }
@@ -893,9 +1052,8 @@ int
 pgmoneta_get_backup_child(int server, struct backup* backup, struct backup** child)
 {
    char* d = NULL;
-   char* c_identifier = NULL;
-   int number_of_backups = 0;
-   struct backup** backups = NULL;
+   struct catalog* catalog = NULL;
+   struct backup* found = NULL;
    struct backup* c = NULL;
 
    *child = NULL;
@@ -907,50 +1065,36 @@ pgmoneta_get_backup_child(int server, struct backup* backup, struct backup** chi
 
    d = pgmoneta_get_server_backup(server);
 
-   if (pgmoneta_load_infos(d, &number_of_backups, &backups))
+   if (pgmoneta_catalog_load(d, &catalog))
    {
       goto error;
    }
 
-   for (int j = 0; c_identifier == NULL && j < number_of_backups; j++)
-   {
-      if (!strcmp(backup->label, backups[j]->parent_label))
-      {
-         c_identifier = pgmoneta_append(c_identifier, backups[j]->label);
-      }
-   }
+   found = pgmoneta_catalog_child(catalog, backup->label);
 
-   if (c_identifier != NULL)
+   if (found != NULL)
    {
-      if (pgmoneta_load_info(d, c_identifier, &c))
+      c = (struct backup*)malloc(sizeof(struct backup));
+
+      if (c == NULL)
       {
          goto error;
       }
 
+      memcpy(c, found, sizeof(struct backup));
+
       *child = c;
    }
 
    free(d);
-   free(c_identifier);
-
-   for (int j = 0; j < number_of_backups; j++)
-   {
-      free(backups[j]);
-   }
-   free(backups);
+   pgmoneta_catalog_destroy(catalog);
 
    return 0;
 
 error:
 
    free(d);
-   free(c_identifier);
-
-   for (int j = 0; j < number_of_backups; j++)
-   {
-      free(backups[j]);
-   }
-   free(backups);
+   pgmoneta_catalog_destroy(catalog);
 
    return 1;
 }
@@ -1356,7 +1500,6 @@ error:
 int
 pgmoneta_save_info(char* directory, struct backup* backup)
 {
-   char buffer[INFO_BUFFER_SIZE];
    char* bck_root_dir = NULL;
    char* bck_info_file = NULL;
    FILE* sfile = NULL;
@@ -1379,53 +1522,7 @@ pgmoneta_save_info(char* directory, struct backup* backup)
       goto error;
    }
 
-   write_info(sfile, "%s=%s\n", INFO_PGMONETA_VERSION, VERSION);
-   write_info(sfile, "%s=%d\n", INFO_STATUS, backup->valid == VALID_TRUE ? 1 : 0);
-   write_info(sfile, "%s=%s\n", INFO_LABEL, backup->label);
-   write_info(sfile, "%s=%s\n", INFO_WAL, backup->wal);
-   write_info(sfile, "%s=%lu\n", INFO_BACKUP, backup->backup_size);
-   write_info(sfile, "%s=%lu\n", INFO_RESTORE, backup->restore_size);
-   write_info(sfile, "%s=%lu\n", INFO_BIGGEST_FILE, backup->biggest_file_size);
-   write_info(sfile, "%s=%.4f\n", INFO_ELAPSED, backup->total_elapsed_time);
-   write_info(sfile, "%s=%.4f\n", INFO_BASEBACKUP_ELAPSED, backup->basebackup_elapsed_time);
-   write_info(sfile, "%s=%.4f\n", INFO_HASH_ELAPSED, backup->hash_elapsed_time);
-   write_info(sfile, "%s=%.4f\n", INFO_COMPRESSION_ZSTD_ELAPSED, backup->compression_zstd_elapsed_time);
-   write_info(sfile, "%s=%.4f\n", INFO_COMPRESSION_GZIP_ELAPSED, backup->compression_gzip_elapsed_time);
-   write_info(sfile, "%s=%.4f\n", INFO_COMPRESSION_BZIP2_ELAPSED, backup->compression_bzip2_elapsed_time);
-   write_info(sfile, "%s=%.4f\n", INFO_COMPRESSION_LZ4_ELAPSED, backup->compression_lz4_elapsed_time);
-   write_info(sfile, "%s=%.4f\n", INFO_ENCRYPTION_ELAPSED, backup->encryption_elapsed_time);
-   write_info(sfile, "%s=%.4f\n", INFO_LINKING_ELAPSED, backup->linking_elapsed_time);
-   write_info(sfile, "%s=%.4f\n", INFO_MANIFEST_ELAPSED, backup->manifest_elapsed_time);
-   write_info(sfile, "%s=%.4f\n", INFO_REMOTE_SSH_ELAPSED, backup->remote_ssh_elapsed_time);
-   write_info(sfile, "%s=%.4f\n", INFO_REMOTE_S3_ELAPSED, backup->remote_s3_elapsed_time);
-   write_info(sfile, "%s=%.4f\n", INFO_REMOTE_AZURE_ELAPSED, backup->remote_azure_elapsed_time);
-   write_info(sfile, "%s=%d\n", INFO_MAJOR_VERSION, backup->major_version);
-   write_info(sfile, "%s=%d\n", INFO_MINOR_VERSION, backup->minor_version);
-   write_info(sfile, "%s=%d\n", INFO_KEEP, backup->keep ? 1 : 0);
-   write_info(sfile, "%s=%lu\n", INFO_TABLESPACES, backup->number_of_tablespaces);
-   write_info(sfile, "%s=%d\n", INFO_COMPRESSION, backup->compression);
-   write_info(sfile, "%s=%d\n", INFO_ENCRYPTION, backup->encryption);
-
-   for (uint64_t i = 0; i < backup->number_of_tablespaces; i++)
-   {
-      write_info(sfile, "TABLESPACE%lu=%s\n", i + 1, backup->tablespaces[i]);
-      write_info(sfile, "TABLESPACE_OID%lu=%s\n", i + 1, backup->tablespaces_oids[i]);
-      write_info(sfile, "TABLESPACE_PATH%lu=%s\n", i + 1, backup->tablespaces_paths[i]);
-   }
-
-   write_info(sfile, "%s=%X/%X\n", INFO_START_WALPOS, backup->start_lsn_hi32, backup->start_lsn_lo32);
-   write_info(sfile, "%s=%X/%X\n", INFO_END_WALPOS, backup->end_lsn_hi32, backup->end_lsn_lo32);
-   write_info(sfile, "%s=%X/%X\n", INFO_CHKPT_WALPOS, backup->checkpoint_lsn_hi32, backup->checkpoint_lsn_lo32);
-
-   write_info(sfile, "%s=%u\n", INFO_START_TIMELINE, backup->start_timeline);
-   write_info(sfile, "%s=%u\n", INFO_END_TIMELINE, backup->end_timeline);
-   write_info(sfile, "%s=%d\n", INFO_TYPE, backup->type);
-   write_info(sfile, "%s=%s\n", INFO_PARENT, backup->parent_label);
-   write_info(sfile, "%s=%s\n", INFO_COMMENTS, backup->comments);
-
-   memset(&buffer[0], 0, sizeof(buffer));
-   pgmoneta_snprintf(&buffer[0], sizeof(buffer), "%s=%.1024s\n", INFO_EXTRA, backup->extra);
-   fputs(&buffer[0], sfile);
+   write_backup(sfile, backup);
 
    pgmoneta_permission(bck_info_file, 6, 0, 0);
 
@@ -1438,6 +1535,11 @@ pgmoneta_save_info(char* directory, struct backup* backup)
    pgmoneta_log_trace("Updating SHA512 for %s", bck_root_dir);
    pgmoneta_update_sha512(bck_root_dir, "backup.info");
 
+   if (catalog_update(directory, backup))
+   {
+      pgmoneta_log_warn("Could not update the catalog in %s", directory);
+   }
+
    free(bck_root_dir);
    free(bck_info_file);
    return 0;
@@ -1631,10 +1733,10 @@ error:
 int
 pgmoneta_backup_size(int server, char* label, unsigned long* size, uint64_t* biggest_file_size)
 {
-   struct json* manifest_read = NULL;
-   struct json* files = NULL;
+   char* key_path[1] = {MANIFEST_FILES};
+   struct json_reader* reader = NULL;
+   struct json* file = NULL;
    struct main_configuration* config = NULL;
-   struct json_iterator* iter = NULL;
    char* manifest_path = NULL;
    unsigned long sz = 0;
    uint64_t biggest_file_sz = 0;
@@ -1646,27 +1748,23 @@ pgmoneta_backup_size(int server, char* label, unsigned long* size, uint64_t* big
    // read and traverse the manifest of the incremental backup
    manifest_path = pgmoneta_get_server_backup_identifier_data(server, label);
    manifest_path = pgmoneta_append(manifest_path, "backup_manifest");
-   if (pgmoneta_json_read_file(manifest_path, &manifest_read))
+   if (pgmoneta_json_reader_init(manifest_path, &reader))
    {
       pgmoneta_log_error("Unable to read manifest %s", manifest_path);
       goto error;
    }
 
-   files = (struct json*)pgmoneta_json_get(manifest_read, MANIFEST_FILES);
-
-   if (files == NULL)
+   if (pgmoneta_json_locate(reader, key_path, 1))
    {
+      pgmoneta_log_error("Unable to locate files array in manifest %s", manifest_path);
       goto error;
    }
 
-   pgmoneta_json_iterator_create(files, &iter);
-   while (pgmoneta_json_iterator_next(iter))
+   while (pgmoneta_json_next_array_item(reader, &file))
    {
-      struct json* file = NULL;
       char* file_path = NULL;
       uint64_t file_size = 0;
 
-      file = (struct json*)pgmoneta_value_data(iter->value);
       file_path = (char*)pgmoneta_json_get(file, "Path");
       /* for incremental files get the `truncated_block_length` */
       if (pgmoneta_is_incremental_path(file_path))
@@ -1717,21 +1815,23 @@ pgmoneta_backup_size(int server, char* label, unsigned long* size, uint64_t* big
          biggest_file_sz = file_size;
       }
       sz += file_size;
+
+      pgmoneta_json_destroy(file);
+      file = NULL;
    }
-   pgmoneta_json_iterator_destroy(iter);
 
    *size = sz;
    *biggest_file_size = biggest_file_sz;
 
-   pgmoneta_json_destroy(manifest_read);
+   pgmoneta_json_reader_close(reader);
    free(manifest_path);
    free(relative_path);
    free(bare_file_name);
    return 0;
 
 error:
-   pgmoneta_json_iterator_destroy(iter);
-   pgmoneta_json_destroy(manifest_read);
+   pgmoneta_json_reader_close(reader);
+   pgmoneta_json_destroy(file);
    free(manifest_path);
    free(relative_path);
    free(bare_file_name);
@@ -1865,90 +1965,371 @@ migrate_compression_value(int compression)
    }
 }
 
-static void
-write_info(FILE* sfile, const char* fmt, ...)
-{
-   char buffer[INFO_BUFFER_SIZE];
-   va_list args;
-
-   memset(buffer, 0, sizeof(buffer));
-
-   va_start(args, fmt);
-   vsnprintf(buffer, sizeof(buffer), fmt, args);
-   va_end(args);
-
-   if (sfile != NULL)
-   {
-      fputs(buffer, sfile);
-   }
-}
-
-static void
-create_info(char* directory, char* label, int status)
+static int
+read_backup(FILE* file, struct backup* bck)
 {
    char buffer[INFO_BUFFER_SIZE];
-   char* s = NULL;
-   FILE* sfile = NULL;
-   struct main_configuration* config;
-
-   config = (struct main_configuration*)shmem;
-
-   s = pgmoneta_append(s, directory);
-   s = pgmoneta_append(s, "/backup.info");
+   int tbl_idx = 0;
 
-   sfile = fopen(s, "w");
-   if (sfile == NULL)
+   while ((fgets(&buffer[0], sizeof(buffer), file)) != NULL)
    {
-      pgmoneta_log_error("Could not open file %s due to %s", s, strerror(errno));
-      errno = 0;
-      goto error;
-   }
-
-   memset(&buffer[0], 0, sizeof(buffer));
-   pgmoneta_snprintf(&buffer[0], sizeof(buffer), "%s=%d\n", INFO_STATUS, status);
-   fputs(&buffer[0], sfile);
-   pgmoneta_log_trace("%s=%d", INFO_STATUS, status);
-
-   memset(&buffer[0], 0, sizeof(buffer));
-   pgmoneta_snprintf(&buffer[0], sizeof(buffer), "%s=%s\n", INFO_LABEL, label);
-   fputs(&buffer[0], sfile);
-   pgmoneta_log_trace("%s=%s", INFO_LABEL, label);
+      char key[INFO_BUFFER_SIZE];
+      char value[INFO_BUFFER_SIZE];
+      char* ptr = NULL;
 
-   memset(&buffer[0], 0, sizeof(buffer));
-   pgmoneta_snprintf(&buffer[0], sizeof(buffer), "%s=0\n", INFO_TABLESPACES);
-   fputs(&buffer[0], sfile);
-   pgmoneta_log_trace("%s=0", INFO_TABLESPACES);
+      /* A blank line ends a record in the catalog */
+      if (!strcmp(&buffer[0], "\n"))
+      {
+         break;
+      }
 
-   memset(&buffer[0], 0, sizeof(buffer));
-   pgmoneta_snprintf(&buffer[0], sizeof(buffer), "%s=%s\n", INFO_PGMONETA_VERSION, VERSION);
-   fputs(&buffer[0], sfile);
-   pgmoneta_log_trace("%s=%s", INFO_PGMONETA_VERSION, VERSION);
+      memset(&key[0], 0, sizeof(key));
+      memset(&value[0], 0, sizeof(value));
 
-   memset(&buffer[0], 0, sizeof(buffer));
-   pgmoneta_snprintf(&buffer[0], sizeof(buffer), "%s=\n", INFO_COMMENTS);
-   fputs(&buffer[0], sfile);
-   pgmoneta_log_trace("%s=", INFO_COMMENTS);
+      ptr = strtok(&buffer[0], "=");
 
-   memset(&buffer[0], 0, sizeof(buffer));
-   pgmoneta_snprintf(&buffer[0], sizeof(buffer), "%s=%d\n", INFO_COMPRESSION, config->compression_type);
-   fputs(&buffer[0], sfile);
-   pgmoneta_log_trace("%s=%d", INFO_COMPRESSION, config->compression_type);
+      if (ptr == NULL)
+      {
+         goto error;
+      }
 
-   memset(&buffer[0], 0, sizeof(buffer));
-   pgmoneta_snprintf(&buffer[0], sizeof(buffer), "%s=%d\n", INFO_ENCRYPTION, config->common.encryption);
-   fputs(&buffer[0], sfile);
-   pgmoneta_log_trace("%s=%d", INFO_ENCRYPTION, config->common.encryption);
+      memcpy(&key[0], ptr, strlen(ptr));
 
-   pgmoneta_permission(s, 6, 0, 0);
+      ptr = strtok(NULL, "=");
 
-   if (sfile != NULL)
-   {
-      fflush(sfile);
-      fsync(fileno(sfile));
-      fclose(sfile);
-   }
+      if (ptr == NULL)
+      {
+         goto error;
+      }
 
-   free(s);
+      memcpy(&value[0], ptr, strlen(ptr) - 1);
+
+      if (!strcmp(INFO_PGMONETA_VERSION, &key[0]))
+      {
+         memcpy(&bck->version[0], &value[0], strlen(&value[0]));
+      }
+      else if (!strcmp(INFO_STATUS, &key[0]))
+      {
+         if (!strcmp("1", &value[0]))
+         {
+            bck->valid = VALID_TRUE;
+         }
+         else
+         {
+            bck->valid = VALID_FALSE;
+         }
+      }
+      else if (!strcmp(INFO_LABEL, &key[0]))
+      {
+         memcpy(&bck->label[0], &value[0], strlen(&value[0]));
+      }
+      else if (!strcmp(INFO_WAL, &key[0]))
+      {
+         memcpy(&bck->wal[0], &value[0], strlen(&value[0]));
+      }
+      else if (!strcmp(INFO_BACKUP, &key[0]))
+      {
+         bck->backup_size = strtoul(&value[0], &ptr, 10);
+      }
+      else if (!strcmp(INFO_RESTORE, &key[0]))
+      {
+         bck->restore_size = strtoul(&value[0], &ptr, 10);
+      }
+      else if (!strcmp(INFO_BIGGEST_FILE, &key[0]))
+      {
+         bck->biggest_file_size = strtoul(&value[0], &ptr, 10);
+      }
+      else if (!strcmp(INFO_CHUNKED, &key[0]))
+      {
+         bck->chunked_size = strtoul(&value[0], &ptr, 10);
+      }
+      else if (!strcmp(INFO_CHUNKED_SHARED, &key[0]))
+      {
+         bck->chunked_shared = atoi(&value[0]) == 1 ? true : false;
+      }
+      else if (!strcmp(INFO_CHUNKED_STORED, &key[0]))
+      {
+         bck->chunked_stored_size = strtoul(&value[0], &ptr, 10);
+      }
+      else if (!strcmp(INFO_ELAPSED, &key[0]))
+      {
+         bck->total_elapsed_time = atof(&value[0]);
+      }
+      else if (!strcmp(INFO_BASEBACKUP_ELAPSED, &key[0]))
+      {
+         bck->basebackup_elapsed_time = atof(&value[0]);
+      }
+      else if (!strcmp(INFO_HASH_ELAPSED, &key[0]))
+      {
+         bck->hash_elapsed_time = atof(&value[0]);
+      }
+      else if (!strcmp(INFO_MANIFEST_ELAPSED, &key[0]))
+      {
+         bck->manifest_elapsed_time = atof(&value[0]);
+      }
+      else if (!strcmp(INFO_COMPRESSION_ZSTD_ELAPSED, &key[0]))
+      {
+         bck->compression_zstd_elapsed_time = atof(&value[0]);
+      }
+      else if (!strcmp(INFO_COMPRESSION_BZIP2_ELAPSED, &key[0]))
+      {
+         bck->compression_bzip2_elapsed_time = atof(&value[0]);
+      }
+      else if (!strcmp(INFO_COMPRESSION_GZIP_ELAPSED, &key[0]))
+      {
+         bck->compression_gzip_elapsed_time = atof(&value[0]);
+      }
+      else if (!strcmp(INFO_COMPRESSION_LZ4_ELAPSED, &key[0]))
+      {
+         bck->compression_lz4_elapsed_time = atof(&value[0]);
+      }
+      else if (!strcmp(INFO_ENCRYPTION_ELAPSED, &key[0]))
+      {
+         bck->encryption_elapsed_time = atof(&value[0]);
+      }
+      else if (!strcmp(INFO_LINKING_ELAPSED, &key[0]))
+      {
+         bck->linking_elapsed_time = atof(&value[0]);
+      }
+      else if (!strcmp(INFO_REMOTE_SSH_ELAPSED, &key[0]))
+      {
+         bck->remote_ssh_elapsed_time = atof(&value[0]);
+      }
+      else if (!strcmp(INFO_REMOTE_AZURE_ELAPSED, &key[0]))
+      {
+         bck->remote_azure_elapsed_time = atof(&value[0]);
+      }
+      else if (!strcmp(INFO_REMOTE_S3_ELAPSED, &key[0]))
+      {
+         bck->remote_s3_elapsed_time = atof(&value[0]);
+      }
+      else if (!strcmp(INFO_MAJOR_VERSION, &key[0]))
+      {
+         bck->major_version = atoi(&value[0]);
+      }
+      else if (!strcmp(INFO_MINOR_VERSION, &key[0]))
+      {
+         bck->minor_version = atoi(&value[0]);
+      }
+      else if (!strcmp(INFO_KEEP, &key[0]))
+      {
+         bck->keep = atoi(&value[0]) == 1 ? true : false;
+      }
+      else if (!strcmp(INFO_TABLESPACES, &key[0]))
+      {
+         bck->number_of_tablespaces = strtoul(&value[0], &ptr, 10);
+      }
+      else if (pgmoneta_starts_with(&key[0], "TABLESPACE_OID"))
+      {
+         memcpy(&bck->tablespaces_oids[tbl_idx], &value[0], strlen(&value[0]));
+      }
+      else if (pgmoneta_starts_with(&key[0], "TABLESPACE_PATH"))
+      {
+         memcpy(&bck->tablespaces_paths[tbl_idx], &value[0], strlen(&value[0]));
+         /* This one is last */
+         tbl_idx++;
+      }
+      else if (pgmoneta_starts_with(&key[0], "TABLESPACE"))
+      {
+         memcpy(&bck->tablespaces[tbl_idx], &value[0], strlen(&value[0]));
+      }
+      else if (pgmoneta_starts_with(&key[0], INFO_START_WALPOS))
+      {
+         sscanf(&value[0], "%X/%X", &bck->start_lsn_hi32, &bck->start_lsn_lo32);
+      }
+      else if (pgmoneta_starts_with(&key[0], INFO_END_WALPOS))
+      {
+         sscanf(&value[0], "%X/%X", &bck->end_lsn_hi32, &bck->end_lsn_lo32);
+      }
+      else if (pgmoneta_starts_with(&key[0], INFO_CHKPT_WALPOS))
+      {
+         sscanf(&value[0], "%X/%X", &bck->checkpoint_lsn_hi32, &bck->checkpoint_lsn_lo32);
+      }
+      else if (pgmoneta_starts_with(&key[0], INFO_START_TIMELINE))
+      {
+         bck->start_timeline = atoi(&value[0]);
+      }
+      else if (pgmoneta_starts_with(&key[0], INFO_END_TIMELINE))
+      {
+         bck->end_timeline = atoi(&value[0]);
+      }
+      else if (pgmoneta_starts_with(&key[0], INFO_COMMENTS))
+      {
+         memcpy(&bck->comments[0], &value[0], strlen(&value[0]));
+      }
+      else if (pgmoneta_starts_with(&key[0], INFO_EXTRA))
+      {
+         memcpy(&bck->comments[0], &value[0], strlen(&value[0]));
+      }
+      else if (pgmoneta_starts_with(&key[0], INFO_COMPRESSION))
+      {
+         bck->compression = migrate_compression_value(atoi(&value[0]));
+      }
+      else if (pgmoneta_starts_with(&key[0], INFO_ENCRYPTION))
+      {
+         bck->encryption = atoi(&value[0]);
+      }
+      else if (pgmoneta_starts_with(&key[0], INFO_TYPE))
+      {
+         bck->type = atoi(&value[0]);
+      }
+      else if (pgmoneta_starts_with(&key[0], INFO_PARENT))
+      {
+         memcpy(&bck->parent_label[0], &value[0], strlen(&value[0]));
+      }
+   }
+
+   return 0;
+
+error:
+
+   return 1;
+}
+
+static void
+write_backup(FILE* sfile, struct backup* backup)
+{
+   char buffer[INFO_BUFFER_SIZE];
+
+   write_info(sfile, "%s=%s\n", INFO_PGMONETA_VERSION, VERSION);
+   write_info(sfile, "%s=%d\n", INFO_STATUS, backup->valid == VALID_TRUE ? 1 : 0);
+   write_info(sfile, "%s=%s\n", INFO_LABEL, backup->label);
+   write_info(sfile, "%s=%s\n", INFO_WAL, backup->wal);
+   write_info(sfile, "%s=%lu\n", INFO_BACKUP, backup->backup_size);
+   write_info(sfile, "%s=%lu\n", INFO_RESTORE, backup->restore_size);
+   write_info(sfile, "%s=%lu\n", INFO_BIGGEST_FILE, backup->biggest_file_size);
+   if (backup->chunked_size > 0)
+   {
+      write_info(sfile, "%s=%lu\n", INFO_CHUNKED, backup->chunked_size);
+      write_info(sfile, "%s=%lu\n", INFO_CHUNKED_STORED, backup->chunked_stored_size);
+      write_info(sfile, "%s=%d\n", INFO_CHUNKED_SHARED, backup->chunked_shared ? 1 : 0);
+   }
+   write_info(sfile, "%s=%.4f\n", INFO_ELAPSED, backup->total_elapsed_time);
+   write_info(sfile, "%s=%.4f\n", INFO_BASEBACKUP_ELAPSED, backup->basebackup_elapsed_time);
+   write_info(sfile, "%s=%.4f\n", INFO_HASH_ELAPSED, backup->hash_elapsed_time);
+   write_info(sfile, "%s=%.4f\n", INFO_COMPRESSION_ZSTD_ELAPSED, backup->compression_zstd_elapsed_time);
+   write_info(sfile, "%s=%.4f\n", INFO_COMPRESSION_GZIP_ELAPSED, backup->compression_gzip_elapsed_time);
+   write_info(sfile, "%s=%.4f\n", INFO_COMPRESSION_BZIP2_ELAPSED, backup->compression_bzip2_elapsed_time);
+   write_info(sfile, "%s=%.4f\n", INFO_COMPRESSION_LZ4_ELAPSED, backup->compression_lz4_elapsed_time);
+   write_info(sfile, "%s=%.4f\n", INFO_ENCRYPTION_ELAPSED, backup->encryption_elapsed_time);
+   write_info(sfile, "%s=%.4f\n", INFO_LINKING_ELAPSED, backup->linking_elapsed_time);
+   write_info(sfile, "%s=%.4f\n", INFO_MANIFEST_ELAPSED, backup->manifest_elapsed_time);
+   write_info(sfile, "%s=%.4f\n", INFO_REMOTE_SSH_ELAPSED, backup->remote_ssh_elapsed_time);
+   write_info(sfile, "%s=%.4f\n", INFO_REMOTE_S3_ELAPSED, backup->remote_s3_elapsed_time);
+   write_info(sfile, "%s=%.4f\n", INFO_REMOTE_AZURE_ELAPSED, backup->remote_azure_elapsed_time);
+   write_info(sfile, "%s=%d\n", INFO_MAJOR_VERSION, backup->major_version);
+   write_info(sfile, "%s=%d\n", INFO_MINOR_VERSION, backup->minor_version);
+   write_info(sfile, "%s=%d\n", INFO_KEEP, backup->keep ? 1 : 0);
+   write_info(sfile, "%s=%lu\n", INFO_TABLESPACES, backup->number_of_tablespaces);
+   write_info(sfile, "%s=%d\n", INFO_COMPRESSION, backup->compression);
+   write_info(sfile, "%s=%d\n", INFO_ENCRYPTION, backup->encryption);
+
+   for (uint64_t i = 0; i < backup->number_of_tablespaces; i++)
+   {
+      write_info(sfile, "TABLESPACE%lu=%s\n", i + 1, backup->tablespaces[i]);
+      write_info(sfile, "TABLESPACE_OID%lu=%s\n", i + 1, backup->tablespaces_oids[i]);
+      write_info(sfile, "TABLESPACE_PATH%lu=%s\n", i + 1, backup->tablespaces_paths[i]);
+   }
+
+   write_info(sfile, "%s=%X/%X\n", INFO_START_WALPOS, backup->start_lsn_hi32, backup->start_lsn_lo32);
+   write_info(sfile, "%s=%X/%X\n", INFO_END_WALPOS, backup->end_lsn_hi32, backup->end_lsn_lo32);
+   write_info(sfile, "%s=%X/%X\n", INFO_CHKPT_WALPOS, backup->checkpoint_lsn_hi32, backup->checkpoint_lsn_lo32);
+
+   write_info(sfile, "%s=%u\n", INFO_START_TIMELINE, backup->start_timeline);
+   write_info(sfile, "%s=%u\n", INFO_END_TIMELINE, backup->end_timeline);
+   write_info(sfile, "%s=%d\n", INFO_TYPE, backup->type);
+   write_info(sfile, "%s=%s\n", INFO_PARENT, backup->parent_label);
+   write_info(sfile, "%s=%s\n", INFO_COMMENTS, backup->comments);
+
+   memset(&buffer[0], 0, sizeof(buffer));
+   pgmoneta_snprintf(&buffer[0], sizeof(buffer), "%s=%.1024s\n", INFO_EXTRA, backup->extra);
+   fputs(&buffer[0], sfile);
+}
+
+static void
+write_info(FILE* sfile, const char* fmt, ...)
+{
+   char buffer[INFO_BUFFER_SIZE];
+   va_list args;
+
+   memset(buffer, 0, sizeof(buffer));
+
+   va_start(args, fmt);
+   vsnprintf(buffer, sizeof(buffer), fmt, args);
+   va_end(args);
+
+   if (sfile != NULL)
+   {
+      fputs(buffer, sfile);
+   }
+}
+
+static void
+create_info(char* directory, char* label, int status)
+{
+   char buffer[INFO_BUFFER_SIZE];
+   char* s = NULL;
+   FILE* sfile = NULL;
+   struct main_configuration* config;
+
+   config = (struct main_configuration*)shmem;
+
+   s = pgmoneta_append(s, directory);
+   s = pgmoneta_append(s, "/backup.info");
+
+   sfile = fopen(s, "w");
+   if (sfile == NULL)
+   {
+      pgmoneta_log_error("Could not open file %s due to %s", s, strerror(errno));
+      errno = 0;
+      goto error;
+   }
+
+   memset(&buffer[0], 0, sizeof(buffer));
+   pgmoneta_snprintf(&buffer[0], sizeof(buffer), "%s=%d\n", INFO_STATUS, status);
+   fputs(&buffer[0], sfile);
+   pgmoneta_log_trace("%s=%d", INFO_STATUS, status);
+
+   memset(&buffer[0], 0, sizeof(buffer));
+   pgmoneta_snprintf(&buffer[0], sizeof(buffer), "%s=%s\n", INFO_LABEL, label);
+   fputs(&buffer[0], sfile);
+   pgmoneta_log_trace("%s=%s", INFO_LABEL, label);
+
+   memset(&buffer[0], 0, sizeof(buffer));
+   pgmoneta_snprintf(&buffer[0], sizeof(buffer), "%s=0\n", INFO_TABLESPACES);
+   fputs(&buffer[0], sfile);
+   pgmoneta_log_trace("%s=0", INFO_TABLESPACES);
+
+   memset(&buffer[0], 0, sizeof(buffer));
+   pgmoneta_snprintf(&buffer[0], sizeof(buffer), "%s=%s\n", INFO_PGMONETA_VERSION, VERSION);
+   fputs(&buffer[0], sfile);
+   pgmoneta_log_trace("%s=%s", INFO_PGMONETA_VERSION, VERSION);
+
+   memset(&buffer[0], 0, sizeof(buffer));
+   pgmoneta_snprintf(&buffer[0], sizeof(buffer), "%s=\n", INFO_COMMENTS);
+   fputs(&buffer[0], sfile);
+   pgmoneta_log_trace("%s=", INFO_COMMENTS);
+
+   memset(&buffer[0], 0, sizeof(buffer));
+   pgmoneta_snprintf(&buffer[0], sizeof(buffer), "%s=%d\n", INFO_COMPRESSION, config->compression_type);
+   fputs(&buffer[0], sfile);
+   pgmoneta_log_trace("%s=%d", INFO_COMPRESSION, config->compression_type);
+
+   memset(&buffer[0], 0, sizeof(buffer));
+   pgmoneta_snprintf(&buffer[0], sizeof(buffer), "%s=%d\n", INFO_ENCRYPTION, config->common.encryption);
+   fputs(&buffer[0], sfile);
+   pgmoneta_log_trace("%s=%d", INFO_ENCRYPTION, config->common.encryption);
+
+   pgmoneta_permission(s, 6, 0, 0);
+
+   if (sfile != NULL)
+   {
+      fflush(sfile);
+      fsync(fileno(sfile));
+      fclose(sfile);
+   }
+
+   free(s);
 
    return;
 
@@ -1956,3 +2337,404 @@ error:
 
    free(s);
 }
+
+static int
+catalog_lock(char* directory)
+{
+   int fd = -1;
+
+   fd = open(directory, O_RDONLY | O_DIRECTORY);
+   if (fd == -1)
+   {
+      pgmoneta_log_debug("Could not open %s due to %s", directory, strerror(errno));
+      errno = 0;
+      return -1;
+   }
+
+   if (flock(fd, LOCK_EX))
+   {
+      pgmoneta_log_debug("Could not lock %s due to %s", directory, strerror(errno));
+      errno = 0;
+      close(fd);
+      return -1;
+   }
+
+   return fd;
+}
+
+static void
+catalog_unlock(int fd)
+{
+   if (fd != -1)
+   {
+      flock(fd, LOCK_UN);
+      close(fd);
+   }
+}
+
+static int
+catalog_read(char* directory, struct art** records)
+{
+   char buffer[INFO_BUFFER_SIZE];
+   char* fn = NULL;
+   FILE* file = NULL;
+   struct backup* bck = NULL;
+   struct art* r = NULL;
+
+   *records = NULL;
+
+   fn = pgmoneta_append(fn, directory);
+   fn = pgmoneta_append(fn, CATALOG_FILE);
+
+   file = fopen(fn, "r");
+   if (file == NULL)
+   {
+      errno = 0;
+      goto done;
+   }
+
+   memset(&buffer[0], 0, sizeof(buffer));
+
+   if (fgets(&buffer[0], sizeof(buffer), file) == NULL || strcmp(&buffer[0], CATALOG_HEADER))
+   {
+      goto error;
+   }
+
+   if (pgmoneta_art_create(&r))
+   {
+      goto error;
+   }
+
+   while (true)
+   {
+      bck = (struct backup*)malloc(sizeof(struct backup));
+
+      if (bck == NULL)
+      {
+         goto error;
+      }
+
+      memset(bck, 0, sizeof(struct backup));
+
+      bck->valid = VALID_UNKNOWN;
+
+      if (read_backup(file, bck))
+      {
+         goto error;
+      }
+
+      if (strlen(bck->label) == 0)
+      {
+         free(bck);
+         bck = NULL;
+         break;
+      }
+
+      if (pgmoneta_art_contains_key(r, bck->label))
+      {
+         goto error;
+      }
+
+      if (pgmoneta_art_insert(r, bck->label, (uintptr_t)bck, ValueRef))
+      {
+         goto error;
+      }
+
+      bck = NULL;
+   }
+
+   *records = r;
+
+done:
+
+   if (file != NULL)
+   {
+      fclose(file);
+   }
+
+   free(fn);
+
+   return 0;
+
+error:
+
+   pgmoneta_log_debug("Corrupted catalog %s", fn);
+
+   if (file != NULL)
+   {
+      fclose(file);
+   }
+
+   free(bck);
+   catalog_records_destroy(r);
+   free(fn);
+
+   return 1;
+}
+
+static int
+catalog_write(char* directory, int number_of_backups, struct backup** backups)
+{
+   char* fn = NULL;
+   char* tmp = NULL;
+   FILE* file = NULL;
+
+   fn = pgmoneta_append(fn, directory);
+   fn = pgmoneta_append(fn, CATALOG_FILE);
+
+   tmp = pgmoneta_append(tmp, fn);
+   tmp = pgmoneta_append(tmp, ".tmp");
+
+   file = fopen(tmp, "w");
+   if (file == NULL)
+   {
+      pgmoneta_log_error("Could not open file %s due to %s", tmp, strerror(errno));
+      errno = 0;
+      goto error;
+   }
+
+   fputs(CATALOG_HEADER, file);
+
+   for (int i = 0; i < number_of_backups; i++)
+   {
+      if (backups[i] == NULL || backups[i]->valid == VALID_UNKNOWN || strlen(backups[i]->label) == 0)
+      {
+         continue;
+      }
+
+      write_backup(file, backups[i]);
+      fputs("\n", file);
+   }
+
+   if (fflush(file) || fsync(fileno(file)))
+   {
+      pgmoneta_log_error("Could not write file %s due to %s", tmp, strerror(errno));
+      errno = 0;
+      goto error;
+   }
+
+   fclose(file);
+   file = NULL;
+
+   pgmoneta_permission(tmp, 6, 0, 0);
+
+   /* Readers never lock, so the catalog is replaced in a single step */
+   if (rename(tmp, fn))
+   {
+      pgmoneta_log_error("Could not rename %s due to %s", tmp, strerror(errno));
+      errno = 0;
+      goto error;
+   }
+
+   free(fn);
+   free(tmp);
+
+   return 0;
+
+error:
+
+   if (file != NULL)
+   {
+      fclose(file);
+   }
+
+   unlink(tmp);
+
+   free(fn);
+   free(tmp);
+
+   return 1;
+}
+
+static int
+catalog_update(char* directory, struct backup* backup)
+{
+   int fd = -1;
+   int number_of_backups = 0;
+   char* fn = NULL;
+   struct art* records = NULL;
+   struct art_iterator* iter = NULL;
+   struct backup* bck = NULL;
+   struct backup** backups = NULL;
+
+   fd = catalog_lock(directory);
+   if (fd == -1)
+   {
+      goto error;
+   }
+
+   if (catalog_read(directory, &records))
+   {
+      goto error;
+   }
+
+   /* Without a catalog there is nothing to update, it is built by the next load */
+   if (records == NULL)
+   {
+      goto done;
+   }
+
+   bck = (struct backup*)pgmoneta_art_search(records, backup->label);
+   if (bck != NULL)
+   {
+      pgmoneta_art_delete(records, backup->label);
+      free(bck);
+   }
+
+   bck = (struct backup*)malloc(sizeof(struct backup));
+
+   if (bck == NULL)
+   {
+      goto error;
+   }
+
+   memcpy(bck, backup, sizeof(struct backup));
+
+   /* The record must read the same as backup.info, which has no unknown status */
+   if (bck->valid != VALID_TRUE)
+   {
+      bck->valid = VALID_FALSE;
+   }
+
+   if (pgmoneta_art_insert(records, bck->label, (uintptr_t)bck, ValueRef))
+   {
+      free(bck);
+      goto error;
+   }
+
+   backups = (struct backup**)malloc(records->size * sizeof(struct backup*));
+
+   if (backups == NULL)
+   {
+      goto error;
+   }
+
+   if (pgmoneta_art_iterator_create(records, &iter))
+   {
+      goto error;
+   }
+
+   while (pgmoneta_art_iterator_next(iter))
+   {
+      backups[number_of_backups++] = (struct backup*)iter->value->data;
+   }
+
+   if (catalog_write(directory, number_of_backups, backups))
+   {
+      goto error;
+   }
+
+done:
+
+   pgmoneta_art_iterator_destroy(iter);
+   free(backups);
+   catalog_records_destroy(records);
+   catalog_unlock(fd);
+
+   return 0;
+
+error:
+
+   /* A stale catalog is worse than none, so leave it to be rebuilt */
+   if (fd != -1)
+   {
+      fn = pgmoneta_append(fn, directory);
+      fn = pgmoneta_append(fn, CATALOG_FILE);
+      unlink(fn);
+      free(fn);
+   }
+
+   pgmoneta_art_iterator_destroy(iter);
+   free(backups);
+   catalog_records_destroy(records);
+   catalog_unlock(fd);
+
+   return 1;
+}
+
+static bool
+catalog_current(char* directory, struct timespec* mtime)
+{
+   char* fn = NULL;
+   struct stat dst;
+   struct stat cst;
+   bool current = false;
+
+   memset(mtime, 0, sizeof(struct timespec));
+
+   if (stat(directory, &dst))
+   {
+      errno = 0;
+      return false;
+   }
+
+   *mtime = dst.st_mtim;
+
+   fn = pgmoneta_append(fn, directory);
+   fn = pgmoneta_append(fn, CATALOG_FILE);
+
+   /* Writing the catalog renames it into the directory, which moves the directory past the stamp */
+   if (!stat(fn, &cst))
+   {
+      current = cst.st_mtim.tv_sec > dst.st_mtim.tv_sec ||
+                (cst.st_mtim.tv_sec == dst.st_mtim.tv_sec && cst.st_mtim.tv_nsec >= dst.st_mtim.tv_nsec);
+   }
+
+   errno = 0;
+   free(fn);
+
+   return current;
+}
+
+static void
+catalog_stamp(char* directory, struct timespec* mtime)
+{
+   char* fn = NULL;
+   struct timespec now;
+   struct timespec times[2];
+
+   clock_gettime(CLOCK_REALTIME, &now);
+
+   /* A change within the timestamp granularity of the file system could carry the same time,
+      so a recently changed directory is scanned again instead */
+   if ((mtime->tv_sec == 0 && mtime->tv_nsec == 0) || now.tv_sec - mtime->tv_sec < 2)
+   {
+      return;
+   }
+
+   fn = pgmoneta_append(fn, directory);
+   fn = pgmoneta_append(fn, CATALOG_FILE);
+
+   times[0].tv_sec = 0;
+   times[0].tv_nsec = UTIME_OMIT;
+   times[1] = *mtime;
+
+   if (utimensat(AT_FDCWD, fn, &times[0], 0))
+   {
+      errno = 0;
+   }
+
+   free(fn);
+}
+
+static void
+catalog_records_destroy(struct art* records)
+{
+   struct art_iterator* iter = NULL;
+
+   if (records == NULL)
+   {
+      return;
+   }
+
+   if (!pgmoneta_art_iterator_create(records, &iter))
+   {
+      while (pgmoneta_art_iterator_next(iter))
+      {
+         free((void*)iter->value->data);
+      }
+      pgmoneta_art_iterator_destroy(iter);
+   }
+
+   pgmoneta_art_destroy(records);
+}
@@ -40,23 +40,39 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#define JSON_NUMBER_LENGTH 64
+
 static int advance_to_first_array_element(struct json_reader* reader);
 static int json_read(struct json_reader* reader);
 static bool json_next_char(struct json_reader* reader, char* next);
 static bool json_peek_next_char(struct json_reader* reader, char* next);
 static int json_fast_forward_value(struct json_reader* reader, char ch);
 static int json_stream_parse_item(struct json_reader* reader, struct json** item);
+static int json_read_string(struct json_reader* reader, char** str);
 static bool type_allowed(enum value_type type);
 static char* item_to_string(struct json* item, int32_t format, char* tag, int indent);
 static char* array_to_string(struct json* array, int32_t format, char* tag, int indent);
-static int parse_string(char* str, uint64_t* index, struct json** obj);
+static int parse_string(char* str, uint64_t len, uint64_t* index, struct json** obj);
+static int parse_quoted(char* str, uint64_t len, uint64_t* index, char** value);
 static int json_add(struct json* obj, char* key, uintptr_t val, enum value_type type);
-static int fill_value(char* str, char* key, uint64_t* index, struct json* o);
+static int fill_value(char* str, uint64_t len, char* key, uint64_t* index, struct json* o);
 static bool value_start(char ch);
-static int handle_escape_char(char* str, uint64_t* index, uint64_t len, char* ch);
+static int handle_escape_char(char* str, uint64_t* index, uint64_t len, char* out, int* size);
+static int unescape_char(char ch, char* out);
+static int unescape_unicode(char* hex, uint64_t length, uint64_t* used, char* out, int* size);
+static int hex_code_point(char* hex, uint32_t* cp);
+static uint64_t string_run_length(char* str, uint64_t length);
 
 int
 pgmoneta_json_reader_init(char* path, struct json_reader** reader)
@@ -116,6 +132,16 @@ pgmoneta_json_reader_close(struct json_reader* reader)
    free(reader);
 }
 
+int
+pgmoneta_json_read_item(struct json_reader* reader, struct json** item)
+{
+   if (reader == NULL || reader->state != ItemStart)
+   {
+      return 1;
+   }
+   return json_stream_parse_item(reader, item);
+}
+
 int
 pgmoneta_json_locate(struct json_reader* reader, char** key_path, int key_path_length)
 {
@@ -145,24 +171,9 @@ pgmoneta_json_locate(struct json_reader* reader, char** key_path, int key_path_l
          if (ch != '"' && ch != ':' && ch != '{' && ch != '}' &&
              !(reader->state == ValueStart && (isdigit(ch) || ch == '[')))
          {
-            if (reader->state == KeyStart)
-            {
-               cur_key = pgmoneta_append_char(cur_key, ch);
-            }
             continue;
          }
-         if (reader->state == KeyStart)
-         {
-            if (ch == '"')
-            {
-               reader->state = KeyEnd;
-            }
-            else
-            {
-               goto error;
-            }
-         }
-         else if (reader->state == KeyEnd)
+         if (reader->state == KeyEnd)
          {
             if (ch == ':')
             {
@@ -232,7 +243,11 @@ pgmoneta_json_locate(struct json_reader* reader, char** key_path, int key_path_l
          {
             if (ch == '"')
             {
-               reader->state = KeyStart;
+               if (json_read_string(reader, &cur_key))
+               {
+                  goto error;
+               }
+               reader->state = KeyEnd;
             }
             else if (ch == '}')
             {
@@ -258,7 +273,11 @@ pgmoneta_json_locate(struct json_reader* reader, char** key_path, int key_path_l
          {
             if (ch == '"')
             {
-               reader->state = KeyStart;
+               if (json_read_string(reader, &cur_key))
+               {
+                  goto error;
+               }
+               reader->state = KeyEnd;
             }
             else if (ch == '}')
             {
@@ -439,6 +458,21 @@ pgmoneta_json_create(struct json** object)
    return 0;
 }
 
+int
+pgmoneta_json_create_array(bool thread_safe, struct json** array)
+{
+   struct json* a = NULL;
+   pgmoneta_json_create(&a);
+   a->type = JSONArray;
+   if (pgmoneta_deque_create(thread_safe, (struct deque**)&a->elements))
+   {
+      free(a);
+      return 1;
+   }
+   *array = a;
+   return 0;
+}
+
 int
 pgmoneta_json_destroy(struct json* object)
 {
@@ -621,12 +655,13 @@ int
 pgmoneta_json_parse_string(char* str, struct json** obj)
 {
    uint64_t idx = 0;
-   if (str == NULL || strlen(str) < 2)
+   uint64_t len = 0;
+   if (str == NULL || (len = strlen(str)) < 2)
    {
       return 1;
    }
 
-   return parse_string(str, &idx, obj);
+   return parse_string(str, len, &idx, obj);
 }
 
 int
@@ -719,14 +754,13 @@ pgmoneta_json_put_size_value(struct json* res, char* key, unsigned int bytes)
 }
 
 static int
-parse_string(char* str, uint64_t* index, struct json** obj)
+parse_string(char* str, uint64_t len, uint64_t* index, struct json** obj)
 {
    enum json_type type;
    struct json* o = NULL;
    uint64_t idx = *index;
    char ch = str[idx];
    char* key = NULL;
-   uint64_t len = strlen(str);
 
    if (ch == '{')
    {
@@ -779,28 +813,12 @@ parse_string(char* str, uint64_t* index, struct json** obj)
          }
          idx++;
          // The key
-         while (idx < len && str[idx] != '"')
-         {
-            char ec_ch;
-            // handle escape character
-            if (str[idx] == '\\')
-            {
-               if (handle_escape_char(str, &idx, len, &ec_ch))
-               {
-                  goto error;
-               }
-               key = pgmoneta_append_char(key, ec_ch);
-               continue;
-            }
-
-            key = pgmoneta_append_char(key, str[idx++]);
-         }
-         if (idx == len || key == NULL)
+         if (parse_quoted(str, len, &idx, &key) || key == NULL)
          {
             goto error;
          }
          // The lands between
-         while (idx < len && (str[idx] == '"' || isspace(str[idx])))
+         while (idx < len && isspace(str[idx]))
          {
             idx++;
          }
@@ -817,7 +835,7 @@ parse_string(char* str, uint64_t* index, struct json** obj)
             goto error;
          }
          // The value
-         if (fill_value(str, key, &idx, o))
+         if (fill_value(str, len, key, &idx, o))
          {
             goto error;
          }
@@ -860,7 +878,7 @@ parse_string(char* str, uint64_t* index, struct json** obj)
             goto error;
          }
 
-         if (fill_value(str, key, &idx, o))
+         if (fill_value(str, len, key, &idx, o))
          {
             goto error;
          }
@@ -901,30 +919,15 @@ value_start(char ch)
 }
 
 static int
-fill_value(char* str, char* key, uint64_t* index, struct json* o)
+fill_value(char* str, uint64_t len, char* key, uint64_t* index, struct json* o)
 {
    uint64_t idx = *index;
-   uint64_t len = strlen(str);
+   uint64_t start = 0;
    if (str[idx] == '"')
    {
       char* val = NULL;
       idx++;
-      while (idx < len && str[idx] != '"')
-      {
-         char ec_ch;
-         if (str[idx] == '\\')
-         {
-            if (handle_escape_char(str, &idx, len, &ec_ch))
-            {
-               goto error;
-            }
-            val = pgmoneta_append_char(val, ec_ch);
-            continue;
-         }
-
-         val = pgmoneta_append_char(val, str[idx++]);
-      }
-      if (idx == len)
+      if (parse_quoted(str, len, &idx, &val))
       {
          goto error;
       }
@@ -936,48 +939,50 @@ fill_value(char* str, char* key, uint64_t* index, struct json* o)
       {
          json_add(o, key, (uintptr_t)val, ValueString);
       }
-      idx++;
       free(val);
    }
    else if (str[idx] == '-' || str[idx] == '+' || isdigit(str[idx]))
    {
       bool has_digit = false;
-      char* val_str = NULL;
+      char val_str[JSON_NUMBER_LENGTH];
+      start = idx;
       while (idx < len && (isdigit(str[idx]) || str[idx] == '.' || str[idx] == '-' || str[idx] == '+'))
       {
          if (str[idx] == '.')
          {
             has_digit = true;
          }
-         val_str = pgmoneta_append_char(val_str, str[idx++]);
+         idx++;
       }
+      if (idx - start >= JSON_NUMBER_LENGTH)
+      {
+         goto error;
+      }
+      memcpy(val_str, str + start, idx - start);
+      val_str[idx - start] = '\0';
       if (has_digit)
       {
          double val = 0.;
          if (sscanf(val_str, "%lf", &val) != 1)
          {
-            free(val_str);
             goto error;
          }
          json_add(o, key, pgmoneta_value_from_double(val), ValueDouble);
-         free(val_str);
       }
       else
       {
          int64_t val = 0;
          if (sscanf(val_str, "%" PRId64, &val) != 1)
          {
-            free(val_str);
             goto error;
          }
          json_add(o, key, (uintptr_t)val, ValueInt64);
-         free(val_str);
       }
    }
    else if (str[idx] == '{')
    {
       struct json* val = NULL;
-      if (parse_string(str, &idx, &val))
+      if (parse_string(str, len, &idx, &val))
       {
          goto error;
       }
@@ -986,7 +991,7 @@ fill_value(char* str, char* key, uint64_t* index, struct json* o)
    else if (str[idx] == '[')
    {
       struct json* val = NULL;
-      if (parse_string(str, &idx, &val))
+      if (parse_string(str, len, &idx, &val))
       {
          goto error;
       }
@@ -994,29 +999,27 @@ fill_value(char* str, char* key, uint64_t* index, struct json* o)
    }
    else if (str[idx] == 'n' || str[idx] == 't' || str[idx] == 'f')
    {
-      char* val = NULL;
+      start = idx;
       while (idx < len && str[idx] >= 'a' && str[idx] <= 'z')
       {
-         val = pgmoneta_append_char(val, str[idx++]);
+         idx++;
       }
-      if (pgmoneta_compare_string(val, "null"))
+      if (idx - start == 4 && !strncmp(str + start, "null", 4))
       {
          json_add(o, key, 0, ValueString);
       }
-      else if (pgmoneta_compare_string(val, "true"))
+      else if (idx - start == 4 && !strncmp(str + start, "true", 4))
       {
          json_add(o, key, true, ValueBool);
       }
-      else if (pgmoneta_compare_string(val, "false"))
+      else if (idx - start == 5 && !strncmp(str + start, "false", 5))
       {
          json_add(o, key, false, ValueBool);
       }
       else
       {
-         free(val);
          goto error;
       }
-      free(val);
    }
    else
    {
@@ -1029,37 +1032,277 @@ error:
 }
 
 static int
-handle_escape_char(char* str, uint64_t* index, uint64_t len, char* ch)
+handle_escape_char(char* str, uint64_t* index, uint64_t len, char* out, int* size)
 {
    uint64_t idx = *index;
+   uint64_t used = 0;
    idx++;
    if (idx == len) // security check
    {
       return 1;
    }
    // Check the next character after checking '\' character
-   switch (str[idx])
+   if (str[idx] == 'u')
+   {
+      if (unescape_unicode(str + idx + 1, len - idx - 1, &used, out, size))
+      {
+         return 1;
+      }
+      *index = idx + 1 + used;
+      return 0;
+   }
+   if (unescape_char(str[idx], out))
+   {
+      return 1;
+   }
+   *size = 1;
+   *index = idx + 1;
+   return 0;
+}
+
+static int
+unescape_char(char ch, char* out)
+{
+   switch (ch)
    {
       case '\"':
       case '\\':
-         *ch = str[idx];
+      case '/':
+         *out = ch;
+         break;
+      case 'b':
+         *out = '\b';
+         break;
+      case 'f':
+         *out = '\f';
          break;
       case 'n':
-         *ch = '\n';
+         *out = '\n';
          break;
       case 't':
-         *ch = '\t';
+         *out = '\t';
          break;
       case 'r':
-         *ch = '\r';
+         *out = '\r';
          break;
       default:
          return 1;
    }
-   *index = idx + 1;
    return 0;
 }
 
+/**
+ * Decode the hex digits after a \u escape as UTF-8. A high surrogate
+ * must be followed by a \u escape of its low surrogate
+ * @param hex The characters after the \u
+ * @param length The number of characters available
+ * @param used [out] The number of characters decoded
+ * @param out [out] The UTF-8 bytes, at least 4
+ * @param size [out] The number of UTF-8 bytes
+ * @return 0 on success, otherwise 1
+ */
+static int
+unescape_unicode(char* hex, uint64_t length, uint64_t* used, char* out, int* size)
+{
+   uint32_t cp = 0;
+   uint32_t low = 0;
+
+   if (length < 4 || hex_code_point(hex, &cp))
+   {
+      return 1;
+   }
+   *used = 4;
+
+   if (cp >= 0xD800 && cp <= 0xDBFF)
+   {
+      if (length < 10 || hex[4] != '\\' || hex[5] != 'u' ||
+          hex_code_point(hex + 6, &low) || low < 0xDC00 || low > 0xDFFF)
+      {
+         return 1;
+      }
+      cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+      *used = 10;
+   }
+   else if ((cp >= 0xDC00 && cp <= 0xDFFF) || cp == 0)
+   {
+      // A lone low surrogate, or a NUL that would end the string
+      return 1;
+   }
+
+   if (cp < 0x80)
+   {
+      out[0] = (char)cp;
+      *size = 1;
+   }
+   else if (cp < 0x800)
+   {
+      out[0] = (char)(0xC0 | (cp >> 6));
+      out[1] = (char)(0x80 | (cp & 0x3F));
+      *size = 2;
+   }
+   else if (cp < 0x10000)
+   {
+      out[0] = (char)(0xE0 | (cp >> 12));
+      out[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+      out[2] = (char)(0x80 | (cp & 0x3F));
+      *size = 3;
+   }
+   else
+   {
+      out[0] = (char)(0xF0 | (cp >> 18));
+      out[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+      out[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+      out[3] = (char)(0x80 | (cp & 0x3F));
+      *size = 4;
+   }
+
+   return 0;
+}
+
+static int
+hex_code_point(char* hex, uint32_t* cp)
+{
+   uint32_t v = 0;
+
+   for (int i = 0; i < 4; i++)
+   {
+      char c = hex[i];
+
+      v <<= 4;
+      if (c >= '0' && c <= '9')
+      {
+         v |= (uint32_t)(c - '0');
+      }
+      else if (c >= 'a' && c <= 'f')
+      {
+         v |= (uint32_t)(c - 'a' + 10);
+      }
+      else if (c >= 'A' && c <= 'F')
+      {
+         v |= (uint32_t)(c - 'A' + 10);
+      }
+      else
+      {
+         return 1;
+      }
+   }
+
+   *cp = v;
+   return 0;
+}
+
+static int
+parse_quoted(char* str, uint64_t len, uint64_t* index, char** value)
+{
+   struct string_builder* sb = NULL;
+   uint64_t idx = *index;
+   uint64_t run = 0;
+   char ec[4];
+   int ec_size = 0;
+
+   *value = NULL;
+
+   run = string_run_length(str + idx, len - idx);
+   if (idx + run == len)
+   {
+      goto error;
+   }
+
+   // Most strings have no escapes, so copy them in one go
+   if (str[idx + run] == '"')
+   {
+      if (run > 0)
+      {
+         *value = (char*)malloc(run + 1);
+         if (*value == NULL)
+         {
+            goto error;
+         }
+         memcpy(*value, str + idx, run);
+         (*value)[run] = '\0';
+      }
+      *index = idx + run + 1;
+      return 0;
+   }
+
+   if (pgmoneta_string_builder_create(0, &sb))
+   {
+      goto error;
+   }
+
+   while (str[idx + run] != '"')
+   {
+      pgmoneta_string_builder_append_bytes(sb, str + idx, run);
+      idx += run;
+      if (handle_escape_char(str, &idx, len, &ec[0], &ec_size))
+      {
+         goto error;
+      }
+      pgmoneta_string_builder_append_bytes(sb, &ec[0], ec_size);
+
+      run = string_run_length(str + idx, len - idx);
+      if (idx + run == len)
+      {
+         goto error;
+      }
+   }
+   pgmoneta_string_builder_append_bytes(sb, str + idx, run);
+
+   *value = pgmoneta_string_builder_release(sb);
+   *index = idx + run + 1;
+   return 0;
+
+error:
+   pgmoneta_string_builder_destroy(sb);
+   return 1;
+}
+
+static uint64_t
+string_run_length(char* str, uint64_t length)
+{
+   uint64_t i = 0;
+#if defined(__SSE2__)
+   __m128i quote = _mm_set1_epi8('"');
+   __m128i backslash = _mm_set1_epi8('\\');
+   __m128i chunk;
+   int mask = 0;
+
+   while (i + 16 <= length)
+   {
+      chunk = _mm_loadu_si128((__m128i*)(str + i));
+      mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)));
+      if (mask != 0)
+      {
+         return i + __builtin_ctz(mask);
+      }
+      i += 16;
+   }
+#elif defined(__ARM_NEON)
+   uint8x16_t quote = vdupq_n_u8('"');
+   uint8x16_t backslash = vdupq_n_u8('\\');
+   uint8x16_t hits;
+   uint64_t mask = 0;
+
+   while (i + 16 <= length)
+   {
+      hits = vld1q_u8((uint8_t*)str + i);
+      hits = vorrq_u8(vceqq_u8(hits, quote), vceqq_u8(hits, backslash));
+      // Narrow to 4 bits per byte so the mask fits in 64 bits
+      mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(hits), 4)), 0);
+      if (mask != 0)
+      {
+         return i + (__builtin_ctzll(mask) >> 2);
+      }
+      i += 16;
+   }
+#endif
+   while (i < length && str[i] != '"' && str[i] != '\\')
+   {
+      i++;
+   }
+   return i;
+}
+
 static int
 advance_to_first_array_element(struct json_reader* reader)
 {
@@ -1192,69 +1435,157 @@ json_peek_next_char(struct json_reader* reader, char* next)
 }
 
 static int
-json_fast_forward_value(struct json_reader* reader, char ch)
+json_read_string(struct json_reader* reader, char** str)
 {
-   if (reader == NULL || reader->state != ValueStart)
-   {
-      goto error;
-   }
-   bool has_next = true;
-   while (ch != '{' && ch != '"' && ch != '[' && !isdigit(ch) && has_next)
+   struct stream_buffer* buffer = reader->buffer;
+   struct string_builder* sb = NULL;
+   uint64_t run = 0;
+   uint64_t used = 0;
+   char ch = 0;
+   char hex[10];
+   char ec[4];
+   int ec_size = 0;
+   int hex_size = 0;
+   uint32_t cp = 0;
+
+   if (str != NULL)
    {
-      has_next = json_next_char(reader, &ch);
+      *str = NULL;
+      if (pgmoneta_string_builder_create(0, &sb))
+      {
+         goto error;
+      }
    }
-   if (ch == '{')
+
+   while (true)
    {
-      int count = 1;
-      while (json_next_char(reader, &ch) && count != 0)
+      // Refill the buffer if it has been drained
+      if (!json_peek_next_char(reader, &ch))
+      {
+         goto error;
+      }
+
+      run = string_run_length(buffer->buffer + buffer->cursor, buffer->end - buffer->cursor);
+      if (sb != NULL)
       {
-         if (ch == '{')
+         pgmoneta_string_builder_append_bytes(sb, buffer->buffer + buffer->cursor, run);
+      }
+      buffer->cursor += run;
+      if (buffer->cursor == buffer->end)
+      {
+         continue;
+      }
+
+      json_next_char(reader, &ch);
+      if (ch == '"')
+      {
+         break;
+      }
+
+      if (!json_next_char(reader, &ch))
+      {
+         goto error;
+      }
+
+      if (ch == 'u')
+      {
+         // Read the hex digits, and the escape of the low surrogate after a high one
+         for (hex_size = 0; hex_size < 4; hex_size++)
          {
-            count++;
+            if (!json_next_char(reader, &hex[hex_size]))
+            {
+               goto error;
+            }
          }
-         else if (ch == '}')
+         if (!hex_code_point(&hex[0], &cp) && cp >= 0xD800 && cp <= 0xDBFF)
          {
-            count--;
+            for (; hex_size < 10; hex_size++)
+            {
+               if (!json_next_char(reader, &hex[hex_size]))
+               {
+                  goto error;
+               }
+            }
+         }
+         if (unescape_unicode(&hex[0], hex_size, &used, &ec[0], &ec_size))
+         {
+            goto error;
          }
       }
-      if (count != 0)
-      {
-         goto error;
-      }
-   }
-   else if (ch == '"')
-   {
-      while (json_next_char(reader, &ch))
+      else
       {
-         if (ch == '"')
+         if (unescape_char(ch, &ec[0]))
          {
-            break;
+            goto error;
          }
+         ec_size = 1;
       }
-      if (ch != '"')
+
+      if (sb != NULL)
       {
-         goto error;
+         pgmoneta_string_builder_append_bytes(sb, &ec[0], ec_size);
       }
    }
-   else if (ch == '[')
+
+   if (str != NULL)
    {
+      *str = pgmoneta_string_builder_release(sb);
+   }
+   return 0;
+
+error:
+   pgmoneta_string_builder_destroy(sb);
+   return 1;
+}
+
+static int
+json_fast_forward_value(struct json_reader* reader, char ch)
+{
+   if (reader == NULL || reader->state != ValueStart)
+   {
+      goto error;
+   }
+   bool has_next = true;
+   while (ch != '{' && ch != '"' && ch != '[' && !isdigit(ch) && has_next)
+   {
+      has_next = json_next_char(reader, &ch);
+   }
+   if (ch == '{' || ch == '[')
+   {
+      char open = ch;
+      char close = ch == '{' ? '}' : ']';
       int count = 1;
-      while (json_next_char(reader, &ch) && count != 0)
+      while (count != 0 && json_next_char(reader, &ch))
       {
-         if (ch == '[')
+         if (ch == open)
          {
             count++;
          }
-         else if (ch == ']')
+         else if (ch == close)
          {
             count--;
          }
+         else if (ch == '"')
+         {
+            // Skip strings so that brackets inside them are not counted
+            if (json_read_string(reader, NULL))
+            {
+               goto error;
+            }
+         }
       }
       if (count != 0)
       {
          goto error;
       }
    }
+   else if (ch == '"')
+   {
+      if (json_read_string(reader, NULL))
+      {
+         goto error;
+      }
+   }
    else if (isdigit(ch))
    {
       while (json_next_char(reader, &ch))
@@ -1295,27 +1626,16 @@ json_stream_parse_item(struct json_reader* reader, struct json** item)
       if (ch != '"' && ch != ':' && ch != '{' && ch != '}' &&
           !(reader->state == ValueStart && (isdigit(ch) || ch == '[')))
       {
-         if (reader->state == KeyStart)
-         {
-            key = pgmoneta_append_char(key, ch);
-         }
          continue;
       }
       if (reader->state == ItemStart)
       {
          if (ch == '"')
          {
-            reader->state = KeyStart;
-         }
-         else
-         {
-            goto error;
-         }
-      }
-      else if (reader->state == KeyStart)
-      {
-         if (ch == '"')
-         {
+            if (json_read_string(reader, &key))
+            {
+               goto error;
+            }
             reader->state = KeyEnd;
          }
          else
@@ -1354,13 +1674,8 @@ json_stream_parse_item(struct json_reader* reader, struct json** item)
             if (ch == '"')
             {
                char* str = NULL;
-               while (json_next_char(reader, &ch) && ch != '"')
-               {
-                  str = pgmoneta_append_char(str, ch);
-               }
-               if (ch != '"')
+               if (json_read_string(reader, &str))
                {
-                  free(str);
                   goto error;
                }
                pgmoneta_json_put(i, key, (uintptr_t)str, ValueString);
@@ -1372,8 +1687,9 @@ json_stream_parse_item(struct json_reader* reader, struct json** item)
             else
             {
                bool has_digit_point = false;
-               char* str = NULL;
-               str = pgmoneta_append_char(str, ch);
+               char str[JSON_NUMBER_LENGTH];
+               int length = 0;
+               str[length++] = ch;
                // peek first in case we advance to non-digit accidentally
                while (json_peek_next_char(reader, &ch) && (isdigit(ch) || ch == '.'))
                {
@@ -1381,7 +1697,6 @@ json_stream_parse_item(struct json_reader* reader, struct json** item)
                   {
                      if (has_digit_point)
                      {
-                        free(str);
                         goto error;
                      }
                      else
@@ -1389,13 +1704,17 @@ json_stream_parse_item(struct json_reader* reader, struct json** item)
                         has_digit_point = true;
                      }
                   }
-                  str = pgmoneta_append_char(str, ch);
+                  if (length == JSON_NUMBER_LENGTH - 1)
+                  {
+                     goto error;
+                  }
+                  str[length++] = ch;
                   // advance
                   json_next_char(reader, &ch);
                }
+               str[length] = '\0';
                if (isdigit(ch) || ch == '.')
                {
-                  free(str);
                   goto error;
                }
                if (has_digit_point)
@@ -1403,11 +1722,8 @@ json_stream_parse_item(struct json_reader* reader, struct json** item)
                   float num = 0;
                   if (sscanf(str, "%f", &num) != 1)
                   {
-                     free(str);
                      goto error;
                   }
-                  free(str);
-                  str = NULL;
                   pgmoneta_json_put(i, key, (uintptr_t)num, ValueFloat);
                }
                else
@@ -1415,11 +1731,8 @@ json_stream_parse_item(struct json_reader* reader, struct json** item)
                   int64_t num = 0;
                   if (sscanf(str, "%" PRId64, &num) != 1)
                   {
-                     free(str);
                      goto error;
                   }
-                  free(str);
-                  str = NULL;
                   pgmoneta_json_put(i, key, (uintptr_t)num, ValueInt64);
                }
                free(key);
@@ -1436,7 +1749,11 @@ json_stream_parse_item(struct json_reader* reader, struct json** item)
       {
          if (ch == '"')
          {
-            reader->state = KeyStart;
+            if (json_read_string(reader, &key))
+            {
+               goto error;
+            }
+            reader->state = KeyEnd;
          }
          else if (ch == '}')
          {
@@ -1461,7 +1778,8 @@ int
 pgmoneta_json_read_file(char* path, struct json** obj)
 {
    FILE* file = NULL;
-   char buf[DEFAULT_BUFFER_SIZE];
+   struct stat st;
+   size_t size = 0;
    char* str = NULL;
    struct json* j = NULL;
 
@@ -1480,15 +1798,22 @@ pgmoneta_json_read_file(char* path, struct json** obj)
       goto error;
    }
 
-   memset(buf, 0, sizeof(buf));
+   // Read the file in one go instead of growing the string chunk by chunk
+   if (fstat(fileno(file), &st) != 0)
+   {
+      pgmoneta_log_error("Failed to stat json file %s", path);
+      goto error;
+   }
 
-   // save the last one for ending so that we get to use append
-   while (fread(buf, 1, DEFAULT_BUFFER_SIZE - 1, file) > 0)
+   str = (char*)malloc(st.st_size + 1);
+   if (str == NULL)
    {
-      str = pgmoneta_append(str, buf);
-      memset(buf, 0, sizeof(buf));
+      goto error;
    }
 
+   size = fread(str, 1, st.st_size, file);
+   str[size] = '\0';
+
    if (pgmoneta_json_parse_string(str, &j))
    {
       pgmoneta_log_error("Failed to parse json file %s", path);
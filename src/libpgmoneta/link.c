@@ -31,6 +31,7 @@
 #include <extraction.h>
 #include <link.h>
 #include <logging.h>
+#include <manifest.h>
 #include <restore.h>
 #include <utils.h>
 
@@ -44,7 +45,7 @@
 
 static void do_link(struct worker_common* wc);
 static void do_relink(struct worker_common* wc);
-static void do_comparefiles(struct worker_common* wc);
+static bool is_same_file(char* from, char* to);
 static char* trim_suffix(char* str);
 
 int
@@ -155,7 +156,15 @@ do_link(struct worker_common* wc)
 {
    struct worker_input* wi = (struct worker_input*)wc;
 
-   if (pgmoneta_exists(wi->to))
+   if (!pgmoneta_exists(wi->to))
+   {
+      pgmoneta_log_debug("%s doesn't exists", wi->to);
+   }
+   else if (pgmoneta_exists(wi->from) && !is_same_file(wi->from, wi->to))
+   {
+      pgmoneta_log_debug("%s differs from %s", wi->from, wi->to);
+   }
+   else
    {
       if (pgmoneta_exists(wi->from))
       {
@@ -167,10 +176,6 @@ do_link(struct worker_common* wc)
       }
       pgmoneta_symlink_file(wi->from, wi->to);
    }
-   else
-   {
-      pgmoneta_log_debug("%s doesn't exists", wi->to);
-   }
 
    free(wi);
 }
@@ -372,115 +377,66 @@ do_relink(struct worker_common* wc)
 int
 pgmoneta_link_comparefiles(char* from, char* to, struct workers* workers)
 {
-   DIR* from_dir = opendir(from);
-   char* from_entry = NULL;
-   char* to_entry = NULL;
-   struct dirent* entry;
-   struct stat statbuf;
-
-   if (from_dir == NULL)
+   char* from_manifest = NULL;
+   char* to_manifest = NULL;
+   char* from_data = NULL;
+   char* to_data = NULL;
+   struct art* deleted = NULL;
+   struct art* changed = NULL;
+   struct art* added = NULL;
+
+   from_manifest = pgmoneta_append(from_manifest, from);
+   if (!pgmoneta_ends_with(from_manifest, "/"))
    {
-      goto error;
+      from_manifest = pgmoneta_append(from_manifest, "/");
    }
+   from_data = pgmoneta_append(from_data, from_manifest);
+   from_data = pgmoneta_append(from_data, "data/");
+   from_manifest = pgmoneta_append(from_manifest, "backup.manifest");
 
-   while ((entry = readdir(from_dir)))
+   to_manifest = pgmoneta_append(to_manifest, to);
+   if (!pgmoneta_ends_with(to_manifest, "/"))
    {
-      if (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, "..") || !strcmp(entry->d_name, "data"))
-      {
-         continue;
-      }
-
-      from_entry = pgmoneta_append(from_entry, from);
-      if (!pgmoneta_ends_with(from_entry, "/"))
-      {
-         from_entry = pgmoneta_append(from_entry, "/");
-      }
-      from_entry = pgmoneta_append(from_entry, entry->d_name);
-
-      to_entry = pgmoneta_append(to_entry, to);
-      if (!pgmoneta_ends_with(to_entry, "/"))
-      {
-         to_entry = pgmoneta_append(to_entry, "/");
-      }
-      to_entry = pgmoneta_append(to_entry, entry->d_name);
-
-      if (!stat(from_entry, &statbuf))
-      {
-         if (S_ISDIR(statbuf.st_mode))
-         {
-            pgmoneta_link_comparefiles(from_entry, to_entry, workers);
-         }
-         else
-         {
-            struct worker_input* wi = NULL;
-
-            if (pgmoneta_create_worker_input(NULL, from_entry, to_entry, 0, workers, &wi))
-            {
-               goto error;
-            }
-
-            if (workers != NULL)
-            {
-               if (workers->outcome)
-               {
-                  pgmoneta_workers_add(workers, do_comparefiles, (struct worker_common*)wi);
-               }
-            }
-            else
-            {
-               do_comparefiles((struct worker_common*)wi);
-            }
-         }
-      }
+      to_manifest = pgmoneta_append(to_manifest, "/");
+   }
+   to_data = pgmoneta_append(to_data, to_manifest);
+   to_data = pgmoneta_append(to_data, "data/");
+   to_manifest = pgmoneta_append(to_manifest, "backup.manifest");
 
-      free(from_entry);
-      free(to_entry);
+   /* Equal checksums in the manifests decide, so neither backup is read */
+   if (pgmoneta_compare_manifests(to_manifest, from_manifest, &deleted, &changed, &added))
+   {
+      goto error;
+   }
 
-      from_entry = NULL;
-      to_entry = NULL;
+   if (pgmoneta_link_manifest(from_data, to_data, from_data, changed, added, workers))
+   {
+      goto error;
    }
 
-   closedir(from_dir);
+   pgmoneta_art_destroy(deleted);
+   pgmoneta_art_destroy(changed);
+   pgmoneta_art_destroy(added);
+   free(from_manifest);
+   free(to_manifest);
+   free(from_data);
+   free(to_data);
 
    return 0;
 
 error:
 
-   if (from_dir != NULL)
-   {
-      closedir(from_dir);
-   }
-
-   free(from_entry);
-   free(to_entry);
+   pgmoneta_art_destroy(deleted);
+   pgmoneta_art_destroy(changed);
+   pgmoneta_art_destroy(added);
+   free(from_manifest);
+   free(to_manifest);
+   free(from_data);
+   free(to_data);
 
    return 1;
 }
 
-static void
-do_comparefiles(struct worker_common* wc)
-{
-   struct worker_input* wi = (struct worker_input*)wc;
-   bool equal;
-
-   equal = pgmoneta_compare_files(wi->from, wi->to);
-
-   if (equal)
-   {
-      if (pgmoneta_exists(wi->from))
-      {
-         pgmoneta_delete_file(wi->from, NULL);
-      }
-      else
-      {
-         pgmoneta_log_debug("%s doesn't exists", wi->from);
-      }
-      pgmoneta_symlink_file(wi->from, wi->to);
-   }
-
-   free(wi);
-}
-
 static char*
 trim_suffix(char* str)
 {
@@ -520,3 +476,26 @@ trim_suffix(char* str)
 
    return res;
 }
+
+static bool
+is_same_file(char* from, char* to)
+{
+   struct stat from_stat;
+   struct stat to_stat;
+   struct main_configuration* config;
+
+   config = (struct main_configuration*)shmem;
+
+   /* The manifest checksums already matched; the sizes of the stored files are a cheap sanity check */
+   if (stat(from, &from_stat) || stat(to, &to_stat) || from_stat.st_size != to_stat.st_size)
+   {
+      return false;
+   }
+
+   if (config->link_paranoid)
+   {
+      return pgmoneta_compare_files(from, to);
+   }
+
+   return true;
+}
@@ -38,10 +38,13 @@
 
 /* system */
 #include <dirent.h>
+#include <errno.h>
 #include <inttypes.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <unistd.h>
 
 #define MANIFEST_KEY_VERSION                 "PostgreSQL-Backup-Manifest-Version"
 #define MANIFEST_KEY_SYS_IDENTIFIER          "System-Identifier"
@@ -55,11 +58,47 @@
 #define MANIFEST_FILE_KEY_LAST_MODIFIED      "Last-Modified"
 #define MANIFEST_FILE_KEY_CHECKSUM           "Checksum"
 
+static bool
+next_entry(struct csv_reader* reader, char*** entry);
+
+static int
+compare_manifest_file(const void* a, const void* b);
+
+static int
+is_sorted(char* manifest, bool* sorted);
+
+static int
+write_run(struct manifest_file* files, int size, char* path);
+
+static int
+merge_runs(char** runs, int number_of_runs, char* path);
+
+static int
+spill_run(char* temp, struct manifest_file* files, int size, char*** runs, int* number_of_runs);
+
+static int
+sort_manifest(char* manifest, char** sorted);
+
+static int
+open_sorted(char* manifest, char** sorted, struct csv_reader** reader);
+
 static void
-build_deque(struct deque* deque, struct csv_reader* reader, char** f);
+free_manifest_files(struct manifest_file* files, int size);
 
 static void
-build_tree(struct art* tree, struct csv_reader* reader, char** f);
+remove_runs(char** runs, int number_of_runs);
+
+static void
+remove_sorted(char* path);
+
+static int
+read_manifest_header(char* path, struct json** manifest);
+
+static int
+write_manifest(struct json* manifest, char* source, struct json* files, char* path);
+
+static void
+write_manifest_file(FILE* file, struct json* f, bool* first);
 
 int
 pgmoneta_manifest_checksum_verify(char* root, struct art* file_checksums, struct art* file_sizes)
@@ -134,154 +173,80 @@ pgmoneta_compare_manifests(char* old_manifest, char* new_manifest, struct art**
    char** f1 = NULL;
    struct csv_reader* r2 = NULL;
    char** f2 = NULL;
+   char* sorted1 = NULL;
+   char* sorted2 = NULL;
    struct art* deleted = NULL;
    struct art* changed = NULL;
    struct art* added = NULL;
-   char* checksum = NULL;
-   int cols = 0;
+   bool has1 = false;
+   bool has2 = false;
+   int cmp = 0;
    bool manifest_changed = false;
-   struct art* tree = NULL;
-   struct deque* que = NULL;
-   struct deque_iterator* iter = NULL;
 
    *deleted_files = NULL;
    *changed_files = NULL;
    *added_files = NULL;
 
-   pgmoneta_deque_create(false, &que);
-
    pgmoneta_art_create(&deleted);
    pgmoneta_art_create(&added);
    pgmoneta_art_create(&changed);
 
-   if (pgmoneta_csv_reader_init(old_manifest, &r1))
+   if (open_sorted(old_manifest, &sorted1, &r1))
    {
       goto error;
    }
 
-   if (pgmoneta_csv_reader_init(new_manifest, &r2))
+   if (open_sorted(new_manifest, &sorted2, &r2))
    {
       goto error;
    }
 
-   while (pgmoneta_csv_next_row(r1, &cols, &f1))
+   // both manifests are ordered by path, so a single merge pass finds all differences
+   has1 = next_entry(r1, &f1);
+   has2 = next_entry(r2, &f2);
+
+   while (has1 || has2)
    {
-      if (cols != MANIFEST_COLUMN_COUNT)
+      if (!has1)
       {
-         pgmoneta_log_error("Incorrect number of columns in manifest file");
-         free(f1);
-         continue;
+         cmp = 1;
       }
-      // build left chunk into a deque
-      build_deque(que, r1, f1);
-      while (pgmoneta_csv_next_row(r2, &cols, &f2))
+      else if (!has2)
       {
-         if (cols != MANIFEST_COLUMN_COUNT)
-         {
-            pgmoneta_log_error("Incorrect number of columns in manifest file");
-            free(f2);
-            continue;
-         }
-         // build every right chunk into an ART
-         pgmoneta_art_create(&tree);
-         build_tree(tree, r2, f2);
-         pgmoneta_deque_iterator_create(que, &iter);
-         while (pgmoneta_deque_iterator_next(iter))
-         {
-            checksum = (char*)pgmoneta_art_search(tree, iter->tag);
-            if (checksum != NULL)
-            {
-               if (!strcmp((char*)pgmoneta_value_data(iter->value), checksum))
-               {
-                  // not changed but not deleted, remove the entry
-                  pgmoneta_deque_iterator_remove(iter);
-               }
-               else
-               {
-                  // file is changed
-                  manifest_changed = true;
-                  pgmoneta_art_insert(changed, iter->tag, pgmoneta_value_data(iter->value), ValueString);
-                  // changed but not deleted, remove the entry
-                  pgmoneta_deque_iterator_remove(iter);
-               }
-            }
-         }
-         pgmoneta_art_destroy(tree);
-         tree = NULL;
+         cmp = -1;
       }
-      pgmoneta_deque_iterator_destroy(iter);
-      iter = NULL;
-
-      // traverse
-      while (!pgmoneta_deque_empty(que))
+      else
       {
-         char* tag = NULL;
-         uintptr_t val = 0;
-         manifest_changed = true;
-         val = pgmoneta_deque_poll(que, &tag);
-         pgmoneta_art_insert(deleted, tag, val, ValueString);
-         free(tag);
-         free((void*)val);
+         cmp = strcmp(f1[MANIFEST_PATH_INDEX], f2[MANIFEST_PATH_INDEX]);
       }
-      // reset right reader for the next left chunk
-      if (pgmoneta_csv_reader_reset(r2))
+
+      if (cmp < 0)
       {
-         goto error;
+         // only in the old manifest
+         manifest_changed = true;
+         pgmoneta_art_insert(deleted, f1[MANIFEST_PATH_INDEX], (uintptr_t)f1[MANIFEST_CHECKSUM_INDEX], ValueString);
+         free(f1);
+         has1 = next_entry(r1, &f1);
       }
-   }
-   if (pgmoneta_csv_reader_reset(r1))
-   {
-      goto error;
-   }
-
-   while (pgmoneta_csv_next_row(r2, &cols, &f2))
-   {
-      if (cols != MANIFEST_COLUMN_COUNT)
+      else if (cmp > 0)
       {
-         pgmoneta_log_error("Incorrect number of columns in manifest file");
+         // only in the new manifest
+         manifest_changed = true;
+         pgmoneta_art_insert(added, f2[MANIFEST_PATH_INDEX], (uintptr_t)f2[MANIFEST_CHECKSUM_INDEX], ValueString);
          free(f2);
-         continue;
+         has2 = next_entry(r2, &f2);
       }
-      build_deque(que, r2, f2);
-      while (pgmoneta_csv_next_row(r1, &cols, &f1))
+      else
       {
-         if (cols != MANIFEST_COLUMN_COUNT)
-         {
-            pgmoneta_log_error("Incorrect number of columns in manifest file");
-            free(f1);
-            continue;
-         }
-         pgmoneta_art_create(&tree);
-         build_tree(tree, r1, f1);
-         pgmoneta_deque_iterator_create(que, &iter);
-         while (pgmoneta_deque_iterator_next(iter))
+         if (strcmp(f1[MANIFEST_CHECKSUM_INDEX], f2[MANIFEST_CHECKSUM_INDEX]))
          {
-            checksum = (char*)pgmoneta_art_search(tree, iter->tag);
-            if (checksum != NULL)
-            {
-               // the entry is not new, remove it
-               pgmoneta_deque_iterator_remove(iter);
-            }
+            manifest_changed = true;
+            pgmoneta_art_insert(changed, f1[MANIFEST_PATH_INDEX], (uintptr_t)f1[MANIFEST_CHECKSUM_INDEX], ValueString);
          }
-         pgmoneta_art_destroy(tree);
-         tree = NULL;
-      }
-      pgmoneta_deque_iterator_destroy(iter);
-      iter = NULL;
-
-      while (!pgmoneta_deque_empty(que))
-      {
-         char* tag = NULL;
-         uintptr_t val = 0;
-         manifest_changed = true;
-         val = pgmoneta_deque_poll(que, &tag);
-         pgmoneta_art_insert(added, tag, val, ValueString);
-         free(tag);
-         free((void*)val);
-      }
-      if (pgmoneta_csv_reader_reset(r1))
-      {
-         goto error;
+         free(f1);
+         free(f2);
+         has1 = next_entry(r1, &f1);
+         has2 = next_entry(r2, &f2);
       }
    }
 
@@ -296,137 +261,95 @@ pgmoneta_compare_manifests(char* old_manifest, char* new_manifest, struct art**
 
    pgmoneta_csv_reader_destroy(r1);
    pgmoneta_csv_reader_destroy(r2);
-   pgmoneta_art_destroy(tree);
-   pgmoneta_deque_destroy(que);
+   remove_sorted(sorted1);
+   remove_sorted(sorted2);
 
    return 0;
 error:
-   pgmoneta_deque_iterator_destroy(iter);
    pgmoneta_csv_reader_destroy(r1);
    pgmoneta_csv_reader_destroy(r2);
-   pgmoneta_art_destroy(tree);
-   pgmoneta_deque_destroy(que);
+   remove_sorted(sorted1);
+   remove_sorted(sorted2);
+   pgmoneta_art_destroy(deleted);
+   pgmoneta_art_destroy(changed);
+   pgmoneta_art_destroy(added);
    return 1;
 }
 
 int
-pgmoneta_write_postgresql_manifest(struct json* manifest, char* path)
+pgmoneta_manifest_sort(char* manifest)
 {
-   FILE* file = NULL;
-   char* checksum = NULL;
-   int version;
-   struct json* files = NULL;
-   struct json* f = NULL;
-   struct json_iterator* fiter = NULL;
-   struct json* wal_ranges = NULL;
-   struct json* r = NULL;
-   struct json_iterator* riter = NULL;
+   bool sorted = false;
+   char* temp = NULL;
 
-   if (path == NULL || manifest == NULL)
+   if (is_sorted(manifest, &sorted))
    {
       goto error;
    }
 
-   if (!pgmoneta_json_contains_key(manifest, MANIFEST_KEY_VERSION))
+   if (sorted)
    {
-      pgmoneta_log_error("Manifest doesn't contain necessary version entry");
-      goto error;
+      return 0;
    }
 
-   version = (int)pgmoneta_json_get(manifest, MANIFEST_KEY_VERSION);
-
-   if ((version >= 2 && !pgmoneta_json_contains_key(manifest, MANIFEST_KEY_SYS_IDENTIFIER)) ||
-       !pgmoneta_json_contains_key(manifest, MANIFEST_KEY_FILES) ||
-       !pgmoneta_json_contains_key(manifest, MANIFEST_KEY_WAL_RANGES))
+   if (sort_manifest(manifest, &temp))
    {
-      pgmoneta_log_error("Manifest doesn't contain necessary entries");
       goto error;
    }
 
-   files = (struct json*)pgmoneta_json_get(manifest, MANIFEST_KEY_FILES);
-   wal_ranges = (struct json*)pgmoneta_json_get(manifest, MANIFEST_KEY_WAL_RANGES);
-
-   pgmoneta_json_iterator_create(files, &fiter);
-   pgmoneta_json_iterator_create(wal_ranges, &riter);
-
-   file = fopen(path, "wb");
-   if (file == NULL)
+   if (rename(temp, manifest))
    {
-      pgmoneta_log_error("Failed to create json file %s", path);
+      pgmoneta_log_error("Could not rename %s to %s: %s", temp, manifest, strerror(errno));
       goto error;
    }
 
-   fprintf(file, "{ \"%s\": %d,\n", MANIFEST_KEY_VERSION, version);
+   free(temp);
 
-   if (pgmoneta_json_contains_key(manifest, MANIFEST_KEY_SYS_IDENTIFIER))
+   return 0;
+
+error:
+   remove_sorted(temp);
+
+   return 1;
+}
+
+int
+pgmoneta_write_postgresql_manifest(struct json* manifest, char* path)
+{
+   if (manifest == NULL)
    {
-      fprintf(file, "\"%s\": %" PRIu64 ",\n", MANIFEST_KEY_SYS_IDENTIFIER,
-              (uint64_t)pgmoneta_json_get(manifest, MANIFEST_KEY_SYS_IDENTIFIER));
+      return 1;
    }
 
-   fprintf(file, "\"%s\": [\n", MANIFEST_KEY_FILES);
-   while (pgmoneta_json_iterator_next(fiter))
+   return write_manifest(manifest, NULL, (struct json*)pgmoneta_json_get(manifest, MANIFEST_KEY_FILES), path);
+}
+
+int
+pgmoneta_write_combined_manifest(char* source, struct json* files, char* path)
+{
+   struct json* header = NULL;
+
+   if (source == NULL || files == NULL)
    {
-      f = (struct json*)pgmoneta_value_data(fiter->value);
-      fprintf(file, "{ \"Path\": \"%s\", \"Size\": %" PRIu64 ", \"Last-Modified\": \"%s\", \"Checksum-Algorithm\": \"%s\", \"Checksum\": \"%s\" }",
-              (char*)pgmoneta_json_get(f, MANIFEST_FILE_KEY_PATH),
-              (uint64_t)pgmoneta_json_get(f, MANIFEST_FILE_KEY_SIZE),
-              (char*)pgmoneta_json_get(f, MANIFEST_FILE_KEY_LAST_MODIFIED),
-              (char*)pgmoneta_json_get(f, MANIFEST_FILE_KEY_CHECKSUM_ALGORITHM),
-              (char*)pgmoneta_json_get(f, MANIFEST_FILE_KEY_CHECKSUM));
-      if (pgmoneta_json_iterator_has_next(fiter))
-      {
-         fprintf(file, ",\n");
-      }
-      else
-      {
-         fprintf(file, "\n");
-      }
+      goto error;
    }
-   fprintf(file, "],\n");
 
-   fprintf(file, "\"%s\": [\n", MANIFEST_KEY_WAL_RANGES);
-   while (pgmoneta_json_iterator_next(riter))
+   if (read_manifest_header(source, &header))
    {
-      r = (struct json*)pgmoneta_value_data(riter->value);
-      fprintf(file, "{ \"Timeline\": %d, \"Start-LSN\": \"%s\", \"End-LSN\": \"%s\" }",
-              (int)pgmoneta_json_get(r, "Timeline"),
-              (char*)pgmoneta_json_get(r, "Start-LSN"),
-              (char*)pgmoneta_json_get(r, "End-LSN"));
-      if (pgmoneta_json_iterator_has_next(riter))
-      {
-         fprintf(file, ",\n");
-      }
-      else
-      {
-         fprintf(file, "\n");
-      }
+      pgmoneta_log_error("Unable to read the manifest header of %s", source);
+      goto error;
    }
-   fprintf(file, "],\n");
-
-   fflush(file);
 
-   if (pgmoneta_create_sha256_file(path, &checksum))
+   if (write_manifest(header, source, files, path))
    {
-      pgmoneta_log_error("unable to get manifest checksum at %s", path);
       goto error;
    }
-   fprintf(file, "\"%s\": \"%s\"}\n", MANIFEST_KEY_CHECKSUM, checksum);
 
-   free(checksum);
-   fclose(file);
-   pgmoneta_json_iterator_destroy(fiter);
-   pgmoneta_json_iterator_destroy(riter);
+   pgmoneta_json_destroy(header);
    return 0;
 
 error:
-   free(checksum);
-   pgmoneta_json_iterator_destroy(fiter);
-   pgmoneta_json_iterator_destroy(riter);
-   if (file != NULL)
-   {
-      fclose(file);
-   }
+   pgmoneta_json_destroy(header);
    return 1;
 }
 
@@ -581,108 +504,657 @@ error:
    return 1;
 }
 
-static void
-build_deque(struct deque* deque, struct csv_reader* reader, char** f)
+static bool
+next_entry(struct csv_reader* reader, char*** entry)
 {
-   char** entry = NULL;
-   char* path = NULL;
-   char* checksum = NULL;
    int cols = 0;
-   if (deque == NULL)
+   char** e = NULL;
+
+   *entry = NULL;
+
+   while (pgmoneta_csv_next_row(reader, &cols, &e))
+   {
+      if (cols == MANIFEST_COLUMN_COUNT)
+      {
+         *entry = e;
+         return true;
+      }
+
+      pgmoneta_log_error("Incorrect number of columns in manifest file");
+      free(e);
+      e = NULL;
+   }
+
+   return false;
+}
+
+static int
+compare_manifest_file(const void* a, const void* b)
+{
+   return strcmp(((struct manifest_file*)a)->path, ((struct manifest_file*)b)->path);
+}
+
+static int
+is_sorted(char* manifest, bool* sorted)
+{
+   struct csv_reader* reader = NULL;
+   char** entry = NULL;
+   char previous[sizeof(reader->line)];
+   bool first = true;
+
+   *sorted = true;
+
+   if (pgmoneta_csv_reader_init(manifest, &reader))
    {
-      return;
+      goto error;
    }
-   path = f[MANIFEST_PATH_INDEX];
-   checksum = f[MANIFEST_CHECKSUM_INDEX];
-   pgmoneta_deque_add(deque, path, (uintptr_t)checksum, ValueString);
-   free(f);
-   while (deque->size < MANIFEST_CHUNK_SIZE && pgmoneta_csv_next_row(reader, &cols, &entry))
+
+   while (next_entry(reader, &entry))
    {
-      if (cols != MANIFEST_COLUMN_COUNT)
+      if (!first && strcmp(previous, entry[MANIFEST_PATH_INDEX]) > 0)
       {
-         pgmoneta_log_error("Incorrect number of columns in manifest file");
+         *sorted = false;
          free(entry);
-         continue;
+         break;
       }
-      path = entry[MANIFEST_PATH_INDEX];
-      checksum = entry[MANIFEST_CHECKSUM_INDEX];
-      pgmoneta_deque_add(deque, path, (uintptr_t)checksum, ValueString);
+
+      pgmoneta_snprintf(previous, sizeof(previous), "%s", entry[MANIFEST_PATH_INDEX]);
+      first = false;
       free(entry);
-      entry = NULL;
    }
+
+   pgmoneta_csv_reader_destroy(reader);
+
+   return 0;
+
+error:
+   pgmoneta_csv_reader_destroy(reader);
+
+   return 1;
 }
 
-static void
-build_tree(struct art* tree, struct csv_reader* reader, char** f)
+static int
+write_run(struct manifest_file* files, int size, char* path)
 {
-   char** entry = NULL;
-   char* path = NULL;
-   int cols = 0;
-   if (tree == NULL)
+   FILE* file = NULL;
+
+   qsort(files, size, sizeof(struct manifest_file), compare_manifest_file);
+
+   file = fopen(path, "w");
+   if (file == NULL)
    {
-      return;
+      pgmoneta_log_error("Could not create %s: %s", path, strerror(errno));
+      goto error;
    }
-   path = f[MANIFEST_PATH_INDEX];
-   pgmoneta_art_insert(tree, path, (uintptr_t)f[MANIFEST_CHECKSUM_INDEX], ValueString);
-   free(f);
-   while (tree->size < MANIFEST_CHUNK_SIZE && pgmoneta_csv_next_row(reader, &cols, &entry))
+
+   for (int i = 0; i < size; i++)
    {
-      if (cols != MANIFEST_COLUMN_COUNT)
+      if (fprintf(file, "%s,%s\n", files[i].path, files[i].checksum) < 0)
       {
-         pgmoneta_log_error("Incorrect number of columns in manifest file");
-         free(entry);
-         continue;
+         goto error;
       }
-      path = entry[MANIFEST_PATH_INDEX];
-      pgmoneta_art_insert(tree, path, (uintptr_t)entry[MANIFEST_CHECKSUM_INDEX], ValueString);
-      free(entry);
    }
+
+   if (fclose(file))
+   {
+      file = NULL;
+      goto error;
+   }
+
+   return 0;
+
+error:
+   if (file != NULL)
+   {
+      fclose(file);
+   }
+
+   return 1;
 }
 
-int
-pgmoneta_manifest_get_paths(char* manifest_path, struct deque** paths)
+static int
+merge_runs(char** runs, int number_of_runs, char* path)
 {
-   int cols = 0;
-   char** entry = NULL;
-   struct csv_reader* reader = NULL;
-   struct deque* deque = NULL;
+   FILE* file = NULL;
+   struct csv_reader** readers = NULL;
+   char*** entries = NULL;
+   int min;
 
-   *paths = NULL;
+   readers = calloc(number_of_runs, sizeof(struct csv_reader*));
+   entries = calloc(number_of_runs, sizeof(char**));
 
-   if (pgmoneta_deque_create(false, &deque))
+   if (readers == NULL || entries == NULL)
    {
       goto error;
    }
 
-   if (pgmoneta_csv_reader_init(manifest_path, &reader))
+   for (int i = 0; i < number_of_runs; i++)
+   {
+      if (pgmoneta_csv_reader_init(runs[i], &readers[i]))
+      {
+         goto error;
+      }
+      next_entry(readers[i], &entries[i]);
+   }
+
+   file = fopen(path, "w");
+   if (file == NULL)
    {
+      pgmoneta_log_error("Could not create %s: %s", path, strerror(errno));
       goto error;
    }
 
-   while (pgmoneta_csv_next_row(reader, &cols, &entry))
+   for (;;)
    {
-      if (cols != MANIFEST_COLUMN_COUNT)
+      min = -1;
+      for (int i = 0; i < number_of_runs; i++)
+      {
+         if (entries[i] != NULL &&
+             (min == -1 || strcmp(entries[i][MANIFEST_PATH_INDEX], entries[min][MANIFEST_PATH_INDEX]) < 0))
+         {
+            min = i;
+         }
+      }
+
+      if (min == -1)
+      {
+         break;
+      }
+
+      if (fprintf(file, "%s,%s\n", entries[min][MANIFEST_PATH_INDEX], entries[min][MANIFEST_CHECKSUM_INDEX]) < 0)
       {
-         pgmoneta_log_error("pgmoneta_manifest_get_paths: incorrect number of columns");
-         free(entry);
          goto error;
       }
 
-      pgmoneta_deque_add(deque, entry[MANIFEST_PATH_INDEX], (uintptr_t)entry[MANIFEST_CHECKSUM_INDEX], ValueString);
-      free(entry);
-      entry = NULL;
+      free(entries[min]);
+      next_entry(readers[min], &entries[min]);
    }
 
-   pgmoneta_csv_reader_destroy(reader);
+   if (fclose(file))
+   {
+      file = NULL;
+      goto error;
+   }
 
-   *paths = deque;
+   for (int i = 0; i < number_of_runs; i++)
+   {
+      pgmoneta_csv_reader_destroy(readers[i]);
+   }
+   free(readers);
+   free(entries);
 
    return 0;
 
 error:
+   if (file != NULL)
+   {
+      fclose(file);
+   }
+   for (int i = 0; readers != NULL && i < number_of_runs; i++)
+   {
+      free(entries != NULL ? entries[i] : NULL);
+      pgmoneta_csv_reader_destroy(readers[i]);
+   }
+   free(readers);
+   free(entries);
 
-   pgmoneta_csv_reader_destroy(reader);
-   pgmoneta_deque_destroy(deque);
+   return 1;
+}
+
+static int
+spill_run(char* temp, struct manifest_file* files, int size, char*** runs, int* number_of_runs)
+{
+   char* run = NULL;
+   char** r = NULL;
+
+   run = pgmoneta_append(run, temp);
+   run = pgmoneta_append_char(run, '.');
+   run = pgmoneta_append_int(run, *number_of_runs);
+
+   r = realloc(*runs, (*number_of_runs + 1) * sizeof(char*));
+   if (run == NULL || r == NULL)
+   {
+      free(run);
+      return 1;
+   }
+
+   r[*number_of_runs] = run;
+   *runs = r;
+   (*number_of_runs)++;
+
+   if (write_run(files, size, run))
+   {
+      return 1;
+   }
+
+   free_manifest_files(files, size);
+
+   return 0;
+}
+
+static int
+sort_manifest(char* manifest, char** sorted)
+{
+   int fd = -1;
+   char* temp = NULL;
+   char** runs = NULL;
+   int number_of_runs = 0;
+   struct csv_reader* reader = NULL;
+   struct manifest_file* files = NULL;
+   char** entry = NULL;
+   int size = 0;
+
+   *sorted = NULL;
+
+   temp = pgmoneta_append(temp, manifest);
+   temp = pgmoneta_append(temp, ".XXXXXX");
+
+   fd = mkstemp(temp);
+   if (fd == -1)
+   {
+      pgmoneta_log_error("Could not create %s: %s", temp, strerror(errno));
+      goto error;
+   }
+   close(fd);
+
+   files = calloc(MANIFEST_SORT_RUN, sizeof(struct manifest_file));
+   if (files == NULL)
+   {
+      goto error;
+   }
+
+   if (pgmoneta_csv_reader_init(manifest, &reader))
+   {
+      goto error;
+   }
+
+   // sort runs of the manifest in memory and spill them to disk
+   while (next_entry(reader, &entry))
+   {
+      files[size].path = strdup(entry[MANIFEST_PATH_INDEX]);
+      files[size].checksum = strdup(entry[MANIFEST_CHECKSUM_INDEX]);
+      free(entry);
+      size++;
+
+      if (files[size - 1].path == NULL || files[size - 1].checksum == NULL)
+      {
+         goto error;
+      }
+
+      if (size == MANIFEST_SORT_RUN)
+      {
+         if (spill_run(temp, files, size, &runs, &number_of_runs))
+         {
+            goto error;
+         }
+         size = 0;
+      }
+   }
+
+   if (number_of_runs == 0)
+   {
+      if (write_run(files, size, temp))
+      {
+         goto error;
+      }
+   }
+   else
+   {
+      if (size > 0)
+      {
+         if (spill_run(temp, files, size, &runs, &number_of_runs))
+         {
+            goto error;
+         }
+         size = 0;
+      }
+
+      if (merge_runs(runs, number_of_runs, temp))
+      {
+         goto error;
+      }
+   }
+
+   pgmoneta_csv_reader_destroy(reader);
+   free_manifest_files(files, size);
+   free(files);
+   remove_runs(runs, number_of_runs);
+
+   *sorted = temp;
+
+   return 0;
+
+error:
+   pgmoneta_csv_reader_destroy(reader);
+   if (files != NULL)
+   {
+      free_manifest_files(files, size);
+   }
+   free(files);
+   remove_runs(runs, number_of_runs);
+   remove_sorted(temp);
+
+   return 1;
+}
+
+static int
+open_sorted(char* manifest, char** sorted, struct csv_reader** reader)
+{
+   bool s = false;
+
+   *sorted = NULL;
+   *reader = NULL;
+
+   if (is_sorted(manifest, &s))
+   {
+      goto error;
+   }
+
+   if (!s)
+   {
+      pgmoneta_log_debug("Sorting manifest %s", manifest);
+
+      if (sort_manifest(manifest, sorted))
+      {
+         goto error;
+      }
+   }
+
+   if (pgmoneta_csv_reader_init(*sorted != NULL ? *sorted : manifest, reader))
+   {
+      goto error;
+   }
+
+   return 0;
+
+error:
+   remove_sorted(*sorted);
+   *sorted = NULL;
+
+   return 1;
+}
+
+static void
+free_manifest_files(struct manifest_file* files, int size)
+{
+   for (int i = 0; i < size; i++)
+   {
+      free(files[i].path);
+      free(files[i].checksum);
+      files[i].path = NULL;
+      files[i].checksum = NULL;
+   }
+}
+
+static void
+remove_runs(char** runs, int number_of_runs)
+{
+   for (int i = 0; i < number_of_runs; i++)
+   {
+      remove_sorted(runs[i]);
+   }
+   free(runs);
+}
+
+static void
+remove_sorted(char* path)
+{
+   if (path != NULL)
+   {
+      remove(path);
+      free(path);
+   }
+}
+
+int
+pgmoneta_manifest_get_paths(char* manifest_path, struct deque** paths)
+{
+   int cols = 0;
+   char** entry = NULL;
+   struct csv_reader* reader = NULL;
+   struct deque* deque = NULL;
+
+   *paths = NULL;
+
+   if (pgmoneta_deque_create(false, &deque))
+   {
+      goto error;
+   }
+
+   if (pgmoneta_csv_reader_init(manifest_path, &reader))
+   {
+      goto error;
+   }
+
+   while (pgmoneta_csv_next_row(reader, &cols, &entry))
+   {
+      if (cols != MANIFEST_COLUMN_COUNT)
+      {
+         pgmoneta_log_error("pgmoneta_manifest_get_paths: incorrect number of columns");
+         free(entry);
+         goto error;
+      }
+
+      pgmoneta_deque_add(deque, entry[MANIFEST_PATH_INDEX], (uintptr_t)entry[MANIFEST_CHECKSUM_INDEX], ValueString);
+      free(entry);
+      entry = NULL;
+   }
+
+   pgmoneta_csv_reader_destroy(reader);
+
+   *paths = deque;
+
+   return 0;
+
+error:
+
+   pgmoneta_csv_reader_destroy(reader);
+   pgmoneta_deque_destroy(deque);
 
    return 1;
 }
+
+static int
+read_manifest_header(char* path, struct json** manifest)
+{
+   char* key_path[1] = {MANIFEST_KEY_WAL_RANGES};
+   struct json_reader* reader = NULL;
+   struct json* m = NULL;
+   struct json* wal_ranges = NULL;
+   struct json* r = NULL;
+
+   *manifest = NULL;
+
+   // the scalars of the root item, the files are skipped without being parsed
+   if (pgmoneta_json_reader_init(path, &reader))
+   {
+      goto error;
+   }
+   if (pgmoneta_json_read_item(reader, &m))
+   {
+      goto error;
+   }
+   pgmoneta_json_reader_close(reader);
+   reader = NULL;
+
+   if (pgmoneta_json_reader_init(path, &reader))
+   {
+      goto error;
+   }
+   if (pgmoneta_json_locate(reader, key_path, 1))
+   {
+      pgmoneta_log_error("cannot locate WAL ranges array in manifest %s", path);
+      goto error;
+   }
+   pgmoneta_json_create_array(false, &wal_ranges);
+   while (pgmoneta_json_next_array_item(reader, &r))
+   {
+      pgmoneta_json_append(wal_ranges, (uintptr_t)r, ValueJSON);
+      r = NULL;
+   }
+   pgmoneta_json_put(m, MANIFEST_KEY_WAL_RANGES, (uintptr_t)wal_ranges, ValueJSON);
+   wal_ranges = NULL;
+
+   pgmoneta_json_reader_close(reader);
+   *manifest = m;
+   return 0;
+
+error:
+   pgmoneta_json_reader_close(reader);
+   pgmoneta_json_destroy(wal_ranges);
+   pgmoneta_json_destroy(m);
+   return 1;
+}
+
+static int
+write_manifest(struct json* manifest, char* source, struct json* files, char* path)
+{
+   FILE* file = NULL;
+   char* checksum = NULL;
+   char* key_path[1] = {MANIFEST_KEY_FILES};
+   int version;
+   bool first = true;
+   struct json* f = NULL;
+   struct json_iterator* fiter = NULL;
+   struct json_reader* reader = NULL;
+   struct json* wal_ranges = NULL;
+   struct json* r = NULL;
+   struct json_iterator* riter = NULL;
+
+   if (path == NULL || manifest == NULL || files == NULL)
+   {
+      goto error;
+   }
+
+   if (!pgmoneta_json_contains_key(manifest, MANIFEST_KEY_VERSION))
+   {
+      pgmoneta_log_error("Manifest doesn't contain necessary version entry");
+      goto error;
+   }
+
+   version = (int)pgmoneta_json_get(manifest, MANIFEST_KEY_VERSION);
+
+   if ((version >= 2 && !pgmoneta_json_contains_key(manifest, MANIFEST_KEY_SYS_IDENTIFIER)) ||
+       !pgmoneta_json_contains_key(manifest, MANIFEST_KEY_WAL_RANGES))
+   {
+      pgmoneta_log_error("Manifest doesn't contain necessary entries");
+      goto error;
+   }
+
+   wal_ranges = (struct json*)pgmoneta_json_get(manifest, MANIFEST_KEY_WAL_RANGES);
+
+   pgmoneta_json_iterator_create(files, &fiter);
+   pgmoneta_json_iterator_create(wal_ranges, &riter);
+
+   if (source != NULL)
+   {
+      if (pgmoneta_json_reader_init(source, &reader))
+      {
+         goto error;
+      }
+      if (pgmoneta_json_locate(reader, key_path, 1))
+      {
+         pgmoneta_log_error("cannot locate files array in manifest %s", source);
+         goto error;
+      }
+   }
+
+   file = fopen(path, "wb");
+   if (file == NULL)
+   {
+      pgmoneta_log_error("Failed to create json file %s", path);
+      goto error;
+   }
+
+   fprintf(file, "{ \"%s\": %d,\n", MANIFEST_KEY_VERSION, version);
+
+   if (pgmoneta_json_contains_key(manifest, MANIFEST_KEY_SYS_IDENTIFIER))
+   {
+      fprintf(file, "\"%s\": %" PRIu64 ",\n", MANIFEST_KEY_SYS_IDENTIFIER,
+              (uint64_t)pgmoneta_json_get(manifest, MANIFEST_KEY_SYS_IDENTIFIER));
+   }
+
+   fprintf(file, "\"%s\": [\n", MANIFEST_KEY_FILES);
+   // stream the source files, its incremental files are replaced by the reconstructed ones
+   while (reader != NULL && pgmoneta_json_next_array_item(reader, &f))
+   {
+      if (!pgmoneta_is_incremental_path((char*)pgmoneta_json_get(f, MANIFEST_FILE_KEY_PATH)))
+      {
+         write_manifest_file(file, f, &first);
+      }
+      pgmoneta_json_destroy(f);
+      f = NULL;
+   }
+   while (pgmoneta_json_iterator_next(fiter))
+   {
+      write_manifest_file(file, (struct json*)pgmoneta_value_data(fiter->value), &first);
+   }
+   if (!first)
+   {
+      fprintf(file, "\n");
+   }
+   fprintf(file, "],\n");
+
+   fprintf(file, "\"%s\": [\n", MANIFEST_KEY_WAL_RANGES);
+   while (pgmoneta_json_iterator_next(riter))
+   {
+      r = (struct json*)pgmoneta_value_data(riter->value);
+      fprintf(file, "{ \"Timeline\": %d, \"Start-LSN\": \"%s\", \"End-LSN\": \"%s\" }",
+              (int)pgmoneta_json_get(r, "Timeline"),
+              (char*)pgmoneta_json_get(r, "Start-LSN"),
+              (char*)pgmoneta_json_get(r, "End-LSN"));
+      if (pgmoneta_json_iterator_has_next(riter))
+      {
+         fprintf(file, ",\n");
+      }
+      else
+      {
+         fprintf(file, "\n");
+      }
+   }
+   fprintf(file, "],\n");
+
+   fflush(file);
+
+   if (pgmoneta_create_sha256_file(path, &checksum))
+   {
+      pgmoneta_log_error("unable to get manifest checksum at %s", path);
+      goto error;
+   }
+   fprintf(file, "\"%s\": \"%s\"}\n", MANIFEST_KEY_CHECKSUM, checksum);
+
+   free(checksum);
+   fclose(file);
+   pgmoneta_json_reader_close(reader);
+   pgmoneta_json_iterator_destroy(fiter);
+   pgmoneta_json_iterator_destroy(riter);
+   return 0;
+
+error:
+   free(checksum);
+   pgmoneta_json_destroy(f);
+   pgmoneta_json_reader_close(reader);
+   pgmoneta_json_iterator_destroy(fiter);
+   pgmoneta_json_iterator_destroy(riter);
+   if (file != NULL)
+   {
+      fclose(file);
+   }
+   return 1;
+}
+
+static void
+write_manifest_file(FILE* file, struct json* f, bool* first)
+{
+   if (!*first)
+   {
+      fprintf(file, ",\n");
+   }
+   fprintf(file, "{ \"Path\": \"%s\", \"Size\": %" PRIu64 ", \"Last-Modified\": \"%s\", \"Checksum-Algorithm\": \"%s\", \"Checksum\": \"%s\" }",
+           (char*)pgmoneta_json_get(f, MANIFEST_FILE_KEY_PATH),
+           (uint64_t)pgmoneta_json_get(f, MANIFEST_FILE_KEY_SIZE),
+           (char*)pgmoneta_json_get(f, MANIFEST_FILE_KEY_LAST_MODIFIED),
+           (char*)pgmoneta_json_get(f, MANIFEST_FILE_KEY_CHECKSUM_ALGORITHM),
+           (char*)pgmoneta_json_get(f, MANIFEST_FILE_KEY_CHECKSUM));
+   *first = false;
+}
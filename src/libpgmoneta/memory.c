@@ -28,15 +28,24 @@
 
 /* pgmoneta */
 #include <pgmoneta.h>
+#include <logging.h>
+#include <memory.h>
 #include <utils.h>
 
 /* system */
 #ifdef DEBUG
 #include <assert.h>
 #endif
+#include <stdarg.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#define REGION_BLOCK_SIZE 65536
+#define REGION_ALIGNMENT  16
+
+static struct region_block* region_block_create(size_t size);
+
 static struct message* message = NULL;
 static void* data = NULL;
 
@@ -181,8 +190,7 @@ pgmoneta_memory_stream_buffer_enlarge(struct stream_buffer* buffer, int bytes_ne
       return 1;
    }
 
-   memset(new_buffer, 0, new_size);
-   memcpy(new_buffer, buffer->buffer, buffer->size);
+   memcpy(new_buffer, buffer->buffer, buffer->end);
 
    free(buffer->buffer);
 
@@ -192,6 +200,24 @@ pgmoneta_memory_stream_buffer_enlarge(struct stream_buffer* buffer, int bytes_ne
    return 0;
 }
 
+void
+pgmoneta_memory_stream_buffer_compact(struct stream_buffer* buffer)
+{
+   if (buffer == NULL || buffer->start == 0)
+   {
+      return;
+   }
+
+   if (buffer->start < buffer->end)
+   {
+      memmove(buffer->buffer, buffer->buffer + buffer->start, buffer->end - buffer->start);
+   }
+
+   buffer->end -= buffer->start;
+   buffer->cursor -= buffer->start;
+   buffer->start = 0;
+}
+
 void
 pgmoneta_memory_stream_buffer_free(struct stream_buffer* buffer)
 {
@@ -206,3 +232,234 @@ pgmoneta_memory_stream_buffer_free(struct stream_buffer* buffer)
    }
    free(buffer);
 }
+
+int
+pgmoneta_memory_region_create(size_t block_size, struct region** region)
+{
+   struct region* r = NULL;
+
+   *region = NULL;
+
+   r = (struct region*)malloc(sizeof(struct region));
+   if (r == NULL)
+   {
+      return 1;
+   }
+   memset(r, 0, sizeof(struct region));
+
+   r->block_size = block_size > 0 ? block_size : REGION_BLOCK_SIZE;
+
+   *region = r;
+
+   return 0;
+}
+
+void*
+pgmoneta_memory_region_alloc(struct region* region, size_t size)
+{
+   struct region_block* block = NULL;
+   uintptr_t start = 0;
+   size_t offset = 0;
+
+   if (region == NULL)
+   {
+      return NULL;
+   }
+
+   block = region->blocks;
+   if (block != NULL)
+   {
+      start = (uintptr_t)(block->data + block->used);
+      offset = block->used + (((start + REGION_ALIGNMENT - 1) & ~(uintptr_t)(REGION_ALIGNMENT - 1)) - start);
+   }
+
+   if (block == NULL || offset + size > block->size)
+   {
+      if (size > region->block_size / 4)
+      {
+         // large allocations get their own block, behind the current one
+         block = region_block_create(size + REGION_ALIGNMENT);
+         if (block == NULL)
+         {
+            return NULL;
+         }
+         if (region->blocks != NULL)
+         {
+            block->next = region->blocks->next;
+            region->blocks->next = block;
+         }
+         else
+         {
+            region->blocks = block;
+         }
+      }
+      else
+      {
+         block = region_block_create(region->block_size);
+         if (block == NULL)
+         {
+            return NULL;
+         }
+         block->next = region->blocks;
+         region->blocks = block;
+      }
+
+      start = (uintptr_t)block->data;
+      offset = ((start + REGION_ALIGNMENT - 1) & ~(uintptr_t)(REGION_ALIGNMENT - 1)) - start;
+
+#ifdef DEBUG
+      region->number_of_blocks++;
+#endif
+   }
+
+   block->used = offset + size;
+
+#ifdef DEBUG
+   region->allocations++;
+   region->bytes += size;
+#endif
+
+   return block->data + offset;
+}
+
+char*
+pgmoneta_memory_region_strdup(struct region* region, const char* s)
+{
+   return pgmoneta_memory_region_append(region, NULL, s);
+}
+
+char*
+pgmoneta_memory_region_append(struct region* region, const char* orig, const char* s)
+{
+   size_t orig_length = 0;
+   size_t s_length = 0;
+   char* n = NULL;
+
+   if (orig == NULL && s == NULL)
+   {
+      return NULL;
+   }
+
+   orig_length = orig != NULL ? strlen(orig) : 0;
+   s_length = s != NULL ? strlen(s) : 0;
+
+   n = (char*)pgmoneta_memory_region_alloc(region, orig_length + s_length + 1);
+   if (n == NULL)
+   {
+      return NULL;
+   }
+
+   if (orig_length > 0)
+   {
+      memcpy(n, orig, orig_length);
+   }
+   if (s_length > 0)
+   {
+      memcpy(n + orig_length, s, s_length);
+   }
+   n[orig_length + s_length] = '\0';
+
+   return n;
+}
+
+char*
+pgmoneta_memory_region_format(struct region* region, const char* fmt, ...)
+{
+   va_list args;
+   int length = 0;
+   char* n = NULL;
+
+   if (fmt == NULL)
+   {
+      return NULL;
+   }
+
+   va_start(args, fmt);
+   length = vsnprintf(NULL, 0, fmt, args);
+   va_end(args);
+
+   if (length < 0)
+   {
+      return NULL;
+   }
+
+   n = (char*)pgmoneta_memory_region_alloc(region, (size_t)length + 1);
+   if (n == NULL)
+   {
+      return NULL;
+   }
+
+   va_start(args, fmt);
+   vsnprintf(n, (size_t)length + 1, fmt, args);
+   va_end(args);
+
+   return n;
+}
+
+void
+pgmoneta_memory_region_reset(struct region* region)
+{
+   struct region_block* block = NULL;
+   struct region_block* next = NULL;
+
+   if (region == NULL)
+   {
+      return;
+   }
+
+   block = region->blocks;
+   while (block != NULL)
+   {
+      next = block->next;
+      free(block);
+      block = next;
+   }
+   region->blocks = NULL;
+}
+
+void
+pgmoneta_memory_region_destroy(struct region* region)
+{
+   if (region == NULL)
+   {
+      return;
+   }
+
+   pgmoneta_memory_region_reset(region);
+   free(region);
+}
+
+void
+pgmoneta_memory_region_statistics(struct region* region, char* name)
+{
+#ifdef DEBUG
+   if (region == NULL)
+   {
+      return;
+   }
+
+   pgmoneta_log_debug("Region %s: %" PRIu64 " allocations, %" PRIu64 " bytes, %" PRIu64 " blocks",
+                      name != NULL ? name : "", region->allocations, region->bytes, region->number_of_blocks);
+#else
+   (void)region;
+   (void)name;
+#endif
+}
+
+static struct region_block*
+region_block_create(size_t size)
+{
+   struct region_block* block = NULL;
+
+   block = (struct region_block*)malloc(sizeof(struct region_block) + size);
+   if (block == NULL)
+   {
+      return NULL;
+   }
+
+   block->next = NULL;
+   block->size = size;
+   block->used = 0;
+
+   return block;
+}
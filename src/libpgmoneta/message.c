@@ -1902,11 +1902,15 @@ pgmoneta_read_copy_stream(int srv, SSL* ssl, int socket, struct stream_buffer* b
    config = (struct main_configuration*)shmem;
 
    /*
-    * if buffer is still too full,
-    * try enlarging it to be at least big enough for one TCP packet (I'm using 1500B here)
-    * we don't expect it to absolutely work
+    * reclaim the space of the consumed messages first, and only if the buffer
+    * is still too full try enlarging it to be at least big enough for one
+    * TCP packet (I'm using 1500B here), we don't expect it to absolutely work
     */
    if (buffer->size - buffer->end < 1500)
+   {
+      pgmoneta_memory_stream_buffer_compact(buffer);
+   }
+   if (buffer->size - buffer->end < 1500)
    {
       if (pgmoneta_memory_stream_buffer_enlarge(buffer, 1500))
       {
@@ -2048,7 +2052,7 @@ pgmoneta_consume_copy_stream(int srv, SSL* ssl, int socket, struct stream_buffer
       m = (struct message*)malloc(sizeof(struct message));
       m->kind = buffer->buffer[buffer->cursor++];
       // try to get message length
-      while (buffer->cursor + 4 >= buffer->end)
+      while (buffer->cursor + 4 > buffer->end)
       {
          status = pgmoneta_read_copy_stream(srv, ssl, socket, buffer);
          if (status == MESSAGE_STATUS_ZERO)
@@ -2062,7 +2066,7 @@ pgmoneta_consume_copy_stream(int srv, SSL* ssl, int socket, struct stream_buffer
       }
       length = pgmoneta_read_int32(buffer->buffer + buffer->cursor);
       // receive the whole message even if we are going to skip it
-      while (buffer->cursor + length >= buffer->end)
+      while (buffer->cursor + length > buffer->end)
       {
          status = pgmoneta_read_copy_stream(srv, ssl, socket, buffer);
          if (status == MESSAGE_STATUS_ZERO)
@@ -2079,6 +2083,8 @@ pgmoneta_consume_copy_stream(int srv, SSL* ssl, int socket, struct stream_buffer
       {
          // skip this message
          keep_read = true;
+         free(m);
+         m = NULL;
          buffer->cursor += length;
          buffer->start = buffer->cursor;
          continue;
@@ -2143,7 +2149,7 @@ pgmoneta_consume_copy_stream_start(int srv, SSL* ssl, int socket, struct stream_
       }
       message->kind = buffer->buffer[buffer->cursor];
       // try to get message length
-      while (buffer->cursor + 1 + 4 >= buffer->end)
+      while (buffer->cursor + 1 + 4 > buffer->end)
       {
          status = pgmoneta_read_copy_stream(srv, ssl, socket, buffer);
          if (status == MESSAGE_STATUS_ZERO)
@@ -2157,8 +2163,21 @@ pgmoneta_consume_copy_stream_start(int srv, SSL* ssl, int socket, struct stream_
       }
       length = pgmoneta_read_int32(buffer->buffer + buffer->cursor + 1);
 
+      // make room for the whole message at once instead of growing per packet
+      if (buffer->cursor + 1 + length > buffer->size)
+      {
+         pgmoneta_memory_stream_buffer_compact(buffer);
+         if (buffer->cursor + 1 + length > buffer->size &&
+             pgmoneta_memory_stream_buffer_enlarge(buffer, buffer->cursor + 1 + length - buffer->size))
+         {
+            pgmoneta_log_error("Fail to enlarge stream buffer");
+            status = MESSAGE_STATUS_ERROR;
+            goto error;
+         }
+      }
+
       // receive the whole message even if we are going to skip it
-      while (buffer->cursor + 1 + length >= buffer->end)
+      while (buffer->cursor + 1 + length > buffer->end)
       {
          status = pgmoneta_read_copy_stream(srv, ssl, socket, buffer);
          if (status == MESSAGE_STATUS_ZERO)
@@ -2212,18 +2231,9 @@ pgmoneta_consume_copy_stream_end(struct stream_buffer* buffer, struct message* m
    int length = pgmoneta_read_int32(buffer->buffer + buffer->cursor + 1);
    buffer->cursor += (1 + length);
    buffer->start = buffer->cursor;
-   // left shift unconsumed data to reuse space
-   if (buffer->start < buffer->end)
-   {
-      if (buffer->start > 0)
-      {
-         memmove(buffer->buffer, buffer->buffer + buffer->start, buffer->end - buffer->start);
-         buffer->end -= buffer->start;
-         buffer->cursor -= buffer->start;
-         buffer->start = 0;
-      }
-   }
-   else
+   // the space of consumed messages is reclaimed lazily by pgmoneta_read_copy_stream,
+   // so only rewind when the buffer is drained
+   if (buffer->start >= buffer->end)
    {
       buffer->start = buffer->end = buffer->cursor = 0;
    }
@@ -225,13 +225,14 @@ pgmoneta_remove_unix_socket(char* directory, char* file)
 }
 
 int
-pgmoneta_connect(char* hostname, int port, int* fd)
+pgmoneta_connect(char* hostname, int port, struct socket_options* options, int* fd)
 {
    struct addrinfo hints = {0};
    struct addrinfo* servinfo = NULL;
    struct addrinfo* p = NULL;
    int yes = 1;
-   size_t buffer_size = DEFAULT_BUFFER_SIZE;
+   int rcvbuf = DEFAULT_BUFFER_SIZE;
+   int sndbuf = DEFAULT_BUFFER_SIZE;
    socklen_t optlen = sizeof(int);
    int rv;
    char sport[6];
@@ -240,6 +241,12 @@ pgmoneta_connect(char* hostname, int port, int* fd)
 
    config = (struct main_configuration*)shmem;
 
+   if (options != NULL)
+   {
+      rcvbuf = options->rcvbuf;
+      sndbuf = options->sndbuf;
+   }
+
    memset(&sport, 0, sizeof(sport));
    sprintf(&sport[0], "%d", port);
 
@@ -295,9 +302,9 @@ pgmoneta_connect(char* hostname, int port, int* fd)
             }
          }
 
-         if (config != NULL)
+         if (config != NULL && rcvbuf > 0)
          {
-            if (setsockopt(*fd, SOL_SOCKET, SO_RCVBUF, &buffer_size, optlen) == -1)
+            if (setsockopt(*fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, optlen) == -1)
             {
                error = errno;
                pgmoneta_disconnect(*fd);
@@ -305,8 +312,11 @@ pgmoneta_connect(char* hostname, int port, int* fd)
                *fd = -1;
                continue;
             }
+         }
 
-            if (setsockopt(*fd, SOL_SOCKET, SO_SNDBUF, &buffer_size, optlen) == -1)
+         if (config != NULL && sndbuf > 0)
+         {
+            if (setsockopt(*fd, SOL_SOCKET, SO_SNDBUF, &sndbuf, optlen) == -1)
             {
                error = errno;
                pgmoneta_disconnect(*fd);
@@ -316,6 +326,29 @@ pgmoneta_connect(char* hostname, int port, int* fd)
             }
          }
 
+         /* The TCP tuning is advisory, so a kernel without support doesn't fail the connection */
+#ifdef TCP_WINDOW_CLAMP
+         if (options != NULL && options->window_clamp > 0)
+         {
+            if (setsockopt(*fd, IPPROTO_TCP, TCP_WINDOW_CLAMP, &options->window_clamp, optlen) == -1)
+            {
+               pgmoneta_log_warn("pgmoneta_connect: TCP_WINDOW_CLAMP %d %s", *fd, strerror(errno));
+               errno = 0;
+            }
+         }
+#endif
+
+#ifdef TCP_NOTSENT_LOWAT
+         if (options != NULL && options->notsent_lowat > 0)
+         {
+            if (setsockopt(*fd, IPPROTO_TCP, TCP_NOTSENT_LOWAT, &options->notsent_lowat, optlen) == -1)
+            {
+               pgmoneta_log_warn("pgmoneta_connect: TCP_NOTSENT_LOWAT %d %s", *fd, strerror(errno));
+               errno = 0;
+            }
+         }
+#endif
+
          if (connect(*fd, p->ai_addr, p->ai_addrlen) == -1)
          {
             error = errno;
@@ -354,6 +387,138 @@ error:
    return 1;
 }
 
+void
+pgmoneta_socket_options(int server, struct socket_options* options)
+{
+   struct main_configuration* config;
+
+   config = (struct main_configuration*)shmem;
+
+   options->rcvbuf = config->socket_rcvbuf;
+   options->sndbuf = config->socket_sndbuf;
+   options->window_clamp = config->tcp_window_clamp;
+   options->notsent_lowat = config->tcp_notsent_lowat;
+
+   if (server >= 0 && server < config->common.number_of_servers)
+   {
+      if (config->common.servers[server].socket_rcvbuf != -1)
+      {
+         options->rcvbuf = config->common.servers[server].socket_rcvbuf;
+      }
+
+      if (config->common.servers[server].socket_sndbuf != -1)
+      {
+         options->sndbuf = config->common.servers[server].socket_sndbuf;
+      }
+
+      if (config->common.servers[server].tcp_window_clamp != -1)
+      {
+         options->window_clamp = config->common.servers[server].tcp_window_clamp;
+      }
+
+      if (config->common.servers[server].tcp_notsent_lowat != -1)
+      {
+         options->notsent_lowat = config->common.servers[server].tcp_notsent_lowat;
+      }
+   }
+}
+
+int
+pgmoneta_socket_busy_poll(int server, int fd)
+{
+   int busy_poll;
+   struct main_configuration* config;
+
+   config = (struct main_configuration*)shmem;
+
+   busy_poll = config->busy_poll;
+   if (config->common.servers[server].busy_poll != -1)
+   {
+      busy_poll = config->common.servers[server].busy_poll;
+   }
+
+   if (busy_poll <= 0)
+   {
+      return 0;
+   }
+
+#ifdef SO_BUSY_POLL
+   if (setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &busy_poll, sizeof(int)) == -1)
+   {
+      /* Raising the value above net.core.busy_read requires CAP_NET_ADMIN */
+      pgmoneta_log_warn("busy_poll: %s %d %s", config->common.servers[server].name, fd, strerror(errno));
+      errno = 0;
+      return 1;
+   }
+
+   pgmoneta_log_debug("busy_poll: %s %dus", config->common.servers[server].name, busy_poll);
+
+   return 0;
+#else
+   pgmoneta_log_warn("busy_poll: Not supported on this platform");
+   return 1;
+#endif
+}
+
+int
+pgmoneta_socket_statistics(int fd, bool cumulative, struct socket_statistics* statistics)
+{
+   int rcvbuf = 0;
+   int sndbuf = 0;
+   socklen_t optlen = sizeof(int);
+
+   if (fd == -1 || statistics == NULL)
+   {
+      return 1;
+   }
+
+   if (getsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, &optlen) == -1)
+   {
+      goto error;
+   }
+
+   optlen = sizeof(int);
+   if (getsockopt(fd, SOL_SOCKET, SO_SNDBUF, &sndbuf, &optlen) == -1)
+   {
+      goto error;
+   }
+
+   atomic_store(&statistics->rcvbuf, rcvbuf);
+   atomic_store(&statistics->sndbuf, sndbuf);
+
+#ifdef HAVE_LINUX
+   struct tcp_info info;
+
+   memset(&info, 0, sizeof(struct tcp_info));
+   optlen = sizeof(struct tcp_info);
+   if (getsockopt(fd, IPPROTO_TCP, TCP_INFO, &info, &optlen) == -1)
+   {
+      goto error;
+   }
+
+   atomic_store(&statistics->rtt, info.tcpi_rtt);
+   if (cumulative)
+   {
+      atomic_fetch_add(&statistics->retransmits, info.tcpi_total_retrans);
+   }
+   else
+   {
+      atomic_store(&statistics->retransmits, info.tcpi_total_retrans);
+   }
+#else
+   (void)cumulative;
+#endif
+
+   return 0;
+
+error:
+
+   pgmoneta_log_debug("socket_statistics: %d %s", fd, strerror(errno));
+   errno = 0;
+
+   return 1;
+}
+
 int
 pgmoneta_connect_unix_socket(char* directory, char* file, int* fd)
 {
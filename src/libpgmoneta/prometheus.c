@@ -39,6 +39,7 @@
 #include <prometheus.h>
 #include <security.h>
 #include <shmem.h>
+#include <usage.h>
 #include <utils.h>
 #include <wal.h>
 #include <workflow.h>
@@ -288,6 +289,33 @@ pgmoneta_prometheus_logging(int type)
    }
 }
 
+int
+pgmoneta_prometheus_metrics(SSL* client_ssl, int client_fd, int* number_of_backups, struct backup*** backups)
+{
+   prometheus_metrics_container_t* container = NULL;
+
+   if (create_metrics_container(&container))
+   {
+      return 1;
+   }
+
+   /* Collect all general metrics */
+   general_information(container);
+
+   if (number_of_backups != NULL && backups != NULL)
+   {
+      backup_information(container, number_of_backups, backups);
+      size_information(container, number_of_backups, backups);
+   }
+
+   /* Stream all ART-stored metrics to the client */
+   output_all_metrics(client_ssl, client_fd, container);
+
+   destroy_metrics_container(container);
+
+   return 0;
+}
+
 static int
 resolve_page(struct message* msg)
 {
@@ -477,6 +505,34 @@ home_page(SSL* client_ssl, int client_fd)
    data = pgmoneta_append(data, "  <h2>pgmoneta_logging_fatal</h2>\n");
    data = pgmoneta_append(data, "  The number of FATAL logging statements\n");
    data = pgmoneta_append(data, "  <p>\n");
+   data = pgmoneta_append(data, "  <h2>pgmoneta_http_tls_connections_total</h2>\n");
+   data = pgmoneta_append(data, "  The number of TLS connections opened to object stores\n");
+   data = pgmoneta_append(data, "  <p>\n");
+   data = pgmoneta_append(data, "  <h2>pgmoneta_http_ktls_connections_total</h2>\n");
+   data = pgmoneta_append(data, "  The number of TLS connections opened to object stores with kTLS offload\n");
+   data = pgmoneta_append(data, "  <table border=\"1\">\n");
+   data = pgmoneta_append(data, "    <tbody>\n");
+   data = pgmoneta_append(data, "      <tr>\n");
+   data = pgmoneta_append(data, "        <td>direction</td>\n");
+   data = pgmoneta_append(data, "        <td>send or receive</td>\n");
+   data = pgmoneta_append(data, "      </tr>\n");
+   data = pgmoneta_append(data, "    </tbody>\n");
+   data = pgmoneta_append(data, "  </table>\n");
+   data = pgmoneta_append(data, "  <p>\n");
+   data = pgmoneta_append(data, "  <h2>pgmoneta_http_socket_buffer</h2>\n");
+   data = pgmoneta_append(data, "  The effective socket buffer size of the last connection to an object store\n");
+   data = pgmoneta_append(data, "  <table border=\"1\">\n");
+   data = pgmoneta_append(data, "    <tbody>\n");
+   data = pgmoneta_append(data, "      <tr>\n");
+   data = pgmoneta_append(data, "        <td>direction</td>\n");
+   data = pgmoneta_append(data, "        <td>send or receive</td>\n");
+   data = pgmoneta_append(data, "      </tr>\n");
+   data = pgmoneta_append(data, "    </tbody>\n");
+   data = pgmoneta_append(data, "  </table>\n");
+   data = pgmoneta_append(data, "  <p>\n");
+   data = pgmoneta_append(data, "  <h2>pgmoneta_http_socket_retransmits</h2>\n");
+   data = pgmoneta_append(data, "  The number of retransmitted TCP segments to object stores\n");
+   data = pgmoneta_append(data, "  <p>\n");
    data = pgmoneta_append(data, "  <h2>pgmoneta_retention_days</h2>\n");
    data = pgmoneta_append(data, "  The retention of pgmoneta in days\n");
    data = pgmoneta_append(data, "  <h2>pgmoneta_retention_weeks</h2>\n");
@@ -529,6 +585,88 @@ home_page(SSL* client_ssl, int client_fd)
    data = pgmoneta_append(data, "  <h2>pgmoneta_wal_streaming</h2>\n");
    data = pgmoneta_append(data, "  The WAL streaming status of a server\n");
    data = pgmoneta_append(data, "  <p>\n");
+   data = pgmoneta_append(data, "  <h2>pgmoneta_wal_streaming_ktls</h2>\n");
+   data = pgmoneta_append(data, "  Is kTLS offload active on the WAL streaming connection of a server\n");
+   data = pgmoneta_append(data, "  <table border=\"1\">\n");
+   data = pgmoneta_append(data, "    <tbody>\n");
+   data = pgmoneta_append(data, "      <tr>\n");
+   data = pgmoneta_append(data, "        <td>name</td>\n");
+   data = pgmoneta_append(data, "        <td>The identifier for the server</td>\n");
+   data = pgmoneta_append(data, "      </tr>\n");
+   data = pgmoneta_append(data, "      <tr>\n");
+   data = pgmoneta_append(data, "        <td>direction</td>\n");
+   data = pgmoneta_append(data, "        <td>send or receive</td>\n");
+   data = pgmoneta_append(data, "      </tr>\n");
+   data = pgmoneta_append(data, "    </tbody>\n");
+   data = pgmoneta_append(data, "  </table>\n");
+   data = pgmoneta_append(data, "  <p>\n");
+   data = pgmoneta_append(data, "  <h2>pgmoneta_server_tls_connections_total</h2>\n");
+   data = pgmoneta_append(data, "  The number of TLS connections opened to a server\n");
+   data = pgmoneta_append(data, "  <p>\n");
+   data = pgmoneta_append(data, "  <h2>pgmoneta_server_ktls_connections_total</h2>\n");
+   data = pgmoneta_append(data, "  The number of TLS connections opened to a server with kTLS offload\n");
+   data = pgmoneta_append(data, "  <table border=\"1\">\n");
+   data = pgmoneta_append(data, "    <tbody>\n");
+   data = pgmoneta_append(data, "      <tr>\n");
+   data = pgmoneta_append(data, "        <td>name</td>\n");
+   data = pgmoneta_append(data, "        <td>The identifier for the server</td>\n");
+   data = pgmoneta_append(data, "      </tr>\n");
+   data = pgmoneta_append(data, "      <tr>\n");
+   data = pgmoneta_append(data, "        <td>direction</td>\n");
+   data = pgmoneta_append(data, "        <td>send or receive</td>\n");
+   data = pgmoneta_append(data, "      </tr>\n");
+   data = pgmoneta_append(data, "    </tbody>\n");
+   data = pgmoneta_append(data, "  </table>\n");
+   data = pgmoneta_append(data, "  <p>\n");
+   data = pgmoneta_append(data, "  <h2>pgmoneta_server_socket_buffer</h2>\n");
+   data = pgmoneta_append(data, "  The effective socket buffer size of a server connection\n");
+   data = pgmoneta_append(data, "  <table border=\"1\">\n");
+   data = pgmoneta_append(data, "    <tbody>\n");
+   data = pgmoneta_append(data, "      <tr>\n");
+   data = pgmoneta_append(data, "        <td>name</td>\n");
+   data = pgmoneta_append(data, "        <td>The identifier for the server</td>\n");
+   data = pgmoneta_append(data, "      </tr>\n");
+   data = pgmoneta_append(data, "      <tr>\n");
+   data = pgmoneta_append(data, "        <td>connection</td>\n");
+   data = pgmoneta_append(data, "        <td>wal or backup</td>\n");
+   data = pgmoneta_append(data, "      </tr>\n");
+   data = pgmoneta_append(data, "      <tr>\n");
+   data = pgmoneta_append(data, "        <td>direction</td>\n");
+   data = pgmoneta_append(data, "        <td>send or receive</td>\n");
+   data = pgmoneta_append(data, "      </tr>\n");
+   data = pgmoneta_append(data, "    </tbody>\n");
+   data = pgmoneta_append(data, "  </table>\n");
+   data = pgmoneta_append(data, "  <p>\n");
+   data = pgmoneta_append(data, "  <h2>pgmoneta_server_socket_rtt</h2>\n");
+   data = pgmoneta_append(data, "  The smoothed round trip time of a server connection in microseconds\n");
+   data = pgmoneta_append(data, "  <table border=\"1\">\n");
+   data = pgmoneta_append(data, "    <tbody>\n");
+   data = pgmoneta_append(data, "      <tr>\n");
+   data = pgmoneta_append(data, "        <td>name</td>\n");
+   data = pgmoneta_append(data, "        <td>The identifier for the server</td>\n");
+   data = pgmoneta_append(data, "      </tr>\n");
+   data = pgmoneta_append(data, "      <tr>\n");
+   data = pgmoneta_append(data, "        <td>connection</td>\n");
+   data = pgmoneta_append(data, "        <td>wal or backup</td>\n");
+   data = pgmoneta_append(data, "      </tr>\n");
+   data = pgmoneta_append(data, "    </tbody>\n");
+   data = pgmoneta_append(data, "  </table>\n");
+   data = pgmoneta_append(data, "  <p>\n");
+   data = pgmoneta_append(data, "  <h2>pgmoneta_server_socket_retransmits</h2>\n");
+   data = pgmoneta_append(data, "  The number of retransmitted TCP segments of a server connection\n");
+   data = pgmoneta_append(data, "  <table border=\"1\">\n");
+   data = pgmoneta_append(data, "    <tbody>\n");
+   data = pgmoneta_append(data, "      <tr>\n");
+   data = pgmoneta_append(data, "        <td>name</td>\n");
+   data = pgmoneta_append(data, "        <td>The identifier for the server</td>\n");
+   data = pgmoneta_append(data, "      </tr>\n");
+   data = pgmoneta_append(data, "      <tr>\n");
+   data = pgmoneta_append(data, "        <td>connection</td>\n");
+   data = pgmoneta_append(data, "        <td>wal or backup</td>\n");
+   data = pgmoneta_append(data, "      </tr>\n");
+   data = pgmoneta_append(data, "    </tbody>\n");
+   data = pgmoneta_append(data, "  </table>\n");
+   data = pgmoneta_append(data, "  <p>\n");
    data = pgmoneta_append(data, "  <h2>pgmoneta_server_operation_count</h2>\n");
    data = pgmoneta_append(data, "  The count of client operations of a server\n");
    data = pgmoneta_append(data, "  <p>\n");
@@ -877,6 +1015,21 @@ home_page(SSL* client_ssl, int client_fd)
    data = pgmoneta_append(data, "    </tbody>\n");
    data = pgmoneta_append(data, "  </table>\n");
    data = pgmoneta_append(data, "  <p>\n");
+   data = pgmoneta_append(data, "  <h2>pgmoneta_backup_dedup_ratio</h2>\n");
+   data = pgmoneta_append(data, "  The share of the chunked data of a backup that was already in the chunk store\n");
+   data = pgmoneta_append(data, "  <table border=\"1\">\n");
+   data = pgmoneta_append(data, "    <tbody>\n");
+   data = pgmoneta_append(data, "      <tr>\n");
+   data = pgmoneta_append(data, "        <td>name</td>\n");
+   data = pgmoneta_append(data, "        <td>The identifier for the server</td>\n");
+   data = pgmoneta_append(data, "      </tr>\n");
+   data = pgmoneta_append(data, "      <tr>\n");
+   data = pgmoneta_append(data, "        <td>label</td>\n");
+   data = pgmoneta_append(data, "        <td>The backup label</td>\n");
+   data = pgmoneta_append(data, "      </tr>\n");
+   data = pgmoneta_append(data, "    </tbody>\n");
+   data = pgmoneta_append(data, "  </table>\n");
+   data = pgmoneta_append(data, "  <p>\n");
    data = pgmoneta_append(data, "  <h2>pgmoneta_backup_remote_ssh_elapsed_time</h2>\n");
    data = pgmoneta_append(data, "  The duration for remote ssh in seconds for a server\n");
    data = pgmoneta_append(data, "  <table border=\"1\">\n");
@@ -1267,6 +1420,17 @@ home_page(SSL* client_ssl, int client_fd)
    data = pgmoneta_append(data, "    </tbody>\n");
    data = pgmoneta_append(data, "  </table>\n");
    data = pgmoneta_append(data, "  <p>\n");
+   data = pgmoneta_append(data, "  <h2>pgmoneta_backup_dedup_saved_size</h2>\n");
+   data = pgmoneta_append(data, "  The size of the chunked data of the backups for a server that the chunk store already held\n");
+   data = pgmoneta_append(data, "  <table border=\"1\">\n");
+   data = pgmoneta_append(data, "    <tbody>\n");
+   data = pgmoneta_append(data, "      <tr>\n");
+   data = pgmoneta_append(data, "        <td>name</td>\n");
+   data = pgmoneta_append(data, "        <td>The identifier for the server</td>\n");
+   data = pgmoneta_append(data, "      </tr>\n");
+   data = pgmoneta_append(data, "    </tbody>\n");
+   data = pgmoneta_append(data, "  </table>\n");
+   data = pgmoneta_append(data, "  <p>\n");
    data = pgmoneta_append(data, "  <h2>pgmoneta_wal_total_size</h2>\n");
    data = pgmoneta_append(data, "  The total size of the WAL for a server\n");
    data = pgmoneta_append(data, "  <table border=\"1\">\n");
@@ -1467,55 +1631,44 @@ retry_cache_locking:
          free(data);
          data = NULL;
 
-         /* Create ART metrics container */
-         prometheus_metrics_container_t* container = NULL;
-
-         if (create_metrics_container(&container) == 0)
-         {
-            /* Collect all general metrics */
-            general_information(container);
+         /* Load backups once for all servers */
+         int* num_backups = NULL;
+         struct backup*** all_backups = NULL;
 
-            /* Load backups once for all servers */
-            int* num_backups = NULL;
-            struct backup*** all_backups = NULL;
+         num_backups = malloc(config->common.number_of_servers * sizeof(int));
+         all_backups = malloc(config->common.number_of_servers * sizeof(struct backup**));
 
-            num_backups = malloc(config->common.number_of_servers * sizeof(int));
-            all_backups = malloc(config->common.number_of_servers * sizeof(struct backup**));
-
-            if (num_backups != NULL && all_backups != NULL)
+         if (num_backups != NULL && all_backups != NULL)
+         {
+            for (int i = 0; i < config->common.number_of_servers; i++)
             {
-               for (int i = 0; i < config->common.number_of_servers; i++)
-               {
-                  char* d = pgmoneta_get_server_backup(i);
-                  num_backups[i] = 0;
-                  all_backups[i] = NULL;
-                  pgmoneta_load_infos(d, &num_backups[i], &all_backups[i]);
-                  free(d);
-               }
+               char* d = pgmoneta_get_server_backup(i);
+               num_backups[i] = 0;
+               all_backups[i] = NULL;
+               pgmoneta_load_infos(d, &num_backups[i], &all_backups[i]);
+               free(d);
+            }
 
-               backup_information(container, num_backups, all_backups);
-               size_information(container, num_backups, all_backups);
+            pgmoneta_prometheus_metrics(client_ssl, client_fd, num_backups, all_backups);
 
-               /* Free all backups */
-               for (int i = 0; i < config->common.number_of_servers; i++)
+            /* Free all backups */
+            for (int i = 0; i < config->common.number_of_servers; i++)
+            {
+               for (int j = 0; j < num_backups[i]; j++)
                {
-                  for (int j = 0; j < num_backups[i]; j++)
-                  {
-                     free(all_backups[i][j]);
-                  }
-                  free(all_backups[i]);
+                  free(all_backups[i][j]);
                }
+               free(all_backups[i]);
             }
-
-            free(num_backups);
-            free(all_backups);
-
-            /* Stream all ART-stored metrics to the client */
-            output_all_metrics(client_ssl, client_fd, container);
-
-            destroy_metrics_container(container);
+         }
+         else
+         {
+            pgmoneta_prometheus_metrics(client_ssl, client_fd, NULL, NULL);
          }
 
+         free(num_backups);
+         free(all_backups);
+
          /* Footer */
          data = pgmoneta_append(data, "0\r\n\r\n");
          metrics_cache_append(data);
@@ -1593,7 +1746,7 @@ general_information(prometheus_metrics_container_t* container)
    char* d;
    unsigned long size;
    int retention;
-   char* data = NULL;
+   struct string_builder* data = NULL;
    time_t t;
    char time_str[128];
    struct tm* time_info;
@@ -1601,192 +1754,211 @@ general_information(prometheus_metrics_container_t* container)
 
    config = (struct main_configuration*)shmem;
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_state The state of pgmoneta\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_state gauge\n");
-   data = pgmoneta_append(data, "pgmoneta_state ");
-   data = pgmoneta_append(data, "1");
-   data = pgmoneta_append(data, "\n\n");
-   add_metric_to_art(container->general_metrics, "pgmoneta_state", data, NULL, NULL, 0);
-   free(data);
-   data = NULL;
-   data = pgmoneta_append(data, "#HELP pgmoneta_version The version of pgmoneta\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_version gauge\n");
-   data = pgmoneta_append(data, "pgmoneta_version{version=\"");
-   data = pgmoneta_append(data, VERSION);
-   data = pgmoneta_append(data, "\"} 1");
-   data = pgmoneta_append(data, "\n\n");
-   add_metric_to_art(container->general_metrics, "pgmoneta_version", data, NULL, NULL, 0);
-   free(data);
-   data = NULL;
-   data = pgmoneta_append(data, "#HELP pgmoneta_fips Is pgmoneta running in FIPS mode\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_fips gauge\n");
-   data = pgmoneta_append(data, "pgmoneta_fips ");
-   data = pgmoneta_append_int(data, pgmoneta_fips_pgmoneta() ? 1 : 0);
-   data = pgmoneta_append(data, "\n\n");
-   add_metric_to_art(container->general_metrics, "pgmoneta_fips", data, NULL, NULL, 0);
-   free(data);
-   data = NULL;
-   data = pgmoneta_append(data, "#HELP pgmoneta_logging_info The number of INFO logging statements\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_logging_info gauge\n");
-   data = pgmoneta_append(data, "pgmoneta_logging_info ");
-   data = pgmoneta_append_ulong(data, atomic_load(&config->common.prometheus.logging_info));
-   data = pgmoneta_append(data, "\n\n");
-   add_metric_to_art(container->general_metrics, "pgmoneta_logging_info", data, NULL, NULL, 0);
-   free(data);
-   data = NULL;
-   data = pgmoneta_append(data, "#HELP pgmoneta_logging_warn The number of WARN logging statements\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_logging_warn gauge\n");
-   data = pgmoneta_append(data, "pgmoneta_logging_warn ");
-   data = pgmoneta_append_ulong(data, atomic_load(&config->common.prometheus.logging_warn));
-   data = pgmoneta_append(data, "\n\n");
-   add_metric_to_art(container->general_metrics, "pgmoneta_logging_warn", data, NULL, NULL, 0);
-   free(data);
-   data = NULL;
-   data = pgmoneta_append(data, "#HELP pgmoneta_logging_error The number of ERROR logging statements\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_logging_error gauge\n");
-   data = pgmoneta_append(data, "pgmoneta_logging_error ");
-   data = pgmoneta_append_ulong(data, atomic_load(&config->common.prometheus.logging_error));
-   data = pgmoneta_append(data, "\n\n");
-   add_metric_to_art(container->general_metrics, "pgmoneta_logging_error", data, NULL, NULL, 0);
-   free(data);
-   data = NULL;
-   data = pgmoneta_append(data, "#HELP pgmoneta_logging_fatal The number of FATAL logging statements\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_logging_fatal gauge\n");
-   data = pgmoneta_append(data, "pgmoneta_logging_fatal ");
-   data = pgmoneta_append_ulong(data, atomic_load(&config->common.prometheus.logging_fatal));
-   data = pgmoneta_append(data, "\n\n");
-   add_metric_to_art(container->general_metrics, "pgmoneta_logging_fatal", data, NULL, NULL, 0);
-   free(data);
-   data = NULL;
-   data = pgmoneta_append(data, "#HELP pgmoneta_retention_days The retention days of pgmoneta\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_retention_days gauge\n");
-   data = pgmoneta_append(data, "pgmoneta_retention_days ");
-   data = pgmoneta_append_int(data, config->retention_days <= 0 ? 0 : config->retention_days);
-   data = pgmoneta_append(data, "\n\n");
-
-   add_metric_to_art(container->general_metrics, "pgmoneta_retention_days", data, NULL, NULL, 0);
-   free(data);
-   data = NULL;
-   data = pgmoneta_append(data, "#HELP pgmoneta_retention_weeks The retention weeks of pgmoneta\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_retention_weeks gauge\n");
-   data = pgmoneta_append(data, "pgmoneta_retention_weeks ");
-   data = pgmoneta_append_int(data, config->retention_weeks <= 0 ? 0 : config->retention_weeks);
-   data = pgmoneta_append(data, "\n\n");
-
-   add_metric_to_art(container->general_metrics, "pgmoneta_retention_weeks", data, NULL, NULL, 0);
-   free(data);
-   data = NULL;
-   data = pgmoneta_append(data, "#HELP pgmoneta_retention_months The retention months of pgmoneta\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_retention_months gauge\n");
-   data = pgmoneta_append(data, "pgmoneta_retention_months ");
-   data = pgmoneta_append_int(data, config->retention_months <= 0 ? 0 : config->retention_months);
-   data = pgmoneta_append(data, "\n\n");
-
-   add_metric_to_art(container->general_metrics, "pgmoneta_retention_months", data, NULL, NULL, 0);
-   free(data);
-   data = NULL;
-   data = pgmoneta_append(data, "#HELP pgmoneta_retention_years The retention years of pgmoneta\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_retention_years gauge\n");
-   data = pgmoneta_append(data, "pgmoneta_retention_years ");
-   data = pgmoneta_append_int(data, config->retention_years <= 0 ? 0 : config->retention_years);
-   data = pgmoneta_append(data, "\n\n");
+   if (pgmoneta_string_builder_create(0, &data))
+   {
+      return;
+   }
 
-   add_metric_to_art(container->general_metrics, "pgmoneta_retention_years", data, NULL, NULL, 0);
-   free(data);
-   data = NULL;
-   data = pgmoneta_append(data, "#HELP pgmoneta_retention_server The retention of a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_retention_server gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_state The state of pgmoneta\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_state gauge\n");
+   pgmoneta_string_builder_append(data, "pgmoneta_state ");
+   pgmoneta_string_builder_append(data, "1");
+   pgmoneta_string_builder_append(data, "\n\n");
+   add_metric_to_art(container->general_metrics, "pgmoneta_state", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_version The version of pgmoneta\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_version gauge\n");
+   pgmoneta_string_builder_append(data, "pgmoneta_version{version=\"");
+   pgmoneta_string_builder_append(data, VERSION);
+   pgmoneta_string_builder_append(data, "\"} 1");
+   pgmoneta_string_builder_append(data, "\n\n");
+   add_metric_to_art(container->general_metrics, "pgmoneta_version", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_fips Is pgmoneta running in FIPS mode\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_fips gauge\n");
+   pgmoneta_string_builder_append(data, "pgmoneta_fips ");
+   pgmoneta_string_builder_append_int(data, pgmoneta_fips_pgmoneta() ? 1 : 0);
+   pgmoneta_string_builder_append(data, "\n\n");
+   add_metric_to_art(container->general_metrics, "pgmoneta_fips", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_logging_info The number of INFO logging statements\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_logging_info gauge\n");
+   pgmoneta_string_builder_append(data, "pgmoneta_logging_info ");
+   pgmoneta_string_builder_append_ulong(data, atomic_load(&config->common.prometheus.logging_info));
+   pgmoneta_string_builder_append(data, "\n\n");
+   add_metric_to_art(container->general_metrics, "pgmoneta_logging_info", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_logging_warn The number of WARN logging statements\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_logging_warn gauge\n");
+   pgmoneta_string_builder_append(data, "pgmoneta_logging_warn ");
+   pgmoneta_string_builder_append_ulong(data, atomic_load(&config->common.prometheus.logging_warn));
+   pgmoneta_string_builder_append(data, "\n\n");
+   add_metric_to_art(container->general_metrics, "pgmoneta_logging_warn", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_logging_error The number of ERROR logging statements\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_logging_error gauge\n");
+   pgmoneta_string_builder_append(data, "pgmoneta_logging_error ");
+   pgmoneta_string_builder_append_ulong(data, atomic_load(&config->common.prometheus.logging_error));
+   pgmoneta_string_builder_append(data, "\n\n");
+   add_metric_to_art(container->general_metrics, "pgmoneta_logging_error", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_logging_fatal The number of FATAL logging statements\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_logging_fatal gauge\n");
+   pgmoneta_string_builder_append(data, "pgmoneta_logging_fatal ");
+   pgmoneta_string_builder_append_ulong(data, atomic_load(&config->common.prometheus.logging_fatal));
+   pgmoneta_string_builder_append(data, "\n\n");
+   add_metric_to_art(container->general_metrics, "pgmoneta_logging_fatal", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_http_tls_connections_total The number of TLS connections opened to object stores\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_http_tls_connections_total counter\n");
+   pgmoneta_string_builder_append(data, "pgmoneta_http_tls_connections_total ");
+   pgmoneta_string_builder_append_ulong(data, atomic_load(&config->http_tls.connections));
+   pgmoneta_string_builder_append(data, "\n\n");
+   add_metric_to_art(container->general_metrics, "pgmoneta_http_tls_connections_total", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_http_ktls_connections_total The number of TLS connections opened to object stores with kTLS offload\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_http_ktls_connections_total counter\n");
+   pgmoneta_string_builder_append(data, "pgmoneta_http_ktls_connections_total{direction=\"send\"} ");
+   pgmoneta_string_builder_append_ulong(data, atomic_load(&config->http_tls.ktls_send));
+   pgmoneta_string_builder_append(data, "\n");
+   pgmoneta_string_builder_append(data, "pgmoneta_http_ktls_connections_total{direction=\"receive\"} ");
+   pgmoneta_string_builder_append_ulong(data, atomic_load(&config->http_tls.ktls_receive));
+   pgmoneta_string_builder_append(data, "\n\n");
+   add_metric_to_art(container->general_metrics, "pgmoneta_http_ktls_connections_total", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_http_socket_buffer The effective socket buffer size of the last connection to an object store\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_http_socket_buffer gauge\n");
+   pgmoneta_string_builder_append(data, "pgmoneta_http_socket_buffer{direction=\"send\"} ");
+   pgmoneta_string_builder_append_int(data, atomic_load(&config->http_socket.sndbuf));
+   pgmoneta_string_builder_append(data, "\n");
+   pgmoneta_string_builder_append(data, "pgmoneta_http_socket_buffer{direction=\"receive\"} ");
+   pgmoneta_string_builder_append_int(data, atomic_load(&config->http_socket.rcvbuf));
+   pgmoneta_string_builder_append(data, "\n\n");
+   add_metric_to_art(container->general_metrics, "pgmoneta_http_socket_buffer", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_http_socket_retransmits The number of retransmitted TCP segments to object stores\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_http_socket_retransmits gauge\n");
+   pgmoneta_string_builder_append(data, "pgmoneta_http_socket_retransmits ");
+   pgmoneta_string_builder_append_ulong(data, atomic_load(&config->http_socket.retransmits));
+   pgmoneta_string_builder_append(data, "\n\n");
+   add_metric_to_art(container->general_metrics, "pgmoneta_http_socket_retransmits", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_retention_days The retention days of pgmoneta\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_retention_days gauge\n");
+   pgmoneta_string_builder_append(data, "pgmoneta_retention_days ");
+   pgmoneta_string_builder_append_int(data, config->retention_days <= 0 ? 0 : config->retention_days);
+   pgmoneta_string_builder_append(data, "\n\n");
+
+   add_metric_to_art(container->general_metrics, "pgmoneta_retention_days", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_retention_weeks The retention weeks of pgmoneta\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_retention_weeks gauge\n");
+   pgmoneta_string_builder_append(data, "pgmoneta_retention_weeks ");
+   pgmoneta_string_builder_append_int(data, config->retention_weeks <= 0 ? 0 : config->retention_weeks);
+   pgmoneta_string_builder_append(data, "\n\n");
+
+   add_metric_to_art(container->general_metrics, "pgmoneta_retention_weeks", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_retention_months The retention months of pgmoneta\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_retention_months gauge\n");
+   pgmoneta_string_builder_append(data, "pgmoneta_retention_months ");
+   pgmoneta_string_builder_append_int(data, config->retention_months <= 0 ? 0 : config->retention_months);
+   pgmoneta_string_builder_append(data, "\n\n");
+
+   add_metric_to_art(container->general_metrics, "pgmoneta_retention_months", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_retention_years The retention years of pgmoneta\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_retention_years gauge\n");
+   pgmoneta_string_builder_append(data, "pgmoneta_retention_years ");
+   pgmoneta_string_builder_append_int(data, config->retention_years <= 0 ? 0 : config->retention_years);
+   pgmoneta_string_builder_append(data, "\n\n");
+
+   add_metric_to_art(container->general_metrics, "pgmoneta_retention_years", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_retention_server The retention of a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_retention_server gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
-      data = pgmoneta_append(data, "pgmoneta_retention_server{");
+      pgmoneta_string_builder_append(data, "pgmoneta_retention_server{");
 
-      data = pgmoneta_append(data, "name=\"");
-      data = pgmoneta_append(data, config->common.servers[i].name);
-      data = pgmoneta_append(data, "\"");
-      data = pgmoneta_append(data, ", ");
-      data = pgmoneta_append(data, "parameter=\"days\"");
-      data = pgmoneta_append(data, "} ");
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\"");
+      pgmoneta_string_builder_append(data, ", ");
+      pgmoneta_string_builder_append(data, "parameter=\"days\"");
+      pgmoneta_string_builder_append(data, "} ");
       retention = config->common.servers[i].retention_days;
       if (retention <= 0)
       {
          retention = config->retention_days;
       }
-      data = pgmoneta_append_int(data, retention <= 0 ? 0 : retention);
-      data = pgmoneta_append(data, "\n");
+      pgmoneta_string_builder_append_int(data, retention <= 0 ? 0 : retention);
+      pgmoneta_string_builder_append(data, "\n");
 
-      data = pgmoneta_append(data, "pgmoneta_retention_server{");
-      data = pgmoneta_append(data, "name=\"");
-      data = pgmoneta_append(data, config->common.servers[i].name);
-      data = pgmoneta_append(data, "\"");
-      data = pgmoneta_append(data, ", ");
-      data = pgmoneta_append(data, "parameter=\"weeks\"");
-      data = pgmoneta_append(data, "} ");
+      pgmoneta_string_builder_append(data, "pgmoneta_retention_server{");
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\"");
+      pgmoneta_string_builder_append(data, ", ");
+      pgmoneta_string_builder_append(data, "parameter=\"weeks\"");
+      pgmoneta_string_builder_append(data, "} ");
       retention = config->common.servers[i].retention_weeks;
       if (retention <= 0)
       {
          retention = config->retention_weeks;
       }
-      data = pgmoneta_append_int(data, retention <= 0 ? 0 : retention);
-      data = pgmoneta_append(data, "\n");
+      pgmoneta_string_builder_append_int(data, retention <= 0 ? 0 : retention);
+      pgmoneta_string_builder_append(data, "\n");
 
-      data = pgmoneta_append(data, "pgmoneta_retention_server{");
-      data = pgmoneta_append(data, "name=\"");
-      data = pgmoneta_append(data, config->common.servers[i].name);
-      data = pgmoneta_append(data, "\"");
-      data = pgmoneta_append(data, ", ");
-      data = pgmoneta_append(data, "parameter=\"months\"");
-      data = pgmoneta_append(data, "} ");
+      pgmoneta_string_builder_append(data, "pgmoneta_retention_server{");
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\"");
+      pgmoneta_string_builder_append(data, ", ");
+      pgmoneta_string_builder_append(data, "parameter=\"months\"");
+      pgmoneta_string_builder_append(data, "} ");
       retention = config->common.servers[i].retention_months;
       if (retention <= 0)
       {
          retention = config->retention_months;
       }
-      data = pgmoneta_append_int(data, retention <= 0 ? 0 : retention);
-      data = pgmoneta_append(data, "\n");
+      pgmoneta_string_builder_append_int(data, retention <= 0 ? 0 : retention);
+      pgmoneta_string_builder_append(data, "\n");
 
-      data = pgmoneta_append(data, "pgmoneta_retention_server{");
-      data = pgmoneta_append(data, "name=\"");
-      data = pgmoneta_append(data, config->common.servers[i].name);
-      data = pgmoneta_append(data, "\"");
-      data = pgmoneta_append(data, ", ");
-      data = pgmoneta_append(data, "parameter=\"years\"");
-      data = pgmoneta_append(data, "} ");
+      pgmoneta_string_builder_append(data, "pgmoneta_retention_server{");
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\"");
+      pgmoneta_string_builder_append(data, ", ");
+      pgmoneta_string_builder_append(data, "parameter=\"years\"");
+      pgmoneta_string_builder_append(data, "} ");
       retention = config->common.servers[i].retention_years;
       if (retention <= 0)
       {
          retention = config->retention_years;
       }
-      data = pgmoneta_append_int(data, retention <= 0 ? 0 : retention);
-      data = pgmoneta_append(data, "\n");
+      pgmoneta_string_builder_append_int(data, retention <= 0 ? 0 : retention);
+      pgmoneta_string_builder_append(data, "\n");
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   add_metric_to_art(container->general_metrics, "pgmoneta_retention_server", data, NULL, NULL, 0);
-   free(data);
-   data = NULL;
-   data = pgmoneta_append(data, "#HELP pgmoneta_compression The compression used\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_compression gauge\n");
-   data = pgmoneta_append(data, "pgmoneta_compression ");
-   data = pgmoneta_append_int(data, config->compression_type);
-   data = pgmoneta_append(data, "\n\n");
+   add_metric_to_art(container->general_metrics, "pgmoneta_retention_server", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_compression The compression used\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_compression gauge\n");
+   pgmoneta_string_builder_append(data, "pgmoneta_compression ");
+   pgmoneta_string_builder_append_int(data, config->compression_type);
+   pgmoneta_string_builder_append(data, "\n\n");
 
-   d = NULL;
-
-   d = pgmoneta_append(d, config->base_dir);
-   d = pgmoneta_append(d, "/");
-
-   size = pgmoneta_directory_size(d);
-
-   add_metric_to_art(container->general_metrics, "pgmoneta_compression", data, NULL, NULL, 0);
-   free(data);
-   data = NULL;
-   data = pgmoneta_append(data, "#HELP pgmoneta_used_space The disk space used for pgmoneta\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_used_space gauge\n");
-   data = pgmoneta_append(data, "pgmoneta_used_space ");
-   data = pgmoneta_append_ulong(data, size);
-   data = pgmoneta_append(data, "\n\n");
+   size = pgmoneta_usage_used_space();
 
-   free(d);
+   add_metric_to_art(container->general_metrics, "pgmoneta_compression", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_used_space The disk space used for pgmoneta\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_used_space gauge\n");
+   pgmoneta_string_builder_append(data, "pgmoneta_used_space ");
+   pgmoneta_string_builder_append_ulong(data, size);
+   pgmoneta_string_builder_append(data, "\n\n");
 
    d = NULL;
 
@@ -1795,14 +1967,13 @@ general_information(prometheus_metrics_container_t* container)
 
    size = pgmoneta_free_space(d);
 
-   add_metric_to_art(container->storage_metrics, "pgmoneta_used_space", data, NULL, NULL, 0);
-   free(data);
-   data = NULL;
-   data = pgmoneta_append(data, "#HELP pgmoneta_free_space The free disk space for pgmoneta\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_free_space gauge\n");
-   data = pgmoneta_append(data, "pgmoneta_free_space ");
-   data = pgmoneta_append_ulong(data, size);
-   data = pgmoneta_append(data, "\n\n");
+   add_metric_to_art(container->storage_metrics, "pgmoneta_used_space", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_free_space The free disk space for pgmoneta\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_free_space gauge\n");
+   pgmoneta_string_builder_append(data, "pgmoneta_free_space ");
+   pgmoneta_string_builder_append_ulong(data, size);
+   pgmoneta_string_builder_append(data, "\n\n");
 
    free(d);
 
@@ -1813,295 +1984,230 @@ general_information(prometheus_metrics_container_t* container)
 
    size = pgmoneta_total_space(d);
 
-   add_metric_to_art(container->storage_metrics, "pgmoneta_free_space", data, NULL, NULL, 0);
-   free(data);
-   data = NULL;
-   data = pgmoneta_append(data, "#HELP pgmoneta_total_space The total disk space for pgmoneta\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_total_space gauge\n");
-   data = pgmoneta_append(data, "pgmoneta_total_space ");
-   data = pgmoneta_append_ulong(data, size);
-   data = pgmoneta_append(data, "\n\n");
+   add_metric_to_art(container->storage_metrics, "pgmoneta_free_space", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_total_space The total disk space for pgmoneta\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_total_space gauge\n");
+   pgmoneta_string_builder_append(data, "pgmoneta_total_space ");
+   pgmoneta_string_builder_append_ulong(data, size);
+   pgmoneta_string_builder_append(data, "\n\n");
 
    free(d);
 
    d = NULL;
 
-   add_metric_to_art(container->storage_metrics, "pgmoneta_total_space", data, NULL, NULL, 0);
-   free(data);
-   data = NULL;
-   data = pgmoneta_append(data, "#HELP pgmoneta_wal_shipping The disk space used for WAL shipping for a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_wal_shipping gauge\n");
+   add_metric_to_art(container->storage_metrics, "pgmoneta_total_space", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_wal_shipping The disk space used for WAL shipping for a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_wal_shipping gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
-      data = pgmoneta_append(data, "pgmoneta_wal_shipping{");
+      pgmoneta_string_builder_append(data, "pgmoneta_wal_shipping{");
 
-      data = pgmoneta_append(data, "name=\"");
-      data = pgmoneta_append(data, config->common.servers[i].name);
-      data = pgmoneta_append(data, "\"} ");
-
-      d = pgmoneta_get_server_wal_shipping_wal(i);
-
-      if (d != NULL)
-      {
-         size = pgmoneta_directory_size(d);
-         data = pgmoneta_append_ulong(data, size);
-      }
-      else
-      {
-         data = pgmoneta_append_ulong(data, 0);
-      }
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\"} ");
 
-      data = pgmoneta_append(data, "\n");
+      pgmoneta_string_builder_append_ulong(data, pgmoneta_usage_get(i, USAGE_WAL_SHIPPING_WAL));
 
-      free(d);
-      d = NULL;
+      pgmoneta_string_builder_append(data, "\n");
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   add_metric_to_art(container->wal_metrics, "pgmoneta_wal_shipping", data, NULL, NULL, 0);
-   free(data);
-   data = NULL;
-   data = pgmoneta_append(data, "#HELP pgmoneta_wal_shipping_used_space The disk space used for WAL shipping of a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_wal_shipping_used_space gauge\n");
+   add_metric_to_art(container->wal_metrics, "pgmoneta_wal_shipping", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_wal_shipping_used_space The disk space used for WAL shipping of a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_wal_shipping_used_space gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
-      data = pgmoneta_append(data, "pgmoneta_wal_shipping_used_space{");
+      pgmoneta_string_builder_append(data, "pgmoneta_wal_shipping_used_space{");
 
-      data = pgmoneta_append(data, "name=\"");
-      data = pgmoneta_append(data, config->common.servers[i].name);
-      data = pgmoneta_append(data, "\"} ");
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\"} ");
 
-      d = pgmoneta_get_server_wal_shipping(i);
-      if (d != NULL)
-      {
-         size = pgmoneta_directory_size(d);
-         data = pgmoneta_append_ulong(data, size);
-      }
-      else
-      {
-         data = pgmoneta_append_ulong(data, 0);
-      }
+      pgmoneta_string_builder_append_ulong(data, pgmoneta_usage_get(i, USAGE_WAL_SHIPPING));
 
-      data = pgmoneta_append(data, "\n");
-
-      free(d);
-      d = NULL;
+      pgmoneta_string_builder_append(data, "\n");
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   add_metric_to_art(container->wal_metrics, "pgmoneta_wal_shipping_used_space", data, NULL, NULL, 0);
-   free(data);
-   data = NULL;
-   data = pgmoneta_append(data, "#HELP pgmoneta_wal_shipping_free_space The free disk space for WAL shipping of a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_wal_shipping_free_space gauge\n");
+   add_metric_to_art(container->wal_metrics, "pgmoneta_wal_shipping_used_space", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_wal_shipping_free_space The free disk space for WAL shipping of a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_wal_shipping_free_space gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
-      data = pgmoneta_append(data, "pgmoneta_wal_shipping_free_space{");
+      pgmoneta_string_builder_append(data, "pgmoneta_wal_shipping_free_space{");
 
-      data = pgmoneta_append(data, "name=\"");
-      data = pgmoneta_append(data, config->common.servers[i].name);
-      data = pgmoneta_append(data, "\"} ");
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\"} ");
 
       d = pgmoneta_get_server_wal_shipping(i);
 
       if (d != NULL)
       {
          size = pgmoneta_free_space(d);
-         data = pgmoneta_append_ulong(data, size);
+         pgmoneta_string_builder_append_ulong(data, size);
       }
       else
       {
-         data = pgmoneta_append_ulong(data, 0);
+         pgmoneta_string_builder_append_ulong(data, 0);
       }
 
-      data = pgmoneta_append(data, "\n");
+      pgmoneta_string_builder_append(data, "\n");
 
       free(d);
       d = NULL;
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   add_metric_to_art(container->wal_metrics, "pgmoneta_wal_shipping_free_space", data, NULL, NULL, 0);
-   free(data);
-   data = NULL;
-   data = pgmoneta_append(data, "#HELP pgmoneta_wal_shipping_total_space The total disk space for WAL shipping of a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_wal_shipping_total_space gauge\n");
+   add_metric_to_art(container->wal_metrics, "pgmoneta_wal_shipping_free_space", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_wal_shipping_total_space The total disk space for WAL shipping of a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_wal_shipping_total_space gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
-      data = pgmoneta_append(data, "pgmoneta_wal_shipping_total_space{");
+      pgmoneta_string_builder_append(data, "pgmoneta_wal_shipping_total_space{");
 
-      data = pgmoneta_append(data, "name=\"");
-      data = pgmoneta_append(data, config->common.servers[i].name);
-      data = pgmoneta_append(data, "\"} ");
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\"} ");
 
       d = pgmoneta_get_server_wal_shipping(i);
 
       if (d != NULL)
       {
          size = pgmoneta_total_space(d);
-         data = pgmoneta_append_ulong(data, size);
+         pgmoneta_string_builder_append_ulong(data, size);
       }
       else
       {
-         data = pgmoneta_append_ulong(data, 0);
+         pgmoneta_string_builder_append_ulong(data, 0);
       }
 
-      data = pgmoneta_append(data, "\n");
+      pgmoneta_string_builder_append(data, "\n");
 
       free(d);
       d = NULL;
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
    free(d);
 
    d = NULL;
 
    /* workspace */
-   add_metric_to_art(container->wal_metrics, "pgmoneta_wal_shipping_total_space", data, NULL, NULL, 0);
-   free(data);
-   data = NULL;
-   data = pgmoneta_append(data, "#HELP pgmoneta_workspace The disk space used for workspace for a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_workspace gauge\n");
+   add_metric_to_art(container->wal_metrics, "pgmoneta_wal_shipping_total_space", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_workspace The disk space used for workspace for a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_workspace gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
-      data = pgmoneta_append(data, "pgmoneta_workspace{");
+      pgmoneta_string_builder_append(data, "pgmoneta_workspace{");
 
-      data = pgmoneta_append(data, "name=\"");
-      data = pgmoneta_append(data, config->common.servers[i].name);
-      data = pgmoneta_append(data, "\"} ");
-
-      d = pgmoneta_get_server_workspace(i);
-
-      if (d != NULL)
-      {
-         size = pgmoneta_directory_size(d);
-         data = pgmoneta_append_ulong(data, size);
-      }
-      else
-      {
-         data = pgmoneta_append_ulong(data, 0);
-      }
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\"} ");
 
-      data = pgmoneta_append(data, "\n");
+      pgmoneta_string_builder_append_ulong(data, pgmoneta_usage_get(i, USAGE_WORKSPACE));
 
-      free(d);
-      d = NULL;
+      pgmoneta_string_builder_append(data, "\n");
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   add_metric_to_art(container->storage_metrics, "pgmoneta_workspace", data, NULL, NULL, 0);
-   free(data);
-   data = NULL;
-   data = pgmoneta_append(data, "#HELP pgmoneta_workspace_free_space The free disk space for workspace of a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_workspace_free_space gauge\n");
+   add_metric_to_art(container->storage_metrics, "pgmoneta_workspace", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_workspace_free_space The free disk space for workspace of a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_workspace_free_space gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
-      data = pgmoneta_append(data, "pgmoneta_workspace_free_space{");
+      pgmoneta_string_builder_append(data, "pgmoneta_workspace_free_space{");
 
-      data = pgmoneta_append(data, "name=\"");
-      data = pgmoneta_append(data, config->common.servers[i].name);
-      data = pgmoneta_append(data, "\"} ");
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\"} ");
 
       d = pgmoneta_get_server_workspace(i);
 
       if (d != NULL)
       {
          size = pgmoneta_free_space(d);
-         data = pgmoneta_append_ulong(data, size);
+         pgmoneta_string_builder_append_ulong(data, size);
       }
       else
       {
-         data = pgmoneta_append_ulong(data, 0);
+         pgmoneta_string_builder_append_ulong(data, 0);
       }
 
-      data = pgmoneta_append(data, "\n");
+      pgmoneta_string_builder_append(data, "\n");
 
       free(d);
       d = NULL;
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   add_metric_to_art(container->storage_metrics, "pgmoneta_workspace_free_space", data, NULL, NULL, 0);
-   free(data);
-   data = NULL;
-   data = pgmoneta_append(data, "#HELP pgmoneta_workspace_total_space The total disk space for workspace of a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_workspace_total_space gauge\n");
+   add_metric_to_art(container->storage_metrics, "pgmoneta_workspace_free_space", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_workspace_total_space The total disk space for workspace of a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_workspace_total_space gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
-      data = pgmoneta_append(data, "pgmoneta_workspace_total_space{");
+      pgmoneta_string_builder_append(data, "pgmoneta_workspace_total_space{");
 
-      data = pgmoneta_append(data, "name=\"");
-      data = pgmoneta_append(data, config->common.servers[i].name);
-      data = pgmoneta_append(data, "\"} ");
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\"} ");
 
       d = pgmoneta_get_server_workspace(i);
 
       if (d != NULL)
       {
          size = pgmoneta_total_space(d);
-         data = pgmoneta_append_ulong(data, size);
+         pgmoneta_string_builder_append_ulong(data, size);
       }
       else
       {
-         data = pgmoneta_append_ulong(data, 0);
+         pgmoneta_string_builder_append_ulong(data, 0);
       }
 
-      data = pgmoneta_append(data, "\n");
+      pgmoneta_string_builder_append(data, "\n");
 
       free(d);
       d = NULL;
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
    /* hot_standby */
-   add_metric_to_art(container->storage_metrics, "pgmoneta_workspace_total_space", data, NULL, NULL, 0);
-   free(data);
-   data = NULL;
-   data = pgmoneta_append(data, "#HELP pgmoneta_hot_standby The disk space used for hot standby for a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_hot_standby gauge\n");
+   add_metric_to_art(container->storage_metrics, "pgmoneta_workspace_total_space", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_hot_standby The disk space used for hot standby for a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_hot_standby gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
-      data = pgmoneta_append(data, "pgmoneta_hot_standby{");
+      pgmoneta_string_builder_append(data, "pgmoneta_hot_standby{");
 
-      data = pgmoneta_append(data, "name=\"");
-      data = pgmoneta_append(data, config->common.servers[i].name);
-      data = pgmoneta_append(data, "\"} ");
-
-      size = 0;
-      for (int j = 0; j < config->common.servers[i].number_of_hot_standbys; j++)
-      {
-         d = pgmoneta_append(d, config->common.servers[i].hot_standby[j]);
-         if (!pgmoneta_ends_with(d, "/"))
-         {
-            d = pgmoneta_append_char(d, '/');
-         }
-         d = pgmoneta_append(d, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\"} ");
 
-         if (pgmoneta_exists(d))
-         {
-            size += pgmoneta_directory_size(d);
-         }
-         free(d);
-         d = NULL;
-      }
-      data = pgmoneta_append_ulong(data, size);
-      data = pgmoneta_append(data, "\n");
+      pgmoneta_string_builder_append_ulong(data, pgmoneta_usage_get(i, USAGE_HOT_STANDBY));
+      pgmoneta_string_builder_append(data, "\n");
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   add_metric_to_art(container->storage_metrics, "pgmoneta_hot_standby", data, NULL, NULL, 0);
-   free(data);
-   data = NULL;
-   data = pgmoneta_append(data, "#HELP pgmoneta_hot_standby_free_space The free disk space for hot standby of a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_hot_standby_free_space gauge\n");
+   add_metric_to_art(container->storage_metrics, "pgmoneta_hot_standby", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_hot_standby_free_space The free disk space for hot standby of a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_hot_standby_free_space gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
-      data = pgmoneta_append(data, "pgmoneta_hot_standby_free_space{");
+      pgmoneta_string_builder_append(data, "pgmoneta_hot_standby_free_space{");
 
-      data = pgmoneta_append(data, "name=\"");
-      data = pgmoneta_append(data, config->common.servers[i].name);
-      data = pgmoneta_append(data, "\"} ");
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\"} ");
 
       size = 0;
       for (int j = 0; j < config->common.servers[i].number_of_hot_standbys; j++)
@@ -2120,23 +2226,22 @@ general_information(prometheus_metrics_container_t* container)
          free(d);
          d = NULL;
       }
-      data = pgmoneta_append_ulong(data, size);
-      data = pgmoneta_append(data, "\n");
+      pgmoneta_string_builder_append_ulong(data, size);
+      pgmoneta_string_builder_append(data, "\n");
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   add_metric_to_art(container->storage_metrics, "pgmoneta_hot_standby_free_space", data, NULL, NULL, 0);
-   free(data);
-   data = NULL;
-   data = pgmoneta_append(data, "#HELP pgmoneta_hot_standby_total_space The total disk space for hot standby of a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_hot_standby_total_space gauge\n");
+   add_metric_to_art(container->storage_metrics, "pgmoneta_hot_standby_free_space", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_hot_standby_total_space The total disk space for hot standby of a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_hot_standby_total_space gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
-      data = pgmoneta_append(data, "pgmoneta_hot_standby_total_space{");
+      pgmoneta_string_builder_append(data, "pgmoneta_hot_standby_total_space{");
 
-      data = pgmoneta_append(data, "name=\"");
-      data = pgmoneta_append(data, config->common.servers[i].name);
-      data = pgmoneta_append(data, "\"} ");
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\"} ");
 
       size = 0;
       for (int j = 0; j < config->common.servers[i].number_of_hot_standbys; j++)
@@ -2155,104 +2260,101 @@ general_information(prometheus_metrics_container_t* container)
          free(d);
          d = NULL;
       }
-      data = pgmoneta_append_ulong(data, size);
-      data = pgmoneta_append(data, "\n");
+      pgmoneta_string_builder_append_ulong(data, size);
+      pgmoneta_string_builder_append(data, "\n");
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   add_metric_to_art(container->storage_metrics, "pgmoneta_hot_standby_total_space", data, NULL, NULL, 0);
-   free(data);
-   data = NULL;
-   data = pgmoneta_append(data, "#HELP pgmoneta_server_timeline The current timeline a server is on\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_server_timeline counter\n");
+   add_metric_to_art(container->storage_metrics, "pgmoneta_hot_standby_total_space", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_server_timeline The current timeline a server is on\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_server_timeline counter\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
-      data = pgmoneta_append(data, "pgmoneta_server_timeline{");
+      pgmoneta_string_builder_append(data, "pgmoneta_server_timeline{");
 
-      data = pgmoneta_append(data, "name=\"");
-      data = pgmoneta_append(data, config->common.servers[i].name);
-      data = pgmoneta_append(data, "\"} ");
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\"} ");
 
-      data = pgmoneta_append_int(data, config->common.servers[i].cur_timeline);
+      pgmoneta_string_builder_append_int(data, config->common.servers[i].cur_timeline);
 
-      data = pgmoneta_append(data, "\n");
+      pgmoneta_string_builder_append(data, "\n");
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   add_metric_to_art(container->server_metrics, "pgmoneta_server_timeline", data, NULL, NULL, 0);
-   free(data);
-   data = NULL;
-   data = pgmoneta_append(data, "#HELP pgmoneta_server_parent_tli The parent timeline of a timeline on a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_server_parent_tli gauge\n");
+   add_metric_to_art(container->server_metrics, "pgmoneta_server_timeline", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_server_parent_tli The parent timeline of a timeline on a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_server_parent_tli gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
       struct timeline_history* history = NULL;
       struct timeline_history* curh = NULL;
       int tli = 2;
 
-      data = pgmoneta_append(data, "pgmoneta_server_parent_tli{");
+      pgmoneta_string_builder_append(data, "pgmoneta_server_parent_tli{");
 
-      data = pgmoneta_append(data, "name=\"");
-      data = pgmoneta_append(data, config->common.servers[i].name);
-      data = pgmoneta_append(data, "\", ");
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\", ");
 
-      data = pgmoneta_append(data, "tli=\"");
-      data = pgmoneta_append_int(data, 1);
-      data = pgmoneta_append(data, "\"} ");
+      pgmoneta_string_builder_append(data, "tli=\"");
+      pgmoneta_string_builder_append_int(data, 1);
+      pgmoneta_string_builder_append(data, "\"} ");
 
-      data = pgmoneta_append_int(data, 0);
+      pgmoneta_string_builder_append_int(data, 0);
 
-      data = pgmoneta_append(data, "\n");
+      pgmoneta_string_builder_append(data, "\n");
 
       pgmoneta_get_timeline_history(i, config->common.servers[i].cur_timeline, &history);
       curh = history;
       while (curh != NULL)
       {
-         data = pgmoneta_append(data, "pgmoneta_server_parent_tli{");
+         pgmoneta_string_builder_append(data, "pgmoneta_server_parent_tli{");
 
-         data = pgmoneta_append(data, "name=\"");
-         data = pgmoneta_append(data, config->common.servers[i].name);
-         data = pgmoneta_append(data, "\", ");
+         pgmoneta_string_builder_append(data, "name=\"");
+         pgmoneta_string_builder_append(data, config->common.servers[i].name);
+         pgmoneta_string_builder_append(data, "\", ");
 
-         data = pgmoneta_append(data, "tli=\"");
-         data = pgmoneta_append_int(data, tli);
-         data = pgmoneta_append(data, "\"} ");
+         pgmoneta_string_builder_append(data, "tli=\"");
+         pgmoneta_string_builder_append_int(data, tli);
+         pgmoneta_string_builder_append(data, "\"} ");
 
-         data = pgmoneta_append_int(data, curh->parent_tli);
+         pgmoneta_string_builder_append_int(data, curh->parent_tli);
 
-         data = pgmoneta_append(data, "\n");
+         pgmoneta_string_builder_append(data, "\n");
 
          curh = curh->next;
          tli++;
       }
       pgmoneta_free_timeline_history(history);
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   add_metric_to_art(container->server_metrics, "pgmoneta_server_parent_tli", data, NULL, NULL, 0);
-   free(data);
-   data = NULL;
-   data = pgmoneta_append(data, "#HELP pgmoneta_server_timeline_switchpos The WAL switch position of a timeline on a server (showed in hex as a parameter)\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_server_timeline_switchpos gauge\n");
+   add_metric_to_art(container->server_metrics, "pgmoneta_server_parent_tli", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_server_timeline_switchpos The WAL switch position of a timeline on a server (showed in hex as a parameter)\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_server_timeline_switchpos gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
       struct timeline_history* history = NULL;
       struct timeline_history* curh = NULL;
       int tli = 2;
 
-      data = pgmoneta_append(data, "pgmoneta_server_timeline_switchpos{");
+      pgmoneta_string_builder_append(data, "pgmoneta_server_timeline_switchpos{");
 
-      data = pgmoneta_append(data, "name=\"");
-      data = pgmoneta_append(data, config->common.servers[i].name);
-      data = pgmoneta_append(data, "\", ");
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\", ");
 
-      data = pgmoneta_append(data, "tli=\"1\", ");
+      pgmoneta_string_builder_append(data, "tli=\"1\", ");
 
-      data = pgmoneta_append(data, "walpos=\"0/0\"} ");
+      pgmoneta_string_builder_append(data, "walpos=\"0/0\"} ");
 
-      data = pgmoneta_append(data, "1");
+      pgmoneta_string_builder_append(data, "1");
 
-      data = pgmoneta_append(data, "\n");
+      pgmoneta_string_builder_append(data, "\n");
 
       pgmoneta_get_timeline_history(i, config->common.servers[i].cur_timeline, &history);
       curh = history;
@@ -2262,178 +2364,350 @@ general_information(prometheus_metrics_container_t* container)
          memset(xlogpos, 0, MISC_LENGTH);
          pgmoneta_snprintf(xlogpos, MISC_LENGTH, "%X/%X", curh->switchpos_hi, curh->switchpos_lo);
 
-         data = pgmoneta_append(data, "pgmoneta_server_timeline_switchpos{");
+         pgmoneta_string_builder_append(data, "pgmoneta_server_timeline_switchpos{");
 
-         data = pgmoneta_append(data, "name=\"");
-         data = pgmoneta_append(data, config->common.servers[i].name);
-         data = pgmoneta_append(data, "\", ");
+         pgmoneta_string_builder_append(data, "name=\"");
+         pgmoneta_string_builder_append(data, config->common.servers[i].name);
+         pgmoneta_string_builder_append(data, "\", ");
 
-         data = pgmoneta_append(data, "tli=\"");
-         data = pgmoneta_append_int(data, tli);
-         data = pgmoneta_append(data, "\", ");
+         pgmoneta_string_builder_append(data, "tli=\"");
+         pgmoneta_string_builder_append_int(data, tli);
+         pgmoneta_string_builder_append(data, "\", ");
 
-         data = pgmoneta_append(data, "walpos=\"");
-         data = pgmoneta_append(data, xlogpos);
-         data = pgmoneta_append(data, "\"} ");
+         pgmoneta_string_builder_append(data, "walpos=\"");
+         pgmoneta_string_builder_append(data, xlogpos);
+         pgmoneta_string_builder_append(data, "\"} ");
 
-         data = pgmoneta_append_int(data, 1);
+         pgmoneta_string_builder_append_int(data, 1);
 
-         data = pgmoneta_append(data, "\n");
+         pgmoneta_string_builder_append(data, "\n");
 
          curh = curh->next;
          tli++;
       }
       pgmoneta_free_timeline_history(history);
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   add_metric_to_art(container->server_metrics, "pgmoneta_server_timeline_switchpos", data, NULL, NULL, 0);
-   free(data);
-   data = NULL;
-   data = pgmoneta_append(data, "#HELP pgmoneta_server_workers The numbeer of workers for a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_server_workers gauge\n");
+   add_metric_to_art(container->server_metrics, "pgmoneta_server_timeline_switchpos", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_server_workers The numbeer of workers for a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_server_workers gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
       int workers = config->common.servers[i].workers != -1 ? config->common.servers[i].workers : config->workers;
 
-      data = pgmoneta_append(data, "pgmoneta_server_workers{");
+      pgmoneta_string_builder_append(data, "pgmoneta_server_workers{");
 
-      data = pgmoneta_append(data, "name=\"");
-      data = pgmoneta_append(data, config->common.servers[i].name);
-      data = pgmoneta_append(data, "\"} ");
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\"} ");
 
-      data = pgmoneta_append_int(data, workers);
+      pgmoneta_string_builder_append_int(data, workers);
 
-      data = pgmoneta_append(data, "\n");
+      pgmoneta_string_builder_append(data, "\n");
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   add_metric_to_art(container->server_metrics, "pgmoneta_server_workers", data, NULL, NULL, 0);
-   free(data);
-   data = NULL;
-   data = pgmoneta_append(data, "#HELP pgmoneta_server_online Is the server in an online state\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_server_online gauge\n");
+   add_metric_to_art(container->server_metrics, "pgmoneta_server_workers", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_server_online Is the server in an online state\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_server_online gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
-      data = pgmoneta_append(data, "pgmoneta_server_online{");
+      pgmoneta_string_builder_append(data, "pgmoneta_server_online{");
 
-      data = pgmoneta_append(data, "name=\"");
-      data = pgmoneta_append(data, config->common.servers[i].name);
-      data = pgmoneta_append(data, "\"} ");
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\"} ");
 
-      data = pgmoneta_append_int(data, config->common.servers[i].online ? 1 : 0);
+      pgmoneta_string_builder_append_int(data, config->common.servers[i].online ? 1 : 0);
 
-      data = pgmoneta_append(data, "\n");
+      pgmoneta_string_builder_append(data, "\n");
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   add_metric_to_art(container->server_metrics, "pgmoneta_server_online", data, NULL, NULL, 0);
-   free(data);
-   data = NULL;
-   data = pgmoneta_append(data, "#HELP pgmoneta_server_primary Is the server a primary\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_server_primary gauge\n");
+   add_metric_to_art(container->server_metrics, "pgmoneta_server_online", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_server_primary Is the server a primary\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_server_primary gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
-      data = pgmoneta_append(data, "pgmoneta_server_primary{");
+      pgmoneta_string_builder_append(data, "pgmoneta_server_primary{");
 
-      data = pgmoneta_append(data, "name=\"");
-      data = pgmoneta_append(data, config->common.servers[i].name);
-      data = pgmoneta_append(data, "\"} ");
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\"} ");
 
-      data = pgmoneta_append_int(data, config->common.servers[i].primary ? 1 : 0);
+      pgmoneta_string_builder_append_int(data, config->common.servers[i].primary ? 1 : 0);
 
-      data = pgmoneta_append(data, "\n");
+      pgmoneta_string_builder_append(data, "\n");
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   add_metric_to_art(container->server_metrics, "pgmoneta_server_primary", data, NULL, NULL, 0);
-   free(data);
-   data = NULL;
-   data = pgmoneta_append(data, "#HELP pgmoneta_server_valid Is the server in a valid state\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_server_valid gauge\n");
+   add_metric_to_art(container->server_metrics, "pgmoneta_server_primary", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_server_valid Is the server in a valid state\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_server_valid gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
-      data = pgmoneta_append(data, "pgmoneta_server_valid{");
+      pgmoneta_string_builder_append(data, "pgmoneta_server_valid{");
 
-      data = pgmoneta_append(data, "name=\"");
-      data = pgmoneta_append(data, config->common.servers[i].name);
-      data = pgmoneta_append(data, "\"} ");
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\"} ");
 
-      data = pgmoneta_append_int(data, config->common.servers[i].valid ? 1 : 0);
+      pgmoneta_string_builder_append_int(data, config->common.servers[i].valid ? 1 : 0);
 
-      data = pgmoneta_append(data, "\n");
+      pgmoneta_string_builder_append(data, "\n");
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   add_metric_to_art(container->server_metrics, "pgmoneta_server_valid", data, NULL, NULL, 0);
-   free(data);
-   data = NULL;
-   data = pgmoneta_append(data, "#HELP pgmoneta_wal_streaming The WAL streaming status of a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_wal_streaming gauge\n");
+   add_metric_to_art(container->server_metrics, "pgmoneta_server_valid", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_wal_streaming The WAL streaming status of a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_wal_streaming gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
-      data = pgmoneta_append(data, "pgmoneta_wal_streaming{");
+      pgmoneta_string_builder_append(data, "pgmoneta_wal_streaming{");
 
-      data = pgmoneta_append(data, "name=\"");
-      data = pgmoneta_append(data, config->common.servers[i].name);
-      data = pgmoneta_append(data, "\"} ");
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\"} ");
 
-      data = pgmoneta_append_int(data, config->common.servers[i].wal_streaming > 0 ? 1 : 0);
+      pgmoneta_string_builder_append_int(data, config->common.servers[i].wal_streaming > 0 ? 1 : 0);
 
-      data = pgmoneta_append(data, "\n");
+      pgmoneta_string_builder_append(data, "\n");
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   add_metric_to_art(container->wal_metrics, "pgmoneta_wal_streaming", data, NULL, NULL, 0);
-   free(data);
-   data = NULL;
-   data = pgmoneta_append(data, "#HELP pgmoneta_server_operation_count The count of client operations of a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_server_operation_count gauge\n");
+   add_metric_to_art(container->wal_metrics, "pgmoneta_wal_streaming", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_wal_streaming_ktls Is kTLS offload active on the WAL streaming connection of a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_wal_streaming_ktls gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
-      data = pgmoneta_append(data, "pgmoneta_server_operation_count{");
+      int ktls = atomic_load(&config->common.servers[i].wal_ktls);
+
+      pgmoneta_string_builder_append(data, "pgmoneta_wal_streaming_ktls{");
+
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\", direction=\"send\"} ");
+
+      pgmoneta_string_builder_append_int(data, (ktls & KTLS_SEND) ? 1 : 0);
 
-      data = pgmoneta_append(data, "name=\"");
-      data = pgmoneta_append(data, config->common.servers[i].name);
-      data = pgmoneta_append(data, "\"} ");
+      pgmoneta_string_builder_append(data, "\n");
 
-      data = pgmoneta_append_ulong(data, atomic_load(&config->common.servers[i].operation_count));
+      pgmoneta_string_builder_append(data, "pgmoneta_wal_streaming_ktls{");
 
-      data = pgmoneta_append(data, "\n");
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\", direction=\"receive\"} ");
+
+      pgmoneta_string_builder_append_int(data, (ktls & KTLS_RECEIVE) ? 1 : 0);
+
+      pgmoneta_string_builder_append(data, "\n");
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   add_metric_to_art(container->server_metrics, "pgmoneta_server_operation_count", data, NULL, NULL, 0);
-   free(data);
-   data = NULL;
-   data = pgmoneta_append(data, "#HELP pgmoneta_server_failed_operation_count The count of failed client operations of a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_server_failed_operation_count gauge\n");
+   add_metric_to_art(container->wal_metrics, "pgmoneta_wal_streaming_ktls", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_server_tls_connections_total The number of TLS connections opened to a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_server_tls_connections_total counter\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
-      data = pgmoneta_append(data, "pgmoneta_server_failed_operation_count{");
+      pgmoneta_string_builder_append(data, "pgmoneta_server_tls_connections_total{");
 
-      data = pgmoneta_append(data, "name=\"");
-      data = pgmoneta_append(data, config->common.servers[i].name);
-      data = pgmoneta_append(data, "\"} ");
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\"} ");
 
-      data = pgmoneta_append_ulong(data, atomic_load(&config->common.servers[i].failed_operation_count));
+      pgmoneta_string_builder_append_ulong(data, atomic_load(&config->common.servers[i].tls.connections));
 
-      data = pgmoneta_append(data, "\n");
+      pgmoneta_string_builder_append(data, "\n");
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   add_metric_to_art(container->server_metrics, "pgmoneta_server_failed_operation_count", data, NULL, NULL, 0);
-   free(data);
-   data = NULL;
-   data = pgmoneta_append(data, "#HELP pgmoneta_server_last_operation_time The time of the latest client operation of a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_server_last_operation_time gauge\n");
+   add_metric_to_art(container->server_metrics, "pgmoneta_server_tls_connections_total", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_server_ktls_connections_total The number of TLS connections opened to a server with kTLS offload\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_server_ktls_connections_total counter\n");
+   for (int i = 0; i < config->common.number_of_servers; i++)
+   {
+      pgmoneta_string_builder_append(data, "pgmoneta_server_ktls_connections_total{");
+
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\", direction=\"send\"} ");
+
+      pgmoneta_string_builder_append_ulong(data, atomic_load(&config->common.servers[i].tls.ktls_send));
+
+      pgmoneta_string_builder_append(data, "\n");
+
+      pgmoneta_string_builder_append(data, "pgmoneta_server_ktls_connections_total{");
+
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\", direction=\"receive\"} ");
+
+      pgmoneta_string_builder_append_ulong(data, atomic_load(&config->common.servers[i].tls.ktls_receive));
+
+      pgmoneta_string_builder_append(data, "\n");
+   }
+   pgmoneta_string_builder_append(data, "\n");
+
+   add_metric_to_art(container->server_metrics, "pgmoneta_server_ktls_connections_total", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_server_socket_buffer The effective socket buffer size of a server connection\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_server_socket_buffer gauge\n");
+   for (int i = 0; i < config->common.number_of_servers; i++)
+   {
+      pgmoneta_string_builder_append(data, "pgmoneta_server_socket_buffer{");
+
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\", connection=\"wal\", direction=\"send\"} ");
+
+      pgmoneta_string_builder_append_int(data, atomic_load(&config->common.servers[i].wal_socket.sndbuf));
+
+      pgmoneta_string_builder_append(data, "\n");
+
+      pgmoneta_string_builder_append(data, "pgmoneta_server_socket_buffer{");
+
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\", connection=\"wal\", direction=\"receive\"} ");
+
+      pgmoneta_string_builder_append_int(data, atomic_load(&config->common.servers[i].wal_socket.rcvbuf));
+
+      pgmoneta_string_builder_append(data, "\n");
+
+      pgmoneta_string_builder_append(data, "pgmoneta_server_socket_buffer{");
+
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\", connection=\"backup\", direction=\"send\"} ");
+
+      pgmoneta_string_builder_append_int(data, atomic_load(&config->common.servers[i].backup_socket.sndbuf));
+
+      pgmoneta_string_builder_append(data, "\n");
+
+      pgmoneta_string_builder_append(data, "pgmoneta_server_socket_buffer{");
+
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\", connection=\"backup\", direction=\"receive\"} ");
+
+      pgmoneta_string_builder_append_int(data, atomic_load(&config->common.servers[i].backup_socket.rcvbuf));
+
+      pgmoneta_string_builder_append(data, "\n");
+   }
+   pgmoneta_string_builder_append(data, "\n");
+
+   add_metric_to_art(container->server_metrics, "pgmoneta_server_socket_buffer", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_server_socket_rtt The smoothed round trip time of a server connection in microseconds\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_server_socket_rtt gauge\n");
+   for (int i = 0; i < config->common.number_of_servers; i++)
+   {
+      pgmoneta_string_builder_append(data, "pgmoneta_server_socket_rtt{");
+
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\", connection=\"wal\"} ");
+
+      pgmoneta_string_builder_append_ulong(data, atomic_load(&config->common.servers[i].wal_socket.rtt));
+
+      pgmoneta_string_builder_append(data, "\n");
+
+      pgmoneta_string_builder_append(data, "pgmoneta_server_socket_rtt{");
+
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\", connection=\"backup\"} ");
+
+      pgmoneta_string_builder_append_ulong(data, atomic_load(&config->common.servers[i].backup_socket.rtt));
+
+      pgmoneta_string_builder_append(data, "\n");
+   }
+   pgmoneta_string_builder_append(data, "\n");
+
+   add_metric_to_art(container->server_metrics, "pgmoneta_server_socket_rtt", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_server_socket_retransmits The number of retransmitted TCP segments of a server connection\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_server_socket_retransmits gauge\n");
+   for (int i = 0; i < config->common.number_of_servers; i++)
+   {
+      pgmoneta_string_builder_append(data, "pgmoneta_server_socket_retransmits{");
+
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\", connection=\"wal\"} ");
+
+      pgmoneta_string_builder_append_ulong(data, atomic_load(&config->common.servers[i].wal_socket.retransmits));
+
+      pgmoneta_string_builder_append(data, "\n");
+
+      pgmoneta_string_builder_append(data, "pgmoneta_server_socket_retransmits{");
+
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\", connection=\"backup\"} ");
+
+      pgmoneta_string_builder_append_ulong(data, atomic_load(&config->common.servers[i].backup_socket.retransmits));
+
+      pgmoneta_string_builder_append(data, "\n");
+   }
+   pgmoneta_string_builder_append(data, "\n");
+
+   add_metric_to_art(container->server_metrics, "pgmoneta_server_socket_retransmits", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_server_operation_count The count of client operations of a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_server_operation_count gauge\n");
+   for (int i = 0; i < config->common.number_of_servers; i++)
+   {
+      pgmoneta_string_builder_append(data, "pgmoneta_server_operation_count{");
+
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\"} ");
+
+      pgmoneta_string_builder_append_ulong(data, atomic_load(&config->common.servers[i].operation_count));
+
+      pgmoneta_string_builder_append(data, "\n");
+   }
+   pgmoneta_string_builder_append(data, "\n");
+
+   add_metric_to_art(container->server_metrics, "pgmoneta_server_operation_count", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_server_failed_operation_count The count of failed client operations of a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_server_failed_operation_count gauge\n");
+   for (int i = 0; i < config->common.number_of_servers; i++)
+   {
+      pgmoneta_string_builder_append(data, "pgmoneta_server_failed_operation_count{");
+
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\"} ");
+
+      pgmoneta_string_builder_append_ulong(data, atomic_load(&config->common.servers[i].failed_operation_count));
+
+      pgmoneta_string_builder_append(data, "\n");
+   }
+   pgmoneta_string_builder_append(data, "\n");
+
+   add_metric_to_art(container->server_metrics, "pgmoneta_server_failed_operation_count", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_server_last_operation_time The time of the latest client operation of a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_server_last_operation_time gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
-      data = pgmoneta_append(data, "pgmoneta_server_last_operation_time{");
+      pgmoneta_string_builder_append(data, "pgmoneta_server_last_operation_time{");
 
-      data = pgmoneta_append(data, "name=\"");
-      data = pgmoneta_append(data, config->common.servers[i].name);
-      data = pgmoneta_append(data, "\"} ");
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\"} ");
 
       if (atomic_load(&config->common.servers[i].operation_count) > 0)
       {
@@ -2442,29 +2716,28 @@ general_information(prometheus_metrics_container_t* container)
          time_info = localtime(&t);
          strftime(&time_str[0], sizeof(time_str), "%Y%m%d%H%M%S", time_info);
 
-         data = pgmoneta_append(data, time_str);
+         pgmoneta_string_builder_append(data, time_str);
       }
       else
       {
-         data = pgmoneta_append_int(data, 0);
+         pgmoneta_string_builder_append_int(data, 0);
       }
 
-      data = pgmoneta_append(data, "\n");
+      pgmoneta_string_builder_append(data, "\n");
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   add_metric_to_art(container->server_metrics, "pgmoneta_server_last_operation_time", data, NULL, NULL, 0);
-   free(data);
-   data = NULL;
-   data = pgmoneta_append(data, "#HELP pgmoneta_server_last_failed_operation_time The time of the latest failed client operation of a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_server_last_failed_operation_time gauge\n");
+   add_metric_to_art(container->server_metrics, "pgmoneta_server_last_operation_time", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_server_last_failed_operation_time The time of the latest failed client operation of a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_server_last_failed_operation_time gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
-      data = pgmoneta_append(data, "pgmoneta_server_last_failed_operation_time{");
+      pgmoneta_string_builder_append(data, "pgmoneta_server_last_failed_operation_time{");
 
-      data = pgmoneta_append(data, "name=\"");
-      data = pgmoneta_append(data, config->common.servers[i].name);
-      data = pgmoneta_append(data, "\"} ");
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\"} ");
 
       if (atomic_load(&config->common.servers[i].failed_operation_count) > 0)
       {
@@ -2473,116 +2746,111 @@ general_information(prometheus_metrics_container_t* container)
          time_info = localtime(&t);
          strftime(&time_str[0], sizeof(time_str), "%Y%m%d%H%M%S", time_info);
 
-         data = pgmoneta_append(data, time_str);
+         pgmoneta_string_builder_append(data, time_str);
       }
       else
       {
-         data = pgmoneta_append_int(data, 0);
+         pgmoneta_string_builder_append_int(data, 0);
       }
 
-      data = pgmoneta_append(data, "\n");
+      pgmoneta_string_builder_append(data, "\n");
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   add_metric_to_art(container->server_metrics, "pgmoneta_server_last_failed_operation_time", data, NULL, NULL, 0);
-   free(data);
-   data = NULL;
-   data = pgmoneta_append(data, "#HELP pgmoneta_server_checksums Are checksums enabled\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_server_checksums gauge\n");
+   add_metric_to_art(container->server_metrics, "pgmoneta_server_last_failed_operation_time", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_server_checksums Are checksums enabled\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_server_checksums gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
-      data = pgmoneta_append(data, "pgmoneta_server_checksums{");
+      pgmoneta_string_builder_append(data, "pgmoneta_server_checksums{");
 
-      data = pgmoneta_append(data, "name=\"");
-      data = pgmoneta_append(data, config->common.servers[i].name);
-      data = pgmoneta_append(data, "\"} ");
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\"} ");
 
       if (config->common.servers[i].checksums)
       {
-         data = pgmoneta_append_int(data, 1);
+         pgmoneta_string_builder_append_int(data, 1);
       }
       else
       {
-         data = pgmoneta_append_int(data, 0);
+         pgmoneta_string_builder_append_int(data, 0);
       }
 
-      data = pgmoneta_append(data, "\n");
+      pgmoneta_string_builder_append(data, "\n");
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   add_metric_to_art(container->server_metrics, "pgmoneta_server_checksums", data, NULL, NULL, 0);
-   free(data);
-   data = NULL;
-   data = pgmoneta_append(data, "#HELP pgmoneta_server_fips_mode Is FIPS mode enabled\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_server_fips_mode gauge\n");
+   add_metric_to_art(container->server_metrics, "pgmoneta_server_checksums", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_server_fips_mode Is FIPS mode enabled\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_server_fips_mode gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
-      data = pgmoneta_append(data, "pgmoneta_server_fips_mode{");
+      pgmoneta_string_builder_append(data, "pgmoneta_server_fips_mode{");
 
-      data = pgmoneta_append(data, "name=\"");
-      data = pgmoneta_append(data, config->common.servers[i].name);
-      data = pgmoneta_append(data, "\"} ");
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\"} ");
 
       if (config->common.servers[i].fips_enabled == SERVER_FIPS_ENABLED)
       {
-         data = pgmoneta_append_int(data, 1);
+         pgmoneta_string_builder_append_int(data, 1);
       }
       else
       {
-         data = pgmoneta_append_int(data, 0);
+         pgmoneta_string_builder_append_int(data, 0);
       }
 
-      data = pgmoneta_append(data, "\n");
+      pgmoneta_string_builder_append(data, "\n");
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   add_metric_to_art(container->server_metrics, "pgmoneta_server_fips_mode", data, NULL, NULL, 0);
-   free(data);
-   data = NULL;
-   data = pgmoneta_append(data, "#HELP pgmoneta_server_summarize_wal Is summarize_wal enabled\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_server_summarize_wal gauge\n");
+   add_metric_to_art(container->server_metrics, "pgmoneta_server_fips_mode", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_server_summarize_wal Is summarize_wal enabled\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_server_summarize_wal gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
-      data = pgmoneta_append(data, "pgmoneta_server_summarize_wal{");
+      pgmoneta_string_builder_append(data, "pgmoneta_server_summarize_wal{");
 
-      data = pgmoneta_append(data, "name=\"");
-      data = pgmoneta_append(data, config->common.servers[i].name);
-      data = pgmoneta_append(data, "\"} ");
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\"} ");
 
       if (config->common.servers[i].summarize_wal)
       {
-         data = pgmoneta_append_int(data, 1);
+         pgmoneta_string_builder_append_int(data, 1);
       }
       else
       {
-         data = pgmoneta_append_int(data, 0);
+         pgmoneta_string_builder_append_int(data, 0);
       }
 
-      data = pgmoneta_append(data, "\n");
+      pgmoneta_string_builder_append(data, "\n");
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   add_metric_to_art(container->server_metrics, "pgmoneta_server_summarize_wal", data, NULL, NULL, 0);
-   free(data);
-   data = NULL;
-   data = pgmoneta_append(data, "#HELP pgmoneta_server_extensions_detected The number of extensions detected on server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_server_extensions_detected gauge\n");
+   add_metric_to_art(container->server_metrics, "pgmoneta_server_summarize_wal", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_server_extensions_detected The number of extensions detected on server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_server_extensions_detected gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
-      data = pgmoneta_append(data, "pgmoneta_server_extensions_detected{");
-      data = pgmoneta_append(data, "name=\"");
-      data = pgmoneta_append(data, config->common.servers[i].name);
-      data = pgmoneta_append(data, "\"} ");
-      data = pgmoneta_append_int(data, config->common.servers[i].number_of_extensions);
-      data = pgmoneta_append(data, "\n");
+      pgmoneta_string_builder_append(data, "pgmoneta_server_extensions_detected{");
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\"} ");
+      pgmoneta_string_builder_append_int(data, config->common.servers[i].number_of_extensions);
+      pgmoneta_string_builder_append(data, "\n");
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   add_metric_to_art(container->server_metrics, "pgmoneta_server_extensions_detected", data, NULL, NULL, 0);
-   free(data);
-   data = NULL;
-   data = pgmoneta_append(data, "#HELP pgmoneta_server_extension Information about installed extensions on server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_server_extension gauge\n");
+   add_metric_to_art(container->server_metrics, "pgmoneta_server_extensions_detected", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_server_extension Information about installed extensions on server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_server_extension gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
       if (config->common.servers[i].number_of_extensions > 0)
@@ -2591,70 +2859,69 @@ general_information(prometheus_metrics_container_t* container)
          {
             struct extension_info* ext = &config->common.servers[i].extensions[j];
 
-            data = pgmoneta_append(data, "pgmoneta_server_extension{");
-            data = pgmoneta_append(data, "name=\"");
-            data = pgmoneta_append(data, config->common.servers[i].name);
-            data = pgmoneta_append(data, "\", ");
-            data = pgmoneta_append(data, "extension=\"");
-            data = pgmoneta_append(data, ext->name);
-            data = pgmoneta_append(data, "\", ");
-            data = pgmoneta_append(data, "version=\"");
+            pgmoneta_string_builder_append(data, "pgmoneta_server_extension{");
+            pgmoneta_string_builder_append(data, "name=\"");
+            pgmoneta_string_builder_append(data, config->common.servers[i].name);
+            pgmoneta_string_builder_append(data, "\", ");
+            pgmoneta_string_builder_append(data, "extension=\"");
+            pgmoneta_string_builder_append(data, ext->name);
+            pgmoneta_string_builder_append(data, "\", ");
+            pgmoneta_string_builder_append(data, "version=\"");
 
             if (ext->enabled && ext->installed_version.major != -1)
             {
                char version_buf[64];
                if (pgmoneta_version_to_string(&ext->installed_version, version_buf, sizeof(version_buf)) == 0)
                {
-                  data = pgmoneta_append(data, version_buf);
+                  pgmoneta_string_builder_append(data, version_buf);
                }
                else
                {
-                  data = pgmoneta_append_int(data, ext->installed_version.major);
+                  pgmoneta_string_builder_append_int(data, ext->installed_version.major);
                   if (ext->installed_version.minor != -1)
                   {
-                     data = pgmoneta_append(data, ".");
-                     data = pgmoneta_append_int(data, ext->installed_version.minor);
+                     pgmoneta_string_builder_append(data, ".");
+                     pgmoneta_string_builder_append_int(data, ext->installed_version.minor);
                      if (ext->installed_version.patch != -1)
                      {
-                        data = pgmoneta_append(data, ".");
-                        data = pgmoneta_append_int(data, ext->installed_version.patch);
+                        pgmoneta_string_builder_append(data, ".");
+                        pgmoneta_string_builder_append_int(data, ext->installed_version.patch);
                      }
                   }
                }
             }
             else
             {
-               data = pgmoneta_append(data, "unknown");
+               pgmoneta_string_builder_append(data, "unknown");
             }
 
-            data = pgmoneta_append(data, "\", ");
-            data = pgmoneta_append(data, "comment=\"");
-            data = pgmoneta_append(data, ext->comment);
-            data = pgmoneta_append(data, "\"} ");
+            pgmoneta_string_builder_append(data, "\", ");
+            pgmoneta_string_builder_append(data, "comment=\"");
+            pgmoneta_string_builder_append(data, ext->comment);
+            pgmoneta_string_builder_append(data, "\"} ");
 
-            data = pgmoneta_append_int(data, ext->enabled ? 1 : 0);
-            data = pgmoneta_append(data, "\n");
+            pgmoneta_string_builder_append_int(data, ext->enabled ? 1 : 0);
+            pgmoneta_string_builder_append(data, "\n");
          }
       }
       else
       {
-         data = pgmoneta_append(data, "pgmoneta_server_extension{");
-         data = pgmoneta_append(data, "name=\"");
-         data = pgmoneta_append(data, config->common.servers[i].name);
-         data = pgmoneta_append(data, "\", ");
-         data = pgmoneta_append(data, "extension=\"none\", ");
-         data = pgmoneta_append(data, "version=\"\", ");
-         data = pgmoneta_append(data, "comment=\"\"} 0");
-         data = pgmoneta_append(data, "\n");
+         pgmoneta_string_builder_append(data, "pgmoneta_server_extension{");
+         pgmoneta_string_builder_append(data, "name=\"");
+         pgmoneta_string_builder_append(data, config->common.servers[i].name);
+         pgmoneta_string_builder_append(data, "\", ");
+         pgmoneta_string_builder_append(data, "extension=\"none\", ");
+         pgmoneta_string_builder_append(data, "version=\"\", ");
+         pgmoneta_string_builder_append(data, "comment=\"\"} 0");
+         pgmoneta_string_builder_append(data, "\n");
       }
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   add_metric_to_art(container->server_metrics, "pgmoneta_server_extension", data, NULL, NULL, 0);
-   free(data);
-   data = NULL;
-   data = pgmoneta_append(data, "#HELP pgmoneta_extension_pgmoneta_ext Status of the pgmoneta extension\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_extension_pgmoneta_ext gauge\n");
+   add_metric_to_art(container->server_metrics, "pgmoneta_server_extension", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_extension_pgmoneta_ext Status of the pgmoneta extension\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_extension_pgmoneta_ext gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
       bool found_pgmoneta_ext = false;
@@ -2665,142 +2932,139 @@ general_information(prometheus_metrics_container_t* container)
          if (strcmp(ext->name, "pgmoneta_ext") == 0)
          {
             found_pgmoneta_ext = true;
-            data = pgmoneta_append(data, "pgmoneta_extension_pgmoneta_ext{");
-            data = pgmoneta_append(data, "name=\"");
-            data = pgmoneta_append(data, config->common.servers[i].name);
-            data = pgmoneta_append(data, "\", ");
-            data = pgmoneta_append(data, "version=\"");
+            pgmoneta_string_builder_append(data, "pgmoneta_extension_pgmoneta_ext{");
+            pgmoneta_string_builder_append(data, "name=\"");
+            pgmoneta_string_builder_append(data, config->common.servers[i].name);
+            pgmoneta_string_builder_append(data, "\", ");
+            pgmoneta_string_builder_append(data, "version=\"");
 
             if (ext->enabled && ext->installed_version.major != -1)
             {
                char version_buf[64];
                if (pgmoneta_version_to_string(&ext->installed_version, version_buf, sizeof(version_buf)) == 0)
                {
-                  data = pgmoneta_append(data, version_buf);
+                  pgmoneta_string_builder_append(data, version_buf);
                }
                else
                {
-                  data = pgmoneta_append(data, "unknown");
+                  pgmoneta_string_builder_append(data, "unknown");
                }
             }
             else
             {
-               data = pgmoneta_append(data, "disabled");
+               pgmoneta_string_builder_append(data, "disabled");
             }
 
-            data = pgmoneta_append(data, "\"} ");
-            data = pgmoneta_append_int(data, ext->enabled ? 1 : 0);
-            data = pgmoneta_append(data, "\n");
+            pgmoneta_string_builder_append(data, "\"} ");
+            pgmoneta_string_builder_append_int(data, ext->enabled ? 1 : 0);
+            pgmoneta_string_builder_append(data, "\n");
             break;
          }
       }
 
       if (!found_pgmoneta_ext)
       {
-         data = pgmoneta_append(data, "pgmoneta_extension_pgmoneta_ext{");
-         data = pgmoneta_append(data, "name=\"");
-         data = pgmoneta_append(data, config->common.servers[i].name);
-         data = pgmoneta_append(data, "\", ");
-         data = pgmoneta_append(data, "version=\"not_installed\"} 0");
-         data = pgmoneta_append(data, "\n");
+         pgmoneta_string_builder_append(data, "pgmoneta_extension_pgmoneta_ext{");
+         pgmoneta_string_builder_append(data, "name=\"");
+         pgmoneta_string_builder_append(data, config->common.servers[i].name);
+         pgmoneta_string_builder_append(data, "\", ");
+         pgmoneta_string_builder_append(data, "version=\"not_installed\"} 0");
+         pgmoneta_string_builder_append(data, "\n");
       }
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   add_metric_to_art(container->general_metrics, "pgmoneta_extension_pgmoneta_ext", data, NULL, NULL, 0);
-   free(data);
-   data = NULL;
-   data = pgmoneta_append(data, "#HELP pgmoneta_progress_percentage The workflow progress percentage (0-100) for a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_progress_percentage gauge\n");
+   add_metric_to_art(container->general_metrics, "pgmoneta_extension_pgmoneta_ext", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_progress_percentage The workflow progress percentage (0-100) for a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_progress_percentage gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
       int wt = atomic_load(&config->common.servers[i].progress.workflow_type);
       int ph = atomic_load(&config->common.servers[i].progress.current_phase);
 
-      data = pgmoneta_append(data, "pgmoneta_progress_percentage{name=\"");
-      data = pgmoneta_append(data, config->common.servers[i].name);
-      data = pgmoneta_append(data, "\", workflow=\"");
-      data = pgmoneta_append(data, (char*)pgmoneta_workflow_name(wt));
-      data = pgmoneta_append(data, "\", phase=\"");
-      data = pgmoneta_append(data, (char*)pgmoneta_phase_name(ph));
-      data = pgmoneta_append(data, "\"} ");
-      data = pgmoneta_append_int(data, atomic_load(&config->common.servers[i].progress.percentage));
-      data = pgmoneta_append(data, "\n");
+      pgmoneta_string_builder_append(data, "pgmoneta_progress_percentage{name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\", workflow=\"");
+      pgmoneta_string_builder_append(data, (char*)pgmoneta_workflow_name(wt));
+      pgmoneta_string_builder_append(data, "\", phase=\"");
+      pgmoneta_string_builder_append(data, (char*)pgmoneta_phase_name(ph));
+      pgmoneta_string_builder_append(data, "\"} ");
+      pgmoneta_string_builder_append_int(data, atomic_load(&config->common.servers[i].progress.percentage));
+      pgmoneta_string_builder_append(data, "\n");
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   add_metric_to_art(container->general_metrics, "pgmoneta_progress_percentage", data, NULL, NULL, 0);
-   free(data);
-   data = NULL;
+   add_metric_to_art(container->general_metrics, "pgmoneta_progress_percentage", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_progress_elapsed_time The elapsed seconds since the current workflow started\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_progress_elapsed_time gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_progress_elapsed_time The elapsed seconds since the current workflow started\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_progress_elapsed_time gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
       int wt = atomic_load(&config->common.servers[i].progress.workflow_type);
       int ph = atomic_load(&config->common.servers[i].progress.current_phase);
 
-      data = pgmoneta_append(data, "pgmoneta_progress_elapsed_time{name=\"");
-      data = pgmoneta_append(data, config->common.servers[i].name);
-      data = pgmoneta_append(data, "\", workflow=\"");
-      data = pgmoneta_append(data, (char*)pgmoneta_workflow_name(wt));
-      data = pgmoneta_append(data, "\", phase=\"");
-      data = pgmoneta_append(data, (char*)pgmoneta_phase_name(ph));
-      data = pgmoneta_append(data, "\"} ");
-      data = pgmoneta_append_ulong(data, (unsigned long)atomic_load(&config->common.servers[i].progress.elapsed));
-      data = pgmoneta_append(data, "\n");
+      pgmoneta_string_builder_append(data, "pgmoneta_progress_elapsed_time{name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\", workflow=\"");
+      pgmoneta_string_builder_append(data, (char*)pgmoneta_workflow_name(wt));
+      pgmoneta_string_builder_append(data, "\", phase=\"");
+      pgmoneta_string_builder_append(data, (char*)pgmoneta_phase_name(ph));
+      pgmoneta_string_builder_append(data, "\"} ");
+      pgmoneta_string_builder_append_ulong(data, (unsigned long)atomic_load(&config->common.servers[i].progress.elapsed));
+      pgmoneta_string_builder_append(data, "\n");
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   add_metric_to_art(container->general_metrics, "pgmoneta_progress_elapsed_time", data, NULL, NULL, 0);
-   free(data);
-   data = NULL;
+   add_metric_to_art(container->general_metrics, "pgmoneta_progress_elapsed_time", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_progress_total The total units of work in the current workflow phase\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_progress_total gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_progress_total The total units of work in the current workflow phase\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_progress_total gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
       int wt = atomic_load(&config->common.servers[i].progress.workflow_type);
       int ph = atomic_load(&config->common.servers[i].progress.current_phase);
 
-      data = pgmoneta_append(data, "pgmoneta_progress_total{name=\"");
-      data = pgmoneta_append(data, config->common.servers[i].name);
-      data = pgmoneta_append(data, "\", workflow=\"");
-      data = pgmoneta_append(data, (char*)pgmoneta_workflow_name(wt));
-      data = pgmoneta_append(data, "\", phase=\"");
-      data = pgmoneta_append(data, (char*)pgmoneta_phase_name(ph));
-      data = pgmoneta_append(data, "\"} ");
-      data = pgmoneta_append_ulong(data, (unsigned long)atomic_load(&config->common.servers[i].progress.total));
-      data = pgmoneta_append(data, "\n");
+      pgmoneta_string_builder_append(data, "pgmoneta_progress_total{name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\", workflow=\"");
+      pgmoneta_string_builder_append(data, (char*)pgmoneta_workflow_name(wt));
+      pgmoneta_string_builder_append(data, "\", phase=\"");
+      pgmoneta_string_builder_append(data, (char*)pgmoneta_phase_name(ph));
+      pgmoneta_string_builder_append(data, "\"} ");
+      pgmoneta_string_builder_append_ulong(data, (unsigned long)atomic_load(&config->common.servers[i].progress.total));
+      pgmoneta_string_builder_append(data, "\n");
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   add_metric_to_art(container->general_metrics, "pgmoneta_progress_total", data, NULL, NULL, 0);
-   free(data);
-   data = NULL;
+   add_metric_to_art(container->general_metrics, "pgmoneta_progress_total", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_progress_done The units of work completed in the current workflow phase\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_progress_done gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_progress_done The units of work completed in the current workflow phase\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_progress_done gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
       int wt = atomic_load(&config->common.servers[i].progress.workflow_type);
       int ph = atomic_load(&config->common.servers[i].progress.current_phase);
 
-      data = pgmoneta_append(data, "pgmoneta_progress_done{name=\"");
-      data = pgmoneta_append(data, config->common.servers[i].name);
-      data = pgmoneta_append(data, "\", workflow=\"");
-      data = pgmoneta_append(data, (char*)pgmoneta_workflow_name(wt));
-      data = pgmoneta_append(data, "\", phase=\"");
-      data = pgmoneta_append(data, (char*)pgmoneta_phase_name(ph));
-      data = pgmoneta_append(data, "\"} ");
-      data = pgmoneta_append_ulong(data, (unsigned long)atomic_load(&config->common.servers[i].progress.done));
-      data = pgmoneta_append(data, "\n");
+      pgmoneta_string_builder_append(data, "pgmoneta_progress_done{name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\", workflow=\"");
+      pgmoneta_string_builder_append(data, (char*)pgmoneta_workflow_name(wt));
+      pgmoneta_string_builder_append(data, "\", phase=\"");
+      pgmoneta_string_builder_append(data, (char*)pgmoneta_phase_name(ph));
+      pgmoneta_string_builder_append(data, "\"} ");
+      pgmoneta_string_builder_append_ulong(data, (unsigned long)atomic_load(&config->common.servers[i].progress.done));
+      pgmoneta_string_builder_append(data, "\n");
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   add_metric_to_art(container->general_metrics, "pgmoneta_progress_done", data, NULL, NULL, 0);
-   free(data);
-   data = NULL;
+   add_metric_to_art(container->general_metrics, "pgmoneta_progress_done", data->str, NULL, NULL, 0);
+   pgmoneta_string_builder_reset(data);
+
+   pgmoneta_string_builder_destroy(data);
 }
 
 static void
@@ -2809,85 +3073,89 @@ backup_information(prometheus_metrics_container_t* container, int* number_of_bac
    bool valid;
    int valid_count = 0;
    int invalid_count = 0;
-   char* data = NULL;
+   struct string_builder* data = NULL;
    struct main_configuration* config;
 
    config = (struct main_configuration*)shmem;
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_backup_oldest The oldest backup for a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_backup_oldest gauge\n");
+   if (pgmoneta_string_builder_create(0, &data))
+   {
+      return;
+   }
+
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_backup_oldest The oldest backup for a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_backup_oldest gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
-      data = pgmoneta_append(data, "pgmoneta_backup_oldest{");
+      pgmoneta_string_builder_append(data, "pgmoneta_backup_oldest{");
 
-      data = pgmoneta_append(data, "name=\"");
-      data = pgmoneta_append(data, config->common.servers[i].name);
-      data = pgmoneta_append(data, "\"} ");
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\"} ");
 
       valid = false;
       for (int j = 0; !valid && j < number_of_backups[i]; j++)
       {
          if (pgmoneta_is_backup_struct_valid(i, backups[i][j]))
          {
-            data = pgmoneta_append(data, backups[i][j]->label);
+            pgmoneta_string_builder_append(data, backups[i][j]->label);
             valid = true;
          }
       }
 
       if (!valid)
       {
-         data = pgmoneta_append(data, "0");
+         pgmoneta_string_builder_append(data, "0");
       }
 
-      data = pgmoneta_append(data, "\n");
+      pgmoneta_string_builder_append(data, "\n");
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   if (data != NULL)
+   if (data->length > 0)
    {
-      add_metric_to_art(container->backup_metrics, "pgmoneta_backup_oldest", data, NULL, NULL, 0);
-      free(data);
-      data = NULL;
+      add_metric_to_art(container->backup_metrics, "pgmoneta_backup_oldest", data->str, NULL, NULL, 0);
+      pgmoneta_string_builder_reset(data);
    }
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_backup_newest The newest backup for a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_backup_newest gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_backup_newest The newest backup for a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_backup_newest gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
-      data = pgmoneta_append(data, "pgmoneta_backup_newest{");
+      pgmoneta_string_builder_append(data, "pgmoneta_backup_newest{");
 
-      data = pgmoneta_append(data, "name=\"");
-      data = pgmoneta_append(data, config->common.servers[i].name);
-      data = pgmoneta_append(data, "\"} ");
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\"} ");
 
       valid = false;
       for (int j = number_of_backups[i] - 1; !valid && j >= 0; j--)
       {
          if (pgmoneta_is_backup_struct_valid(i, backups[i][j]))
          {
-            data = pgmoneta_append(data, backups[i][j]->label);
+            pgmoneta_string_builder_append(data, backups[i][j]->label);
             valid = true;
          }
       }
 
       if (!valid)
       {
-         data = pgmoneta_append(data, "0");
+         pgmoneta_string_builder_append(data, "0");
       }
 
-      data = pgmoneta_append(data, "\n");
+      pgmoneta_string_builder_append(data, "\n");
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_backup_valid The number of valid backups for a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_backup_valid gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_backup_valid The number of valid backups for a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_backup_valid gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
-      data = pgmoneta_append(data, "pgmoneta_backup_valid{");
+      pgmoneta_string_builder_append(data, "pgmoneta_backup_valid{");
 
-      data = pgmoneta_append(data, "name=\"");
-      data = pgmoneta_append(data, config->common.servers[i].name);
-      data = pgmoneta_append(data, "\"} ");
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\"} ");
 
       valid_count = 0;
       for (int j = 0; j < number_of_backups[i]; j++)
@@ -2898,28 +3166,27 @@ backup_information(prometheus_metrics_container_t* container, int* number_of_bac
          }
       }
 
-      data = pgmoneta_append_int(data, valid_count);
+      pgmoneta_string_builder_append_int(data, valid_count);
 
-      data = pgmoneta_append(data, "\n");
+      pgmoneta_string_builder_append(data, "\n");
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   if (data != NULL)
+   if (data->length > 0)
    {
-      add_metric_to_art(container->backup_metrics, "pgmoneta_backup_valid", data, NULL, NULL, 0);
-      free(data);
-      data = NULL;
+      add_metric_to_art(container->backup_metrics, "pgmoneta_backup_valid", data->str, NULL, NULL, 0);
+      pgmoneta_string_builder_reset(data);
    }
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_backup_invalid The number of invalid backups for a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_backup_invalid gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_backup_invalid The number of invalid backups for a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_backup_invalid gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
-      data = pgmoneta_append(data, "pgmoneta_backup_invalid{");
+      pgmoneta_string_builder_append(data, "pgmoneta_backup_invalid{");
 
-      data = pgmoneta_append(data, "name=\"");
-      data = pgmoneta_append(data, config->common.servers[i].name);
-      data = pgmoneta_append(data, "\"} ");
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\"} ");
 
       invalid_count = 0;
       for (int j = 0; j < number_of_backups[i]; j++)
@@ -2930,590 +3197,628 @@ backup_information(prometheus_metrics_container_t* container, int* number_of_bac
          }
       }
 
-      data = pgmoneta_append_int(data, invalid_count);
+      pgmoneta_string_builder_append_int(data, invalid_count);
 
-      data = pgmoneta_append(data, "\n");
+      pgmoneta_string_builder_append(data, "\n");
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   if (data != NULL)
+   if (data->length > 0)
    {
-      add_metric_to_art(container->backup_metrics, "pgmoneta_backup_invalid", data, NULL, NULL, 0);
-      free(data);
-      data = NULL;
+      add_metric_to_art(container->backup_metrics, "pgmoneta_backup_invalid", data->str, NULL, NULL, 0);
+      pgmoneta_string_builder_reset(data);
    }
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_backup Is the backup valid for a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_backup gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_backup Is the backup valid for a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_backup gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
       if (number_of_backups[i] > 0)
       {
          for (int j = 0; j < number_of_backups[i]; j++)
          {
-            data = pgmoneta_append(data, "pgmoneta_backup{");
+            pgmoneta_string_builder_append(data, "pgmoneta_backup{");
 
-            data = pgmoneta_append(data, "name=\"");
-            data = pgmoneta_append(data, config->common.servers[i].name);
-            data = pgmoneta_append(data, "\", label=\"");
-            data = pgmoneta_append(data, backups[i][j] != NULL ? backups[i][j]->label : "0");
-            data = pgmoneta_append(data, "\"} ");
+            pgmoneta_string_builder_append(data, "name=\"");
+            pgmoneta_string_builder_append(data, config->common.servers[i].name);
+            pgmoneta_string_builder_append(data, "\", label=\"");
+            pgmoneta_string_builder_append(data, backups[i][j] != NULL ? backups[i][j]->label : "0");
+            pgmoneta_string_builder_append(data, "\"} ");
 
-            data = pgmoneta_append_int(data, pgmoneta_is_backup_struct_valid(i, backups[i][j]));
+            pgmoneta_string_builder_append_int(data, pgmoneta_is_backup_struct_valid(i, backups[i][j]));
 
-            data = pgmoneta_append(data, "\n");
+            pgmoneta_string_builder_append(data, "\n");
          }
       }
       else
       {
-         data = pgmoneta_append(data, "pgmoneta_backup{");
+         pgmoneta_string_builder_append(data, "pgmoneta_backup{");
 
-         data = pgmoneta_append(data, "name=\"");
-         data = pgmoneta_append(data, config->common.servers[i].name);
-         data = pgmoneta_append(data, "\", label=\"0\"} 0");
+         pgmoneta_string_builder_append(data, "name=\"");
+         pgmoneta_string_builder_append(data, config->common.servers[i].name);
+         pgmoneta_string_builder_append(data, "\", label=\"0\"} 0");
 
-         data = pgmoneta_append(data, "\n");
+         pgmoneta_string_builder_append(data, "\n");
       }
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   if (data != NULL)
+   if (data->length > 0)
    {
-      add_metric_to_art(container->backup_metrics, "pgmoneta_backup", data, NULL, NULL, 0);
-      free(data);
-      data = NULL;
+      add_metric_to_art(container->backup_metrics, "pgmoneta_backup", data->str, NULL, NULL, 0);
+      pgmoneta_string_builder_reset(data);
    }
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_backup_version The version of postgresql for a backup\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_backup_version gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_backup_version The version of postgresql for a backup\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_backup_version gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
       if (number_of_backups[i] > 0)
       {
          for (int j = 0; j < number_of_backups[i]; j++)
          {
-            data = pgmoneta_append(data, "pgmoneta_backup_version{");
-
-            data = pgmoneta_append(data, "name=\"");
-            data = pgmoneta_append(data, config->common.servers[i].name);
-            data = pgmoneta_append(data, "\", label=\"");
-            data = pgmoneta_append(data, backups[i][j] != NULL ? backups[i][j]->label : "0");
-            data = pgmoneta_append(data, "\", major=\"");
-            data = pgmoneta_append_int(data, backups[i][j] != NULL ? backups[i][j]->major_version : 0);
-            data = pgmoneta_append(data, "\", minor=\"");
-            data = pgmoneta_append_int(data, backups[i][j] != NULL ? backups[i][j]->minor_version : 0);
-            data = pgmoneta_append(data, "\"} 1");
-
-            data = pgmoneta_append(data, "\n");
+            pgmoneta_string_builder_append(data, "pgmoneta_backup_version{");
+
+            pgmoneta_string_builder_append(data, "name=\"");
+            pgmoneta_string_builder_append(data, config->common.servers[i].name);
+            pgmoneta_string_builder_append(data, "\", label=\"");
+            pgmoneta_string_builder_append(data, backups[i][j] != NULL ? backups[i][j]->label : "0");
+            pgmoneta_string_builder_append(data, "\", major=\"");
+            pgmoneta_string_builder_append_int(data, backups[i][j] != NULL ? backups[i][j]->major_version : 0);
+            pgmoneta_string_builder_append(data, "\", minor=\"");
+            pgmoneta_string_builder_append_int(data, backups[i][j] != NULL ? backups[i][j]->minor_version : 0);
+            pgmoneta_string_builder_append(data, "\"} 1");
+
+            pgmoneta_string_builder_append(data, "\n");
          }
       }
       else
       {
-         data = pgmoneta_append(data, "pgmoneta_backup_version{");
+         pgmoneta_string_builder_append(data, "pgmoneta_backup_version{");
 
-         data = pgmoneta_append(data, "name=\"");
-         data = pgmoneta_append(data, config->common.servers[i].name);
-         data = pgmoneta_append(data, "\", label=\"");
-         data = pgmoneta_append(data, "0");
-         data = pgmoneta_append(data, "\", major=\"");
-         data = pgmoneta_append_int(data, 0);
-         data = pgmoneta_append(data, "\", minor=\"");
-         data = pgmoneta_append_int(data, 0);
-         data = pgmoneta_append(data, "\"} 0");
+         pgmoneta_string_builder_append(data, "name=\"");
+         pgmoneta_string_builder_append(data, config->common.servers[i].name);
+         pgmoneta_string_builder_append(data, "\", label=\"");
+         pgmoneta_string_builder_append(data, "0");
+         pgmoneta_string_builder_append(data, "\", major=\"");
+         pgmoneta_string_builder_append_int(data, 0);
+         pgmoneta_string_builder_append(data, "\", minor=\"");
+         pgmoneta_string_builder_append_int(data, 0);
+         pgmoneta_string_builder_append(data, "\"} 0");
 
-         data = pgmoneta_append(data, "\n");
+         pgmoneta_string_builder_append(data, "\n");
       }
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   if (data != NULL)
+   if (data->length > 0)
    {
-      add_metric_to_art(container->backup_metrics, "pgmoneta_backup_version", data, NULL, NULL, 0);
-      free(data);
-      data = NULL;
+      add_metric_to_art(container->backup_metrics, "pgmoneta_backup_version", data->str, NULL, NULL, 0);
+      pgmoneta_string_builder_reset(data);
+   }
+
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_backup_total_elapsed_time The backup in seconds for a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_backup_total_elapsed_time gauge\n");
+   for (int i = 0; i < config->common.number_of_servers; i++)
+   {
+      if (number_of_backups[i] > 0)
+      {
+         for (int j = 0; j < number_of_backups[i]; j++)
+         {
+            pgmoneta_string_builder_append(data, "pgmoneta_backup_total_elapsed_time{");
+
+            pgmoneta_string_builder_append(data, "name=\"");
+            pgmoneta_string_builder_append(data, config->common.servers[i].name);
+            pgmoneta_string_builder_append(data, "\", label=\"");
+            pgmoneta_string_builder_append(data, backups[i][j] != NULL ? backups[i][j]->label : "0");
+            pgmoneta_string_builder_append(data, "\"} ");
+
+            pgmoneta_string_builder_append_double_precision(data, backups[i][j] != NULL ? backups[i][j]->total_elapsed_time : 0.0, 4);
+
+            pgmoneta_string_builder_append(data, "\n");
+         }
+      }
+      else
+      {
+         pgmoneta_string_builder_append(data, "pgmoneta_backup_total_elapsed_time{");
+
+         pgmoneta_string_builder_append(data, "name=\"");
+         pgmoneta_string_builder_append(data, config->common.servers[i].name);
+         pgmoneta_string_builder_append(data, "\", label=\"0\"} 0.0");
+
+         pgmoneta_string_builder_append(data, "\n");
+      }
    }
+   pgmoneta_string_builder_append(data, "\n");
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_backup_total_elapsed_time The backup in seconds for a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_backup_total_elapsed_time gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_backup_basebackup_elapsed_time The duration for basebackup in seconds for a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_backup_basebackup_elapsed_time gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
       if (number_of_backups[i] > 0)
       {
          for (int j = 0; j < number_of_backups[i]; j++)
          {
-            data = pgmoneta_append(data, "pgmoneta_backup_total_elapsed_time{");
+            pgmoneta_string_builder_append(data, "pgmoneta_backup_basebackup_elapsed_time{");
 
-            data = pgmoneta_append(data, "name=\"");
-            data = pgmoneta_append(data, config->common.servers[i].name);
-            data = pgmoneta_append(data, "\", label=\"");
-            data = pgmoneta_append(data, backups[i][j] != NULL ? backups[i][j]->label : "0");
-            data = pgmoneta_append(data, "\"} ");
+            pgmoneta_string_builder_append(data, "name=\"");
+            pgmoneta_string_builder_append(data, config->common.servers[i].name);
+            pgmoneta_string_builder_append(data, "\", label=\"");
+            pgmoneta_string_builder_append(data, backups[i][j] != NULL ? backups[i][j]->label : "0");
+            pgmoneta_string_builder_append(data, "\"} ");
 
-            data = pgmoneta_append_double_precision(data, backups[i][j] != NULL ? backups[i][j]->total_elapsed_time : 0.0, 4);
+            pgmoneta_string_builder_append_double_precision(data, backups[i][j] != NULL ? backups[i][j]->basebackup_elapsed_time : 0.0, 4);
 
-            data = pgmoneta_append(data, "\n");
+            pgmoneta_string_builder_append(data, "\n");
          }
       }
       else
       {
-         data = pgmoneta_append(data, "pgmoneta_backup_total_elapsed_time{");
+         pgmoneta_string_builder_append(data, "pgmoneta_backup_basebackup_elapsed_time{");
 
-         data = pgmoneta_append(data, "name=\"");
-         data = pgmoneta_append(data, config->common.servers[i].name);
-         data = pgmoneta_append(data, "\", label=\"0\"} 0.0");
+         pgmoneta_string_builder_append(data, "name=\"");
+         pgmoneta_string_builder_append(data, config->common.servers[i].name);
+         pgmoneta_string_builder_append(data, "\", label=\"0\"} 0.0");
 
-         data = pgmoneta_append(data, "\n");
+         pgmoneta_string_builder_append(data, "\n");
       }
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_backup_basebackup_elapsed_time The duration for basebackup in seconds for a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_backup_basebackup_elapsed_time gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_backup_manifest_elapsed_time The duration for manifest in seconds for a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_backup_manifest_elapsed_time gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
       if (number_of_backups[i] > 0)
       {
          for (int j = 0; j < number_of_backups[i]; j++)
          {
-            data = pgmoneta_append(data, "pgmoneta_backup_basebackup_elapsed_time{");
+            pgmoneta_string_builder_append(data, "pgmoneta_backup_manifest_elapsed_time{");
 
-            data = pgmoneta_append(data, "name=\"");
-            data = pgmoneta_append(data, config->common.servers[i].name);
-            data = pgmoneta_append(data, "\", label=\"");
-            data = pgmoneta_append(data, backups[i][j] != NULL ? backups[i][j]->label : "0");
-            data = pgmoneta_append(data, "\"} ");
+            pgmoneta_string_builder_append(data, "name=\"");
+            pgmoneta_string_builder_append(data, config->common.servers[i].name);
+            pgmoneta_string_builder_append(data, "\", label=\"");
+            pgmoneta_string_builder_append(data, backups[i][j] != NULL ? backups[i][j]->label : "0");
+            pgmoneta_string_builder_append(data, "\"} ");
 
-            data = pgmoneta_append_double_precision(data, backups[i][j] != NULL ? backups[i][j]->basebackup_elapsed_time : 0.0, 4);
+            pgmoneta_string_builder_append_double_precision(data, backups[i][j] != NULL ? backups[i][j]->manifest_elapsed_time : 0.0, 4);
 
-            data = pgmoneta_append(data, "\n");
+            pgmoneta_string_builder_append(data, "\n");
          }
       }
       else
       {
-         data = pgmoneta_append(data, "pgmoneta_backup_basebackup_elapsed_time{");
+         pgmoneta_string_builder_append(data, "pgmoneta_backup_manifest_elapsed_time{");
 
-         data = pgmoneta_append(data, "name=\"");
-         data = pgmoneta_append(data, config->common.servers[i].name);
-         data = pgmoneta_append(data, "\", label=\"0\"} 0.0");
+         pgmoneta_string_builder_append(data, "name=\"");
+         pgmoneta_string_builder_append(data, config->common.servers[i].name);
+         pgmoneta_string_builder_append(data, "\", label=\"0\"} 0.0");
 
-         data = pgmoneta_append(data, "\n");
+         pgmoneta_string_builder_append(data, "\n");
       }
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_backup_manifest_elapsed_time The duration for manifest in seconds for a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_backup_manifest_elapsed_time gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_backup_compression_zstd_elapsed_time The duration for zstd compression in seconds for a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_backup_compression_zstd_elapsed_time gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
       if (number_of_backups[i] > 0)
       {
          for (int j = 0; j < number_of_backups[i]; j++)
          {
-            data = pgmoneta_append(data, "pgmoneta_backup_manifest_elapsed_time{");
+            pgmoneta_string_builder_append(data, "pgmoneta_backup_compression_zstd_elapsed_time{");
 
-            data = pgmoneta_append(data, "name=\"");
-            data = pgmoneta_append(data, config->common.servers[i].name);
-            data = pgmoneta_append(data, "\", label=\"");
-            data = pgmoneta_append(data, backups[i][j] != NULL ? backups[i][j]->label : "0");
-            data = pgmoneta_append(data, "\"} ");
+            pgmoneta_string_builder_append(data, "name=\"");
+            pgmoneta_string_builder_append(data, config->common.servers[i].name);
+            pgmoneta_string_builder_append(data, "\", label=\"");
+            pgmoneta_string_builder_append(data, backups[i][j] != NULL ? backups[i][j]->label : "0");
+            pgmoneta_string_builder_append(data, "\"} ");
 
-            data = pgmoneta_append_double_precision(data, backups[i][j] != NULL ? backups[i][j]->manifest_elapsed_time : 0.0, 4);
+            pgmoneta_string_builder_append_double_precision(data, backups[i][j] != NULL ? backups[i][j]->compression_zstd_elapsed_time : 0.0, 4);
 
-            data = pgmoneta_append(data, "\n");
+            pgmoneta_string_builder_append(data, "\n");
          }
       }
       else
       {
-         data = pgmoneta_append(data, "pgmoneta_backup_manifest_elapsed_time{");
+         pgmoneta_string_builder_append(data, "pgmoneta_backup_compression_zstd_elapsed_time{");
 
-         data = pgmoneta_append(data, "name=\"");
-         data = pgmoneta_append(data, config->common.servers[i].name);
-         data = pgmoneta_append(data, "\", label=\"0\"} 0.0");
+         pgmoneta_string_builder_append(data, "name=\"");
+         pgmoneta_string_builder_append(data, config->common.servers[i].name);
+         pgmoneta_string_builder_append(data, "\", label=\"0\"} 0.0");
 
-         data = pgmoneta_append(data, "\n");
+         pgmoneta_string_builder_append(data, "\n");
       }
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_backup_compression_zstd_elapsed_time The duration for zstd compression in seconds for a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_backup_compression_zstd_elapsed_time gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_backup_compression_gzip_elapsed_time The duration for gzip compression in seconds for a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_backup_compression_gzip_elapsed_time gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
       if (number_of_backups[i] > 0)
       {
          for (int j = 0; j < number_of_backups[i]; j++)
          {
-            data = pgmoneta_append(data, "pgmoneta_backup_compression_zstd_elapsed_time{");
+            pgmoneta_string_builder_append(data, "pgmoneta_backup_compression_gzip_elapsed_time{");
 
-            data = pgmoneta_append(data, "name=\"");
-            data = pgmoneta_append(data, config->common.servers[i].name);
-            data = pgmoneta_append(data, "\", label=\"");
-            data = pgmoneta_append(data, backups[i][j] != NULL ? backups[i][j]->label : "0");
-            data = pgmoneta_append(data, "\"} ");
+            pgmoneta_string_builder_append(data, "name=\"");
+            pgmoneta_string_builder_append(data, config->common.servers[i].name);
+            pgmoneta_string_builder_append(data, "\", label=\"");
+            pgmoneta_string_builder_append(data, backups[i][j] != NULL ? backups[i][j]->label : "0");
+            pgmoneta_string_builder_append(data, "\"} ");
 
-            data = pgmoneta_append_double_precision(data, backups[i][j] != NULL ? backups[i][j]->compression_zstd_elapsed_time : 0.0, 4);
+            pgmoneta_string_builder_append_double_precision(data, backups[i][j] != NULL ? backups[i][j]->compression_gzip_elapsed_time : 0.0, 4);
 
-            data = pgmoneta_append(data, "\n");
+            pgmoneta_string_builder_append(data, "\n");
          }
       }
       else
       {
-         data = pgmoneta_append(data, "pgmoneta_backup_compression_zstd_elapsed_time{");
+         pgmoneta_string_builder_append(data, "pgmoneta_backup_compression_gzip_elapsed_time{");
 
-         data = pgmoneta_append(data, "name=\"");
-         data = pgmoneta_append(data, config->common.servers[i].name);
-         data = pgmoneta_append(data, "\", label=\"0\"} 0.0");
+         pgmoneta_string_builder_append(data, "name=\"");
+         pgmoneta_string_builder_append(data, config->common.servers[i].name);
+         pgmoneta_string_builder_append(data, "\", label=\"0\"} 0.0");
 
-         data = pgmoneta_append(data, "\n");
+         pgmoneta_string_builder_append(data, "\n");
       }
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_backup_compression_gzip_elapsed_time The duration for gzip compression in seconds for a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_backup_compression_gzip_elapsed_time gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_backup_compression_bzip2_elapsed_time The duration for bzip2 compression in seconds for a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_backup_compression_bzip2_elapsed_time gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
       if (number_of_backups[i] > 0)
       {
          for (int j = 0; j < number_of_backups[i]; j++)
          {
-            data = pgmoneta_append(data, "pgmoneta_backup_compression_gzip_elapsed_time{");
+            pgmoneta_string_builder_append(data, "pgmoneta_backup_compression_bzip2_elapsed_time{");
 
-            data = pgmoneta_append(data, "name=\"");
-            data = pgmoneta_append(data, config->common.servers[i].name);
-            data = pgmoneta_append(data, "\", label=\"");
-            data = pgmoneta_append(data, backups[i][j] != NULL ? backups[i][j]->label : "0");
-            data = pgmoneta_append(data, "\"} ");
+            pgmoneta_string_builder_append(data, "name=\"");
+            pgmoneta_string_builder_append(data, config->common.servers[i].name);
+            pgmoneta_string_builder_append(data, "\", label=\"");
+            pgmoneta_string_builder_append(data, backups[i][j] != NULL ? backups[i][j]->label : "0");
+            pgmoneta_string_builder_append(data, "\"} ");
 
-            data = pgmoneta_append_double_precision(data, backups[i][j] != NULL ? backups[i][j]->compression_gzip_elapsed_time : 0.0, 4);
+            pgmoneta_string_builder_append_double_precision(data, backups[i][j] != NULL ? backups[i][j]->compression_bzip2_elapsed_time : 0.0, 4);
 
-            data = pgmoneta_append(data, "\n");
+            pgmoneta_string_builder_append(data, "\n");
          }
       }
       else
       {
-         data = pgmoneta_append(data, "pgmoneta_backup_compression_gzip_elapsed_time{");
+         pgmoneta_string_builder_append(data, "pgmoneta_backup_compression_bzip2_elapsed_time{");
 
-         data = pgmoneta_append(data, "name=\"");
-         data = pgmoneta_append(data, config->common.servers[i].name);
-         data = pgmoneta_append(data, "\", label=\"0\"} 0.0");
+         pgmoneta_string_builder_append(data, "name=\"");
+         pgmoneta_string_builder_append(data, config->common.servers[i].name);
+         pgmoneta_string_builder_append(data, "\", label=\"0\"} 0.0");
 
-         data = pgmoneta_append(data, "\n");
+         pgmoneta_string_builder_append(data, "\n");
       }
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_backup_compression_bzip2_elapsed_time The duration for bzip2 compression in seconds for a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_backup_compression_bzip2_elapsed_time gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_backup_compression_lz4_elapsed_time The duration for lz4 compression in seconds for a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_backup_compression_lz4_elapsed_time gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
       if (number_of_backups[i] > 0)
       {
          for (int j = 0; j < number_of_backups[i]; j++)
          {
-            data = pgmoneta_append(data, "pgmoneta_backup_compression_bzip2_elapsed_time{");
+            pgmoneta_string_builder_append(data, "pgmoneta_backup_compression_lz4_elapsed_time{");
 
-            data = pgmoneta_append(data, "name=\"");
-            data = pgmoneta_append(data, config->common.servers[i].name);
-            data = pgmoneta_append(data, "\", label=\"");
-            data = pgmoneta_append(data, backups[i][j] != NULL ? backups[i][j]->label : "0");
-            data = pgmoneta_append(data, "\"} ");
+            pgmoneta_string_builder_append(data, "name=\"");
+            pgmoneta_string_builder_append(data, config->common.servers[i].name);
+            pgmoneta_string_builder_append(data, "\", label=\"");
+            pgmoneta_string_builder_append(data, backups[i][j] != NULL ? backups[i][j]->label : "0");
+            pgmoneta_string_builder_append(data, "\"} ");
 
-            data = pgmoneta_append_double_precision(data, backups[i][j] != NULL ? backups[i][j]->compression_bzip2_elapsed_time : 0.0, 4);
+            pgmoneta_string_builder_append_double_precision(data, backups[i][j] != NULL ? backups[i][j]->compression_lz4_elapsed_time : 0.0, 4);
 
-            data = pgmoneta_append(data, "\n");
+            pgmoneta_string_builder_append(data, "\n");
          }
       }
       else
       {
-         data = pgmoneta_append(data, "pgmoneta_backup_compression_bzip2_elapsed_time{");
+         pgmoneta_string_builder_append(data, "pgmoneta_backup_compression_lz4_elapsed_time{");
 
-         data = pgmoneta_append(data, "name=\"");
-         data = pgmoneta_append(data, config->common.servers[i].name);
-         data = pgmoneta_append(data, "\", label=\"0\"} 0.0");
+         pgmoneta_string_builder_append(data, "name=\"");
+         pgmoneta_string_builder_append(data, config->common.servers[i].name);
+         pgmoneta_string_builder_append(data, "\", label=\"0\"} 0.0");
 
-         data = pgmoneta_append(data, "\n");
+         pgmoneta_string_builder_append(data, "\n");
       }
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_backup_compression_lz4_elapsed_time The duration for lz4 compression in seconds for a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_backup_compression_lz4_elapsed_time gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_backup_encryption_elapsed_time The duration for encryption in seconds for a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_backup_encryption_elapsed_time gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
       if (number_of_backups[i] > 0)
       {
          for (int j = 0; j < number_of_backups[i]; j++)
          {
-            data = pgmoneta_append(data, "pgmoneta_backup_compression_lz4_elapsed_time{");
+            pgmoneta_string_builder_append(data, "pgmoneta_backup_encryption_elapsed_time{");
 
-            data = pgmoneta_append(data, "name=\"");
-            data = pgmoneta_append(data, config->common.servers[i].name);
-            data = pgmoneta_append(data, "\", label=\"");
-            data = pgmoneta_append(data, backups[i][j] != NULL ? backups[i][j]->label : "0");
-            data = pgmoneta_append(data, "\"} ");
+            pgmoneta_string_builder_append(data, "name=\"");
+            pgmoneta_string_builder_append(data, config->common.servers[i].name);
+            pgmoneta_string_builder_append(data, "\", label=\"");
+            pgmoneta_string_builder_append(data, backups[i][j] != NULL ? backups[i][j]->label : "0");
+            pgmoneta_string_builder_append(data, "\"} ");
 
-            data = pgmoneta_append_double_precision(data, backups[i][j] != NULL ? backups[i][j]->compression_lz4_elapsed_time : 0.0, 4);
+            pgmoneta_string_builder_append_double_precision(data, backups[i][j] != NULL ? backups[i][j]->encryption_elapsed_time : 0.0, 4);
 
-            data = pgmoneta_append(data, "\n");
+            pgmoneta_string_builder_append(data, "\n");
          }
       }
       else
       {
-         data = pgmoneta_append(data, "pgmoneta_backup_compression_lz4_elapsed_time{");
+         pgmoneta_string_builder_append(data, "pgmoneta_backup_encryption_elapsed_time{");
 
-         data = pgmoneta_append(data, "name=\"");
-         data = pgmoneta_append(data, config->common.servers[i].name);
-         data = pgmoneta_append(data, "\", label=\"0\"} 0.0");
+         pgmoneta_string_builder_append(data, "name=\"");
+         pgmoneta_string_builder_append(data, config->common.servers[i].name);
+         pgmoneta_string_builder_append(data, "\", label=\"0\"} 0.0");
 
-         data = pgmoneta_append(data, "\n");
+         pgmoneta_string_builder_append(data, "\n");
       }
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_backup_encryption_elapsed_time The duration for encryption in seconds for a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_backup_encryption_elapsed_time gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_backup_linking_elapsed_time The duration for linking in seconds for a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_backup_linking_elapsed_time gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
       if (number_of_backups[i] > 0)
       {
          for (int j = 0; j < number_of_backups[i]; j++)
          {
-            data = pgmoneta_append(data, "pgmoneta_backup_encryption_elapsed_time{");
+            pgmoneta_string_builder_append(data, "pgmoneta_backup_linking_elapsed_time{");
 
-            data = pgmoneta_append(data, "name=\"");
-            data = pgmoneta_append(data, config->common.servers[i].name);
-            data = pgmoneta_append(data, "\", label=\"");
-            data = pgmoneta_append(data, backups[i][j] != NULL ? backups[i][j]->label : "0");
-            data = pgmoneta_append(data, "\"} ");
+            pgmoneta_string_builder_append(data, "name=\"");
+            pgmoneta_string_builder_append(data, config->common.servers[i].name);
+            pgmoneta_string_builder_append(data, "\", label=\"");
+            pgmoneta_string_builder_append(data, backups[i][j] != NULL ? backups[i][j]->label : "0");
+            pgmoneta_string_builder_append(data, "\"} ");
 
-            data = pgmoneta_append_double_precision(data, backups[i][j] != NULL ? backups[i][j]->encryption_elapsed_time : 0.0, 4);
+            pgmoneta_string_builder_append_double_precision(data, backups[i][j] != NULL ? backups[i][j]->linking_elapsed_time : 0.0, 4);
 
-            data = pgmoneta_append(data, "\n");
+            pgmoneta_string_builder_append(data, "\n");
          }
       }
       else
       {
-         data = pgmoneta_append(data, "pgmoneta_backup_encryption_elapsed_time{");
+         pgmoneta_string_builder_append(data, "pgmoneta_backup_linking_elapsed_time{");
 
-         data = pgmoneta_append(data, "name=\"");
-         data = pgmoneta_append(data, config->common.servers[i].name);
-         data = pgmoneta_append(data, "\", label=\"0\"} 0.0");
+         pgmoneta_string_builder_append(data, "name=\"");
+         pgmoneta_string_builder_append(data, config->common.servers[i].name);
+         pgmoneta_string_builder_append(data, "\", label=\"0\"} 0.0");
 
-         data = pgmoneta_append(data, "\n");
+         pgmoneta_string_builder_append(data, "\n");
       }
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_backup_linking_elapsed_time The duration for linking in seconds for a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_backup_linking_elapsed_time gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_backup_dedup_ratio The share of the chunked data of a backup that was already in the chunk store\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_backup_dedup_ratio gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
       if (number_of_backups[i] > 0)
       {
          for (int j = 0; j < number_of_backups[i]; j++)
          {
-            data = pgmoneta_append(data, "pgmoneta_backup_linking_elapsed_time{");
+            double ratio = 0.0;
+
+            if (backups[i][j] != NULL && backups[i][j]->chunked_size > 0)
+            {
+               ratio = 1.0 - ((double)backups[i][j]->chunked_stored_size / (double)backups[i][j]->chunked_size);
+            }
 
-            data = pgmoneta_append(data, "name=\"");
-            data = pgmoneta_append(data, config->common.servers[i].name);
-            data = pgmoneta_append(data, "\", label=\"");
-            data = pgmoneta_append(data, backups[i][j] != NULL ? backups[i][j]->label : "0");
-            data = pgmoneta_append(data, "\"} ");
+            pgmoneta_string_builder_append(data, "pgmoneta_backup_dedup_ratio{");
 
-            data = pgmoneta_append_double_precision(data, backups[i][j] != NULL ? backups[i][j]->linking_elapsed_time : 0.0, 4);
+            pgmoneta_string_builder_append(data, "name=\"");
+            pgmoneta_string_builder_append(data, config->common.servers[i].name);
+            pgmoneta_string_builder_append(data, "\", label=\"");
+            pgmoneta_string_builder_append(data, backups[i][j] != NULL ? backups[i][j]->label : "0");
+            pgmoneta_string_builder_append(data, "\"} ");
 
-            data = pgmoneta_append(data, "\n");
+            pgmoneta_string_builder_append_double_precision(data, ratio, 4);
+
+            pgmoneta_string_builder_append(data, "\n");
          }
       }
       else
       {
-         data = pgmoneta_append(data, "pgmoneta_backup_linking_elapsed_time{");
+         pgmoneta_string_builder_append(data, "pgmoneta_backup_dedup_ratio{");
 
-         data = pgmoneta_append(data, "name=\"");
-         data = pgmoneta_append(data, config->common.servers[i].name);
-         data = pgmoneta_append(data, "\", label=\"0\"} 0.0");
+         pgmoneta_string_builder_append(data, "name=\"");
+         pgmoneta_string_builder_append(data, config->common.servers[i].name);
+         pgmoneta_string_builder_append(data, "\", label=\"0\"} 0.0");
 
-         data = pgmoneta_append(data, "\n");
+         pgmoneta_string_builder_append(data, "\n");
       }
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_backup_remote_ssh_elapsed_time The duration for remote ssh in seconds for a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_backup_remote_ssh_elapsed_time gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_backup_remote_ssh_elapsed_time The duration for remote ssh in seconds for a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_backup_remote_ssh_elapsed_time gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
       if (number_of_backups[i] > 0)
       {
          for (int j = 0; j < number_of_backups[i]; j++)
          {
-            data = pgmoneta_append(data, "pgmoneta_backup_remote_ssh_elapsed_time{");
+            pgmoneta_string_builder_append(data, "pgmoneta_backup_remote_ssh_elapsed_time{");
 
-            data = pgmoneta_append(data, "name=\"");
-            data = pgmoneta_append(data, config->common.servers[i].name);
-            data = pgmoneta_append(data, "\", label=\"");
-            data = pgmoneta_append(data, backups[i][j] != NULL ? backups[i][j]->label : "0");
-            data = pgmoneta_append(data, "\"} ");
+            pgmoneta_string_builder_append(data, "name=\"");
+            pgmoneta_string_builder_append(data, config->common.servers[i].name);
+            pgmoneta_string_builder_append(data, "\", label=\"");
+            pgmoneta_string_builder_append(data, backups[i][j] != NULL ? backups[i][j]->label : "0");
+            pgmoneta_string_builder_append(data, "\"} ");
 
-            data = pgmoneta_append_double_precision(data, backups[i][j] != NULL ? backups[i][j]->remote_ssh_elapsed_time : 0.0, 4);
+            pgmoneta_string_builder_append_double_precision(data, backups[i][j] != NULL ? backups[i][j]->remote_ssh_elapsed_time : 0.0, 4);
 
-            data = pgmoneta_append(data, "\n");
+            pgmoneta_string_builder_append(data, "\n");
          }
       }
       else
       {
-         data = pgmoneta_append(data, "pgmoneta_backup_remote_ssh_elapsed_time{");
+         pgmoneta_string_builder_append(data, "pgmoneta_backup_remote_ssh_elapsed_time{");
 
-         data = pgmoneta_append(data, "name=\"");
-         data = pgmoneta_append(data, config->common.servers[i].name);
-         data = pgmoneta_append(data, "\", label=\"0\"} 0.0");
+         pgmoneta_string_builder_append(data, "name=\"");
+         pgmoneta_string_builder_append(data, config->common.servers[i].name);
+         pgmoneta_string_builder_append(data, "\", label=\"0\"} 0.0");
 
-         data = pgmoneta_append(data, "\n");
+         pgmoneta_string_builder_append(data, "\n");
       }
    }
 
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_backup_remote_s3_elapsed_time The duration for remote_s3 in seconds for a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_backup_remote_s3_elapsed_time gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_backup_remote_s3_elapsed_time The duration for remote_s3 in seconds for a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_backup_remote_s3_elapsed_time gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
       if (number_of_backups[i] > 0)
       {
          for (int j = 0; j < number_of_backups[i]; j++)
          {
-            data = pgmoneta_append(data, "pgmoneta_backup_remote_s3_elapsed_time{");
+            pgmoneta_string_builder_append(data, "pgmoneta_backup_remote_s3_elapsed_time{");
 
-            data = pgmoneta_append(data, "name=\"");
-            data = pgmoneta_append(data, config->common.servers[i].name);
-            data = pgmoneta_append(data, "\", label=\"");
-            data = pgmoneta_append(data, backups[i][j] != NULL ? backups[i][j]->label : "0");
-            data = pgmoneta_append(data, "\"} ");
+            pgmoneta_string_builder_append(data, "name=\"");
+            pgmoneta_string_builder_append(data, config->common.servers[i].name);
+            pgmoneta_string_builder_append(data, "\", label=\"");
+            pgmoneta_string_builder_append(data, backups[i][j] != NULL ? backups[i][j]->label : "0");
+            pgmoneta_string_builder_append(data, "\"} ");
 
-            data = pgmoneta_append_double_precision(data, backups[i][j] != NULL ? backups[i][j]->remote_s3_elapsed_time : 0.0, 4);
+            pgmoneta_string_builder_append_double_precision(data, backups[i][j] != NULL ? backups[i][j]->remote_s3_elapsed_time : 0.0, 4);
 
-            data = pgmoneta_append(data, "\n");
+            pgmoneta_string_builder_append(data, "\n");
          }
       }
       else
       {
-         data = pgmoneta_append(data, "pgmoneta_backup_remote_s3_elapsed_time{");
+         pgmoneta_string_builder_append(data, "pgmoneta_backup_remote_s3_elapsed_time{");
 
-         data = pgmoneta_append(data, "name=\"");
-         data = pgmoneta_append(data, config->common.servers[i].name);
-         data = pgmoneta_append(data, "\", label=\"0\"} 0.0");
+         pgmoneta_string_builder_append(data, "name=\"");
+         pgmoneta_string_builder_append(data, config->common.servers[i].name);
+         pgmoneta_string_builder_append(data, "\", label=\"0\"} 0.0");
 
-         data = pgmoneta_append(data, "\n");
+         pgmoneta_string_builder_append(data, "\n");
       }
    }
 
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_backup_remote_azure_elapsed_time The duration for remote_azure in seconds for a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_backup_remote_azure_elapsed_time gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_backup_remote_azure_elapsed_time The duration for remote_azure in seconds for a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_backup_remote_azure_elapsed_time gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
       if (number_of_backups[i] > 0)
       {
          for (int j = 0; j < number_of_backups[i]; j++)
          {
-            data = pgmoneta_append(data, "pgmoneta_backup_remote_azure_elapsed_time{");
+            pgmoneta_string_builder_append(data, "pgmoneta_backup_remote_azure_elapsed_time{");
 
-            data = pgmoneta_append(data, "name=\"");
-            data = pgmoneta_append(data, config->common.servers[i].name);
-            data = pgmoneta_append(data, "\", label=\"");
-            data = pgmoneta_append(data, backups[i][j] != NULL ? backups[i][j]->label : "0");
-            data = pgmoneta_append(data, "\"} ");
+            pgmoneta_string_builder_append(data, "name=\"");
+            pgmoneta_string_builder_append(data, config->common.servers[i].name);
+            pgmoneta_string_builder_append(data, "\", label=\"");
+            pgmoneta_string_builder_append(data, backups[i][j] != NULL ? backups[i][j]->label : "0");
+            pgmoneta_string_builder_append(data, "\"} ");
 
-            data = pgmoneta_append_double_precision(data, backups[i][j] != NULL ? backups[i][j]->remote_azure_elapsed_time : 0.0, 4);
+            pgmoneta_string_builder_append_double_precision(data, backups[i][j] != NULL ? backups[i][j]->remote_azure_elapsed_time : 0.0, 4);
 
-            data = pgmoneta_append(data, "\n");
+            pgmoneta_string_builder_append(data, "\n");
          }
       }
       else
       {
-         data = pgmoneta_append(data, "pgmoneta_backup_remote_azure_elapsed_time{");
+         pgmoneta_string_builder_append(data, "pgmoneta_backup_remote_azure_elapsed_time{");
 
-         data = pgmoneta_append(data, "name=\"");
-         data = pgmoneta_append(data, config->common.servers[i].name);
-         data = pgmoneta_append(data, "\", label=\"0\"} 0.0");
+         pgmoneta_string_builder_append(data, "name=\"");
+         pgmoneta_string_builder_append(data, config->common.servers[i].name);
+         pgmoneta_string_builder_append(data, "\", label=\"0\"} 0.0");
 
-         data = pgmoneta_append(data, "\n");
+         pgmoneta_string_builder_append(data, "\n");
       }
    }
 
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_backup_start_timeline The starting timeline of a backup for a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_backup_start_timeline gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_backup_start_timeline The starting timeline of a backup for a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_backup_start_timeline gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
       if (number_of_backups[i] > 0)
       {
          for (int j = 0; j < number_of_backups[i]; j++)
          {
-            data = pgmoneta_append(data, "pgmoneta_backup_start_timeline{");
+            pgmoneta_string_builder_append(data, "pgmoneta_backup_start_timeline{");
 
-            data = pgmoneta_append(data, "name=\"");
-            data = pgmoneta_append(data, config->common.servers[i].name);
-            data = pgmoneta_append(data, "\", label=\"");
-            data = pgmoneta_append(data, backups[i][j] != NULL ? backups[i][j]->label : "0");
-            data = pgmoneta_append(data, "\"} ");
+            pgmoneta_string_builder_append(data, "name=\"");
+            pgmoneta_string_builder_append(data, config->common.servers[i].name);
+            pgmoneta_string_builder_append(data, "\", label=\"");
+            pgmoneta_string_builder_append(data, backups[i][j] != NULL ? backups[i][j]->label : "0");
+            pgmoneta_string_builder_append(data, "\"} ");
 
-            data = pgmoneta_append_int(data, backups[i][j] != NULL ? backups[i][j]->start_timeline : 0);
+            pgmoneta_string_builder_append_int(data, backups[i][j] != NULL ? backups[i][j]->start_timeline : 0);
 
-            data = pgmoneta_append(data, "\n");
+            pgmoneta_string_builder_append(data, "\n");
          }
       }
       else
       {
-         data = pgmoneta_append(data, "pgmoneta_backup_start_timeline{");
+         pgmoneta_string_builder_append(data, "pgmoneta_backup_start_timeline{");
 
-         data = pgmoneta_append(data, "name=\"");
-         data = pgmoneta_append(data, config->common.servers[i].name);
-         data = pgmoneta_append(data, "\", label=\"0\"} 0");
+         pgmoneta_string_builder_append(data, "name=\"");
+         pgmoneta_string_builder_append(data, config->common.servers[i].name);
+         pgmoneta_string_builder_append(data, "\", label=\"0\"} 0");
 
-         data = pgmoneta_append(data, "\n");
+         pgmoneta_string_builder_append(data, "\n");
       }
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_backup_end_timeline The ending timeline of a backup for a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_backup_end_timeline gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_backup_end_timeline The ending timeline of a backup for a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_backup_end_timeline gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
       if (number_of_backups[i] > 0)
       {
          for (int j = 0; j < number_of_backups[i]; j++)
          {
-            data = pgmoneta_append(data, "pgmoneta_backup_end_timeline{");
+            pgmoneta_string_builder_append(data, "pgmoneta_backup_end_timeline{");
 
-            data = pgmoneta_append(data, "name=\"");
-            data = pgmoneta_append(data, config->common.servers[i].name);
-            data = pgmoneta_append(data, "\", label=\"");
-            data = pgmoneta_append(data, backups[i][j] != NULL ? backups[i][j]->label : "0");
-            data = pgmoneta_append(data, "\"} ");
+            pgmoneta_string_builder_append(data, "name=\"");
+            pgmoneta_string_builder_append(data, config->common.servers[i].name);
+            pgmoneta_string_builder_append(data, "\", label=\"");
+            pgmoneta_string_builder_append(data, backups[i][j] != NULL ? backups[i][j]->label : "0");
+            pgmoneta_string_builder_append(data, "\"} ");
 
-            data = pgmoneta_append_int(data, backups[i][j] != NULL ? backups[i][j]->end_timeline : 0);
+            pgmoneta_string_builder_append_int(data, backups[i][j] != NULL ? backups[i][j]->end_timeline : 0);
 
-            data = pgmoneta_append(data, "\n");
+            pgmoneta_string_builder_append(data, "\n");
          }
       }
       else
       {
-         data = pgmoneta_append(data, "pgmoneta_backup_end_timeline{");
+         pgmoneta_string_builder_append(data, "pgmoneta_backup_end_timeline{");
 
-         data = pgmoneta_append(data, "name=\"");
-         data = pgmoneta_append(data, config->common.servers[i].name);
-         data = pgmoneta_append(data, "\", label=\"0\"} 0");
+         pgmoneta_string_builder_append(data, "name=\"");
+         pgmoneta_string_builder_append(data, config->common.servers[i].name);
+         pgmoneta_string_builder_append(data, "\", label=\"0\"} 0");
 
-         data = pgmoneta_append(data, "\n");
+         pgmoneta_string_builder_append(data, "\n");
       }
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_backup_start_walpos The starting WAL position of a backup for a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_backup_start_walpos gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_backup_start_walpos The starting WAL position of a backup for a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_backup_start_walpos gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
       if (number_of_backups[i] > 0)
@@ -3522,42 +3827,42 @@ backup_information(prometheus_metrics_container_t* container, int* number_of_bac
          {
             char walpos[MISC_LENGTH];
             memset(walpos, 0, MISC_LENGTH);
-            data = pgmoneta_append(data, "pgmoneta_backup_start_walpos{");
+            pgmoneta_string_builder_append(data, "pgmoneta_backup_start_walpos{");
 
-            data = pgmoneta_append(data, "name=\"");
-            data = pgmoneta_append(data, config->common.servers[i].name);
-            data = pgmoneta_append(data, "\", label=\"");
-            data = pgmoneta_append(data, backups[i][j] != NULL ? backups[i][j]->label : "0");
-            data = pgmoneta_append(data, "\", ");
+            pgmoneta_string_builder_append(data, "name=\"");
+            pgmoneta_string_builder_append(data, config->common.servers[i].name);
+            pgmoneta_string_builder_append(data, "\", label=\"");
+            pgmoneta_string_builder_append(data, backups[i][j] != NULL ? backups[i][j]->label : "0");
+            pgmoneta_string_builder_append(data, "\", ");
 
             pgmoneta_snprintf(walpos, MISC_LENGTH, "%X/%X",
                               backups[i][j] != NULL ? backups[i][j]->start_lsn_hi32 : 0,
                               backups[i][j] != NULL ? backups[i][j]->start_lsn_lo32 : 0);
-            data = pgmoneta_append(data, "walpos=\"");
-            data = pgmoneta_append(data, walpos);
-            data = pgmoneta_append(data, "\"} ");
+            pgmoneta_string_builder_append(data, "walpos=\"");
+            pgmoneta_string_builder_append(data, walpos);
+            pgmoneta_string_builder_append(data, "\"} ");
 
-            data = pgmoneta_append_int(data, 1);
+            pgmoneta_string_builder_append_int(data, 1);
 
-            data = pgmoneta_append(data, "\n");
+            pgmoneta_string_builder_append(data, "\n");
          }
       }
       else
       {
-         data = pgmoneta_append(data, "pgmoneta_backup_start_walpos{");
+         pgmoneta_string_builder_append(data, "pgmoneta_backup_start_walpos{");
 
-         data = pgmoneta_append(data, "name=\"");
-         data = pgmoneta_append(data, config->common.servers[i].name);
-         data = pgmoneta_append(data, "\", label=\"0\", ");
-         data = pgmoneta_append(data, "walpos=\"0/0\"} 0");
+         pgmoneta_string_builder_append(data, "name=\"");
+         pgmoneta_string_builder_append(data, config->common.servers[i].name);
+         pgmoneta_string_builder_append(data, "\", label=\"0\", ");
+         pgmoneta_string_builder_append(data, "walpos=\"0/0\"} 0");
 
-         data = pgmoneta_append(data, "\n");
+         pgmoneta_string_builder_append(data, "\n");
       }
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_backup_checkpoint_walpos The checkpoint WAL position of a backup for a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_backup_checkpoint_walpos gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_backup_checkpoint_walpos The checkpoint WAL position of a backup for a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_backup_checkpoint_walpos gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
       if (number_of_backups[i] > 0)
@@ -3566,40 +3871,40 @@ backup_information(prometheus_metrics_container_t* container, int* number_of_bac
          {
             char walpos[MISC_LENGTH];
             memset(walpos, 0, MISC_LENGTH);
-            data = pgmoneta_append(data, "pgmoneta_backup_checkpoint_walpos{");
+            pgmoneta_string_builder_append(data, "pgmoneta_backup_checkpoint_walpos{");
 
-            data = pgmoneta_append(data, "name=\"");
-            data = pgmoneta_append(data, config->common.servers[i].name);
-            data = pgmoneta_append(data, "\", label=\"");
-            data = pgmoneta_append(data, backups[i][j]->label);
-            data = pgmoneta_append(data, "\", ");
+            pgmoneta_string_builder_append(data, "name=\"");
+            pgmoneta_string_builder_append(data, config->common.servers[i].name);
+            pgmoneta_string_builder_append(data, "\", label=\"");
+            pgmoneta_string_builder_append(data, backups[i][j]->label);
+            pgmoneta_string_builder_append(data, "\", ");
 
             pgmoneta_snprintf(walpos, MISC_LENGTH, "%X/%X", backups[i][j]->checkpoint_lsn_hi32, backups[i][j]->checkpoint_lsn_lo32);
-            data = pgmoneta_append(data, "walpos=\"");
-            data = pgmoneta_append(data, walpos);
-            data = pgmoneta_append(data, "\"} ");
+            pgmoneta_string_builder_append(data, "walpos=\"");
+            pgmoneta_string_builder_append(data, walpos);
+            pgmoneta_string_builder_append(data, "\"} ");
 
-            data = pgmoneta_append_int(data, 1);
+            pgmoneta_string_builder_append_int(data, 1);
 
-            data = pgmoneta_append(data, "\n");
+            pgmoneta_string_builder_append(data, "\n");
          }
       }
       else
       {
-         data = pgmoneta_append(data, "pgmoneta_backup_checkpoint_walpos{");
+         pgmoneta_string_builder_append(data, "pgmoneta_backup_checkpoint_walpos{");
 
-         data = pgmoneta_append(data, "name=\"");
-         data = pgmoneta_append(data, config->common.servers[i].name);
-         data = pgmoneta_append(data, "\", label=\"0\", ");
-         data = pgmoneta_append(data, "walpos=\"0/0\"} 0");
+         pgmoneta_string_builder_append(data, "name=\"");
+         pgmoneta_string_builder_append(data, config->common.servers[i].name);
+         pgmoneta_string_builder_append(data, "\", label=\"0\", ");
+         pgmoneta_string_builder_append(data, "walpos=\"0/0\"} 0");
 
-         data = pgmoneta_append(data, "\n");
+         pgmoneta_string_builder_append(data, "\n");
       }
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_backup_end_walpos The ending WAL position of a backup for a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_backup_end_walpos gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_backup_end_walpos The ending WAL position of a backup for a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_backup_end_walpos gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
       if (number_of_backups[i] > 0)
@@ -3608,46 +3913,47 @@ backup_information(prometheus_metrics_container_t* container, int* number_of_bac
          {
             char walpos[MISC_LENGTH];
             memset(walpos, 0, MISC_LENGTH);
-            data = pgmoneta_append(data, "pgmoneta_backup_end_walpos{");
+            pgmoneta_string_builder_append(data, "pgmoneta_backup_end_walpos{");
 
-            data = pgmoneta_append(data, "name=\"");
-            data = pgmoneta_append(data, config->common.servers[i].name);
-            data = pgmoneta_append(data, "\", label=\"");
-            data = pgmoneta_append(data, backups[i][j] != NULL ? backups[i][j]->label : "0");
-            data = pgmoneta_append(data, "\", ");
+            pgmoneta_string_builder_append(data, "name=\"");
+            pgmoneta_string_builder_append(data, config->common.servers[i].name);
+            pgmoneta_string_builder_append(data, "\", label=\"");
+            pgmoneta_string_builder_append(data, backups[i][j] != NULL ? backups[i][j]->label : "0");
+            pgmoneta_string_builder_append(data, "\", ");
 
             pgmoneta_snprintf(walpos, MISC_LENGTH, "%X/%X",
                               backups[i][j] != NULL ? backups[i][j]->end_lsn_hi32 : 0,
                               backups[i][j] != NULL ? backups[i][j]->end_lsn_lo32 : 0);
-            data = pgmoneta_append(data, "walpos=\"");
-            data = pgmoneta_append(data, walpos);
-            data = pgmoneta_append(data, "\"} ");
+            pgmoneta_string_builder_append(data, "walpos=\"");
+            pgmoneta_string_builder_append(data, walpos);
+            pgmoneta_string_builder_append(data, "\"} ");
 
-            data = pgmoneta_append_int(data, 1);
+            pgmoneta_string_builder_append_int(data, 1);
 
-            data = pgmoneta_append(data, "\n");
+            pgmoneta_string_builder_append(data, "\n");
          }
       }
       else
       {
-         data = pgmoneta_append(data, "pgmoneta_backup_end_walpos{");
+         pgmoneta_string_builder_append(data, "pgmoneta_backup_end_walpos{");
 
-         data = pgmoneta_append(data, "name=\"");
-         data = pgmoneta_append(data, config->common.servers[i].name);
-         data = pgmoneta_append(data, "\", label=\"0\", ");
-         data = pgmoneta_append(data, "walpos=\"0/0\"} 0");
+         pgmoneta_string_builder_append(data, "name=\"");
+         pgmoneta_string_builder_append(data, config->common.servers[i].name);
+         pgmoneta_string_builder_append(data, "\", label=\"0\", ");
+         pgmoneta_string_builder_append(data, "walpos=\"0/0\"} 0");
 
-         data = pgmoneta_append(data, "\n");
+         pgmoneta_string_builder_append(data, "\n");
       }
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   if (data != NULL)
+   if (data->length > 0)
    {
-      add_metric_to_art(container->backup_metrics, "pgmoneta_backup_end_walpos", data, NULL, NULL, 0);
-      free(data);
-      data = NULL;
+      add_metric_to_art(container->backup_metrics, "pgmoneta_backup_end_walpos", data->str, NULL, NULL, 0);
+      pgmoneta_string_builder_reset(data);
    }
+
+   pgmoneta_string_builder_destroy(data);
 }
 
 static void
@@ -3655,86 +3961,88 @@ size_information(prometheus_metrics_container_t* container, int* number_of_backu
 {
    unsigned long size;
    bool valid;
-   char* d = NULL;
-   char* data = NULL;
+   struct string_builder* data = NULL;
    struct main_configuration* config;
 
    config = (struct main_configuration*)shmem;
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_restore_newest_size The size of the newest restore for a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_restore_newest_size gauge\n");
+   if (pgmoneta_string_builder_create(0, &data))
+   {
+      return;
+   }
+
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_restore_newest_size The size of the newest restore for a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_restore_newest_size gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
-      data = pgmoneta_append(data, "pgmoneta_restore_newest_size{");
+      pgmoneta_string_builder_append(data, "pgmoneta_restore_newest_size{");
 
-      data = pgmoneta_append(data, "name=\"");
-      data = pgmoneta_append(data, config->common.servers[i].name);
-      data = pgmoneta_append(data, "\"} ");
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\"} ");
 
       valid = false;
       for (int j = number_of_backups[i] - 1; !valid && j >= 0; j--)
       {
          if (pgmoneta_is_backup_struct_valid(i, backups[i][j]))
          {
-            data = pgmoneta_append_ulong(data, backups[i][j]->restore_size);
+            pgmoneta_string_builder_append_ulong(data, backups[i][j]->restore_size);
             valid = true;
          }
       }
 
       if (!valid)
       {
-         data = pgmoneta_append(data, "0");
+         pgmoneta_string_builder_append(data, "0");
       }
 
-      data = pgmoneta_append(data, "\n");
+      pgmoneta_string_builder_append(data, "\n");
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   if (data != NULL)
+   if (data->length > 0)
    {
-      add_metric_to_art(container->backup_metrics, "pgmoneta_restore_newest_size", data, NULL, NULL, 0);
-      free(data);
-      data = NULL;
+      add_metric_to_art(container->backup_metrics, "pgmoneta_restore_newest_size", data->str, NULL, NULL, 0);
+      pgmoneta_string_builder_reset(data);
    }
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_backup_newest_size The size of the newest backup for a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_backup_newest_size gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_backup_newest_size The size of the newest backup for a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_backup_newest_size gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
-      data = pgmoneta_append(data, "pgmoneta_backup_newest_size{");
+      pgmoneta_string_builder_append(data, "pgmoneta_backup_newest_size{");
 
-      data = pgmoneta_append(data, "name=\"");
-      data = pgmoneta_append(data, config->common.servers[i].name);
-      data = pgmoneta_append(data, "\"} ");
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\"} ");
 
       valid = false;
       for (int j = number_of_backups[i] - 1; !valid && j >= 0; j--)
       {
          if (pgmoneta_is_backup_struct_valid(i, backups[i][j]))
          {
-            data = pgmoneta_append_ulong(data, backups[i][j]->backup_size);
+            pgmoneta_string_builder_append_ulong(data, backups[i][j]->backup_size);
             valid = true;
          }
       }
 
       if (!valid)
       {
-         data = pgmoneta_append(data, "0");
+         pgmoneta_string_builder_append(data, "0");
       }
 
-      data = pgmoneta_append(data, "\n");
+      pgmoneta_string_builder_append(data, "\n");
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   if (data != NULL)
+   if (data->length > 0)
    {
-      add_metric_to_art(container->backup_metrics, "pgmoneta_backup_newest_size", data, NULL, NULL, 0);
-      free(data);
-      data = NULL;
+      add_metric_to_art(container->backup_metrics, "pgmoneta_backup_newest_size", data->str, NULL, NULL, 0);
+      pgmoneta_string_builder_reset(data);
    }
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_restore_size The size of a restore for a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_restore_size gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_restore_size The size of a restore for a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_restore_size gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
       if (number_of_backups[i] > 0)
@@ -3743,42 +4051,41 @@ size_information(prometheus_metrics_container_t* container, int* number_of_backu
          {
             if (pgmoneta_is_backup_struct_valid(i, backups[i][j]))
             {
-               data = pgmoneta_append(data, "pgmoneta_restore_size{");
+               pgmoneta_string_builder_append(data, "pgmoneta_restore_size{");
 
-               data = pgmoneta_append(data, "name=\"");
-               data = pgmoneta_append(data, config->common.servers[i].name);
-               data = pgmoneta_append(data, "\", label=\"");
-               data = pgmoneta_append(data, backups[i][j] != NULL ? backups[i][j]->label : "0");
-               data = pgmoneta_append(data, "\"} ");
+               pgmoneta_string_builder_append(data, "name=\"");
+               pgmoneta_string_builder_append(data, config->common.servers[i].name);
+               pgmoneta_string_builder_append(data, "\", label=\"");
+               pgmoneta_string_builder_append(data, backups[i][j] != NULL ? backups[i][j]->label : "0");
+               pgmoneta_string_builder_append(data, "\"} ");
 
-               data = pgmoneta_append_ulong(data, backups[i][j] != NULL ? backups[i][j]->restore_size : 0);
+               pgmoneta_string_builder_append_ulong(data, backups[i][j] != NULL ? backups[i][j]->restore_size : 0);
 
-               data = pgmoneta_append(data, "\n");
+               pgmoneta_string_builder_append(data, "\n");
             }
          }
       }
       else
       {
-         data = pgmoneta_append(data, "pgmoneta_restore_size{");
+         pgmoneta_string_builder_append(data, "pgmoneta_restore_size{");
 
-         data = pgmoneta_append(data, "name=\"");
-         data = pgmoneta_append(data, config->common.servers[i].name);
-         data = pgmoneta_append(data, "\", label=\"0\"} 0");
+         pgmoneta_string_builder_append(data, "name=\"");
+         pgmoneta_string_builder_append(data, config->common.servers[i].name);
+         pgmoneta_string_builder_append(data, "\", label=\"0\"} 0");
 
-         data = pgmoneta_append(data, "\n");
+         pgmoneta_string_builder_append(data, "\n");
       }
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   if (data != NULL)
+   if (data->length > 0)
    {
-      add_metric_to_art(container->backup_metrics, "pgmoneta_restore_size", data, NULL, NULL, 0);
-      free(data);
-      data = NULL;
+      add_metric_to_art(container->backup_metrics, "pgmoneta_restore_size", data->str, NULL, NULL, 0);
+      pgmoneta_string_builder_reset(data);
    }
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_restore_size_increment The size increment of a restore for a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_restore_size_increment gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_restore_size_increment The size increment of a restore for a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_restore_size_increment gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
       if (number_of_backups[i] > 0)
@@ -3787,90 +4094,88 @@ size_information(prometheus_metrics_container_t* container, int* number_of_backu
          {
             if (backups[i][j] != NULL)
             {
-               data = pgmoneta_append(data, "pgmoneta_restore_size_increment{");
+               pgmoneta_string_builder_append(data, "pgmoneta_restore_size_increment{");
 
-               data = pgmoneta_append(data, "name=\"");
-               data = pgmoneta_append(data, config->common.servers[i].name);
-               data = pgmoneta_append(data, "\", label=\"");
-               data = pgmoneta_append(data, backups[i][j]->label);
-               data = pgmoneta_append(data, "\"} ");
+               pgmoneta_string_builder_append(data, "name=\"");
+               pgmoneta_string_builder_append(data, config->common.servers[i].name);
+               pgmoneta_string_builder_append(data, "\", label=\"");
+               pgmoneta_string_builder_append(data, backups[i][j]->label);
+               pgmoneta_string_builder_append(data, "\"} ");
 
                if (j == 0)
                {
-                  data = pgmoneta_append_int(data, backups[i][0]->restore_size);
+                  pgmoneta_string_builder_append_int(data, backups[i][0]->restore_size);
                }
                else
                {
-                  data = pgmoneta_append_int(data, backups[i][j]->restore_size - backups[i][j - 1]->restore_size);
+                  pgmoneta_string_builder_append_int(data, backups[i][j]->restore_size - backups[i][j - 1]->restore_size);
                }
 
-               data = pgmoneta_append(data, "\n");
+               pgmoneta_string_builder_append(data, "\n");
             }
          }
       }
       else
       {
-         data = pgmoneta_append(data, "pgmoneta_restore_size_increment{");
+         pgmoneta_string_builder_append(data, "pgmoneta_restore_size_increment{");
 
-         data = pgmoneta_append(data, "name=\"");
-         data = pgmoneta_append(data, config->common.servers[i].name);
-         data = pgmoneta_append(data, "\", label=\"0\"} 0");
+         pgmoneta_string_builder_append(data, "name=\"");
+         pgmoneta_string_builder_append(data, config->common.servers[i].name);
+         pgmoneta_string_builder_append(data, "\", label=\"0\"} 0");
 
-         data = pgmoneta_append(data, "\n");
+         pgmoneta_string_builder_append(data, "\n");
       }
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   if (data != NULL)
+   if (data->length > 0)
    {
-      add_metric_to_art(container->backup_metrics, "pgmoneta_restore_size_increment", data, NULL, NULL, 0);
-      free(data);
-      data = NULL;
+      add_metric_to_art(container->backup_metrics, "pgmoneta_restore_size_increment", data->str, NULL, NULL, 0);
+      pgmoneta_string_builder_reset(data);
    }
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_backup_size The size of a backup for a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_backup_size gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_backup_size The size of a backup for a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_backup_size gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
       if (number_of_backups[i] > 0)
       {
          for (int j = 0; j < number_of_backups[i]; j++)
          {
-            data = pgmoneta_append(data, "pgmoneta_backup_size{");
+            pgmoneta_string_builder_append(data, "pgmoneta_backup_size{");
 
-            data = pgmoneta_append(data, "name=\"");
-            data = pgmoneta_append(data, config->common.servers[i].name);
-            data = pgmoneta_append(data, "\", label=\"");
-            data = pgmoneta_append(data, backups[i][j] != NULL ? backups[i][j]->label : "0");
-            data = pgmoneta_append(data, "\"} ");
+            pgmoneta_string_builder_append(data, "name=\"");
+            pgmoneta_string_builder_append(data, config->common.servers[i].name);
+            pgmoneta_string_builder_append(data, "\", label=\"");
+            pgmoneta_string_builder_append(data, backups[i][j] != NULL ? backups[i][j]->label : "0");
+            pgmoneta_string_builder_append(data, "\"} ");
 
-            data = pgmoneta_append_ulong(data, backups[i][j] != NULL ? backups[i][j]->backup_size : 0);
+            pgmoneta_string_builder_append_ulong(data, backups[i][j] != NULL ? backups[i][j]->backup_size : 0);
 
-            data = pgmoneta_append(data, "\n");
+            pgmoneta_string_builder_append(data, "\n");
          }
       }
       else
       {
-         data = pgmoneta_append(data, "pgmoneta_backup_size{");
+         pgmoneta_string_builder_append(data, "pgmoneta_backup_size{");
 
-         data = pgmoneta_append(data, "name=\"");
-         data = pgmoneta_append(data, config->common.servers[i].name);
-         data = pgmoneta_append(data, "\", label=\"0\"} 0");
+         pgmoneta_string_builder_append(data, "name=\"");
+         pgmoneta_string_builder_append(data, config->common.servers[i].name);
+         pgmoneta_string_builder_append(data, "\", label=\"0\"} 0");
 
-         data = pgmoneta_append(data, "\n");
+         pgmoneta_string_builder_append(data, "\n");
       }
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   if (data != NULL)
+   if (data->length > 0)
    {
-      add_metric_to_art(container->backup_metrics, "pgmoneta_backup_size", data, NULL, NULL, 0);
-      free(data);
-      data = NULL;
+      add_metric_to_art(container->backup_metrics, "pgmoneta_backup_size", data->str, NULL, NULL, 0);
+      pgmoneta_string_builder_reset(data);
    }
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_backup_compression_ratio The ratio of backup size to restore size for each backup\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_backup_compression_ratio gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_backup_compression_ratio The ratio of backup size to restore size for each backup\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_backup_compression_ratio gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
       if (number_of_backups[i] > 0)
@@ -3879,49 +4184,48 @@ size_information(prometheus_metrics_container_t* container, int* number_of_backu
          {
             if (backups[i][j] != NULL)
             {
-               data = pgmoneta_append(data, "pgmoneta_backup_compression_ratio{");
+               pgmoneta_string_builder_append(data, "pgmoneta_backup_compression_ratio{");
 
-               data = pgmoneta_append(data, "name=\"");
-               data = pgmoneta_append(data, config->common.servers[i].name);
-               data = pgmoneta_append(data, "\", label=\"");
-               data = pgmoneta_append(data, backups[i][j]->label);
-               data = pgmoneta_append(data, "\"} ");
+               pgmoneta_string_builder_append(data, "name=\"");
+               pgmoneta_string_builder_append(data, config->common.servers[i].name);
+               pgmoneta_string_builder_append(data, "\", label=\"");
+               pgmoneta_string_builder_append(data, backups[i][j]->label);
+               pgmoneta_string_builder_append(data, "\"} ");
 
                if (backups[i][j]->restore_size)
                {
-                  data = pgmoneta_append_double(data, 1.0 * backups[i][j]->backup_size / backups[i][j]->restore_size);
+                  pgmoneta_string_builder_append_double(data, 1.0 * backups[i][j]->backup_size / backups[i][j]->restore_size);
                }
                else
                {
-                  data = pgmoneta_append_int(data, 0);
+                  pgmoneta_string_builder_append_int(data, 0);
                }
 
-               data = pgmoneta_append(data, "\n");
+               pgmoneta_string_builder_append(data, "\n");
             }
          }
       }
       else
       {
-         data = pgmoneta_append(data, "pgmoneta_backup_compression_ratio{");
+         pgmoneta_string_builder_append(data, "pgmoneta_backup_compression_ratio{");
 
-         data = pgmoneta_append(data, "name=\"");
-         data = pgmoneta_append(data, config->common.servers[i].name);
-         data = pgmoneta_append(data, "\", label=\"0\"} 0");
+         pgmoneta_string_builder_append(data, "name=\"");
+         pgmoneta_string_builder_append(data, config->common.servers[i].name);
+         pgmoneta_string_builder_append(data, "\", label=\"0\"} 0");
 
-         data = pgmoneta_append(data, "\n");
+         pgmoneta_string_builder_append(data, "\n");
       }
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   if (data != NULL)
+   if (data->length > 0)
    {
-      add_metric_to_art(container->backup_metrics, "pgmoneta_backup_compression_ratio", data, NULL, NULL, 0);
-      free(data);
-      data = NULL;
+      add_metric_to_art(container->backup_metrics, "pgmoneta_backup_compression_ratio", data->str, NULL, NULL, 0);
+      pgmoneta_string_builder_reset(data);
    }
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_backup_throughput The throughput of the backup for a server (MB/s)\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_backup_throughput gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_backup_throughput The throughput of the backup for a server (MB/s)\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_backup_throughput gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
       if (number_of_backups[i] > 0)
@@ -3930,48 +4234,47 @@ size_information(prometheus_metrics_container_t* container, int* number_of_backu
          {
             if (backups[i][j] != NULL)
             {
-               data = pgmoneta_append(data, "pgmoneta_backup_throughput{");
+               pgmoneta_string_builder_append(data, "pgmoneta_backup_throughput{");
 
-               data = pgmoneta_append(data, "name=\"");
-               data = pgmoneta_append(data, config->common.servers[i].name);
-               data = pgmoneta_append(data, "\", label=\"");
-               data = pgmoneta_append(data, backups[i][j]->label);
-               data = pgmoneta_append(data, "\"} ");
+               pgmoneta_string_builder_append(data, "name=\"");
+               pgmoneta_string_builder_append(data, config->common.servers[i].name);
+               pgmoneta_string_builder_append(data, "\", label=\"");
+               pgmoneta_string_builder_append(data, backups[i][j]->label);
+               pgmoneta_string_builder_append(data, "\"} ");
 
                if (backups[i][j]->total_elapsed_time)
                {
-                  data = pgmoneta_append_double_precision(data, (1.0 * backups[i][j]->backup_size / backups[i][j]->total_elapsed_time) / (1e6), 4);
+                  pgmoneta_string_builder_append_double_precision(data, (1.0 * backups[i][j]->backup_size / backups[i][j]->total_elapsed_time) / (1e6), 4);
                }
                else
                {
-                  data = pgmoneta_append_int(data, 0);
+                  pgmoneta_string_builder_append_int(data, 0);
                }
-               data = pgmoneta_append(data, "\n");
+               pgmoneta_string_builder_append(data, "\n");
             }
          }
       }
       else
       {
-         data = pgmoneta_append(data, "pgmoneta_backup_throughput{");
+         pgmoneta_string_builder_append(data, "pgmoneta_backup_throughput{");
 
-         data = pgmoneta_append(data, "name=\"");
-         data = pgmoneta_append(data, config->common.servers[i].name);
-         data = pgmoneta_append(data, "\", label=\"0\"} 0");
+         pgmoneta_string_builder_append(data, "name=\"");
+         pgmoneta_string_builder_append(data, config->common.servers[i].name);
+         pgmoneta_string_builder_append(data, "\", label=\"0\"} 0");
 
-         data = pgmoneta_append(data, "\n");
+         pgmoneta_string_builder_append(data, "\n");
       }
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   if (data != NULL)
+   if (data->length > 0)
    {
-      add_metric_to_art(container->backup_metrics, "pgmoneta_backup_throughput", data, NULL, NULL, 0);
-      free(data);
-      data = NULL;
+      add_metric_to_art(container->backup_metrics, "pgmoneta_backup_throughput", data->str, NULL, NULL, 0);
+      pgmoneta_string_builder_reset(data);
    }
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_backup_basebackup_mbs The throughput of the basebackup for a server (MB/s)\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_backup_basebackup_mbs gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_backup_basebackup_mbs The throughput of the basebackup for a server (MB/s)\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_backup_basebackup_mbs gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
       if (number_of_backups[i] > 0)
@@ -3980,48 +4283,47 @@ size_information(prometheus_metrics_container_t* container, int* number_of_backu
          {
             if (backups[i][j] != NULL)
             {
-               data = pgmoneta_append(data, "pgmoneta_backup_basebackup_mbs{");
+               pgmoneta_string_builder_append(data, "pgmoneta_backup_basebackup_mbs{");
 
-               data = pgmoneta_append(data, "name=\"");
-               data = pgmoneta_append(data, config->common.servers[i].name);
-               data = pgmoneta_append(data, "\", label=\"");
-               data = pgmoneta_append(data, backups[i][j]->label);
-               data = pgmoneta_append(data, "\"} ");
+               pgmoneta_string_builder_append(data, "name=\"");
+               pgmoneta_string_builder_append(data, config->common.servers[i].name);
+               pgmoneta_string_builder_append(data, "\", label=\"");
+               pgmoneta_string_builder_append(data, backups[i][j]->label);
+               pgmoneta_string_builder_append(data, "\"} ");
 
                if (backups[i][j]->basebackup_elapsed_time)
                {
-                  data = pgmoneta_append_double_precision(data, (1.0 * backups[i][j]->backup_size / backups[i][j]->basebackup_elapsed_time) / (1e6), 4);
+                  pgmoneta_string_builder_append_double_precision(data, (1.0 * backups[i][j]->backup_size / backups[i][j]->basebackup_elapsed_time) / (1e6), 4);
                }
                else
                {
-                  data = pgmoneta_append_int(data, 0);
+                  pgmoneta_string_builder_append_int(data, 0);
                }
-               data = pgmoneta_append(data, "\n");
+               pgmoneta_string_builder_append(data, "\n");
             }
          }
       }
       else
       {
-         data = pgmoneta_append(data, "pgmoneta_backup_basebackup_mbs{");
+         pgmoneta_string_builder_append(data, "pgmoneta_backup_basebackup_mbs{");
 
-         data = pgmoneta_append(data, "name=\"");
-         data = pgmoneta_append(data, config->common.servers[i].name);
-         data = pgmoneta_append(data, "\", label=\"0\"} 0");
+         pgmoneta_string_builder_append(data, "name=\"");
+         pgmoneta_string_builder_append(data, config->common.servers[i].name);
+         pgmoneta_string_builder_append(data, "\", label=\"0\"} 0");
 
-         data = pgmoneta_append(data, "\n");
+         pgmoneta_string_builder_append(data, "\n");
       }
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   if (data != NULL)
+   if (data->length > 0)
    {
-      add_metric_to_art(container->backup_metrics, "pgmoneta_backup_basebackup_mbs", data, NULL, NULL, 0);
-      free(data);
-      data = NULL;
+      add_metric_to_art(container->backup_metrics, "pgmoneta_backup_basebackup_mbs", data->str, NULL, NULL, 0);
+      pgmoneta_string_builder_reset(data);
    }
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_backup_manifest_mbs The throughput of the manifest for a server (MB/s)\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_backup_manifest_mbs gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_backup_manifest_mbs The throughput of the manifest for a server (MB/s)\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_backup_manifest_mbs gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
       if (number_of_backups[i] > 0)
@@ -4030,48 +4332,47 @@ size_information(prometheus_metrics_container_t* container, int* number_of_backu
          {
             if (backups[i][j] != NULL)
             {
-               data = pgmoneta_append(data, "pgmoneta_backup_manifest_mbs{");
+               pgmoneta_string_builder_append(data, "pgmoneta_backup_manifest_mbs{");
 
-               data = pgmoneta_append(data, "name=\"");
-               data = pgmoneta_append(data, config->common.servers[i].name);
-               data = pgmoneta_append(data, "\", label=\"");
-               data = pgmoneta_append(data, backups[i][j]->label);
-               data = pgmoneta_append(data, "\"} ");
+               pgmoneta_string_builder_append(data, "name=\"");
+               pgmoneta_string_builder_append(data, config->common.servers[i].name);
+               pgmoneta_string_builder_append(data, "\", label=\"");
+               pgmoneta_string_builder_append(data, backups[i][j]->label);
+               pgmoneta_string_builder_append(data, "\"} ");
 
                if (backups[i][j]->manifest_elapsed_time)
                {
-                  data = pgmoneta_append_double_precision(data, (1.0 * backups[i][j]->backup_size / backups[i][j]->manifest_elapsed_time) / (1e6), 4);
+                  pgmoneta_string_builder_append_double_precision(data, (1.0 * backups[i][j]->backup_size / backups[i][j]->manifest_elapsed_time) / (1e6), 4);
                }
                else
                {
-                  data = pgmoneta_append_int(data, 0);
+                  pgmoneta_string_builder_append_int(data, 0);
                }
-               data = pgmoneta_append(data, "\n");
+               pgmoneta_string_builder_append(data, "\n");
             }
          }
       }
       else
       {
-         data = pgmoneta_append(data, "pgmoneta_backup_manifest_mbs{");
+         pgmoneta_string_builder_append(data, "pgmoneta_backup_manifest_mbs{");
 
-         data = pgmoneta_append(data, "name=\"");
-         data = pgmoneta_append(data, config->common.servers[i].name);
-         data = pgmoneta_append(data, "\", label=\"0\"} 0");
+         pgmoneta_string_builder_append(data, "name=\"");
+         pgmoneta_string_builder_append(data, config->common.servers[i].name);
+         pgmoneta_string_builder_append(data, "\", label=\"0\"} 0");
 
-         data = pgmoneta_append(data, "\n");
+         pgmoneta_string_builder_append(data, "\n");
       }
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   if (data != NULL)
+   if (data->length > 0)
    {
-      add_metric_to_art(container->backup_metrics, "pgmoneta_backup_manifest_mbs", data, NULL, NULL, 0);
-      free(data);
-      data = NULL;
+      add_metric_to_art(container->backup_metrics, "pgmoneta_backup_manifest_mbs", data->str, NULL, NULL, 0);
+      pgmoneta_string_builder_reset(data);
    }
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_backup_compression_zstd_mbs The throughput of the zstd compression for a server (MB/s)\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_backup_compression_zstd_mbs gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_backup_compression_zstd_mbs The throughput of the zstd compression for a server (MB/s)\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_backup_compression_zstd_mbs gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
       if (number_of_backups[i] > 0)
@@ -4080,48 +4381,47 @@ size_information(prometheus_metrics_container_t* container, int* number_of_backu
          {
             if (backups[i][j] != NULL)
             {
-               data = pgmoneta_append(data, "pgmoneta_backup_compression_zstd_mbs{");
+               pgmoneta_string_builder_append(data, "pgmoneta_backup_compression_zstd_mbs{");
 
-               data = pgmoneta_append(data, "name=\"");
-               data = pgmoneta_append(data, config->common.servers[i].name);
-               data = pgmoneta_append(data, "\", label=\"");
-               data = pgmoneta_append(data, backups[i][j]->label);
-               data = pgmoneta_append(data, "\"} ");
+               pgmoneta_string_builder_append(data, "name=\"");
+               pgmoneta_string_builder_append(data, config->common.servers[i].name);
+               pgmoneta_string_builder_append(data, "\", label=\"");
+               pgmoneta_string_builder_append(data, backups[i][j]->label);
+               pgmoneta_string_builder_append(data, "\"} ");
 
                if (backups[i][j]->compression_zstd_elapsed_time)
                {
-                  data = pgmoneta_append_double_precision(data, (1.0 * backups[i][j]->backup_size / backups[i][j]->compression_zstd_elapsed_time) / (1e6), 4);
+                  pgmoneta_string_builder_append_double_precision(data, (1.0 * backups[i][j]->backup_size / backups[i][j]->compression_zstd_elapsed_time) / (1e6), 4);
                }
                else
                {
-                  data = pgmoneta_append_int(data, 0);
+                  pgmoneta_string_builder_append_int(data, 0);
                }
-               data = pgmoneta_append(data, "\n");
+               pgmoneta_string_builder_append(data, "\n");
             }
          }
       }
       else
       {
-         data = pgmoneta_append(data, "pgmoneta_backup_compression_zstd_mbs{");
+         pgmoneta_string_builder_append(data, "pgmoneta_backup_compression_zstd_mbs{");
 
-         data = pgmoneta_append(data, "name=\"");
-         data = pgmoneta_append(data, config->common.servers[i].name);
-         data = pgmoneta_append(data, "\", label=\"0\"} 0");
+         pgmoneta_string_builder_append(data, "name=\"");
+         pgmoneta_string_builder_append(data, config->common.servers[i].name);
+         pgmoneta_string_builder_append(data, "\", label=\"0\"} 0");
 
-         data = pgmoneta_append(data, "\n");
+         pgmoneta_string_builder_append(data, "\n");
       }
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   if (data != NULL)
+   if (data->length > 0)
    {
-      add_metric_to_art(container->backup_metrics, "pgmoneta_backup_compression_zstd_mbs", data, NULL, NULL, 0);
-      free(data);
-      data = NULL;
+      add_metric_to_art(container->backup_metrics, "pgmoneta_backup_compression_zstd_mbs", data->str, NULL, NULL, 0);
+      pgmoneta_string_builder_reset(data);
    }
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_backup_compression_gzip_mbs The throughput of the gzip compression for a server (MB/s)\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_backup_compression_gzip_mbs gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_backup_compression_gzip_mbs The throughput of the gzip compression for a server (MB/s)\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_backup_compression_gzip_mbs gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
       if (number_of_backups[i] > 0)
@@ -4130,48 +4430,47 @@ size_information(prometheus_metrics_container_t* container, int* number_of_backu
          {
             if (backups[i][j] != NULL)
             {
-               data = pgmoneta_append(data, "pgmoneta_backup_compression_gzip_mbs{");
+               pgmoneta_string_builder_append(data, "pgmoneta_backup_compression_gzip_mbs{");
 
-               data = pgmoneta_append(data, "name=\"");
-               data = pgmoneta_append(data, config->common.servers[i].name);
-               data = pgmoneta_append(data, "\", label=\"");
-               data = pgmoneta_append(data, backups[i][j]->label);
-               data = pgmoneta_append(data, "\"} ");
+               pgmoneta_string_builder_append(data, "name=\"");
+               pgmoneta_string_builder_append(data, config->common.servers[i].name);
+               pgmoneta_string_builder_append(data, "\", label=\"");
+               pgmoneta_string_builder_append(data, backups[i][j]->label);
+               pgmoneta_string_builder_append(data, "\"} ");
 
                if (backups[i][j]->compression_gzip_elapsed_time)
                {
-                  data = pgmoneta_append_double_precision(data, (1.0 * backups[i][j]->backup_size / backups[i][j]->compression_gzip_elapsed_time) / (1e6), 4);
+                  pgmoneta_string_builder_append_double_precision(data, (1.0 * backups[i][j]->backup_size / backups[i][j]->compression_gzip_elapsed_time) / (1e6), 4);
                }
                else
                {
-                  data = pgmoneta_append_int(data, 0);
+                  pgmoneta_string_builder_append_int(data, 0);
                }
-               data = pgmoneta_append(data, "\n");
+               pgmoneta_string_builder_append(data, "\n");
             }
          }
       }
       else
       {
-         data = pgmoneta_append(data, "pgmoneta_backup_compression_gzip_mbs{");
+         pgmoneta_string_builder_append(data, "pgmoneta_backup_compression_gzip_mbs{");
 
-         data = pgmoneta_append(data, "name=\"");
-         data = pgmoneta_append(data, config->common.servers[i].name);
-         data = pgmoneta_append(data, "\", label=\"0\"} 0");
+         pgmoneta_string_builder_append(data, "name=\"");
+         pgmoneta_string_builder_append(data, config->common.servers[i].name);
+         pgmoneta_string_builder_append(data, "\", label=\"0\"} 0");
 
-         data = pgmoneta_append(data, "\n");
+         pgmoneta_string_builder_append(data, "\n");
       }
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   if (data != NULL)
+   if (data->length > 0)
    {
-      add_metric_to_art(container->backup_metrics, "pgmoneta_backup_compression_gzip_mbs", data, NULL, NULL, 0);
-      free(data);
-      data = NULL;
+      add_metric_to_art(container->backup_metrics, "pgmoneta_backup_compression_gzip_mbs", data->str, NULL, NULL, 0);
+      pgmoneta_string_builder_reset(data);
    }
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_backup_compression_bzip2_mbs The throughput of the bzip2 compression for a server (MB/s)\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_backup_compression_bzip2_mbs gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_backup_compression_bzip2_mbs The throughput of the bzip2 compression for a server (MB/s)\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_backup_compression_bzip2_mbs gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
       if (number_of_backups[i] > 0)
@@ -4180,48 +4479,47 @@ size_information(prometheus_metrics_container_t* container, int* number_of_backu
          {
             if (backups[i][j] != NULL)
             {
-               data = pgmoneta_append(data, "pgmoneta_backup_compression_bzip2_mbs{");
+               pgmoneta_string_builder_append(data, "pgmoneta_backup_compression_bzip2_mbs{");
 
-               data = pgmoneta_append(data, "name=\"");
-               data = pgmoneta_append(data, config->common.servers[i].name);
-               data = pgmoneta_append(data, "\", label=\"");
-               data = pgmoneta_append(data, backups[i][j]->label);
-               data = pgmoneta_append(data, "\"} ");
+               pgmoneta_string_builder_append(data, "name=\"");
+               pgmoneta_string_builder_append(data, config->common.servers[i].name);
+               pgmoneta_string_builder_append(data, "\", label=\"");
+               pgmoneta_string_builder_append(data, backups[i][j]->label);
+               pgmoneta_string_builder_append(data, "\"} ");
 
                if (backups[i][j]->compression_bzip2_elapsed_time)
                {
-                  data = pgmoneta_append_double_precision(data, (1.0 * backups[i][j]->backup_size / backups[i][j]->compression_bzip2_elapsed_time) / (1e6), 4);
+                  pgmoneta_string_builder_append_double_precision(data, (1.0 * backups[i][j]->backup_size / backups[i][j]->compression_bzip2_elapsed_time) / (1e6), 4);
                }
                else
                {
-                  data = pgmoneta_append_int(data, 0);
+                  pgmoneta_string_builder_append_int(data, 0);
                }
-               data = pgmoneta_append(data, "\n");
+               pgmoneta_string_builder_append(data, "\n");
             }
          }
       }
       else
       {
-         data = pgmoneta_append(data, "pgmoneta_backup_compression_bzip2_mbs{");
+         pgmoneta_string_builder_append(data, "pgmoneta_backup_compression_bzip2_mbs{");
 
-         data = pgmoneta_append(data, "name=\"");
-         data = pgmoneta_append(data, config->common.servers[i].name);
-         data = pgmoneta_append(data, "\", label=\"0\"} 0");
+         pgmoneta_string_builder_append(data, "name=\"");
+         pgmoneta_string_builder_append(data, config->common.servers[i].name);
+         pgmoneta_string_builder_append(data, "\", label=\"0\"} 0");
 
-         data = pgmoneta_append(data, "\n");
+         pgmoneta_string_builder_append(data, "\n");
       }
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   if (data != NULL)
+   if (data->length > 0)
    {
-      add_metric_to_art(container->backup_metrics, "pgmoneta_backup_compression_bzip2_mbs", data, NULL, NULL, 0);
-      free(data);
-      data = NULL;
+      add_metric_to_art(container->backup_metrics, "pgmoneta_backup_compression_bzip2_mbs", data->str, NULL, NULL, 0);
+      pgmoneta_string_builder_reset(data);
    }
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_backup_compression_lz4_mbs The throughput of the lz4 compression for a server (MB/s)\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_backup_compression_lz4_mbs gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_backup_compression_lz4_mbs The throughput of the lz4 compression for a server (MB/s)\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_backup_compression_lz4_mbs gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
       if (number_of_backups[i] > 0)
@@ -4230,48 +4528,47 @@ size_information(prometheus_metrics_container_t* container, int* number_of_backu
          {
             if (backups[i][j] != NULL)
             {
-               data = pgmoneta_append(data, "pgmoneta_backup_compression_lz4_mbs{");
+               pgmoneta_string_builder_append(data, "pgmoneta_backup_compression_lz4_mbs{");
 
-               data = pgmoneta_append(data, "name=\"");
-               data = pgmoneta_append(data, config->common.servers[i].name);
-               data = pgmoneta_append(data, "\", label=\"");
-               data = pgmoneta_append(data, backups[i][j]->label);
-               data = pgmoneta_append(data, "\"} ");
+               pgmoneta_string_builder_append(data, "name=\"");
+               pgmoneta_string_builder_append(data, config->common.servers[i].name);
+               pgmoneta_string_builder_append(data, "\", label=\"");
+               pgmoneta_string_builder_append(data, backups[i][j]->label);
+               pgmoneta_string_builder_append(data, "\"} ");
 
                if (backups[i][j]->compression_lz4_elapsed_time)
                {
-                  data = pgmoneta_append_double_precision(data, (1.0 * backups[i][j]->backup_size / backups[i][j]->compression_lz4_elapsed_time) / (1e6), 4);
+                  pgmoneta_string_builder_append_double_precision(data, (1.0 * backups[i][j]->backup_size / backups[i][j]->compression_lz4_elapsed_time) / (1e6), 4);
                }
                else
                {
-                  data = pgmoneta_append_int(data, 0);
+                  pgmoneta_string_builder_append_int(data, 0);
                }
-               data = pgmoneta_append(data, "\n");
+               pgmoneta_string_builder_append(data, "\n");
             }
          }
       }
       else
       {
-         data = pgmoneta_append(data, "pgmoneta_backup_compression_lz4_mbs{");
+         pgmoneta_string_builder_append(data, "pgmoneta_backup_compression_lz4_mbs{");
 
-         data = pgmoneta_append(data, "name=\"");
-         data = pgmoneta_append(data, config->common.servers[i].name);
-         data = pgmoneta_append(data, "\", label=\"0\"} 0");
+         pgmoneta_string_builder_append(data, "name=\"");
+         pgmoneta_string_builder_append(data, config->common.servers[i].name);
+         pgmoneta_string_builder_append(data, "\", label=\"0\"} 0");
 
-         data = pgmoneta_append(data, "\n");
+         pgmoneta_string_builder_append(data, "\n");
       }
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   if (data != NULL)
+   if (data->length > 0)
    {
-      add_metric_to_art(container->backup_metrics, "pgmoneta_backup_compression_lz4_mbs", data, NULL, NULL, 0);
-      free(data);
-      data = NULL;
+      add_metric_to_art(container->backup_metrics, "pgmoneta_backup_compression_lz4_mbs", data->str, NULL, NULL, 0);
+      pgmoneta_string_builder_reset(data);
    }
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_backup_encryption_mbs The throughput of the encryption for a server (MB/s)\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_backup_encryption_mbs gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_backup_encryption_mbs The throughput of the encryption for a server (MB/s)\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_backup_encryption_mbs gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
       if (number_of_backups[i] > 0)
@@ -4280,48 +4577,47 @@ size_information(prometheus_metrics_container_t* container, int* number_of_backu
          {
             if (backups[i][j] != NULL)
             {
-               data = pgmoneta_append(data, "pgmoneta_backup_encryption_mbs{");
+               pgmoneta_string_builder_append(data, "pgmoneta_backup_encryption_mbs{");
 
-               data = pgmoneta_append(data, "name=\"");
-               data = pgmoneta_append(data, config->common.servers[i].name);
-               data = pgmoneta_append(data, "\", label=\"");
-               data = pgmoneta_append(data, backups[i][j]->label);
-               data = pgmoneta_append(data, "\"} ");
+               pgmoneta_string_builder_append(data, "name=\"");
+               pgmoneta_string_builder_append(data, config->common.servers[i].name);
+               pgmoneta_string_builder_append(data, "\", label=\"");
+               pgmoneta_string_builder_append(data, backups[i][j]->label);
+               pgmoneta_string_builder_append(data, "\"} ");
 
                if (backups[i][j]->encryption_elapsed_time)
                {
-                  data = pgmoneta_append_double_precision(data, (1.0 * backups[i][j]->backup_size / backups[i][j]->encryption_elapsed_time) / (1e6), 4);
+                  pgmoneta_string_builder_append_double_precision(data, (1.0 * backups[i][j]->backup_size / backups[i][j]->encryption_elapsed_time) / (1e6), 4);
                }
                else
                {
-                  data = pgmoneta_append_int(data, 0);
+                  pgmoneta_string_builder_append_int(data, 0);
                }
-               data = pgmoneta_append(data, "\n");
+               pgmoneta_string_builder_append(data, "\n");
             }
          }
       }
       else
       {
-         data = pgmoneta_append(data, "pgmoneta_backup_encryption_mbs{");
+         pgmoneta_string_builder_append(data, "pgmoneta_backup_encryption_mbs{");
 
-         data = pgmoneta_append(data, "name=\"");
-         data = pgmoneta_append(data, config->common.servers[i].name);
-         data = pgmoneta_append(data, "\", label=\"0\"} 0");
+         pgmoneta_string_builder_append(data, "name=\"");
+         pgmoneta_string_builder_append(data, config->common.servers[i].name);
+         pgmoneta_string_builder_append(data, "\", label=\"0\"} 0");
 
-         data = pgmoneta_append(data, "\n");
+         pgmoneta_string_builder_append(data, "\n");
       }
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   if (data != NULL)
+   if (data->length > 0)
    {
-      add_metric_to_art(container->backup_metrics, "pgmoneta_backup_encryption_mbs", data, NULL, NULL, 0);
-      free(data);
-      data = NULL;
+      add_metric_to_art(container->backup_metrics, "pgmoneta_backup_encryption_mbs", data->str, NULL, NULL, 0);
+      pgmoneta_string_builder_reset(data);
    }
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_backup_linking_mbs The throughput of the linking for a server (MB/s)\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_backup_linking_mbs gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_backup_linking_mbs The throughput of the linking for a server (MB/s)\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_backup_linking_mbs gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
       if (number_of_backups[i] > 0)
@@ -4330,48 +4626,47 @@ size_information(prometheus_metrics_container_t* container, int* number_of_backu
          {
             if (backups[i][j] != NULL)
             {
-               data = pgmoneta_append(data, "pgmoneta_backup_linking_mbs{");
+               pgmoneta_string_builder_append(data, "pgmoneta_backup_linking_mbs{");
 
-               data = pgmoneta_append(data, "name=\"");
-               data = pgmoneta_append(data, config->common.servers[i].name);
-               data = pgmoneta_append(data, "\", label=\"");
-               data = pgmoneta_append(data, backups[i][j]->label);
-               data = pgmoneta_append(data, "\"} ");
+               pgmoneta_string_builder_append(data, "name=\"");
+               pgmoneta_string_builder_append(data, config->common.servers[i].name);
+               pgmoneta_string_builder_append(data, "\", label=\"");
+               pgmoneta_string_builder_append(data, backups[i][j]->label);
+               pgmoneta_string_builder_append(data, "\"} ");
 
                if (backups[i][j]->linking_elapsed_time)
                {
-                  data = pgmoneta_append_double_precision(data, (1.0 * backups[i][j]->backup_size / backups[i][j]->linking_elapsed_time) / (1e6), 4);
+                  pgmoneta_string_builder_append_double_precision(data, (1.0 * backups[i][j]->backup_size / backups[i][j]->linking_elapsed_time) / (1e6), 4);
                }
                else
                {
-                  data = pgmoneta_append_int(data, 0);
+                  pgmoneta_string_builder_append_int(data, 0);
                }
-               data = pgmoneta_append(data, "\n");
+               pgmoneta_string_builder_append(data, "\n");
             }
          }
       }
       else
       {
-         data = pgmoneta_append(data, "pgmoneta_backup_linking_mbs{");
+         pgmoneta_string_builder_append(data, "pgmoneta_backup_linking_mbs{");
 
-         data = pgmoneta_append(data, "name=\"");
-         data = pgmoneta_append(data, config->common.servers[i].name);
-         data = pgmoneta_append(data, "\", label=\"0\"} 0");
+         pgmoneta_string_builder_append(data, "name=\"");
+         pgmoneta_string_builder_append(data, config->common.servers[i].name);
+         pgmoneta_string_builder_append(data, "\", label=\"0\"} 0");
 
-         data = pgmoneta_append(data, "\n");
+         pgmoneta_string_builder_append(data, "\n");
       }
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   if (data != NULL)
+   if (data->length > 0)
    {
-      add_metric_to_art(container->backup_metrics, "pgmoneta_backup_linking_mbs", data, NULL, NULL, 0);
-      free(data);
-      data = NULL;
+      add_metric_to_art(container->backup_metrics, "pgmoneta_backup_linking_mbs", data->str, NULL, NULL, 0);
+      pgmoneta_string_builder_reset(data);
    }
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_backup_remote_ssh_mbs The throughput of the remote_ssh for a server (MB/s)\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_backup_remote_ssh_mbs gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_backup_remote_ssh_mbs The throughput of the remote_ssh for a server (MB/s)\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_backup_remote_ssh_mbs gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
       if (number_of_backups[i] > 0)
@@ -4380,48 +4675,47 @@ size_information(prometheus_metrics_container_t* container, int* number_of_backu
          {
             if (backups[i][j] != NULL)
             {
-               data = pgmoneta_append(data, "pgmoneta_backup_remote_ssh_mbs{");
+               pgmoneta_string_builder_append(data, "pgmoneta_backup_remote_ssh_mbs{");
 
-               data = pgmoneta_append(data, "name=\"");
-               data = pgmoneta_append(data, config->common.servers[i].name);
-               data = pgmoneta_append(data, "\", label=\"");
-               data = pgmoneta_append(data, backups[i][j]->label);
-               data = pgmoneta_append(data, "\"} ");
+               pgmoneta_string_builder_append(data, "name=\"");
+               pgmoneta_string_builder_append(data, config->common.servers[i].name);
+               pgmoneta_string_builder_append(data, "\", label=\"");
+               pgmoneta_string_builder_append(data, backups[i][j]->label);
+               pgmoneta_string_builder_append(data, "\"} ");
 
                if (backups[i][j]->remote_ssh_elapsed_time)
                {
-                  data = pgmoneta_append_double_precision(data, (1.0 * backups[i][j]->backup_size / backups[i][j]->remote_ssh_elapsed_time) / (1e6), 4);
+                  pgmoneta_string_builder_append_double_precision(data, (1.0 * backups[i][j]->backup_size / backups[i][j]->remote_ssh_elapsed_time) / (1e6), 4);
                }
                else
                {
-                  data = pgmoneta_append_int(data, 0);
+                  pgmoneta_string_builder_append_int(data, 0);
                }
-               data = pgmoneta_append(data, "\n");
+               pgmoneta_string_builder_append(data, "\n");
             }
          }
       }
       else
       {
-         data = pgmoneta_append(data, "pgmoneta_backup_remote_ssh_mbs{");
+         pgmoneta_string_builder_append(data, "pgmoneta_backup_remote_ssh_mbs{");
 
-         data = pgmoneta_append(data, "name=\"");
-         data = pgmoneta_append(data, config->common.servers[i].name);
-         data = pgmoneta_append(data, "\", label=\"0\"} 0");
+         pgmoneta_string_builder_append(data, "name=\"");
+         pgmoneta_string_builder_append(data, config->common.servers[i].name);
+         pgmoneta_string_builder_append(data, "\", label=\"0\"} 0");
 
-         data = pgmoneta_append(data, "\n");
+         pgmoneta_string_builder_append(data, "\n");
       }
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   if (data != NULL)
+   if (data->length > 0)
    {
-      add_metric_to_art(container->backup_metrics, "pgmoneta_backup_remote_ssh_mbs", data, NULL, NULL, 0);
-      free(data);
-      data = NULL;
+      add_metric_to_art(container->backup_metrics, "pgmoneta_backup_remote_ssh_mbs", data->str, NULL, NULL, 0);
+      pgmoneta_string_builder_reset(data);
    }
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_backup_remote_s3_mbs The throughput of the remote_s3 for a server (MB/s)\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_backup_remote_s3_mbs gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_backup_remote_s3_mbs The throughput of the remote_s3 for a server (MB/s)\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_backup_remote_s3_mbs gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
       if (number_of_backups[i] > 0)
@@ -4430,48 +4724,47 @@ size_information(prometheus_metrics_container_t* container, int* number_of_backu
          {
             if (backups[i][j] != NULL)
             {
-               data = pgmoneta_append(data, "pgmoneta_backup_remote_s3_mbs{");
+               pgmoneta_string_builder_append(data, "pgmoneta_backup_remote_s3_mbs{");
 
-               data = pgmoneta_append(data, "name=\"");
-               data = pgmoneta_append(data, config->common.servers[i].name);
-               data = pgmoneta_append(data, "\", label=\"");
-               data = pgmoneta_append(data, backups[i][j]->label);
-               data = pgmoneta_append(data, "\"} ");
+               pgmoneta_string_builder_append(data, "name=\"");
+               pgmoneta_string_builder_append(data, config->common.servers[i].name);
+               pgmoneta_string_builder_append(data, "\", label=\"");
+               pgmoneta_string_builder_append(data, backups[i][j]->label);
+               pgmoneta_string_builder_append(data, "\"} ");
 
                if (backups[i][j]->remote_s3_elapsed_time)
                {
-                  data = pgmoneta_append_double_precision(data, (1.0 * backups[i][j]->backup_size / backups[i][j]->remote_s3_elapsed_time) / (1e6), 4);
+                  pgmoneta_string_builder_append_double_precision(data, (1.0 * backups[i][j]->backup_size / backups[i][j]->remote_s3_elapsed_time) / (1e6), 4);
                }
                else
                {
-                  data = pgmoneta_append_int(data, 0);
+                  pgmoneta_string_builder_append_int(data, 0);
                }
-               data = pgmoneta_append(data, "\n");
+               pgmoneta_string_builder_append(data, "\n");
             }
          }
       }
       else
       {
-         data = pgmoneta_append(data, "pgmoneta_backup_remote_s3_mbs{");
+         pgmoneta_string_builder_append(data, "pgmoneta_backup_remote_s3_mbs{");
 
-         data = pgmoneta_append(data, "name=\"");
-         data = pgmoneta_append(data, config->common.servers[i].name);
-         data = pgmoneta_append(data, "\", label=\"0\"} 0");
+         pgmoneta_string_builder_append(data, "name=\"");
+         pgmoneta_string_builder_append(data, config->common.servers[i].name);
+         pgmoneta_string_builder_append(data, "\", label=\"0\"} 0");
 
-         data = pgmoneta_append(data, "\n");
+         pgmoneta_string_builder_append(data, "\n");
       }
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   if (data != NULL)
+   if (data->length > 0)
    {
-      add_metric_to_art(container->backup_metrics, "pgmoneta_backup_remote_s3_mbs", data, NULL, NULL, 0);
-      free(data);
-      data = NULL;
+      add_metric_to_art(container->backup_metrics, "pgmoneta_backup_remote_s3_mbs", data->str, NULL, NULL, 0);
+      pgmoneta_string_builder_reset(data);
    }
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_backup_remote_azure_mbs The throughput of the remote_azure for a server (MB/s)\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_backup_remote_azure_mbs gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_backup_remote_azure_mbs The throughput of the remote_azure for a server (MB/s)\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_backup_remote_azure_mbs gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
       if (number_of_backups[i] > 0)
@@ -4480,48 +4773,47 @@ size_information(prometheus_metrics_container_t* container, int* number_of_backu
          {
             if (backups[i][j] != NULL)
             {
-               data = pgmoneta_append(data, "pgmoneta_backup_remote_azure_mbs{");
+               pgmoneta_string_builder_append(data, "pgmoneta_backup_remote_azure_mbs{");
 
-               data = pgmoneta_append(data, "name=\"");
-               data = pgmoneta_append(data, config->common.servers[i].name);
-               data = pgmoneta_append(data, "\", label=\"");
-               data = pgmoneta_append(data, backups[i][j]->label);
-               data = pgmoneta_append(data, "\"} ");
+               pgmoneta_string_builder_append(data, "name=\"");
+               pgmoneta_string_builder_append(data, config->common.servers[i].name);
+               pgmoneta_string_builder_append(data, "\", label=\"");
+               pgmoneta_string_builder_append(data, backups[i][j]->label);
+               pgmoneta_string_builder_append(data, "\"} ");
 
                if (backups[i][j]->remote_azure_elapsed_time)
                {
-                  data = pgmoneta_append_double_precision(data, (1.0 * backups[i][j]->backup_size / backups[i][j]->remote_azure_elapsed_time) / (1e6), 4);
+                  pgmoneta_string_builder_append_double_precision(data, (1.0 * backups[i][j]->backup_size / backups[i][j]->remote_azure_elapsed_time) / (1e6), 4);
                }
                else
                {
-                  data = pgmoneta_append_int(data, 0);
+                  pgmoneta_string_builder_append_int(data, 0);
                }
-               data = pgmoneta_append(data, "\n");
+               pgmoneta_string_builder_append(data, "\n");
             }
          }
       }
       else
       {
-         data = pgmoneta_append(data, "pgmoneta_backup_remote_azure_mbs{");
+         pgmoneta_string_builder_append(data, "pgmoneta_backup_remote_azure_mbs{");
 
-         data = pgmoneta_append(data, "name=\"");
-         data = pgmoneta_append(data, config->common.servers[i].name);
-         data = pgmoneta_append(data, "\", label=\"0\"} 0");
+         pgmoneta_string_builder_append(data, "name=\"");
+         pgmoneta_string_builder_append(data, config->common.servers[i].name);
+         pgmoneta_string_builder_append(data, "\", label=\"0\"} 0");
 
-         data = pgmoneta_append(data, "\n");
+         pgmoneta_string_builder_append(data, "\n");
       }
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   if (data != NULL)
+   if (data->length > 0)
    {
-      add_metric_to_art(container->backup_metrics, "pgmoneta_backup_remote_azure_mbs", data, NULL, NULL, 0);
-      free(data);
-      data = NULL;
+      add_metric_to_art(container->backup_metrics, "pgmoneta_backup_remote_azure_mbs", data->str, NULL, NULL, 0);
+      pgmoneta_string_builder_reset(data);
    }
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_backup_retain Retain backup for a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_backup_retain gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_backup_retain Retain backup for a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_backup_retain gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
       if (number_of_backups[i] > 0)
@@ -4530,307 +4822,305 @@ size_information(prometheus_metrics_container_t* container, int* number_of_backu
          {
             if (backups[i][j] != NULL)
             {
-               data = pgmoneta_append(data, "pgmoneta_backup_retain{");
+               pgmoneta_string_builder_append(data, "pgmoneta_backup_retain{");
 
-               data = pgmoneta_append(data, "name=\"");
-               data = pgmoneta_append(data, config->common.servers[i].name);
-               data = pgmoneta_append(data, "\", label=\"");
-               data = pgmoneta_append(data, backups[i][j]->label);
-               data = pgmoneta_append(data, "\"} ");
+               pgmoneta_string_builder_append(data, "name=\"");
+               pgmoneta_string_builder_append(data, config->common.servers[i].name);
+               pgmoneta_string_builder_append(data, "\", label=\"");
+               pgmoneta_string_builder_append(data, backups[i][j]->label);
+               pgmoneta_string_builder_append(data, "\"} ");
 
-               data = pgmoneta_append_int(data, backups[i][j]->keep ? 1 : 0);
+               pgmoneta_string_builder_append_int(data, backups[i][j]->keep ? 1 : 0);
 
-               data = pgmoneta_append(data, "\n");
+               pgmoneta_string_builder_append(data, "\n");
             }
          }
       }
       else
       {
-         data = pgmoneta_append(data, "pgmoneta_backup_retain{");
+         pgmoneta_string_builder_append(data, "pgmoneta_backup_retain{");
 
-         data = pgmoneta_append(data, "name=\"");
-         data = pgmoneta_append(data, config->common.servers[i].name);
-         data = pgmoneta_append(data, "\", label=\"0\"} 0");
+         pgmoneta_string_builder_append(data, "name=\"");
+         pgmoneta_string_builder_append(data, config->common.servers[i].name);
+         pgmoneta_string_builder_append(data, "\", label=\"0\"} 0");
 
-         data = pgmoneta_append(data, "\n");
+         pgmoneta_string_builder_append(data, "\n");
       }
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   if (data != NULL)
+   if (data->length > 0)
    {
-      add_metric_to_art(container->backup_metrics, "pgmoneta_backup_retain", data, NULL, NULL, 0);
-      free(data);
-      data = NULL;
+      add_metric_to_art(container->backup_metrics, "pgmoneta_backup_retain", data->str, NULL, NULL, 0);
+      pgmoneta_string_builder_reset(data);
    }
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_backup_total_size The total size of the backups for a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_backup_total_size gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_backup_total_size The total size of the backups for a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_backup_total_size gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
-      d = pgmoneta_get_server_backup(i);
+      pgmoneta_string_builder_append(data, "pgmoneta_backup_total_size{");
 
-      size = pgmoneta_directory_size(d);
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\"} ");
 
-      data = pgmoneta_append(data, "pgmoneta_backup_total_size{");
+      pgmoneta_string_builder_append_ulong(data, pgmoneta_usage_get(i, USAGE_BACKUP));
 
-      data = pgmoneta_append(data, "name=\"");
-      data = pgmoneta_append(data, config->common.servers[i].name);
-      data = pgmoneta_append(data, "\"} ");
-
-      data = pgmoneta_append_ulong(data, size);
-
-      data = pgmoneta_append(data, "\n");
-
-      free(d);
+      pgmoneta_string_builder_append(data, "\n");
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   if (data != NULL)
+   if (data->length > 0)
    {
-      add_metric_to_art(container->backup_metrics, "pgmoneta_backup_total_size", data, NULL, NULL, 0);
-      free(data);
-      data = NULL;
+      add_metric_to_art(container->backup_metrics, "pgmoneta_backup_total_size", data->str, NULL, NULL, 0);
+      pgmoneta_string_builder_reset(data);
    }
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_wal_total_size The total size of the WAL for a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_wal_total_size gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_backup_dedup_saved_size The size of the chunked data of the backups for a server that the chunk store already held\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_backup_dedup_saved_size gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
-      d = pgmoneta_get_server_wal(i);
-
-      size = pgmoneta_directory_size(d);
-
-      free(d);
-
-      d = pgmoneta_get_server_wal_shipping_wal(i);
+      size = 0;
 
-      if (d != NULL)
+      for (int j = 0; j < number_of_backups[i]; j++)
       {
-         size += pgmoneta_directory_size(d);
+         if (backups[i][j] != NULL && backups[i][j]->chunked_size > backups[i][j]->chunked_stored_size)
+         {
+            size += backups[i][j]->chunked_size - backups[i][j]->chunked_stored_size;
+         }
       }
 
-      data = pgmoneta_append(data, "pgmoneta_wal_total_size{");
+      pgmoneta_string_builder_append(data, "pgmoneta_backup_dedup_saved_size{");
 
-      data = pgmoneta_append(data, "name=\"");
-      data = pgmoneta_append(data, config->common.servers[i].name);
-      data = pgmoneta_append(data, "\"} ");
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\"} ");
 
-      data = pgmoneta_append_ulong(data, size);
+      pgmoneta_string_builder_append_ulong(data, size);
 
-      data = pgmoneta_append(data, "\n");
-
-      free(d);
+      pgmoneta_string_builder_append(data, "\n");
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   if (data != NULL)
+   if (data->length > 0)
    {
-      add_metric_to_art(container->backup_metrics, "pgmoneta_wal_total_size", data, NULL, NULL, 0);
-      free(data);
-      data = NULL;
+      add_metric_to_art(container->backup_metrics, "pgmoneta_backup_dedup_saved_size", data->str, NULL, NULL, 0);
+      pgmoneta_string_builder_reset(data);
    }
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_total_size The total size for a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_total_size gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_wal_total_size The total size of the WAL for a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_wal_total_size gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
-      d = pgmoneta_get_server(i);
+      size = pgmoneta_usage_get(i, USAGE_WAL) + pgmoneta_usage_get(i, USAGE_WAL_SHIPPING_WAL);
 
-      size = pgmoneta_directory_size(d);
+      pgmoneta_string_builder_append(data, "pgmoneta_wal_total_size{");
 
-      free(d);
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\"} ");
 
-      d = pgmoneta_get_server_wal_shipping(i);
+      pgmoneta_string_builder_append_ulong(data, size);
 
-      if (d != NULL)
-      {
-         size += pgmoneta_directory_size(d);
-      }
+      pgmoneta_string_builder_append(data, "\n");
+   }
+   pgmoneta_string_builder_append(data, "\n");
+
+   if (data->length > 0)
+   {
+      add_metric_to_art(container->backup_metrics, "pgmoneta_wal_total_size", data->str, NULL, NULL, 0);
+      pgmoneta_string_builder_reset(data);
+   }
 
-      data = pgmoneta_append(data, "pgmoneta_total_size{");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_total_size The total size for a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_total_size gauge\n");
+   for (int i = 0; i < config->common.number_of_servers; i++)
+   {
+      size = pgmoneta_usage_get(i, USAGE_SERVER) + pgmoneta_usage_get(i, USAGE_WAL_SHIPPING);
 
-      data = pgmoneta_append(data, "name=\"");
-      data = pgmoneta_append(data, config->common.servers[i].name);
-      data = pgmoneta_append(data, "\"} ");
+      pgmoneta_string_builder_append(data, "pgmoneta_total_size{");
 
-      data = pgmoneta_append_ulong(data, size);
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\"} ");
 
-      data = pgmoneta_append(data, "\n");
+      pgmoneta_string_builder_append_ulong(data, size);
 
-      free(d);
+      pgmoneta_string_builder_append(data, "\n");
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_active_backup Is there an active backup for a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_active_backup gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_active_backup Is there an active backup for a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_active_backup gauge\n");
 
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
-      data = pgmoneta_append(data, "pgmoneta_active_backup{");
-      data = pgmoneta_append(data, "name=\"");
-      data = pgmoneta_append(data, config->common.servers[i].name);
-      data = pgmoneta_append(data, "\"} ");
+      pgmoneta_string_builder_append(data, "pgmoneta_active_backup{");
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\"} ");
 
       if (config->common.servers[i].active_backup)
       {
-         data = pgmoneta_append_int(data, 1);
+         pgmoneta_string_builder_append_int(data, 1);
       }
       else
       {
-         data = pgmoneta_append_int(data, 0);
+         pgmoneta_string_builder_append_int(data, 0);
       }
-      data = pgmoneta_append(data, "\n");
+      pgmoneta_string_builder_append(data, "\n");
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_active_restore Is there an active restore for a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_active_restore gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_active_restore Is there an active restore for a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_active_restore gauge\n");
 
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
-      data = pgmoneta_append(data, "pgmoneta_active_restore{");
-      data = pgmoneta_append(data, "name=\"");
-      data = pgmoneta_append(data, config->common.servers[i].name);
-      data = pgmoneta_append(data, "\"} ");
+      pgmoneta_string_builder_append(data, "pgmoneta_active_restore{");
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\"} ");
 
       if (config->common.servers[i].active_restore)
       {
-         data = pgmoneta_append_int(data, 1);
+         pgmoneta_string_builder_append_int(data, 1);
       }
       else
       {
-         data = pgmoneta_append_int(data, 0);
+         pgmoneta_string_builder_append_int(data, 0);
       }
 
-      data = pgmoneta_append(data, "\n");
+      pgmoneta_string_builder_append(data, "\n");
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_active_archive Is there an active archiving for a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_active_archive gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_active_archive Is there an active archiving for a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_active_archive gauge\n");
 
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
-      data = pgmoneta_append(data, "pgmoneta_active_archive{");
-      data = pgmoneta_append(data, "name=\"");
-      data = pgmoneta_append(data, config->common.servers[i].name);
-      data = pgmoneta_append(data, "\"} ");
+      pgmoneta_string_builder_append(data, "pgmoneta_active_archive{");
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\"} ");
 
       if (config->common.servers[i].active_archive)
       {
-         data = pgmoneta_append_int(data, 1);
+         pgmoneta_string_builder_append_int(data, 1);
       }
       else
       {
-         data = pgmoneta_append_int(data, 0);
+         pgmoneta_string_builder_append_int(data, 0);
       }
 
-      data = pgmoneta_append(data, "\n");
+      pgmoneta_string_builder_append(data, "\n");
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_active_delete Is there an active delete for a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_active_delete gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_active_delete Is there an active delete for a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_active_delete gauge\n");
 
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
-      data = pgmoneta_append(data, "pgmoneta_active_delete{");
-      data = pgmoneta_append(data, "name=\"");
-      data = pgmoneta_append(data, config->common.servers[i].name);
-      data = pgmoneta_append(data, "\"} ");
+      pgmoneta_string_builder_append(data, "pgmoneta_active_delete{");
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\"} ");
 
       if (config->common.servers[i].active_delete)
       {
-         data = pgmoneta_append_int(data, 1);
+         pgmoneta_string_builder_append_int(data, 1);
       }
       else
       {
-         data = pgmoneta_append_int(data, 0);
+         pgmoneta_string_builder_append_int(data, 0);
       }
 
-      data = pgmoneta_append(data, "\n");
+      pgmoneta_string_builder_append(data, "\n");
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_active_retention Is there an "
-                                "active archiving for a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_active_retention gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_active_retention Is there an "
+                                  "active archiving for a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_active_retention gauge\n");
 
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
-      data = pgmoneta_append(data, "pgmoneta_active_retention{");
-      data = pgmoneta_append(data, "name=\"");
-      data = pgmoneta_append(data, config->common.servers[i].name);
-      data = pgmoneta_append(data, "\"} ");
+      pgmoneta_string_builder_append(data, "pgmoneta_active_retention{");
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\"} ");
 
       if (config->common.servers[i].active_retention)
       {
-         data = pgmoneta_append_int(data, 1);
+         pgmoneta_string_builder_append_int(data, 1);
       }
       else
       {
-         data = pgmoneta_append_int(data, 0);
+         pgmoneta_string_builder_append_int(data, 0);
       }
 
-      data = pgmoneta_append(data, "\n");
+      pgmoneta_string_builder_append(data, "\n");
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   data = pgmoneta_append(data, "#HELP pgmoneta_current_wal_file The current streaming WAL filename of a server\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_current_wal_file gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_current_wal_file The current streaming WAL filename of a server\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_current_wal_file gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
-      data = pgmoneta_append(data, "pgmoneta_current_wal_file{");
+      pgmoneta_string_builder_append(data, "pgmoneta_current_wal_file{");
 
-      data = pgmoneta_append(data, "name=\"");
-      data = pgmoneta_append(data, config->common.servers[i].name);
-      data = pgmoneta_append(data, "\", ");
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\", ");
 
-      data = pgmoneta_append(data, "file=\"");
-      data = pgmoneta_append(data, config->common.servers[i].current_wal_filename);
-      data = pgmoneta_append(data, "\"} ");
+      pgmoneta_string_builder_append(data, "file=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].current_wal_filename);
+      pgmoneta_string_builder_append(data, "\"} ");
 
-      data = pgmoneta_append_int(data, config->common.servers[i].wal_streaming > 0 ? 1 : 0);
+      pgmoneta_string_builder_append_int(data, config->common.servers[i].wal_streaming > 0 ? 1 : 0);
 
-      data = pgmoneta_append(data, "\n");
+      pgmoneta_string_builder_append(data, "\n");
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
    // Append the WAL LSN of every server
-   data = pgmoneta_append(data, "#HELP pgmoneta_current_wal_lsn The current WAL log sequence number\n");
-   data = pgmoneta_append(data, "#TYPE pgmoneta_current_wal_lsn gauge\n");
+   pgmoneta_string_builder_append(data, "#HELP pgmoneta_current_wal_lsn The current WAL log sequence number\n");
+   pgmoneta_string_builder_append(data, "#TYPE pgmoneta_current_wal_lsn gauge\n");
    for (int i = 0; i < config->common.number_of_servers; i++)
    {
-      data = pgmoneta_append(data, "pgmoneta_current_wal_lsn{");
+      pgmoneta_string_builder_append(data, "pgmoneta_current_wal_lsn{");
 
-      data = pgmoneta_append(data, "name=\"");
-      data = pgmoneta_append(data, config->common.servers[i].name);
-      data = pgmoneta_append(data, "\", ");
+      pgmoneta_string_builder_append(data, "name=\"");
+      pgmoneta_string_builder_append(data, config->common.servers[i].name);
+      pgmoneta_string_builder_append(data, "\", ");
 
-      data = pgmoneta_append(data, "lsn=\"");
+      pgmoneta_string_builder_append(data, "lsn=\"");
       if (!strcmp(config->common.servers[i].current_wal_lsn, ""))
       {
-         data = pgmoneta_append(data, "0/0");
+         pgmoneta_string_builder_append(data, "0/0");
       }
       else
       {
-         data = pgmoneta_append(data, config->common.servers[i].current_wal_lsn);
+         pgmoneta_string_builder_append(data, config->common.servers[i].current_wal_lsn);
       }
-      data = pgmoneta_append(data, "\"} ");
+      pgmoneta_string_builder_append(data, "\"} ");
 
-      data = pgmoneta_append_int(data, config->common.servers[i].wal_streaming > 0 ? 1 : 0);
+      pgmoneta_string_builder_append_int(data, config->common.servers[i].wal_streaming > 0 ? 1 : 0);
 
-      data = pgmoneta_append(data, "\n");
+      pgmoneta_string_builder_append(data, "\n");
    }
-   data = pgmoneta_append(data, "\n");
+   pgmoneta_string_builder_append(data, "\n");
 
-   if (data != NULL)
+   if (data->length > 0)
    {
-      add_metric_to_art(container->backup_metrics, "pgmoneta_current_wal_lsn", data, NULL, NULL, 0);
-      free(data);
-      data = NULL;
+      add_metric_to_art(container->backup_metrics, "pgmoneta_current_wal_lsn", data->str, NULL, NULL, 0);
+      pgmoneta_string_builder_reset(data);
    }
+
+   pgmoneta_string_builder_destroy(data);
 }
 
 static int
@@ -5245,7 +5535,7 @@ error:
 static void
 output_art_metrics(SSL* client_ssl, int client_fd, struct art* art_tree)
 {
-   char* data = NULL;
+   struct string_builder* data = NULL;
    struct art_iterator* iter = NULL;
 
    if (art_tree == NULL)
@@ -5258,24 +5548,30 @@ output_art_metrics(SSL* client_ssl, int client_fd, struct art* art_tree)
       return;
    }
 
+   if (pgmoneta_string_builder_create(0, &data))
+   {
+      pgmoneta_art_iterator_destroy(iter);
+      return;
+   }
+
    while (pgmoneta_art_iterator_next(iter))
    {
       prometheus_metric_value_t* m = (prometheus_metric_value_t*)iter->value->data;
 
       if (m != NULL && m->value != NULL)
       {
-         data = pgmoneta_append(data, m->value);
-         data = pgmoneta_append(data, "\n");
+         pgmoneta_string_builder_append(data, m->value);
+         pgmoneta_string_builder_append(data, "\n");
       }
    }
 
-   if (data != NULL)
+   if (data->length > 0)
    {
-      send_chunk(client_ssl, client_fd, data);
-      metrics_cache_append(data);
-      free(data);
+      send_chunk(client_ssl, client_fd, data->str);
+      metrics_cache_append(data->str);
    }
 
+   pgmoneta_string_builder_destroy(data);
    pgmoneta_art_iterator_destroy(iter);
 }
 
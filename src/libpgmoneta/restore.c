@@ -28,6 +28,7 @@
 
 /* pgmoneta */
 #include <pgmoneta.h>
+#include <chunk.h>
 #include <logging.h>
 #include <management.h>
 #include <manifest.h>
@@ -81,7 +82,6 @@ static int restore_backup_incremental(struct art* nodes);
 
 static int carry_out_workflow(struct workflow* workflow, struct art* nodes);
 
-static void clear_manifest_incremental_entries(struct json* manifest);
 /**
  * Combine the provided backups or each of the user defined table-spaces
  * The function will be called for two rounds, the first round would construct the data directory
@@ -236,6 +236,9 @@ parse_oid(char* name);
 static void
 cleanup_workspaces(int server, struct deque* labels);
 
+static void
+remove_rehydrated(int server, struct deque* labels);
+
 static void
 create_workspace_directory(int server, char* label, char* relative_prefix);
 
@@ -251,6 +254,24 @@ create_workspace_directories(int server, struct deque* labels, char* relative_pr
  * @param labels [out] The resulting label deque
  * @return 0 on success, 1 if otherwise
  */
+static void
+remove_rehydrated(int server, struct deque* labels)
+{
+   struct deque_iterator* iter = NULL;
+
+   if (labels == NULL)
+   {
+      return;
+   }
+
+   pgmoneta_deque_iterator_create(labels, &iter);
+   while (pgmoneta_deque_iterator_next(iter))
+   {
+      pgmoneta_chunk_rehydrate_remove(server, (char*)pgmoneta_value_data(iter->value));
+   }
+   pgmoneta_deque_iterator_destroy(iter);
+}
+
 static int
 construct_backup_label_chain(int server, char* newest_label, char* oldest_label, bool inclusive, struct deque** labels);
 
@@ -832,7 +853,7 @@ pgmoneta_restore_backup(struct art* nodes)
 }
 
 int
-pgmoneta_combine_backups(int server, char* label, char* base, char* input_dir, char* output_dir, struct deque* prior_labels, struct backup* bck, struct json* manifest, bool incremental, bool combine_as_is)
+pgmoneta_combine_backups(int server, char* label, char* base, char* input_dir, char* output_dir, struct deque* prior_labels, struct backup* bck, bool incremental, bool combine_as_is)
 {
    uint32_t tsoid = 0;
    char relative_tablespace_path[MAX_PATH];
@@ -841,6 +862,7 @@ pgmoneta_combine_backups(int server, char* label, char* base, char* input_dir, c
    char itblspc_dir[MAX_PATH];
    char otblspc_dir[MAX_PATH];
    char manifest_path[MAX_PATH];
+   char source_manifest_path[MAX_PATH];
    char* oldest_label = NULL;
    char* server_dir = NULL;
    int number_of_workers = 0;
@@ -850,7 +872,7 @@ pgmoneta_combine_backups(int server, char* label, char* base, char* input_dir, c
    struct json* files = NULL;
    struct main_configuration* config;
 
-   if (manifest == NULL || prior_labels == NULL || base == NULL || input_dir == NULL || output_dir == NULL)
+   if (prior_labels == NULL || base == NULL || input_dir == NULL || output_dir == NULL)
    {
       goto error;
    }
@@ -878,24 +900,27 @@ pgmoneta_combine_backups(int server, char* label, char* base, char* input_dir, c
          goto error;
       }
       pgmoneta_art_insert(backups, l, (uintptr_t)b, ValueMem);
+
+      /* A chunked prior backup is read from a temporary copy, so it stays chunked */
+      if (pgmoneta_chunk_is_chunked(server, l) && pgmoneta_chunk_rehydrate(server, l))
+      {
+         pgmoneta_log_error("Combine incremental: Unable to rehydrate %s", l);
+         goto error;
+      }
    }
    pgmoneta_art_insert(backups, label, (uintptr_t)bck, ValueRef);
 
    memset(manifest_path, 0, MAX_PATH);
    pgmoneta_snprintf(manifest_path, MAX_PATH, "%s/backup_manifest", output_dir);
+   memset(source_manifest_path, 0, MAX_PATH);
+   pgmoneta_snprintf(source_manifest_path, MAX_PATH, "%s/backup_manifest", input_dir);
 
-   clear_manifest_incremental_entries(manifest);
-   files = (struct json*)pgmoneta_json_get(manifest, MANIFEST_FILES);
-   if (files == NULL)
+   // only the reconstructed files are kept in memory, the rest is streamed from the source manifest
+   if (pgmoneta_json_create_array(number_of_workers > 0, &files))
    {
       goto error;
    }
 
-   if (number_of_workers > 0)
-   {
-      pgmoneta_deque_set_thread_safe((struct deque*)files->elements);
-   }
-
    // It is actually ok even if we don't explicitly create the top level directory
    // since pgmoneta_mkdir creates parent directory if it doesn't exist.
    // We do this to make the code clearer and safer
@@ -992,20 +1017,24 @@ pgmoneta_combine_backups(int server, char* label, char* base, char* input_dir, c
       }
    }
 
-   if (pgmoneta_write_postgresql_manifest(manifest, manifest_path))
+   if (pgmoneta_write_combined_manifest(source_manifest_path, files, manifest_path))
    {
       pgmoneta_log_error("Fail to write manifest to %s", manifest_path);
       goto error;
    }
 
+   pgmoneta_json_destroy(files);
    pgmoneta_workers_destroy(workers);
+   remove_rehydrated(server, prior_labels);
    pgmoneta_art_destroy(backups);
    pgmoneta_deque_iterator_destroy(iter);
    free(server_dir);
    return 0;
 
 error:
+   pgmoneta_json_destroy(files);
    pgmoneta_workers_destroy(workers);
+   remove_rehydrated(server, prior_labels);
    pgmoneta_art_destroy(backups);
    pgmoneta_deque_iterator_destroy(iter);
    free(server_dir);
@@ -2349,38 +2378,6 @@ error:
    return 0;
 }
 
-static void
-clear_manifest_incremental_entries(struct json* manifest)
-{
-   struct json* files = NULL;
-   struct json* f = NULL;
-   char* path = NULL;
-   struct json_iterator* iter = NULL;
-   struct deque_iterator* diter = NULL;
-   if (manifest == NULL)
-   {
-      return;
-   }
-   files = (struct json*)pgmoneta_json_get(manifest, MANIFEST_FILES);
-   if (files == NULL)
-   {
-      return;
-   }
-   pgmoneta_json_iterator_create(files, &iter);
-   // a tiny hack to get the internal deque iterator of the json iterator
-   diter = (struct deque_iterator*)iter->iter;
-   while (pgmoneta_deque_iterator_next(diter))
-   {
-      f = (struct json*)pgmoneta_value_data(diter->value);
-      path = (char*)pgmoneta_json_get(f, "Path");
-      if (pgmoneta_is_incremental_path(path))
-      {
-         pgmoneta_deque_iterator_remove(diter);
-      }
-   }
-   pgmoneta_json_iterator_destroy(iter);
-}
-
 static int
 restore_backup_full(struct art* nodes)
 {
@@ -2515,7 +2512,6 @@ restore_backup_incremental(struct art* nodes)
    char tmp_excluded_file_path[MAX_PATH_CONCAT + sizeof(TMP_SUFFIX)];
    int excluded_files = 0;
    char* manifest_path = NULL;
-   struct json* manifest = NULL;
    struct workflow* workflow = NULL;
    struct main_configuration* config;
    uint64_t free_space = 0;
@@ -2552,12 +2548,12 @@ restore_backup_incremental(struct art* nodes)
 
    manifest_path = pgmoneta_get_server_backup_identifier_data(server, backup->label);
    manifest_path = pgmoneta_append(manifest_path, "backup_manifest");
-   // read the manifest for later usage
-   if (pgmoneta_json_read_file(manifest_path, &manifest))
+   // the manifest is streamed when the backups are combined
+   if (!pgmoneta_exists(manifest_path))
    {
+      pgmoneta_log_error("restore_backup_incremental: missing manifest %s", manifest_path);
       goto error;
    }
-   pgmoneta_art_insert(nodes, NODE_MANIFEST, (uintptr_t)manifest, ValueJSON);
 
    if (!pgmoneta_exists(target_root_combine))
    {
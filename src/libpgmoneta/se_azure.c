@@ -28,28 +28,67 @@
 
 /* pgmoneta */
 #include <pgmoneta.h>
+#include <deque.h>
 #include <http.h>
 #include <logging.h>
 #include <security.h>
 #include <utils.h>
+#include <workers.h>
 #include <workflow.h>
 
 /* system */
 #include <assert.h>
 #include <dirent.h>
+#include <fcntl.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define AZURE_VERSION    "2021-08-06"
+#define AZURE_MAX_BLOCKS 50000
+
+/**
+ * A file uploaded as a block blob
+ */
+struct azure_file
+{
+   char local_path[MAX_PATH];  /**< The local path */
+   char azure_path[MAX_PATH];  /**< The blob path */
+   size_t size;                /**< The size of the file */
+   size_t block_size;          /**< The size of a block */
+   int number_of_blocks;       /**< The number of blocks, 0 for a single Put Blob */
+};
+
+/**
+ * A Put Blob or Put Block request for a worker
+ */
+struct azure_task
+{
+   struct worker_common common; /**< The common worker data */
+   struct azure_file* file;     /**< The file */
+   int block;                   /**< The block, -1 for the whole blob */
+};
 
 static char* azure_storage_name(void);
 static int azure_storage_setup(char* name, struct art*);
 static int azure_storage_execute(char* name, struct art*);
 static int azure_storage_teardown(char* name, struct art*);
 
-static int azure_upload_files(char* local_root, char* azure_root, char* relative_path);
-static int azure_send_upload_request(char* local_root, char* azure_root, char* relative_path);
-static int azure_add_request_headers(struct http_request* request, char* auth_value, char* utc_date);
+static int azure_upload_files(char* local_root, char* azure_root, char* relative_path, struct workers* workers, struct deque* files);
+static int azure_upload_file(char* local_root, char* azure_root, char* relative_path, struct workers* workers, struct deque* files);
+static int azure_put_blob(struct azure_file* file);
+static int azure_put_block(struct azure_file* file, int block);
+static int azure_put_block_list(struct azure_file* file);
+static int azure_send_request(char* azure_path, char* query, char* canonical_query, char* content_type,
+                              bool blob_type, void* data, size_t size);
+static int azure_add_request_headers(struct http_request* request, char* auth_value, char* utc_date, bool blob_type);
+static void azure_block_id(int block, char* id, size_t size);
+static int azure_read_block(char* path, off_t offset, size_t size, void** data);
+static void do_azure_upload(struct worker_common* wc);
 
 static char* azure_get_host(void);
+static int azure_get_port(void);
 static char* azure_get_basepath(int server, char* identifier);
 
 struct workflow*
@@ -109,6 +148,10 @@ azure_storage_execute(char* name __attribute__((unused)), struct art* nodes)
    char* local_root = NULL;
    char* base_dir = NULL;
    char* azure_root = NULL;
+   int number_of_workers = 0;
+   struct workers* workers = NULL;
+   struct deque* files = NULL;
+   struct deque_iterator* iter = NULL;
    struct main_configuration* config;
    struct backup* temp_backup = NULL;
 
@@ -136,11 +179,45 @@ azure_storage_execute(char* name __attribute__((unused)), struct art* nodes)
    base_dir = pgmoneta_get_server_backup(server);
    azure_root = azure_get_basepath(server, label);
 
-   if (azure_upload_files(local_root, azure_root, ""))
+   if (pgmoneta_deque_create(false, &files))
    {
       goto error;
    }
 
+   number_of_workers = pgmoneta_get_number_of_workers(server);
+   if (number_of_workers > 0)
+   {
+      pgmoneta_workers_initialize(number_of_workers, &workers);
+   }
+
+   if (azure_upload_files(local_root, azure_root, "", workers, files))
+   {
+      goto error;
+   }
+
+   pgmoneta_workers_wait(workers);
+   if (workers != NULL && !workers->outcome)
+   {
+      goto error;
+   }
+
+   /* Every block is staged, commit the block lists */
+   pgmoneta_deque_iterator_create(files, &iter);
+   while (pgmoneta_deque_iterator_next(iter))
+   {
+      struct azure_file* file = (struct azure_file*)pgmoneta_value_data(iter->value);
+
+      if (file->number_of_blocks > 0 && azure_put_block_list(file))
+      {
+         goto error;
+      }
+   }
+   pgmoneta_deque_iterator_destroy(iter);
+   iter = NULL;
+
+   pgmoneta_workers_destroy(workers);
+   workers = NULL;
+
 #ifdef HAVE_FREEBSD
    clock_gettime(CLOCK_MONOTONIC_FAST, &end_t);
 #else
@@ -160,7 +237,9 @@ azure_storage_execute(char* name __attribute__((unused)), struct art* nodes)
       goto error;
    }
 
+   pgmoneta_deque_destroy(files);
    free(temp_backup);
+   free(base_dir);
    free(local_root);
    free(azure_root);
 
@@ -168,6 +247,12 @@ azure_storage_execute(char* name __attribute__((unused)), struct art* nodes)
 
 error:
 
+   pgmoneta_deque_iterator_destroy(iter);
+   pgmoneta_workers_wait(workers);
+   pgmoneta_workers_destroy(workers);
+   pgmoneta_deque_destroy(files);
+   free(temp_backup);
+   free(base_dir);
    free(local_root);
    free(azure_root);
 
@@ -206,7 +291,7 @@ azure_storage_teardown(char* name __attribute__((unused)), struct art* nodes)
 }
 
 static int
-azure_upload_files(char* local_root, char* azure_root, char* relative_path)
+azure_upload_files(char* local_root, char* azure_root, char* relative_path, struct workers* workers, struct deque* files)
 {
    char* local_path = NULL;
    char* relative_file;
@@ -250,7 +335,10 @@ azure_upload_files(char* local_root, char* azure_root, char* relative_path)
             pgmoneta_snprintf(relative_dir, sizeof(relative_dir), "%s", entry->d_name);
          }
 
-         azure_upload_files(local_root, azure_root, relative_dir);
+         if (azure_upload_files(local_root, azure_root, relative_dir, workers, files))
+         {
+            goto error;
+         }
       }
       else
       {
@@ -265,7 +353,7 @@ azure_upload_files(char* local_root, char* azure_root, char* relative_path)
          }
          relative_file = pgmoneta_append(relative_file, entry->d_name);
 
-         if (azure_send_upload_request(local_root, azure_root, relative_file))
+         if (azure_upload_file(local_root, azure_root, relative_file, workers, files))
          {
             free(relative_file);
             goto error;
@@ -291,11 +379,12 @@ azure_upload_files(char* local_root, char* azure_root, char* relative_path)
 
       pgmoneta_permission(new_file, 6, 4, 4);
 
-      azure_send_upload_request(local_root, azure_root, relative_file);
-
       fflush(file);
       fclose(file);
 
+      /* The marker is removed right away, so it is not handed to the workers */
+      azure_upload_file(local_root, azure_root, relative_file, NULL, files);
+
       remove(new_file);
 
       free(new_file);
@@ -310,117 +399,389 @@ azure_upload_files(char* local_root, char* azure_root, char* relative_path)
 
 error:
 
-   closedir(dir);
+   if (dir != NULL)
+   {
+      closedir(dir);
+   }
 
    free(local_path);
 
    return 1;
 }
 
+/**
+ * Queue the upload of a file. A file up to azure_block_size is sent
+ * with one Put Blob, a larger file is staged with one Put Block per
+ * block and committed by azure_put_block_list() once all workers are done.
+ */
 static int
-azure_send_upload_request(char* local_root, char* azure_root, char* relative_path)
+azure_upload_file(char* local_root, char* azure_root, char* relative_path, struct workers* workers, struct deque* files)
 {
-   char utc_date[UTC_TIME_LENGTH];
-   char* string_to_sign = NULL;
-   char* signing_key = NULL;
-   char* base64_signature = NULL;
-   size_t base64_signature_length;
-   char* local_path = NULL;
-   char* azure_path = NULL;
-   char* azure_host = NULL;
-   char* auth_value = NULL;
-   unsigned char* signature_hmac = NULL;
-   int hmac_length = 0;
-   size_t signing_key_length = 0;
-   FILE* file = NULL;
-   struct stat file_info;
-   void* file_data = NULL;
-   struct http* connection = NULL;
-   struct http_request* request = NULL;
-   struct http_response* response = NULL;
+   struct azure_file* file = NULL;
+   struct azure_task* task = NULL;
+   struct stat st;
+   size_t block_size;
+   int number_of_tasks = 1;
    struct main_configuration* config;
-   char size_str[64];
-   char azure_put_path[MAX_PATH];
 
    config = (struct main_configuration*)shmem;
 
-   if (strchr(config->azure_storage_account, ' ') != NULL)
+   file = (struct azure_file*)malloc(sizeof(struct azure_file));
+   if (file == NULL)
    {
-      pgmoneta_log_error("Azure storage account name contains spaces: '%s'. This is not allowed.", config->azure_storage_account);
       goto error;
    }
 
-   local_path = pgmoneta_append(local_path, local_root);
+   memset(file, 0, sizeof(struct azure_file));
+
    if (strlen(relative_path) > 0)
    {
-      if (!pgmoneta_ends_with(local_root, "/"))
+      pgmoneta_snprintf(file->local_path, sizeof(file->local_path), "%s%s%s", local_root,
+                        pgmoneta_ends_with(local_root, "/") ? "" : "/", relative_path);
+      pgmoneta_snprintf(file->azure_path, sizeof(file->azure_path), "%s%s%s", azure_root,
+                        pgmoneta_ends_with(azure_root, "/") ? "" : "/", relative_path);
+   }
+   else
+   {
+      pgmoneta_snprintf(file->local_path, sizeof(file->local_path), "%s", local_root);
+      pgmoneta_snprintf(file->azure_path, sizeof(file->azure_path), "%s", azure_root);
+   }
+
+   if (stat(file->local_path, &st))
+   {
+      pgmoneta_log_error("Azure: Could not stat %s", file->local_path);
+      goto error;
+   }
+
+   file->size = (size_t)st.st_size;
+
+   block_size = (size_t)config->azure_block_size;
+   if (file->size > block_size)
+   {
+      /* Grow the blocks for files that would exceed the block limit */
+      if ((file->size + block_size - 1) / block_size > AZURE_MAX_BLOCKS)
       {
-         local_path = pgmoneta_append(local_path, "/");
+         block_size = (file->size + AZURE_MAX_BLOCKS - 1) / AZURE_MAX_BLOCKS;
       }
-      local_path = pgmoneta_append(local_path, relative_path);
+
+      file->block_size = block_size;
+      file->number_of_blocks = (int)((file->size + block_size - 1) / block_size);
+      number_of_tasks = file->number_of_blocks;
    }
 
-   azure_path = pgmoneta_append(azure_path, azure_root);
-   if (strlen(relative_path) > 0)
+   if (pgmoneta_deque_add(files, NULL, (uintptr_t)file, ValueMem))
+   {
+      goto error;
+   }
+
+   for (int i = 0; i < number_of_tasks; i++)
    {
-      if (!pgmoneta_ends_with(azure_root, "/"))
+      task = (struct azure_task*)malloc(sizeof(struct azure_task));
+      if (task == NULL)
+      {
+         return 1;
+      }
+
+      memset(task, 0, sizeof(struct azure_task));
+      task->common.workers = workers;
+      task->file = file;
+      task->block = file->number_of_blocks > 0 ? i : -1;
+
+      if (workers != NULL && workers->outcome)
       {
-         azure_path = pgmoneta_append(azure_path, "/");
+         if (pgmoneta_workers_add(workers, do_azure_upload, (struct worker_common*)task))
+         {
+            free(task);
+            return 1;
+         }
+      }
+      else
+      {
+         int ret = task->block >= 0 ? azure_put_block(file, task->block) : azure_put_blob(file);
+
+         free(task);
+
+         if (ret)
+         {
+            return 1;
+         }
       }
-      azure_path = pgmoneta_append(azure_path, relative_path);
    }
 
-   memset(&utc_date[0], 0, sizeof(utc_date));
+   return 0;
 
-   if (pgmoneta_get_timestamp_UTC_format(utc_date))
+error:
+
+   free(file);
+
+   return 1;
+}
+
+static void
+do_azure_upload(struct worker_common* wc)
+{
+   struct azure_task* task = (struct azure_task*)wc;
+   int ret;
+
+   if (task->block >= 0)
+   {
+      ret = azure_put_block(task->file, task->block);
+   }
+   else
+   {
+      ret = azure_put_blob(task->file);
+   }
+
+   if (ret && task->common.workers != NULL)
+   {
+      task->common.workers->outcome = false;
+   }
+
+   free(task);
+}
+
+static int
+azure_put_blob(struct azure_file* file)
+{
+   void* data = NULL;
+
+   if (file->size > 0 && azure_read_block(file->local_path, 0, file->size, &data))
    {
       goto error;
    }
 
-   file = fopen(local_path, "rb");
-   if (file == NULL)
+   if (azure_send_request(file->azure_path, NULL, NULL, "application/octet-stream", true, data, file->size))
    {
+      pgmoneta_log_error("Azure: Failed to upload %s", file->local_path);
       goto error;
    }
 
-   if (fstat(fileno(file), &file_info) != 0)
+   pgmoneta_log_debug("Azure: Uploaded %s", file->azure_path);
+
+   free(data);
+
+   return 0;
+
+error:
+
+   free(data);
+
+   return 1;
+}
+
+static int
+azure_put_block(struct azure_file* file, int block)
+{
+   char id[MISC_LENGTH];
+   char query[MISC_LENGTH];
+   char canonical_query[MISC_LENGTH];
+   size_t offset;
+   size_t length;
+   void* data = NULL;
+
+   offset = (size_t)block * file->block_size;
+   length = MIN(file->block_size, file->size - offset);
+
+   if (azure_read_block(file->local_path, (off_t)offset, length, &data))
    {
       goto error;
    }
 
-   file_data = malloc(file_info.st_size);
-   if (file_data == NULL)
+   azure_block_id(block, &id[0], sizeof(id));
+
+   pgmoneta_snprintf(&query[0], sizeof(query), "comp=block&blockid=%s", &id[0]);
+   pgmoneta_snprintf(&canonical_query[0], sizeof(canonical_query), "\nblockid:%s\ncomp:block", &id[0]);
+
+   if (azure_send_request(file->azure_path, &query[0], &canonical_query[0], "application/octet-stream", false, data, length))
    {
+      pgmoneta_log_error("Azure: Failed to upload block %d of %s", block, file->local_path);
       goto error;
    }
 
-   if (fread(file_data, 1, file_info.st_size, file) != (size_t)file_info.st_size)
+   free(data);
+
+   return 0;
+
+error:
+
+   free(data);
+
+   return 1;
+}
+
+static int
+azure_put_block_list(struct azure_file* file)
+{
+   char id[MISC_LENGTH];
+   char* xml = NULL;
+
+   xml = pgmoneta_append(xml, "<?xml version=\"1.0\" encoding=\"utf-8\"?><BlockList>");
+   for (int i = 0; i < file->number_of_blocks; i++)
    {
+      azure_block_id(i, &id[0], sizeof(id));
+
+      xml = pgmoneta_append(xml, "<Latest>");
+      xml = pgmoneta_append(xml, &id[0]);
+      xml = pgmoneta_append(xml, "</Latest>");
+   }
+   xml = pgmoneta_append(xml, "</BlockList>");
+
+   if (azure_send_request(file->azure_path, "comp=blocklist", "\ncomp:blocklist", "application/xml", false, xml, strlen(xml)))
+   {
+      pgmoneta_log_error("Azure: Failed to commit the block list of %s", file->local_path);
       goto error;
    }
 
-   fclose(file);
-   file = NULL;
+   pgmoneta_log_debug("Azure: Uploaded %s (%d blocks)", file->azure_path, file->number_of_blocks);
 
-   if (file_info.st_size == 0)
+   free(xml);
+
+   return 0;
+
+error:
+
+   free(xml);
+
+   return 1;
+}
+
+/**
+ * Block ids must have the same length within a blob, six digits
+ * encode to eight base64 characters without padding
+ */
+static void
+azure_block_id(int block, char* id, size_t size)
+{
+   char raw[8];
+   char* encoded = NULL;
+   size_t encoded_length = 0;
+
+   pgmoneta_snprintf(&raw[0], sizeof(raw), "%06d", block);
+
+   memset(id, 0, size);
+   if (!pgmoneta_base64_encode(&raw[0], 6, &encoded, &encoded_length))
    {
-      string_to_sign = pgmoneta_append(string_to_sign, "PUT\n\n\n\n\napplication/octet-stream\n\n\n\n\n\n\nx-ms-blob-type:BlockBlob\nx-ms-date:");
+      pgmoneta_snprintf(id, size, "%s", encoded);
    }
-   else
+
+   free(encoded);
+}
+
+static int
+azure_read_block(char* path, off_t offset, size_t size, void** data)
+{
+   int fd = -1;
+   size_t total = 0;
+   ssize_t r;
+   char* d = NULL;
+
+   *data = NULL;
+
+   d = (char*)malloc(size);
+   if (d == NULL)
    {
-      string_to_sign = pgmoneta_append(string_to_sign, "PUT\n\n\n");
-      pgmoneta_snprintf(size_str, sizeof(size_str), "%ld", (long)file_info.st_size);
-      string_to_sign = pgmoneta_append(string_to_sign, size_str);
-      string_to_sign = pgmoneta_append(string_to_sign, "\n\napplication/octet-stream\n\n\n\n\n\n\nx-ms-blob-type:BlockBlob\nx-ms-date:");
+      goto error;
+   }
+
+   fd = open(path, O_RDONLY);
+   if (fd < 0)
+   {
+      goto error;
+   }
+
+   while (total < size)
+   {
+      r = pread(fd, d + total, size - total, offset + (off_t)total);
+      if (r <= 0)
+      {
+         goto error;
+      }
+      total += (size_t)r;
+   }
+
+   close(fd);
+
+   *data = d;
+
+   return 0;
+
+error:
+
+   pgmoneta_log_error("Azure: Could not read %s", path);
+
+   if (fd >= 0)
+   {
+      close(fd);
    }
 
+   free(d);
+
+   return 1;
+}
+
+static int
+azure_send_request(char* azure_path, char* query, char* canonical_query, char* content_type,
+                   bool blob_type, void* data, size_t size)
+{
+   char utc_date[UTC_TIME_LENGTH];
+   char* string_to_sign = NULL;
+   char* signing_key = NULL;
+   char* base64_signature = NULL;
+   size_t base64_signature_length;
+   char* azure_host = NULL;
+   char* auth_value = NULL;
+   unsigned char* signature_hmac = NULL;
+   int hmac_length = 0;
+   size_t signing_key_length = 0;
+   struct http* connection = NULL;
+   struct http_request* request = NULL;
+   struct http_response* response = NULL;
+   struct main_configuration* config;
+   char size_str[64];
+   char azure_put_path[MAX_PATH];
+
+   config = (struct main_configuration*)shmem;
+
+   if (strchr(config->azure_storage_account, ' ') != NULL)
+   {
+      pgmoneta_log_error("Azure storage account name contains spaces: '%s'. This is not allowed.", config->azure_storage_account);
+      goto error;
+   }
+
+   pgmoneta_throttle(THROTTLE_UPLOAD, size);
+
+   memset(&utc_date[0], 0, sizeof(utc_date));
+
+   if (pgmoneta_get_timestamp_UTC_format(utc_date))
+   {
+      goto error;
+   }
+
+   string_to_sign = pgmoneta_append(string_to_sign, "PUT\n\n\n");
+   if (size > 0)
+   {
+      pgmoneta_snprintf(size_str, sizeof(size_str), "%zu", size);
+      string_to_sign = pgmoneta_append(string_to_sign, size_str);
+   }
+   string_to_sign = pgmoneta_append(string_to_sign, "\n\n");
+   string_to_sign = pgmoneta_append(string_to_sign, content_type);
+   string_to_sign = pgmoneta_append(string_to_sign, "\n\n\n\n\n\n\n");
+   if (blob_type)
+   {
+      string_to_sign = pgmoneta_append(string_to_sign, "x-ms-blob-type:BlockBlob\n");
+   }
+   string_to_sign = pgmoneta_append(string_to_sign, "x-ms-date:");
    string_to_sign = pgmoneta_append(string_to_sign, utc_date);
-   string_to_sign = pgmoneta_append(string_to_sign, "\nx-ms-version:2021-08-06\n/");
+   string_to_sign = pgmoneta_append(string_to_sign, "\nx-ms-version:" AZURE_VERSION "\n/");
    string_to_sign = pgmoneta_append(string_to_sign, config->azure_storage_account);
    string_to_sign = pgmoneta_append(string_to_sign, "/");
    string_to_sign = pgmoneta_append(string_to_sign, config->azure_container);
    string_to_sign = pgmoneta_append(string_to_sign, "/");
    string_to_sign = pgmoneta_append(string_to_sign, azure_path);
+   if (canonical_query != NULL)
+   {
+      string_to_sign = pgmoneta_append(string_to_sign, canonical_query);
+   }
 
    if (pgmoneta_base64_decode(config->azure_shared_key, strlen(config->azure_shared_key), (void**)&signing_key, &signing_key_length))
    {
@@ -444,70 +805,60 @@ azure_send_upload_request(char* local_root, char* azure_root, char* relative_pat
 
    azure_host = azure_get_host();
 
-   if (pgmoneta_http_create(azure_host, 443, true, &connection))
+   if (pgmoneta_http_create(azure_host, azure_get_port(), config->azure_use_tls, &connection))
    {
       pgmoneta_log_error("Failed to connect to Azure host: %s", azure_host);
       goto error;
    }
 
-   pgmoneta_snprintf(azure_put_path, sizeof(azure_put_path), "/%s/%s", config->azure_container, azure_path);
+   if (query != NULL)
+   {
+      pgmoneta_snprintf(azure_put_path, sizeof(azure_put_path), "/%s/%s?%s", config->azure_container, azure_path, query);
+   }
+   else
+   {
+      pgmoneta_snprintf(azure_put_path, sizeof(azure_put_path), "/%s/%s", config->azure_container, azure_path);
+   }
 
    if (pgmoneta_http_request_create(PGMONETA_HTTP_PUT, azure_put_path, &request))
    {
       goto error;
    }
 
-   if (azure_add_request_headers(request, auth_value, utc_date))
+   if (azure_add_request_headers(request, auth_value, utc_date, blob_type))
    {
       goto error;
    }
 
-   if (pgmoneta_http_request_add_header(request, "Content-Type", "application/octet-stream"))
+   if (pgmoneta_http_request_add_header(request, "Content-Type", content_type))
    {
       goto error;
    }
 
-   if (pgmoneta_http_set_data(request, file_data, file_info.st_size))
+   if (pgmoneta_http_set_data(request, data, size))
    {
       goto error;
    }
 
    if (pgmoneta_http_invoke(connection, request, &response))
    {
-      pgmoneta_log_error("Failed to execute HTTP PUT request for %s", local_path);
+      pgmoneta_log_error("Failed to execute HTTP PUT request for %s", azure_path);
       goto error;
    }
 
-   if (response->status_code >= 200 && response->status_code < 300)
+   if (response->status_code < 200 || response->status_code >= 300)
    {
-      char* azure_url = NULL;
-      azure_url = pgmoneta_append(azure_url, "https://");
-      azure_url = pgmoneta_append(azure_url, azure_host);
-      azure_url = pgmoneta_append(azure_url, "/");
-      azure_url = pgmoneta_append(azure_url, config->azure_container);
-      azure_url = pgmoneta_append(azure_url, "/");
-      azure_url = pgmoneta_append(azure_url, azure_path);
-
-      pgmoneta_log_info("Successfully uploaded file to URL: %s", azure_url);
-      free(azure_url);
-   }
-   else
-   {
-      pgmoneta_log_error("Azure upload failed with status code: %d. Failed to upload: %s to Azure path: %s. Azure container: %s, host: %s",
-                         response->status_code, local_path, azure_path,
-                         config->azure_container, azure_host);
+      pgmoneta_log_error("Azure upload failed with status code: %d. Azure path: %s. Azure container: %s, host: %s",
+                         response->status_code, azure_path, config->azure_container, azure_host);
       goto error;
    }
 
-   free(local_path);
-   free(azure_path);
    free(azure_host);
    free(base64_signature);
    free(signature_hmac);
    free(string_to_sign);
    free(auth_value);
    free(signing_key);
-   free(file_data);
 
    pgmoneta_http_request_destroy(request);
    pgmoneta_http_response_destroy(response);
@@ -517,50 +868,12 @@ azure_send_upload_request(char* local_root, char* azure_root, char* relative_pat
 
 error:
 
-   if (local_path != NULL)
-   {
-      free(local_path);
-   }
-
-   if (azure_path != NULL)
-   {
-      free(azure_path);
-   }
-
-   if (azure_host != NULL)
-   {
-      free(azure_host);
-   }
-
-   if (signing_key != NULL)
-   {
-      free(signing_key);
-   }
-
-   if (base64_signature != NULL)
-   {
-      free(base64_signature);
-   }
-
-   if (signature_hmac != NULL)
-   {
-      free(signature_hmac);
-   }
-
-   if (string_to_sign != NULL)
-   {
-      free(string_to_sign);
-   }
-
-   if (auth_value != NULL)
-   {
-      free(auth_value);
-   }
-
-   if (file_data != NULL)
-   {
-      free(file_data);
-   }
+   free(azure_host);
+   free(signing_key);
+   free(base64_signature);
+   free(signature_hmac);
+   free(string_to_sign);
+   free(auth_value);
 
    if (connection != NULL)
    {
@@ -577,11 +890,6 @@ error:
       pgmoneta_http_response_destroy(response);
    }
 
-   if (file != NULL)
-   {
-      fclose(file);
-   }
-
    return 1;
 }
 
@@ -593,12 +901,32 @@ azure_get_host()
 
    config = (struct main_configuration*)shmem;
 
+   if (strlen(config->azure_endpoint) > 0)
+   {
+      return pgmoneta_append(host, config->azure_endpoint);
+   }
+
    host = pgmoneta_append(host, config->azure_storage_account);
    host = pgmoneta_append(host, ".blob.core.windows.net");
 
    return host;
 }
 
+static int
+azure_get_port(void)
+{
+   struct main_configuration* config;
+
+   config = (struct main_configuration*)shmem;
+
+   if (config->azure_port > 0)
+   {
+      return config->azure_port;
+   }
+
+   return config->azure_use_tls ? 443 : 80;
+}
+
 static char*
 azure_get_basepath(int server, char* identifier)
 {
@@ -620,14 +948,14 @@ azure_get_basepath(int server, char* identifier)
 }
 
 static int
-azure_add_request_headers(struct http_request* request, char* auth_value, char* utc_date)
+azure_add_request_headers(struct http_request* request, char* auth_value, char* utc_date, bool blob_type)
 {
    if (pgmoneta_http_request_add_header(request, "Authorization", auth_value))
    {
       return 1;
    }
 
-   if (pgmoneta_http_request_add_header(request, "x-ms-blob-type", "BlockBlob"))
+   if (blob_type && pgmoneta_http_request_add_header(request, "x-ms-blob-type", "BlockBlob"))
    {
       return 1;
    }
@@ -637,7 +965,7 @@ azure_add_request_headers(struct http_request* request, char* auth_value, char*
       return 1;
    }
 
-   if (pgmoneta_http_request_add_header(request, "x-ms-version", "2021-08-06"))
+   if (pgmoneta_http_request_add_header(request, "x-ms-version", AZURE_VERSION))
    {
       return 1;
    }
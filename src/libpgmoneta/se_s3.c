@@ -38,17 +38,26 @@
 #include <manifest.h>
 #include <progress.h>
 #include <security.h>
+#include <storage.h>
 #include <utils.h>
 #include <value.h>
+#include <walbundle.h>
+#include <workers.h>
 #include <workflow.h>
 
 /* system */
 #include <assert.h>
 #include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdatomic.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 static char* s3_backup_name(void);
 static char* s3_restore_name(void);
@@ -81,6 +90,8 @@ static int s3_apply_signed_headers(struct http_request* request, struct deque* h
 
 static char* s3_get_host(int server);
 static char* s3_get_basepath(int server, char* identifier);
+static char* s3_get_walpath(int server);
+static char* s3_get_server_path(int server);
 static char* s3_url_encode(char* str);
 static int xml_parse_s3_delete_result(char* xml, bool* has_fatal_error);
 static int xml_s3_build_delete_key(char** xml, char* key);
@@ -100,7 +111,41 @@ struct s3_transfer_task
    char file_sha512[MISC_LENGTH];
 };
 
+/**
+ * An object fetched with ranged GETs. The ranges are claimed in order by
+ * lanes running on the download workers, and the last lane to finish
+ * closes the file.
+ */
+struct s3_download
+{
+   struct s3_transfer_task task;    /**< A copy of the object task */
+   char* path;                      /**< The local file */
+   int fd;                          /**< The preallocated local file */
+   size_t total;                    /**< The size of the object */
+   size_t part_size;                /**< The size of a range */
+   int number_of_ranges;            /**< The number of ranges after the first part */
+   atomic_int next;                 /**< The next range to claim */
+   atomic_int lanes;                /**< The number of lanes still running */
+   atomic_bool failed;              /**< Has a range failed */
+};
+
+/**
+ * A lane of ranged GETs of a large object
+ */
+struct s3_range_task
+{
+   struct worker_common common;     /**< The common worker data */
+   struct s3_download* download;    /**< The object */
+};
+
+#define S3_RANGE_RETRIES 3
+
 static void do_download_file(struct worker_common* wc);
+static void do_download_range(struct worker_common* wc);
+static int s3_download_range(struct s3_transfer_task* task, int fd, size_t offset, size_t length, size_t* total, bool* complete);
+static int s3_download_lane(struct s3_download* download);
+static int s3_download_finish(struct s3_download* download);
+static int s3_write_at(int fd, void* data, size_t size, size_t offset);
 static void do_upload_file(struct worker_common* wc);
 static int s3_create_transfer_task(int server, char* s3_root, char* remote_path,
                                    char* local_root, char* local_path, char* file_sha512,
@@ -108,6 +153,18 @@ static int s3_create_transfer_task(int server, char* s3_root, char* remote_path,
 static int s3_upload_one_file(struct s3_transfer_task* task);
 static int s3_download_one_file(struct s3_transfer_task* task);
 
+#define S3_WAL_BUNDLE_STATE "wal.bundle"
+#define S3_DELETE_MAX_KEYS 1000
+
+static char* s3_wal_state_path(int server);
+static int s3_wal_read_state(int server, char* last, size_t size);
+static int s3_wal_write_state(int server, char* last);
+static int s3_wal_files(char* wal_dir, char* suffix, char* last, struct deque** segments, struct deque** histories);
+static int s3_wal_upload_bundle(int server, char* wal_dir, char* wal_root, struct deque* segments);
+static int s3_wal_get_range(int server, char* wal_root, char* key, long start, long end, struct http_response** response);
+static int s3_wal_bundles(int server, char* wal_root, struct deque** bundles);
+static int s3_wal_fetch(int server, char* wal_root, char* bundle, char* segment, char* start, char* directory, int* fetched);
+
 struct workflow*
 pgmoneta_storage_create_s3(int workflow_type)
 {
@@ -573,6 +630,7 @@ s3_storage_restore(char* name __attribute__((unused)), struct art* nodes)
    char* sha512_final = NULL;
    char* info_tmp = NULL;
    char* info_final = NULL;
+   char* wal_dir = NULL;
    struct backup* backup = NULL;
    struct main_configuration* config;
 
@@ -643,6 +701,17 @@ s3_storage_restore(char* name __attribute__((unused)), struct art* nodes)
       goto error;
    }
 
+   /* The WAL after the backup comes from the WAL bundles */
+   if (config->wal_bundle_size > 0)
+   {
+      wal_dir = pgmoneta_get_server_wal(server);
+
+      if (pgmoneta_s3_wal_restore(server, backup->wal, wal_dir))
+      {
+         pgmoneta_log_warn("S3 restore: could not restore WAL for %s/%s", config->common.servers[server].name, label);
+      }
+   }
+
    pgmoneta_log_info("S3 restore: %s/%s completed", config->common.servers[server].name, label);
 
    free(s3_root);
@@ -655,6 +724,7 @@ s3_storage_restore(char* name __attribute__((unused)), struct art* nodes)
    free(sha512_final);
    free(info_tmp);
    free(info_final);
+   free(wal_dir);
 
    return 0;
 
@@ -696,6 +766,7 @@ error:
    free(sha512_final);
    free(info_tmp);
    free(info_final);
+   free(wal_dir);
    return 1;
 }
 
@@ -990,186 +1061,1405 @@ s3_download_files(char* s3_root, char* local_root, int server, int compression,
       local_file_path = NULL;
    }
 
-   pgmoneta_workers_wait(workers);
-   if (workers != NULL && !workers->outcome)
-   {
-      goto error;
+   pgmoneta_workers_wait(workers);
+   if (workers != NULL && !workers->outcome)
+   {
+      goto error;
+   }
+   pgmoneta_workers_destroy(workers);
+
+   pgmoneta_deque_iterator_destroy(iter);
+   pgmoneta_deque_destroy(paths);
+   free(manifest_path);
+   free(suffix);
+
+   return 0;
+
+error:
+
+   pgmoneta_deque_iterator_destroy(iter);
+   pgmoneta_deque_destroy(paths);
+   pgmoneta_workers_wait(workers);
+   pgmoneta_workers_destroy(workers);
+   free(manifest_path);
+   free(suffix);
+   free(filename);
+   free(s3_path);
+   free(local_file_path);
+   free(task);
+
+   return 1;
+}
+
+static int
+s3_create_transfer_task(int server, char* s3_root, char* remote_path,
+                        char* local_root, char* local_path, char* file_sha512,
+                        struct workers* workers, struct s3_transfer_task** task)
+{
+   struct s3_transfer_task* t = NULL;
+
+   *task = NULL;
+
+   if (s3_root == NULL || remote_path == NULL || local_path == NULL)
+   {
+      goto error;
+   }
+
+   if (strlen(s3_root) >= MAX_PATH || strlen(remote_path) >= MAX_PATH || strlen(local_path) >= MAX_PATH)
+   {
+      pgmoneta_log_error("S3 transfer path too long");
+      goto error;
+   }
+
+   if (local_root != NULL && strlen(local_root) >= MAX_PATH)
+   {
+      pgmoneta_log_error("S3 local root path too long");
+      goto error;
+   }
+
+   if (file_sha512 != NULL && strlen(file_sha512) >= MISC_LENGTH)
+   {
+      pgmoneta_log_error("S3 sha512 value too long");
+      goto error;
+   }
+
+   t = (struct s3_transfer_task*)malloc(sizeof(struct s3_transfer_task));
+   if (t == NULL)
+   {
+      goto error;
+   }
+
+   memset(t, 0, sizeof(struct s3_transfer_task));
+   pgmoneta_snprintf(t->s3_root, sizeof(t->s3_root), "%s", s3_root);
+   pgmoneta_snprintf(t->remote_path, sizeof(t->remote_path), "%s", remote_path);
+   pgmoneta_snprintf(t->local_path, sizeof(t->local_path), "%s", local_path);
+   if (local_root != NULL)
+   {
+      pgmoneta_snprintf(t->local_root, sizeof(t->local_root), "%s", local_root);
+   }
+   if (file_sha512 != NULL)
+   {
+      pgmoneta_snprintf(t->file_sha512, sizeof(t->file_sha512), "%s", file_sha512);
+   }
+
+   t->common.workers = workers;
+   t->server = server;
+   t->progress_enabled = (server >= 0 && pgmoneta_is_progress_enabled(server));
+
+   *task = t;
+
+   return 0;
+
+error:
+   free(t);
+   return 1;
+}
+
+/**
+ * Download an object. The first part tells the size of the object, the
+ * remaining parts are fetched by up to s3_download_concurrency lanes.
+ * The extra lanes are queued on the workers that download the files, so
+ * the number of GETs in flight never exceeds the number of workers.
+ */
+static int
+s3_download_one_file(struct s3_transfer_task* task)
+{
+   char* full_local = NULL;
+   char* parent_dir = NULL;
+   int fd = -1;
+   int lanes = 1;
+   bool complete = false;
+   size_t part_size = 0;
+   size_t total = 0;
+   struct s3_download* download = NULL;
+   struct main_configuration* config;
+
+   config = (struct main_configuration*)shmem;
+
+   full_local = pgmoneta_append(full_local, task->local_root);
+   full_local = pgmoneta_append(full_local, task->local_path);
+
+   parent_dir = pgmoneta_get_parent_dir(full_local);
+   if (parent_dir == NULL || pgmoneta_mkdir(parent_dir))
+   {
+      goto error;
+   }
+
+   fd = open(full_local, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+   if (fd < 0)
+   {
+      pgmoneta_log_error("S3 download: failed to create %s: %s", full_local, strerror(errno));
+      goto error;
+   }
+
+   part_size = (size_t)config->s3_part_size;
+
+   if (s3_download_range(task, fd, 0, part_size, &total, &complete))
+   {
+      goto error;
+   }
+
+   if (!complete && total > part_size && ftruncate(fd, (off_t)total))
+   {
+      pgmoneta_log_error("S3 download: failed to allocate %s: %s", full_local, strerror(errno));
+      goto error;
+   }
+
+   download = (struct s3_download*)malloc(sizeof(struct s3_download));
+   if (download == NULL)
+   {
+      goto error;
+   }
+
+   memset(download, 0, sizeof(struct s3_download));
+   memcpy(&download->task, task, sizeof(struct s3_transfer_task));
+   download->path = full_local;
+   download->fd = fd;
+   download->total = total;
+   download->part_size = part_size;
+   /* A server that ignores the range sends the complete object at once */
+   download->number_of_ranges = !complete && total > part_size ? (int)((total - part_size + part_size - 1) / part_size) : 0;
+
+   if (task->common.workers != NULL && download->number_of_ranges > 1)
+   {
+      lanes = MIN(config->s3_download_concurrency, download->number_of_ranges);
+   }
+
+   atomic_init(&download->next, 0);
+   atomic_init(&download->lanes, lanes);
+   atomic_init(&download->failed, false);
+
+   full_local = NULL;
+   fd = -1;
+
+   for (int i = 1; i < lanes; i++)
+   {
+      struct s3_range_task* range = NULL;
+
+      range = (struct s3_range_task*)malloc(sizeof(struct s3_range_task));
+      if (range != NULL)
+      {
+         memset(range, 0, sizeof(struct s3_range_task));
+         range->common.workers = task->common.workers;
+         range->download = download;
+      }
+
+      if (range == NULL || pgmoneta_workers_add(task->common.workers, do_download_range, (struct worker_common*)range))
+      {
+         /* The lanes that run take over the remaining ranges */
+         free(range);
+         atomic_fetch_sub(&download->lanes, lanes - i);
+         break;
+      }
+   }
+
+   free(parent_dir);
+
+   /* This worker is a lane too, so the download progresses without free workers */
+   return s3_download_lane(download);
+
+error:
+
+   if (fd >= 0)
+   {
+      close(fd);
+   }
+
+   if (full_local != NULL)
+   {
+      unlink(full_local);
+   }
+
+   free(parent_dir);
+   free(full_local);
+
+   return 1;
+}
+
+/**
+ * Claim and fetch ranges until none are left. The last lane finishes
+ * the download and returns its outcome, the other lanes return 0.
+ */
+static int
+s3_download_lane(struct s3_download* download)
+{
+   int i;
+   size_t offset;
+   size_t length;
+
+   while (!atomic_load(&download->failed))
+   {
+      i = atomic_fetch_add(&download->next, 1);
+      if (i >= download->number_of_ranges)
+      {
+         break;
+      }
+
+      offset = download->part_size * (size_t)(i + 1);
+      length = MIN(download->part_size, download->total - offset);
+
+      if (s3_download_range(&download->task, download->fd, offset, length, NULL, NULL))
+      {
+         atomic_store(&download->failed, true);
+      }
+   }
+
+   if (atomic_fetch_sub(&download->lanes, 1) != 1)
+   {
+      return 0;
+   }
+
+   return s3_download_finish(download);
+}
+
+static int
+s3_download_finish(struct s3_download* download)
+{
+   int ret = 0;
+
+   if (close(download->fd) || atomic_load(&download->failed))
+   {
+      unlink(download->path);
+      ret = 1;
+   }
+   else
+   {
+      if (download->task.progress_enabled)
+      {
+         pgmoneta_progress_increment(download->task.server, 1);
+      }
+
+      pgmoneta_log_debug("S3 download: %s (%zu bytes, %d ranges)", download->task.remote_path,
+                         download->total, download->number_of_ranges + 1);
+   }
+
+   free(download->path);
+   free(download);
+
+   return ret;
+}
+
+/**
+ * Fetch a range of an object and write it at its offset. The total
+ * size of the object is returned when requested, and whether the
+ * response already was the complete object.
+ */
+static int
+s3_download_range(struct s3_transfer_task* task, int fd, size_t offset, size_t length, size_t* total, bool* complete)
+{
+   struct http_response* response = NULL;
+   char* content_range = NULL;
+   char* slash = NULL;
+   size_t expected = 0;
+
+   for (int attempt = 0; attempt < S3_RANGE_RETRIES; attempt++)
+   {
+      if (attempt > 0)
+      {
+         pgmoneta_log_debug("S3 download: retrying %s at %zu (%d)", task->remote_path, offset, attempt);
+         SLEEP(250000000L * attempt);
+      }
+
+      pgmoneta_http_response_destroy(response);
+      response = NULL;
+
+      if (s3_send_get_request(task->remote_path, task->s3_root, task->server,
+                              (long)offset, (long)(offset + length - 1), &response))
+      {
+         continue;
+      }
+
+      if (response->status_code == 200 && offset == 0)
+      {
+         /* The whole object, either small or the range was ignored */
+         expected = response->payload.data_size;
+         if (total != NULL)
+         {
+            *total = expected;
+         }
+         if (complete != NULL)
+         {
+            *complete = true;
+         }
+      }
+      else if (response->status_code == 416 && offset == 0 && total != NULL)
+      {
+         /* An empty object has no satisfiable range */
+         *total = 0;
+         pgmoneta_http_response_destroy(response);
+
+         return 0;
+      }
+      else if (response->status_code == 206)
+      {
+         expected = length;
+
+         if (total != NULL)
+         {
+            content_range = pgmoneta_http_get_response_header(response, "Content-Range");
+            if (content_range == NULL)
+            {
+               content_range = pgmoneta_http_get_response_header(response, "content-range");
+            }
+
+            slash = content_range != NULL ? strrchr(content_range, '/') : NULL;
+            if (slash == NULL || *(slash + 1) == '*')
+            {
+               pgmoneta_log_error("S3 download: %s has no object size", task->remote_path);
+               goto error;
+            }
+
+            *total = (size_t)strtoull(slash + 1, NULL, 10);
+            expected = MIN(length, *total);
+         }
+      }
+      else if (response->status_code >= 400 && response->status_code < 500 && response->status_code != 408 &&
+               response->status_code != 429)
+      {
+         pgmoneta_log_error("S3 download: %s returned status %d", task->remote_path, response->status_code);
+         goto error;
+      }
+      else
+      {
+         continue;
+      }
+
+      if (response->payload.data_size != expected)
+      {
+         continue;
+      }
+
+      pgmoneta_throttle(THROTTLE_DOWNLOAD, response->payload.data_size);
+
+      if (s3_write_at(fd, response->payload.data, response->payload.data_size, offset))
+      {
+         pgmoneta_log_error("S3 download: failed to write %s", task->local_path);
+         goto error;
+      }
+
+      pgmoneta_http_response_destroy(response);
+
+      return 0;
+   }
+
+   pgmoneta_log_error("S3 download: failed to GET %s at %zu", task->remote_path, offset);
+
+error:
+
+   pgmoneta_http_response_destroy(response);
+
+   return 1;
+}
+
+static int
+s3_write_at(int fd, void* data, size_t size, size_t offset)
+{
+   size_t written = 0;
+   ssize_t w;
+
+   while (written < size)
+   {
+      w = pwrite(fd, (char*)data + written, size - written, (off_t)(offset + written));
+      if (w < 0)
+      {
+         if (errno == EINTR)
+         {
+            continue;
+         }
+         return 1;
+      }
+      written += (size_t)w;
+   }
+
+   return 0;
+}
+
+static void
+do_download_range(struct worker_common* wc)
+{
+   struct s3_range_task* range = (struct s3_range_task*)wc;
+
+   if (s3_download_lane(range->download) && range->common.workers != NULL)
+   {
+      range->common.workers->outcome = false;
+   }
+
+   free(range);
+}
+
+static void
+do_download_file(struct worker_common* wc)
+{
+   struct s3_transfer_task* task = (struct s3_transfer_task*)wc;
+
+   if (s3_download_one_file(task) && task->common.workers != NULL)
+   {
+      task->common.workers->outcome = false;
+   }
+
+   free(task);
+}
+
+static int
+s3_upload_one_file(struct s3_transfer_task* task)
+{
+   if (s3_send_upload_request(task->local_root, task->s3_root, task->remote_path,
+                              strlen(task->file_sha512) > 0 ? task->file_sha512 : NULL, task->server))
+   {
+      pgmoneta_log_error("S3 upload: failed %s", task->remote_path);
+      return 1;
+   }
+
+   if (task->progress_enabled)
+   {
+      pgmoneta_progress_increment(task->server, 1);
+   }
+
+   return 0;
+}
+
+static void
+do_upload_file(struct worker_common* wc)
+{
+   struct s3_transfer_task* task = (struct s3_transfer_task*)wc;
+
+   if (s3_upload_one_file(task) && task->common.workers != NULL)
+   {
+      task->common.workers->outcome = false;
+   }
+
+   free(task);
+}
+
+int
+pgmoneta_s3_wal_bundle(int server)
+{
+   char last[MISC_LENGTH];
+   char path[MAX_PATH];
+   char* suffix = NULL;
+   char* wal_dir = NULL;
+   char* wal_root = NULL;
+   uint64_t pending = 0;
+   time_t oldest = 0;
+   int64_t timeout = 0;
+   int number_of_bundles = 0;
+   struct stat st;
+   struct deque* segments = NULL;
+   struct deque* histories = NULL;
+   struct deque* bundle = NULL;
+   struct deque_iterator* it = NULL;
+   struct main_configuration* config;
+
+   config = (struct main_configuration*)shmem;
+
+   if (config->wal_bundle_size == 0)
+   {
+      return 0;
+   }
+
+   memset(&last[0], 0, sizeof(last));
+   s3_wal_read_state(server, &last[0], sizeof(last));
+
+   if (pgmoneta_extraction_get_suffix(config->compression_type, config->common.encryption, &suffix))
+   {
+      goto error;
+   }
+
+   wal_dir = pgmoneta_get_server_wal(server);
+   wal_root = s3_get_walpath(server);
+   timeout = pgmoneta_time_convert(config->wal_bundle_timeout, FORMAT_TIME_S);
+
+   if (s3_wal_files(wal_dir, suffix != NULL ? suffix : "", &last[0], &segments, &histories))
+   {
+      goto error;
+   }
+
+   if (pgmoneta_deque_create(false, &bundle) || pgmoneta_deque_iterator_create(segments, &it))
+   {
+      goto error;
+   }
+
+   while (pgmoneta_deque_iterator_next(it))
+   {
+      pgmoneta_snprintf(path, sizeof(path), "%s/%s", wal_dir, it->tag);
+      if (stat(path, &st))
+      {
+         continue;
+      }
+
+      pgmoneta_deque_add(bundle, it->tag, (uintptr_t)it->tag, ValueString);
+      pending += (uint64_t)st.st_size;
+      if (oldest == 0 || st.st_mtime < oldest)
+      {
+         oldest = st.st_mtime;
+      }
+
+      if (pending >= config->wal_bundle_size)
+      {
+         if (s3_wal_upload_bundle(server, wal_dir, wal_root, bundle))
+         {
+            goto error;
+         }
+
+         number_of_bundles++;
+         pgmoneta_deque_destroy(bundle);
+         bundle = NULL;
+         pending = 0;
+         oldest = 0;
+
+         if (pgmoneta_deque_create(false, &bundle))
+         {
+            goto error;
+         }
+      }
+   }
+
+   /* A quiet server still ships its WAL once the oldest segment is old enough */
+   if (!pgmoneta_deque_empty(bundle) && timeout > 0 && time(NULL) - oldest >= timeout)
+   {
+      if (s3_wal_upload_bundle(server, wal_dir, wal_root, bundle))
+      {
+         goto error;
+      }
+
+      number_of_bundles++;
+   }
+
+   /* Timeline history files are small and rare, so they are kept as plain objects */
+   if (number_of_bundles > 0)
+   {
+      pgmoneta_deque_iterator_destroy(it);
+      it = NULL;
+
+      if (pgmoneta_deque_iterator_create(histories, &it))
+      {
+         goto error;
+      }
+
+      while (pgmoneta_deque_iterator_next(it))
+      {
+         if (s3_send_upload_request(wal_dir, wal_root, it->tag, NULL, server))
+         {
+            pgmoneta_log_warn("S3 WAL: could not upload %s", it->tag);
+         }
+      }
+   }
+
+   pgmoneta_deque_iterator_destroy(it);
+   pgmoneta_deque_destroy(segments);
+   pgmoneta_deque_destroy(histories);
+   pgmoneta_deque_destroy(bundle);
+   free(suffix);
+   free(wal_dir);
+   free(wal_root);
+
+   return 0;
+
+error:
+
+   pgmoneta_deque_iterator_destroy(it);
+   pgmoneta_deque_destroy(segments);
+   pgmoneta_deque_destroy(histories);
+   pgmoneta_deque_destroy(bundle);
+   free(suffix);
+   free(wal_dir);
+   free(wal_root);
+
+   return 1;
+}
+
+int
+pgmoneta_s3_wal_get(int server, char* segment, char* directory)
+{
+   char path[MAX_PATH];
+   int fd = -1;
+   int fetched = 0;
+   char* wal_root = NULL;
+   struct deque* bundles = NULL;
+   struct deque_iterator* it = NULL;
+   struct http_response* response = NULL;
+
+   memset(&path[0], 0, sizeof(path));
+
+   wal_root = s3_get_walpath(server);
+
+   if (segment == NULL || pgmoneta_mkdir(directory))
+   {
+      goto error;
+   }
+
+   /* Timeline history files are plain objects */
+   if (pgmoneta_ends_with(segment, ".history"))
+   {
+      if (s3_wal_get_range(server, wal_root, segment, -1, -1, &response))
+      {
+         goto error;
+      }
+
+      pgmoneta_snprintf(path, sizeof(path), "%s/%s", directory, segment);
+      fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+      if (fd < 0)
+      {
+         pgmoneta_log_error("S3 WAL: failed to create %s: %s", path, strerror(errno));
+         goto error;
+      }
+
+      if (s3_write_at(fd, response->payload.data, response->payload.data_size, 0) || fsync(fd))
+      {
+         goto error;
+      }
+
+      close(fd);
+      fd = -1;
+
+      fetched = 1;
+   }
+   else
+   {
+      if (s3_wal_bundles(server, wal_root, &bundles) || pgmoneta_deque_iterator_create(bundles, &it))
+      {
+         goto error;
+      }
+
+      while (fetched == 0 && pgmoneta_deque_iterator_next(it))
+      {
+         if (pgmoneta_wal_bundle_covers(it->tag, segment) &&
+             s3_wal_fetch(server, wal_root, it->tag, segment, NULL, directory, &fetched))
+         {
+            goto error;
+         }
+      }
+   }
+
+   if (fetched == 0)
+   {
+      pgmoneta_log_debug("S3 WAL: %s not found", segment);
+      goto error;
+   }
+
+   pgmoneta_http_response_destroy(response);
+   pgmoneta_deque_iterator_destroy(it);
+   pgmoneta_deque_destroy(bundles);
+   free(wal_root);
+
+   return 0;
+
+error:
+
+   if (fd >= 0)
+   {
+      close(fd);
+      unlink(path);
+   }
+
+   pgmoneta_http_response_destroy(response);
+   pgmoneta_deque_iterator_destroy(it);
+   pgmoneta_deque_destroy(bundles);
+   free(wal_root);
+
+   return 1;
+}
+
+int
+pgmoneta_s3_wal_restore(int server, char* start, char* directory)
+{
+   int fetched = 0;
+   char* wal_root = NULL;
+   struct deque* bundles = NULL;
+   struct deque_iterator* it = NULL;
+
+   wal_root = s3_get_walpath(server);
+
+   if (pgmoneta_mkdir(directory))
+   {
+      goto error;
+   }
+
+   if (s3_wal_bundles(server, wal_root, &bundles) || pgmoneta_deque_iterator_create(bundles, &it))
+   {
+      goto error;
+   }
+
+   while (pgmoneta_deque_iterator_next(it))
+   {
+      /* Skip the bundles that end before the start segment */
+      if (start != NULL && pgmoneta_wal_bundle_ends_before(it->tag, start))
+      {
+         continue;
+      }
+
+      if (s3_wal_fetch(server, wal_root, it->tag, NULL, start, directory, &fetched))
+      {
+         goto error;
+      }
+   }
+
+   pgmoneta_log_debug("S3 WAL: restored %d segments from %s", fetched, wal_root);
+
+   pgmoneta_deque_iterator_destroy(it);
+   pgmoneta_deque_destroy(bundles);
+   free(wal_root);
+
+   return 0;
+
+error:
+
+   pgmoneta_deque_iterator_destroy(it);
+   pgmoneta_deque_destroy(bundles);
+   free(wal_root);
+
+   return 1;
+}
+
+int
+pgmoneta_s3_wal_retention(int server)
+{
+   char* d = NULL;
+   char* base = NULL;
+   char* wal_root = NULL;
+   char* delete_xml = NULL;
+   int deleted = 0;
+   struct backup* backup = NULL;
+   struct deque* objects = NULL;
+   struct deque* keys = NULL;
+   struct deque_iterator* it = NULL;
+   struct http_response* response = NULL;
+   struct main_configuration* config;
+
+   config = (struct main_configuration*)shmem;
+
+   d = pgmoneta_get_server_backup(server);
+
+   if (pgmoneta_load_info(d, "oldest", &backup))
+   {
+      goto error;
+   }
+
+   /* Without a backup the bundles are the only copy of the WAL */
+   if (backup == NULL)
+   {
+      goto done;
+   }
+
+   wal_root = s3_get_walpath(server);
+
+   if (s3_list_objects("", wal_root, server, &objects) || pgmoneta_deque_create(false, &keys))
+   {
+      goto error;
+   }
+
+   if (objects != NULL)
+   {
+      if (pgmoneta_deque_iterator_create(objects, &it))
+      {
+         goto error;
+      }
+
+      while (pgmoneta_deque_iterator_next(it))
+      {
+         char* key = (char*)it->value->data;
+
+         base = strrchr(key, '/');
+         base = base != NULL ? base + 1 : key;
+
+         if (pgmoneta_wal_bundle_ends_before(base, backup->wal))
+         {
+            pgmoneta_log_trace("S3 WAL: Deleting %s", key);
+            pgmoneta_deque_add(keys, NULL, (uintptr_t)key, ValueString);
+         }
+      }
+   }
+
+   while (pgmoneta_deque_size(keys) > 0)
+   {
+      int size = (int)MIN(pgmoneta_deque_size(keys), (size_t)S3_DELETE_MAX_KEYS);
+
+      if (xml_s3_build_delete_list(&delete_xml, keys, size) ||
+          s3_send_delete_request("", wal_root, server, delete_xml, &response))
+      {
+         goto error;
+      }
+
+      pgmoneta_http_response_destroy(response);
+      response = NULL;
+
+      free(delete_xml);
+      delete_xml = NULL;
+
+      deleted += size;
+   }
+
+   if (deleted > 0)
+   {
+      pgmoneta_log_debug("S3 WAL: %s: Deleted %d bundles before %s",
+                         config->common.servers[server].name, deleted, backup->wal);
+   }
+
+done:
+
+   pgmoneta_deque_iterator_destroy(it);
+   pgmoneta_deque_destroy(objects);
+   pgmoneta_deque_destroy(keys);
+   free(backup);
+   free(wal_root);
+   free(d);
+
+   return 0;
+
+error:
+
+   pgmoneta_http_response_destroy(response);
+   pgmoneta_deque_iterator_destroy(it);
+   pgmoneta_deque_destroy(objects);
+   pgmoneta_deque_destroy(keys);
+   free(delete_xml);
+   free(backup);
+   free(wal_root);
+   free(d);
+
+   return 1;
+}
+
+static char*
+s3_wal_state_path(int server)
+{
+   char* p = NULL;
+
+   p = pgmoneta_get_server(server);
+   if (p == NULL)
+   {
+      return NULL;
+   }
+
+   if (!pgmoneta_ends_with(p, "/"))
+   {
+      p = pgmoneta_append_char(p, '/');
+   }
+   p = pgmoneta_append(p, S3_WAL_BUNDLE_STATE);
+
+   return p;
+}
+
+static int
+s3_wal_read_state(int server, char* last, size_t size)
+{
+   char* path = NULL;
+   FILE* file = NULL;
+
+   path = s3_wal_state_path(server);
+   if (path == NULL)
+   {
+      return 1;
+   }
+
+   file = fopen(path, "r");
+   if (file == NULL)
+   {
+      free(path);
+      return 1;
+   }
+
+   if (fgets(last, (int)size, file) == NULL)
+   {
+      last[0] = '\0';
+   }
+   last[strcspn(last, "\r\n")] = '\0';
+
+   fclose(file);
+   free(path);
+
+   return 0;
+}
+
+static int
+s3_wal_write_state(int server, char* last)
+{
+   char* path = NULL;
+   char* tmp = NULL;
+   FILE* file = NULL;
+
+   path = s3_wal_state_path(server);
+   if (path == NULL)
+   {
+      goto error;
+   }
+
+   tmp = pgmoneta_append(tmp, path);
+   tmp = pgmoneta_append(tmp, ".tmp");
+
+   file = fopen(tmp, "w");
+   if (file == NULL)
+   {
+      goto error;
+   }
+
+   fprintf(file, "%s\n", last);
+
+   if (fflush(file) || fsync(fileno(file)))
+   {
+      goto error;
+   }
+
+   fclose(file);
+   file = NULL;
+
+   if (rename(tmp, path))
+   {
+      goto error;
+   }
+
+   free(path);
+   free(tmp);
+
+   return 0;
+
+error:
+
+   if (file != NULL)
+   {
+      fclose(file);
+   }
+
+   if (tmp != NULL)
+   {
+      unlink(tmp);
+   }
+
+   free(path);
+   free(tmp);
+
+   return 1;
+}
+
+/**
+ * The completed segments in their final, compressed and encrypted, form
+ * after the last archived segment, and the timeline history files
+ */
+static int
+s3_wal_files(char* wal_dir, char* suffix, char* last, struct deque** segments, struct deque** histories)
+{
+   DIR* dir = NULL;
+   struct dirent* entry = NULL;
+   struct deque* s = NULL;
+   struct deque* h = NULL;
+   struct deque_iterator* it = NULL;
+
+   *segments = NULL;
+   *histories = NULL;
+
+   if (pgmoneta_deque_create(false, &s) || pgmoneta_deque_create(false, &h))
+   {
+      goto error;
+   }
+
+   dir = opendir(wal_dir);
+   if (dir == NULL)
+   {
+      goto error;
+   }
+
+   while ((entry = readdir(dir)) != NULL)
+   {
+      char name[25];
+
+      if (entry->d_type != DT_REG)
+      {
+         continue;
+      }
+
+      if (pgmoneta_ends_with(entry->d_name, ".history"))
+      {
+         pgmoneta_deque_add(h, entry->d_name, (uintptr_t)entry->d_name, ValueString);
+         continue;
+      }
+
+      if (strlen(entry->d_name) != 24 + strlen(suffix) || strcmp(entry->d_name + 24, suffix))
+      {
+         continue;
+      }
+
+      memset(&name[0], 0, sizeof(name));
+      memcpy(&name[0], entry->d_name, 24);
+
+      if (!pgmoneta_is_wal_file(&name[0]))
+      {
+         continue;
+      }
+
+      if (last != NULL && strlen(last) > 0 && strncmp(&name[0], last, 24) <= 0)
+      {
+         continue;
+      }
+
+      pgmoneta_deque_add(s, entry->d_name, (uintptr_t)entry->d_name, ValueString);
+   }
+
+   closedir(dir);
+   dir = NULL;
+
+   pgmoneta_deque_sort(s, NULL);
+
+   /* Stop at a segment that is still being compressed, so none is skipped */
+   if (strlen(suffix) > 0)
+   {
+      bool stop = false;
+
+      if (pgmoneta_deque_iterator_create(s, &it))
+      {
+         goto error;
+      }
+
+      while (pgmoneta_deque_iterator_next(it))
+      {
+         char raw[MAX_PATH];
+
+         pgmoneta_snprintf(raw, sizeof(raw), "%s/%.24s", wal_dir, it->tag);
+
+         if (stop || pgmoneta_exists(raw))
+         {
+            stop = true;
+            pgmoneta_deque_iterator_remove(it);
+         }
+      }
+
+      pgmoneta_deque_iterator_destroy(it);
    }
-   pgmoneta_workers_destroy(workers);
 
-   pgmoneta_deque_iterator_destroy(iter);
-   pgmoneta_deque_destroy(paths);
-   free(manifest_path);
-   free(suffix);
+   *segments = s;
+   *histories = h;
 
    return 0;
 
 error:
 
-   pgmoneta_deque_iterator_destroy(iter);
-   pgmoneta_deque_destroy(paths);
-   pgmoneta_workers_wait(workers);
-   pgmoneta_workers_destroy(workers);
-   free(manifest_path);
-   free(suffix);
-   free(filename);
-   free(s3_path);
-   free(local_file_path);
-   free(task);
+   if (dir != NULL)
+   {
+      closedir(dir);
+   }
+
+   pgmoneta_deque_destroy(s);
+   pgmoneta_deque_destroy(h);
 
    return 1;
 }
 
 static int
-s3_create_transfer_task(int server, char* s3_root, char* remote_path,
-                        char* local_root, char* local_path, char* file_sha512,
-                        struct workers* workers, struct s3_transfer_task** task)
+s3_wal_upload_bundle(int server, char* wal_dir, char* wal_root, struct deque* segments)
 {
-   struct s3_transfer_task* t = NULL;
+   char* first = NULL;
+   char* last = NULL;
+   char* name = NULL;
+   char* server_dir = NULL;
+   char path[MAX_PATH];
 
-   *task = NULL;
+   pgmoneta_deque_peek(segments, &first);
+   pgmoneta_deque_peek_last(segments, &last);
 
-   if (s3_root == NULL || remote_path == NULL || local_path == NULL)
+   name = pgmoneta_wal_bundle_name(first, last);
+   server_dir = pgmoneta_get_server(server);
+   if (name == NULL || server_dir == NULL)
    {
       goto error;
    }
 
-   if (strlen(s3_root) >= MAX_PATH || strlen(remote_path) >= MAX_PATH || strlen(local_path) >= MAX_PATH)
+   pgmoneta_snprintf(path, sizeof(path), "%s%s%s", server_dir, pgmoneta_ends_with(server_dir, "/") ? "" : "/", name);
+
+   if (pgmoneta_wal_bundle_create(wal_dir, segments, path))
    {
-      pgmoneta_log_error("S3 transfer path too long");
       goto error;
    }
 
-   if (local_root != NULL && strlen(local_root) >= MAX_PATH)
+   if (s3_send_upload_request(server_dir, wal_root, name, NULL, server))
    {
-      pgmoneta_log_error("S3 local root path too long");
+      pgmoneta_log_error("S3 WAL: could not upload %s", name);
+      unlink(path);
       goto error;
    }
 
-   if (file_sha512 != NULL && strlen(file_sha512) >= MISC_LENGTH)
+   unlink(path);
+
+   /* Only a stored bundle moves the archive forward */
+   if (s3_wal_write_state(server, last))
    {
-      pgmoneta_log_error("S3 sha512 value too long");
+      pgmoneta_log_error("S3 WAL: could not save the state for %s", name);
       goto error;
    }
 
-   t = (struct s3_transfer_task*)malloc(sizeof(struct s3_transfer_task));
-   if (t == NULL)
+   pgmoneta_log_debug("S3 WAL: uploaded %s (%d segments)", name, pgmoneta_deque_size(segments));
+
+   free(name);
+   free(server_dir);
+
+   return 0;
+
+error:
+
+   free(name);
+   free(server_dir);
+
+   return 1;
+}
+
+static int
+s3_wal_get_range(int server, char* wal_root, char* key, long start, long end, struct http_response** response)
+{
+   struct http_response* r = NULL;
+
+   *response = NULL;
+
+   for (int attempt = 0; attempt < S3_RANGE_RETRIES; attempt++)
    {
-      goto error;
+      if (attempt > 0)
+      {
+         SLEEP(250000000L * attempt);
+      }
+
+      pgmoneta_http_response_destroy(r);
+      r = NULL;
+
+      if (s3_send_get_request(key, wal_root, server, start, end, &r))
+      {
+         continue;
+      }
+
+      if (r->status_code == 200 || r->status_code == 206)
+      {
+         pgmoneta_throttle(THROTTLE_DOWNLOAD, r->payload.data_size);
+
+         *response = r;
+         return 0;
+      }
+
+      if (r->status_code >= 400 && r->status_code < 500 && r->status_code != 408 && r->status_code != 429)
+      {
+         break;
+      }
    }
 
-   memset(t, 0, sizeof(struct s3_transfer_task));
-   pgmoneta_snprintf(t->s3_root, sizeof(t->s3_root), "%s", s3_root);
-   pgmoneta_snprintf(t->remote_path, sizeof(t->remote_path), "%s", remote_path);
-   pgmoneta_snprintf(t->local_path, sizeof(t->local_path), "%s", local_path);
-   if (local_root != NULL)
+   pgmoneta_log_debug("S3 WAL: failed to GET %s", key);
+   pgmoneta_http_response_destroy(r);
+
+   return 1;
+}
+
+static int
+s3_wal_bundles(int server, char* wal_root, struct deque** bundles)
+{
+   char* base = NULL;
+   struct deque* objects = NULL;
+   struct deque* b = NULL;
+   struct deque_iterator* it = NULL;
+
+   *bundles = NULL;
+
+   if (s3_list_objects("", wal_root, server, &objects) || pgmoneta_deque_create(false, &b))
    {
-      pgmoneta_snprintf(t->local_root, sizeof(t->local_root), "%s", local_root);
+      goto error;
    }
-   if (file_sha512 != NULL)
+
+   if (objects != NULL)
    {
-      pgmoneta_snprintf(t->file_sha512, sizeof(t->file_sha512), "%s", file_sha512);
+      if (pgmoneta_deque_iterator_create(objects, &it))
+      {
+         goto error;
+      }
+
+      while (pgmoneta_deque_iterator_next(it))
+      {
+         char* key = (char*)it->value->data;
+
+         base = strrchr(key, '/');
+         base = base != NULL ? base + 1 : key;
+
+         if (pgmoneta_ends_with(base, WAL_BUNDLE_SUFFIX))
+         {
+            pgmoneta_deque_add(b, base, (uintptr_t)base, ValueString);
+         }
+      }
    }
 
-   t->common.workers = workers;
-   t->server = server;
-   t->progress_enabled = (server >= 0 && pgmoneta_is_progress_enabled(server));
+   pgmoneta_deque_sort(b, NULL);
 
-   *task = t;
+   pgmoneta_deque_iterator_destroy(it);
+   pgmoneta_deque_destroy(objects);
+
+   *bundles = b;
 
    return 0;
 
 error:
-   free(t);
+
+   pgmoneta_deque_iterator_destroy(it);
+   pgmoneta_deque_destroy(objects);
+   pgmoneta_deque_destroy(b);
+
    return 1;
 }
 
+/**
+ * Read the index of a bundle and fetch a single segment, or the segments
+ * from start on that are missing in the directory, each with its own
+ * ranged GET
+ */
 static int
-s3_download_one_file(struct s3_transfer_task* task)
+s3_wal_fetch(int server, char* wal_root, char* bundle, char* segment, char* start, char* directory, int* fetched)
 {
+   char path[MAX_PATH];
+   char* content_range = NULL;
+   char* slash = NULL;
+   uint64_t total = 0;
+   uint64_t offset = 0;
+   uint64_t length = 0;
+   int fd = -1;
    struct http_response* response = NULL;
-   char* full_local = NULL;
+   struct deque* entries = NULL;
+   struct deque_iterator* it = NULL;
+   struct wal_bundle_entry* wanted = NULL;
+
+   memset(&path[0], 0, sizeof(path));
 
-   if (s3_send_get_request(task->remote_path, task->s3_root, task->server, -1, -1, &response))
+   if (s3_wal_get_range(server, wal_root, bundle, -1, WAL_BUNDLE_TRAILER_SIZE, &response))
    {
-      pgmoneta_log_error("S3 download: failed to GET %s", task->remote_path);
       goto error;
    }
 
-   if (response->status_code != 200)
+   if (response->status_code == 206)
    {
-      pgmoneta_log_error("S3 download: %s returned status %d", task->remote_path, response->status_code);
-      goto error;
-   }
+      content_range = pgmoneta_http_get_response_header(response, "Content-Range");
+      if (content_range == NULL)
+      {
+         content_range = pgmoneta_http_get_response_header(response, "content-range");
+      }
 
-   full_local = pgmoneta_append(full_local, task->local_root);
-   full_local = pgmoneta_append(full_local, task->local_path);
+      slash = content_range != NULL ? strrchr(content_range, '/') : NULL;
+      if (slash == NULL || *(slash + 1) == '*')
+      {
+         pgmoneta_log_error("S3 WAL: %s has no object size", bundle);
+         goto error;
+      }
 
-   if (pgmoneta_append_file_chunk(full_local, response->payload.data, response->payload.data_size, 0))
+      total = strtoull(slash + 1, NULL, 10);
+   }
+   else
    {
-      pgmoneta_log_error("S3 download: failed to write %s", full_local);
-      goto error;
+      total = response->payload.data_size;
    }
 
-   if (task->progress_enabled)
+   if (response->payload.data_size < WAL_BUNDLE_TRAILER_SIZE ||
+       pgmoneta_wal_bundle_read_trailer((char*)response->payload.data + response->payload.data_size - WAL_BUNDLE_TRAILER_SIZE,
+                                        WAL_BUNDLE_TRAILER_SIZE, total, &offset, &length))
    {
-      pgmoneta_progress_increment(task->server, 1);
+      pgmoneta_log_error("S3 WAL: %s is not a WAL bundle", bundle);
+      goto error;
    }
 
-   pgmoneta_log_debug("S3 download: %s", task->remote_path);
    pgmoneta_http_response_destroy(response);
-   free(full_local);
-
-   return 0;
+   response = NULL;
 
-error:
-   pgmoneta_http_response_destroy(response);
-   free(full_local);
-   return 1;
-}
+   if (length > 0)
+   {
+      if (s3_wal_get_range(server, wal_root, bundle, (long)offset, (long)(offset + length - 1), &response) ||
+          response->payload.data_size != length ||
+          pgmoneta_wal_bundle_read_index(response->payload.data, length, &entries))
+      {
+         pgmoneta_log_error("S3 WAL: could not read the index of %s", bundle);
+         goto error;
+      }
 
-static void
-do_download_file(struct worker_common* wc)
-{
-   struct s3_transfer_task* task = (struct s3_transfer_task*)wc;
+      pgmoneta_http_response_destroy(response);
+      response = NULL;
+   }
 
-   if (s3_download_one_file(task) && task->common.workers != NULL)
+   if (entries == NULL || pgmoneta_deque_iterator_create(entries, &it))
    {
-      task->common.workers->outcome = false;
+      goto error;
    }
 
-   free(task);
-}
-
-static int
-s3_upload_one_file(struct s3_transfer_task* task)
-{
-   if (s3_send_upload_request(task->local_root, task->s3_root, task->remote_path,
-                              strlen(task->file_sha512) > 0 ? task->file_sha512 : NULL, task->server))
+   if (segment != NULL)
    {
-      pgmoneta_log_error("S3 upload: failed %s", task->remote_path);
-      return 1;
+      wanted = pgmoneta_wal_bundle_find(entries, segment);
+      if (wanted == NULL)
+      {
+         goto done;
+      }
    }
 
-   if (task->progress_enabled)
+   while (pgmoneta_deque_iterator_next(it))
    {
-      pgmoneta_progress_increment(task->server, 1);
+      struct wal_bundle_entry* entry = (struct wal_bundle_entry*)it->value->data;
+
+      if (wanted != NULL && entry != wanted)
+      {
+         continue;
+      }
+
+      if (start != NULL && strncmp(entry->name, start, 24) < 0)
+      {
+         continue;
+      }
+
+      pgmoneta_snprintf(path, sizeof(path), "%s/%s", directory, entry->name);
+
+      /* A single segment is always fetched again */
+      if (wanted == NULL && pgmoneta_exists(path))
+      {
+         continue;
+      }
+
+      if (entry->offset + entry->size > offset ||
+          (entry->size > 0 &&
+           s3_wal_get_range(server, wal_root, bundle, (long)entry->offset, (long)(entry->offset + entry->size - 1), &response)))
+      {
+         goto error;
+      }
+
+      if (response != NULL && response->payload.data_size != entry->size)
+      {
+         pgmoneta_log_error("S3 WAL: short read of %s from %s", entry->name, bundle);
+         goto error;
+      }
+
+      fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+      if (fd < 0)
+      {
+         pgmoneta_log_error("S3 WAL: failed to create %s: %s", path, strerror(errno));
+         goto error;
+      }
+
+      if ((response != NULL && s3_write_at(fd, response->payload.data, response->payload.data_size, 0)) || fsync(fd))
+      {
+         goto error;
+      }
+
+      close(fd);
+      fd = -1;
+
+      pgmoneta_http_response_destroy(response);
+      response = NULL;
+
+      (*fetched)++;
    }
 
+done:
+
+   pgmoneta_deque_iterator_destroy(it);
+   pgmoneta_deque_destroy(entries);
+
    return 0;
-}
 
-static void
-do_upload_file(struct worker_common* wc)
-{
-   struct s3_transfer_task* task = (struct s3_transfer_task*)wc;
+error:
 
-   if (s3_upload_one_file(task) && task->common.workers != NULL)
+   if (fd >= 0)
    {
-      task->common.workers->outcome = false;
+      close(fd);
+      unlink(path);
    }
 
-   free(task);
+   pgmoneta_http_response_destroy(response);
+   pgmoneta_deque_iterator_destroy(it);
+   pgmoneta_deque_destroy(entries);
+
+   return 1;
 }
 
 static int
@@ -2088,12 +3378,19 @@ s3_send_get_request(char* relative_path, char* s3_root, int server,
    pgmoneta_deque_add(sign_headers, "host", (uintptr_t)s3_host, ValueStringRef);
    pgmoneta_deque_add(sign_headers, "x-amz-content-sha256", (uintptr_t)body_hash, ValueStringRef);
    pgmoneta_deque_add(sign_headers, "x-amz-date", (uintptr_t)long_date, ValueStringRef);
-   if (range_start >= 0 && range_end > range_start)
+   if (range_start >= 0 && range_end >= range_start)
    {
       char range_buf[128];
       pgmoneta_snprintf(range_buf, sizeof(range_buf), "bytes=%ld-%ld", range_start, range_end);
       pgmoneta_deque_add(sign_headers, "range", (uintptr_t)range_buf, ValueString);
    }
+   else if (range_start < 0 && range_end > 0)
+   {
+      /* The last range_end bytes of the object */
+      char range_buf[128];
+      pgmoneta_snprintf(range_buf, sizeof(range_buf), "bytes=-%ld", range_end);
+      pgmoneta_deque_add(sign_headers, "range", (uintptr_t)range_buf, ValueString);
+   }
 
    if (s3_sign_request("GET", canonical_uri, NULL,
                        sign_headers, body_hash,
@@ -2188,9 +3485,7 @@ s3_send_upload_request(char* local_root, char* s3_root, char* relative_path, cha
    char* local_path = NULL;
    char* request_path = NULL;
    char* file_sha256 = NULL;
-   FILE* file = NULL;
    struct stat file_info;
-   void* file_data = NULL;
    char* canonical_uri = NULL;
    struct deque* sign_headers = NULL;
    struct http* connection = NULL;
@@ -2270,31 +3565,12 @@ s3_send_upload_request(char* local_root, char* s3_root, char* relative_path, cha
       goto error;
    }
 
-   file = fopen(local_path, "rb");
-
-   if (file == NULL)
-   {
-      goto error;
-   }
-
-   if (fstat(fileno(file), &file_info) != 0)
-   {
-      goto error;
-   }
-
-   file_data = malloc(file_info.st_size);
-   if (file_data == NULL)
-   {
-      goto error;
-   }
-
-   if (fread(file_data, 1, file_info.st_size, file) != (size_t)file_info.st_size)
+   if (stat(local_path, &file_info) != 0)
    {
       goto error;
    }
 
-   fclose(file);
-   file = NULL;
+   pgmoneta_throttle(THROTTLE_UPLOAD, file_info.st_size);
 
    int s3_port;
 
@@ -2336,7 +3612,7 @@ s3_send_upload_request(char* local_root, char* s3_root, char* relative_path, cha
       goto error;
    }
 
-   if (pgmoneta_http_set_data(request, file_data, file_info.st_size))
+   if (pgmoneta_http_set_file(request, local_path, 0, file_info.st_size))
    {
       goto error;
    }
@@ -2363,7 +3639,6 @@ s3_send_upload_request(char* local_root, char* s3_root, char* relative_path, cha
    free(local_path);
    free(s3_path);
    free(auth_value);
-   free(file_data);
    free(canonical_uri);
    pgmoneta_deque_destroy(sign_headers);
    pgmoneta_http_request_destroy(request);
@@ -2380,7 +3655,6 @@ error:
    free(s3_path);
    free(file_sha256);
    free(auth_value);
-   free(file_data);
    free(canonical_uri);
    pgmoneta_deque_destroy(sign_headers);
 
@@ -2399,11 +3673,6 @@ error:
       pgmoneta_http_response_destroy(response);
    }
 
-   if (file != NULL)
-   {
-      fclose(file);
-   }
-
    return 1;
 }
 
@@ -2445,6 +3714,29 @@ s3_get_host(int server)
 
 static char*
 s3_get_basepath(int server, char* identifier)
+{
+   char* d = NULL;
+
+   d = s3_get_server_path(server);
+   d = pgmoneta_append(d, "backup/");
+   d = pgmoneta_append(d, identifier);
+
+   return d;
+}
+
+static char*
+s3_get_walpath(int server)
+{
+   char* d = NULL;
+
+   d = s3_get_server_path(server);
+   d = pgmoneta_append(d, "wal/");
+
+   return d;
+}
+
+static char*
+s3_get_server_path(int server)
 {
    char* d = NULL;
    struct main_configuration* config;
@@ -2474,8 +3766,7 @@ s3_get_basepath(int server, char* identifier)
    }
 
    d = pgmoneta_append(d, config->common.servers[server].name);
-   d = pgmoneta_append(d, "/backup/");
-   d = pgmoneta_append(d, identifier);
+   d = pgmoneta_append(d, "/");
 
    return d;
 }
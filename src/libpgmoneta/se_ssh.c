@@ -44,6 +44,34 @@
 #include <libssh/libssh.h>
 #include <libssh/sftp.h>
 
+#define SFTP_MAX_TRANSFERS    8
+#define SFTP_DEFAULT_WRITE    32768
+
+/**
+ * A file being uploaded. With libssh 0.11 the writes are asynchronous,
+ * otherwise each write waits for its reply
+ */
+struct sftp_transfer
+{
+   char* path;       /**< The remote path, NULL if the slot is free */
+   FILE* sfile;      /**< The local file */
+   sftp_file dfile;  /**< The remote file */
+   bool eof;         /**< Has the local file been read completely */
+   int pending;      /**< The number of writes in flight */
+};
+
+/**
+ * An asynchronous write in flight
+ */
+struct sftp_request
+{
+#ifdef HAVE_LIBSSH_AIO
+   sftp_aio aio;                     /**< The libssh request */
+#endif
+   struct sftp_transfer* transfer;   /**< The transfer */
+   size_t length;                    /**< The number of bytes */
+};
+
 static char* ssh_storage_name(void);
 static int ssh_storage_setup(char*, struct art*);
 static int ssh_storage_backup_execute(char*, struct art*);
@@ -61,7 +89,14 @@ static int read_latest_backup_sha256(char* path);
 static int sftp_make_directory(char* local_dir, char* remote_dir);
 static int sftp_copy_directory(char* local_root, char* remote_root, char* relative_path);
 static int sftp_copy_file(char* local_root, char* remote_root, char* relative_path);
-static int sftp_wal_prepare(sftp_file* file, int segsize);
+static int sftp_wal_prepare(sftp_file* file, char* path, int segsize);
+static int sftp_transfer_setup(void);
+static void sftp_transfer_teardown(void);
+static int sftp_transfer_begin(char* local_path, char* remote_path, mode_t mode);
+static int sftp_transfer_fill(void);
+static int sftp_transfer_wait(void);
+static int sftp_transfer_finish(void);
+static void sftp_transfer_close(struct sftp_transfer* transfer);
 static bool sftp_exists(char* path);
 static int sftp_get_file_size(char* file_path, size_t* file_size);
 static int sftp_permission(char* path, int user, int group, int all);
@@ -69,6 +104,14 @@ static int sftp_permission(char* path, int user, int group, int all);
 static ssh_session session = NULL;
 static sftp_session sftp = NULL;
 
+static struct sftp_transfer transfers[SFTP_MAX_TRANSFERS];
+static struct sftp_request* requests = NULL;
+static int request_head = 0;
+static int request_count = 0;
+static int next_transfer = 0;
+static size_t write_length = SFTP_DEFAULT_WRITE;
+static char* write_buffer = NULL;
+
 static struct art* tree_map = NULL;
 
 static bool is_error = false;
@@ -247,6 +290,11 @@ ssh_storage_setup(char* name __attribute__((unused)), struct art* nodes)
       goto error;
    }
 
+   if (sftp_transfer_setup())
+   {
+      goto error;
+   }
+
    is_error = false;
 
    ssh_string_free_char(hexa);
@@ -267,6 +315,8 @@ error:
    ssh_key_free(client_pubkey);
    ssh_key_free(client_privkey);
 
+   sftp_transfer_teardown();
+
    sftp_free(sftp);
 
    ssh_disconnect(session);
@@ -366,10 +416,17 @@ ssh_storage_backup_execute(char* name __attribute__((unused)), struct art* nodes
 
    if (sftp_copy_directory(local_root, remote_root, "") != 0)
    {
+      sftp_transfer_finish();
       pgmoneta_log_error("failed to transfer the backup directory from the local host to the remote server: %s", strerror(errno));
       goto error;
    }
 
+   if (sftp_transfer_finish())
+   {
+      pgmoneta_log_error("failed to transfer the backup directory from the local host to the remote server: %s", ssh_get_error(session));
+      goto error;
+   }
+
    is_error = false;
 
    for (int i = 0; i < number_of_backups; i++)
@@ -518,6 +575,8 @@ ssh_storage_backup_teardown(char* name __attribute__((unused)), struct art* node
 
    free(latest_remote_root);
 
+   sftp_transfer_teardown();
+
    sftp_free(sftp);
 
    ssh_free(session);
@@ -546,6 +605,8 @@ ssh_storage_wal_shipping_teardown(char* name __attribute__((unused)), struct art
 
    pgmoneta_log_debug("SSH storage engine (WAL shipping/teardown): %s/%s", config->common.servers[server].name, label);
 
+   sftp_transfer_teardown();
+
    sftp_free(sftp);
 
    ssh_free(session);
@@ -689,10 +750,6 @@ sftp_copy_file(char* local_root, char* remote_root, char* relative_path)
    char* sha256 = NULL;
    char* latest_sha256 = NULL;
    char* latest_backup_path = NULL;
-   char buffer[16384];
-   FILE* sfile = NULL;
-   sftp_file dfile = NULL;
-   unsigned long read_bytes = 0;
    mode_t mode = 0;
    bool is_link = false;
 
@@ -730,95 +787,461 @@ sftp_copy_file(char* local_root, char* remote_root, char* relative_path)
    {
       mode = pgmoneta_get_permission(s);
 
-      sfile = fopen(s, "rb");
-
-      if (sfile == NULL)
+      if (sftp_transfer_begin(s, d, mode))
       {
          goto error;
       }
+   }
+
+   free(s);
+   free(d);
+   free(sha256);
+
+   if (latest_backup_path != NULL)
+   {
+      free(latest_backup_path);
+   }
+
+   return 0;
+
+error:
+
+   free(s);
+   free(d);
+   free(sha256);
+
+   if (latest_backup_path != NULL)
+   {
+      free(latest_backup_path);
+   }
+
+   return 1;
+}
+
+static int
+sftp_wal_prepare(sftp_file* file, char* path, int segsize)
+{
+   struct sftp_attributes_struct attributes;
+#ifdef HAVE_LIBSSH_AIO
+   sftp_aio* aio = NULL;
+   int head = 0;
+   int count = 0;
+#endif
+   char* zero = NULL;
+   size_t length = 0;
+   size_t offset = 0;
+   struct main_configuration* config;
+
+   config = (struct main_configuration*)shmem;
+
+   if (file == NULL || *file == NULL)
+   {
+      return 1;
+   }
+
+   /* Extend the segment on the server instead of sending the zeros */
+   memset(&attributes, 0, sizeof(attributes));
+   attributes.flags = SSH_FILEXFER_ATTR_SIZE;
+   attributes.size = (uint64_t)segsize;
+
+   if (sftp_setstat(sftp, path, &attributes) == SSH_OK)
+   {
+      return 0;
+   }
+
+   pgmoneta_log_debug("WAL: %s could not be extended remotely, writing zeros", path);
 
-      dfile = sftp_open(sftp, d, O_WRONLY | O_CREAT | O_TRUNC, mode);
+   length = write_length;
+   zero = (char*)calloc(1, length);
+   if (zero == NULL)
+   {
+      return 1;
+   }
+
+#ifdef HAVE_LIBSSH_AIO
+   aio = (sftp_aio*)calloc(config->ssh_inflight, sizeof(sftp_aio));
+   if (aio == NULL)
+   {
+      free(zero);
+      return 1;
+   }
 
-      if (dfile == NULL)
+   while (offset < (size_t)segsize || count > 0)
+   {
+      if (offset < (size_t)segsize && count < config->ssh_inflight)
       {
-         goto error;
+         size_t n = MIN(length, (size_t)segsize - offset);
+
+         if (sftp_aio_begin_write(*file, zero, n, &aio[(head + count) % config->ssh_inflight]) < 0)
+         {
+            goto error;
+         }
+
+         offset += n;
+         count++;
+      }
+      else
+      {
+         if (sftp_aio_wait_write(&aio[head]) < 0)
+         {
+            count--;
+            head = (head + 1) % config->ssh_inflight;
+            goto error;
+         }
+
+         count--;
+         head = (head + 1) % config->ssh_inflight;
       }
+   }
+#else
+   (void)config;
 
-      memset(buffer, 0, sizeof(buffer));
+   while (offset < (size_t)segsize)
+   {
+      size_t n = MIN(length, (size_t)segsize - offset);
 
-      while ((read_bytes = fread(buffer, 1, sizeof(buffer), sfile)) > 0)
+      if (sftp_write(*file, zero, n) != (ssize_t)n)
       {
-         sftp_write(dfile, buffer, read_bytes);
+         goto error;
       }
+
+      offset += n;
+   }
+#endif
+
+   if (sftp_seek(*file, 0) < 0)
+   {
+      pgmoneta_log_error("WAL error: %s", ssh_get_error(session));
+      goto error;
    }
 
-   if (sfile != NULL)
+   free(zero);
+#ifdef HAVE_LIBSSH_AIO
+   free(aio);
+#endif
+
+   return 0;
+
+error:
+
+#ifdef HAVE_LIBSSH_AIO
+   while (count > 0)
    {
-      fclose(sfile);
+      sftp_aio_free(aio[head]);
+      count--;
+      head = (head + 1) % config->ssh_inflight;
    }
 
-   if (dfile != NULL)
+   free(aio);
+#endif
+
+   pgmoneta_log_error("WAL error: %s", ssh_get_error(session));
+
+   free(zero);
+
+   return 1;
+}
+
+static int
+sftp_transfer_setup(void)
+{
+#ifdef HAVE_LIBSSH_AIO
+   sftp_limits_t limits = NULL;
+#endif
+   struct main_configuration* config;
+
+   config = (struct main_configuration*)shmem;
+
+   memset(&transfers[0], 0, sizeof(transfers));
+   request_head = 0;
+   request_count = 0;
+   next_transfer = 0;
+
+   /* The server may accept larger writes than the protocol minimum */
+   write_length = SFTP_DEFAULT_WRITE;
+#ifdef HAVE_LIBSSH_AIO
+   limits = sftp_limits(sftp);
+   if (limits != NULL)
    {
-      sftp_close(dfile);
+      if (limits->max_write_length > 0)
+      {
+         write_length = (size_t)limits->max_write_length;
+      }
+      sftp_limits_free(limits);
    }
+#endif
 
-   free(s);
-   free(d);
-   free(sha256);
+   requests = (struct sftp_request*)calloc(config->ssh_inflight, sizeof(struct sftp_request));
+   write_buffer = (char*)malloc(write_length);
 
-   if (latest_backup_path != NULL)
+   if (requests == NULL || write_buffer == NULL)
    {
-      free(latest_backup_path);
+      sftp_transfer_teardown();
+      return 1;
    }
 
+#ifdef HAVE_LIBSSH_AIO
+   pgmoneta_log_debug("SFTP: %d requests of %zu bytes in flight", config->ssh_inflight, write_length);
+#else
+   pgmoneta_log_debug("SFTP: Synchronous writes of %zu bytes", write_length);
+#endif
+
    return 0;
+}
 
-error:
+static void
+sftp_transfer_teardown(void)
+{
+   struct main_configuration* config;
+
+   config = (struct main_configuration*)shmem;
 
-   if (sfile != NULL)
+   while (requests != NULL && request_count > 0)
    {
-      fclose(sfile);
+#ifdef HAVE_LIBSSH_AIO
+      sftp_aio_free(requests[request_head].aio);
+#endif
+      request_head = (request_head + 1) % config->ssh_inflight;
+      request_count--;
    }
 
-   if (dfile != NULL)
+   for (int i = 0; i < SFTP_MAX_TRANSFERS; i++)
    {
-      sftp_close(dfile);
+      sftp_transfer_close(&transfers[i]);
    }
 
-   free(s);
-   free(d);
-   free(sha256);
+   free(requests);
+   requests = NULL;
 
-   if (latest_backup_path != NULL)
+   free(write_buffer);
+   write_buffer = NULL;
+}
+
+/**
+ * Start uploading a file. The writes of up to SFTP_MAX_TRANSFERS files
+ * share the ssh_inflight requests of the SFTP channel, so small files
+ * do not each pay a round trip.
+ */
+static int
+sftp_transfer_begin(char* local_path, char* remote_path, mode_t mode)
+{
+   struct sftp_transfer* transfer = NULL;
+
+   while (transfer == NULL)
    {
-      free(latest_backup_path);
+      for (int i = 0; i < SFTP_MAX_TRANSFERS && transfer == NULL; i++)
+      {
+         if (transfers[i].path == NULL)
+         {
+            transfer = &transfers[i];
+         }
+      }
+
+      if (transfer == NULL && sftp_transfer_wait())
+      {
+         return 1;
+      }
+   }
+
+   transfer->sfile = fopen(local_path, "rb");
+   if (transfer->sfile == NULL)
+   {
+      goto error;
+   }
+
+   transfer->dfile = sftp_open(sftp, remote_path, O_WRONLY | O_CREAT | O_TRUNC, mode);
+   if (transfer->dfile == NULL)
+   {
+      goto error;
+   }
+
+   transfer->path = strdup(remote_path);
+   transfer->eof = false;
+   transfer->pending = 0;
+
+   if (transfer->path == NULL)
+   {
+      goto error;
    }
 
+   return sftp_transfer_fill();
+
+error:
+
+   sftp_transfer_close(transfer);
+
    return 1;
 }
 
 static int
-sftp_wal_prepare(sftp_file* file, int segsize)
+sftp_transfer_fill(void)
 {
-   char buffer[8192] = {0};
-   size_t written = 0;
+   size_t read_bytes = 0;
+   struct sftp_transfer* transfer = NULL;
+   struct sftp_request* request = NULL;
+   struct main_configuration* config;
 
-   if (file == NULL || *file == NULL)
+   config = (struct main_configuration*)shmem;
+
+   while (request_count < config->ssh_inflight)
    {
+      transfer = NULL;
+
+      for (int i = 0; i < SFTP_MAX_TRANSFERS && transfer == NULL; i++)
+      {
+         struct sftp_transfer* t = &transfers[(next_transfer + i) % SFTP_MAX_TRANSFERS];
+
+         if (t->path != NULL && !t->eof)
+         {
+            transfer = t;
+            next_transfer = (next_transfer + i + 1) % SFTP_MAX_TRANSFERS;
+         }
+      }
+
+      if (transfer == NULL)
+      {
+         break;
+      }
+
+      read_bytes = fread(write_buffer, 1, write_length, transfer->sfile);
+      if (read_bytes == 0)
+      {
+         if (ferror(transfer->sfile))
+         {
+            pgmoneta_log_error("SFTP: Could not read the local file for %s", transfer->path);
+            return 1;
+         }
+
+         transfer->eof = true;
+         if (transfer->pending == 0)
+         {
+            sftp_transfer_close(transfer);
+         }
+         continue;
+      }
+
+      pgmoneta_throttle(THROTTLE_UPLOAD, read_bytes);
+
+#ifdef HAVE_LIBSSH_AIO
+      request = &requests[(request_head + request_count) % config->ssh_inflight];
+
+      /* The data is copied into the outgoing packet, so the buffer can be reused */
+      if (sftp_aio_begin_write(transfer->dfile, write_buffer, read_bytes, &request->aio) < 0)
+      {
+         pgmoneta_log_error("SFTP: Could not write %s: %s", transfer->path, ssh_get_error(session));
+         return 1;
+      }
+
+      request->transfer = transfer;
+      request->length = read_bytes;
+      transfer->pending++;
+      request_count++;
+#else
+      (void)request;
+
+      /* Without the AIO API no request stays in flight */
+      if (sftp_write(transfer->dfile, write_buffer, read_bytes) != (ssize_t)read_bytes)
+      {
+         pgmoneta_log_error("SFTP: Could not write %s: %s", transfer->path, ssh_get_error(session));
+         return 1;
+      }
+#endif
+   }
+
+   return 0;
+}
+
+static int
+sftp_transfer_wait(void)
+{
+   ssize_t written = 0;
+   struct sftp_request* request = NULL;
+   struct sftp_transfer* transfer = NULL;
+   struct main_configuration* config;
+
+   config = (struct main_configuration*)shmem;
+
+   if (request_count == 0)
+   {
+      return sftp_transfer_fill();
+   }
+
+   request = &requests[request_head];
+   transfer = request->transfer;
+
+#ifdef HAVE_LIBSSH_AIO
+   written = sftp_aio_wait_write(&request->aio);
+   request->aio = NULL;
+#else
+   written = (ssize_t)request->length;
+#endif
+
+   request_head = (request_head + 1) % config->ssh_inflight;
+   request_count--;
+   transfer->pending--;
+
+   if (written < 0 || (size_t)written != request->length)
+   {
+      pgmoneta_log_error("SFTP: Could not write %s: %s", transfer->path, ssh_get_error(session));
       return 1;
    }
 
-   while (written < (size_t)segsize)
+   if (transfer->eof && transfer->pending == 0)
    {
-      written += sftp_write(*file, buffer, sizeof(buffer));
+      sftp_transfer_close(transfer);
    }
 
-   if (sftp_seek(*file, 0) < 0)
+   return sftp_transfer_fill();
+}
+
+static int
+sftp_transfer_finish(void)
+{
+   int ret = 0;
+
+   if (requests == NULL)
    {
-      pgmoneta_log_error("WAL error: %s", ssh_get_error(session));
       return 1;
    }
-   return 0;
+
+   if (sftp_transfer_fill())
+   {
+      ret = 1;
+   }
+
+   while (ret == 0 && request_count > 0)
+   {
+      if (sftp_transfer_wait())
+      {
+         ret = 1;
+      }
+   }
+
+   if (ret)
+   {
+      sftp_transfer_teardown();
+      sftp_transfer_setup();
+   }
+
+   return ret;
+}
+
+static void
+sftp_transfer_close(struct sftp_transfer* transfer)
+{
+   if (transfer->sfile != NULL)
+   {
+      fclose(transfer->sfile);
+   }
+
+   if (transfer->dfile != NULL)
+   {
+      sftp_close(transfer->dfile);
+   }
+
+   free(transfer->path);
+
+   memset(transfer, 0, sizeof(struct sftp_transfer));
 }
 
 static int
@@ -991,7 +1414,7 @@ pgmoneta_sftp_wal_open(int server, char* filename, int segsize, sftp_file* file)
       goto error;
    }
 
-   if (sftp_wal_prepare(file, segsize))
+   if (sftp_wal_prepare(file, path, segsize))
    {
       goto error;
    }
@@ -37,10 +37,17 @@
 #include <utf8.h>
 
 /* system */
-#ifdef HAVE_CRC32_SSE42
-#include <nmmintrin.h>
-#include <wmmintrin.h>
+#if defined(HAVE_CRC32_SSE42) && defined(__x86_64__)
+#include <immintrin.h>
 #endif
+#if defined(HAVE_CRC32C) && defined(__aarch64__)
+#include <arm_acle.h>
+#if defined(__linux__)
+#include <sys/auxv.h>
+#endif
+#endif
+#include <fcntl.h>
+#include <inttypes.h>
 #include <stdatomic.h>
 #include <stdbool.h>
 #include <stddef.h>
@@ -64,10 +71,6 @@
 #include <sys/socket.h>
 #include <sys/types.h>
 
-#if defined(__x86_64__) || defined(__i386__)
-#include <cpuid.h> /* for __get_cpuid */
-#endif
-
 #define SECURITY_INVALID            -2
 #define SECURITY_REJECT             -1
 #define SECURITY_TRUST              0
@@ -166,7 +169,7 @@ pgmoneta_remote_management_auth(int client_fd, char* address, SSL** client_ssl)
          SSL_CTX* ctx = NULL;
 
          /* We are acting as a server against the client */
-         if (pgmoneta_create_ssl_ctx(false, &ctx))
+         if (pgmoneta_create_ssl_ctx(false, TLS_KTLS_OFF, &ctx))
          {
             goto error;
          }
@@ -393,7 +396,7 @@ pgmoneta_remote_management_scram_sha256(char* username, char* password, int serv
 
                if (msg->kind == 'S')
                {
-                  if (pgmoneta_create_ssl_ctx(true, &ctx))
+                  if (pgmoneta_create_ssl_ctx(true, TLS_KTLS_OFF, &ctx))
                   {
                      goto error;
                   }
@@ -1112,7 +1115,10 @@ pgmoneta_server_authenticate(int server, char* database, char* username, char* p
    }
    else
    {
-      ret = pgmoneta_connect(config->common.servers[server].host, config->common.servers[server].port, &server_fd);
+      struct socket_options options;
+
+      pgmoneta_socket_options(server, &options);
+      ret = pgmoneta_connect(config->common.servers[server].host, config->common.servers[server].port, &options, &server_fd);
    }
 
    if (ret != 0)
@@ -1142,7 +1148,7 @@ pgmoneta_server_authenticate(int server, char* database, char* username, char* p
    {
       SSL_CTX* ctx = NULL;
 
-      if (pgmoneta_create_ssl_ctx(true, &ctx))
+      if (pgmoneta_create_ssl_ctx(true, config->tls_ktls, &ctx))
       {
          goto error;
       }
@@ -1195,6 +1201,8 @@ pgmoneta_server_authenticate(int server, char* database, char* username, char* p
          }
       }
       while (connect != 1);
+
+      pgmoneta_ssl_ktls_account(c_ssl, config->tls_ktls, config->common.servers[server].name, &config->common.servers[server].tls);
    }
 
    ret = pgmoneta_create_startup_message(username, database, replication, &startup_msg);
@@ -2765,7 +2773,7 @@ error:
    return 1;
 }
 int
-pgmoneta_create_ssl_ctx(bool client, SSL_CTX** ctx)
+pgmoneta_create_ssl_ctx(bool client, int ktls, SSL_CTX** ctx)
 {
    SSL_CTX* c = NULL;
 
@@ -2801,6 +2809,19 @@ pgmoneta_create_ssl_ctx(bool client, SSL_CTX** ctx)
    SSL_CTX_set_options(c, SSL_OP_NO_TICKET);
    SSL_CTX_set_session_cache_mode(c, SSL_SESS_CACHE_OFF);
 
+   if (ktls != TLS_KTLS_OFF)
+   {
+#ifdef SSL_OP_ENABLE_KTLS
+      /* OpenSSL falls back to user space when the kernel or the cipher can't do it */
+      SSL_CTX_set_options(c, SSL_OP_ENABLE_KTLS);
+#else
+      if (ktls == TLS_KTLS_ON)
+      {
+         pgmoneta_log_warn("kTLS is not supported by the OpenSSL library");
+      }
+#endif
+   }
+
    *ctx = c;
 
    return 0;
@@ -3188,23 +3209,99 @@ error:
    return 1;
 }
 
-#ifdef HAVE_CRC32_SSE42
-static int
-cpu_supports_sse42(void)
+#define CRC32C_POLY  0x82F63B78
+#define CRC32C_LONG  8192
+#define CRC32C_SHORT 256
+
+static crc_impl_t crc_impls[CRC32C_IMPLEMENTATIONS];
+static int crc_active = CRC32C_SOFTWARE;
+
+/* Operators that shift a CRC over CRC32C_LONG and CRC32C_SHORT zero bytes */
+static uint32_t crc32c_long[4][256];
+static uint32_t crc32c_short[4][256];
+
+/* Folding constants for 128, 512 and 2048 bit strides */
+static uint64_t crc32c_fold[3][2];
+
+/*
+ * Multiply a and b modulo the CRC32C polynomial, both in the reflected
+ * representation where bit 31 is x^0
+ */
+static uint32_t
+crc32c_multmodp(uint32_t a, uint32_t b)
 {
-#if defined(__x86_64__) || defined(__i386__)
-   unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
-   if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+   uint32_t m = (uint32_t)1 << 31;
+   uint32_t p = 0;
+
+   for (;;)
    {
-      return 0;
+      if (a & m)
+      {
+         p ^= b;
+         if ((a & (m - 1)) == 0)
+         {
+            break;
+         }
+      }
+      m >>= 1;
+      b = b & 1 ? (b >> 1) ^ CRC32C_POLY : b >> 1;
    }
-   return (int)((ecx >> 20) & 1u);
-#else
-   return 0;
-#endif
+
+   return p;
 }
 
-#ifdef __x86_64__
+/* x^n modulo the CRC32C polynomial */
+static uint32_t
+crc32c_xnmodp(uint64_t n)
+{
+   uint32_t p = (uint32_t)1 << 31;
+   uint32_t square = (uint32_t)1 << 30;
+
+   while (n > 0)
+   {
+      if (n & 1)
+      {
+         p = crc32c_multmodp(square, p);
+      }
+      square = crc32c_multmodp(square, square);
+      n >>= 1;
+   }
+
+   return p;
+}
+
+static void
+crc32c_shift_table(uint32_t table[4][256], size_t length)
+{
+   uint32_t op = crc32c_xnmodp((uint64_t)length * 8);
+
+   for (int i = 0; i < 4; i++)
+   {
+      for (uint32_t v = 0; v < 256; v++)
+      {
+         table[i][v] = crc32c_multmodp(op, v << (8 * i));
+      }
+   }
+}
+
+static inline uint32_t
+crc32c_shift(uint32_t table[4][256], uint32_t crc)
+{
+   return table[0][crc & 0xFF] ^ table[1][(crc >> 8) & 0xFF] ^
+          table[2][(crc >> 16) & 0xFF] ^ table[3][crc >> 24];
+}
+
+static inline uint64_t
+crc32c_load64(const unsigned char* p)
+{
+   uint64_t v;
+
+   memcpy(&v, p, sizeof(v));
+
+   return v;
+}
+
+#if defined(HAVE_CRC32_SSE42) && defined(__x86_64__)
 __attribute__((target("sse4.2"))) static int
 pgmoneta_crc32c_sse42(const void* buffer, size_t size, uint32_t* crc)
 {
@@ -3215,17 +3312,10 @@ pgmoneta_crc32c_sse42(const void* buffer, size_t size, uint32_t* crc)
    // Process eight bytes at a time (x86_64 only)
    while (p + 8 <= pend)
    {
-      crc32 = _mm_crc32_u64(crc32, *(const uint64_t*)p);
+      crc32 = (uint32_t)_mm_crc32_u64(crc32, crc32c_load64(p));
       p += 8;
    }
 
-   // Process remaining full four bytes if any
-   if (p + 4 <= pend)
-   {
-      crc32 = _mm_crc32_u32(crc32, *(const uint32_t*)p);
-      p += 4;
-   }
-
    // Process any remaining bytes one at a time
    while (p < pend)
    {
@@ -3237,8 +3327,273 @@ pgmoneta_crc32c_sse42(const void* buffer, size_t size, uint32_t* crc)
 
    return 0;
 }
-#endif // __x86_64__
 
+/*
+ * The crc32 instruction has a latency of three cycles but a throughput of one,
+ * so run three independent chains over adjacent blocks and merge them with
+ * the shift tables
+ */
+__attribute__((target("sse4.2"))) static int
+pgmoneta_crc32c_sse42_3way(const void* buffer, size_t size, uint32_t* crc)
+{
+   uint32_t crc0 = *crc;
+   uint32_t crc1;
+   uint32_t crc2;
+   size_t block = CRC32C_LONG;
+   uint32_t(*table)[256] = crc32c_long;
+   const unsigned char* p = (const unsigned char*)buffer;
+   const unsigned char* end;
+
+   while (size > 0 && ((uintptr_t)p & 7) != 0)
+   {
+      crc0 = _mm_crc32_u8(crc0, *p);
+      p++;
+      size--;
+   }
+
+   for (int pass = 0; pass < 2; pass++)
+   {
+      while (size >= 3 * block)
+      {
+         crc1 = 0;
+         crc2 = 0;
+         end = p + block;
+
+         while (p < end)
+         {
+            crc0 = (uint32_t)_mm_crc32_u64(crc0, crc32c_load64(p));
+            crc1 = (uint32_t)_mm_crc32_u64(crc1, crc32c_load64(p + block));
+            crc2 = (uint32_t)_mm_crc32_u64(crc2, crc32c_load64(p + 2 * block));
+            p += 8;
+         }
+
+         crc0 = crc32c_shift(table, crc0) ^ crc1;
+         crc0 = crc32c_shift(table, crc0) ^ crc2;
+
+         p += 2 * block;
+         size -= 3 * block;
+      }
+
+      block = CRC32C_SHORT;
+      table = crc32c_short;
+   }
+
+   *crc = crc0;
+
+   return pgmoneta_crc32c_sse42(p, size, crc);
+}
+
+/* Fold x forward over the stride encoded in k and add y */
+__attribute__((target("sse4.2,pclmul"))) static inline __m128i
+crc32c_fold_128(__m128i x, __m128i k, __m128i y)
+{
+   return _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x, k, 0x00),
+                                      _mm_clmulepi64_si128(x, k, 0x11)),
+                        y);
+}
+
+/* Fold the remaining 16 byte blocks into x, reduce it and finish the tail */
+__attribute__((target("sse4.2,pclmul"))) static int
+crc32c_fold_finish(__m128i x, const unsigned char* p, size_t size, uint32_t* crc)
+{
+   __m128i k = _mm_set_epi64x((long long)crc32c_fold[0][1], (long long)crc32c_fold[0][0]);
+   uint32_t crc0;
+
+   while (size >= 16)
+   {
+      x = crc32c_fold_128(x, k, _mm_loadu_si128((const __m128i*)p));
+      p += 16;
+      size -= 16;
+   }
+
+   crc0 = (uint32_t)_mm_crc32_u64(0, (uint64_t)_mm_cvtsi128_si64(x));
+   crc0 = (uint32_t)_mm_crc32_u64(crc0, (uint64_t)_mm_extract_epi64(x, 1));
+
+   *crc = crc0;
+
+   return pgmoneta_crc32c_sse42(p, size, crc);
+}
+
+/*
+ * Carry-less multiplication folding over four 128 bit lanes, see
+ * "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction"
+ */
+__attribute__((target("sse4.2,pclmul"))) static int
+pgmoneta_crc32c_pclmul(const void* buffer, size_t size, uint32_t* crc)
+{
+   const unsigned char* p = (const unsigned char*)buffer;
+   __m128i x0, x1, x2, x3, k;
+
+   if (size < 128)
+   {
+      return pgmoneta_crc32c_sse42(buffer, size, crc);
+   }
+
+   x0 = _mm_xor_si128(_mm_loadu_si128((const __m128i*)p), _mm_cvtsi32_si128((int)*crc));
+   x1 = _mm_loadu_si128((const __m128i*)(p + 16));
+   x2 = _mm_loadu_si128((const __m128i*)(p + 32));
+   x3 = _mm_loadu_si128((const __m128i*)(p + 48));
+   p += 64;
+   size -= 64;
+
+   k = _mm_set_epi64x((long long)crc32c_fold[1][1], (long long)crc32c_fold[1][0]);
+   while (size >= 64)
+   {
+      x0 = crc32c_fold_128(x0, k, _mm_loadu_si128((const __m128i*)p));
+      x1 = crc32c_fold_128(x1, k, _mm_loadu_si128((const __m128i*)(p + 16)));
+      x2 = crc32c_fold_128(x2, k, _mm_loadu_si128((const __m128i*)(p + 32)));
+      x3 = crc32c_fold_128(x3, k, _mm_loadu_si128((const __m128i*)(p + 48)));
+      p += 64;
+      size -= 64;
+   }
+
+   k = _mm_set_epi64x((long long)crc32c_fold[0][1], (long long)crc32c_fold[0][0]);
+   x0 = crc32c_fold_128(x0, k, x1);
+   x0 = crc32c_fold_128(x0, k, x2);
+   x0 = crc32c_fold_128(x0, k, x3);
+
+   return crc32c_fold_finish(x0, p, size, crc);
+}
+
+__attribute__((target("sse4.2,pclmul,avx512f,avx512vl,vpclmulqdq"))) static inline __m512i
+crc32c_fold_512(__m512i x, __m512i k, __m512i y)
+{
+   return _mm512_ternarylogic_epi64(_mm512_clmulepi64_epi128(x, k, 0x00),
+                                    _mm512_clmulepi64_epi128(x, k, 0x11),
+                                    y, 0x96);
+}
+
+/* The same folding over four 512 bit registers, 256 bytes per iteration */
+__attribute__((target("sse4.2,pclmul,avx512f,avx512vl,vpclmulqdq"))) static int
+pgmoneta_crc32c_vpclmul(const void* buffer, size_t size, uint32_t* crc)
+{
+   const unsigned char* p = (const unsigned char*)buffer;
+   __m512i z0, z1, z2, z3, k;
+   __m128i x, k128;
+
+   if (size < 512)
+   {
+      return pgmoneta_crc32c_pclmul(buffer, size, crc);
+   }
+
+   z0 = _mm512_xor_si512(_mm512_loadu_si512(p),
+                         _mm512_inserti32x4(_mm512_setzero_si512(), _mm_cvtsi32_si128((int)*crc), 0));
+   z1 = _mm512_loadu_si512(p + 64);
+   z2 = _mm512_loadu_si512(p + 128);
+   z3 = _mm512_loadu_si512(p + 192);
+   p += 256;
+   size -= 256;
+
+   k = _mm512_broadcast_i32x4(_mm_set_epi64x((long long)crc32c_fold[2][1], (long long)crc32c_fold[2][0]));
+   while (size >= 256)
+   {
+      z0 = crc32c_fold_512(z0, k, _mm512_loadu_si512(p));
+      z1 = crc32c_fold_512(z1, k, _mm512_loadu_si512(p + 64));
+      z2 = crc32c_fold_512(z2, k, _mm512_loadu_si512(p + 128));
+      z3 = crc32c_fold_512(z3, k, _mm512_loadu_si512(p + 192));
+      p += 256;
+      size -= 256;
+   }
+
+   k = _mm512_broadcast_i32x4(_mm_set_epi64x((long long)crc32c_fold[1][1], (long long)crc32c_fold[1][0]));
+   z0 = crc32c_fold_512(z0, k, z1);
+   z0 = crc32c_fold_512(z0, k, z2);
+   z0 = crc32c_fold_512(z0, k, z3);
+
+   while (size >= 64)
+   {
+      z0 = crc32c_fold_512(z0, k, _mm512_loadu_si512(p));
+      p += 64;
+      size -= 64;
+   }
+
+   k128 = _mm_set_epi64x((long long)crc32c_fold[0][1], (long long)crc32c_fold[0][0]);
+   x = _mm512_extracti32x4_epi32(z0, 0);
+   x = crc32c_fold_128(x, k128, _mm512_extracti32x4_epi32(z0, 1));
+   x = crc32c_fold_128(x, k128, _mm512_extracti32x4_epi32(z0, 2));
+   x = crc32c_fold_128(x, k128, _mm512_extracti32x4_epi32(z0, 3));
+
+   return crc32c_fold_finish(x, p, size, crc);
+}
+#endif // HAVE_CRC32_SSE42 && __x86_64__
+
+#if defined(HAVE_CRC32C) && defined(__aarch64__)
+/* Three interleaved chains, as the x86_64 kernel */
+static int
+pgmoneta_crc32c_armv8(const void* buffer, size_t size, uint32_t* crc)
+{
+   uint32_t crc0 = *crc;
+   uint32_t crc1;
+   uint32_t crc2;
+   size_t block = CRC32C_LONG;
+   uint32_t(*table)[256] = crc32c_long;
+   const unsigned char* p = (const unsigned char*)buffer;
+   const unsigned char* end;
+
+   while (size > 0 && ((uintptr_t)p & 7) != 0)
+   {
+      crc0 = __crc32cb(crc0, *p);
+      p++;
+      size--;
+   }
+
+   for (int pass = 0; pass < 2; pass++)
+   {
+      while (size >= 3 * block)
+      {
+         crc1 = 0;
+         crc2 = 0;
+         end = p + block;
+
+         while (p < end)
+         {
+            crc0 = __crc32cd(crc0, crc32c_load64(p));
+            crc1 = __crc32cd(crc1, crc32c_load64(p + block));
+            crc2 = __crc32cd(crc2, crc32c_load64(p + 2 * block));
+            p += 8;
+         }
+
+         crc0 = crc32c_shift(table, crc0) ^ crc1;
+         crc0 = crc32c_shift(table, crc0) ^ crc2;
+
+         p += 2 * block;
+         size -= 3 * block;
+      }
+
+      block = CRC32C_SHORT;
+      table = crc32c_short;
+   }
+
+   while (size >= 8)
+   {
+      crc0 = __crc32cd(crc0, crc32c_load64(p));
+      p += 8;
+      size -= 8;
+   }
+
+   while (size > 0)
+   {
+      crc0 = __crc32cb(crc0, *p);
+      p++;
+      size--;
+   }
+
+   *crc = crc0;
+
+   return 0;
+}
+
+static bool
+cpu_supports_armv8_crc32(void)
+{
+#if defined(__linux__) && defined(HWCAP_CRC32)
+   return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+#else
+   /* The CRC32 extension is mandatory from ARMv8.1 on */
+   return true;
+#endif
+}
+#endif // HAVE_CRC32C && __aarch64__
 static int
 pgmoneta_crc32c_software(const void* buffer, size_t size, uint32_t* crc)
 {
@@ -3318,22 +3673,127 @@ pgmoneta_crc32c_software(const void* buffer, size_t size, uint32_t* crc)
 
    return 0;
 }
-#endif // HAVE_CRC32_SSE42
 
 void
 pgmoneta_crc_init(void)
 {
-#ifdef HAVE_CRC32_SSE42
-#if defined(__x86_64__) || defined(__i386__)
-   if (cpu_supports_sse42())
+   int best = CRC32C_SOFTWARE;
+
+   crc32c_shift_table(crc32c_long, CRC32C_LONG);
+   crc32c_shift_table(crc32c_short, CRC32C_SHORT);
+
+   /*
+    * Folding a 128 bit block X = X_H * x^64 + X_L forward over D bits is
+    * X_H * (x^(63 + D) mod P) * x + X_L * (x^(D - 1) mod P) * x, where the
+    * extra x comes from the carry-less multiplication of reflected operands
+    */
+   for (int i = 0; i < 3; i++)
    {
-      crc_impl = pgmoneta_crc32c_sse42;
-      return;
+      uint64_t d = (uint64_t)128 << (2 * i);
+
+      crc32c_fold[i][0] = (uint64_t)crc32c_xnmodp(63 + d) << 32;
+      crc32c_fold[i][1] = (uint64_t)crc32c_xnmodp(d - 1) << 32;
+   }
+
+   memset(crc_impls, 0, sizeof(crc_impls));
+   crc_impls[CRC32C_SOFTWARE] = pgmoneta_crc32c_software;
+
+#if defined(HAVE_CRC32_SSE42) && defined(__x86_64__)
+   __builtin_cpu_init();
+
+   if (__builtin_cpu_supports("sse4.2"))
+   {
+      crc_impls[CRC32C_SSE42] = pgmoneta_crc32c_sse42;
+      crc_impls[CRC32C_SSE42_3WAY] = pgmoneta_crc32c_sse42_3way;
+      best = CRC32C_SSE42_3WAY;
+
+      if (__builtin_cpu_supports("pclmul"))
+      {
+         crc_impls[CRC32C_PCLMUL] = pgmoneta_crc32c_pclmul;
+         best = CRC32C_PCLMUL;
+
+         if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl") &&
+             __builtin_cpu_supports("vpclmulqdq"))
+         {
+            crc_impls[CRC32C_VPCLMUL] = pgmoneta_crc32c_vpclmul;
+            best = CRC32C_VPCLMUL;
+         }
+      }
    }
 #endif
 
-   crc_impl = pgmoneta_crc32c_software;
+#if defined(HAVE_CRC32C) && defined(__aarch64__)
+   if (cpu_supports_armv8_crc32())
+   {
+      crc_impls[CRC32C_ARMV8] = pgmoneta_crc32c_armv8;
+      best = CRC32C_ARMV8;
+   }
 #endif
+
+   crc_active = best;
+   crc_impl = crc_impls[best];
+}
+
+int
+pgmoneta_crc32c_implementation(void)
+{
+   if (crc_impl == NULL)
+   {
+      pgmoneta_crc_init();
+   }
+
+   return crc_active;
+}
+
+char*
+pgmoneta_crc32c_implementation_name(int implementation)
+{
+   switch (implementation)
+   {
+      case CRC32C_SOFTWARE:
+         return "software";
+      case CRC32C_SSE42:
+         return "sse4.2";
+      case CRC32C_SSE42_3WAY:
+         return "sse4.2-3way";
+      case CRC32C_PCLMUL:
+         return "pclmul";
+      case CRC32C_VPCLMUL:
+         return "vpclmul";
+      case CRC32C_ARMV8:
+         return "armv8";
+      default:
+         break;
+   }
+
+   return "unknown";
+}
+
+bool
+pgmoneta_crc32c_supported(int implementation)
+{
+   if (crc_impl == NULL)
+   {
+      pgmoneta_crc_init();
+   }
+
+   if (implementation < 0 || implementation >= CRC32C_IMPLEMENTATIONS)
+   {
+      return false;
+   }
+
+   return crc_impls[implementation] != NULL;
+}
+
+int
+pgmoneta_create_crc32c_buffer_with(int implementation, void* buffer, size_t size, uint32_t* crc)
+{
+   if (buffer == NULL || !pgmoneta_crc32c_supported(implementation))
+   {
+      return 1;
+   }
+
+   return crc_impls[implementation](buffer, size, crc);
 }
 
 int
@@ -3410,6 +3870,67 @@ error:
    return 1;
 }
 
+int
+pgmoneta_ssl_ktls(SSL* ssl)
+{
+   int ktls = 0;
+
+   if (ssl == NULL)
+   {
+      return 0;
+   }
+
+#if defined(BIO_get_ktls_send) && defined(BIO_get_ktls_recv)
+   if (BIO_get_ktls_send(SSL_get_wbio(ssl)))
+   {
+      ktls |= KTLS_SEND;
+   }
+   if (BIO_get_ktls_recv(SSL_get_rbio(ssl)))
+   {
+      ktls |= KTLS_RECEIVE;
+   }
+#endif
+
+   return ktls;
+}
+
+void
+pgmoneta_ssl_ktls_account(SSL* ssl, int ktls, char* peer, struct tls_statistics* statistics)
+{
+   int active;
+
+   if (ssl == NULL)
+   {
+      return;
+   }
+
+   active = pgmoneta_ssl_ktls(ssl);
+
+   if (statistics != NULL)
+   {
+      atomic_fetch_add(&statistics->connections, 1);
+      if (active & KTLS_SEND)
+      {
+         atomic_fetch_add(&statistics->ktls_send, 1);
+      }
+      if (active & KTLS_RECEIVE)
+      {
+         atomic_fetch_add(&statistics->ktls_receive, 1);
+      }
+   }
+
+   if (ktls == TLS_KTLS_ON && active != (KTLS_SEND | KTLS_RECEIVE))
+   {
+      pgmoneta_log_warn("kTLS is not active for %s (send: %s, receive: %s)", peer,
+                        (active & KTLS_SEND) ? "on" : "off", (active & KTLS_RECEIVE) ? "on" : "off");
+   }
+   else if (ktls != TLS_KTLS_OFF)
+   {
+      pgmoneta_log_debug("kTLS for %s (send: %s, receive: %s)", peer,
+                         (active & KTLS_SEND) ? "on" : "off", (active & KTLS_RECEIVE) ? "on" : "off");
+   }
+}
+
 void
 pgmoneta_close_ssl(SSL* ssl)
 {
@@ -3608,3 +4129,291 @@ pgmoneta_hasher_destroy(struct hasher* hasher)
    free(hasher->hash);
    free(hasher);
 }
+
+int
+pgmoneta_tree_hasher_create(struct tree_hasher** hasher)
+{
+   struct tree_hasher* h = NULL;
+
+   *hasher = NULL;
+
+   h = malloc(sizeof(struct tree_hasher));
+   if (h == NULL)
+   {
+      goto error;
+   }
+
+   memset(h, 0, sizeof(struct tree_hasher));
+
+   h->md_ctx = EVP_MD_CTX_new();
+   if (h->md_ctx == NULL)
+   {
+      goto error;
+   }
+
+   *hasher = h;
+
+   return 0;
+
+error:
+   pgmoneta_tree_hasher_destroy(h);
+
+   return 1;
+}
+
+int
+pgmoneta_tree_hasher_update(struct tree_hasher* hasher, void* buffer, size_t size)
+{
+   unsigned char* b = (unsigned char*)buffer;
+   unsigned int md_len = 0;
+
+   if (hasher == NULL || (buffer == NULL && size > 0))
+   {
+      goto error;
+   }
+
+   while (size > 0)
+   {
+      size_t n = MIN(size, (size_t)TREE_HASH_LEAF_SIZE - hasher->leaf_fill);
+
+      if (hasher->leaf_fill == 0)
+      {
+         if (!EVP_DigestInit_ex(hasher->md_ctx, EVP_sha512(), NULL))
+         {
+            goto error;
+         }
+      }
+
+      if (!EVP_DigestUpdate(hasher->md_ctx, b, n))
+      {
+         goto error;
+      }
+
+      hasher->leaf_fill += n;
+      hasher->size += n;
+      b += n;
+      size -= n;
+
+      if (hasher->leaf_fill == TREE_HASH_LEAF_SIZE)
+      {
+         if (hasher->leaves == hasher->capacity)
+         {
+            size_t capacity = hasher->capacity == 0 ? 64 : hasher->capacity * 2;
+            unsigned char* d = realloc(hasher->digests, capacity * TREE_HASH_DIGEST_SIZE);
+
+            if (d == NULL)
+            {
+               goto error;
+            }
+
+            hasher->digests = d;
+            hasher->capacity = capacity;
+         }
+
+         if (!EVP_DigestFinal_ex(hasher->md_ctx, hasher->digests + hasher->leaves * TREE_HASH_DIGEST_SIZE, &md_len))
+         {
+            goto error;
+         }
+
+         hasher->leaves++;
+         hasher->leaf_fill = 0;
+      }
+   }
+
+   return 0;
+
+error:
+   pgmoneta_log_error("Tree hash update failed");
+   return 1;
+}
+
+int
+pgmoneta_tree_hasher_final(struct tree_hasher* hasher, char** hash)
+{
+   unsigned int md_len = 0;
+
+   *hash = NULL;
+
+   if (hasher == NULL)
+   {
+      goto error;
+   }
+
+   if (hasher->leaf_fill > 0)
+   {
+      if (hasher->leaves == hasher->capacity)
+      {
+         unsigned char* d = realloc(hasher->digests, (hasher->capacity + 1) * TREE_HASH_DIGEST_SIZE);
+
+         if (d == NULL)
+         {
+            goto error;
+         }
+
+         hasher->digests = d;
+         hasher->capacity++;
+      }
+
+      if (!EVP_DigestFinal_ex(hasher->md_ctx, hasher->digests + hasher->leaves * TREE_HASH_DIGEST_SIZE, &md_len))
+      {
+         goto error;
+      }
+
+      hasher->leaves++;
+      hasher->leaf_fill = 0;
+   }
+
+   return pgmoneta_create_sha512_tree_root(hasher->digests, hasher->leaves, hasher->size, hash);
+
+error:
+   return 1;
+}
+
+void
+pgmoneta_tree_hasher_destroy(struct tree_hasher* hasher)
+{
+   if (hasher == NULL)
+   {
+      return;
+   }
+
+   if (hasher->md_ctx != NULL)
+   {
+      EVP_MD_CTX_free(hasher->md_ctx);
+   }
+
+   free(hasher->digests);
+   free(hasher);
+}
+
+int
+pgmoneta_create_sha512_leaf(char* filename, uint64_t leaf, unsigned char* digest)
+{
+   EVP_MD_CTX* md_ctx = NULL;
+   unsigned int md_len = 0;
+   char* buffer = NULL;
+   off_t offset = (off_t)(leaf * TREE_HASH_LEAF_SIZE);
+   size_t remaining = TREE_HASH_LEAF_SIZE;
+   ssize_t r = 0;
+   int fd = -1;
+
+   fd = open(filename, O_RDONLY);
+   if (fd == -1)
+   {
+      goto error;
+   }
+
+   buffer = malloc(DEFAULT_BUFFER_SIZE);
+   md_ctx = EVP_MD_CTX_new();
+   if (buffer == NULL || md_ctx == NULL || !EVP_DigestInit_ex(md_ctx, EVP_sha512(), NULL))
+   {
+      goto error;
+   }
+
+   while (remaining > 0)
+   {
+      r = pread(fd, buffer, MIN(remaining, (size_t)DEFAULT_BUFFER_SIZE), offset);
+      if (r < 0)
+      {
+         goto error;
+      }
+      else if (r == 0)
+      {
+         break;
+      }
+
+      if (!EVP_DigestUpdate(md_ctx, buffer, (size_t)r))
+      {
+         goto error;
+      }
+
+      offset += r;
+      remaining -= (size_t)r;
+   }
+
+   if (!EVP_DigestFinal_ex(md_ctx, digest, &md_len))
+   {
+      goto error;
+   }
+
+   EVP_MD_CTX_free(md_ctx);
+   free(buffer);
+   close(fd);
+
+   return 0;
+
+error:
+   pgmoneta_log_error("Could not hash leaf %" PRIu64 " of %s", leaf, filename);
+
+   EVP_MD_CTX_free(md_ctx);
+   free(buffer);
+   if (fd != -1)
+   {
+      close(fd);
+   }
+
+   return 1;
+}
+
+int
+pgmoneta_create_sha512_tree_root(unsigned char* digests, size_t leaves, uint64_t size, char** hash)
+{
+   EVP_MD_CTX* md_ctx = NULL;
+   unsigned char md_value[EVP_MAX_MD_SIZE];
+   unsigned char header[16];
+   unsigned int md_len = 0;
+   uint64_t leaf_size = TREE_HASH_LEAF_SIZE;
+   char* h = NULL;
+
+   *hash = NULL;
+
+   for (int i = 0; i < 8; i++)
+   {
+      header[i] = (unsigned char)(leaf_size >> (56 - 8 * i));
+      header[8 + i] = (unsigned char)(size >> (56 - 8 * i));
+   }
+
+   md_ctx = EVP_MD_CTX_new();
+   if (md_ctx == NULL || !EVP_DigestInit_ex(md_ctx, EVP_sha512(), NULL))
+   {
+      goto error;
+   }
+
+   if (!EVP_DigestUpdate(md_ctx, header, sizeof(header)))
+   {
+      goto error;
+   }
+
+   if (leaves > 0 && !EVP_DigestUpdate(md_ctx, digests, leaves * TREE_HASH_DIGEST_SIZE))
+   {
+      goto error;
+   }
+
+   if (!EVP_DigestFinal_ex(md_ctx, md_value, &md_len))
+   {
+      goto error;
+   }
+
+   h = malloc(md_len * 2 + 1);
+   if (h == NULL)
+   {
+      goto error;
+   }
+
+   for (unsigned int i = 0; i < md_len; i++)
+   {
+      sprintf(&h[i * 2], "%02x", md_value[i]);
+   }
+   h[md_len * 2] = 0;
+
+   *hash = h;
+
+   EVP_MD_CTX_free(md_ctx);
+
+   return 0;
+
+error:
+   EVP_MD_CTX_free(md_ctx);
+
+   return 1;
+}
@@ -278,12 +278,16 @@ bool
 pgmoneta_server_verify_connection(int srv)
 {
    int fd = -1;
+   struct socket_options options;
    struct main_configuration* config;
 
    config = (struct main_configuration*)shmem;
 
+   pgmoneta_socket_options(srv, &options);
+
    if (pgmoneta_connect(config->common.servers[srv].host,
                         config->common.servers[srv].port,
+                        &options,
                         &fd))
    {
       pgmoneta_log_debug("No connection to %s:%d",
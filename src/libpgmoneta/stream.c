@@ -32,11 +32,45 @@
 #include <deque.h>
 #include <extraction.h>
 #include <logging.h>
+#include <progress.h>
+#include <security.h>
 #include <stream.h>
 #include <utils.h>
 #include <value.h>
+#include <workers.h>
 
+#include <dirent.h>
+#include <pthread.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <sys/stat.h>
+
+/** @struct vfile_digest
+ * Defines a destination that only hashes what is written to it
+ */
+struct vfile_digest
+{
+   struct vfile super;     /**< The vfile */
+   struct hasher* sha256;  /**< The SHA-256 hasher */
+   struct hasher* sha512;  /**< The SHA-512 hasher */
+   uint32_t crc32c;        /**< The running CRC32C */
+   size_t size;            /**< The number of bytes hashed */
+};
+
+/** @struct stream_file_task
+ * Defines a file to compress and encrypt in a worker
+ */
+struct stream_file_task
+{
+   struct worker_common common; /**< The common base */
+   char from[MAX_PATH];         /**< The source file */
+   char to[MAX_PATH];           /**< The destination file */
+   int compression;             /**< The compression mode */
+   int encryption;              /**< The encryption mode */
+   int server;                  /**< The server index for progress */
+   bool progress_enabled;       /**< Is progress tracking enabled */
+   struct art* digests;         /**< The map the digests are added to, may be NULL */
+};
 
 static int noop_stream_cb(struct streamer* this, bool last_chunk);
 static int backup_stream_cb(struct streamer* this, bool last_chunk);
@@ -44,6 +78,15 @@ static int restore_stream_cb(struct streamer* this, bool last_chunk);
 static int get_backup_file_name_cb(struct streamer* this, char* file_name, char** dest_file_name);
 static int get_restore_file_name_cb(struct streamer* this, char* file_name, char** dest_file_name);
 static void vfile_destroy_cb(uintptr_t val);
+static int vfile_digest_write(struct vfile* vfile, void* buffer, size_t size, bool last_chunk);
+static void vfile_digest_close(struct vfile* vfile);
+static void digest_key(char* path, char* key, size_t size);
+static int64_t mtime_ns(struct stat* st);
+
+/* The workers of a directory share the digests map */
+static pthread_mutex_t digests_lock = PTHREAD_MUTEX_INITIALIZER;
+static void do_stream_file(struct worker_common* wc);
+static int dispatch_stream_file(int server, char* from, char* to, int compression, int encryption, struct workers* workers, struct art* digests);
 
 int
 pgmoneta_streamer_create(int mode, int encryption, int compression, struct streamer** streamer)
@@ -219,6 +262,7 @@ noop_stream_cb(struct streamer* this, bool last_chunk)
       if (f->write(f, this->buffer, this->size, last_chunk))
       {
          pgmoneta_log_error("Failed to write buffer");
+         goto error;
       }
    }
    pgmoneta_deque_iterator_destroy(vfile_iter);
@@ -267,9 +311,10 @@ backup_stream_cb(struct streamer* this, bool last_chunk)
       while (pgmoneta_deque_iterator_next(vfile_iter))
       {
          f = (struct vfile*)pgmoneta_value_data(vfile_iter->value);
-         if (f->write(f, ebuf, ebuf_size, last_chunk))
+         if (f->write(f, ebuf, ebuf_size, finished && last_chunk))
          {
             pgmoneta_log_error("Failed to write buffer");
+            goto error;
          }
       }
       pgmoneta_deque_iterator_destroy(vfile_iter);
@@ -327,9 +372,10 @@ restore_stream_cb(struct streamer* this, bool last_chunk)
       while (pgmoneta_deque_iterator_next(vfile_iter))
       {
          f = (struct vfile*)pgmoneta_value_data(vfile_iter->value);
-         if (f->write(f, cbuf, cbuf_size, last_chunk))
+         if (f->write(f, cbuf, cbuf_size, finished && last_chunk))
          {
             pgmoneta_log_error("Failed to write buffer");
+            goto error;
          }
       }
       pgmoneta_deque_iterator_destroy(vfile_iter);
@@ -344,6 +390,541 @@ error:
    return 1;
 }
 
+int
+pgmoneta_stream_file(char* from, char* to, int compression, int encryption, struct stream_digests* digests)
+{
+   struct streamer* streamer = NULL;
+   struct vfile* destination = NULL;
+   struct vfile* digest = NULL;
+   char* tmp = NULL;
+   char* buffer = NULL;
+   FILE* in = NULL;
+   size_t size = 0;
+   bool last_chunk = false;
+
+   if (from == NULL || to == NULL)
+   {
+      goto error;
+   }
+
+   tmp = pgmoneta_append(tmp, to);
+   tmp = pgmoneta_append(tmp, ".tmp");
+
+   buffer = malloc(BUFFER_SIZE);
+   if (buffer == NULL)
+   {
+      goto error;
+   }
+
+   in = fopen(from, "rb");
+   if (in == NULL)
+   {
+      pgmoneta_log_error("pgmoneta_stream_file: could not open %s", from);
+      goto error;
+   }
+
+   if (pgmoneta_streamer_create(STREAMER_MODE_BACKUP, encryption, compression, &streamer))
+   {
+      goto error;
+   }
+
+   if (pgmoneta_vfile_create_local(tmp, "wb", &destination))
+   {
+      goto error;
+   }
+
+   if (pgmoneta_streamer_add_destination(streamer, destination))
+   {
+      pgmoneta_vfile_destroy(destination);
+      goto error;
+   }
+
+   if (digests != NULL)
+   {
+      if (pgmoneta_stream_digest_create(&digest))
+      {
+         goto error;
+      }
+
+      if (pgmoneta_streamer_add_destination(streamer, digest))
+      {
+         pgmoneta_vfile_destroy(digest);
+         digest = NULL;
+         goto error;
+      }
+   }
+
+   while (!last_chunk)
+   {
+      size = fread(buffer, 1, BUFFER_SIZE, in);
+      if (ferror(in))
+      {
+         pgmoneta_log_error("pgmoneta_stream_file: could not read %s", from);
+         goto error;
+      }
+      last_chunk = size < BUFFER_SIZE;
+
+      if (pgmoneta_streamer_write(streamer, buffer, size, last_chunk))
+      {
+         pgmoneta_log_error("pgmoneta_stream_file: could not stream %s", from);
+         goto error;
+      }
+   }
+
+   if (digests != NULL)
+   {
+      if (pgmoneta_stream_digest_finish(digest, digests))
+      {
+         goto error;
+      }
+   }
+
+   fclose(in);
+   in = NULL;
+
+   /* Closes the destinations */
+   pgmoneta_streamer_destroy(streamer);
+   streamer = NULL;
+
+   pgmoneta_permission(tmp, 6, 0, 0);
+   if (pgmoneta_move_file(tmp, to))
+   {
+      goto error;
+   }
+
+   pgmoneta_delete_file(from, NULL);
+
+   free(buffer);
+   free(tmp);
+
+   return 0;
+
+error:
+
+   if (in != NULL)
+   {
+      fclose(in);
+   }
+
+   pgmoneta_streamer_destroy(streamer);
+
+   if (tmp != NULL && pgmoneta_exists(tmp))
+   {
+      pgmoneta_delete_file(tmp, NULL);
+   }
+
+   free(buffer);
+   free(tmp);
+
+   return 1;
+}
+
+int
+pgmoneta_stream_directory(int server, char* directory, int compression, int encryption, struct workers* workers, struct deque* excludes, struct art* digests)
+{
+   DIR* dir = NULL;
+   struct dirent* entry = NULL;
+   char full_path[MAX_PATH];
+   char* suffix = NULL;
+   char* encryption_suffix = NULL;
+
+   if (directory == NULL)
+   {
+      goto error;
+   }
+
+   if (pgmoneta_extraction_get_suffix(compression, encryption, &suffix) ||
+       pgmoneta_extraction_get_suffix(COMPRESSION_NONE, encryption, &encryption_suffix))
+   {
+      goto error;
+   }
+
+   if (!(dir = opendir(directory)))
+   {
+      goto error;
+   }
+
+   while ((entry = readdir(dir)) != NULL)
+   {
+      char* to = NULL;
+      bool compressed = false;
+
+      if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+      {
+         continue;
+      }
+
+      pgmoneta_snprintf(full_path, sizeof(full_path), "%s/%s", directory, entry->d_name);
+
+      if (entry->d_type == DT_DIR ||
+          ((entry->d_type == DT_LNK || entry->d_type == DT_UNKNOWN) && pgmoneta_is_directory(full_path)))
+      {
+         if (strcmp(entry->d_name, "pg_tblspc") == 0)
+         {
+            continue;
+         }
+
+         if (pgmoneta_stream_directory(server, full_path, compression, encryption, workers, excludes, digests))
+         {
+            goto error;
+         }
+
+         continue;
+      }
+
+      if (entry->d_type != DT_REG &&
+          !((entry->d_type == DT_LNK || entry->d_type == DT_UNKNOWN) && pgmoneta_is_file(full_path)))
+      {
+         continue;
+      }
+
+      if (excludes != NULL)
+      {
+         char* ext = strrchr(entry->d_name, '.');
+
+         if (pgmoneta_deque_exists(excludes, entry->d_name) || (ext != NULL && pgmoneta_deque_exists(excludes, ext)))
+         {
+            continue;
+         }
+      }
+
+      if (pgmoneta_ends_with(entry->d_name, "backup_manifest") ||
+          pgmoneta_ends_with(entry->d_name, "backup_label") ||
+          pgmoneta_ends_with(entry->d_name, ".tmp") ||
+          pgmoneta_ends_with(entry->d_name, ".partial"))
+      {
+         continue;
+      }
+
+      if (pgmoneta_is_encrypted(full_path))
+      {
+         continue;
+      }
+
+      /* Already compressed files only need to be encrypted */
+      compressed = pgmoneta_is_compressed(full_path);
+      if (compressed && encryption == ENCRYPTION_NONE)
+      {
+         continue;
+      }
+
+      to = pgmoneta_append(to, full_path);
+      to = pgmoneta_append(to, compressed ? encryption_suffix : suffix);
+
+      if (dispatch_stream_file(server, full_path, to, compressed ? COMPRESSION_NONE : compression, encryption, workers, digests))
+      {
+         free(to);
+         goto error;
+      }
+
+      free(to);
+   }
+
+   closedir(dir);
+   free(suffix);
+   free(encryption_suffix);
+
+   return 0;
+
+error:
+
+   if (dir != NULL)
+   {
+      closedir(dir);
+   }
+
+   free(suffix);
+   free(encryption_suffix);
+
+   return 1;
+}
+
+static int
+dispatch_stream_file(int server, char* from, char* to, int compression, int encryption, struct workers* workers, struct art* digests)
+{
+   struct stream_file_task* task = NULL;
+
+   if (strlen(from) >= MAX_PATH || strlen(to) >= MAX_PATH)
+   {
+      pgmoneta_log_error("Stream path too long: %s -> %s", from, to);
+      goto error;
+   }
+
+   task = (struct stream_file_task*)malloc(sizeof(struct stream_file_task));
+   if (task == NULL)
+   {
+      goto error;
+   }
+
+   memset(task, 0, sizeof(struct stream_file_task));
+
+   memcpy(task->from, from, strlen(from));
+   memcpy(task->to, to, strlen(to));
+   task->compression = compression;
+   task->encryption = encryption;
+   task->common.workers = workers;
+   task->server = server;
+   task->progress_enabled = (server >= 0 && pgmoneta_is_progress_enabled(server));
+   task->digests = digests;
+
+   if (workers != NULL && workers->outcome)
+   {
+      if (pgmoneta_workers_add(workers, do_stream_file, (struct worker_common*)task))
+      {
+         goto error;
+      }
+   }
+   else
+   {
+      do_stream_file((struct worker_common*)task);
+   }
+
+   return 0;
+
+error:
+   free(task);
+   return 1;
+}
+
+static void
+do_stream_file(struct worker_common* wc)
+{
+   struct stream_file_task* task = (struct stream_file_task*)wc;
+   struct stream_digests digests;
+
+   memset(&digests, 0, sizeof(struct stream_digests));
+
+   if (pgmoneta_stream_file(task->from, task->to, task->compression, task->encryption,
+                            task->digests != NULL ? &digests : NULL))
+   {
+      pgmoneta_log_warn("do_stream_file: %s -> %s", task->from, task->to);
+      if (task->common.workers != NULL)
+      {
+         task->common.workers->outcome = false;
+      }
+   }
+   else if (task->digests != NULL)
+   {
+      pthread_mutex_lock(&digests_lock);
+      if (pgmoneta_stream_digests_add(task->digests, task->to, &digests))
+      {
+         pgmoneta_log_debug("do_stream_file: no digests for %s", task->to);
+      }
+      pthread_mutex_unlock(&digests_lock);
+   }
+
+   if (task->progress_enabled)
+   {
+      pgmoneta_progress_increment(task->server, 1);
+   }
+
+   free(task);
+}
+
+int
+pgmoneta_stream_digest_create(struct vfile** vfile)
+{
+   struct vfile_digest* v = NULL;
+
+   *vfile = NULL;
+
+   v = malloc(sizeof(struct vfile_digest));
+   if (v == NULL)
+   {
+      goto error;
+   }
+
+   memset(v, 0, sizeof(struct vfile_digest));
+   v->super.write = vfile_digest_write;
+   v->super.close = vfile_digest_close;
+   pgmoneta_init_crc32c(&v->crc32c);
+
+   if (pgmoneta_hasher_create("SHA256", &v->sha256) ||
+       pgmoneta_hasher_create("SHA512", &v->sha512))
+   {
+      goto error;
+   }
+
+   *vfile = (struct vfile*)v;
+
+   return 0;
+
+error:
+   if (v != NULL)
+   {
+      vfile_digest_close((struct vfile*)v);
+      free(v);
+   }
+
+   return 1;
+}
+
+static int
+vfile_digest_write(struct vfile* vfile, void* buffer, size_t size, bool last_chunk)
+{
+   struct vfile_digest* this = (struct vfile_digest*)vfile;
+
+   (void)last_chunk;
+
+   if (size == 0)
+   {
+      return 0;
+   }
+
+   this->size += size;
+
+   /* The digests are finalized once the stream is complete */
+   pgmoneta_create_crc32c_buffer(buffer, size, &this->crc32c);
+
+   if (pgmoneta_hasher_update(this->sha256, buffer, size, false) ||
+       pgmoneta_hasher_update(this->sha512, buffer, size, false))
+   {
+      return 1;
+   }
+
+   return 0;
+}
+
+int
+pgmoneta_stream_digest_finish(struct vfile* vfile, struct stream_digests* digests)
+{
+   struct vfile_digest* this = (struct vfile_digest*)vfile;
+   char empty = 0;
+
+   if (this == NULL || digests == NULL)
+   {
+      return 1;
+   }
+
+   if (pgmoneta_hasher_update(this->sha256, &empty, 0, true) ||
+       pgmoneta_hasher_update(this->sha512, &empty, 0, true))
+   {
+      return 1;
+   }
+
+   pgmoneta_snprintf(digests->sha256, sizeof(digests->sha256), "%s", this->sha256->hash);
+   pgmoneta_snprintf(digests->sha512, sizeof(digests->sha512), "%s", this->sha512->hash);
+   digests->crc32c = this->crc32c;
+   pgmoneta_finalize_crc32c(&digests->crc32c);
+   digests->size = this->size;
+
+   return 0;
+}
+
+int
+pgmoneta_stream_digests_add(struct art* map, char* path, struct stream_digests* digests)
+{
+   struct stream_digests* d = NULL;
+   struct stat st;
+   char key[MAX_PATH];
+
+   if (map == NULL || path == NULL || digests == NULL)
+   {
+      return 1;
+   }
+
+   d = malloc(sizeof(struct stream_digests));
+   if (d == NULL)
+   {
+      return 1;
+   }
+
+   memcpy(d, digests, sizeof(struct stream_digests));
+
+   if (stat(path, &st) != 0)
+   {
+      free(d);
+      return 1;
+   }
+
+   d->inode = (uint64_t)st.st_ino;
+   d->mtime = mtime_ns(&st);
+
+   digest_key(path, key, sizeof(key));
+
+   if (pgmoneta_art_insert(map, key, (uintptr_t)d, ValueMem))
+   {
+      free(d);
+      return 1;
+   }
+
+   return 0;
+}
+
+struct stream_digests*
+pgmoneta_stream_digests_get(struct art* map, char* path)
+{
+   struct stream_digests* d = NULL;
+   struct stat st;
+   char key[MAX_PATH];
+
+   if (map == NULL || path == NULL)
+   {
+      return NULL;
+   }
+
+   digest_key(path, key, sizeof(key));
+
+   d = (struct stream_digests*)pgmoneta_art_search(map, key);
+   if (d == NULL)
+   {
+      return NULL;
+   }
+
+   /* A later stage may have rewritten or replaced the file, only trust an unchanged one */
+   if (stat(path, &st) != 0 || !S_ISREG(st.st_mode) || (size_t)st.st_size != d->size ||
+       (uint64_t)st.st_ino != d->inode || mtime_ns(&st) != d->mtime)
+   {
+      return NULL;
+   }
+
+   return d;
+}
+
+static void
+vfile_digest_close(struct vfile* vfile)
+{
+   struct vfile_digest* this = (struct vfile_digest*)vfile;
+
+   if (this == NULL)
+   {
+      return;
+   }
+
+   pgmoneta_hasher_destroy(this->sha256);
+   pgmoneta_hasher_destroy(this->sha512);
+   this->sha256 = NULL;
+   this->sha512 = NULL;
+}
+
+static void
+digest_key(char* path, char* key, size_t size)
+{
+   size_t j = 0;
+
+   /* Collapse repeated separators so that differently joined paths match */
+   for (size_t i = 0; path[i] != '\0' && j + 1 < size; i++)
+   {
+      if (path[i] == '/' && j > 0 && key[j - 1] == '/')
+      {
+         continue;
+      }
+      key[j++] = path[i];
+   }
+
+   key[j] = '\0';
+}
+
+static int64_t
+mtime_ns(struct stat* st)
+{
+#ifdef HAVE_OSX
+   return (int64_t)st->st_mtimespec.tv_sec * 1000000000LL + st->st_mtimespec.tv_nsec;
+#else
+   return (int64_t)st->st_mtim.tv_sec * 1000000000LL + st->st_mtim.tv_nsec;
+#endif
+}
+
 static void
 vfile_destroy_cb(uintptr_t val)
 {
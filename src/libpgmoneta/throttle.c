@@ -0,0 +1,267 @@
+/*
+ * Copyright (C) 2026 The pgmoneta community
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or other
+ * materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may
+ * be used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* pgmoneta */
+#include <pgmoneta.h>
+#include <throttle.h>
+#include <utils.h>
+
+/* system */
+#include <stdatomic.h>
+#include <stdint.h>
+#include <time.h>
+
+#define THROTTLE_WINDOW   1000000000LL /* A class is active for a second after its last I/O */
+#define THROTTLE_MAX_WAIT 100000000LL  /* Recheck the buckets at least every 100ms */
+
+static void throttle_take(struct throttle* throttle, int io_class, int64_t rate, int64_t iops, uint64_t bytes);
+static int64_t throttle_now(void);
+static void bucket_refill(struct throttle_bucket* bucket, int64_t rate, int64_t now);
+static int64_t bucket_wait(struct throttle_bucket* bucket, int64_t rate, int higher, int64_t now);
+static int active_higher(struct throttle* throttle, int io_class, int64_t now);
+
+void
+pgmoneta_throttle_init(struct throttle* throttle)
+{
+   atomic_init(&throttle->bytes.tokens, 0);
+   atomic_init(&throttle->bytes.last, 0);
+   atomic_init(&throttle->operations.tokens, 0);
+   atomic_init(&throttle->operations.last, 0);
+
+   for (int i = 0; i < NUMBER_OF_THROTTLE_CLASSES; i++)
+   {
+      atomic_init(&throttle->active[i], 0);
+      atomic_init(&throttle->waited[i], 0);
+   }
+}
+
+bool
+pgmoneta_throttle_enabled(void)
+{
+   struct main_configuration* config;
+
+   config = (struct main_configuration*)shmem;
+
+   return config != NULL && (config->io_max_rate > 0 || config->io_max_iops > 0);
+}
+
+void
+pgmoneta_throttle(int io_class, uint64_t bytes)
+{
+   int64_t rate = 0;
+   int64_t iops = 0;
+   uint64_t slice = 0;
+   uint64_t charge = 0;
+   struct throttle* throttle = NULL;
+   struct main_configuration* config;
+
+   if (!pgmoneta_throttle_enabled() || io_class < 0 || io_class >= NUMBER_OF_THROTTLE_CLASSES)
+   {
+      return;
+   }
+
+   config = (struct main_configuration*)shmem;
+   throttle = &config->throttle;
+   rate = (int64_t)config->io_max_rate;
+   iops = (int64_t)config->io_max_iops;
+
+   /* A large request is taken in slices of THROTTLE_MAX_WAIT of I/O, so the
+      debt of a single call is bounded and a higher class is not held back */
+   slice = bytes;
+   if (rate > 0 && io_class != THROTTLE_WAL)
+   {
+      slice = (uint64_t)MAX((int64_t)((double)rate * (double)THROTTLE_MAX_WAIT / 1000000000.0), 1LL);
+   }
+
+   do
+   {
+      charge = MIN(bytes, slice);
+      throttle_take(throttle, io_class, rate, iops, charge);
+      bytes -= charge;
+
+      /* The request is a single operation */
+      iops = 0;
+   }
+   while (bytes > 0);
+}
+
+/**
+ * Wait until a class may take tokens, and take them
+ */
+static void
+throttle_take(struct throttle* throttle, int io_class, int64_t rate, int64_t iops, uint64_t bytes)
+{
+   int64_t now = 0;
+   int64_t wait = 0;
+   int higher = 0;
+
+   now = throttle_now();
+   atomic_store(&throttle->active[io_class], now);
+
+   /* WAL streaming is accounted so the other classes back off, but never waits */
+   while (io_class != THROTTLE_WAL)
+   {
+      wait = 0;
+      higher = active_higher(throttle, io_class, now);
+
+      if (rate > 0)
+      {
+         wait = MAX(wait, bucket_wait(&throttle->bytes, rate, higher, now));
+      }
+
+      if (iops > 0)
+      {
+         wait = MAX(wait, bucket_wait(&throttle->operations, iops, higher, now));
+      }
+
+      if (wait == 0)
+      {
+         break;
+      }
+
+      wait = MIN(wait, THROTTLE_MAX_WAIT);
+      atomic_fetch_add(&throttle->waited[io_class], wait);
+      SLEEP(wait);
+
+      now = throttle_now();
+      atomic_store(&throttle->active[io_class], now);
+   }
+
+   if (rate > 0)
+   {
+      bucket_refill(&throttle->bytes, rate, now);
+      atomic_fetch_sub(&throttle->bytes.tokens, (long long)bytes);
+   }
+
+   if (iops > 0)
+   {
+      bucket_refill(&throttle->operations, iops, now);
+      atomic_fetch_sub(&throttle->operations.tokens, 1);
+   }
+}
+
+static int64_t
+throttle_now(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+
+   return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void
+bucket_refill(struct throttle_bucket* bucket, int64_t rate, int64_t now)
+{
+   long long last;
+   long long tokens;
+   long long refilled;
+   int64_t elapsed;
+   int64_t add;
+
+   last = atomic_load(&bucket->last);
+
+   if (last == 0)
+   {
+      /* The bucket starts full */
+      if (atomic_compare_exchange_strong(&bucket->last, &last, now))
+      {
+         atomic_store(&bucket->tokens, rate);
+      }
+      return;
+   }
+
+   elapsed = now - last;
+   if (elapsed <= 0)
+   {
+      return;
+   }
+
+   /* An idle bucket is full after a second */
+   elapsed = MIN(elapsed, THROTTLE_WINDOW);
+   add = (int64_t)((double)elapsed * (double)rate / 1000000000.0);
+   if (add <= 0)
+   {
+      return;
+   }
+
+   /* Only the time that made whole tokens is used */
+   if (!atomic_compare_exchange_strong(&bucket->last, &last,
+                                       MAX(last, now - THROTTLE_WINDOW) + (int64_t)((double)add * 1000000000.0 / (double)rate)))
+   {
+      return;
+   }
+
+   tokens = atomic_load(&bucket->tokens);
+   do
+   {
+      refilled = MIN(tokens + add, (long long)rate);
+   }
+   while (!atomic_compare_exchange_weak(&bucket->tokens, &tokens, refilled));
+}
+
+/**
+ * The nanoseconds until a class may take tokens, where one full bucket
+ * is a second of I/O and each active higher class keeps a share of it
+ */
+static int64_t
+bucket_wait(struct throttle_bucket* bucket, int64_t rate, int higher, int64_t now)
+{
+   int64_t reserve;
+   long long tokens;
+
+   bucket_refill(bucket, rate, now);
+
+   reserve = rate * higher / (higher + 1);
+   tokens = atomic_load(&bucket->tokens);
+
+   if (tokens > reserve)
+   {
+      return 0;
+   }
+
+   return MAX((int64_t)((double)(reserve - tokens + 1) * 1000000000.0 / (double)rate), 1000000LL);
+}
+
+static int
+active_higher(struct throttle* throttle, int io_class, int64_t now)
+{
+   int higher = 0;
+
+   for (int i = 0; i < io_class; i++)
+   {
+      long long active = atomic_load(&throttle->active[i]);
+
+      if (active > 0 && now - active < THROTTLE_WINDOW)
+      {
+         higher++;
+      }
+   }
+
+   return higher;
+}
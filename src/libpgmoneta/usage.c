@@ -0,0 +1,265 @@
+/*
+ * Copyright (C) 2026 The pgmoneta community
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or other
+ * materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may
+ * be used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* pgmoneta */
+#include <pgmoneta.h>
+#include <logging.h>
+#include <usage.h>
+#include <utils.h>
+
+/* system */
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+static void usage_apply(atomic_ullong* size, int64_t delta);
+static void usage_reconcile(atomic_ullong* size, char* directory);
+static uint64_t usage_size(char* directory);
+static uint64_t usage_hot_standby(int server);
+
+void
+pgmoneta_usage_init(struct usage* usage)
+{
+   for (int i = 0; i < NUMBER_OF_USAGES; i++)
+   {
+      atomic_init(&usage->size[i], 0);
+   }
+
+   atomic_init(&usage->reconciled, 0);
+}
+
+void
+pgmoneta_usage_add(int server, int type, int64_t delta)
+{
+   struct usage* usage = NULL;
+   struct main_configuration* config;
+
+   config = (struct main_configuration*)shmem;
+
+   if (config == NULL || server < 0 || server >= config->common.number_of_servers ||
+       type < 0 || type >= NUMBER_OF_USAGES || delta == 0)
+   {
+      return;
+   }
+
+   usage = &config->common.servers[server].usage;
+
+   usage_apply(&usage->size[type], delta);
+
+   if (type == USAGE_BACKUP || type == USAGE_WAL)
+   {
+      usage_apply(&usage->size[USAGE_SERVER], delta);
+      usage_apply(&config->used_space, delta);
+   }
+   else if (type == USAGE_WAL_SHIPPING_WAL)
+   {
+      usage_apply(&usage->size[USAGE_WAL_SHIPPING], delta);
+   }
+}
+
+uint64_t
+pgmoneta_usage_get(int server, int type)
+{
+   struct main_configuration* config;
+
+   config = (struct main_configuration*)shmem;
+
+   if (config == NULL || server < 0 || server >= config->common.number_of_servers ||
+       type < 0 || type >= NUMBER_OF_USAGES)
+   {
+      return 0;
+   }
+
+   return atomic_load(&config->common.servers[server].usage.size[type]);
+}
+
+uint64_t
+pgmoneta_usage_used_space(void)
+{
+   struct main_configuration* config;
+
+   config = (struct main_configuration*)shmem;
+
+   if (config == NULL)
+   {
+      return 0;
+   }
+
+   return atomic_load(&config->used_space);
+}
+
+int
+pgmoneta_usage_reconcile(void)
+{
+   char* d = NULL;
+   unsigned long long snapshot = 0;
+   struct usage* usage = NULL;
+   struct main_configuration* config;
+
+   config = (struct main_configuration*)shmem;
+
+   for (int i = 0; i < config->common.number_of_servers; i++)
+   {
+      usage = &config->common.servers[i].usage;
+
+      d = pgmoneta_get_server_backup(i);
+      usage_reconcile(&usage->size[USAGE_BACKUP], d);
+      free(d);
+
+      d = pgmoneta_get_server_wal(i);
+      usage_reconcile(&usage->size[USAGE_WAL], d);
+      free(d);
+
+      d = pgmoneta_get_server(i);
+      usage_reconcile(&usage->size[USAGE_SERVER], d);
+      free(d);
+
+      d = pgmoneta_get_server_wal_shipping_wal(i);
+      usage_reconcile(&usage->size[USAGE_WAL_SHIPPING_WAL], d);
+      free(d);
+
+      d = pgmoneta_get_server_wal_shipping(i);
+      usage_reconcile(&usage->size[USAGE_WAL_SHIPPING], d);
+      free(d);
+
+      d = pgmoneta_get_server_workspace(i);
+      usage_reconcile(&usage->size[USAGE_WORKSPACE], d);
+      free(d);
+
+      snapshot = atomic_load(&usage->size[USAGE_HOT_STANDBY]);
+      usage_apply(&usage->size[USAGE_HOT_STANDBY], (int64_t)usage_hot_standby(i) - (int64_t)snapshot);
+
+      atomic_store(&usage->reconciled, (long long)time(NULL));
+   }
+
+   d = pgmoneta_append(NULL, config->base_dir);
+   d = pgmoneta_append(d, "/");
+   usage_reconcile(&config->used_space, d);
+   free(d);
+
+   return 0;
+}
+
+void
+pgmoneta_usage(char** argv)
+{
+   bool active = false;
+   struct main_configuration* config;
+
+   pgmoneta_start_logging();
+
+   config = (struct main_configuration*)shmem;
+
+   pgmoneta_set_proc_title(1, argv, "usage", NULL);
+
+   if (atomic_compare_exchange_strong(&config->usage_active, &active, true))
+   {
+      pgmoneta_usage_reconcile();
+      atomic_store(&config->usage_active, false);
+   }
+   else
+   {
+      pgmoneta_log_debug("Usage: Reconciler is already active");
+   }
+
+   pgmoneta_stop_logging();
+   exit(0);
+}
+
+static void
+usage_apply(atomic_ullong* size, int64_t delta)
+{
+   unsigned long long current;
+   unsigned long long updated;
+
+   current = atomic_load(size);
+   do
+   {
+      if (delta < 0 && (unsigned long long)(-delta) > current)
+      {
+         updated = 0;
+      }
+      else
+      {
+         updated = current + delta;
+      }
+   }
+   while (!atomic_compare_exchange_weak(size, &current, updated));
+}
+
+static void
+usage_reconcile(atomic_ullong* size, char* directory)
+{
+   unsigned long long snapshot = 0;
+   uint64_t walked = 0;
+
+   /* Only apply the change since the snapshot, so deltas added during the walk are kept */
+   snapshot = atomic_load(size);
+   walked = usage_size(directory);
+
+   usage_apply(size, (int64_t)walked - (int64_t)snapshot);
+}
+
+static uint64_t
+usage_size(char* directory)
+{
+   if (directory == NULL || !pgmoneta_exists(directory))
+   {
+      return 0;
+   }
+
+   return pgmoneta_directory_size(directory);
+}
+
+static uint64_t
+usage_hot_standby(int server)
+{
+   char* d = NULL;
+   uint64_t size = 0;
+   struct main_configuration* config;
+
+   config = (struct main_configuration*)shmem;
+
+   for (int j = 0; j < config->common.servers[server].number_of_hot_standbys; j++)
+   {
+      d = pgmoneta_append(d, config->common.servers[server].hot_standby[j]);
+      if (!pgmoneta_ends_with(d, "/"))
+      {
+         d = pgmoneta_append_char(d, '/');
+      }
+      d = pgmoneta_append(d, config->common.servers[server].name);
+
+      size += usage_size(d);
+
+      free(d);
+      d = NULL;
+   }
+
+   return size;
+}
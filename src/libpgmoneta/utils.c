@@ -83,6 +83,8 @@
 #include <execinfo.h>
 #endif
 
+#define STRING_BUILDER_CAPACITY 256
+
 extern char** environ;
 #ifdef HAVE_LINUX
 static bool env_changed = false;
@@ -99,6 +101,7 @@ static void do_copy_file(struct worker_common* wc);
 static void do_delete_file(struct worker_common* wc);
 static bool is_valid_wal_file_prefix(char* f);
 static bool is_valid_wal_file_name(char* f);
+static int string_builder_reserve(struct string_builder* sb, size_t length);
 
 int32_t
 pgmoneta_get_request(struct message* msg)
@@ -1571,7 +1574,7 @@ pgmoneta_append_int(char* orig, int i)
    char number[12];
 
    memset(&number[0], 0, sizeof(number));
-   pgmoneta_snprintf(&number[0], 11, "%d", i);
+   pgmoneta_snprintf(&number[0], sizeof(number), "%d", i);
    orig = pgmoneta_append(orig, number);
 
    return orig;
@@ -1583,7 +1586,7 @@ pgmoneta_append_ulong(char* orig, unsigned long l)
    char number[21];
 
    memset(&number[0], 0, sizeof(number));
-   pgmoneta_snprintf(&number[0], 20, "%lu", l);
+   pgmoneta_snprintf(&number[0], sizeof(number), "%lu", l);
    orig = pgmoneta_append(orig, number);
 
    return orig;
@@ -1636,6 +1639,219 @@ pgmoneta_append_bool(char* orig, bool b)
    return orig;
 }
 
+int
+pgmoneta_string_builder_create(size_t capacity, struct string_builder** sb)
+{
+   struct string_builder* b = NULL;
+
+   *sb = NULL;
+
+   if (capacity == 0)
+   {
+      capacity = STRING_BUILDER_CAPACITY;
+   }
+
+   b = (struct string_builder*)malloc(sizeof(struct string_builder));
+
+   if (b == NULL)
+   {
+      goto error;
+   }
+
+   b->str = (char*)malloc(capacity);
+
+   if (b->str == NULL)
+   {
+      goto error;
+   }
+
+   b->str[0] = '\0';
+   b->length = 0;
+   b->capacity = capacity;
+
+   *sb = b;
+
+   return 0;
+
+error:
+
+   free(b);
+
+   return 1;
+}
+
+int
+pgmoneta_string_builder_append(struct string_builder* sb, const char* s)
+{
+   if (s == NULL)
+   {
+      return 0;
+   }
+
+   return pgmoneta_string_builder_append_bytes(sb, s, strlen(s));
+}
+
+int
+pgmoneta_string_builder_append_bytes(struct string_builder* sb, const char* s, size_t length)
+{
+   if (sb == NULL)
+   {
+      return 1;
+   }
+
+   if (s == NULL || length == 0)
+   {
+      return 0;
+   }
+
+   if (string_builder_reserve(sb, length))
+   {
+      return 1;
+   }
+
+   memcpy(sb->str + sb->length, s, length);
+   sb->length += length;
+   sb->str[sb->length] = '\0';
+
+   return 0;
+}
+
+int
+pgmoneta_string_builder_append_char(struct string_builder* sb, char c)
+{
+   return pgmoneta_string_builder_append_bytes(sb, &c, 1);
+}
+
+int
+pgmoneta_string_builder_append_int(struct string_builder* sb, int i)
+{
+   return pgmoneta_string_builder_format(sb, "%d", i);
+}
+
+int
+pgmoneta_string_builder_append_ulong(struct string_builder* sb, unsigned long l)
+{
+   return pgmoneta_string_builder_format(sb, "%lu", l);
+}
+
+int
+pgmoneta_string_builder_append_double(struct string_builder* sb, double d)
+{
+   return pgmoneta_string_builder_format(sb, "%lf", d);
+}
+
+int
+pgmoneta_string_builder_append_double_precision(struct string_builder* sb, double d, int precision)
+{
+   return pgmoneta_string_builder_format(sb, "%.*f", precision, d);
+}
+
+int
+pgmoneta_string_builder_format(struct string_builder* sb, char* format, ...)
+{
+   int n;
+   va_list args;
+
+   if (sb == NULL || format == NULL)
+   {
+      return 1;
+   }
+
+   va_start(args, format);
+   n = vsnprintf(sb->str + sb->length, sb->capacity - sb->length, format, args);
+   va_end(args);
+
+   if (n < 0)
+   {
+      sb->str[sb->length] = '\0';
+      return 1;
+   }
+
+   /* Format again only when the result did not fit */
+   if ((size_t)n >= sb->capacity - sb->length)
+   {
+      if (string_builder_reserve(sb, (size_t)n))
+      {
+         sb->str[sb->length] = '\0';
+         return 1;
+      }
+
+      va_start(args, format);
+      vsnprintf(sb->str + sb->length, sb->capacity - sb->length, format, args);
+      va_end(args);
+   }
+
+   sb->length += (size_t)n;
+
+   return 0;
+}
+
+int
+pgmoneta_string_builder_indent(struct string_builder* sb, char* tag, int indent)
+{
+   if (sb == NULL)
+   {
+      return 1;
+   }
+
+   if (indent > 0)
+   {
+      if (string_builder_reserve(sb, (size_t)indent))
+      {
+         return 1;
+      }
+
+      memset(sb->str + sb->length, ' ', (size_t)indent);
+      sb->length += (size_t)indent;
+      sb->str[sb->length] = '\0';
+   }
+
+   return pgmoneta_string_builder_append(sb, tag);
+}
+
+void
+pgmoneta_string_builder_reset(struct string_builder* sb)
+{
+   if (sb != NULL)
+   {
+      sb->length = 0;
+      sb->str[0] = '\0';
+   }
+}
+
+char*
+pgmoneta_string_builder_release(struct string_builder* sb)
+{
+   char* s = NULL;
+
+   if (sb == NULL)
+   {
+      return NULL;
+   }
+
+   if (sb->length > 0)
+   {
+      s = sb->str;
+      sb->str = NULL;
+   }
+
+   pgmoneta_string_builder_destroy(sb);
+
+   return s;
+}
+
+void
+pgmoneta_string_builder_destroy(struct string_builder* sb)
+{
+   if (sb == NULL)
+   {
+      return;
+   }
+
+   free(sb->str);
+   free(sb);
+}
+
 char*
 pgmoneta_remove_whitespace(char* orig)
 {
@@ -2050,6 +2266,7 @@ pgmoneta_delete_directory(char* path)
                }
                else
                {
+                  pgmoneta_throttle(THROTTLE_DELETE, 0);
                   r2 = unlink(buf);
                }
             }
@@ -2120,7 +2337,8 @@ pgmoneta_get_files(uint32_t file_type_mask, char* base, bool recursive, struct d
 
    if (*files == NULL)
    {
-      pgmoneta_deque_create(false, &array);
+      // file lists can be millions of entries, so keep them in one array
+      pgmoneta_deque_create_ring(false, 0, true, &array);
    }
    else
    {
@@ -2161,19 +2379,11 @@ pgmoneta_get_files(uint32_t file_type_mask, char* base, bool recursive, struct d
          {
             if (recursive)
             {
-               /* Recursive: return full path with pgmoneta_append (caller must free) */
-               char* path_copy = NULL;
-               path_copy = pgmoneta_append(path_copy, full_path);
-               if (path_copy == NULL)
+               /* Recursive: return full path, the deque keeps its own copy */
+               if (pgmoneta_deque_add(array, full_path, (uintptr_t)full_path, ValueString))
                {
                   goto error;
                }
-               if (pgmoneta_deque_add(array, path_copy, (uintptr_t)path_copy, ValueString))
-               {
-                  free(path_copy);
-                  goto error;
-               }
-               free(path_copy);
             }
             else
             {
@@ -2318,7 +2528,7 @@ pgmoneta_get_wal_files(char* base, struct deque** files)
 
    if (*files == NULL)
    {
-      pgmoneta_deque_create(false, &array);
+      pgmoneta_deque_create_ring(false, 0, true, &array);
    }
    else
    {
@@ -2406,7 +2616,11 @@ static void
 do_delete_file(struct worker_common* wc)
 {
    struct worker_input* fi = (struct worker_input*)wc;
-   int ret = unlink(fi->from);
+   int ret;
+
+   pgmoneta_throttle(THROTTLE_DELETE, 0);
+
+   ret = unlink(fi->from);
 
    if (ret != 0)
    {
@@ -4003,6 +4217,40 @@ pgmoneta_get_server_summary(int server)
    return d;
 }
 
+char*
+pgmoneta_get_server_chunks(int server, bool shared)
+{
+   char* d = NULL;
+   struct main_configuration* config;
+
+   config = (struct main_configuration*)shmem;
+
+   d = get_server_basepath(server);
+   if (d == NULL)
+   {
+      return NULL;
+   }
+
+   if (shared)
+   {
+      free(d);
+      d = NULL;
+
+      d = pgmoneta_append(d, config->base_dir);
+      if (!pgmoneta_ends_with(config->base_dir, "/"))
+      {
+         d = pgmoneta_append(d, "/");
+      }
+      d = pgmoneta_append(d, ".chunks/");
+
+      return d;
+   }
+
+   d = pgmoneta_append(d, "chunks/");
+
+   return d;
+}
+
 char*
 pgmoneta_get_server_wal_shipping(int server)
 {
@@ -4698,25 +4946,38 @@ parse_command(int argc,
 char*
 pgmoneta_format_and_append(char* buf, char* format, ...)
 {
+   int n;
+   size_t length = 0;
+   char* n_buf = NULL;
    va_list args;
-   va_start(args, format);
 
-   // Determine the required buffer size
-   int size_needed = vsnprintf(NULL, 0, format, args) + 1;
+   va_start(args, format);
+   n = vsnprintf(NULL, 0, format, args);
    va_end(args);
 
-   // Allocate buffer to hold the formatted string
-   char* formatted_str = malloc(size_needed);
+   if (n <= 0)
+   {
+      return buf;
+   }
 
-   va_start(args, format);
-   vsnprintf(formatted_str, size_needed, format, args);
-   va_end(args);
+   if (buf != NULL)
+   {
+      length = strlen(buf);
+   }
 
-   buf = pgmoneta_append(buf, formatted_str);
+   /* Format straight into the grown string instead of a temporary one */
+   n_buf = (char*)realloc(buf, length + n + 1);
 
-   free(formatted_str);
+   if (n_buf == NULL)
+   {
+      return buf;
+   }
+
+   va_start(args, format);
+   vsnprintf(n_buf + length, n + 1, format, args);
+   va_end(args);
 
-   return buf;
+   return n_buf;
 }
 
 int
@@ -4743,9 +5004,25 @@ pgmoneta_atoi(char* input)
 char*
 pgmoneta_indent(char* str, char* tag, int indent)
 {
-   for (int i = 0; i < indent; i++)
+   size_t length = 0;
+   char* n = NULL;
+
+   if (indent > 0)
    {
-      str = pgmoneta_append(str, " ");
+      if (str != NULL)
+      {
+         length = strlen(str);
+      }
+
+      n = (char*)realloc(str, length + indent + 1);
+      if (n == NULL)
+      {
+         return str;
+      }
+
+      memset(n + length, ' ', indent);
+      n[length + indent] = '\0';
+      str = n;
    }
    if (tag != NULL)
    {
@@ -5938,3 +6215,33 @@ pgmoneta_get_lsn(uint32_t hi, uint32_t lo)
 {
    return ((uint64_t)hi << 32) | lo;
 }
+
+static int
+string_builder_reserve(struct string_builder* sb, size_t length)
+{
+   size_t capacity;
+   char* n = NULL;
+
+   if (sb->length + length + 1 <= sb->capacity)
+   {
+      return 0;
+   }
+
+   capacity = sb->capacity;
+   while (capacity < sb->length + length + 1)
+   {
+      capacity *= 2;
+   }
+
+   n = (char*)realloc(sb->str, capacity);
+
+   if (n == NULL)
+   {
+      return 1;
+   }
+
+   sb->str = n;
+   sb->capacity = capacity;
+
+   return 0;
+}
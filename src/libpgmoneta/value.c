@@ -74,6 +74,40 @@ pgmoneta_value_create(enum value_type type, uintptr_t data, struct value** value
    {
       goto error;
    }
+   if (pgmoneta_value_init(type, data, NULL, val))
+   {
+      free(val);
+      goto error;
+   }
+   *value = val;
+   return 0;
+
+error:
+   return 1;
+}
+
+int
+pgmoneta_value_create_with_config(uintptr_t data, struct value_config* config, struct value** value)
+{
+   struct value* val = NULL;
+
+   val = (struct value*)malloc(sizeof(struct value));
+   if (val == NULL)
+   {
+      return 1;
+   }
+   pgmoneta_value_init(ValueRef, data, config, val);
+   *value = val;
+   return 0;
+}
+
+int
+pgmoneta_value_init(enum value_type type, uintptr_t data, struct value_config* config, struct value* val)
+{
+   if (type == ValueNone || val == NULL)
+   {
+      return 1;
+   }
    val->data = 0;
    val->type = type;
    switch (type)
@@ -175,42 +209,39 @@ pgmoneta_value_create(enum value_type type, uintptr_t data, struct value** value
          val->destroy_data = noop_destroy_cb;
          break;
    }
-   *value = val;
-   return 0;
-
-error:
-   return 1;
-}
-
-int
-pgmoneta_value_create_with_config(uintptr_t data, struct value_config* config, struct value** value)
-{
-   if (pgmoneta_value_create(ValueRef, data, value))
-   {
-      return 1;
-   }
    if (config != NULL)
    {
       if (config->destroy_data != NULL)
       {
-         (*value)->destroy_data = config->destroy_data;
+         val->destroy_data = config->destroy_data;
       }
       if (config->to_string != NULL)
       {
-         (*value)->to_string = config->to_string;
+         val->to_string = config->to_string;
       }
    }
    return 0;
 }
 
 int
-pgmoneta_value_destroy(struct value* value)
+pgmoneta_value_release(struct value* value)
 {
    if (value == NULL)
    {
       return 0;
    }
    value->destroy_data(value->data);
+   return 0;
+}
+
+int
+pgmoneta_value_destroy(struct value* value)
+{
+   if (value == NULL)
+   {
+      return 0;
+   }
+   pgmoneta_value_release(value);
    free(value);
    return 0;
 }
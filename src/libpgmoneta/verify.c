@@ -28,7 +28,9 @@
 
 /* pgmoneta */
 #include <pgmoneta.h>
+#include <art.h>
 #include <backup.h>
+#include <chunk.h>
 #include <info.h>
 #include <logging.h>
 #include <management.h>
@@ -39,11 +41,41 @@
 
 /* system */
 #include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include <unistd.h>
+#include <sys/stat.h>
 
 #define NAME "verify"
 
+#define VERIFICATION_LEDGER "verification.ledger"
+
+/**
+ * A physical file to verify, identified by device, inode, size and mtime
+ */
+struct verification_candidate
+{
+   char* path;            /**< The path of the file */
+   char* hash;            /**< The expected SHA512 */
+   char* key;             /**< The ledger key */
+   off_t size;            /**< The size of the file */
+   time_t verified;       /**< The time of the last successful verification */
+   int* backups;          /**< The indexes of the backups that link the file */
+   int number_of_backups; /**< The number of backups that link the file */
+};
+
+static char* ledger_path(int server);
+static int load_ledger(int server, struct art** ledger);
+static int save_ledger(int server, struct verification_candidate* candidates, int number_of_candidates);
+static int collect_candidates(int server, int index, struct backup* backup, struct art* ledger, struct art* seen,
+                              struct verification_candidate** candidates, int* number_of_candidates, int* capacity);
+static int add_owner(struct verification_candidate* candidate, int index);
+static void fail_candidate(struct verification_candidate* candidate, bool* failed);
+static int compare_candidates(const void* a, const void* b);
+
 void
 pgmoneta_verify(SSL* ssl, int client_fd, int server, uint8_t compression, uint8_t encryption, struct json* payload)
 {
@@ -320,17 +352,18 @@ pgmoneta_sha512_verification(char** argv)
    char* backup_dir = NULL;
    int number_of_backups = 0;
    struct backup** backups = NULL;
-   char* sha512_path = NULL;
-   FILE* sha512_file = NULL;
-   char buffer[4096];
-   char* root = NULL;
-   char* filename = NULL;
-   char* hash = NULL;
+   bool* failed = NULL;
+   struct art* ledger = NULL;
+   struct art* seen = NULL;
+   struct verification_candidate* candidates = NULL;
+   int number_of_candidates = 0;
+   int capacity = 0;
+   int verified = 0;
+   uint64_t spent = 0;
+   time_t now;
    char* calculated_hash = NULL;
-   char* absolute_file_path = NULL;
    bool active = false;
    bool locked = false;
-   int line = 0;
    int err = 0;
    char* elapsed = NULL;
    struct timespec start_t;
@@ -362,6 +395,12 @@ pgmoneta_sha512_verification(char** argv)
 
       locked = true;
 
+#ifdef HAVE_FREEBSD
+      clock_gettime(CLOCK_MONOTONIC_FAST, &start_t);
+#else
+      clock_gettime(CLOCK_MONOTONIC_RAW, &start_t);
+#endif
+
       backup_dir = pgmoneta_get_server_backup(server);
 
       if (pgmoneta_load_infos(backup_dir, &number_of_backups, &backups))
@@ -371,160 +410,141 @@ pgmoneta_sha512_verification(char** argv)
          goto server_cleanup;
       }
 
-      for (int i = 0; i < number_of_backups; i++)
+      if (number_of_backups > 0)
       {
-         bool success = true;
+         failed = (bool*)calloc(number_of_backups, sizeof(bool));
+         if (failed == NULL)
+         {
+            err = 1;
+            goto server_cleanup;
+         }
+      }
 
-#ifdef HAVE_FREEBSD
-         clock_gettime(CLOCK_MONOTONIC_FAST, &start_t);
-#else
-         clock_gettime(CLOCK_MONOTONIC_RAW, &start_t);
-#endif
+      if (load_ledger(server, &ledger) || pgmoneta_art_create(&seen))
+      {
+         pgmoneta_log_error("Verification: %s: Unable to load the ledger", config->common.servers[server].name);
+         err = 1;
+         goto server_cleanup;
+      }
 
+      for (int i = 0; i < number_of_backups; i++)
+      {
          if (!pgmoneta_is_backup_struct_valid(server, backups[i]))
          {
             err = 1;
-            success = false;
             continue;
          }
-         root = pgmoneta_get_server_backup_identifier(server, backups[i]->label);
 
-         sha512_path = pgmoneta_append(sha512_path, root);
-         if (!pgmoneta_ends_with(sha512_path, "/"))
+         if (collect_candidates(server, i, backups[i], ledger, seen,
+                                &candidates, &number_of_candidates, &capacity))
          {
-            sha512_path = pgmoneta_append_char(sha512_path, '/');
+            err = 1;
+            failed[i] = true;
          }
-         sha512_path = pgmoneta_append(sha512_path, "backup.sha512");
+      }
 
-         sha512_file = fopen(sha512_path, "r");
-         if (sha512_file == NULL)
+      /* Stalest first, so every physical file is covered over a rolling window */
+      if (number_of_candidates > 1)
+      {
+         qsort(candidates, number_of_candidates, sizeof(struct verification_candidate), compare_candidates);
+      }
+
+      now = time(NULL);
+      verified = 0;
+      spent = 0;
+
+      for (int i = 0; i < number_of_candidates; i++)
+      {
+         struct verification_candidate* c = &candidates[i];
+
+         if (config->verification_budget > 0 && verified > 0 &&
+             spent + (uint64_t)c->size > config->verification_budget)
          {
-            pgmoneta_log_error("Verification: %s / Could not open file %s: %s",
-                               config->common.servers[server].name, sha512_path,
-                               strerror(errno));
-            err = 1;
-            success = false;
-            goto backup_cleanup;
+            break;
          }
 
-         line = 0;
-         while (fgets(&buffer[0], sizeof(buffer), sha512_file) != NULL)
+         spent += (uint64_t)c->size;
+         verified++;
+
+         pgmoneta_throttle(THROTTLE_VERIFY, c->size);
+
+         if (pgmoneta_create_sha512_file(c->path, &calculated_hash))
          {
-            char* entry = NULL;
-
-            line++;
-            entry = strtok(&buffer[0], " ");
-            if (entry == NULL)
-            {
-               pgmoneta_log_error("Verification: %s / %s: formatting error at line %d",
-                                  config->common.servers[server].name, sha512_path, sha512_path,
-                                  line);
-               err = 1;
-               success = false;
-               goto cleanup;
-            }
-
-            hash = strdup(entry);
-            if (hash == NULL)
-            {
-               pgmoneta_log_error("Verification: %s / Memory allocation error for hash",
-                                  config->common.servers[server].name);
-               err = 1;
-               success = false;
-               goto cleanup;
-            }
-
-            entry = strtok(NULL, "\n");
-            if (entry == NULL || strlen(entry) < 3)
-            {
-               pgmoneta_log_error("Verification: %s/%s %s formatting error at line %d",
-                                  config->common.servers[server].name,
-                                  backups[i]->label, sha512_path, line);
-               err = 1;
-               success = false;
-               goto cleanup;
-            }
-
-            // skip the " *." or " */"
-            filename = entry + 3;
-
-            absolute_file_path = pgmoneta_append(absolute_file_path, root);
-            if (!pgmoneta_ends_with(absolute_file_path, "/"))
-            {
-               absolute_file_path = pgmoneta_append(absolute_file_path, "/");
-            }
-
-            absolute_file_path = pgmoneta_append(absolute_file_path, filename);
-
-            if (pgmoneta_create_sha512_file(absolute_file_path, &calculated_hash))
-            {
-               pgmoneta_log_error("Verification: %s / Could not create hash for %s",
-                                  config->common.servers[server].name, absolute_file_path);
-               err = 1;
-               success = false;
-               goto cleanup;
-            }
-
-            if (strcmp(hash, calculated_hash) != 0)
-            {
-               pgmoneta_log_error("Verification: %s / Hash mismatch for %s | Expected: %s | Got: %s",
-                                  config->common.servers[server].name,
-                                  absolute_file_path, hash, calculated_hash);
-               err = 1;
-            }
-
-cleanup:
-            free(hash);
-            hash = NULL;
-
-            free(absolute_file_path);
-            absolute_file_path = NULL;
-
-            free(calculated_hash);
-            calculated_hash = NULL;
+            pgmoneta_log_error("Verification: %s / Could not create hash for %s",
+                               config->common.servers[server].name, c->path);
+            err = 1;
+            fail_candidate(c, failed);
+            continue;
          }
 
-#ifdef HAVE_FREEBSD
-         clock_gettime(CLOCK_MONOTONIC_FAST, &end_t);
-#else
-         clock_gettime(CLOCK_MONOTONIC_RAW, &end_t);
-#endif
-
-         elapsed = pgmoneta_get_timestamp_string(start_t, end_t, &total_seconds);
-         if (success)
+         if (strcmp(c->hash, calculated_hash) != 0)
          {
-            pgmoneta_log_info("Verification: %s/%s (Elapsed: %s)", config->common.servers[server].name, backups[i]->label, elapsed);
+            pgmoneta_log_error("Verification: %s / Hash mismatch for %s | Expected: %s | Got: %s",
+                               config->common.servers[server].name,
+                               c->path, c->hash, calculated_hash);
+            err = 1;
+            fail_candidate(c, failed);
          }
          else
          {
-            char* bck_dir = NULL;
+            c->verified = now;
+         }
 
-            pgmoneta_log_info("Update .info");
+         free(calculated_hash);
+         calculated_hash = NULL;
+      }
 
-            backups[i]->valid = VALID_FALSE;
+      if (save_ledger(server, candidates, number_of_candidates))
+      {
+         pgmoneta_log_warn("Verification: %s: Unable to save the ledger", config->common.servers[server].name);
+      }
 
-            bck_dir = pgmoneta_get_server_backup(server);
+      for (int i = 0; i < number_of_backups; i++)
+      {
+         if (failed[i])
+         {
+            pgmoneta_log_info("Update .info");
 
-            pgmoneta_save_info(bck_dir, backups[i]);
+            backups[i]->valid = VALID_FALSE;
 
-            free(bck_dir);
+            pgmoneta_save_info(backup_dir, backups[i]);
          }
-         free(elapsed);
+      }
 
-backup_cleanup:
-         if (sha512_file != NULL)
-         {
-            fclose(sha512_file);
-            sha512_file = NULL;
-         }
-         free(sha512_path);
-         sha512_path = NULL;
+#ifdef HAVE_FREEBSD
+      clock_gettime(CLOCK_MONOTONIC_FAST, &end_t);
+#else
+      clock_gettime(CLOCK_MONOTONIC_RAW, &end_t);
+#endif
 
-         free(root);
-         root = NULL;
-      }
+      elapsed = pgmoneta_get_timestamp_string(start_t, end_t, &total_seconds);
+      pgmoneta_log_info("Verification: %s (Files: %d/%d, Size: %" PRIu64 ", Elapsed: %s)",
+                        config->common.servers[server].name, verified, number_of_candidates,
+                        spent, elapsed);
+      free(elapsed);
+      elapsed = NULL;
 
 server_cleanup:
+      for (int i = 0; i < number_of_candidates; i++)
+      {
+         free(candidates[i].path);
+         free(candidates[i].hash);
+         free(candidates[i].key);
+         free(candidates[i].backups);
+      }
+      free(candidates);
+      candidates = NULL;
+      number_of_candidates = 0;
+      capacity = 0;
+
+      pgmoneta_art_destroy(ledger);
+      ledger = NULL;
+      pgmoneta_art_destroy(seen);
+      seen = NULL;
+
+      free(failed);
+      failed = NULL;
+
       for (int i = 0; i < number_of_backups; i++)
       {
          if (backups[i])
@@ -534,6 +554,7 @@ server_cleanup:
       }
       free(backups);
       backups = NULL;
+      number_of_backups = 0;
 
       free(backup_dir);
       backup_dir = NULL;
@@ -548,3 +569,361 @@ server_cleanup:
    pgmoneta_stop_logging();
    exit(err);
 }
+
+static char*
+ledger_path(int server)
+{
+   char* p = NULL;
+
+   p = pgmoneta_get_server(server);
+   if (p == NULL)
+   {
+      return NULL;
+   }
+
+   if (!pgmoneta_ends_with(p, "/"))
+   {
+      p = pgmoneta_append_char(p, '/');
+   }
+   p = pgmoneta_append(p, VERIFICATION_LEDGER);
+
+   return p;
+}
+
+static int
+load_ledger(int server, struct art** ledger)
+{
+   char* path = NULL;
+   FILE* file = NULL;
+   char buffer[MISC_LENGTH];
+   struct art* l = NULL;
+
+   *ledger = NULL;
+
+   if (pgmoneta_art_create(&l))
+   {
+      goto error;
+   }
+
+   path = ledger_path(server);
+   if (path == NULL)
+   {
+      goto error;
+   }
+
+   file = fopen(path, "r");
+   if (file != NULL)
+   {
+      while (fgets(&buffer[0], sizeof(buffer), file) != NULL)
+      {
+         char* sep = NULL;
+         char* end = NULL;
+         long long ts;
+
+         buffer[strcspn(&buffer[0], "\n")] = '\0';
+
+         sep = strrchr(&buffer[0], ',');
+         if (sep == NULL)
+         {
+            continue;
+         }
+         *sep = '\0';
+
+         errno = 0;
+         ts = strtoll(sep + 1, &end, 10);
+         if (errno != 0 || end == sep + 1 || ts <= 0)
+         {
+            continue;
+         }
+
+         pgmoneta_art_insert(l, &buffer[0], (uintptr_t)ts, ValueInt64);
+      }
+
+      fclose(file);
+   }
+
+   free(path);
+
+   *ledger = l;
+
+   return 0;
+
+error:
+
+   pgmoneta_art_destroy(l);
+   free(path);
+
+   return 1;
+}
+
+static int
+save_ledger(int server, struct verification_candidate* candidates, int number_of_candidates)
+{
+   char* path = NULL;
+   char* tmp = NULL;
+   FILE* file = NULL;
+
+   path = ledger_path(server);
+   if (path == NULL)
+   {
+      goto error;
+   }
+
+   tmp = pgmoneta_append(tmp, path);
+   tmp = pgmoneta_append(tmp, ".tmp");
+
+   file = fopen(tmp, "w");
+   if (file == NULL)
+   {
+      goto error;
+   }
+
+   /* Only the files seen in this cycle are kept, which prunes deleted backups */
+   for (int i = 0; i < number_of_candidates; i++)
+   {
+      if (candidates[i].verified > 0)
+      {
+         fprintf(file, "%s,%lld\n", candidates[i].key, (long long)candidates[i].verified);
+      }
+   }
+
+   if (fflush(file) || fsync(fileno(file)))
+   {
+      goto error;
+   }
+
+   fclose(file);
+   file = NULL;
+
+   if (rename(tmp, path))
+   {
+      goto error;
+   }
+
+   pgmoneta_permission(path, 6, 0, 0);
+
+   free(path);
+   free(tmp);
+
+   return 0;
+
+error:
+
+   if (file != NULL)
+   {
+      fclose(file);
+   }
+
+   if (tmp != NULL)
+   {
+      unlink(tmp);
+   }
+
+   free(path);
+   free(tmp);
+
+   return 1;
+}
+
+static int
+collect_candidates(int server, int index, struct backup* backup, struct art* ledger, struct art* seen,
+                   struct verification_candidate** candidates, int* number_of_candidates, int* capacity)
+{
+   char* root = NULL;
+   char* sha512_path = NULL;
+   char* absolute_file_path = NULL;
+   FILE* sha512_file = NULL;
+   char buffer[4096];
+   char key[MISC_LENGTH];
+   bool chunked = false;
+   int line = 0;
+   int ret = 0;
+   struct stat st;
+   struct main_configuration* config;
+
+   config = (struct main_configuration*)shmem;
+
+   chunked = pgmoneta_chunk_is_chunked(server, backup->label);
+
+   root = pgmoneta_get_server_backup_identifier(server, backup->label);
+
+   sha512_path = pgmoneta_append(sha512_path, root);
+   if (!pgmoneta_ends_with(sha512_path, "/"))
+   {
+      sha512_path = pgmoneta_append_char(sha512_path, '/');
+   }
+   sha512_path = pgmoneta_append(sha512_path, "backup.sha512");
+
+   sha512_file = fopen(sha512_path, "r");
+   if (sha512_file == NULL)
+   {
+      pgmoneta_log_error("Verification: %s / Could not open file %s: %s",
+                         config->common.servers[server].name, sha512_path,
+                         strerror(errno));
+      goto error;
+   }
+
+   while (fgets(&buffer[0], sizeof(buffer), sha512_file) != NULL)
+   {
+      struct verification_candidate* c = NULL;
+      char* hash = NULL;
+      char* entry = NULL;
+
+      line++;
+      hash = strtok(&buffer[0], " ");
+      entry = strtok(NULL, "\n");
+      if (hash == NULL || entry == NULL || strlen(entry) < 3)
+      {
+         pgmoneta_log_error("Verification: %s/%s %s formatting error at line %d",
+                            config->common.servers[server].name,
+                            backup->label, sha512_path, line);
+         ret = 1;
+         continue;
+      }
+
+      absolute_file_path = pgmoneta_append(absolute_file_path, root);
+      if (!pgmoneta_ends_with(absolute_file_path, "/"))
+      {
+         absolute_file_path = pgmoneta_append(absolute_file_path, "/");
+      }
+      // skip the " *." or " */"
+      absolute_file_path = pgmoneta_append(absolute_file_path, entry + 3);
+
+      if (stat(absolute_file_path, &st))
+      {
+         /* The Chunk stage moved the file into the chunk store */
+         if (!(chunked && errno == ENOENT))
+         {
+            pgmoneta_log_error("Verification: %s / Could not stat %s: %s",
+                               config->common.servers[server].name, absolute_file_path,
+                               strerror(errno));
+            ret = 1;
+         }
+
+         free(absolute_file_path);
+         absolute_file_path = NULL;
+         continue;
+      }
+
+      pgmoneta_snprintf(&key[0], sizeof(key), "%llu,%llu,%lld,%lld",
+                        (unsigned long long)st.st_dev, (unsigned long long)st.st_ino,
+                        (long long)st.st_size, (long long)st.st_mtime);
+
+      /* Linked files share an inode, so hash each physical file once for all of its backups */
+      if (pgmoneta_art_contains_key(seen, &key[0]))
+      {
+         c = &(*candidates)[(int)pgmoneta_art_search(seen, &key[0]) - 1];
+
+         free(absolute_file_path);
+         absolute_file_path = NULL;
+
+         if (add_owner(c, index))
+         {
+            goto error;
+         }
+
+         continue;
+      }
+
+      if (*number_of_candidates == *capacity)
+      {
+         struct verification_candidate* n = NULL;
+         int size = *capacity == 0 ? 1024 : *capacity * 2;
+
+         n = (struct verification_candidate*)realloc(*candidates, size * sizeof(struct verification_candidate));
+         if (n == NULL)
+         {
+            goto error;
+         }
+
+         *candidates = n;
+         *capacity = size;
+      }
+
+      c = &(*candidates)[*number_of_candidates];
+      memset(c, 0, sizeof(struct verification_candidate));
+      c->hash = strdup(hash);
+      c->key = strdup(&key[0]);
+      if (c->hash == NULL || c->key == NULL || add_owner(c, index))
+      {
+         free(c->hash);
+         free(c->key);
+         free(c->backups);
+         goto error;
+      }
+
+      c->path = absolute_file_path;
+      c->size = st.st_size;
+      c->verified = (time_t)pgmoneta_art_search(ledger, &key[0]);
+      absolute_file_path = NULL;
+      (*number_of_candidates)++;
+
+      pgmoneta_art_insert(seen, &key[0], (uintptr_t)*number_of_candidates, ValueInt32);
+   }
+
+   fclose(sha512_file);
+   free(sha512_path);
+   free(root);
+
+   return ret;
+
+error:
+
+   if (sha512_file != NULL)
+   {
+      fclose(sha512_file);
+   }
+
+   free(absolute_file_path);
+   free(sha512_path);
+   free(root);
+
+   return 1;
+}
+
+static int
+add_owner(struct verification_candidate* candidate, int index)
+{
+   int* n = NULL;
+
+   /* A backup lists a physical file once */
+   if (candidate->number_of_backups > 0 && candidate->backups[candidate->number_of_backups - 1] == index)
+   {
+      return 0;
+   }
+
+   n = (int*)realloc(candidate->backups, (candidate->number_of_backups + 1) * sizeof(int));
+   if (n == NULL)
+   {
+      return 1;
+   }
+
+   n[candidate->number_of_backups] = index;
+   candidate->backups = n;
+   candidate->number_of_backups++;
+
+   return 0;
+}
+
+static void
+fail_candidate(struct verification_candidate* candidate, bool* failed)
+{
+   for (int i = 0; i < candidate->number_of_backups; i++)
+   {
+      failed[candidate->backups[i]] = true;
+   }
+}
+
+static int
+compare_candidates(const void* a, const void* b)
+{
+   const struct verification_candidate* ca = (const struct verification_candidate*)a;
+   const struct verification_candidate* cb = (const struct verification_candidate*)b;
+
+   if (ca->verified != cb->verified)
+   {
+      return ca->verified < cb->verified ? -1 : 1;
+   }
+
+   return ca->backups[0] - cb->backups[0];
+}
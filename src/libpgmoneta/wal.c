@@ -30,12 +30,14 @@
 #include <pgmoneta.h>
 #include <aes.h>
 #include <bzip2_compression.h>
+#include <extraction.h>
 #include <gzip_compression.h>
 #include <logging.h>
 #include <lz4_compression.h>
 #include <network.h>
 #include <security.h>
 #include <server.h>
+#include <stream.h>
 #include <storage.h>
 #include <utils.h>
 #include <wal.h>
@@ -77,6 +79,7 @@ static int wal_shipping_setup(int srv, char** wal_shipping);
 static void update_wal_lsn(int srv, size_t xlogptr);
 static void reap_wal_children(int sig);
 static void install_wal_sigchld_handler(void);
+static void wal_throttle_compress(char* directory, char* wal_file);
 
 void
 pgmoneta_wal(int srv, char** argv)
@@ -229,6 +232,9 @@ pgmoneta_wal(int srv, char** argv)
    pgmoneta_memory_stream_buffer_init(&buffer);
 
    config->common.servers[srv].wal_streaming = getpid();
+   atomic_store(&config->common.servers[srv].wal_ktls, pgmoneta_ssl_ktls(ssl));
+   pgmoneta_socket_busy_poll(srv, socket);
+   pgmoneta_socket_statistics(socket, false, &config->common.servers[srv].wal_socket);
 
    pgmoneta_create_identify_system_message(&identify_system_msg);
    if (pgmoneta_query_execute(ssl, socket, identify_system_msg,
@@ -405,6 +411,7 @@ pgmoneta_wal(int srv, char** argv)
                         pgmoneta_log_error("Could not create or open WAL segment file at %s", d);
                         goto error;
                      }
+                     pgmoneta_usage_add(srv, USAGE_WAL, segsize);
                      memset(config->common.servers[srv].current_wal_filename, 0, MISC_LENGTH);
                      pgmoneta_snprintf(config->common.servers[srv].current_wal_filename, MISC_LENGTH, "%s.partial", filename);
                      if ((wal_shipping_file = wal_open(wal_shipping, filename, segsize)) == NULL)
@@ -414,6 +421,10 @@ pgmoneta_wal(int srv, char** argv)
                            pgmoneta_log_warn("Could not create or open WAL segment file at %s", wal_shipping);
                         }
                      }
+                     else
+                     {
+                        pgmoneta_usage_add(srv, USAGE_WAL_SHIPPING_WAL, segsize);
+                     }
                      if (config->storage_engine & STORAGE_ENGINE_SSH)
                      {
                         if (pgmoneta_sftp_wal_open(srv, filename, segsize, &sftp_wal_file) == 1)
@@ -430,6 +441,7 @@ pgmoneta_wal(int srv, char** argv)
                   }
                   bytes_left = msg->length - hdrlen;
                   size_t bytes_written = 0;
+                  pgmoneta_throttle(THROTTLE_WAL, bytes_left);
                   // write to the wal file
                   while (bytes_left > 0)
                   {
@@ -505,6 +517,7 @@ pgmoneta_wal(int srv, char** argv)
                               pgmoneta_log_error("Could not create or open WAL segment file at %s", d);
                               goto error;
                            }
+                           pgmoneta_usage_add(srv, USAGE_WAL, segsize);
                            memset(config->common.servers[srv].current_wal_filename, 0, MISC_LENGTH);
                            pgmoneta_snprintf(config->common.servers[srv].current_wal_filename, MISC_LENGTH, "%s.partial", filename);
                            if ((wal_shipping_file = wal_open(wal_shipping, filename, segsize)) == NULL)
@@ -514,6 +527,10 @@ pgmoneta_wal(int srv, char** argv)
                                  pgmoneta_log_warn("Could not create or open WAL segment file at %s", wal_shipping);
                               }
                            }
+                           else
+                           {
+                              pgmoneta_usage_add(srv, USAGE_WAL_SHIPPING_WAL, segsize);
+                           }
                            if (config->storage_engine & STORAGE_ENGINE_SSH)
                            {
                               if (pgmoneta_sftp_wal_open(srv, filename, segsize, &sftp_wal_file) == 1)
@@ -540,6 +557,8 @@ pgmoneta_wal(int srv, char** argv)
                         free(wal_filename);
                         wal_filename = NULL;
 
+                        pgmoneta_socket_statistics(socket, false, &config->common.servers[srv].wal_socket);
+
                         break;
                      }
                   }
@@ -553,6 +572,7 @@ pgmoneta_wal(int srv, char** argv)
                {
                   // keep alive request
                   update_wal_lsn(srv, xlogptr);
+                  pgmoneta_socket_statistics(socket, false, &config->common.servers[srv].wal_socket);
                   wal_send_status_report(ssl, socket, xlogptr, xlogptr, 0);
                   break;
                }
@@ -627,6 +647,7 @@ pgmoneta_wal(int srv, char** argv)
    pgmoneta_wal_server_compress_encrypt(srv, argv, NULL);
 
    config->common.servers[srv].wal_streaming = -1;
+   atomic_store(&config->common.servers[srv].wal_ktls, 0);
    pgmoneta_close_ssl(ssl);
    if (socket != -1)
    {
@@ -679,6 +700,7 @@ pgmoneta_wal(int srv, char** argv)
 error:
    pgmoneta_server_set_online(srv, false);
    config->common.servers[srv].wal_streaming = -1;
+   atomic_store(&config->common.servers[srv].wal_ktls, 0);
    pgmoneta_close_ssl(ssl);
    if (socket != -1)
    {
@@ -1848,7 +1870,40 @@ retry:
          pgmoneta_deque_add(excludes, ".aes", 0, ValueString);
          pgmoneta_deque_add(excludes, "backup_label", 0, ValueString);
 
-         if (scan)
+         /* Unlike the streaming the pass may wait, the segments are already safe on disk */
+         wal_throttle_compress(d, scan ? NULL : wal_file);
+
+         if (COMPRESSION_ALGORITHM(config->compression_type) != COMPRESSION_ALG_NONE &&
+             config->common.encryption != ENCRYPTION_NONE)
+         {
+            /* Compress and encrypt in a single pass without an intermediate file */
+            if (scan)
+            {
+               if (pgmoneta_stream_directory(-1, d, config->compression_type, config->common.encryption, NULL, excludes, NULL))
+               {
+                  pgmoneta_log_error("WAL: Could not compress/encrypt %s", d);
+               }
+            }
+            else
+            {
+               char from[MAX_PATH];
+               char to[MAX_PATH];
+               char* suffix = NULL;
+
+               pgmoneta_extraction_get_suffix(config->compression_type, config->common.encryption, &suffix);
+
+               pgmoneta_snprintf(from, sizeof(from), "%s/%s", d, wal_file);
+               pgmoneta_snprintf(to, sizeof(to), "%s/%s%s", d, wal_file, suffix != NULL ? suffix : "");
+
+               if (pgmoneta_stream_file(from, to, config->compression_type, config->common.encryption, NULL))
+               {
+                  pgmoneta_log_error("WAL: Could not compress/encrypt %s", from);
+               }
+
+               free(suffix);
+            }
+         }
+         else if (scan)
          {
             pgmoneta_compress_directory(-1, d, config->compression_type, NULL, excludes);
          }
@@ -1866,7 +1921,8 @@ retry:
             pgmoneta_compress_file(from, to, config->compression_type, NULL);
          }
 
-         if (config->common.encryption != ENCRYPTION_NONE)
+         if (config->common.encryption != ENCRYPTION_NONE &&
+             COMPRESSION_ALGORITHM(config->compression_type) == COMPRESSION_ALG_NONE)
          {
             if (scan)
             {
@@ -1918,3 +1974,75 @@ retry:
       exit(0);
    }
 }
+
+void
+pgmoneta_wal_bundle(int srv, char** argv)
+{
+   int active = 0;
+   int ret = 1;
+   struct main_configuration* config;
+
+   config = (struct main_configuration*)shmem;
+
+   pgmoneta_start_logging();
+   pgmoneta_memory_init();
+
+   if (argv != NULL)
+   {
+      pgmoneta_set_proc_title(1, argv, "wal/bundle", config->common.servers[srv].name);
+   }
+
+   /* A single bundler per server so a segment is shipped once. The lock holds
+      the process id, so it is released by pgmoneta when the process dies */
+   if (atomic_compare_exchange_strong(&config->common.servers[srv].wal_bundle, &active, (int)getpid()))
+   {
+      ret = pgmoneta_s3_wal_bundle(srv);
+
+      atomic_store(&config->common.servers[srv].wal_bundle, 0);
+   }
+   else
+   {
+      pgmoneta_log_debug("WAL: Bundling already active for server %s", config->common.servers[srv].name);
+      ret = 0;
+   }
+
+   pgmoneta_memory_destroy();
+   pgmoneta_stop_logging();
+
+   exit(ret);
+}
+
+static void
+wal_throttle_compress(char* directory, char* wal_file)
+{
+   char path[MAX_PATH];
+   uint64_t bytes = 0;
+   DIR* dir = NULL;
+   struct dirent* entry = NULL;
+
+   if (!pgmoneta_throttle_enabled())
+   {
+      return;
+   }
+
+   if (wal_file != NULL)
+   {
+      pgmoneta_snprintf(path, sizeof(path), "%s/%s", directory, wal_file);
+      bytes = pgmoneta_get_file_size(path);
+   }
+   else if ((dir = opendir(directory)) != NULL)
+   {
+      while ((entry = readdir(dir)) != NULL)
+      {
+         if (pgmoneta_is_wal_file(entry->d_name))
+         {
+            pgmoneta_snprintf(path, sizeof(path), "%s/%s", directory, entry->d_name);
+            bytes += pgmoneta_get_file_size(path);
+         }
+      }
+
+      closedir(dir);
+   }
+
+   pgmoneta_throttle(THROTTLE_WAL_COMPRESS, bytes);
+}
@@ -0,0 +1,360 @@
+/*
+ * Copyright (C) 2026 The pgmoneta community
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or other
+ * materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may
+ * be used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* pgmoneta */
+#include <pgmoneta.h>
+#include <deque.h>
+#include <logging.h>
+#include <utils.h>
+#include <walbundle.h>
+
+/* system */
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define WAL_BUNDLE_NAME_LENGTH 24
+
+static int bundle_copy(FILE* from, FILE* to, uint64_t size);
+
+int
+pgmoneta_wal_bundle_create(char* directory, struct deque* files, char* path)
+{
+   char from[MAX_PATH];
+   char line[MISC_LENGTH + 64];
+   char trailer[WAL_BUNDLE_TRAILER_SIZE];
+   uint64_t offset = 0;
+   uint64_t size = 0;
+   FILE* bundle = NULL;
+   FILE* segment = NULL;
+   struct deque* index = NULL;
+   struct deque_iterator* it = NULL;
+
+   if (directory == NULL || files == NULL || path == NULL || pgmoneta_deque_empty(files))
+   {
+      goto error;
+   }
+
+   bundle = fopen(path, "wb");
+   if (bundle == NULL)
+   {
+      pgmoneta_log_error("WAL bundle: could not create %s: %s", path, strerror(errno));
+      goto error;
+   }
+
+   if (pgmoneta_deque_create(false, &index) || pgmoneta_deque_iterator_create(files, &it))
+   {
+      goto error;
+   }
+
+   while (pgmoneta_deque_iterator_next(it))
+   {
+      if (strlen(it->tag) >= MISC_LENGTH)
+      {
+         goto error;
+      }
+
+      pgmoneta_snprintf(from, sizeof(from), "%s/%s", directory, it->tag);
+
+      segment = fopen(from, "rb");
+      if (segment == NULL)
+      {
+         pgmoneta_log_error("WAL bundle: could not open %s: %s", from, strerror(errno));
+         goto error;
+      }
+
+      size = pgmoneta_get_file_size(from);
+      if (bundle_copy(segment, bundle, size))
+      {
+         pgmoneta_log_error("WAL bundle: could not copy %s", from);
+         goto error;
+      }
+
+      fclose(segment);
+      segment = NULL;
+
+      pgmoneta_snprintf(line, sizeof(line), "%s,%" PRIu64 ",%" PRIu64 "\n", it->tag, offset, size);
+      pgmoneta_deque_add(index, NULL, (uintptr_t)line, ValueString);
+
+      offset += size;
+   }
+
+   pgmoneta_deque_iterator_destroy(it);
+   it = NULL;
+
+   if (pgmoneta_deque_iterator_create(index, &it))
+   {
+      goto error;
+   }
+
+   while (pgmoneta_deque_iterator_next(it))
+   {
+      char* l = (char*)it->value->data;
+
+      if (fwrite(l, 1, strlen(l), bundle) != strlen(l))
+      {
+         goto error;
+      }
+   }
+
+   pgmoneta_write_uint64(&trailer[0], offset);
+   memcpy(&trailer[8], WAL_BUNDLE_MAGIC, 8);
+
+   if (fwrite(&trailer[0], 1, sizeof(trailer), bundle) != sizeof(trailer))
+   {
+      goto error;
+   }
+
+   if (fflush(bundle) || fsync(fileno(bundle)))
+   {
+      goto error;
+   }
+
+   fclose(bundle);
+
+   pgmoneta_deque_iterator_destroy(it);
+   pgmoneta_deque_destroy(index);
+
+   return 0;
+
+error:
+
+   if (segment != NULL)
+   {
+      fclose(segment);
+   }
+
+   if (bundle != NULL)
+   {
+      fclose(bundle);
+      unlink(path);
+   }
+
+   pgmoneta_deque_iterator_destroy(it);
+   pgmoneta_deque_destroy(index);
+
+   return 1;
+}
+
+char*
+pgmoneta_wal_bundle_name(char* first, char* last)
+{
+   char* name = NULL;
+   size_t length = 2 * WAL_BUNDLE_NAME_LENGTH + strlen(WAL_BUNDLE_SUFFIX) + 2;
+
+   if (first == NULL || last == NULL || strlen(first) < WAL_BUNDLE_NAME_LENGTH || strlen(last) < WAL_BUNDLE_NAME_LENGTH)
+   {
+      return NULL;
+   }
+
+   name = (char*)malloc(length);
+   if (name == NULL)
+   {
+      return NULL;
+   }
+
+   pgmoneta_snprintf(name, length, "%.24s-%.24s%s", first, last, WAL_BUNDLE_SUFFIX);
+
+   return name;
+}
+
+bool
+pgmoneta_wal_bundle_ends_before(char* bundle, char* segment)
+{
+   if (bundle == NULL || segment == NULL ||
+       strlen(bundle) < 2 * WAL_BUNDLE_NAME_LENGTH + 1 || strlen(segment) < WAL_BUNDLE_NAME_LENGTH ||
+       bundle[WAL_BUNDLE_NAME_LENGTH] != '-' || !pgmoneta_ends_with(bundle, WAL_BUNDLE_SUFFIX))
+   {
+      return false;
+   }
+
+   /* Segment names of a timeline sort in WAL order */
+   return strncmp(bundle + WAL_BUNDLE_NAME_LENGTH + 1, segment, WAL_BUNDLE_NAME_LENGTH) < 0;
+}
+
+bool
+pgmoneta_wal_bundle_covers(char* bundle, char* segment)
+{
+   if (bundle == NULL || segment == NULL ||
+       strlen(bundle) < 2 * WAL_BUNDLE_NAME_LENGTH + 1 || strlen(segment) < WAL_BUNDLE_NAME_LENGTH ||
+       bundle[WAL_BUNDLE_NAME_LENGTH] != '-' || !pgmoneta_ends_with(bundle, WAL_BUNDLE_SUFFIX))
+   {
+      return false;
+   }
+
+   return strncmp(segment, bundle, WAL_BUNDLE_NAME_LENGTH) >= 0 &&
+          !pgmoneta_wal_bundle_ends_before(bundle, segment);
+}
+
+int
+pgmoneta_wal_bundle_read_trailer(void* data, size_t size, uint64_t total, uint64_t* offset, uint64_t* length)
+{
+   uint64_t o = 0;
+
+   *offset = 0;
+   *length = 0;
+
+   if (data == NULL || size != WAL_BUNDLE_TRAILER_SIZE || total < WAL_BUNDLE_TRAILER_SIZE ||
+       memcmp((char*)data + 8, WAL_BUNDLE_MAGIC, 8))
+   {
+      return 1;
+   }
+
+   o = pgmoneta_read_uint64(data);
+   if (o > total - WAL_BUNDLE_TRAILER_SIZE)
+   {
+      return 1;
+   }
+
+   *offset = o;
+   *length = total - WAL_BUNDLE_TRAILER_SIZE - o;
+
+   return 0;
+}
+
+int
+pgmoneta_wal_bundle_read_index(char* data, size_t size, struct deque** entries)
+{
+   char* line = NULL;
+   char* end = NULL;
+   char* limit = NULL;
+   char* c1 = NULL;
+   char* c2 = NULL;
+   struct wal_bundle_entry* entry = NULL;
+   struct deque* d = NULL;
+
+   *entries = NULL;
+
+   if (data == NULL || pgmoneta_deque_create(false, &d))
+   {
+      goto error;
+   }
+
+   line = data;
+   limit = data + size;
+
+   while (line < limit)
+   {
+      end = memchr(line, '\n', limit - line);
+      if (end == NULL)
+      {
+         goto error;
+      }
+
+      c1 = memchr(line, ',', end - line);
+      c2 = c1 != NULL ? memchr(c1 + 1, ',', end - c1 - 1) : NULL;
+      if (c2 == NULL || c1 - line >= MISC_LENGTH || c1 - line < WAL_BUNDLE_NAME_LENGTH)
+      {
+         goto error;
+      }
+
+      entry = (struct wal_bundle_entry*)malloc(sizeof(struct wal_bundle_entry));
+      if (entry == NULL)
+      {
+         goto error;
+      }
+
+      memset(entry, 0, sizeof(struct wal_bundle_entry));
+      memcpy(entry->name, line, c1 - line);
+      entry->offset = strtoull(c1 + 1, NULL, 10);
+      entry->size = strtoull(c2 + 1, NULL, 10);
+
+      if (pgmoneta_deque_add(d, entry->name, (uintptr_t)entry, ValueMem))
+      {
+         free(entry);
+         goto error;
+      }
+
+      line = end + 1;
+   }
+
+   *entries = d;
+
+   return 0;
+
+error:
+
+   pgmoneta_log_error("WAL bundle: invalid index");
+   pgmoneta_deque_destroy(d);
+
+   return 1;
+}
+
+struct wal_bundle_entry*
+pgmoneta_wal_bundle_find(struct deque* entries, char* segment)
+{
+   struct wal_bundle_entry* entry = NULL;
+   struct deque_iterator* it = NULL;
+
+   if (entries == NULL || segment == NULL || pgmoneta_deque_iterator_create(entries, &it))
+   {
+      return NULL;
+   }
+
+   while (entry == NULL && pgmoneta_deque_iterator_next(it))
+   {
+      struct wal_bundle_entry* e = (struct wal_bundle_entry*)it->value->data;
+
+      if (!strncmp(e->name, segment, WAL_BUNDLE_NAME_LENGTH))
+      {
+         entry = e;
+      }
+   }
+
+   pgmoneta_deque_iterator_destroy(it);
+
+   return entry;
+}
+
+static int
+bundle_copy(FILE* from, FILE* to, uint64_t size)
+{
+   char buffer[65536];
+   size_t n = 0;
+
+   while (size > 0)
+   {
+      n = fread(&buffer[0], 1, MIN(sizeof(buffer), size), from);
+      if (n == 0)
+      {
+         return 1;
+      }
+
+      if (fwrite(&buffer[0], 1, n, to) != n)
+      {
+         return 1;
+      }
+
+      size -= n;
+   }
+
+   return 0;
+}
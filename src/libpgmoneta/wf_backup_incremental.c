@@ -690,6 +690,8 @@ incr_backup_execute_17_plus(char* name __attribute__((unused)), struct art* node
    struct stream_buffer* buffer = NULL;
    struct query_response* response = NULL;
    struct tablespace* tablespaces = NULL;
+   struct art* file_digests = NULL;
+   struct art* file_trees = NULL;
    struct tablespace* current_tablespace = NULL;
    struct tuple* tup = NULL;
    struct backup* backup = NULL;
@@ -856,7 +858,13 @@ incr_backup_execute_17_plus(char* name __attribute__((unused)), struct art* node
 
    pgmoneta_mkdir(backup_base);
 
-   if (pgmoneta_receive_archive_stream(server, ssl, socket, buffer, backup_base, tablespaces))
+   /* The digests are owned by the nodes, so the checksum stages can reuse them */
+   pgmoneta_art_create(&file_digests);
+   pgmoneta_art_insert(nodes, NODE_DIGESTS, (uintptr_t)file_digests, ValueART);
+   pgmoneta_art_create(&file_trees);
+   pgmoneta_art_insert(nodes, NODE_TREES, (uintptr_t)file_trees, ValueART);
+
+   if (pgmoneta_receive_archive_stream(server, ssl, socket, buffer, backup_base, tablespaces, file_digests, file_trees))
    {
       pgmoneta_log_error("Incremental backup: Could not backup %s", config->common.servers[server].name);
 
@@ -871,6 +879,8 @@ incr_backup_execute_17_plus(char* name __attribute__((unused)), struct art* node
       goto error;
    }
 
+   pgmoneta_socket_statistics(socket, false, &config->common.servers[server].backup_socket);
+
    // Receive the final result set, which contains the WAL ending point
    if (pgmoneta_consume_data_row_messages(server, ssl, socket, buffer, &response))
    {
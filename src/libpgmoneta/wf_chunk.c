@@ -0,0 +1,183 @@
+/*
+ * Copyright (C) 2026 The pgmoneta community
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or other
+ * materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may
+ * be used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* pgmoneta */
+#include <pgmoneta.h>
+#include <chunk.h>
+#include <info.h>
+#include <logging.h>
+#include <utils.h>
+#include <workers.h>
+#include <workflow.h>
+
+/* system */
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+static char* chunk_name(void);
+static int chunk_execute(char*, struct art*);
+
+struct workflow*
+pgmoneta_create_chunk(void)
+{
+   struct workflow* wf = NULL;
+
+   wf = (struct workflow*)malloc(sizeof(struct workflow));
+
+   if (wf == NULL)
+   {
+      return NULL;
+   }
+
+   wf->name = &chunk_name;
+   wf->setup = &pgmoneta_common_setup;
+   wf->execute = &chunk_execute;
+   wf->teardown = &pgmoneta_common_teardown;
+   wf->next = NULL;
+
+   return wf;
+}
+
+static char*
+chunk_name(void)
+{
+   return PHASE_NAME_CHUNK;
+}
+
+static int
+chunk_execute(char* name __attribute__((unused)), struct art* nodes)
+{
+   int server = -1;
+   char* label = NULL;
+   char* store = NULL;
+   char* index = NULL;
+   char* backup_base = NULL;
+   char* backup_data = NULL;
+   char* server_backup = NULL;
+   uint64_t chunked = 0;
+   uint64_t stored = 0;
+   int number_of_workers = 0;
+   struct timespec start_t;
+   struct timespec end_t;
+   struct backup* backup = NULL;
+   struct workers* workers = NULL;
+   struct main_configuration* config;
+
+   config = (struct main_configuration*)shmem;
+
+#ifdef DEBUG
+   pgmoneta_dump_art(nodes);
+
+   assert(pgmoneta_art_contains_key(nodes, NODE_SERVER_ID));
+   assert(pgmoneta_art_contains_key(nodes, NODE_LABEL));
+   assert(pgmoneta_art_contains_key(nodes, NODE_BACKUP));
+   assert(pgmoneta_art_contains_key(nodes, NODE_BACKUP_BASE));
+   assert(pgmoneta_art_contains_key(nodes, NODE_BACKUP_DATA));
+   assert(pgmoneta_art_contains_key(nodes, NODE_SERVER_BACKUP));
+#endif
+
+   server = (int)pgmoneta_art_search(nodes, NODE_SERVER_ID);
+   label = (char*)pgmoneta_art_search(nodes, NODE_LABEL);
+
+   pgmoneta_log_debug("Chunk (execute): %s/%s", config->common.servers[server].name, label);
+
+#ifdef HAVE_FREEBSD
+   clock_gettime(CLOCK_MONOTONIC_FAST, &start_t);
+#else
+   clock_gettime(CLOCK_MONOTONIC_RAW, &start_t);
+#endif
+
+   backup = (struct backup*)pgmoneta_art_search(nodes, NODE_BACKUP);
+   backup_base = (char*)pgmoneta_art_search(nodes, NODE_BACKUP_BASE);
+   backup_data = (char*)pgmoneta_art_search(nodes, NODE_BACKUP_DATA);
+   server_backup = (char*)pgmoneta_art_search(nodes, NODE_SERVER_BACKUP);
+
+   store = pgmoneta_get_server_chunks(server, config->chunk_store_shared);
+
+   index = pgmoneta_append(index, backup_base);
+   if (!pgmoneta_ends_with(index, "/"))
+   {
+      index = pgmoneta_append(index, "/");
+   }
+   index = pgmoneta_append(index, CHUNK_INDEX);
+
+   number_of_workers = pgmoneta_get_number_of_workers(server);
+   if (number_of_workers > 0)
+   {
+      pgmoneta_workers_initialize(number_of_workers, &workers);
+   }
+
+   /* Record the store before any chunk is added, so a collection keeps them */
+   backup->chunked_shared = config->chunk_store_shared;
+
+   if (pgmoneta_save_info(server_backup, backup))
+   {
+      goto error;
+   }
+
+   if (pgmoneta_chunk_directory(store, backup_data, index, workers, &chunked, &stored))
+   {
+      pgmoneta_log_error("Chunk: Could not chunk %s/%s", config->common.servers[server].name, label);
+      goto error;
+   }
+
+   pgmoneta_workers_destroy(workers);
+   workers = NULL;
+
+#ifdef HAVE_FREEBSD
+   clock_gettime(CLOCK_MONOTONIC_FAST, &end_t);
+#else
+   clock_gettime(CLOCK_MONOTONIC_RAW, &end_t);
+#endif
+
+   pgmoneta_log_debug("Chunk: %s/%s (Chunked: %lu Stored: %lu Elapsed: %.4f)",
+                      config->common.servers[server].name, label, chunked, stored,
+                      pgmoneta_compute_duration(start_t, end_t));
+
+   backup->chunked_size = chunked;
+   backup->chunked_stored_size = stored;
+
+   if (pgmoneta_save_info(server_backup, backup))
+   {
+      goto error;
+   }
+
+   free(store);
+   free(index);
+
+   return 0;
+
+error:
+
+   pgmoneta_workers_destroy(workers);
+   free(store);
+   free(index);
+
+   return 1;
+}
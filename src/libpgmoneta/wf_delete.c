@@ -31,6 +31,7 @@
 #include <pgmoneta.h>
 #include <art.h>
 #include <backup.h>
+#include <chunk.h>
 #include <link.h>
 #include <logging.h>
 #include <management.h>
@@ -174,6 +175,11 @@ delete_backup_execute(char* name __attribute__((unused)), struct art* nodes)
 
    pgmoneta_log_debug("Delete: %s/%s", config->common.servers[server].name, backups[backup_index]->label);
 
+   if (pgmoneta_chunk_collect_server(server))
+   {
+      pgmoneta_log_warn("Delete: Unable to collect chunks for %s", config->common.servers[server].name);
+   }
+
    for (int i = 0; i < number_of_backups; i++)
    {
       free(backups[i]);
@@ -257,6 +263,7 @@ delete_backup(int server, int index, struct backup* backup __attribute__((unused
    char* d = NULL;
    char* backup_dir = NULL;
    unsigned long size;
+   unsigned long deleted;
    int number_of_workers = 0;
    struct workers* workers = NULL;
    struct main_configuration* config;
@@ -295,6 +302,7 @@ delete_backup(int server, int index, struct backup* backup __attribute__((unused
    }
 
    d = pgmoneta_get_server_backup_identifier(server, backups[index]->label);
+   deleted = pgmoneta_directory_size(d);
 
    number_of_workers = pgmoneta_get_number_of_workers(server);
    if (number_of_workers > 0)
@@ -417,6 +425,8 @@ delete_backup(int server, int index, struct backup* backup __attribute__((unused
       pgmoneta_delete_directory(d);
    }
 
+   pgmoneta_usage_add(server, USAGE_BACKUP, -(int64_t)deleted);
+
    free(temp_backup);
    free(backup_dir);
    free(d);
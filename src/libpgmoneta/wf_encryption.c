@@ -33,6 +33,7 @@
 #include <deque.h>
 #include <logging.h>
 #include <progress.h>
+#include <stream.h>
 #include <utils.h>
 #include <workflow.h>
 
@@ -42,7 +43,9 @@
 
 static char* encryption_name(void);
 static int encryption_execute(char*, struct art*);
+static int compression_encryption_execute(char*, struct art*);
 static int decryption_execute(char*, struct art*);
+static int encrypt_backup(struct art* nodes, bool compress);
 
 struct workflow*
 pgmoneta_encryption(bool encrypt)
@@ -74,6 +77,27 @@ pgmoneta_encryption(bool encrypt)
    return wf;
 }
 
+struct workflow*
+pgmoneta_create_compression_encryption(void)
+{
+   struct workflow* wf = NULL;
+
+   wf = (struct workflow*)malloc(sizeof(struct workflow));
+
+   if (wf == NULL)
+   {
+      return NULL;
+   }
+
+   wf->name = &encryption_name;
+   wf->setup = &pgmoneta_common_setup;
+   wf->execute = &compression_encryption_execute;
+   wf->teardown = &pgmoneta_common_teardown;
+   wf->next = NULL;
+
+   return wf;
+}
+
 static char*
 encryption_name(void)
 {
@@ -82,6 +106,18 @@ encryption_name(void)
 
 static int
 encryption_execute(char* name __attribute__((unused)), struct art* nodes)
+{
+   return encrypt_backup(nodes, false);
+}
+
+static int
+compression_encryption_execute(char* name __attribute__((unused)), struct art* nodes)
+{
+   return encrypt_backup(nodes, true);
+}
+
+static int
+encrypt_backup(struct art* nodes, bool compress)
 {
    int server = -1;
    char* label = NULL;
@@ -101,6 +137,8 @@ encryption_execute(char* name __attribute__((unused)), struct art* nodes)
    int number_of_workers = 0;
    struct workers* workers = NULL;
    struct deque* excludes = NULL;
+   struct art* digests = NULL;
+   struct stream_digests file_digests;
    struct main_configuration* config;
    struct backup* backup = NULL;
 
@@ -129,17 +167,19 @@ encryption_execute(char* name __attribute__((unused)), struct art* nodes)
    server_backup = (char*)pgmoneta_art_search(nodes, NODE_SERVER_BACKUP);
    backup = (struct backup*)pgmoneta_art_search(nodes, NODE_BACKUP);
    tarfile = (char*)pgmoneta_art_search(nodes, NODE_TARGET_FILE);
+   digests = (struct art*)pgmoneta_art_search(nodes, NODE_DIGESTS);
 
-   pgmoneta_log_debug("Encryption (execute): %s/%s", config->common.servers[server].name, label);
+   pgmoneta_log_debug("%s (execute): %s/%s", compress ? "Compression/Encryption" : "Encryption",
+                      config->common.servers[server].name, label);
 
-   if (tarfile == NULL)
+   number_of_workers = pgmoneta_get_number_of_workers(server);
+   if (number_of_workers > 0)
    {
-      number_of_workers = pgmoneta_get_number_of_workers(server);
-      if (number_of_workers > 0)
-      {
-         pgmoneta_workers_initialize(number_of_workers, &workers);
-      }
+      pgmoneta_workers_initialize(number_of_workers, &workers);
+   }
 
+   if (tarfile == NULL)
+   {
       if (pgmoneta_deque_create(true, &excludes))
       {
          goto error;
@@ -156,7 +196,15 @@ encryption_execute(char* name __attribute__((unused)), struct art* nodes)
          pgmoneta_progress_set_total(server, file_count);
       }
 
-      if (pgmoneta_encrypt_directory(server, backup_base, workers, excludes))
+      if (compress)
+      {
+         /* The checksum stages reuse the digests of the written files */
+         if (pgmoneta_stream_directory(server, backup_base, backup->compression, backup->encryption, workers, excludes, digests))
+         {
+            goto error;
+         }
+      }
+      else if (pgmoneta_encrypt_directory(server, backup_base, workers, excludes))
       {
          goto error;
       }
@@ -169,7 +217,6 @@ encryption_execute(char* name __attribute__((unused)), struct art* nodes)
             goto error;
          }
       }
-      pgmoneta_workers_destroy(workers);
 
       pgmoneta_deque_destroy(excludes);
       excludes = NULL;
@@ -178,7 +225,7 @@ encryption_execute(char* name __attribute__((unused)), struct art* nodes)
    {
       const char* alg_suffix = NULL;
 
-      pgmoneta_compression_get_suffix(config->compression_type, &alg_suffix);
+      pgmoneta_compression_get_suffix(compress ? backup->compression : config->compression_type, &alg_suffix);
       if (alg_suffix != NULL)
       {
          compress_suffix = (char*)alg_suffix;
@@ -200,14 +247,44 @@ encryption_execute(char* name __attribute__((unused)), struct art* nodes)
          pgmoneta_log_debug("%s doesn't exists", d);
       }
 
-      enc_file = pgmoneta_append(enc_file, tarfile);
-      enc_file = pgmoneta_append(enc_file, compress_suffix);
-      if (pgmoneta_encrypt_file(enc_file, d, NULL))
+      if (compress)
       {
-         goto error;
+         /* The archive is read once and only the final file is written */
+         memset(&file_digests, 0, sizeof(struct stream_digests));
+         if (pgmoneta_stream_file(tarfile, d, backup->compression, backup->encryption, digests != NULL ? &file_digests : NULL))
+         {
+            goto error;
+         }
+
+         if (digests != NULL)
+         {
+            pgmoneta_stream_digests_add(digests, d, &file_digests);
+         }
+      }
+      else
+      {
+         enc_file = pgmoneta_append(enc_file, tarfile);
+         enc_file = pgmoneta_append(enc_file, compress_suffix);
+         /* The chunks of the archive are encrypted in parallel */
+         if (pgmoneta_encrypt_file(enc_file, d, workers))
+         {
+            goto error;
+         }
+      }
+
+      if (workers != NULL)
+      {
+         pgmoneta_workers_wait(workers);
+         if (!workers->outcome)
+         {
+            goto error;
+         }
       }
    }
 
+   pgmoneta_workers_destroy(workers);
+   workers = NULL;
+
 #ifdef HAVE_FREEBSD
    clock_gettime(CLOCK_MONOTONIC_FAST, &end_t);
 #else
@@ -223,7 +300,8 @@ encryption_execute(char* name __attribute__((unused)), struct art* nodes)
    memset(&elapsed[0], 0, sizeof(elapsed));
    sprintf(&elapsed[0], "%02i:%02i:%.4f", hours, minutes, seconds);
 
-   pgmoneta_log_debug("Encryption: %s/%s (Elapsed: %s)", config->common.servers[server].name, label, &elapsed[0]);
+   pgmoneta_log_debug("%s: %s/%s (Elapsed: %s)", compress ? "Compression/Encryption" : "Encryption",
+                      config->common.servers[server].name, label, &elapsed[0]);
 
    backup->encryption_elapsed_time = encryption_elapsed_time;
    if (pgmoneta_save_info(server_backup, backup))
@@ -244,7 +322,7 @@ error:
       pgmoneta_deque_destroy(excludes);
    }
 
-   if (number_of_workers > 0)
+   if (workers != NULL)
    {
       pgmoneta_workers_destroy(workers);
    }
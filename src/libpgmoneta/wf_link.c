@@ -81,8 +81,6 @@ link_execute(char* name __attribute__((unused)), struct art* nodes)
    char* server_path = NULL;
    char* from = NULL;
    char* to = NULL;
-   char* from_manifest = NULL;
-   char* to_manifest = NULL;
    char* from_tablespaces = NULL;
    char* to_tablespaces = NULL;
    char* backup_base = NULL;
@@ -97,9 +95,6 @@ link_execute(char* name __attribute__((unused)), struct art* nodes)
    int index = 0;
    struct workers* workers = NULL;
    struct main_configuration* config;
-   struct art* deleted_files = NULL;
-   struct art* changed_files = NULL;
-   struct art* added_files = NULL;
    struct backup* backup = NULL;
    config = (struct main_configuration*)shmem;
 
@@ -162,17 +157,11 @@ link_execute(char* name __attribute__((unused)), struct art* nodes)
 
          to = pgmoneta_get_server_backup_identifier(server, backups[next_newest]->label);
 
-         from_manifest = pgmoneta_append(from_manifest, from);
-         from_manifest = pgmoneta_append(from_manifest, "backup.manifest");
-
-         to_manifest = pgmoneta_append(to_manifest, to);
-         to_manifest = pgmoneta_append(to_manifest, "backup.manifest");
-
-         from = pgmoneta_append(from, "data/");
-         to = pgmoneta_append(to, "data/");
-
-         pgmoneta_compare_manifests(to_manifest, from_manifest, &deleted_files, &changed_files, &added_files);
-         pgmoneta_link_manifest(from, to, from, changed_files, added_files, workers);
+         /* Linking only saves space, so the backup stays usable without it */
+         if (pgmoneta_link_comparefiles(from, to, workers))
+         {
+            pgmoneta_log_warn("Link: Could not compare %s/%s with %s, files are not linked", config->common.servers[server].name, label, backups[next_newest]->label);
+         }
 
          pgmoneta_workers_wait(workers);
          if (workers != NULL && !workers->outcome)
@@ -217,13 +206,8 @@ link_execute(char* name __attribute__((unused)), struct art* nodes)
    free(server_path);
    free(from);
    free(to);
-   free(from_manifest);
-   free(to_manifest);
    free(from_tablespaces);
    free(to_tablespaces);
-   pgmoneta_art_destroy(changed_files);
-   pgmoneta_art_destroy(added_files);
-   pgmoneta_art_destroy(deleted_files);
 
    return 0;
 
@@ -240,13 +224,8 @@ error:
    free(server_path);
    free(from);
    free(to);
-   free(from_manifest);
-   free(to_manifest);
    free(from_tablespaces);
    free(to_tablespaces);
-   pgmoneta_art_destroy(changed_files);
-   pgmoneta_art_destroy(added_files);
-   pgmoneta_art_destroy(deleted_files);
 
    return 1;
 }
@@ -87,6 +87,10 @@ manifest_execute(char* name __attribute__((unused)), struct art* nodes)
    struct json_reader* reader = NULL;
    struct json* entry = NULL;
    struct csv_writer* writer = NULL;
+   struct csv_writer* tree_writer = NULL;
+   struct art* trees = NULL;
+   char* tree = NULL;
+   char* tree_path = NULL;
    char file_path[MAX_PATH];
    char* info[MANIFEST_COLUMN_COUNT];
    struct main_configuration* config;
@@ -123,6 +127,7 @@ manifest_execute(char* name __attribute__((unused)), struct art* nodes)
    server_backup = (char*)pgmoneta_art_search(nodes, NODE_SERVER_BACKUP);
 
    incremental = (char*)pgmoneta_art_search(nodes, NODE_INCREMENTAL_BASE);
+   trees = (struct art*)pgmoneta_art_search(nodes, NODE_TREES);
 
    manifest = pgmoneta_append(manifest, backup_base);
    if (!pgmoneta_ends_with(manifest, "/"))
@@ -131,6 +136,13 @@ manifest_execute(char* name __attribute__((unused)), struct art* nodes)
    }
    manifest = pgmoneta_append(manifest, "backup.manifest");
 
+   tree_path = pgmoneta_append(tree_path, backup_base);
+   if (!pgmoneta_ends_with(tree_path, "/"))
+   {
+      tree_path = pgmoneta_append(tree_path, "/");
+   }
+   tree_path = pgmoneta_append(tree_path, "backup.tree");
+
    manifest_orig = pgmoneta_append(manifest_orig, backup_data);
    if (!pgmoneta_ends_with(manifest_orig, "/"))
    {
@@ -180,11 +192,40 @@ manifest_execute(char* name __attribute__((unused)), struct art* nodes)
       info[MANIFEST_PATH_INDEX] = file_path;
       info[MANIFEST_CHECKSUM_INDEX] = (char*)pgmoneta_json_get(entry, "Checksum");
       pgmoneta_csv_write(writer, MANIFEST_COLUMN_COUNT, info);
+
+      /* Tree digests of large files are kept next to the manifest */
+      tree = (char*)pgmoneta_art_search(trees, file_path);
+      if (tree != NULL)
+      {
+         if (tree_writer == NULL && pgmoneta_csv_writer_init(tree_path, &tree_writer))
+         {
+            pgmoneta_log_error("Could not create csv writer for %s", tree_path);
+            goto error;
+         }
+
+         info[MANIFEST_CHECKSUM_INDEX] = tree;
+         pgmoneta_csv_write(tree_writer, MANIFEST_COLUMN_COUNT, info);
+      }
+
       pgmoneta_json_destroy(entry);
       entry = NULL;
    }
 
+   pgmoneta_csv_writer_destroy(writer);
+   writer = NULL;
+
+   /* Keep the manifest ordered by path so it can be merge joined */
+   if (pgmoneta_manifest_sort(manifest))
+   {
+      pgmoneta_log_error("Could not sort %s", manifest);
+      goto error;
+   }
+
    pgmoneta_permission(manifest, 6, 0, 0);
+   if (tree_writer != NULL)
+   {
+      pgmoneta_permission(tree_path, 6, 0, 0);
+   }
 
 #ifdef HAVE_FREEBSD
    clock_gettime(CLOCK_MONOTONIC_FAST, &end_t);
@@ -201,18 +242,22 @@ manifest_execute(char* name __attribute__((unused)), struct art* nodes)
 
    pgmoneta_json_reader_close(reader);
    pgmoneta_csv_writer_destroy(writer);
+   pgmoneta_csv_writer_destroy(tree_writer);
    pgmoneta_json_destroy(entry);
    free(manifest);
    free(manifest_orig);
+   free(tree_path);
 
    return 0;
 error:
    pgmoneta_json_destroy(m);
    pgmoneta_json_reader_close(reader);
    pgmoneta_csv_writer_destroy(writer);
+   pgmoneta_csv_writer_destroy(tree_writer);
    pgmoneta_json_destroy(entry);
    free(manifest);
    free(manifest_orig);
+   free(tree_path);
 
    return 1;
 }
@@ -29,6 +29,7 @@
 /* pgmoneta */
 #include <pgmoneta.h>
 #include <art.h>
+#include <chunk.h>
 #include <extraction.h>
 #include <logging.h>
 #include <restore.h>
@@ -180,6 +181,8 @@ restore_execute(char* name __attribute__((unused)), struct art* nodes)
    char* label = NULL;
    char* from = NULL;
    char* to = NULL;
+   char* chunks = NULL;
+   char* index = NULL;
    char* origwal = NULL;
    char* waldir = NULL;
    char* waltarget = NULL;
@@ -229,9 +232,25 @@ restore_execute(char* name __attribute__((unused)), struct art* nodes)
    {
       goto error;
    }
+
+   if (pgmoneta_chunk_is_chunked(server, label))
+   {
+      chunks = pgmoneta_get_server_chunks(server, backup->chunked_shared);
+      index = pgmoneta_get_server_backup_identifier(server, label);
+      index = pgmoneta_append(index, CHUNK_INDEX);
+
+      if (pgmoneta_chunk_restore(chunks, index, to, workers))
+      {
+         pgmoneta_log_error("Restore: Could not restore the chunks of %s/%s", config->common.servers[server].name, label);
+         goto error;
+      }
+   }
+
    pgmoneta_workers_destroy(workers);
 
    free(from);
+   free(chunks);
+   free(index);
    free(origwal);
    free(waldir);
    free(waltarget);
@@ -246,6 +265,8 @@ error:
    }
 
    free(from);
+   free(chunks);
+   free(index);
    free(origwal);
    free(waldir);
    free(waltarget);
@@ -272,7 +293,6 @@ combine_incremental_execute(char* name __attribute__((unused)), struct art* node
    char* output_dir;
    char* base = NULL;
    struct backup* bck = NULL;
-   struct json* manifest = NULL;
    struct main_configuration* config;
 
    config = (struct main_configuration*)shmem;
@@ -286,7 +306,6 @@ combine_incremental_execute(char* name __attribute__((unused)), struct art* node
    assert(pgmoneta_art_contains_key(nodes, NODE_LABELS));
    assert(pgmoneta_art_contains_key(nodes, NODE_LABEL));
    assert(pgmoneta_art_contains_key(nodes, NODE_TARGET_ROOT));
-   assert(pgmoneta_art_contains_key(nodes, NODE_MANIFEST));
    assert(pgmoneta_art_contains_key(nodes, NODE_COMBINE_AS_IS));
 #endif
 
@@ -309,11 +328,6 @@ combine_incremental_execute(char* name __attribute__((unused)), struct art* node
    input_dir = pgmoneta_get_server_backup_identifier_data(server, label);
    base = (char*)pgmoneta_art_search(nodes, NODE_TARGET_ROOT);
    output_dir = (char*)pgmoneta_art_search(nodes, NODE_TARGET_BASE);
-   manifest = (struct json*)pgmoneta_art_search(nodes, NODE_MANIFEST);
-   if (manifest == NULL)
-   {
-      goto error;
-   }
 
    if (pgmoneta_exists(output_dir))
    {
@@ -339,7 +353,7 @@ combine_incremental_execute(char* name __attribute__((unused)), struct art* node
       }
    }
 
-   if (pgmoneta_combine_backups(server, label, base, input_dir, output_dir, prior_labels, bck, manifest, incremental, combine_as_is))
+   if (pgmoneta_combine_backups(server, label, base, input_dir, output_dir, prior_labels, bck, incremental, combine_as_is))
    {
       goto error;
    }
@@ -30,6 +30,7 @@
 #include <pgmoneta.h>
 #include <delete.h>
 #include <logging.h>
+#include <storage.h>
 #include <utils.h>
 #include <workflow.h>
 
@@ -183,6 +184,11 @@ retention_execute(char* name __attribute__((unused)), struct art* nodes)
 
       pgmoneta_delete_wal(i);
 
+      if ((config->storage_engine & STORAGE_ENGINE_S3) && config->wal_bundle_size > 0)
+      {
+         pgmoneta_s3_wal_retention(i);
+      }
+
       for (int j = 0; j < number_of_backups; j++)
       {
          free(backups[j]);
@@ -30,6 +30,7 @@
 #include <pgmoneta.h>
 #include <logging.h>
 #include <security.h>
+#include <stream.h>
 #include <utils.h>
 #include <workflow.h>
 
@@ -40,7 +41,7 @@
 static char* sha256_name(void);
 static int sha256_execute(char*, struct art*);
 
-static int write_backup_sha256(char* root, char* relative_path);
+static int write_backup_sha256(char* root, char* relative_path, struct art* digests);
 
 static FILE* sha256_file = NULL;
 
@@ -74,6 +75,7 @@ sha256_execute(char* name __attribute__((unused)), struct art* nodes)
    char* root = NULL;
    char* d = NULL;
    char* sha256_path = NULL;
+   struct art* digests = NULL;
    struct main_configuration* config;
 
    config = (struct main_configuration*)shmem;
@@ -87,6 +89,7 @@ sha256_execute(char* name __attribute__((unused)), struct art* nodes)
 
    server = (int)pgmoneta_art_search(nodes, NODE_SERVER_ID);
    label = (char*)pgmoneta_art_search(nodes, NODE_LABEL);
+   digests = (struct art*)pgmoneta_art_search(nodes, NODE_DIGESTS);
 
    pgmoneta_log_debug("SHA256 (execute): %s/%s", config->common.servers[server].name, label);
 
@@ -107,7 +110,7 @@ sha256_execute(char* name __attribute__((unused)), struct art* nodes)
 
    d = pgmoneta_get_server_backup_identifier_data(server, label);
 
-   if (write_backup_sha256(d, ""))
+   if (write_backup_sha256(d, "", digests))
    {
       goto error;
    }
@@ -139,13 +142,14 @@ error:
 }
 
 static int
-write_backup_sha256(char* root, char* relative_path)
+write_backup_sha256(char* root, char* relative_path, struct art* digests)
 {
    char* dir_path = NULL;
    char* relative_file_path;
    char* absolute_file_path;
    char* buffer;
    char* sha256;
+   struct stream_digests* known = NULL;
    DIR* dir;
    struct dirent* entry;
 
@@ -170,7 +174,7 @@ write_backup_sha256(char* root, char* relative_path)
 
          pgmoneta_snprintf(relative_dir, sizeof(relative_dir), "%s/%s", relative_path, entry->d_name);
 
-         write_backup_sha256(root, relative_dir);
+         write_backup_sha256(root, relative_dir, digests);
       }
       else
       {
@@ -187,7 +191,16 @@ write_backup_sha256(char* root, char* relative_path)
          absolute_file_path = pgmoneta_append(absolute_file_path, "/");
          absolute_file_path = pgmoneta_append(absolute_file_path, relative_file_path);
 
-         pgmoneta_create_sha256_file(absolute_file_path, &sha256);
+         /* Files written during receive were hashed on the way to disk */
+         known = pgmoneta_stream_digests_get(digests, absolute_file_path);
+         if (known != NULL)
+         {
+            sha256 = pgmoneta_append(sha256, known->sha256);
+         }
+         else
+         {
+            pgmoneta_create_sha256_file(absolute_file_path, &sha256);
+         }
 
          buffer = pgmoneta_append(buffer, relative_file_path);
          buffer = pgmoneta_append(buffer, ":");
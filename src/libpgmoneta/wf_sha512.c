@@ -31,6 +31,7 @@
 #include <logging.h>
 #include <progress.h>
 #include <security.h>
+#include <stream.h>
 #include <utils.h>
 #include <verify.h>
 #include <workflow.h>
@@ -46,7 +47,7 @@ static char* sha512_name(void);
 static int sha512_execute(char*, struct art*);
 
 static int write_backup_sha512(int server, char* root, char* relative_path,
-                               bool progress_enabled);
+                               struct art* digests, bool progress_enabled);
 
 static FILE* sha512_file = NULL;
 
@@ -84,6 +85,7 @@ sha512_execute(char* name __attribute__((unused)), struct art* nodes)
    char* sha512_path = NULL;
    char* server_backup = NULL;
    struct backup* backup = NULL;
+   struct art* digests = NULL;
    struct main_configuration* config;
 
    config = (struct main_configuration*)shmem;
@@ -106,6 +108,7 @@ sha512_execute(char* name __attribute__((unused)), struct art* nodes)
    label = (char*)pgmoneta_art_search(nodes, NODE_LABEL);
    backup = (struct backup*)pgmoneta_art_search(nodes, NODE_BACKUP);
    server_backup = (char*)pgmoneta_art_search(nodes, NODE_SERVER_BACKUP);
+   digests = (struct art*)pgmoneta_art_search(nodes, NODE_DIGESTS);
 
    pgmoneta_log_debug("SHA512 (execute): %s/%s", config->common.servers[server].name, label);
 
@@ -138,7 +141,7 @@ sha512_execute(char* name __attribute__((unused)), struct art* nodes)
       pgmoneta_progress_set_total(server, file_count);
    }
 
-   if (write_backup_sha512(server, root, "", progress_enabled))
+   if (write_backup_sha512(server, root, "", digests, progress_enabled))
    {
       goto error;
    }
@@ -189,13 +192,14 @@ error:
 
 static int
 write_backup_sha512(int server, char* root, char* relative_path,
-                    bool progress_enabled)
+                    struct art* digests, bool progress_enabled)
 {
    char* dir_path = NULL;
    char* relative_file_path;
    char* absolute_file_path;
    char* buffer;
    char* sha512;
+   struct stream_digests* known = NULL;
    DIR* dir;
    struct dirent* entry;
 
@@ -220,7 +224,7 @@ write_backup_sha512(int server, char* root, char* relative_path,
 
          pgmoneta_snprintf(relative_dir, sizeof(relative_dir), "%s/%s", relative_path, entry->d_name);
 
-         write_backup_sha512(server, root, relative_dir, progress_enabled);
+         write_backup_sha512(server, root, relative_dir, digests, progress_enabled);
       }
       else if (strcmp(entry->d_name, "backup.sha512"))
       {
@@ -237,7 +241,16 @@ write_backup_sha512(int server, char* root, char* relative_path,
          absolute_file_path = pgmoneta_append(absolute_file_path, "/");
          absolute_file_path = pgmoneta_append(absolute_file_path, relative_file_path);
 
-         pgmoneta_create_sha512_file(absolute_file_path, &sha512);
+         /* Files written during receive were hashed on the way to disk */
+         known = pgmoneta_stream_digests_get(digests, absolute_file_path);
+         if (known != NULL)
+         {
+            sha512 = pgmoneta_append(sha512, known->sha512);
+         }
+         else
+         {
+            pgmoneta_create_sha512_file(absolute_file_path, &sha512);
+         }
 
          buffer = pgmoneta_append(buffer, sha512);
          buffer = pgmoneta_append(buffer, " *.");
@@ -31,6 +31,7 @@
 #include <csv.h>
 #include <logging.h>
 #include <management.h>
+#include <manifest.h>
 #include <security.h>
 #include <utils.h>
 #include <value.h>
@@ -39,13 +40,65 @@
 /* system */
 #include <assert.h>
 #include <fcntl.h>
+#include <stdatomic.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <sys/stat.h>
+
+#define VERIFY_BATCH_FILES 32
+#define VERIFY_BATCH_SIZE  (8 * 1024 * 1024)
+
+/** @struct verify_batch
+ * Defines a group of small files verified by one worker
+ */
+struct verify_batch
+{
+   struct worker_common common;             /**< The common base */
+   struct json* files[VERIFY_BATCH_FILES]; /**< The files */
+   int count;                               /**< The number of files */
+   uint64_t size;                           /**< The total size of the files */
+   struct deque* failed;                    /**< Failed files */
+   struct deque* all;                       /**< All files */
+};
+
+/** @struct verify_tree
+ * Defines a large file whose tree digest is verified leaf by leaf
+ */
+struct verify_tree
+{
+   struct json* data;        /**< The file */
+   char path[MAX_PATH];      /**< The path of the file */
+   char expected[129];       /**< The expected tree digest */
+   uint64_t size;            /**< The size of the file */
+   size_t leaves;            /**< The number of leaves */
+   unsigned char* digests;   /**< The leaf digests */
+   atomic_size_t remaining;  /**< The number of leaves not yet hashed */
+   atomic_bool error;        /**< Did hashing a leaf fail */
+   struct deque* failed;     /**< Failed files */
+   struct deque* all;        /**< All files */
+};
+
+/** @struct verify_leaf
+ * Defines a leaf of a large file
+ */
+struct verify_leaf
+{
+   struct worker_common common; /**< The common base */
+   struct verify_tree* tree;    /**< The file */
+   size_t leaf;                 /**< The leaf index */
+};
 
 static char* verify_name(void);
 static int verify_execute(char*, struct art*);
 
+static int load_trees(char* path, struct art** trees);
+static int dispatch_tree(struct json* j, char* path, char* expected, uint64_t size,
+                         struct deque* failed, struct deque* all, struct workers* workers);
+static int dispatch_batch(struct verify_batch** batch, struct workers* workers);
+static void verify_file(struct json* j, bool verified, struct deque* failed, struct deque* all);
 static void do_verify(struct worker_common* wc);
+static void do_verify_batch(struct worker_common* wc);
+static void do_verify_leaf(struct worker_common* wc);
 
 struct workflow*
 pgmoneta_create_verify(void)
@@ -88,6 +141,10 @@ verify_execute(char* name __attribute__((unused)), struct art* nodes)
    struct deque* all_deque = NULL;
    struct csv_reader* csv = NULL;
    struct workers* workers = NULL;
+   struct art* trees = NULL;
+   struct verify_batch* batch = NULL;
+   char* tree_file = NULL;
+   char* target_base = NULL;
    struct main_configuration* config;
 
    config = (struct main_configuration*)shmem;
@@ -116,6 +173,17 @@ verify_execute(char* name __attribute__((unused)), struct art* nodes)
    manifest_file = pgmoneta_append(manifest_file, "/");
    manifest_file = pgmoneta_append(manifest_file, "backup.manifest");
 
+   tree_file = pgmoneta_append(tree_file, base);
+   if (!pgmoneta_ends_with(tree_file, "/"))
+   {
+      tree_file = pgmoneta_append(tree_file, "/");
+   }
+   tree_file = pgmoneta_append(tree_file, label);
+   tree_file = pgmoneta_append(tree_file, "/");
+   tree_file = pgmoneta_append(tree_file, "backup.tree");
+
+   target_base = (char*)pgmoneta_art_search(nodes, NODE_TARGET_BASE);
+
    if (pgmoneta_deque_create(true, &failed_deque))
    {
       goto error;
@@ -136,6 +204,15 @@ verify_execute(char* name __attribute__((unused)), struct art* nodes)
       pgmoneta_workers_initialize(number_of_workers, &workers);
    }
 
+   /* Large files with a tree digest can be split across the workers */
+   if (workers != NULL && pgmoneta_exists(tree_file))
+   {
+      if (load_trees(tree_file, &trees))
+      {
+         pgmoneta_log_warn("Verify: Could not read %s", tree_file);
+      }
+   }
+
    if (pgmoneta_is_binary_file(manifest_file))
    {
       pgmoneta_log_error("Verify: Manifest file is not a text file");
@@ -153,6 +230,9 @@ verify_execute(char* name __attribute__((unused)), struct art* nodes)
    {
       struct worker_input* payload = NULL;
       struct json* j = NULL;
+      char* tree = NULL;
+      char f[MAX_PATH];
+      struct stat st;
 
       line_number++;
 
@@ -171,41 +251,89 @@ verify_execute(char* name __attribute__((unused)), struct art* nodes)
          goto error;
       }
 
-      if (pgmoneta_create_worker_input(NULL, NULL, NULL, -1, workers, &payload))
-      {
-         goto error;
-      }
-
       if (pgmoneta_json_create(&j))
       {
          goto error;
       }
 
-      pgmoneta_json_put(j, MANAGEMENT_ARGUMENT_DIRECTORY, (uintptr_t)pgmoneta_art_search(nodes, NODE_TARGET_BASE), ValueString);
+      pgmoneta_json_put(j, MANAGEMENT_ARGUMENT_DIRECTORY, (uintptr_t)target_base, ValueString);
       pgmoneta_json_put(j, MANAGEMENT_ARGUMENT_FILENAME, (uintptr_t)columns[0], ValueString);
       pgmoneta_json_put(j, MANAGEMENT_ARGUMENT_ORIGINAL, (uintptr_t)columns[1], ValueString);
       pgmoneta_json_put(j, MANAGEMENT_ARGUMENT_HASH_ALGORITHM, (uintptr_t)"SHA512", ValueString);
 
-      payload->data = j;
-      payload->failed = failed_deque;
-      payload->all = all_deque;
-
       if (number_of_workers > 0)
       {
-         if (workers->outcome)
+         if (!workers->outcome)
+         {
+            pgmoneta_json_destroy(j);
+         }
+         else
          {
-            pgmoneta_workers_add(workers, do_verify, (struct worker_common*)payload);
+            pgmoneta_snprintf(f, sizeof(f), "%s%s%s", target_base,
+                              pgmoneta_ends_with(target_base, "/") ? "" : "/", columns[0]);
+
+            memset(&st, 0, sizeof(struct stat));
+            stat(f, &st);
+
+            tree = (char*)pgmoneta_art_search(trees, columns[0]);
+
+            if (tree != NULL && (uint64_t)st.st_size > TREE_HASH_LEAF_SIZE)
+            {
+               if (dispatch_tree(j, f, tree, (uint64_t)st.st_size, failed_deque, all_deque, workers))
+               {
+                  goto error;
+               }
+            }
+            else if ((uint64_t)st.st_size < VERIFY_BATCH_SIZE)
+            {
+               /* Small files are verified in groups to amortize the dispatch */
+               if (batch == NULL)
+               {
+                  batch = (struct verify_batch*)calloc(1, sizeof(struct verify_batch));
+                  if (batch == NULL)
+                  {
+                     pgmoneta_json_destroy(j);
+                     goto error;
+                  }
+                  batch->failed = failed_deque;
+                  batch->all = all_deque;
+               }
+
+               batch->files[batch->count++] = j;
+               batch->size += (uint64_t)st.st_size;
+
+               if (batch->count == VERIFY_BATCH_FILES || batch->size >= VERIFY_BATCH_SIZE)
+               {
+                  dispatch_batch(&batch, workers);
+               }
+            }
+            else
+            {
+               if (pgmoneta_create_worker_input(NULL, NULL, NULL, -1, workers, &payload))
+               {
+                  pgmoneta_json_destroy(j);
+                  goto error;
+               }
+
+               payload->data = j;
+               payload->failed = failed_deque;
+               payload->all = all_deque;
+
+               pgmoneta_workers_add(workers, do_verify, (struct worker_common*)payload);
+            }
          }
       }
       else
       {
-         do_verify((struct worker_common*)payload);
+         verify_file(j, false, failed_deque, all_deque);
       }
 
       free(columns);
       columns = NULL;
    }
 
+   dispatch_batch(&batch, workers);
+
    pgmoneta_workers_wait(workers);
    if (workers != NULL && !workers->outcome)
    {
@@ -220,7 +348,9 @@ verify_execute(char* name __attribute__((unused)), struct art* nodes)
    pgmoneta_art_insert(nodes, NODE_ALL, (uintptr_t)all_deque, ValueDeque);
 
    pgmoneta_csv_reader_destroy(csv);
+   pgmoneta_art_destroy(trees);
 
+   free(tree_file);
    free(base);
    free(manifest_file);
 
@@ -230,6 +360,8 @@ error:
 
    if (number_of_workers > 0)
    {
+      dispatch_batch(&batch, workers);
+      pgmoneta_workers_wait(workers);
       pgmoneta_workers_destroy(workers);
    }
 
@@ -240,24 +372,165 @@ error:
    pgmoneta_deque_destroy(all_deque);
 
    pgmoneta_csv_reader_destroy(csv);
+   pgmoneta_art_destroy(trees);
 
    free(columns);
+   free(tree_file);
    free(base);
    free(manifest_file);
 
    return 1;
 }
 
+static int
+load_trees(char* path, struct art** trees)
+{
+   struct csv_reader* csv = NULL;
+   struct art* t = NULL;
+   int number_of_columns = 0;
+   char** columns = NULL;
+
+   *trees = NULL;
+
+   if (pgmoneta_art_create(&t))
+   {
+      goto error;
+   }
+
+   if (pgmoneta_csv_reader_init(path, &csv))
+   {
+      goto error;
+   }
+
+   while (pgmoneta_csv_next_row(csv, &number_of_columns, &columns))
+   {
+      if (number_of_columns == MANIFEST_COLUMN_COUNT && columns[0] != NULL && columns[1] != NULL)
+      {
+         pgmoneta_art_insert(t, columns[0], (uintptr_t)columns[1], ValueString);
+      }
+
+      free(columns);
+      columns = NULL;
+   }
+
+   pgmoneta_csv_reader_destroy(csv);
+
+   *trees = t;
+
+   return 0;
+
+error:
+
+   pgmoneta_csv_reader_destroy(csv);
+   pgmoneta_art_destroy(t);
+
+   return 1;
+}
+
+static int
+dispatch_tree(struct json* j, char* path, char* expected, uint64_t size,
+              struct deque* failed, struct deque* all, struct workers* workers)
+{
+   struct verify_tree* tree = NULL;
+   struct verify_leaf* leaf = NULL;
+   size_t leaves = (size_t)((size + TREE_HASH_LEAF_SIZE - 1) / TREE_HASH_LEAF_SIZE);
+
+   tree = (struct verify_tree*)calloc(1, sizeof(struct verify_tree));
+   if (tree == NULL)
+   {
+      goto error;
+   }
+
+   tree->digests = (unsigned char*)malloc(leaves * TREE_HASH_DIGEST_SIZE);
+   if (tree->digests == NULL)
+   {
+      goto error;
+   }
+
+   tree->data = j;
+   pgmoneta_snprintf(tree->path, sizeof(tree->path), "%s", path);
+   pgmoneta_snprintf(tree->expected, sizeof(tree->expected), "%s", expected);
+   tree->size = size;
+   tree->leaves = leaves;
+   tree->failed = failed;
+   tree->all = all;
+   atomic_init(&tree->remaining, leaves);
+   atomic_init(&tree->error, false);
+
+   /* The leaf finishing last reports the file, so all leaves must be queued */
+   for (size_t i = 0; i < leaves; i++)
+   {
+      leaf = (struct verify_leaf*)calloc(1, sizeof(struct verify_leaf));
+      if (leaf == NULL)
+      {
+         pgmoneta_log_error("Verify: Out of memory for %s", path);
+         atomic_store(&tree->error, true);
+         if (atomic_fetch_sub(&tree->remaining, leaves - i) == leaves - i)
+         {
+            /* Every queued leaf is done already */
+            pgmoneta_json_destroy(tree->data);
+            free(tree->digests);
+            free(tree);
+         }
+         return 1;
+      }
+
+      leaf->common.workers = workers;
+      leaf->tree = tree;
+      leaf->leaf = i;
+
+      pgmoneta_workers_add(workers, do_verify_leaf, (struct worker_common*)leaf);
+   }
+
+   return 0;
+
+error:
+
+   pgmoneta_json_destroy(j);
+   if (tree != NULL)
+   {
+      free(tree->digests);
+      free(tree);
+   }
+
+   return 1;
+}
+
+static int
+dispatch_batch(struct verify_batch** batch, struct workers* workers)
+{
+   struct verify_batch* b = *batch;
+
+   *batch = NULL;
+
+   if (b == NULL)
+   {
+      return 0;
+   }
+
+   b->common.workers = workers;
+
+   if (workers == NULL || !workers->outcome)
+   {
+      for (int i = 0; i < b->count; i++)
+      {
+         pgmoneta_json_destroy(b->files[i]);
+      }
+      free(b);
+      return 1;
+   }
+
+   pgmoneta_workers_add(workers, do_verify_batch, (struct worker_common*)b);
+
+   return 0;
+}
+
 static void
-do_verify(struct worker_common* wc)
+verify_file(struct json* j, bool verified, struct deque* failed_deque, struct deque* all)
 {
-   struct worker_input* wi = (struct worker_input*)wc;
    char* f = NULL;
    char* hash_cal = NULL;
    bool failed = false;
-   struct json* j = NULL;
-
-   j = wi->data;
 
    f = pgmoneta_append(f, (char*)pgmoneta_json_get(j, MANAGEMENT_ARGUMENT_DIRECTORY));
    if (!pgmoneta_ends_with(f, "/"))
@@ -271,16 +544,22 @@ do_verify(struct worker_common* wc)
       goto error;
    }
 
-   if (!pgmoneta_create_sha512_file(f, &hash_cal))
+   /* A matching tree digest already proves the content */
+   if (!verified)
    {
-      if (strcmp(hash_cal, (char*)pgmoneta_json_get(j, MANAGEMENT_ARGUMENT_ORIGINAL)))
+      pgmoneta_throttle(THROTTLE_VERIFY, pgmoneta_get_file_size(f));
+
+      if (!pgmoneta_create_sha512_file(f, &hash_cal))
       {
-         failed = true;
+         if (strcmp(hash_cal, (char*)pgmoneta_json_get(j, MANAGEMENT_ARGUMENT_ORIGINAL)))
+         {
+            failed = true;
+         }
+      }
+      else
+      {
+         goto error;
       }
-   }
-   else
-   {
-      goto error;
    }
 
    if (failed)
@@ -295,37 +574,92 @@ do_verify(struct worker_common* wc)
          pgmoneta_json_put(j, MANAGEMENT_ARGUMENT_CALCULATED, (uintptr_t)"Unknown", ValueString);
       }
 
-      pgmoneta_deque_add(wi->failed, f, (uintptr_t)j, ValueJSON);
+      pgmoneta_deque_add(failed_deque, f, (uintptr_t)j, ValueJSON);
    }
-   else if (wi->all != NULL)
+   else if (all != NULL)
    {
-      pgmoneta_deque_add(wi->all, f, (uintptr_t)j, ValueJSON);
+      pgmoneta_deque_add(all, f, (uintptr_t)j, ValueJSON);
    }
    else
    {
       pgmoneta_json_destroy(j);
    }
 
-   wi->data = NULL;
-   wi->failed = NULL;
-   wi->all = NULL;
-
    free(hash_cal);
    free(f);
-   free(wi);
 
    return;
 
 error:
    pgmoneta_log_error("Unable to calculate hash for %s", f);
 
-   pgmoneta_json_destroy(wi->data);
+   pgmoneta_json_destroy(j);
+
+   free(hash_cal);
+   free(f);
+}
+
+static void
+do_verify(struct worker_common* wc)
+{
+   struct worker_input* wi = (struct worker_input*)wc;
+
+   verify_file(wi->data, false, wi->failed, wi->all);
 
    wi->data = NULL;
    wi->failed = NULL;
    wi->all = NULL;
 
-   free(hash_cal);
-   free(f);
    free(wi);
 }
+
+static void
+do_verify_batch(struct worker_common* wc)
+{
+   struct verify_batch* b = (struct verify_batch*)wc;
+
+   for (int i = 0; i < b->count; i++)
+   {
+      verify_file(b->files[i], false, b->failed, b->all);
+      b->files[i] = NULL;
+   }
+
+   free(b);
+}
+
+static void
+do_verify_leaf(struct worker_common* wc)
+{
+   struct verify_leaf* l = (struct verify_leaf*)wc;
+   struct verify_tree* t = l->tree;
+   char* root = NULL;
+   bool verified = false;
+
+   if (!atomic_load(&t->error))
+   {
+      if (pgmoneta_create_sha512_leaf(t->path, l->leaf, t->digests + l->leaf * TREE_HASH_DIGEST_SIZE))
+      {
+         atomic_store(&t->error, true);
+      }
+   }
+
+   free(l);
+
+   if (atomic_fetch_sub(&t->remaining, 1) != 1)
+   {
+      return;
+   }
+
+   if (!atomic_load(&t->error) &&
+       !pgmoneta_create_sha512_tree_root(t->digests, t->leaves, t->size, &root))
+   {
+      verified = !strcmp(root, t->expected);
+   }
+
+   /* On a mismatch the SHA-512 is calculated to report the actual value */
+   verify_file(t->data, verified, t->failed, t->all);
+
+   free(root);
+   free(t->digests);
+   free(t);
+}
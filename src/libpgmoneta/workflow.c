@@ -35,6 +35,7 @@
 #include <info.h>
 #include <logging.h>
 #include <management.h>
+#include <memory.h>
 #include <progress.h>
 #include <storage.h>
 #include <utils.h>
@@ -65,6 +66,7 @@ static struct workflow* wf_delete_s3_objects(void);
 static struct workflow* wf_restore_s3_objects(void);
 
 static int get_error_code(int type, int flow, struct art* nodes);
+static void region_destroy_cb(uintptr_t data);
 
 struct workflow*
 pgmoneta_workflow_create(int workflow_type, struct backup* backup)
@@ -139,12 +141,19 @@ pgmoneta_workflow_nodes(int server, char* identifier, struct art* nodes, struct
    char* backup_base = NULL;
    char* backup_data = NULL;
    struct backup* bck = NULL;
+   struct region* region = NULL;
    struct main_configuration* config;
 
    config = (struct main_configuration*)shmem;
 
    *backup = NULL;
 
+   region = pgmoneta_workflow_region(nodes);
+   if (region == NULL)
+   {
+      goto error;
+   }
+
    if (!pgmoneta_art_contains_key(nodes, USER_SERVER))
    {
       if (pgmoneta_art_insert(nodes, USER_SERVER, (uintptr_t)config->common.servers[server].name, ValueString))
@@ -171,40 +180,26 @@ pgmoneta_workflow_nodes(int server, char* identifier, struct art* nodes, struct
 
    if (!pgmoneta_art_contains_key(nodes, NODE_SERVER_BASE))
    {
-      server_base = pgmoneta_append(server_base, config->base_dir);
-      if (!pgmoneta_ends_with(server_base, "/"))
-      {
-         server_base = pgmoneta_append(server_base, "/");
-      }
-      server_base = pgmoneta_append(server_base, config->common.servers[server].name);
-      if (!pgmoneta_ends_with(server_base, "/"))
-      {
-         server_base = pgmoneta_append(server_base, "/");
-      }
+      server_base = pgmoneta_memory_region_format(region, "%s%s%s%s",
+                                                  config->base_dir,
+                                                  pgmoneta_ends_with(config->base_dir, "/") ? "" : "/",
+                                                  config->common.servers[server].name,
+                                                  pgmoneta_ends_with(config->common.servers[server].name, "/") ? "" : "/");
 
-      if (pgmoneta_art_insert(nodes, NODE_SERVER_BASE, (uintptr_t)server_base, ValueString))
+      if (server_base == NULL || pgmoneta_art_insert(nodes, NODE_SERVER_BASE, (uintptr_t)server_base, ValueStringRef))
       {
-         free(server_base);
          goto error;
       }
-
-      free(server_base);
-      server_base = NULL;
    }
 
    if (!pgmoneta_art_contains_key(nodes, NODE_SERVER_BACKUP))
    {
-      server_backup = pgmoneta_append(server_backup, (char*)pgmoneta_art_search(nodes, NODE_SERVER_BASE));
-      server_backup = pgmoneta_append(server_backup, "backup/");
+      server_backup = pgmoneta_memory_region_append(region, (char*)pgmoneta_art_search(nodes, NODE_SERVER_BASE), "backup/");
 
-      if (pgmoneta_art_insert(nodes, NODE_SERVER_BACKUP, (uintptr_t)server_backup, ValueString))
+      if (server_backup == NULL || pgmoneta_art_insert(nodes, NODE_SERVER_BACKUP, (uintptr_t)server_backup, ValueStringRef))
       {
-         free(server_backup);
          goto error;
       }
-
-      free(server_backup);
-      server_backup = NULL;
    }
 
    if (identifier != NULL)
@@ -247,36 +242,31 @@ pgmoneta_workflow_nodes(int server, char* identifier, struct art* nodes, struct
          }
       }
 
-      backup_base = NULL;
-      backup_base = pgmoneta_append(backup_base, (char*)pgmoneta_art_search(nodes, NODE_SERVER_BACKUP));
-      if (strlen(bck->label) > 0)
+      backup_base = pgmoneta_memory_region_append(region, (char*)pgmoneta_art_search(nodes, NODE_SERVER_BACKUP),
+                                                  strlen(bck->label) > 0 ? bck->label : identifier);
+      if (backup_base != NULL && !pgmoneta_ends_with(backup_base, "/"))
       {
-         backup_base = pgmoneta_append(backup_base, bck->label);
+         backup_base = pgmoneta_memory_region_append(region, backup_base, "/");
       }
-      else
+      if (backup_base == NULL)
       {
-         backup_base = pgmoneta_append(backup_base, identifier);
-      }
-      if (!pgmoneta_ends_with(backup_base, "/"))
-      {
-         backup_base = pgmoneta_append(backup_base, "/");
+         goto error;
       }
 
       if (!pgmoneta_art_contains_key(nodes, NODE_BACKUP_BASE))
       {
-         if (pgmoneta_art_insert(nodes, NODE_BACKUP_BASE, (uintptr_t)backup_base, ValueString))
+         if (pgmoneta_art_insert(nodes, NODE_BACKUP_BASE, (uintptr_t)backup_base, ValueStringRef))
          {
             pgmoneta_log_error("pgmoneta_workflow_nodes: Unable to insert backup base for %s", identifier);
             goto error;
          }
       }
 
-      backup_data = pgmoneta_append(backup_data, backup_base);
-      backup_data = pgmoneta_append(backup_data, "data/");
+      backup_data = pgmoneta_memory_region_append(region, backup_base, "data/");
 
       if (!pgmoneta_art_contains_key(nodes, NODE_BACKUP_DATA))
       {
-         if (pgmoneta_art_insert(nodes, NODE_BACKUP_DATA, (uintptr_t)backup_data, ValueString))
+         if (backup_data == NULL || pgmoneta_art_insert(nodes, NODE_BACKUP_DATA, (uintptr_t)backup_data, ValueStringRef))
          {
             pgmoneta_log_error("pgmoneta_workflow_nodes: Unable to insert backup data for %s", identifier);
             goto error;
@@ -284,12 +274,7 @@ pgmoneta_workflow_nodes(int server, char* identifier, struct art* nodes, struct
       }
 
       free(backup_dir);
-      free(backup_base);
-      free(backup_data);
-
       backup_dir = NULL;
-      backup_base = NULL;
-      backup_data = NULL;
    }
    else
    {
@@ -302,12 +287,44 @@ pgmoneta_workflow_nodes(int server, char* identifier, struct art* nodes, struct
 error:
 
    free(backup_dir);
-   free(backup_base);
-   free(backup_data);
    free(bck);
    return 1;
 }
 
+struct region*
+pgmoneta_workflow_region(struct art* nodes)
+{
+   struct region* region = NULL;
+   struct value_config vc = {.destroy_data = region_destroy_cb,
+                             .to_string = NULL};
+
+   if (nodes == NULL)
+   {
+      return NULL;
+   }
+
+   region = (struct region*)pgmoneta_art_search(nodes, NODE_REGION);
+   if (region != NULL)
+   {
+      return region;
+   }
+
+   if (pgmoneta_memory_region_create(0, &region))
+   {
+      pgmoneta_log_error("Unable to create the workflow region");
+      return NULL;
+   }
+
+   if (pgmoneta_art_insert_with_config(nodes, NODE_REGION, (uintptr_t)region, &vc))
+   {
+      pgmoneta_log_error("Unable to insert the workflow region");
+      pgmoneta_memory_region_destroy(region);
+      return NULL;
+   }
+
+   return region;
+}
+
 int
 pgmoneta_workflow_execute(struct workflow* workflow, struct art* nodes,
                           char** error_name, int* error_code)
@@ -399,6 +416,8 @@ pgmoneta_workflow_execute(struct workflow* workflow, struct art* nodes,
       current = current->next;
    }
 
+   pgmoneta_memory_region_statistics((struct region*)pgmoneta_art_search(nodes, NODE_REGION), "workflow");
+
    return 0;
 
 error:
@@ -610,6 +629,12 @@ wf_backup(void)
    current->next = pgmoneta_create_sha512();
    current = current->next;
 
+   if (config->chunk_store)
+   {
+      current->next = pgmoneta_create_chunk();
+      current = current->next;
+   }
+
 #ifdef DEBUG
    current = head;
    while (current != NULL)
@@ -747,30 +772,39 @@ wf_post_rollup(struct backup* backup)
    current->next = pgmoneta_storage_create_local();
    current = current->next;
 
-   switch (COMPRESSION_ALGORITHM(backup->compression))
+   if (COMPRESSION_ALGORITHM(backup->compression) != COMPRESSION_ALG_NONE && backup->encryption != ENCRYPTION_NONE)
    {
-      case COMPRESSION_ALG_GZIP:
-         current->next = pgmoneta_create_gzip(true);
-         current = current->next;
-         break;
-      case COMPRESSION_ALG_ZSTD:
-         current->next = pgmoneta_create_zstd(true);
-         current = current->next;
-         break;
-      case COMPRESSION_ALG_LZ4:
-         current->next = pgmoneta_create_lz4(true);
-         current = current->next;
-         break;
-      case COMPRESSION_ALG_BZIP2:
-         current->next = pgmoneta_create_bzip2(true);
-         current = current->next;
-         break;
+      /* Compress and encrypt each file in a single pass */
+      current->next = pgmoneta_create_compression_encryption();
+      current = current->next;
    }
-
-   if (backup->encryption != ENCRYPTION_NONE)
+   else
    {
-      current->next = pgmoneta_encryption(true);
-      current = current->next;
+      switch (COMPRESSION_ALGORITHM(backup->compression))
+      {
+         case COMPRESSION_ALG_GZIP:
+            current->next = pgmoneta_create_gzip(true);
+            current = current->next;
+            break;
+         case COMPRESSION_ALG_ZSTD:
+            current->next = pgmoneta_create_zstd(true);
+            current = current->next;
+            break;
+         case COMPRESSION_ALG_LZ4:
+            current->next = pgmoneta_create_lz4(true);
+            current = current->next;
+            break;
+         case COMPRESSION_ALG_BZIP2:
+            current->next = pgmoneta_create_bzip2(true);
+            current = current->next;
+            break;
+      }
+
+      if (backup->encryption != ENCRYPTION_NONE)
+      {
+         current->next = pgmoneta_encryption(true);
+         current = current->next;
+      }
    }
 
 #ifdef DEBUG
@@ -849,30 +883,39 @@ wf_incremental_backup(void)
    current->next = pgmoneta_create_hot_standby();
    current = current->next;
 
-   switch (COMPRESSION_ALGORITHM(config->compression_type))
+   if (COMPRESSION_ALGORITHM(config->compression_type) != COMPRESSION_ALG_NONE && config->common.encryption != ENCRYPTION_NONE)
    {
-      case COMPRESSION_ALG_GZIP:
-         current->next = pgmoneta_create_gzip(true);
-         current = current->next;
-         break;
-      case COMPRESSION_ALG_ZSTD:
-         current->next = pgmoneta_create_zstd(true);
-         current = current->next;
-         break;
-      case COMPRESSION_ALG_LZ4:
-         current->next = pgmoneta_create_lz4(true);
-         current = current->next;
-         break;
-      case COMPRESSION_ALG_BZIP2:
-         current->next = pgmoneta_create_bzip2(true);
-         current = current->next;
-         break;
+      /* Compress and encrypt each file in a single pass */
+      current->next = pgmoneta_create_compression_encryption();
+      current = current->next;
    }
-
-   if (config->common.encryption != ENCRYPTION_NONE)
+   else
    {
-      current->next = pgmoneta_encryption(true);
-      current = current->next;
+      switch (COMPRESSION_ALGORITHM(config->compression_type))
+      {
+         case COMPRESSION_ALG_GZIP:
+            current->next = pgmoneta_create_gzip(true);
+            current = current->next;
+            break;
+         case COMPRESSION_ALG_ZSTD:
+            current->next = pgmoneta_create_zstd(true);
+            current = current->next;
+            break;
+         case COMPRESSION_ALG_LZ4:
+            current->next = pgmoneta_create_lz4(true);
+            current = current->next;
+            break;
+         case COMPRESSION_ALG_BZIP2:
+            current->next = pgmoneta_create_bzip2(true);
+            current = current->next;
+            break;
+      }
+
+      if (config->common.encryption != ENCRYPTION_NONE)
+      {
+         current->next = pgmoneta_encryption(true);
+         current = current->next;
+      }
    }
 
    current->next = pgmoneta_create_link();
@@ -988,30 +1031,39 @@ wf_archive(struct backup* backup)
    head = pgmoneta_create_archive();
    current = head;
 
-   switch (COMPRESSION_ALGORITHM(backup->compression))
+   if (COMPRESSION_ALGORITHM(backup->compression) != COMPRESSION_ALG_NONE && backup->encryption != ENCRYPTION_NONE)
    {
-      case COMPRESSION_ALG_GZIP:
-         current->next = pgmoneta_create_gzip(true);
-         current = current->next;
-         break;
-      case COMPRESSION_ALG_ZSTD:
-         current->next = pgmoneta_create_zstd(true);
-         current = current->next;
-         break;
-      case COMPRESSION_ALG_LZ4:
-         current->next = pgmoneta_create_lz4(true);
-         current = current->next;
-         break;
-      case COMPRESSION_ALG_BZIP2:
-         current->next = pgmoneta_create_bzip2(true);
-         current = current->next;
-         break;
+      /* Compress and encrypt each file in a single pass */
+      current->next = pgmoneta_create_compression_encryption();
+      current = current->next;
    }
-
-   if (backup->encryption != ENCRYPTION_NONE)
+   else
    {
-      current->next = pgmoneta_encryption(true);
-      current = current->next;
+      switch (COMPRESSION_ALGORITHM(backup->compression))
+      {
+         case COMPRESSION_ALG_GZIP:
+            current->next = pgmoneta_create_gzip(true);
+            current = current->next;
+            break;
+         case COMPRESSION_ALG_ZSTD:
+            current->next = pgmoneta_create_zstd(true);
+            current = current->next;
+            break;
+         case COMPRESSION_ALG_LZ4:
+            current->next = pgmoneta_create_lz4(true);
+            current = current->next;
+            break;
+         case COMPRESSION_ALG_BZIP2:
+            current->next = pgmoneta_create_bzip2(true);
+            current = current->next;
+            break;
+      }
+
+      if (backup->encryption != ENCRYPTION_NONE)
+      {
+         current->next = pgmoneta_encryption(true);
+         current = current->next;
+      }
    }
 
    current->next = pgmoneta_create_permissions(PERMISSION_TYPE_ARCHIVE);
@@ -1385,3 +1437,9 @@ get_error_code(int type, int flow, struct art* nodes)
       return -1;
    }
 }
+
+static void
+region_destroy_cb(uintptr_t data)
+{
+   pgmoneta_memory_region_destroy((struct region*)data);
+}
@@ -55,6 +55,7 @@
 #include <shmem.h>
 #include <status.h>
 #include <stddef.h>
+#include <usage.h>
 #include <utils.h>
 #include <verify.h>
 #include <wal.h>
@@ -100,6 +101,7 @@ static void retention_cb(struct ev_loop* loop, ev_periodic* w, int revents);
 static void verification_cb(struct ev_loop* loop, ev_periodic* w, int revents);
 static void valid_cb(struct ev_loop* loop, ev_periodic* w, int revents);
 static void wal_streaming_cb(struct ev_loop* loop, ev_periodic* w, int revents);
+static void usage_cb(struct ev_loop* loop, ev_periodic* w, int revents);
 static bool accept_fatal(int error);
 static void reload_configuration(bool* restart);
 static void service_reload_cb(struct ev_loop* loop, ev_signal* w, int revents);
@@ -292,6 +294,7 @@ main(int argc, char** argv)
    struct ev_periodic valid;
    struct ev_periodic wal_streaming;
    struct ev_periodic verification;
+   struct ev_periodic reconcile;
    size_t shmem_size;
    size_t prometheus_cache_shmem_size = 0;
    struct main_configuration* config = NULL;
@@ -904,6 +907,14 @@ main(int argc, char** argv)
    ev_periodic_init(&verification, verification_cb, 0., pgmoneta_time_convert(config->verification, FORMAT_TIME_S), 0);
    ev_periodic_start(main_loop, &verification);
 
+   /* Start disk usage reconciler for the metrics */
+   if (config->metrics > 0)
+   {
+      ev_periodic_init(&reconcile, usage_cb, 0., USAGE_RECONCILE_INTERVAL, 0);
+      ev_periodic_start(main_loop, &reconcile);
+      usage_cb(main_loop, &reconcile, 0);
+   }
+
    pgmoneta_log_info("Started on %s", config->host);
    pgmoneta_log_debug("Management: %d", unix_management_socket);
    for (int i = 0; i < metrics_fds_length; i++)
@@ -2235,7 +2246,7 @@ accept_metrics_cb(struct ev_loop* loop, struct ev_io* watcher, int revents)
       shutdown_ports(false);
       if (strlen(config->metrics_cert_file) > 0 && strlen(config->metrics_key_file) > 0)
       {
-         if (pgmoneta_create_ssl_ctx(false, &ctx))
+         if (pgmoneta_create_ssl_ctx(false, TLS_KTLS_OFF, &ctx))
          {
             pgmoneta_log_error("Could not create metrics SSL context");
             goto child_error;
@@ -2417,9 +2428,24 @@ accept_management_cb(struct ev_loop* loop, struct ev_io* watcher, int revents)
 static void
 sigchld_cb(struct ev_loop* loop __attribute__((unused)), ev_signal* w __attribute__((unused)), int revents __attribute__((unused)))
 {
-   while (waitpid(-1, NULL, WNOHANG) > 0)
+   pid_t pid;
+   int expected;
+   struct main_configuration* config;
+
+   config = (struct main_configuration*)shmem;
+
+   while ((pid = waitpid(-1, NULL, WNOHANG)) > 0)
    {
-      ;
+      /* A WAL bundler that died keeps its lock, so release it */
+      for (int i = 0; i < config->common.number_of_servers; i++)
+      {
+         expected = (int)pid;
+         if (atomic_compare_exchange_strong(&config->common.servers[i].wal_bundle, &expected, 0))
+         {
+            pgmoneta_log_warn("WAL bundle: Process %d for server %s ended without releasing its lock",
+                              (int)pid, config->common.servers[i].name);
+         }
+      }
    }
 }
 
@@ -2624,6 +2650,23 @@ verification_cb(struct ev_loop* loop __attribute__((unused)), ev_periodic* w __a
    }
 }
 
+static void
+usage_cb(struct ev_loop* loop __attribute__((unused)), ev_periodic* w __attribute__((unused)), int revents)
+{
+   if (EV_ERROR & revents)
+   {
+      pgmoneta_log_trace("usage_cb: got invalid event: %s", strerror(errno));
+      errno = 0;
+      return;
+   }
+
+   if (!fork())
+   {
+      shutdown_ports(false);
+      pgmoneta_usage(argv_ptr);
+   }
+}
+
 static void
 valid_cb(struct ev_loop* loop __attribute__((unused)), ev_periodic* w __attribute__((unused)), int revents)
 {
@@ -2782,6 +2825,29 @@ wal_streaming_cb(struct ev_loop* loop __attribute__((unused)), ev_periodic* w __
          }
       }
    }
+
+   if ((config->storage_engine & STORAGE_ENGINE_S3) && config->wal_bundle_size > 0)
+   {
+      for (int i = 0; keep_running && i < config->common.number_of_servers; i++)
+      {
+         if (atomic_load(&config->common.servers[i].wal_bundle) == 0)
+         {
+            pid_t pid;
+
+            pid = fork();
+            if (pid == -1)
+            {
+               /* No process */
+               pgmoneta_log_error("WAL bundle - Cannot create process");
+            }
+            else if (pid == 0)
+            {
+               shutdown_ports(false);
+               pgmoneta_wal_bundle(i, argv_ptr);
+            }
+         }
+      }
+   }
 }
 
 static bool
@@ -624,3 +624,109 @@ MCTF_TEST(test_aes_is_encrypted)
 cleanup:
    MCTF_FINISH();
 }
+
+/**
+ * Test: Multi-chunk file round-trip, random access and corruption detection.
+ */
+MCTF_TEST(test_aes_file_chunked)
+{
+   struct test_encryption_env env;
+   char from[MAX_PATH] = {0};
+   char encrypted[MAX_PATH] = {0};
+   char decrypted[MAX_PATH] = {0};
+   size_t plaintext_size = 3 * AES_CHUNK_SIZE + 123;
+   unsigned char* plaintext = NULL;
+   unsigned char* range = NULL;
+   size_t range_size = 0;
+   unsigned char* content = NULL;
+   FILE* f = NULL;
+   int c;
+
+   MCTF_ASSERT(pgmoneta_test_setup_encryption_env(&env) == 0, cleanup, "Failed to setup mock environment");
+
+   pgmoneta_snprintf(from, MAX_PATH, "%s/chunked.bin", env.test_home);
+   pgmoneta_snprintf(encrypted, MAX_PATH, "%s/chunked.bin.aes", env.test_home);
+   pgmoneta_snprintf(decrypted, MAX_PATH, "%s/chunked.out", env.test_home);
+
+   plaintext = malloc(plaintext_size);
+   content = malloc(plaintext_size + 1);
+   MCTF_ASSERT_PTR_NONNULL(plaintext, cleanup, "Failed to allocate plaintext");
+   MCTF_ASSERT_PTR_NONNULL(content, cleanup, "Failed to allocate content");
+   for (size_t i = 0; i < plaintext_size; i++)
+   {
+      plaintext[i] = (unsigned char)(i * 31 + (i >> 12));
+   }
+
+   f = fopen(from, "wb");
+   MCTF_ASSERT_PTR_NONNULL(f, cleanup, "Failed to create test file");
+   MCTF_ASSERT(fwrite(plaintext, 1, plaintext_size, f) == plaintext_size, cleanup, "Failed to write test file");
+   fclose(f);
+   f = NULL;
+
+   MCTF_ASSERT(pgmoneta_encrypt_file(from, encrypted, NULL) == 0, cleanup, "pgmoneta_encrypt_file failed");
+   MCTF_ASSERT(pgmoneta_is_encrypted_chunked(encrypted), cleanup, "Encrypted file is not chunked");
+
+   /* Random access across a chunk boundary */
+   MCTF_ASSERT(pgmoneta_decrypt_file_range(encrypted, AES_CHUNK_SIZE - 10, 100, &range, &range_size) == 0, cleanup, "Range decryption failed");
+   MCTF_ASSERT_INT_EQ((int)range_size, 100, cleanup, "Range size mismatch");
+   MCTF_ASSERT(memcmp(range, plaintext + AES_CHUNK_SIZE - 10, 100) == 0, cleanup, "Range content mismatch");
+   free(range);
+   range = NULL;
+
+   /* Reading past the end is clamped */
+   MCTF_ASSERT(pgmoneta_decrypt_file_range(encrypted, plaintext_size - 23, 1000, &range, &range_size) == 0, cleanup, "Tail range decryption failed");
+   MCTF_ASSERT_INT_EQ((int)range_size, 23, cleanup, "Tail range size mismatch");
+   free(range);
+   range = NULL;
+
+   MCTF_ASSERT(pgmoneta_decrypt_file(encrypted, decrypted, NULL) == 0, cleanup, "pgmoneta_decrypt_file failed");
+
+   f = fopen(decrypted, "rb");
+   MCTF_ASSERT_PTR_NONNULL(f, cleanup, "Failed to open decrypted file");
+   MCTF_ASSERT(fread(content, 1, plaintext_size + 1, f) == plaintext_size, cleanup, "Decrypted size mismatch");
+   fclose(f);
+   f = NULL;
+   MCTF_ASSERT(memcmp(content, plaintext, plaintext_size) == 0, cleanup, "Decrypted content mismatch");
+
+   /* Flip a bit in the second chunk */
+   remove(decrypted);
+   f = fopen(from, "wb");
+   MCTF_ASSERT_PTR_NONNULL(f, cleanup, "Failed to recreate test file");
+   MCTF_ASSERT(fwrite(plaintext, 1, plaintext_size, f) == plaintext_size, cleanup, "Failed to write test file");
+   fclose(f);
+   f = NULL;
+   MCTF_ASSERT(pgmoneta_encrypt_file(from, encrypted, NULL) == 0, cleanup, "pgmoneta_encrypt_file failed");
+
+   f = fopen(encrypted, "r+b");
+   MCTF_ASSERT_PTR_NONNULL(f, cleanup, "Failed to open encrypted file");
+   fseek(f, AES_CHUNK_HEADER_LENGTH + AES_CHUNK_SIZE + GCM_TAG_LENGTH + 42, SEEK_SET);
+   c = fgetc(f);
+   fseek(f, -1, SEEK_CUR);
+   fputc(c ^ 0x01, f);
+   fclose(f);
+   f = NULL;
+
+   MCTF_ASSERT(pgmoneta_decrypt_file_range(encrypted, 0, 10, &range, &range_size) == 0, cleanup, "Untouched chunk should decrypt");
+   free(range);
+   range = NULL;
+   MCTF_ASSERT(pgmoneta_decrypt_file_range(encrypted, AES_CHUNK_SIZE, 10, &range, &range_size) != 0, cleanup, "Tampered chunk should fail");
+   MCTF_ASSERT(pgmoneta_decrypt_file(encrypted, decrypted, NULL) != 0, cleanup, "Tampered file should fail");
+   MCTF_ASSERT(!pgmoneta_exists(decrypted), cleanup, "No output should be left behind");
+
+cleanup:
+   if (f)
+      fclose(f);
+
+   if (from[0] != '\0')
+      remove(from);
+   if (encrypted[0] != '\0')
+      remove(encrypted);
+   if (decrypted[0] != '\0')
+      remove(decrypted);
+
+   pgmoneta_test_teardown_encryption_env(&env);
+   free(plaintext);
+   free(content);
+   free(range);
+   MCTF_FINISH();
+}
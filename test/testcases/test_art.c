@@ -29,13 +29,18 @@
 
 #include <pgmoneta.h>
 #include <art.h>
+#include <logging.h>
 #include <tscommon.h>
 #include <mctf.h>
 #include <utils.h>
 #include <value.h>
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
+
+#define ART_BENCHMARK_SIZES 3
 
 struct art_test_obj
 {
@@ -46,6 +51,9 @@ struct art_test_obj
 static void test_obj_create(int idx, struct art_test_obj** obj);
 static void test_obj_destroy(struct art_test_obj* obj);
 static void test_obj_destroy_cb(uintptr_t obj);
+static int compare_keys(const void* a, const void* b);
+static char** create_keys(uint64_t count);
+static void destroy_keys(char** keys, uint64_t count);
 
 MCTF_TEST(test_art_create)
 {
@@ -963,6 +971,215 @@ cleanup:
    MCTF_FINISH();
 }
 
+MCTF_TEST(test_art_node16_search)
+{
+   struct art* t = NULL;
+   char key[3] = {0};
+   unsigned char bytes[] = {0x01, 0x20, 0x41, 0x5a, 0x61, 0x7a, 0x7f, 0x80, 0x81, 0xc0, 0xfe, 0xff};
+
+   pgmoneta_test_setup();
+
+   pgmoneta_art_create(&t);
+
+   // Twelve children after the shared prefix make a node16,
+   // including bytes above 0x7f to check the comparison is unsigned
+   for (int i = sizeof(bytes) - 1; i >= 0; i--)
+   {
+      key[0] = 'k';
+      key[1] = (char)bytes[i];
+      MCTF_ASSERT(!pgmoneta_art_insert(t, key, bytes[i], ValueUInt8), cleanup, "Insert failed");
+   }
+   MCTF_ASSERT_INT_EQ(t->size, sizeof(bytes), cleanup, "Size mismatch");
+
+   for (int i = 0; i < (int)sizeof(bytes); i++)
+   {
+      key[1] = (char)bytes[i];
+      MCTF_ASSERT_INT_EQ(pgmoneta_art_search(t, key), bytes[i], cleanup, "Search mismatch");
+   }
+
+   key[1] = 0x02;
+   MCTF_ASSERT(!pgmoneta_art_contains_key(t, key), cleanup, "Key should not exist");
+   key[1] = (char)0xfd;
+   MCTF_ASSERT(!pgmoneta_art_contains_key(t, key), cleanup, "Key should not exist");
+
+   key[1] = (char)0xff;
+   MCTF_ASSERT(!pgmoneta_art_delete(t, key), cleanup, "Delete failed");
+   MCTF_ASSERT(!pgmoneta_art_contains_key(t, key), cleanup, "Key should be deleted");
+   key[1] = 0x01;
+   MCTF_ASSERT(!pgmoneta_art_delete(t, key), cleanup, "Delete failed");
+   key[1] = (char)0x80;
+   MCTF_ASSERT_INT_EQ(pgmoneta_art_search(t, key), 0x80, cleanup, "Search mismatch");
+
+cleanup:
+   pgmoneta_art_destroy(t);
+   pgmoneta_test_teardown();
+   MCTF_FINISH();
+}
+
+MCTF_TEST(test_art_bulk_load)
+{
+   struct art* t = NULL;
+   struct art* s = NULL;
+   struct art_iterator* iter = NULL;
+   char** keys = NULL;
+   uintptr_t* values = NULL;
+   char* swap = NULL;
+   uint64_t count = 5000;
+   uint64_t n = 0;
+
+   pgmoneta_test_setup();
+
+   keys = create_keys(count);
+   values = malloc(count * sizeof(uintptr_t));
+   MCTF_ASSERT(keys != NULL && values != NULL, cleanup, "Allocation failed");
+   qsort(keys, count, sizeof(char*), compare_keys);
+   for (uint64_t i = 0; i < count; i++)
+   {
+      values[i] = (uintptr_t)keys[i];
+   }
+
+   pgmoneta_art_create(&t);
+   MCTF_ASSERT(!pgmoneta_art_bulk_load(t, keys, values, ValueString, count), cleanup, "Bulk load failed");
+   MCTF_ASSERT_INT_EQ(t->size, count, cleanup, "Size mismatch");
+   for (uint64_t i = 0; i < count; i++)
+   {
+      MCTF_ASSERT_STR_EQ((char*)pgmoneta_art_search(t, keys[i]), keys[i], cleanup, "Search mismatch");
+   }
+   MCTF_ASSERT(!pgmoneta_art_contains_key(t, "base/"), cleanup, "Key should not exist");
+
+   pgmoneta_art_iterator_create(t, &iter);
+   while (pgmoneta_art_iterator_next(iter))
+   {
+      MCTF_ASSERT_STR_EQ((char*)iter->value->data, iter->key, cleanup, "Iterator value mismatch");
+      n++;
+   }
+   MCTF_ASSERT_INT_EQ(n, count, cleanup, "Iterator count mismatch");
+   pgmoneta_art_iterator_destroy(iter);
+   iter = NULL;
+
+   // The loaded tree takes regular inserts and deletes afterward
+   MCTF_ASSERT(!pgmoneta_art_insert(t, "base/extra", 1, ValueUInt8), cleanup, "Insert failed");
+   MCTF_ASSERT(!pgmoneta_art_delete(t, keys[count / 2]), cleanup, "Delete failed");
+   MCTF_ASSERT(!pgmoneta_art_contains_key(t, keys[count / 2]), cleanup, "Key should be deleted");
+   MCTF_ASSERT_INT_EQ(t->size, count, cleanup, "Size mismatch");
+
+   // Unsorted input falls back to inserts
+   swap = keys[0];
+   keys[0] = keys[count - 1];
+   keys[count - 1] = swap;
+   pgmoneta_art_create(&s);
+   MCTF_ASSERT(!pgmoneta_art_bulk_load(s, keys, values, ValueString, count), cleanup, "Bulk load failed");
+   MCTF_ASSERT_INT_EQ(s->size, count, cleanup, "Size mismatch");
+   MCTF_ASSERT_STR_EQ((char*)pgmoneta_art_search(s, keys[0]), keys[count - 1], cleanup, "Search mismatch");
+
+cleanup:
+   pgmoneta_art_iterator_destroy(iter);
+   pgmoneta_art_destroy(t);
+   pgmoneta_art_destroy(s);
+   destroy_keys(keys, count);
+   free(values);
+   pgmoneta_test_teardown();
+   MCTF_FINISH();
+}
+
+/**
+ * Benchmark: insert, search, iterate and bulk load
+ */
+MCTF_TEST_MAX(test_art_benchmark, 300)
+{
+   struct art* t = NULL;
+   struct art_iterator* iter = NULL;
+   char** keys = NULL;
+   uintptr_t* values = NULL;
+   uint64_t sizes[ART_BENCHMARK_SIZES] = {10000, 100000, 1000000};
+   uint64_t count = 0;
+   uint64_t found = 0;
+   struct timespec start_t;
+   struct timespec end_t;
+   double insert;
+   double search;
+   double iterate;
+   double bulk;
+
+   pgmoneta_test_setup();
+
+   for (int s = 0; s < ART_BENCHMARK_SIZES; s++)
+   {
+      count = sizes[s];
+      keys = create_keys(count);
+      values = malloc(count * sizeof(uintptr_t));
+      MCTF_ASSERT(keys != NULL && values != NULL, cleanup, "Allocation failed");
+      for (uint64_t i = 0; i < count; i++)
+      {
+         values[i] = i;
+      }
+
+      pgmoneta_art_create(&t);
+      clock_gettime(CLOCK_MONOTONIC, &start_t);
+      for (uint64_t i = 0; i < count; i++)
+      {
+         pgmoneta_art_insert(t, keys[i], values[i], ValueUInt64);
+      }
+      clock_gettime(CLOCK_MONOTONIC, &end_t);
+      insert = pgmoneta_compute_duration(start_t, end_t);
+
+      found = 0;
+      clock_gettime(CLOCK_MONOTONIC, &start_t);
+      for (uint64_t i = 0; i < count; i++)
+      {
+         if (pgmoneta_art_search(t, keys[i]) == values[i])
+         {
+            found++;
+         }
+      }
+      clock_gettime(CLOCK_MONOTONIC, &end_t);
+      search = pgmoneta_compute_duration(start_t, end_t);
+      MCTF_ASSERT_INT_EQ(found, count, cleanup, "Search mismatch");
+
+      found = 0;
+      clock_gettime(CLOCK_MONOTONIC, &start_t);
+      pgmoneta_art_iterator_create(t, &iter);
+      while (pgmoneta_art_iterator_next(iter))
+      {
+         found++;
+      }
+      pgmoneta_art_iterator_destroy(iter);
+      iter = NULL;
+      clock_gettime(CLOCK_MONOTONIC, &end_t);
+      iterate = pgmoneta_compute_duration(start_t, end_t);
+      MCTF_ASSERT_INT_EQ(found, count, cleanup, "Iterator count mismatch");
+
+      pgmoneta_art_destroy(t);
+      t = NULL;
+
+      qsort(keys, count, sizeof(char*), compare_keys);
+      pgmoneta_art_create(&t);
+      clock_gettime(CLOCK_MONOTONIC, &start_t);
+      pgmoneta_art_bulk_load(t, keys, values, ValueUInt64, count);
+      clock_gettime(CLOCK_MONOTONIC, &end_t);
+      bulk = pgmoneta_compute_duration(start_t, end_t);
+      MCTF_ASSERT_INT_EQ(t->size, count, cleanup, "Size mismatch");
+
+      pgmoneta_log_info("art %" PRIu64 " keys: insert %.3fs, search %.3fs, iterate %.3fs, bulk load %.3fs",
+                        count, insert, search, iterate, bulk);
+
+      pgmoneta_art_destroy(t);
+      t = NULL;
+      destroy_keys(keys, count);
+      keys = NULL;
+      free(values);
+      values = NULL;
+   }
+
+cleanup:
+   pgmoneta_art_iterator_destroy(iter);
+   pgmoneta_art_destroy(t);
+   destroy_keys(keys, count);
+   free(values);
+   pgmoneta_test_teardown();
+   MCTF_FINISH();
+}
+
 static void
 test_obj_create(int idx, struct art_test_obj** obj)
 {
@@ -991,4 +1208,48 @@ static void
 test_obj_destroy_cb(uintptr_t obj)
 {
    test_obj_destroy((struct art_test_obj*)obj);
-}
\ No newline at end of file
+}
+
+static int
+compare_keys(const void* a, const void* b)
+{
+   return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+static char**
+create_keys(uint64_t count)
+{
+   char** keys = NULL;
+   char buf[MISC_LENGTH];
+   uint64_t j = 0;
+
+   keys = malloc(count * sizeof(char*));
+   if (keys == NULL)
+   {
+      return NULL;
+   }
+
+   // Manifest like paths in a scattered order
+   for (uint64_t i = 0; i < count; i++)
+   {
+      j = (i * 1000003) % count;
+      pgmoneta_snprintf(buf, sizeof(buf), "base/%" PRIu64 "/%" PRIu64, j % 7, j);
+      keys[i] = pgmoneta_append(NULL, buf);
+   }
+
+   return keys;
+}
+
+static void
+destroy_keys(char** keys, uint64_t count)
+{
+   if (keys == NULL)
+   {
+      return;
+   }
+   for (uint64_t i = 0; i < count; i++)
+   {
+      free(keys[i]);
+   }
+   free(keys);
+}
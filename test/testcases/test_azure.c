@@ -0,0 +1,560 @@
+/*
+ * Copyright (C) 2026 The pgmoneta community
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or other
+ * materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may
+ * be used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <pgmoneta.h>
+#include <art.h>
+#include <mctf.h>
+#include <storage.h>
+#include <tscommon.h>
+#include <utils.h>
+#include <workflow.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#define AZURE_TEST_LABEL      "20260101000000"
+#define AZURE_TEST_BLOCK_SIZE (64 * 1024)
+#define AZURE_TEST_FILE_SIZE  (5 * AZURE_TEST_BLOCK_SIZE - 100)
+#define AZURE_TEST_MAX_BLOCKS 16
+
+/**
+ * A block staged with Put Block
+ */
+struct mock_block
+{
+   char id[MISC_LENGTH];
+   char* data;
+   size_t length;
+};
+
+/**
+ * A local endpoint that accepts Put Blob, Put Block and Put Block List
+ */
+struct mock_azure
+{
+   int socket_fd;
+   int port;
+   pthread_t thread;
+   volatile bool running;
+   pthread_mutex_t lock;
+   int blobs;
+   int blocks;
+   int block_lists;
+   size_t bytes;
+   struct mock_block staged[AZURE_TEST_MAX_BLOCKS];
+   char block_list_path[1024];
+   char* block_list;
+   char* pg_version;
+   size_t pg_version_length;
+};
+
+static struct mock_azure mock;
+
+static bool
+read_request(int fd, char* path, size_t path_size, char** body, size_t* body_length)
+{
+   char buffer[8192];
+   char* end = NULL;
+   char* cl = NULL;
+   char* data = NULL;
+   size_t length = 0;
+   size_t content_length = 0;
+   size_t received = 0;
+   ssize_t n;
+
+   *body = NULL;
+   *body_length = 0;
+
+   memset(buffer, 0, sizeof(buffer));
+
+   while (end == NULL && length < sizeof(buffer) - 1)
+   {
+      n = read(fd, buffer + length, sizeof(buffer) - 1 - length);
+      if (n <= 0)
+      {
+         return false;
+      }
+      length += (size_t)n;
+      end = strstr(buffer, "\r\n\r\n");
+   }
+
+   if (end == NULL || sscanf(buffer, "PUT %1023s", path) != 1)
+   {
+      return false;
+   }
+   path[path_size - 1] = '\0';
+
+   cl = strstr(buffer, "Content-Length: ");
+   if (cl != NULL)
+   {
+      content_length = strtoul(cl + strlen("Content-Length: "), NULL, 10);
+   }
+
+   /* Keep the body, with a terminator for the XML requests */
+   data = (char*)calloc(1, content_length + 1);
+   if (data == NULL)
+   {
+      return false;
+   }
+
+   received = MIN(content_length, length - (size_t)(end + 4 - buffer));
+   memcpy(data, end + 4, received);
+   while (received < content_length)
+   {
+      n = read(fd, data + received, content_length - received);
+      if (n <= 0)
+      {
+         free(data);
+         return false;
+      }
+      received += (size_t)n;
+   }
+
+   *body = data;
+   *body_length = content_length;
+
+   return true;
+}
+
+static void*
+mock_azure_thread(void* arg __attribute__((unused)))
+{
+   char* reply = "HTTP/1.1 201 Created\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+
+   while (mock.running)
+   {
+      fd_set read_fds;
+      struct timeval timeout;
+      char path[1024];
+      char* body = NULL;
+      char* id = NULL;
+      size_t body_length = 0;
+      int client;
+
+      FD_ZERO(&read_fds);
+      FD_SET(mock.socket_fd, &read_fds);
+      timeout.tv_sec = 0;
+      timeout.tv_usec = 100000;
+
+      if (select(mock.socket_fd + 1, &read_fds, NULL, NULL, &timeout) <= 0)
+      {
+         continue;
+      }
+
+      client = accept(mock.socket_fd, NULL, NULL);
+      if (client < 0)
+      {
+         continue;
+      }
+
+      if (read_request(client, path, sizeof(path), &body, &body_length))
+      {
+         pthread_mutex_lock(&mock.lock);
+         if (strstr(path, "comp=blocklist") != NULL)
+         {
+            mock.block_lists++;
+            pgmoneta_snprintf(mock.block_list_path, sizeof(mock.block_list_path), "%s", path);
+            free(mock.block_list);
+            mock.block_list = body;
+            body = NULL;
+         }
+         else if ((id = strstr(path, "blockid=")) != NULL)
+         {
+            if (mock.blocks < AZURE_TEST_MAX_BLOCKS)
+            {
+               struct mock_block* b = &mock.staged[mock.blocks];
+
+               pgmoneta_snprintf(b->id, sizeof(b->id), "%s", id + strlen("blockid="));
+               b->id[strcspn(b->id, "&")] = '\0';
+               b->data = body;
+               b->length = body_length;
+               body = NULL;
+            }
+            mock.blocks++;
+            mock.bytes += body_length;
+         }
+         else
+         {
+            if (pgmoneta_ends_with(path, "/PG_VERSION"))
+            {
+               free(mock.pg_version);
+               mock.pg_version = body;
+               mock.pg_version_length = body_length;
+               body = NULL;
+            }
+            mock.blobs++;
+            mock.bytes += body_length;
+         }
+         pthread_mutex_unlock(&mock.lock);
+
+         if (write(client, reply, strlen(reply)) < 0)
+         {
+            /* The client reports the failure */
+         }
+      }
+
+      free(body);
+      close(client);
+   }
+
+   return NULL;
+}
+
+/**
+ * Rebuild a blob from the staged blocks in the order of the block list
+ */
+static int
+mock_azure_reassemble(char*** ids, int* number_of_ids, char** blob, size_t* blob_length)
+{
+   char* p = NULL;
+   char* e = NULL;
+   char* b = NULL;
+   char** list = NULL;
+   int n = 0;
+   size_t length = 0;
+
+   *ids = NULL;
+   *number_of_ids = 0;
+   *blob = NULL;
+   *blob_length = 0;
+
+   if (mock.block_list == NULL)
+   {
+      return 1;
+   }
+
+   list = (char**)calloc(AZURE_TEST_MAX_BLOCKS, sizeof(char*));
+   if (list == NULL)
+   {
+      return 1;
+   }
+
+   p = mock.block_list;
+   while ((p = strstr(p, "<Latest>")) != NULL && n < AZURE_TEST_MAX_BLOCKS)
+   {
+      struct mock_block* block = NULL;
+      char* nb = NULL;
+
+      p += strlen("<Latest>");
+      e = strstr(p, "</Latest>");
+      if (e == NULL)
+      {
+         goto error;
+      }
+
+      list[n] = strndup(p, (size_t)(e - p));
+      if (list[n] == NULL)
+      {
+         goto error;
+      }
+
+      for (int i = 0; i < mock.blocks && i < AZURE_TEST_MAX_BLOCKS && block == NULL; i++)
+      {
+         if (!strcmp(mock.staged[i].id, list[n]))
+         {
+            block = &mock.staged[i];
+         }
+      }
+      n++;
+
+      if (block == NULL)
+      {
+         goto error;
+      }
+
+      nb = (char*)realloc(b, length + block->length);
+      if (nb == NULL)
+      {
+         goto error;
+      }
+      b = nb;
+      memcpy(b + length, block->data, block->length);
+      length += block->length;
+
+      p = e;
+   }
+
+   *ids = list;
+   *number_of_ids = n;
+   *blob = b;
+   *blob_length = length;
+
+   return 0;
+
+error:
+
+   for (int i = 0; i < n; i++)
+   {
+      free(list[i]);
+   }
+   free(list);
+   free(b);
+
+   return 1;
+}
+
+static int
+mock_azure_start(void)
+{
+   struct sockaddr_in addr;
+   socklen_t len = sizeof(addr);
+   int opt = 1;
+
+   memset(&mock, 0, sizeof(mock));
+   pthread_mutex_init(&mock.lock, NULL);
+
+   mock.socket_fd = socket(AF_INET, SOCK_STREAM, 0);
+   if (mock.socket_fd < 0)
+   {
+      return 1;
+   }
+
+   setsockopt(mock.socket_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+   memset(&addr, 0, sizeof(addr));
+   addr.sin_family = AF_INET;
+   addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+   addr.sin_port = 0;
+
+   if (bind(mock.socket_fd, (struct sockaddr*)&addr, sizeof(addr)) ||
+       listen(mock.socket_fd, 128) ||
+       getsockname(mock.socket_fd, (struct sockaddr*)&addr, &len))
+   {
+      close(mock.socket_fd);
+      return 1;
+   }
+
+   mock.port = ntohs(addr.sin_port);
+   mock.running = true;
+
+   if (pthread_create(&mock.thread, NULL, mock_azure_thread, NULL))
+   {
+      close(mock.socket_fd);
+      return 1;
+   }
+
+   return 0;
+}
+
+static void
+mock_azure_stop(void)
+{
+   if (mock.running)
+   {
+      mock.running = false;
+      pthread_join(mock.thread, NULL);
+      close(mock.socket_fd);
+   }
+   pthread_mutex_destroy(&mock.lock);
+
+   for (int i = 0; i < mock.blocks && i < AZURE_TEST_MAX_BLOCKS; i++)
+   {
+      free(mock.staged[i].data);
+   }
+   free(mock.block_list);
+   free(mock.pg_version);
+}
+
+static int
+write_file(char* path, size_t size)
+{
+   FILE* file = fopen(path, "w");
+
+   if (file == NULL)
+   {
+      return 1;
+   }
+
+   for (size_t i = 0; i < size; i++)
+   {
+      fputc((int)(i * 31 % 251), file);
+   }
+
+   fclose(file);
+
+   return 0;
+}
+
+static bool
+same_content(char* data, size_t size)
+{
+   for (size_t i = 0; i < size; i++)
+   {
+      if ((unsigned char)data[i] != (unsigned char)(i * 31 % 251))
+      {
+         return false;
+      }
+   }
+
+   return true;
+}
+
+/**
+ * Test: a file larger than azure_block_size is staged as blocks and
+ * committed with one block list, small files use a single Put Blob.
+ */
+MCTF_TEST(test_azure_block_upload)
+{
+   struct main_configuration* config = NULL;
+   char endpoint[MISC_LENGTH];
+   char account[MISC_LENGTH];
+   char container[MISC_LENGTH];
+   char key[MISC_LENGTH];
+   char base_dir[MAX_PATH];
+   int port = 0;
+   bool use_tls = true;
+   int block_size = 0;
+   struct workflow* wf = NULL;
+   struct art* nodes = NULL;
+   char* root = NULL;
+   char path[MAX_PATH];
+   FILE* info = NULL;
+   char** ids = NULL;
+   int number_of_ids = 0;
+   char* blob = NULL;
+   size_t blob_length = 0;
+   char* expected = NULL;
+   size_t expected_length = 0;
+   char raw[8];
+   int ret = -1;
+   int blocks = (AZURE_TEST_FILE_SIZE + AZURE_TEST_BLOCK_SIZE - 1) / AZURE_TEST_BLOCK_SIZE;
+
+   pgmoneta_test_setup();
+
+   config = (struct main_configuration*)shmem;
+   memcpy(endpoint, config->azure_endpoint, sizeof(endpoint));
+   memcpy(account, config->azure_storage_account, sizeof(account));
+   memcpy(container, config->azure_container, sizeof(container));
+   memcpy(key, config->azure_shared_key, sizeof(key));
+   memcpy(base_dir, config->azure_base_dir, sizeof(base_dir));
+   port = config->azure_port;
+   use_tls = config->azure_use_tls;
+   block_size = config->azure_block_size;
+
+   MCTF_ASSERT(mock_azure_start() == 0, cleanup, "the mock endpoint should start");
+
+   pgmoneta_snprintf(config->azure_endpoint, sizeof(config->azure_endpoint), "localhost");
+   pgmoneta_snprintf(config->azure_storage_account, sizeof(config->azure_storage_account), "pgmoneta");
+   pgmoneta_snprintf(config->azure_container, sizeof(config->azure_container), "backups");
+   pgmoneta_snprintf(config->azure_shared_key, sizeof(config->azure_shared_key), "cGdtb25ldGE=");
+   pgmoneta_snprintf(config->azure_base_dir, sizeof(config->azure_base_dir), "/pgmoneta");
+   config->azure_port = mock.port;
+   config->azure_use_tls = false;
+   config->azure_block_size = AZURE_TEST_BLOCK_SIZE;
+
+   root = pgmoneta_get_server_backup_identifier(PRIMARY_SERVER, AZURE_TEST_LABEL);
+   pgmoneta_snprintf(path, sizeof(path), "%s/data/base/1", root);
+   MCTF_ASSERT(pgmoneta_mkdir(path) == 0, cleanup, "directory should be created");
+
+   pgmoneta_snprintf(path, sizeof(path), "%s/backup.info", root);
+   info = fopen(path, "w");
+   MCTF_ASSERT_PTR_NONNULL(info, cleanup, "backup.info should be created");
+   fprintf(info, "LABEL=%s\nSTATUS=1\n", AZURE_TEST_LABEL);
+   fclose(info);
+
+   pgmoneta_snprintf(path, sizeof(path), "%s/data/PG_VERSION", root);
+   MCTF_ASSERT(write_file(path, 3) == 0, cleanup, "file should be written");
+   pgmoneta_snprintf(path, sizeof(path), "%s/data/base/1/16384", root);
+   MCTF_ASSERT(write_file(path, AZURE_TEST_FILE_SIZE) == 0, cleanup, "file should be written");
+
+   pgmoneta_art_create(&nodes);
+   pgmoneta_art_insert(nodes, NODE_SERVER_ID, (uintptr_t)PRIMARY_SERVER, ValueInt32);
+   pgmoneta_art_insert(nodes, NODE_LABEL, (uintptr_t)AZURE_TEST_LABEL, ValueString);
+
+   wf = pgmoneta_storage_create_azure();
+   MCTF_ASSERT_PTR_NONNULL(wf, cleanup, "the workflow should be created");
+
+   ret = wf->setup(wf->name(), nodes);
+   MCTF_ASSERT_INT_EQ(ret, 0, cleanup, "setup should succeed");
+   ret = wf->execute(wf->name(), nodes);
+   MCTF_ASSERT_INT_EQ(ret, 0, cleanup, "upload should succeed");
+
+   MCTF_ASSERT_INT_EQ(mock.blocks, blocks, cleanup, "the large file should be staged in blocks");
+   MCTF_ASSERT_INT_EQ(mock.block_lists, 1, cleanup, "the blocks should be committed once");
+   /* backup.info, PG_VERSION and the marker of the base directory */
+   MCTF_ASSERT_INT_EQ(mock.blobs, 3, cleanup, "small files should use Put Blob");
+
+   /* The block list names every block once, in the order of the file */
+   MCTF_ASSERT(mock_azure_reassemble(&ids, &number_of_ids, &blob, &blob_length) == 0, cleanup,
+               "the block list should only name staged blocks");
+   MCTF_ASSERT(pgmoneta_ends_with(mock.block_list_path, "/data/base/1/16384?comp=blocklist"), cleanup,
+               "the block list should commit the large file");
+   MCTF_ASSERT_INT_EQ(number_of_ids, blocks, cleanup, "the block list should name every block");
+   for (int i = 0; i < number_of_ids; i++)
+   {
+      pgmoneta_snprintf(&raw[0], sizeof(raw), "%06d", i);
+      MCTF_ASSERT(!pgmoneta_base64_encode(&raw[0], 6, &expected, &expected_length), cleanup,
+                  "the block id should be encoded");
+      MCTF_ASSERT_STR_EQ(ids[i], expected, cleanup, "the block list should be in file order");
+      free(expected);
+      expected = NULL;
+   }
+
+   /* The committed blob is the file, and so is the single Put Blob */
+   MCTF_ASSERT(blob_length == AZURE_TEST_FILE_SIZE, cleanup, "the blob should have the size of the file");
+   MCTF_ASSERT(same_content(blob, blob_length), cleanup, "the blob should match the file");
+   MCTF_ASSERT(mock.pg_version_length == 3 && same_content(mock.pg_version, 3), cleanup,
+               "PG_VERSION should be sent as is");
+
+cleanup:
+   mock_azure_stop();
+   for (int i = 0; i < number_of_ids; i++)
+   {
+      free(ids[i]);
+   }
+   free(ids);
+   free(blob);
+   free(expected);
+   free(wf);
+   pgmoneta_art_destroy(nodes);
+   if (root != NULL)
+   {
+      pgmoneta_delete_directory(root);
+   }
+   free(root);
+   if (config != NULL)
+   {
+      memcpy(config->azure_endpoint, endpoint, sizeof(endpoint));
+      memcpy(config->azure_storage_account, account, sizeof(account));
+      memcpy(config->azure_container, container, sizeof(container));
+      memcpy(config->azure_shared_key, key, sizeof(key));
+      memcpy(config->azure_base_dir, base_dir, sizeof(base_dir));
+      config->azure_port = port;
+      config->azure_use_tls = use_tls;
+      config->azure_block_size = block_size;
+   }
+   pgmoneta_test_teardown();
+   MCTF_FINISH();
+}
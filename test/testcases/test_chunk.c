@@ -0,0 +1,494 @@
+/*
+ * Copyright (C) 2026 The pgmoneta community
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or other
+ * materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may
+ * be used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <pgmoneta.h>
+#include <chunk.h>
+#include <deque.h>
+#include <extraction.h>
+#include <info.h>
+#include <mctf.h>
+#include <tscommon.h>
+#include <utils.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+
+#define CHUNK_TEST_SIZE  (4 * 1024 * 1024)
+#define CHUNK_TEST_LABEL "20991231235958"
+
+MCTF_TEST_SETUP(chunk)
+{
+   pgmoneta_test_config_save();
+}
+
+MCTF_TEST_TEARDOWN(chunk)
+{
+   pgmoneta_test_config_restore();
+}
+
+static void
+fill(unsigned char* data, size_t size, uint64_t seed)
+{
+   uint64_t x = seed;
+
+   for (size_t i = 0; i < size; i++)
+   {
+      x ^= x << 13;
+      x ^= x >> 7;
+      x ^= x << 17;
+      data[i] = (unsigned char)x;
+   }
+}
+
+static int
+write_file(char* path, unsigned char* data, size_t size)
+{
+   FILE* file = fopen(path, "w");
+
+   if (file == NULL)
+   {
+      return 1;
+   }
+
+   fwrite(data, 1, size, file);
+   fclose(file);
+
+   return 0;
+}
+
+static bool
+same_file(char* path, unsigned char* data, size_t size)
+{
+   bool same = false;
+   unsigned char* content = NULL;
+   FILE* file = fopen(path, "r");
+
+   if (file == NULL)
+   {
+      return false;
+   }
+
+   content = (unsigned char*)malloc(size + 1);
+   if (content != NULL)
+   {
+      same = fread(content, 1, size + 1, file) == size && !memcmp(content, data, size);
+   }
+
+   free(content);
+   fclose(file);
+
+   return same;
+}
+
+/**
+ * Test: chunk boundaries only depend on the content, so an insertion
+ * only moves the boundaries next to it.
+ */
+MCTF_TEST(test_chunk_cut)
+{
+   unsigned char* data = NULL;
+   unsigned char* shifted = NULL;
+   size_t offset = 0;
+   size_t length = 0;
+   int cuts = 0;
+   int shared = 0;
+   struct deque* boundaries = NULL;
+   char key[32];
+
+   data = (unsigned char*)malloc(CHUNK_TEST_SIZE);
+   shifted = (unsigned char*)malloc(CHUNK_TEST_SIZE + 100);
+   MCTF_ASSERT(data != NULL && shifted != NULL, cleanup, "allocation should succeed");
+
+   fill(data, CHUNK_TEST_SIZE, 42);
+   fill(shifted, 100, 7);
+   memcpy(shifted + 100, data, CHUNK_TEST_SIZE);
+
+   pgmoneta_deque_create(false, &boundaries);
+
+   while (offset < CHUNK_TEST_SIZE)
+   {
+      length = pgmoneta_chunk_cut(data + offset, CHUNK_TEST_SIZE - offset);
+      MCTF_ASSERT(length > 0 && length <= CHUNK_MAX_SIZE, cleanup, "chunk length should be bounded");
+      MCTF_ASSERT(length >= CHUNK_MIN_SIZE || offset + length == CHUNK_TEST_SIZE, cleanup, "only the last chunk may be short");
+      offset += length;
+      pgmoneta_snprintf(key, sizeof(key), "%zu", offset);
+      pgmoneta_deque_add(boundaries, key, (uintptr_t)key, ValueString);
+      cuts++;
+   }
+
+   MCTF_ASSERT(cuts > CHUNK_TEST_SIZE / CHUNK_MAX_SIZE, cleanup, "content should decide most boundaries");
+
+   offset = 0;
+   while (offset < CHUNK_TEST_SIZE + 100)
+   {
+      offset += pgmoneta_chunk_cut(shifted + offset, CHUNK_TEST_SIZE + 100 - offset);
+      pgmoneta_snprintf(key, sizeof(key), "%zu", offset - 100);
+      if (offset > 100 && pgmoneta_deque_exists(boundaries, key))
+      {
+         shared++;
+      }
+   }
+
+   MCTF_ASSERT_FMT(shared >= cuts - 2, cleanup, "%d of %d boundaries should survive the insertion", shared, cuts);
+
+cleanup:
+   pgmoneta_deque_destroy(boundaries);
+   free(data);
+   free(shifted);
+   MCTF_FINISH();
+}
+
+/**
+ * Test: chunk a directory, restore it, deduplicate a copy and collect
+ * the chunks that are no longer referenced.
+ */
+MCTF_TEST(test_chunk_store)
+{
+   char store[MAX_PATH];
+   char first[MAX_PATH];
+   char second[MAX_PATH];
+   char target[MAX_PATH];
+   char path[MAX_PATH];
+   char first_index[MAX_PATH];
+   char second_index[MAX_PATH];
+   unsigned char* data = NULL;
+   uint64_t chunked = 0;
+   uint64_t stored = 0;
+   uint64_t removed = 0;
+   struct deque* indexes = NULL;
+
+   pgmoneta_snprintf(store, sizeof(store), "%s/chunk/store", TEST_BASE_DIR);
+   pgmoneta_snprintf(first, sizeof(first), "%s/chunk/first/", TEST_BASE_DIR);
+   pgmoneta_snprintf(second, sizeof(second), "%s/chunk/second/", TEST_BASE_DIR);
+   pgmoneta_snprintf(target, sizeof(target), "%s/chunk/target/", TEST_BASE_DIR);
+   pgmoneta_snprintf(first_index, sizeof(first_index), "%s/chunk/first.chunks", TEST_BASE_DIR);
+   pgmoneta_snprintf(second_index, sizeof(second_index), "%s/chunk/second.chunks", TEST_BASE_DIR);
+
+   data = (unsigned char*)malloc(CHUNK_TEST_SIZE);
+   MCTF_ASSERT_PTR_NONNULL(data, cleanup, "allocation should succeed");
+   fill(data, CHUNK_TEST_SIZE, 42);
+
+   pgmoneta_snprintf(path, sizeof(path), "%sbase/1", first);
+   MCTF_ASSERT(pgmoneta_mkdir(path) == 0, cleanup, "directory should be created");
+   pgmoneta_snprintf(path, sizeof(path), "%sbase/1/16384", first);
+   MCTF_ASSERT(write_file(path, data, CHUNK_TEST_SIZE) == 0, cleanup, "file should be written");
+   pgmoneta_snprintf(path, sizeof(path), "%sPG_VERSION", first);
+   MCTF_ASSERT(write_file(path, (unsigned char*)"17\n", 3) == 0, cleanup, "file should be written");
+
+   MCTF_ASSERT(pgmoneta_chunk_directory(store, first, first_index, NULL, &chunked, &stored) == 0, cleanup, "chunking should succeed");
+   MCTF_ASSERT_INT_EQ((int)chunked, CHUNK_TEST_SIZE, cleanup, "the large file should be chunked");
+   MCTF_ASSERT_INT_EQ((int)stored, CHUNK_TEST_SIZE, cleanup, "all chunks should be new");
+
+   pgmoneta_snprintf(path, sizeof(path), "%sbase/1/16384", first);
+   MCTF_ASSERT(!pgmoneta_exists(path), cleanup, "the chunked file should be removed");
+   pgmoneta_snprintf(path, sizeof(path), "%sPG_VERSION", first);
+   MCTF_ASSERT(pgmoneta_exists(path), cleanup, "small files should be kept");
+
+   MCTF_ASSERT(pgmoneta_chunk_restore(store, first_index, target, NULL) == 0, cleanup, "restore should succeed");
+   pgmoneta_snprintf(path, sizeof(path), "%sbase/1/16384", target);
+   MCTF_ASSERT(same_file(path, data, CHUNK_TEST_SIZE), cleanup, "the restored file should match");
+
+   /* Change the tail of a copy */
+   fill(data + CHUNK_TEST_SIZE - 1000, 1000, 99);
+   pgmoneta_snprintf(path, sizeof(path), "%sbase/1", second);
+   MCTF_ASSERT(pgmoneta_mkdir(path) == 0, cleanup, "directory should be created");
+   pgmoneta_snprintf(path, sizeof(path), "%sbase/1/16384", second);
+   MCTF_ASSERT(write_file(path, data, CHUNK_TEST_SIZE) == 0, cleanup, "file should be written");
+
+   MCTF_ASSERT(pgmoneta_chunk_directory(store, second, second_index, NULL, &chunked, &stored) == 0, cleanup, "chunking should succeed");
+   MCTF_ASSERT_FMT(stored <= CHUNK_MAX_SIZE, cleanup, "only the last chunk should be new (%lu)", stored);
+
+   /* Only the second backup is left */
+   pgmoneta_deque_create(false, &indexes);
+   pgmoneta_deque_add(indexes, second_index, (uintptr_t)second_index, ValueString);
+   MCTF_ASSERT(pgmoneta_chunk_collect(store, indexes, &removed) == 0, cleanup, "collect should succeed");
+   MCTF_ASSERT_FMT(removed > 0 && removed <= CHUNK_MAX_SIZE, cleanup, "the old last chunk should be removed (%lu)", removed);
+
+   pgmoneta_delete_directory(target);
+   MCTF_ASSERT(pgmoneta_chunk_restore(store, second_index, target, NULL) == 0, cleanup, "restore should succeed");
+   pgmoneta_snprintf(path, sizeof(path), "%sbase/1/16384", target);
+   MCTF_ASSERT(same_file(path, data, CHUNK_TEST_SIZE), cleanup, "the restored copy should match");
+
+cleanup:
+   pgmoneta_deque_destroy(indexes);
+   free(data);
+   pgmoneta_snprintf(path, sizeof(path), "%s/chunk", TEST_BASE_DIR);
+   pgmoneta_delete_directory(path);
+   MCTF_FINISH();
+}
+
+/**
+ * Test: two servers share a store, and a store in use is not collected.
+ */
+MCTF_TEST(test_chunk_shared)
+{
+   char store[MAX_PATH];
+   char first[MAX_PATH];
+   char second[MAX_PATH];
+   char path[MAX_PATH];
+   char first_index[MAX_PATH];
+   char second_index[MAX_PATH];
+   unsigned char* data = NULL;
+   uint64_t chunked = 0;
+   uint64_t stored = 0;
+   uint64_t removed = 0;
+   int lock = -1;
+   struct deque* indexes = NULL;
+
+   pgmoneta_snprintf(store, sizeof(store), "%s/chunk/store", TEST_BASE_DIR);
+   pgmoneta_snprintf(first, sizeof(first), "%s/chunk/primary/", TEST_BASE_DIR);
+   pgmoneta_snprintf(second, sizeof(second), "%s/chunk/replica/", TEST_BASE_DIR);
+   pgmoneta_snprintf(first_index, sizeof(first_index), "%s/chunk/primary.chunks", TEST_BASE_DIR);
+   pgmoneta_snprintf(second_index, sizeof(second_index), "%s/chunk/replica.chunks", TEST_BASE_DIR);
+
+   data = (unsigned char*)malloc(CHUNK_TEST_SIZE);
+   MCTF_ASSERT_PTR_NONNULL(data, cleanup, "allocation should succeed");
+   fill(data, CHUNK_TEST_SIZE, 7);
+
+   pgmoneta_snprintf(path, sizeof(path), "%sbase/5", first);
+   MCTF_ASSERT(pgmoneta_mkdir(path) == 0, cleanup, "directory should be created");
+   pgmoneta_snprintf(path, sizeof(path), "%sbase/5/1259", first);
+   MCTF_ASSERT(write_file(path, data, CHUNK_TEST_SIZE) == 0, cleanup, "file should be written");
+   pgmoneta_snprintf(path, sizeof(path), "%sbase/5", second);
+   MCTF_ASSERT(pgmoneta_mkdir(path) == 0, cleanup, "directory should be created");
+   pgmoneta_snprintf(path, sizeof(path), "%sbase/5/1259", second);
+   MCTF_ASSERT(write_file(path, data, CHUNK_TEST_SIZE) == 0, cleanup, "file should be written");
+
+   MCTF_ASSERT(pgmoneta_chunk_directory(store, first, first_index, NULL, &chunked, &stored) == 0, cleanup, "chunking should succeed");
+   MCTF_ASSERT(pgmoneta_chunk_directory(store, second, second_index, NULL, &chunked, &stored) == 0, cleanup, "chunking should succeed");
+   MCTF_ASSERT_INT_EQ((int)stored, 0, cleanup, "the clone should not add chunks");
+
+   /* A backup holding the store keeps the collection away */
+   pgmoneta_snprintf(path, sizeof(path), "%s/.lock", store);
+   lock = open(path, O_RDONLY);
+   MCTF_ASSERT(lock != -1 && flock(lock, LOCK_SH) == 0, cleanup, "the store should be locked");
+
+   pgmoneta_deque_create(false, &indexes);
+   MCTF_ASSERT(pgmoneta_chunk_collect(store, indexes, &removed) == 0, cleanup, "collect should succeed");
+   MCTF_ASSERT_INT_EQ((int)removed, 0, cleanup, "a store in use should not be collected");
+
+   close(lock);
+   lock = -1;
+
+   /* The primary is gone, the replica still refers to every chunk */
+   pgmoneta_deque_add(indexes, second_index, (uintptr_t)second_index, ValueString);
+   MCTF_ASSERT(pgmoneta_chunk_collect(store, indexes, &removed) == 0, cleanup, "collect should succeed");
+   MCTF_ASSERT_INT_EQ((int)removed, 0, cleanup, "shared chunks should be kept");
+
+   pgmoneta_snprintf(path, sizeof(path), "%s/chunk/target/", TEST_BASE_DIR);
+   MCTF_ASSERT(pgmoneta_chunk_restore(store, second_index, path, NULL) == 0, cleanup, "restore should succeed");
+   pgmoneta_snprintf(path, sizeof(path), "%s/chunk/target/base/5/1259", TEST_BASE_DIR);
+   MCTF_ASSERT(same_file(path, data, CHUNK_TEST_SIZE), cleanup, "the restored file should match");
+
+cleanup:
+   if (lock != -1)
+   {
+      close(lock);
+   }
+   pgmoneta_deque_destroy(indexes);
+   free(data);
+   pgmoneta_snprintf(path, sizeof(path), "%s/chunk", TEST_BASE_DIR);
+   pgmoneta_delete_directory(path);
+   MCTF_FINISH();
+}
+
+/**
+ * Test: a backup keeps the chunk store it was chunked into when
+ * chunk_store_shared changes, and stays chunked when it is rehydrated.
+ */
+MCTF_TEST(test_chunk_store_location)
+{
+   char path[MAX_PATH];
+   char* server_backup = NULL;
+   char* backup_dir = NULL;
+   char* data_dir = NULL;
+   char* store = NULL;
+   char* index = NULL;
+   char* rehydrated = NULL;
+   char* extracted = NULL;
+   unsigned char* data = NULL;
+   bool existed = false;
+   uint64_t chunked = 0;
+   uint64_t stored = 0;
+   struct backup* backup = NULL;
+   struct main_configuration* config;
+
+   config = (struct main_configuration*)shmem;
+   config->chunk_store_shared = false;
+
+   server_backup = pgmoneta_get_server_backup(PRIMARY_SERVER);
+   backup_dir = pgmoneta_get_server_backup_identifier(PRIMARY_SERVER, CHUNK_TEST_LABEL);
+   data_dir = pgmoneta_get_server_backup_identifier_data(PRIMARY_SERVER, CHUNK_TEST_LABEL);
+   store = pgmoneta_get_server_chunks(PRIMARY_SERVER, false);
+   index = pgmoneta_append(NULL, backup_dir);
+   index = pgmoneta_append(index, CHUNK_INDEX);
+   existed = pgmoneta_exists(store);
+
+   data = (unsigned char*)malloc(CHUNK_TEST_SIZE);
+   MCTF_ASSERT_PTR_NONNULL(data, cleanup, "allocation should succeed");
+   fill(data, CHUNK_TEST_SIZE, 11);
+
+   pgmoneta_snprintf(path, sizeof(path), "%sbase/5", data_dir);
+   MCTF_ASSERT(pgmoneta_mkdir(path) == 0, cleanup, "directory should be created");
+   pgmoneta_snprintf(path, sizeof(path), "%sbase/5/1259", data_dir);
+   MCTF_ASSERT(write_file(path, data, CHUNK_TEST_SIZE) == 0, cleanup, "file should be written");
+
+   MCTF_ASSERT(pgmoneta_chunk_directory(store, data_dir, index, NULL, &chunked, &stored) == 0, cleanup, "chunking should succeed");
+
+   backup = (struct backup*)calloc(1, sizeof(struct backup));
+   MCTF_ASSERT_PTR_NONNULL(backup, cleanup, "allocation should succeed");
+   pgmoneta_snprintf(backup->label, sizeof(backup->label), "%s", CHUNK_TEST_LABEL);
+   backup->valid = VALID_TRUE;
+   backup->chunked_size = chunked;
+   backup->chunked_stored_size = stored;
+   backup->chunked_shared = false;
+   MCTF_ASSERT(pgmoneta_save_info(server_backup, backup) == 0, cleanup, "info should be saved");
+
+   /* The backup still resolves its own store after the toggle */
+   config->chunk_store_shared = true;
+
+   MCTF_ASSERT(pgmoneta_chunk_rehydrate(PRIMARY_SERVER, CHUNK_TEST_LABEL) == 0, cleanup, "rehydrate should succeed");
+   rehydrated = pgmoneta_chunk_get_rehydrated(PRIMARY_SERVER, CHUNK_TEST_LABEL);
+   MCTF_ASSERT_PTR_NONNULL(rehydrated, cleanup, "the rehydrated directory should be known");
+   pgmoneta_snprintf(path, sizeof(path), "%sbase/5/1259", rehydrated);
+   MCTF_ASSERT(same_file(path, data, CHUNK_TEST_SIZE), cleanup, "the rehydrated file should match");
+
+   /* The backup stays chunked, and its files are read from the rehydrated copy */
+   MCTF_ASSERT(pgmoneta_exists(index), cleanup, "the index should be kept");
+   pgmoneta_snprintf(path, sizeof(path), "%sbase/5/1259", data_dir);
+   MCTF_ASSERT(!pgmoneta_exists(path), cleanup, "the backup should not be rehydrated in place");
+   MCTF_ASSERT(pgmoneta_extract_backup_file(PRIMARY_SERVER, CHUNK_TEST_LABEL, "base/5/1259", NULL, &extracted) == 0, cleanup, "extract should succeed");
+   MCTF_ASSERT(same_file(extracted, data, CHUNK_TEST_SIZE), cleanup, "the extracted file should match");
+
+   pgmoneta_chunk_rehydrate_remove(PRIMARY_SERVER, CHUNK_TEST_LABEL);
+   MCTF_ASSERT(!pgmoneta_exists(rehydrated), cleanup, "the rehydrated directory should be removed");
+
+cleanup:
+   pgmoneta_delete_server_workspace(PRIMARY_SERVER, CHUNK_TEST_LABEL);
+   if (backup_dir != NULL)
+   {
+      pgmoneta_delete_directory(backup_dir);
+   }
+   if (store != NULL && !existed)
+   {
+      pgmoneta_delete_directory(store);
+   }
+   free(backup);
+   free(data);
+   free(server_backup);
+   free(backup_dir);
+   free(data_dir);
+   free(store);
+   free(index);
+   free(rehydrated);
+   free(extracted);
+   MCTF_FINISH();
+}
+
+/**
+ * Test: the chunks of a backup that has not recorded its store yet are
+ * kept by a collection of that store.
+ */
+MCTF_TEST(test_chunk_collect_in_flight)
+{
+   char path[MAX_PATH];
+   char target[MAX_PATH];
+   char* server_backup = NULL;
+   char* backup_dir = NULL;
+   char* data_dir = NULL;
+   char* store = NULL;
+   char* index = NULL;
+   unsigned char* data = NULL;
+   bool existed = false;
+   uint64_t chunked = 0;
+   uint64_t stored = 0;
+   struct backup* backup = NULL;
+   struct main_configuration* config;
+
+   config = (struct main_configuration*)shmem;
+   config->chunk_store_shared = true;
+
+   server_backup = pgmoneta_get_server_backup(PRIMARY_SERVER);
+   backup_dir = pgmoneta_get_server_backup_identifier(PRIMARY_SERVER, CHUNK_TEST_LABEL);
+   data_dir = pgmoneta_get_server_backup_identifier_data(PRIMARY_SERVER, CHUNK_TEST_LABEL);
+   store = pgmoneta_get_server_chunks(PRIMARY_SERVER, true);
+   index = pgmoneta_append(NULL, backup_dir);
+   index = pgmoneta_append(index, CHUNK_INDEX);
+   existed = pgmoneta_exists(store);
+
+   data = (unsigned char*)malloc(CHUNK_TEST_SIZE);
+   MCTF_ASSERT_PTR_NONNULL(data, cleanup, "allocation should succeed");
+   fill(data, CHUNK_TEST_SIZE, 13);
+
+   pgmoneta_snprintf(path, sizeof(path), "%sbase/5", data_dir);
+   MCTF_ASSERT(pgmoneta_mkdir(path) == 0, cleanup, "directory should be created");
+   pgmoneta_snprintf(path, sizeof(path), "%sbase/5/1259", data_dir);
+   MCTF_ASSERT(write_file(path, data, CHUNK_TEST_SIZE) == 0, cleanup, "file should be written");
+
+   /* The backup.info still describes a backup outside of the shared store */
+   backup = (struct backup*)calloc(1, sizeof(struct backup));
+   MCTF_ASSERT_PTR_NONNULL(backup, cleanup, "allocation should succeed");
+   pgmoneta_snprintf(backup->label, sizeof(backup->label), "%s", CHUNK_TEST_LABEL);
+   backup->valid = VALID_TRUE;
+   backup->chunked_shared = false;
+   MCTF_ASSERT(pgmoneta_save_info(server_backup, backup) == 0, cleanup, "info should be saved");
+
+   MCTF_ASSERT(pgmoneta_chunk_directory(store, data_dir, index, NULL, &chunked, &stored) == 0, cleanup, "chunking should succeed");
+   MCTF_ASSERT(stored > 0, cleanup, "chunks should be stored");
+
+   MCTF_ASSERT(pgmoneta_chunk_collect_server(PRIMARY_SERVER) == 0, cleanup, "collect should succeed");
+
+   pgmoneta_snprintf(target, sizeof(target), "%s/chunk/target/", TEST_BASE_DIR);
+   MCTF_ASSERT(pgmoneta_chunk_restore(store, index, target, NULL) == 0, cleanup, "restore should succeed");
+   pgmoneta_snprintf(target, sizeof(target), "%s/chunk/target/base/5/1259", TEST_BASE_DIR);
+   MCTF_ASSERT(same_file(target, data, CHUNK_TEST_SIZE), cleanup, "the chunks should be kept");
+
+cleanup:
+   if (backup_dir != NULL)
+   {
+      pgmoneta_delete_directory(backup_dir);
+   }
+   if (store != NULL && !existed)
+   {
+      pgmoneta_delete_directory(store);
+   }
+   pgmoneta_snprintf(path, sizeof(path), "%s/chunk", TEST_BASE_DIR);
+   pgmoneta_delete_directory(path);
+   free(backup);
+   free(data);
+   free(server_backup);
+   free(backup_dir);
+   free(data_dir);
+   free(store);
+   free(index);
+   MCTF_FINISH();
+}
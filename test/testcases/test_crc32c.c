@@ -0,0 +1,224 @@
+/*
+ * Copyright (C) 2026 The pgmoneta community
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or other
+ * materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may
+ * be used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <pgmoneta.h>
+#include <logging.h>
+#include <mctf.h>
+#include <security.h>
+#include <utils.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define CRC32C_TEST_BUFFER    (1024 * 1024)
+#define CRC32C_TEST_ROUNDS    2000
+#define CRC32C_BENCHMARK_SIZE (256 * 1024 * 1024)
+
+static unsigned char*
+create_buffer(size_t size)
+{
+   unsigned char* buffer = malloc(size);
+
+   if (buffer != NULL)
+   {
+      srand(42);
+      for (size_t i = 0; i < size; i++)
+      {
+         buffer[i] = (unsigned char)rand();
+      }
+   }
+
+   return buffer;
+}
+
+/**
+ * Test: the check value of CRC32C for "123456789" in every implementation.
+ */
+MCTF_TEST(test_crc32c_check_value)
+{
+   char* data = "123456789";
+   uint32_t crc = 0;
+
+   for (int i = 0; i < CRC32C_IMPLEMENTATIONS; i++)
+   {
+      if (!pgmoneta_crc32c_supported(i))
+      {
+         continue;
+      }
+
+      pgmoneta_init_crc32c(&crc);
+      MCTF_ASSERT(pgmoneta_create_crc32c_buffer_with(i, data, strlen(data), &crc) == 0, cleanup, "crc32c should succeed");
+      pgmoneta_finalize_crc32c(&crc);
+      MCTF_ASSERT_FMT(crc == 0xE3069283, cleanup, "%s: expected e3069283, got %08x",
+                      pgmoneta_crc32c_implementation_name(i), crc);
+   }
+
+   MCTF_ASSERT(pgmoneta_crc32c_supported(CRC32C_SOFTWARE), cleanup, "software crc32c is always supported");
+   MCTF_ASSERT(pgmoneta_crc32c_supported(pgmoneta_crc32c_implementation()), cleanup, "the active crc32c is supported");
+
+cleanup:
+   MCTF_FINISH();
+}
+
+/**
+ * Test: every supported implementation matches the software implementation
+ * over random lengths, alignments and seeds.
+ */
+MCTF_TEST(test_crc32c_cross_validate)
+{
+   unsigned char* buffer = NULL;
+   size_t offset;
+   size_t length;
+   uint32_t seed;
+   uint32_t expected;
+   uint32_t actual;
+
+   buffer = create_buffer(CRC32C_TEST_BUFFER + 64);
+   MCTF_ASSERT_PTR_NONNULL(buffer, cleanup, "buffer allocation should succeed");
+
+   for (int round = 0; round < CRC32C_TEST_ROUNDS; round++)
+   {
+      offset = (size_t)rand() % 64;
+      if (round < 1024)
+      {
+         length = (size_t)round;
+      }
+      else if (round % 2 == 0)
+      {
+         length = (size_t)rand() % 32768;
+      }
+      else
+      {
+         length = (size_t)rand() % CRC32C_TEST_BUFFER;
+      }
+      seed = (uint32_t)rand();
+
+      expected = seed;
+      pgmoneta_create_crc32c_buffer_with(CRC32C_SOFTWARE, buffer + offset, length, &expected);
+
+      for (int i = 1; i < CRC32C_IMPLEMENTATIONS; i++)
+      {
+         if (!pgmoneta_crc32c_supported(i))
+         {
+            continue;
+         }
+
+         actual = seed;
+         pgmoneta_create_crc32c_buffer_with(i, buffer + offset, length, &actual);
+         MCTF_ASSERT_FMT(actual == expected, cleanup, "%s: length %zu offset %zu expected %08x, got %08x",
+                         pgmoneta_crc32c_implementation_name(i), length, offset, expected, actual);
+      }
+   }
+
+cleanup:
+   free(buffer);
+   MCTF_FINISH();
+}
+
+/**
+ * Test: incremental updates give the same result as a single call.
+ */
+MCTF_TEST(test_crc32c_incremental)
+{
+   unsigned char* buffer = NULL;
+   uint32_t whole = 0;
+   uint32_t parts = 0;
+   size_t position = 0;
+   size_t step;
+
+   buffer = create_buffer(CRC32C_TEST_BUFFER);
+   MCTF_ASSERT_PTR_NONNULL(buffer, cleanup, "buffer allocation should succeed");
+
+   pgmoneta_init_crc32c(&whole);
+   pgmoneta_create_crc32c_buffer(buffer, CRC32C_TEST_BUFFER, &whole);
+   pgmoneta_finalize_crc32c(&whole);
+
+   pgmoneta_init_crc32c(&parts);
+   while (position < CRC32C_TEST_BUFFER)
+   {
+      step = MIN((size_t)rand() % 50000 + 1, CRC32C_TEST_BUFFER - position);
+      pgmoneta_create_crc32c_buffer(buffer + position, step, &parts);
+      position += step;
+   }
+   pgmoneta_finalize_crc32c(&parts);
+
+   MCTF_ASSERT_FMT(whole == parts, cleanup, "expected %08x, got %08x", whole, parts);
+
+cleanup:
+   free(buffer);
+   MCTF_FINISH();
+}
+
+/**
+ * Benchmark: throughput of every supported implementation.
+ */
+MCTF_TEST_MAX(test_crc32c_benchmark, 120)
+{
+   unsigned char* buffer = NULL;
+   struct timespec start_t;
+   struct timespec end_t;
+   double seconds;
+   double throughput[CRC32C_IMPLEMENTATIONS] = {0};
+   size_t total;
+   uint32_t crc = 0;
+
+   buffer = create_buffer(CRC32C_TEST_BUFFER);
+   MCTF_ASSERT_PTR_NONNULL(buffer, cleanup, "buffer allocation should succeed");
+
+   for (int i = 0; i < CRC32C_IMPLEMENTATIONS; i++)
+   {
+      if (!pgmoneta_crc32c_supported(i))
+      {
+         continue;
+      }
+
+      /* The software implementation is slow, so give it less work */
+      total = i == CRC32C_SOFTWARE ? CRC32C_BENCHMARK_SIZE / 16 : CRC32C_BENCHMARK_SIZE;
+
+      clock_gettime(CLOCK_MONOTONIC, &start_t);
+      for (size_t done = 0; done < total; done += CRC32C_TEST_BUFFER)
+      {
+         pgmoneta_create_crc32c_buffer_with(i, buffer, CRC32C_TEST_BUFFER, &crc);
+      }
+      clock_gettime(CLOCK_MONOTONIC, &end_t);
+
+      seconds = pgmoneta_compute_duration(start_t, end_t);
+      throughput[i] = seconds > 0 ? (double)total / (1024 * 1024) / seconds : 0;
+
+      pgmoneta_log_info("crc32c %s: %.1f MB/s", pgmoneta_crc32c_implementation_name(i), throughput[i]);
+   }
+
+   MCTF_ASSERT(throughput[pgmoneta_crc32c_implementation()] >= throughput[CRC32C_SOFTWARE], cleanup,
+               "the active crc32c should not be slower than the software implementation");
+
+cleanup:
+   free(buffer);
+   MCTF_FINISH();
+}
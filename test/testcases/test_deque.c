@@ -28,6 +28,7 @@
  */
 #include <pgmoneta.h>
 #include <deque.h>
+#include <logging.h>
 #include <tscommon.h>
 #include <mctf.h>
 #include <utils.h>
@@ -450,6 +451,203 @@ cleanup:
    MCTF_FINISH();
 }
 
+MCTF_TEST(test_deque_ring_fifo_lifo)
+{
+   struct deque* dq = NULL;
+   char* tag = NULL;
+   char t[16];
+
+   pgmoneta_test_setup();
+
+   MCTF_ASSERT(!pgmoneta_deque_create_ring(false, 4, true, &dq), cleanup, "ring deque creation failed");
+
+   // wrap the ring around before it has to grow
+   for (int i = 0; i < 10; i++)
+   {
+      pgmoneta_snprintf(t, sizeof(t), "tag%d", i);
+      MCTF_ASSERT(!pgmoneta_deque_add(dq, t, i, ValueInt32), cleanup, "add failed");
+      MCTF_ASSERT_INT_EQ(pgmoneta_deque_poll(dq, NULL), i, cleanup, "poll mismatch");
+   }
+   MCTF_ASSERT(pgmoneta_deque_empty(dq), cleanup, "deque should be empty");
+
+   for (int i = 0; i < 100; i++)
+   {
+      pgmoneta_snprintf(t, sizeof(t), "tag%d", i);
+      MCTF_ASSERT(!pgmoneta_deque_add(dq, t, i, ValueInt32), cleanup, "add failed");
+   }
+   MCTF_ASSERT_INT_EQ(pgmoneta_deque_size(dq), 100, cleanup, "deque size should be 100");
+   MCTF_ASSERT_INT_EQ(pgmoneta_deque_peek(dq, &tag), 0, cleanup, "peek mismatch");
+   MCTF_ASSERT_STR_EQ(tag, "tag0", cleanup, "peek tag mismatch");
+   MCTF_ASSERT_INT_EQ(pgmoneta_deque_peek_last(dq, NULL), 99, cleanup, "peek last mismatch");
+   MCTF_ASSERT_INT_EQ(pgmoneta_deque_get(dq, "tag42"), 42, cleanup, "get mismatch");
+   MCTF_ASSERT(pgmoneta_deque_exists(dq, "tag7"), cleanup, "tag7 should exist");
+   MCTF_ASSERT(!pgmoneta_deque_exists(dq, "tag100"), cleanup, "tag100 should not exist");
+
+   // interned tags are handed out as copies
+   tag = NULL;
+   MCTF_ASSERT_INT_EQ(pgmoneta_deque_poll(dq, &tag), 0, cleanup, "poll mismatch");
+   MCTF_ASSERT_STR_EQ(tag, "tag0", cleanup, "poll tag mismatch");
+   free(tag);
+   tag = NULL;
+   MCTF_ASSERT_INT_EQ(pgmoneta_deque_poll_last(dq, &tag), 99, cleanup, "poll last mismatch");
+   MCTF_ASSERT_STR_EQ(tag, "tag99", cleanup, "poll last tag mismatch");
+   free(tag);
+   tag = NULL;
+   MCTF_ASSERT_INT_EQ(pgmoneta_deque_size(dq), 98, cleanup, "deque size should be 98");
+
+   MCTF_ASSERT(!pgmoneta_deque_clear(dq), cleanup, "clear failed");
+   MCTF_ASSERT_INT_EQ(pgmoneta_deque_size(dq), 0, cleanup, "deque size should be 0");
+   MCTF_ASSERT(!pgmoneta_deque_add(dq, "x", (uintptr_t)"value", ValueString), cleanup, "add after clear failed");
+   MCTF_ASSERT_STR_EQ((char*)pgmoneta_deque_peek(dq, NULL), "value", cleanup, "string value mismatch");
+
+cleanup:
+   free(tag);
+   pgmoneta_deque_destroy(dq);
+   pgmoneta_test_teardown();
+   MCTF_FINISH();
+}
+
+MCTF_TEST(test_deque_ring_iterator_sort)
+{
+   struct deque* dq = NULL;
+   struct deque_iterator* iter = NULL;
+   char* str = NULL;
+   char tag[2] = {0};
+   int index[8] = {2, 7, 1, 3, 6, 5, 4, 0};
+   int cnt = 0;
+
+   pgmoneta_test_setup();
+
+   MCTF_ASSERT(!pgmoneta_deque_create_ring(false, 0, false, &dq), cleanup, "ring deque creation failed");
+   for (int i = 0; i < 8; i++)
+   {
+      tag[0] = '0' + index[i];
+      MCTF_ASSERT(!pgmoneta_deque_add(dq, tag, index[i], ValueInt32), cleanup, "add failed");
+   }
+
+   pgmoneta_deque_sort(dq, NULL);
+
+   MCTF_ASSERT(!pgmoneta_deque_iterator_create(dq, &iter), cleanup, "iterator creation failed");
+   while (pgmoneta_deque_iterator_next(iter))
+   {
+      MCTF_ASSERT_INT_EQ(pgmoneta_value_data(iter->value), cnt, cleanup, "sorted value mismatch");
+      tag[0] = '0' + cnt;
+      MCTF_ASSERT_STR_EQ(iter->tag, tag, cleanup, "sorted tag mismatch");
+      // remove from both halves of the ring
+      if (cnt == 1 || cnt == 6)
+      {
+         pgmoneta_deque_iterator_remove(iter);
+      }
+      cnt++;
+   }
+   MCTF_ASSERT_INT_EQ(cnt, 8, cleanup, "iterator count mismatch");
+   pgmoneta_deque_iterator_remove(iter);
+   pgmoneta_deque_iterator_destroy(iter);
+   iter = NULL;
+
+   MCTF_ASSERT_INT_EQ(pgmoneta_deque_remove(dq, "0"), 1, cleanup, "remove by tag failed");
+   MCTF_ASSERT_INT_EQ(pgmoneta_deque_size(dq), 5, cleanup, "deque size should be 5");
+
+   str = pgmoneta_deque_to_string(dq, FORMAT_JSON_COMPACT, NULL, 0);
+   MCTF_ASSERT_STR_EQ(str, "[2:2,3:3,4:4,5:5,7:7]", cleanup, "to string mismatch");
+
+cleanup:
+   free(str);
+   pgmoneta_deque_iterator_destroy(iter);
+   pgmoneta_deque_destroy(dq);
+   pgmoneta_test_teardown();
+   MCTF_FINISH();
+}
+
+MCTF_TEST_MAX(test_deque_benchmark, 300)
+{
+   struct deque* dq = NULL;
+   struct deque_iterator* iter = NULL;
+   uint64_t sizes[3] = {10000, 100000, 1000000};
+   char path[MAX_PATH];
+   struct timespec start_t;
+   struct timespec end_t;
+   double add[2];
+   double iterate[2];
+   double drain[2];
+   uint64_t count = 0;
+   uint64_t found = 0;
+   size_t tags = 0;
+
+   pgmoneta_test_setup();
+
+   for (int s = 0; s < 3; s++)
+   {
+      count = sizes[s];
+      tags = 0;
+
+      // the linked deque first, then the ring buffer deque
+      for (int r = 0; r < 2; r++)
+      {
+         if (r == 0)
+         {
+            MCTF_ASSERT(!pgmoneta_deque_create(false, &dq), cleanup, "deque creation failed");
+         }
+         else
+         {
+            MCTF_ASSERT(!pgmoneta_deque_create_ring(false, 0, true, &dq), cleanup, "ring deque creation failed");
+         }
+
+         clock_gettime(CLOCK_MONOTONIC, &start_t);
+         for (uint64_t i = 0; i < count; i++)
+         {
+            pgmoneta_snprintf(path, sizeof(path), "base/16384/%" PRIu64, i);
+            if (r == 0)
+            {
+               tags += strlen(path) + 1;
+            }
+            pgmoneta_deque_add(dq, path, i, ValueUInt64);
+         }
+         clock_gettime(CLOCK_MONOTONIC, &end_t);
+         add[r] = pgmoneta_compute_duration(start_t, end_t);
+
+         found = 0;
+         clock_gettime(CLOCK_MONOTONIC, &start_t);
+         pgmoneta_deque_iterator_create(dq, &iter);
+         while (pgmoneta_deque_iterator_next(iter))
+         {
+            found += pgmoneta_value_data(iter->value) == found;
+         }
+         pgmoneta_deque_iterator_destroy(iter);
+         iter = NULL;
+         clock_gettime(CLOCK_MONOTONIC, &end_t);
+         iterate[r] = pgmoneta_compute_duration(start_t, end_t);
+         MCTF_ASSERT_INT_EQ(found, count, cleanup, "iterator mismatch");
+
+         found = 0;
+         clock_gettime(CLOCK_MONOTONIC, &start_t);
+         while (!pgmoneta_deque_empty(dq))
+         {
+            found += pgmoneta_deque_poll(dq, NULL) == found;
+         }
+         clock_gettime(CLOCK_MONOTONIC, &end_t);
+         drain[r] = pgmoneta_compute_duration(start_t, end_t);
+         MCTF_ASSERT_INT_EQ(found, count, cleanup, "poll mismatch");
+
+         pgmoneta_deque_destroy(dq);
+         dq = NULL;
+      }
+
+      pgmoneta_log_info("deque %" PRIu64 " entries: linked add %.3fs, iterate %.3fs, poll %.3fs, %" PRIu64 " allocations, ~%zu bytes",
+                        count, add[0], iterate[0], drain[0], count * 3,
+                        count * (sizeof(struct deque_node) + sizeof(struct value)) + tags);
+      pgmoneta_log_info("deque %" PRIu64 " entries: ring add %.3fs, iterate %.3fs, poll %.3fs, ~%zu bytes",
+                        count, add[1], iterate[1], drain[1],
+                        count * sizeof(struct deque_slot) + tags);
+   }
+
+cleanup:
+   pgmoneta_deque_iterator_destroy(iter);
+   pgmoneta_deque_destroy(dq);
+   pgmoneta_test_teardown();
+   MCTF_FINISH();
+}
+
 static void
 test_obj_create(int idx, struct deque_test_obj** obj)
 {
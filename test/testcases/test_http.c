@@ -26,7 +26,10 @@
  * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  *
  */
+#include <pgmoneta.h>
 #include <http.h>
+#include <network.h>
+#include <shmem.h>
 #include <tsclient.h>
 #include <tscommon.h>
 #include <mctf.h>
@@ -34,6 +37,7 @@
 #include <pthread.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <sys/select.h>
@@ -334,6 +338,116 @@ cleanup:
    MCTF_FINISH();
 }
 
+MCTF_TEST(test_pgmoneta_http_put_file_range)
+{
+   int status;
+   int fd = -1;
+   struct http* connection = NULL;
+   struct http_request* request = NULL;
+   struct http_response* response = NULL;
+   char path[] = "/tmp/pgmoneta_http_XXXXXX";
+   const char* hostname = "localhost";
+   int port = 9999;
+   bool secure = false;
+   const char* test_data = "skipped prefix|This is the body of a PUT file range request|skipped suffix";
+
+   setup_echo_server(NULL);
+
+   fd = mkstemp(path);
+   MCTF_ASSERT(fd >= 0, cleanup, "Failed to create temp file");
+   MCTF_ASSERT(write(fd, test_data, strlen(test_data)) == (ssize_t)strlen(test_data), cleanup, "wrote file incomplete");
+
+   MCTF_ASSERT(!pgmoneta_http_create((char*)hostname, port, secure, &connection), cleanup, "failed to establish connection");
+   MCTF_ASSERT(!pgmoneta_http_request_create(PGMONETA_HTTP_PUT, "/put", &request), cleanup, "failed to create request");
+   MCTF_ASSERT(!pgmoneta_http_set_file(request, path, 15, 44), cleanup, "failed to set request file");
+   MCTF_ASSERT_PTR_NONNULL(request->file, cleanup, "request file not set");
+   MCTF_ASSERT_INT_EQ((int)request->file_size, 44, cleanup, "request file size mismatch");
+
+   status = pgmoneta_http_invoke(connection, request, &response);
+   MCTF_ASSERT_INT_EQ(status, PGMONETA_HTTP_STATUS_OK, cleanup, "HTTP PUT file range request failed");
+
+cleanup:
+   pgmoneta_http_request_destroy(request);
+   pgmoneta_http_response_destroy(response);
+   pgmoneta_http_destroy(connection);
+   if (fd >= 0)
+   {
+      close(fd);
+      unlink(path);
+   }
+   teardown_echo_server();
+   MCTF_FINISH();
+}
+
+MCTF_TEST(test_pgmoneta_http_socket_options)
+{
+   int status;
+   int rcvbuf = 0;
+   int lowat = 0;
+   int saved_rcvbuf = 0;
+   int saved_sndbuf = 0;
+   int saved_notsent_lowat = 0;
+   socklen_t optlen = sizeof(int);
+   struct http* connection = NULL;
+   struct http_request* request = NULL;
+   struct http_response* response = NULL;
+   struct socket_options options;
+   struct main_configuration* config = NULL;
+   const char* hostname = "localhost";
+   int port = 9999;
+   bool secure = false;
+
+   config = (struct main_configuration*)shmem;
+   MCTF_ASSERT_PTR_NONNULL(config, cleanup, "configuration is null");
+
+   saved_rcvbuf = config->socket_rcvbuf;
+   saved_sndbuf = config->socket_sndbuf;
+   saved_notsent_lowat = config->tcp_notsent_lowat;
+
+   config->socket_rcvbuf = 32768;
+   config->socket_sndbuf = 0;
+   config->tcp_notsent_lowat = 16384;
+
+   pgmoneta_socket_options(-1, &options);
+   MCTF_ASSERT_INT_EQ(options.rcvbuf, 32768, cleanup, "rcvbuf option mismatch");
+   MCTF_ASSERT_INT_EQ(options.sndbuf, 0, cleanup, "sndbuf option mismatch");
+   MCTF_ASSERT_INT_EQ(options.notsent_lowat, 16384, cleanup, "notsent_lowat option mismatch");
+
+   setup_echo_server(NULL);
+
+   MCTF_ASSERT(!pgmoneta_http_create((char*)hostname, port, secure, &connection), cleanup, "failed to establish connection");
+   MCTF_ASSERT(!getsockopt(connection->socket, SOL_SOCKET, SO_RCVBUF, &rcvbuf, &optlen), cleanup, "getsockopt failed");
+   MCTF_ASSERT(rcvbuf >= 32768 && rcvbuf < DEFAULT_BUFFER_SIZE, cleanup, "SO_RCVBUF not applied");
+#ifdef TCP_NOTSENT_LOWAT
+   optlen = sizeof(int);
+   MCTF_ASSERT(!getsockopt(connection->socket, IPPROTO_TCP, TCP_NOTSENT_LOWAT, &lowat, &optlen), cleanup, "getsockopt failed");
+   MCTF_ASSERT_INT_EQ(lowat, 16384, cleanup, "TCP_NOTSENT_LOWAT not applied");
+#endif
+
+   MCTF_ASSERT(!pgmoneta_http_request_create(PGMONETA_HTTP_GET, "/get", &request), cleanup, "failed to create request");
+   status = pgmoneta_http_invoke(connection, request, &response);
+   MCTF_ASSERT_INT_EQ(status, PGMONETA_HTTP_STATUS_OK, cleanup, "HTTP GET request failed");
+
+   pgmoneta_http_destroy(connection);
+   connection = NULL;
+
+   MCTF_ASSERT_INT_EQ(atomic_load(&config->http_socket.rcvbuf), rcvbuf, cleanup, "http socket statistics not sampled");
+   MCTF_ASSERT(atomic_load(&config->http_socket.sndbuf) > 0, cleanup, "http socket statistics not sampled");
+
+cleanup:
+   if (config != NULL)
+   {
+      config->socket_rcvbuf = saved_rcvbuf;
+      config->socket_sndbuf = saved_sndbuf;
+      config->tcp_notsent_lowat = saved_notsent_lowat;
+   }
+   pgmoneta_http_request_destroy(request);
+   pgmoneta_http_response_destroy(response);
+   pgmoneta_http_destroy(connection);
+   teardown_echo_server();
+   MCTF_FINISH();
+}
+
 MCTF_TEST(test_pgmoneta_http_header_operations)
 {
    struct http_request* request = NULL;
@@ -0,0 +1,235 @@
+/*
+ * Copyright (C) 2026 The pgmoneta community
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or other
+ * materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may
+ * be used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <pgmoneta.h>
+#include <info.h>
+#include <mctf.h>
+#include <tscommon.h>
+#include <utils.h>
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+static int
+create_backup(char* directory, char* label, char* parent, bool info)
+{
+   char path[MAX_PATH];
+   struct backup backup;
+
+   pgmoneta_snprintf(path, sizeof(path), "%s%s", directory, label);
+   if (pgmoneta_mkdir(path))
+   {
+      return 1;
+   }
+
+   if (!info)
+   {
+      return 0;
+   }
+
+   memset(&backup, 0, sizeof(struct backup));
+   pgmoneta_snprintf(backup.label, sizeof(backup.label), "%s", label);
+   pgmoneta_snprintf(backup.wal, sizeof(backup.wal), "000000010000000000000002");
+   backup.valid = VALID_TRUE;
+   backup.backup_size = 1024;
+   backup.major_version = 17;
+
+   if (parent != NULL)
+   {
+      backup.type = TYPE_INCREMENTAL;
+      pgmoneta_snprintf(backup.parent_label, sizeof(backup.parent_label), "%s", parent);
+   }
+
+   return pgmoneta_save_info(directory, &backup);
+}
+
+static int
+age_directory(char* directory)
+{
+   struct timespec times[2];
+
+   clock_gettime(CLOCK_REALTIME, &times[0]);
+   times[0].tv_sec -= 60;
+   times[1] = times[0];
+
+   return utimensat(AT_FDCWD, directory, &times[0], 0);
+}
+
+/**
+ * Test: the catalog follows the backup directories, including backups
+ * that are in progress, updated or deleted.
+ */
+MCTF_TEST(test_info_catalog)
+{
+   char directory[MAX_PATH];
+   char path[MAX_PATH];
+   struct catalog* catalog = NULL;
+   struct backup* backup = NULL;
+   FILE* file = NULL;
+
+   pgmoneta_snprintf(directory, sizeof(directory), "%s/catalog/", TEST_BASE_DIR);
+   pgmoneta_snprintf(path, sizeof(path), "%s%s", directory, CATALOG_FILE);
+
+   MCTF_ASSERT(create_backup(directory, "20260101000000", NULL, true) == 0, cleanup, "backup should be created");
+   MCTF_ASSERT(create_backup(directory, "20260102000000", "20260101000000", true) == 0, cleanup, "backup should be created");
+   MCTF_ASSERT(create_backup(directory, "20260103000000", NULL, false) == 0, cleanup, "backup should be created");
+
+   MCTF_ASSERT(pgmoneta_catalog_load(directory, &catalog) == 0, cleanup, "catalog should load");
+   MCTF_ASSERT(pgmoneta_exists(path), cleanup, "catalog should be written");
+   MCTF_ASSERT_INT_EQ(catalog->number_of_backups, 3, cleanup, "all backups should be listed");
+   MCTF_ASSERT_INT_EQ(catalog->backups[2]->valid, VALID_UNKNOWN, cleanup, "backup in progress should be unknown");
+
+   backup = pgmoneta_catalog_search(catalog, "oldest");
+   MCTF_ASSERT_PTR_NONNULL(backup, cleanup, "oldest should be found");
+   MCTF_ASSERT_STR_EQ(backup->label, "20260101000000", cleanup, "oldest should be the first label");
+
+   backup = pgmoneta_catalog_child(catalog, "20260101000000");
+   MCTF_ASSERT_PTR_NONNULL(backup, cleanup, "child should be found");
+   MCTF_ASSERT_STR_EQ(backup->label, "20260102000000", cleanup, "child should be the incremental backup");
+
+   pgmoneta_catalog_destroy(catalog);
+   catalog = NULL;
+
+   /* The backup in progress completes */
+   MCTF_ASSERT(create_backup(directory, "20260103000000", NULL, true) == 0, cleanup, "backup should be saved");
+
+   MCTF_ASSERT(pgmoneta_catalog_load(directory, &catalog) == 0, cleanup, "catalog should load");
+   backup = pgmoneta_catalog_search(catalog, "latest");
+   MCTF_ASSERT_PTR_NONNULL(backup, cleanup, "latest should be found");
+   MCTF_ASSERT_INT_EQ(backup->valid, VALID_TRUE, cleanup, "saved backup should be valid");
+   MCTF_ASSERT_INT_EQ((int)backup->backup_size, 1024, cleanup, "saved backup should be read back");
+
+   pgmoneta_catalog_destroy(catalog);
+   catalog = NULL;
+
+   /* A deleted backup leaves the catalog */
+   pgmoneta_snprintf(path, sizeof(path), "%s%s", directory, "20260102000000");
+   pgmoneta_delete_directory(path);
+
+   MCTF_ASSERT(pgmoneta_catalog_load(directory, &catalog) == 0, cleanup, "catalog should load");
+   MCTF_ASSERT_INT_EQ(catalog->number_of_backups, 2, cleanup, "deleted backup should be gone");
+   MCTF_ASSERT(pgmoneta_catalog_search(catalog, "20260102000000") == NULL, cleanup, "deleted backup should not be found");
+   MCTF_ASSERT(pgmoneta_catalog_child(catalog, "20260101000000") == NULL, cleanup, "deleted child should not be found");
+
+   pgmoneta_catalog_destroy(catalog);
+   catalog = NULL;
+
+   /* A corrupted catalog is rebuilt */
+   pgmoneta_snprintf(path, sizeof(path), "%s%s", directory, CATALOG_FILE);
+   file = fopen(path, "w");
+   MCTF_ASSERT_PTR_NONNULL(file, cleanup, "catalog should open");
+   fputs("garbage\n", file);
+   fclose(file);
+
+   MCTF_ASSERT(pgmoneta_catalog_load(directory, &catalog) == 0, cleanup, "catalog should load");
+   MCTF_ASSERT_INT_EQ(catalog->number_of_backups, 2, cleanup, "backups should be rebuilt");
+   MCTF_ASSERT_INT_EQ(catalog->backups[0]->valid, VALID_TRUE, cleanup, "rebuilt backup should be valid");
+
+cleanup:
+   pgmoneta_catalog_destroy(catalog);
+   pgmoneta_snprintf(path, sizeof(path), "%s/catalog", TEST_BASE_DIR);
+   pgmoneta_delete_directory(path);
+   MCTF_FINISH();
+}
+
+/**
+ * Test: a stamped catalog is used without a scan until a backup
+ * directory is added or removed, and resolves the parent chain.
+ */
+MCTF_TEST(test_info_catalog_stamp)
+{
+   char* directory = NULL;
+   char path[MAX_PATH];
+   struct catalog* catalog = NULL;
+   struct backup backup;
+   struct backup* parent = NULL;
+   struct backup* root = NULL;
+
+   directory = pgmoneta_get_server_backup(PRIMARY_SERVER);
+   MCTF_ASSERT_PTR_NONNULL(directory, cleanup, "backup directory should be known");
+
+   MCTF_ASSERT(create_backup(directory, "20991230000000", NULL, true) == 0, cleanup, "backup should be created");
+   MCTF_ASSERT(create_backup(directory, "20991230000001", "20991230000000", true) == 0, cleanup, "backup should be created");
+   MCTF_ASSERT(create_backup(directory, "20991230000002", "20991230000001", true) == 0, cleanup, "backup should be created");
+
+   /* Scan and stamp the catalog with a directory that is old enough */
+   MCTF_ASSERT(pgmoneta_catalog_load(directory, &catalog) == 0, cleanup, "catalog should load");
+   pgmoneta_catalog_destroy(catalog);
+   catalog = NULL;
+   MCTF_ASSERT(age_directory(directory) == 0, cleanup, "directory should be aged");
+   MCTF_ASSERT(pgmoneta_catalog_load(directory, &catalog) == 0, cleanup, "catalog should load");
+   pgmoneta_catalog_destroy(catalog);
+   catalog = NULL;
+
+   /* A directory that does not move the stamp is not scanned */
+   pgmoneta_snprintf(path, sizeof(path), "%s%s", directory, "20991230000003");
+   MCTF_ASSERT(pgmoneta_mkdir(path) == 0, cleanup, "directory should be created");
+   MCTF_ASSERT(age_directory(directory) == 0, cleanup, "directory should be aged");
+
+   MCTF_ASSERT(pgmoneta_catalog_load(directory, &catalog) == 0, cleanup, "catalog should load");
+   MCTF_ASSERT(pgmoneta_catalog_search(catalog, "20991230000001") != NULL, cleanup, "cataloged backup should be found");
+   MCTF_ASSERT(pgmoneta_catalog_search(catalog, "20991230000003") == NULL, cleanup, "stamped catalog should not be scanned");
+   pgmoneta_catalog_destroy(catalog);
+   catalog = NULL;
+
+   /* A newer directory is scanned */
+   MCTF_ASSERT(utimensat(AT_FDCWD, directory, NULL, 0) == 0, cleanup, "directory should be touched");
+   MCTF_ASSERT(pgmoneta_catalog_load(directory, &catalog) == 0, cleanup, "catalog should load");
+   MCTF_ASSERT(pgmoneta_catalog_search(catalog, "20991230000003") != NULL, cleanup, "new backup should be found");
+   pgmoneta_catalog_destroy(catalog);
+   catalog = NULL;
+
+   /* The parent and the root come from the catalog */
+   memset(&backup, 0, sizeof(struct backup));
+   pgmoneta_snprintf(backup.label, sizeof(backup.label), "20991230000002");
+   pgmoneta_snprintf(backup.parent_label, sizeof(backup.parent_label), "20991230000001");
+   backup.type = TYPE_INCREMENTAL;
+
+   MCTF_ASSERT(pgmoneta_get_backup_parent(PRIMARY_SERVER, &backup, &parent) == 0, cleanup, "parent should be found");
+   MCTF_ASSERT_STR_EQ(parent->label, "20991230000001", cleanup, "parent should match");
+   MCTF_ASSERT(pgmoneta_get_backup_root(PRIMARY_SERVER, &backup, &root) == 0, cleanup, "root should be found");
+   MCTF_ASSERT_STR_EQ(root->label, "20991230000000", cleanup, "root should be the full backup");
+
+cleanup:
+   pgmoneta_catalog_destroy(catalog);
+   free(parent);
+   free(root);
+   if (directory != NULL)
+   {
+      for (int i = 0; i < 4; i++)
+      {
+         pgmoneta_snprintf(path, sizeof(path), "%s2099123000000%d", directory, i);
+         pgmoneta_delete_directory(path);
+      }
+   }
+   free(directory);
+   MCTF_FINISH();
+}
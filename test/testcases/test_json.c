@@ -27,6 +27,7 @@
  *
  */
 #include <pgmoneta.h>
+#include <info.h>
 #include <json.h>
 #include <tscommon.h>
 #include <mctf.h>
@@ -341,3 +342,177 @@ cleanup:
    pgmoneta_test_teardown();
    MCTF_FINISH();
 }
+
+MCTF_TEST(test_json_parse_escape)
+{
+   struct json* obj = NULL;
+   char* str = "{\"k\\\"ey\": \"a\\\\b\\\"c\\n\", \"long\": \"0123456789abcdef0123456789abcdef0123456789\", "
+               "\"empty\": \"\", \"n\": -12, \"d\": 1.5, \"t\": true, \"f\": false, \"z\": null}";
+
+   pgmoneta_test_setup();
+
+   MCTF_ASSERT(!pgmoneta_json_parse_string(str, &obj), cleanup, "parse failed");
+   MCTF_ASSERT_STR_EQ((char*)pgmoneta_json_get(obj, "k\"ey"), "a\\b\"c\n", cleanup, "escaped string mismatch");
+   MCTF_ASSERT_STR_EQ((char*)pgmoneta_json_get(obj, "long"), "0123456789abcdef0123456789abcdef0123456789", cleanup, "long string mismatch");
+   MCTF_ASSERT(pgmoneta_json_contains_key(obj, "empty"), cleanup, "empty string key missing");
+   MCTF_ASSERT_INT_EQ((int64_t)pgmoneta_json_get(obj, "n"), -12, cleanup, "integer mismatch");
+   MCTF_ASSERT(pgmoneta_value_to_double(pgmoneta_json_get(obj, "d")) == 1.5, cleanup, "double mismatch");
+   MCTF_ASSERT(pgmoneta_json_get(obj, "t") == true, cleanup, "true mismatch");
+   MCTF_ASSERT(pgmoneta_json_get(obj, "f") == false, cleanup, "false mismatch");
+   MCTF_ASSERT(pgmoneta_json_contains_key(obj, "z"), cleanup, "null key missing");
+
+   pgmoneta_json_destroy(obj);
+   obj = NULL;
+
+   MCTF_ASSERT(pgmoneta_json_parse_string("{\"a\": \"unterminated}", &obj), cleanup, "unterminated string should fail");
+   MCTF_ASSERT(pgmoneta_json_parse_string("{\"a\": \"bad \\q\"}", &obj), cleanup, "unknown escape should fail");
+
+   MCTF_ASSERT(!pgmoneta_json_parse_string("{\"a\": \"\\/\\b\\f caf\\u00e9 \\u20AC \\ud83d\\ude00\"}", &obj), cleanup, "parse failed");
+   MCTF_ASSERT_STR_EQ((char*)pgmoneta_json_get(obj, "a"), "/\b\f caf\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80", cleanup, "unicode escape mismatch");
+   pgmoneta_json_destroy(obj);
+   obj = NULL;
+
+   MCTF_ASSERT(pgmoneta_json_parse_string("{\"a\": \"\\u00e\"}", &obj), cleanup, "short unicode escape should fail");
+   MCTF_ASSERT(pgmoneta_json_parse_string("{\"a\": \"\\ude00\"}", &obj), cleanup, "lone low surrogate should fail");
+   MCTF_ASSERT(pgmoneta_json_parse_string("{\"a\": \"\\ud83d x\"}", &obj), cleanup, "lone high surrogate should fail");
+   MCTF_ASSERT(pgmoneta_json_parse_string("{\"a\": \"\\u0000\"}", &obj), cleanup, "NUL escape should fail");
+
+cleanup:
+   pgmoneta_json_destroy(obj);
+   pgmoneta_test_teardown();
+   MCTF_FINISH();
+}
+
+MCTF_TEST(test_json_stream_manifest)
+{
+   char path[MAX_PATH];
+   char* key_path[1] = {"Files"};
+   FILE* file = NULL;
+   struct json_reader* reader = NULL;
+   struct json* item = NULL;
+   struct json* obj = NULL;
+   struct json* files = NULL;
+   uint64_t count = 0;
+   uint64_t size = 0;
+   int total = 20000;
+
+   pgmoneta_test_setup();
+
+   pgmoneta_snprintf(path, sizeof(path), "%s/json_manifest", TEST_BASE_DIR);
+   file = fopen(path, "w");
+   MCTF_ASSERT_PTR_NONNULL(file, cleanup, "unable to create manifest");
+
+   // Brackets and quotes inside skipped values must not confuse the reader
+   fprintf(file, "{\"PostgreSQL-Backup-Manifest-Version\": 2,\n\"System-Identifier\": \"}]\\\"{[\",\n");
+   fprintf(file, "\"Meta\": {\"note\": \"}\", \"list\": [\"]\", 1]},\n\"Files\": [\n");
+   for (int i = 0; i < total; i++)
+   {
+      fprintf(file, "{ \"Path\": \"base/1/%d\\\"q\", \"Size\": %d, \"Last-Modified\": \"2026-10-19 00:00:00 GMT\", "
+                    "\"Checksum-Algorithm\": \"SHA256\", \"Checksum\": \"%064d\" }%s\n",
+              i, i, i, i == total - 1 ? "" : ",");
+   }
+   fprintf(file, "],\n\"Manifest-Checksum\": \"0\"}\n");
+   fclose(file);
+   file = NULL;
+
+   MCTF_ASSERT(!pgmoneta_json_reader_init(path, &reader), cleanup, "reader init failed");
+   MCTF_ASSERT(!pgmoneta_json_locate(reader, key_path, 1), cleanup, "unable to locate files");
+   while (pgmoneta_json_next_array_item(reader, &item))
+   {
+      char expected[MAX_PATH];
+
+      pgmoneta_snprintf(expected, sizeof(expected), "base/1/%" PRIu64 "\"q", count);
+      MCTF_ASSERT_STR_EQ((char*)pgmoneta_json_get(item, "Path"), expected, cleanup, "path mismatch");
+      size += (uint64_t)pgmoneta_json_get(item, "Size");
+      count++;
+      pgmoneta_json_destroy(item);
+      item = NULL;
+   }
+   MCTF_ASSERT_INT_EQ(count, total, cleanup, "streamed file count mismatch");
+   MCTF_ASSERT_INT_EQ(size, (uint64_t)total * (total - 1) / 2, cleanup, "streamed size mismatch");
+
+   MCTF_ASSERT(!pgmoneta_json_read_file(path, &obj), cleanup, "read file failed");
+   files = (struct json*)pgmoneta_json_get(obj, "Files");
+   MCTF_ASSERT_PTR_NONNULL(files, cleanup, "files array missing");
+   MCTF_ASSERT_INT_EQ(pgmoneta_json_array_length(files), total, cleanup, "parsed file count mismatch");
+   MCTF_ASSERT_STR_EQ((char*)pgmoneta_json_get(obj, "System-Identifier"), "}]\"{[", cleanup, "escaped identifier mismatch");
+
+cleanup:
+   if (file != NULL)
+   {
+      fclose(file);
+   }
+   pgmoneta_json_destroy(item);
+   pgmoneta_json_destroy(obj);
+   pgmoneta_json_reader_close(reader);
+   remove(path);
+   pgmoneta_test_teardown();
+   MCTF_FINISH();
+}
+
+MCTF_TEST(test_json_stream_manifest_escape)
+{
+   char* label = "20991231235958";
+   char* key_path[1] = {"Files"};
+   char* paths[] = {"base/1/caf\xc3\xa9", "base/1/\xf0\x9f\x98\x80", "pg_tblspc/16384/PG_18", "base/1/\b\f"};
+   char* root = NULL;
+   char* manifest = NULL;
+   FILE* file = NULL;
+   struct json_reader* reader = NULL;
+   struct json* item = NULL;
+   unsigned long size = 0;
+   uint64_t biggest = 0;
+   int count = 0;
+
+   pgmoneta_test_setup();
+
+   root = pgmoneta_get_server_backup_identifier(0, label);
+   manifest = pgmoneta_get_server_backup_identifier_data(0, label);
+   MCTF_ASSERT(pgmoneta_mkdir(manifest) == 0, cleanup, "unable to create backup directory");
+   manifest = pgmoneta_append(manifest, "backup_manifest");
+
+   file = fopen(manifest, "w");
+   MCTF_ASSERT_PTR_NONNULL(file, cleanup, "unable to create manifest");
+
+   // The escapes PostgreSQL may write for a path
+   fprintf(file, "{\"PostgreSQL-Backup-Manifest-Version\": 2,\n\"Files\": [\n");
+   fprintf(file, "{ \"Path\": \"base/1/caf\\u00e9\", \"Size\": 1 },\n");
+   fprintf(file, "{ \"Path\": \"base/1/\\ud83d\\ude00\", \"Size\": 2 },\n");
+   fprintf(file, "{ \"Path\": \"pg_tblspc\\/16384\\/PG_18\", \"Size\": 3 },\n");
+   fprintf(file, "{ \"Path\": \"base/1/\\b\\f\", \"Size\": 4 }\n");
+   fprintf(file, "],\n\"Manifest-Checksum\": \"0\"}\n");
+   fclose(file);
+   file = NULL;
+
+   MCTF_ASSERT(!pgmoneta_json_reader_init(manifest, &reader), cleanup, "reader init failed");
+   MCTF_ASSERT(!pgmoneta_json_locate(reader, key_path, 1), cleanup, "unable to locate files");
+   while (pgmoneta_json_next_array_item(reader, &item))
+   {
+      MCTF_ASSERT(count < 4, cleanup, "too many files");
+      MCTF_ASSERT_STR_EQ((char*)pgmoneta_json_get(item, "Path"), paths[count], cleanup, "path mismatch");
+      count++;
+      pgmoneta_json_destroy(item);
+      item = NULL;
+   }
+   MCTF_ASSERT_INT_EQ(count, 4, cleanup, "streamed file count mismatch");
+
+   MCTF_ASSERT(!pgmoneta_backup_size(0, label, &size, &biggest), cleanup, "backup size failed");
+   MCTF_ASSERT_INT_EQ(size, 10, cleanup, "backup size mismatch");
+   MCTF_ASSERT_INT_EQ(biggest, 4, cleanup, "biggest file size mismatch");
+
+cleanup:
+   if (file != NULL)
+   {
+      fclose(file);
+   }
+   pgmoneta_json_destroy(item);
+   pgmoneta_json_reader_close(reader);
+   if (root != NULL)
+   {
+      pgmoneta_delete_directory(root);
+   }
+   free(root);
+   free(manifest);
+   pgmoneta_test_teardown();
+   MCTF_FINISH();
+}
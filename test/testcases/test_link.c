@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2026 The pgmoneta community
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or other
+ * materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may
+ * be used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <pgmoneta.h>
+#include <link.h>
+#include <mctf.h>
+#include <tscommon.h>
+#include <utils.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int create_backup(char* dir, char* differs);
+static int write_file(char* path, char* content);
+
+MCTF_TEST_SETUP(link)
+{
+   pgmoneta_test_config_save();
+}
+
+MCTF_TEST_TEARDOWN(link)
+{
+   pgmoneta_test_config_restore();
+}
+
+MCTF_TEST(test_link_comparefiles)
+{
+   char* dir = NULL;
+   char from[MAX_PATH] = {0};
+   char to[MAX_PATH] = {0};
+   char path[MAX_PATH] = {0};
+   struct main_configuration* config;
+
+   config = (struct main_configuration*)shmem;
+   config->compression_type = COMPRESSION_NONE;
+   config->common.encryption = ENCRYPTION_NONE;
+   config->link_paranoid = false;
+
+   dir = pgmoneta_append(dir, TEST_BASE_DIR);
+   dir = pgmoneta_append(dir, "/link");
+   pgmoneta_snprintf(from, sizeof(from), "%s/new", dir);
+   pgmoneta_snprintf(to, sizeof(to), "%s/old", dir);
+
+   MCTF_ASSERT(!create_backup(from, "abcdefgh"), cleanup, "Failed to create %s", from);
+   MCTF_ASSERT(!create_backup(to, "hgfedcba"), cleanup, "Failed to create %s", to);
+
+   /* Matching manifest checksums and sizes are enough */
+   MCTF_ASSERT(!pgmoneta_link_comparefiles(from, to, NULL), cleanup, "Failed to compare %s with %s", from, to);
+
+   pgmoneta_snprintf(path, sizeof(path), "%s/data/same", from);
+   MCTF_ASSERT(pgmoneta_is_symlink(path), cleanup, "%s not linked", path);
+   pgmoneta_snprintf(path, sizeof(path), "%s/data/differs", from);
+   MCTF_ASSERT(pgmoneta_is_symlink(path), cleanup, "%s not linked", path);
+   pgmoneta_snprintf(path, sizeof(path), "%s/data/changed", from);
+   MCTF_ASSERT(!pgmoneta_is_symlink(path), cleanup, "%s linked", path);
+
+   /* With link_paranoid the content must match as well */
+   pgmoneta_delete_directory(dir);
+   config->link_paranoid = true;
+
+   MCTF_ASSERT(!create_backup(from, "abcdefgh"), cleanup, "Failed to create %s", from);
+   MCTF_ASSERT(!create_backup(to, "hgfedcba"), cleanup, "Failed to create %s", to);
+
+   MCTF_ASSERT(!pgmoneta_link_comparefiles(from, to, NULL), cleanup, "Failed to compare %s with %s", from, to);
+
+   pgmoneta_snprintf(path, sizeof(path), "%s/data/same", from);
+   MCTF_ASSERT(pgmoneta_is_symlink(path), cleanup, "%s not linked", path);
+   pgmoneta_snprintf(path, sizeof(path), "%s/data/differs", from);
+   MCTF_ASSERT(!pgmoneta_is_symlink(path), cleanup, "%s linked with link_paranoid", path);
+   pgmoneta_snprintf(path, sizeof(path), "%s/data/changed", from);
+   MCTF_ASSERT(!pgmoneta_is_symlink(path), cleanup, "%s linked", path);
+
+   /* Without manifests nothing can be compared */
+   pgmoneta_snprintf(path, sizeof(path), "%s/backup.manifest", to);
+   pgmoneta_delete_file(path, NULL);
+   MCTF_ASSERT(pgmoneta_link_comparefiles(from, to, NULL), cleanup, "Compare without a manifest succeeded");
+
+cleanup:
+   pgmoneta_delete_directory(dir);
+   free(dir);
+   MCTF_FINISH();
+}
+
+static int
+create_backup(char* dir, char* differs)
+{
+   char path[MAX_PATH] = {0};
+   char manifest[MAX_PATH * 2] = {0};
+
+   pgmoneta_snprintf(path, sizeof(path), "%s/data", dir);
+   if (pgmoneta_mkdir(path))
+   {
+      return 1;
+   }
+
+   pgmoneta_snprintf(path, sizeof(path), "%s/data/same", dir);
+   if (write_file(path, "12345678"))
+   {
+      return 1;
+   }
+
+   /* Same size and manifest checksum, but different content */
+   pgmoneta_snprintf(path, sizeof(path), "%s/data/differs", dir);
+   if (write_file(path, differs))
+   {
+      return 1;
+   }
+
+   pgmoneta_snprintf(path, sizeof(path), "%s/data/changed", dir);
+   if (write_file(path, dir))
+   {
+      return 1;
+   }
+
+   pgmoneta_snprintf(manifest, sizeof(manifest), "changed,%s\ndiffers,%s\nsame,%s\n",
+                     pgmoneta_ends_with(dir, "new") ? "ccc" : "ddd", "bbb", "aaa");
+   pgmoneta_snprintf(path, sizeof(path), "%s/backup.manifest", dir);
+
+   return write_file(path, manifest);
+}
+
+static int
+write_file(char* path, char* content)
+{
+   FILE* f = NULL;
+
+   f = fopen(path, "w");
+   if (f == NULL)
+   {
+      return 1;
+   }
+
+   fputs(content, f);
+   fclose(f);
+
+   return 0;
+}
@@ -0,0 +1,330 @@
+/*
+ * Copyright (C) 2026 The pgmoneta community
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or other
+ * materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may
+ * be used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <pgmoneta.h>
+#include <art.h>
+#include <json.h>
+#include <logging.h>
+#include <manifest.h>
+#include <mctf.h>
+#include <tscommon.h>
+#include <utils.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MANIFEST_BENCHMARK_ENTRIES 1000000
+
+static int
+write_manifest(char* path, char** rows, int size)
+{
+   FILE* file = fopen(path, "w");
+
+   if (file == NULL)
+   {
+      return 1;
+   }
+
+   for (int i = 0; i < size; i++)
+   {
+      fprintf(file, "%s\n", rows[i]);
+   }
+
+   fclose(file);
+
+   return 0;
+}
+
+/**
+ * Test: added, changed and deleted files of two unsorted manifests.
+ */
+MCTF_TEST(test_manifest_compare)
+{
+   char old_manifest[MAX_PATH];
+   char new_manifest[MAX_PATH];
+   char* old_rows[] = {"base/1/3,aaaa", "global/pg_control,bbbb", "base/1/1,cccc", "base/1/2,dddd"};
+   char* new_rows[] = {"base/1/4,eeee", "base/1/1,cccc", "global/pg_control,ffff"};
+   struct art* deleted = NULL;
+   struct art* changed = NULL;
+   struct art* added = NULL;
+
+   pgmoneta_snprintf(old_manifest, sizeof(old_manifest), "%s/old.manifest", TEST_BASE_DIR);
+   pgmoneta_snprintf(new_manifest, sizeof(new_manifest), "%s/new.manifest", TEST_BASE_DIR);
+
+   MCTF_ASSERT(write_manifest(old_manifest, old_rows, 4) == 0, cleanup, "writing the old manifest should succeed");
+   MCTF_ASSERT(write_manifest(new_manifest, new_rows, 3) == 0, cleanup, "writing the new manifest should succeed");
+
+   MCTF_ASSERT(pgmoneta_compare_manifests(old_manifest, new_manifest, &deleted, &changed, &added) == 0, cleanup, "compare should succeed");
+
+   MCTF_ASSERT_INT_EQ(deleted->size, 2, cleanup, "two files should be deleted");
+   MCTF_ASSERT_STR_EQ((char*)pgmoneta_art_search(deleted, "base/1/2"), "dddd", cleanup, "base/1/2 should be deleted");
+   MCTF_ASSERT_STR_EQ((char*)pgmoneta_art_search(deleted, "base/1/3"), "aaaa", cleanup, "base/1/3 should be deleted");
+
+   MCTF_ASSERT_INT_EQ(added->size, 1, cleanup, "one file should be added");
+   MCTF_ASSERT_STR_EQ((char*)pgmoneta_art_search(added, "base/1/4"), "eeee", cleanup, "base/1/4 should be added");
+
+   MCTF_ASSERT_INT_EQ(changed->size, 2, cleanup, "pg_control and the manifest should be changed");
+   MCTF_ASSERT_STR_EQ((char*)pgmoneta_art_search(changed, "global/pg_control"), "bbbb", cleanup, "pg_control should be changed");
+   MCTF_ASSERT(pgmoneta_art_contains_key(changed, "backup_manifest"), cleanup, "the manifest should be changed");
+
+   MCTF_ASSERT(!pgmoneta_art_contains_key(deleted, "base/1/1") && !pgmoneta_art_contains_key(changed, "base/1/1"),
+               cleanup, "base/1/1 is unchanged");
+
+cleanup:
+   pgmoneta_art_destroy(deleted);
+   pgmoneta_art_destroy(changed);
+   pgmoneta_art_destroy(added);
+   remove(old_manifest);
+   remove(new_manifest);
+   MCTF_FINISH();
+}
+
+/**
+ * Test: sorting a manifest larger than a single run.
+ */
+MCTF_TEST(test_manifest_sort)
+{
+   char manifest[MAX_PATH];
+   char previous[MAX_PATH];
+   FILE* file = NULL;
+   struct deque* paths = NULL;
+   struct deque_iterator* iter = NULL;
+   int entries = MANIFEST_SORT_RUN * 2 + 17;
+   int count = 0;
+
+   pgmoneta_snprintf(manifest, sizeof(manifest), "%s/sort.manifest", TEST_BASE_DIR);
+
+   file = fopen(manifest, "w");
+   MCTF_ASSERT_PTR_NONNULL(file, cleanup, "manifest should be created");
+   for (int i = 0; i < entries; i++)
+   {
+      fprintf(file, "base/%d,%08x\n", (int)(((long)i * 1000003) % entries), i);
+   }
+   fclose(file);
+   file = NULL;
+
+   MCTF_ASSERT(pgmoneta_manifest_sort(manifest) == 0, cleanup, "sort should succeed");
+   MCTF_ASSERT(pgmoneta_manifest_get_paths(manifest, &paths) == 0, cleanup, "reading the manifest should succeed");
+
+   memset(previous, 0, sizeof(previous));
+   pgmoneta_deque_iterator_create(paths, &iter);
+   while (pgmoneta_deque_iterator_next(iter))
+   {
+      MCTF_ASSERT_FMT(strcmp(previous, iter->tag) <= 0, cleanup, "%s sorted before %s", previous, iter->tag);
+      pgmoneta_snprintf(previous, sizeof(previous), "%s", iter->tag);
+      count++;
+   }
+
+   MCTF_ASSERT_INT_EQ(count, entries, cleanup, "all entries should be kept");
+
+cleanup:
+   if (file != NULL)
+   {
+      fclose(file);
+   }
+   pgmoneta_deque_iterator_destroy(iter);
+   pgmoneta_deque_destroy(paths);
+   remove(manifest);
+   MCTF_FINISH();
+}
+
+/**
+ * Test: a combined manifest replaces the incremental files of its source.
+ */
+MCTF_TEST(test_manifest_combined)
+{
+   char source[MAX_PATH];
+   char combined[MAX_PATH];
+   char* rows[] = {
+      "{ \"PostgreSQL-Backup-Manifest-Version\": 2,",
+      "\"System-Identifier\": 7412345678901234567,",
+      "\"Files\": [",
+      "{ \"Path\": \"global/pg_control\", \"Size\": 8192, \"Last-Modified\": \"2026-10-19 10:00:00 GMT\", \"Checksum-Algorithm\": \"CRC32C\", \"Checksum\": \"aaaa\" },",
+      "{ \"Path\": \"base/1/INCREMENTAL.1259\", \"Size\": 40, \"Last-Modified\": \"2026-10-19 10:00:00 GMT\", \"Checksum-Algorithm\": \"CRC32C\", \"Checksum\": \"bbbb\" }",
+      "],",
+      "\"WAL-Ranges\": [",
+      "{ \"Timeline\": 1, \"Start-LSN\": \"0/2000028\", \"End-LSN\": \"0/2000120\" }",
+      "],",
+      "\"Manifest-Checksum\": \"cccc\"}"};
+   struct json* files = NULL;
+   struct json* f = NULL;
+   struct json* manifest = NULL;
+   struct json* entries = NULL;
+   struct json* ranges = NULL;
+   struct json_iterator* iter = NULL;
+   int count = 0;
+
+   pgmoneta_snprintf(source, sizeof(source), "%s/source.manifest", TEST_BASE_DIR);
+   pgmoneta_snprintf(combined, sizeof(combined), "%s/combined.manifest", TEST_BASE_DIR);
+
+   MCTF_ASSERT(write_manifest(source, rows, 10) == 0, cleanup, "writing the source manifest should succeed");
+
+   MCTF_ASSERT(pgmoneta_json_create_array(false, &files) == 0, cleanup, "files should be created");
+   pgmoneta_json_create(&f);
+   pgmoneta_json_put(f, "Path", (uintptr_t)"base/1/1259", ValueString);
+   pgmoneta_json_put(f, "Size", 16384, ValueInt64);
+   pgmoneta_json_put(f, "Last-Modified", (uintptr_t)"2026-10-19 10:00:00 GMT", ValueString);
+   pgmoneta_json_put(f, "Checksum-Algorithm", (uintptr_t)"CRC32C", ValueString);
+   pgmoneta_json_put(f, "Checksum", (uintptr_t)"dddd", ValueString);
+   pgmoneta_json_append(files, (uintptr_t)f, ValueJSON);
+
+   MCTF_ASSERT(pgmoneta_write_combined_manifest(source, files, combined) == 0, cleanup, "writing the combined manifest should succeed");
+   MCTF_ASSERT(pgmoneta_json_read_file(combined, &manifest) == 0, cleanup, "the combined manifest should be valid json");
+
+   MCTF_ASSERT_INT_EQ((int)pgmoneta_json_get(manifest, "PostgreSQL-Backup-Manifest-Version"), 2, cleanup, "the version should be kept");
+   MCTF_ASSERT((uint64_t)pgmoneta_json_get(manifest, "System-Identifier") == 7412345678901234567ULL, cleanup, "the system identifier should be kept");
+
+   ranges = (struct json*)pgmoneta_json_get(manifest, "WAL-Ranges");
+   MCTF_ASSERT_INT_EQ((int)pgmoneta_json_array_length(ranges), 1, cleanup, "the WAL range should be kept");
+
+   entries = (struct json*)pgmoneta_json_get(manifest, "Files");
+   MCTF_ASSERT_INT_EQ((int)pgmoneta_json_array_length(entries), 2, cleanup, "the incremental file should be replaced");
+
+   pgmoneta_json_iterator_create(entries, &iter);
+   while (pgmoneta_json_iterator_next(iter))
+   {
+      char* path = (char*)pgmoneta_json_get((struct json*)pgmoneta_value_data(iter->value), "Path");
+      MCTF_ASSERT(!pgmoneta_is_incremental_path(path), cleanup, "no incremental file should be left");
+      count++;
+   }
+   MCTF_ASSERT_INT_EQ(count, 2, cleanup, "both files should be listed");
+
+cleanup:
+   pgmoneta_json_iterator_destroy(iter);
+   pgmoneta_json_destroy(manifest);
+   pgmoneta_json_destroy(files);
+   remove(source);
+   remove(combined);
+   MCTF_FINISH();
+}
+
+/**
+ * Benchmark: compare two manifests with 1M entries each.
+ */
+MCTF_TEST_MAX(test_manifest_compare_benchmark, 300)
+{
+   char old_manifest[MAX_PATH];
+   char new_manifest[MAX_PATH];
+   FILE* o = NULL;
+   FILE* n = NULL;
+   struct art* deleted = NULL;
+   struct art* changed = NULL;
+   struct art* added = NULL;
+   struct timespec start_t;
+   struct timespec end_t;
+   int expected_deleted = 0;
+   int expected_added = 0;
+   int expected_changed = 0;
+   int j;
+
+   pgmoneta_snprintf(old_manifest, sizeof(old_manifest), "%s/old_benchmark.manifest", TEST_BASE_DIR);
+   pgmoneta_snprintf(new_manifest, sizeof(new_manifest), "%s/new_benchmark.manifest", TEST_BASE_DIR);
+
+   o = fopen(old_manifest, "w");
+   n = fopen(new_manifest, "w");
+   MCTF_ASSERT(o != NULL && n != NULL, cleanup, "manifests should be created");
+
+   // unsorted input, one percent each of deleted, added and changed files
+   for (int i = 0; i < MANIFEST_BENCHMARK_ENTRIES; i++)
+   {
+      j = (int)(((long)i * 1000003) % MANIFEST_BENCHMARK_ENTRIES);
+
+      switch (i % 100)
+      {
+         case 0:
+            fprintf(o, "base/%d/%d,%08x\n", j % 7, j, j);
+            expected_deleted++;
+            break;
+         case 1:
+            fprintf(n, "base/%d/%d,%08x\n", j % 7, j, j);
+            expected_added++;
+            break;
+         case 2:
+            fprintf(o, "base/%d/%d,%08x\n", j % 7, j, j);
+            fprintf(n, "base/%d/%d,%08x\n", j % 7, j, j + 1);
+            expected_changed++;
+            break;
+         default:
+            fprintf(o, "base/%d/%d,%08x\n", j % 7, j, j);
+            fprintf(n, "base/%d/%d,%08x\n", j % 7, j, j);
+            break;
+      }
+   }
+   fclose(o);
+   fclose(n);
+   o = NULL;
+   n = NULL;
+
+   clock_gettime(CLOCK_MONOTONIC, &start_t);
+   MCTF_ASSERT(pgmoneta_compare_manifests(old_manifest, new_manifest, &deleted, &changed, &added) == 0, cleanup, "compare should succeed");
+   clock_gettime(CLOCK_MONOTONIC, &end_t);
+
+   pgmoneta_log_info("compare of unsorted manifests with %d entries: %.3f seconds",
+                     MANIFEST_BENCHMARK_ENTRIES, pgmoneta_compute_duration(start_t, end_t));
+
+   MCTF_ASSERT_INT_EQ((int)deleted->size, expected_deleted, cleanup, "deleted files");
+   MCTF_ASSERT_INT_EQ((int)added->size, expected_added, cleanup, "added files");
+   MCTF_ASSERT_INT_EQ((int)changed->size, expected_changed + 1, cleanup, "changed files");
+
+   pgmoneta_art_destroy(deleted);
+   pgmoneta_art_destroy(changed);
+   pgmoneta_art_destroy(added);
+   deleted = NULL;
+   changed = NULL;
+   added = NULL;
+
+   MCTF_ASSERT(pgmoneta_manifest_sort(old_manifest) == 0, cleanup, "sort should succeed");
+   MCTF_ASSERT(pgmoneta_manifest_sort(new_manifest) == 0, cleanup, "sort should succeed");
+
+   clock_gettime(CLOCK_MONOTONIC, &start_t);
+   MCTF_ASSERT(pgmoneta_compare_manifests(old_manifest, new_manifest, &deleted, &changed, &added) == 0, cleanup, "compare should succeed");
+   clock_gettime(CLOCK_MONOTONIC, &end_t);
+
+   pgmoneta_log_info("compare of sorted manifests with %d entries: %.3f seconds",
+                     MANIFEST_BENCHMARK_ENTRIES, pgmoneta_compute_duration(start_t, end_t));
+
+   MCTF_ASSERT_INT_EQ((int)changed->size, expected_changed + 1, cleanup, "changed files");
+
+cleanup:
+   if (o != NULL)
+   {
+      fclose(o);
+   }
+   if (n != NULL)
+   {
+      fclose(n);
+   }
+   pgmoneta_art_destroy(deleted);
+   pgmoneta_art_destroy(changed);
+   pgmoneta_art_destroy(added);
+   remove(old_manifest);
+   remove(new_manifest);
+   MCTF_FINISH();
+}
@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2026 The pgmoneta community
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or other
+ * materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may
+ * be used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <pgmoneta.h>
+#include <art.h>
+#include <memory.h>
+#include <tscommon.h>
+#include <mctf.h>
+#include <utils.h>
+#include <value.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+MCTF_TEST(test_memory_region_alloc)
+{
+   struct region* region = NULL;
+   char* s = NULL;
+   void* p = NULL;
+   void* big = NULL;
+
+   pgmoneta_test_setup();
+
+   MCTF_ASSERT(!pgmoneta_memory_region_create(1024, &region), cleanup, "region creation failed");
+   MCTF_ASSERT_PTR_NULL(pgmoneta_memory_region_alloc(NULL, 16), cleanup, "allocation without region should fail");
+
+   for (int i = 0; i < 1000; i++)
+   {
+      p = pgmoneta_memory_region_alloc(region, 1 + i % 37);
+      MCTF_ASSERT_PTR_NONNULL(p, cleanup, "allocation failed");
+      MCTF_ASSERT_INT_EQ((uintptr_t)p % 16, 0, cleanup, "allocation is not aligned");
+      memset(p, 0xAB, 1 + i % 37);
+   }
+
+   // larger than a block
+   big = pgmoneta_memory_region_alloc(region, 10000);
+   MCTF_ASSERT_PTR_NONNULL(big, cleanup, "large allocation failed");
+   memset(big, 0xCD, 10000);
+   p = pgmoneta_memory_region_alloc(region, 8);
+   MCTF_ASSERT_PTR_NONNULL(p, cleanup, "allocation after large allocation failed");
+
+   s = pgmoneta_memory_region_strdup(region, "base/");
+   MCTF_ASSERT_STR_EQ(s, "base/", cleanup, "strdup mismatch");
+   s = pgmoneta_memory_region_append(region, s, "16384");
+   MCTF_ASSERT_STR_EQ(s, "base/16384", cleanup, "append mismatch");
+   s = pgmoneta_memory_region_append(region, NULL, "");
+   MCTF_ASSERT_STR_EQ(s, "", cleanup, "empty append mismatch");
+   s = pgmoneta_memory_region_format(region, "%s/%d_%s", "base", 1, "vm");
+   MCTF_ASSERT_STR_EQ(s, "base/1_vm", cleanup, "format mismatch");
+
+#ifdef DEBUG
+   MCTF_ASSERT_INT_EQ(region->allocations, 1006, cleanup, "allocation count mismatch");
+#endif
+
+   pgmoneta_memory_region_reset(region);
+   MCTF_ASSERT_PTR_NULL(region->blocks, cleanup, "reset should release the blocks");
+   s = pgmoneta_memory_region_strdup(region, "again");
+   MCTF_ASSERT_STR_EQ(s, "again", cleanup, "strdup after reset mismatch");
+
+cleanup:
+   pgmoneta_memory_region_destroy(region);
+   pgmoneta_test_teardown();
+   MCTF_FINISH();
+}
+
+MCTF_TEST(test_memory_region_art)
+{
+   struct art* nodes = NULL;
+   struct region* region = NULL;
+   char key[32];
+   char* value = NULL;
+
+   pgmoneta_test_setup();
+
+   MCTF_ASSERT(!pgmoneta_memory_region_create(0, &region), cleanup, "region creation failed");
+   MCTF_ASSERT(!pgmoneta_art_create(&nodes), cleanup, "art creation failed");
+
+   // the tree only keeps references, the region owns the strings
+   for (int i = 0; i < 1000; i++)
+   {
+      pgmoneta_snprintf(key, sizeof(key), "key%d", i);
+      value = pgmoneta_memory_region_format(region, "value%d", i);
+      MCTF_ASSERT(!pgmoneta_art_insert(nodes, key, (uintptr_t)value, ValueStringRef), cleanup, "insert failed");
+   }
+
+   MCTF_ASSERT_STR_EQ((char*)pgmoneta_art_search(nodes, "key42"), "value42", cleanup, "search mismatch");
+   MCTF_ASSERT_STR_EQ((char*)pgmoneta_art_search(nodes, "key999"), "value999", cleanup, "search mismatch");
+
+cleanup:
+   pgmoneta_art_destroy(nodes);
+   pgmoneta_memory_region_destroy(region);
+   pgmoneta_test_teardown();
+   MCTF_FINISH();
+}
@@ -0,0 +1,350 @@
+/*
+ * Copyright (C) 2026 The pgmoneta community
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or other
+ * materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may
+ * be used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <pgmoneta.h>
+#include <logging.h>
+#include <memory.h>
+#include <message.h>
+#include <tscommon.h>
+#include <mctf.h>
+#include <utils.h>
+
+#include <inttypes.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#define TEST_MESSAGE_PAYLOAD 8192
+
+static int test_message_stream(int count, size_t payload, pid_t* pid);
+static size_t test_message_copy_data(char* data, int seq, size_t payload);
+static bool test_message_verify(struct message* msg, int seq, size_t payload);
+
+MCTF_TEST(test_message_copy_stream)
+{
+   struct main_configuration* config = NULL;
+   struct stream_buffer* buffer = NULL;
+   struct message* msg = NULL;
+   size_t sizes[] = {1, 100, TEST_MESSAGE_PAYLOAD, 3 * DEFAULT_BUFFER_SIZE, 17};
+   bool running = false;
+   bool online = false;
+   int count = 100;
+   int socket = -1;
+   int seq = 0;
+   pid_t pid = -1;
+
+   pgmoneta_test_setup();
+
+   config = (struct main_configuration*)shmem;
+   running = config->running;
+   online = config->common.servers[0].online;
+   config->running = true;
+   config->common.servers[0].online = true;
+
+   pgmoneta_memory_stream_buffer_init(&buffer);
+   MCTF_ASSERT_PTR_NONNULL(buffer, cleanup, "stream buffer creation failed");
+
+   msg = (struct message*)malloc(sizeof(struct message));
+   MCTF_ASSERT_PTR_NONNULL(msg, cleanup, "message creation failed");
+   memset(msg, 0, sizeof(struct message));
+
+   // the sizes cycle through a message larger than the buffer
+   for (int s = 0; s < (int)(sizeof(sizes) / sizeof(sizes[0])); s++)
+   {
+      socket = test_message_stream(count, sizes[s], &pid);
+      MCTF_ASSERT(socket != -1, cleanup, "stream creation failed");
+
+      seq = 0;
+      while (msg->kind != 'c')
+      {
+         MCTF_ASSERT_INT_EQ(pgmoneta_consume_copy_stream_start(0, NULL, socket, buffer, msg), MESSAGE_STATUS_OK, cleanup, "consume failed");
+         MCTF_ASSERT(msg->kind != 'N', cleanup, "notice should be skipped");
+         if (msg->kind == 'd')
+         {
+            MCTF_ASSERT(test_message_verify(msg, seq, sizes[s]), cleanup, "payload %d mismatch for size %zu", seq, sizes[s]);
+            // the message is a view into the stream buffer
+            MCTF_ASSERT((char*)msg->data > buffer->buffer && (char*)msg->data < buffer->buffer + buffer->end, cleanup, "message is not a view");
+            seq++;
+         }
+         pgmoneta_consume_copy_stream_end(buffer, msg);
+      }
+      MCTF_ASSERT_INT_EQ(seq, count, cleanup, "message count mismatch for size %zu", sizes[s]);
+      MCTF_ASSERT_INT_EQ(buffer->start, buffer->cursor, cleanup, "buffer not consumed");
+
+      msg->kind = 0;
+      close(socket);
+      socket = -1;
+      waitpid(pid, NULL, 0);
+      pid = -1;
+   }
+
+cleanup:
+   if (socket != -1)
+   {
+      close(socket);
+   }
+   if (pid > 0)
+   {
+      kill(pid, SIGKILL);
+      waitpid(pid, NULL, 0);
+   }
+   free(msg);
+   pgmoneta_memory_stream_buffer_free(buffer);
+   if (config != NULL)
+   {
+      config->running = running;
+      config->common.servers[0].online = online;
+   }
+   pgmoneta_test_teardown();
+   MCTF_FINISH();
+}
+
+MCTF_TEST_MAX(test_message_copy_stream_benchmark, 300)
+{
+   struct main_configuration* config = NULL;
+   struct stream_buffer* buffer = NULL;
+   struct message* msg = NULL;
+   struct timespec start_t;
+   struct timespec end_t;
+   double duration[2];
+   bool running = false;
+   bool online = false;
+   int count = 32768;
+   int socket = -1;
+   int seq = 0;
+   pid_t pid = -1;
+
+   pgmoneta_test_setup();
+
+   config = (struct main_configuration*)shmem;
+   running = config->running;
+   online = config->common.servers[0].online;
+   config->running = true;
+   config->common.servers[0].online = true;
+
+   // a copy per message first, then the in-place message views
+   for (int r = 0; r < 2; r++)
+   {
+      pgmoneta_memory_stream_buffer_init(&buffer);
+      MCTF_ASSERT_PTR_NONNULL(buffer, cleanup, "stream buffer creation failed");
+
+      if (r == 1)
+      {
+         msg = (struct message*)malloc(sizeof(struct message));
+         MCTF_ASSERT_PTR_NONNULL(msg, cleanup, "message creation failed");
+         memset(msg, 0, sizeof(struct message));
+      }
+
+      socket = test_message_stream(count, TEST_MESSAGE_PAYLOAD, &pid);
+      MCTF_ASSERT(socket != -1, cleanup, "stream creation failed");
+
+      seq = 0;
+      clock_gettime(CLOCK_MONOTONIC, &start_t);
+      while (msg == NULL || msg->kind != 'c')
+      {
+         if (r == 0)
+         {
+            MCTF_ASSERT_INT_EQ(pgmoneta_consume_copy_stream(0, NULL, socket, buffer, &msg), MESSAGE_STATUS_OK, cleanup, "consume failed");
+            seq += msg->kind == 'd';
+         }
+         else
+         {
+            MCTF_ASSERT_INT_EQ(pgmoneta_consume_copy_stream_start(0, NULL, socket, buffer, msg), MESSAGE_STATUS_OK, cleanup, "consume failed");
+            seq += msg->kind == 'd';
+            pgmoneta_consume_copy_stream_end(buffer, msg);
+         }
+      }
+      clock_gettime(CLOCK_MONOTONIC, &end_t);
+      duration[r] = pgmoneta_compute_duration(start_t, end_t);
+      MCTF_ASSERT_INT_EQ(seq, count, cleanup, "message count mismatch");
+
+      if (r == 0)
+      {
+         pgmoneta_free_message(msg);
+      }
+      else
+      {
+         free(msg);
+      }
+      msg = NULL;
+      pgmoneta_memory_stream_buffer_free(buffer);
+      buffer = NULL;
+      close(socket);
+      socket = -1;
+      waitpid(pid, NULL, 0);
+      pid = -1;
+   }
+
+   pgmoneta_log_info("copy stream %d x %d bytes: copied %.3fs (%.1f MB/s), in place %.3fs (%.1f MB/s)",
+                     count, TEST_MESSAGE_PAYLOAD,
+                     duration[0], (double)count * TEST_MESSAGE_PAYLOAD / (1024.0 * 1024.0) / duration[0],
+                     duration[1], (double)count * TEST_MESSAGE_PAYLOAD / (1024.0 * 1024.0) / duration[1]);
+
+cleanup:
+   if (socket != -1)
+   {
+      close(socket);
+   }
+   if (pid > 0)
+   {
+      kill(pid, SIGKILL);
+      waitpid(pid, NULL, 0);
+   }
+   free(msg);
+   pgmoneta_memory_stream_buffer_free(buffer);
+   if (config != NULL)
+   {
+      config->running = running;
+      config->common.servers[0].online = online;
+   }
+   pgmoneta_test_teardown();
+   MCTF_FINISH();
+}
+
+/**
+ * Fork a writer sending a CopyOutResponse, a NoticeResponse, count
+ * CopyData messages and a CopyDone
+ * @param count The number of CopyData messages
+ * @param payload The size of a CopyData payload
+ * @param pid [out] The writer
+ * @return The socket to read from, otherwise -1
+ */
+static int
+test_message_stream(int count, size_t payload, pid_t* pid)
+{
+   int fds[2];
+   char* data = NULL;
+   size_t length = 0;
+   size_t offset = 0;
+   ssize_t numbytes = 0;
+   char header[] = {'H', 0, 0, 0, 7, 0, 0, 0, 'N', 0, 0, 0, 5, 'x'};
+   char done[] = {'c', 0, 0, 0, 4};
+
+   *pid = -1;
+
+   if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds))
+   {
+      return -1;
+   }
+
+   *pid = fork();
+   if (*pid == -1)
+   {
+      close(fds[0]);
+      close(fds[1]);
+      return -1;
+   }
+
+   if (*pid > 0)
+   {
+      close(fds[1]);
+      return fds[0];
+   }
+
+   close(fds[0]);
+
+   data = malloc(sizeof(header) + 1 + 4 + payload);
+   if (data == NULL)
+   {
+      _exit(1);
+   }
+
+   for (int i = -1; i <= count; i++)
+   {
+      if (i == -1)
+      {
+         memcpy(data, header, sizeof(header));
+         length = sizeof(header);
+      }
+      else if (i == count)
+      {
+         memcpy(data, done, sizeof(done));
+         length = sizeof(done);
+      }
+      else
+      {
+         length = test_message_copy_data(data, i, payload);
+      }
+
+      offset = 0;
+      while (offset < length)
+      {
+         numbytes = write(fds[1], data + offset, length - offset);
+         if (numbytes <= 0)
+         {
+            _exit(1);
+         }
+         offset += numbytes;
+      }
+   }
+
+   free(data);
+   close(fds[1]);
+   _exit(0);
+}
+
+static size_t
+test_message_copy_data(char* data, int seq, size_t payload)
+{
+   pgmoneta_write_byte(data, 'd');
+   pgmoneta_write_int32(data + 1, (int32_t)(payload + 4));
+   for (size_t i = 0; i < payload; i++)
+   {
+      data[5 + i] = (char)((seq + i) & 0xFF);
+   }
+
+   return 1 + 4 + payload;
+}
+
+static bool
+test_message_verify(struct message* msg, int seq, size_t payload)
+{
+   char* data = (char*)msg->data;
+
+   if (msg->length != (ssize_t)payload)
+   {
+      return false;
+   }
+
+   for (size_t i = 0; i < payload; i++)
+   {
+      if (data[i] != (char)((seq + i) & 0xFF))
+      {
+         return false;
+      }
+   }
+
+   return true;
+}
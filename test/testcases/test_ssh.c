@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2026 The pgmoneta community
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or other
+ * materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may
+ * be used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <pgmoneta.h>
+#include <art.h>
+#include <mctf.h>
+#include <storage.h>
+#include <tscommon.h>
+#include <utils.h>
+#include <workflow.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+MCTF_TEST_SETUP(ssh)
+{
+   pgmoneta_test_config_save();
+}
+
+MCTF_TEST_TEARDOWN(ssh)
+{
+   pgmoneta_test_config_restore();
+}
+
+MCTF_TEST(test_ssh_inflight)
+{
+   struct main_configuration* config;
+
+   /* conf/01: ssh_inflight = 4 */
+   MCTF_ASSERT_INT_EQ(pgmoneta_test_load_conf(TEST_CONF_DIR "/ssh/01.conf"), 0,
+                      cleanup, "failed to read 01.conf");
+   config = (struct main_configuration*)shmem;
+   MCTF_ASSERT_INT_EQ(config->ssh_inflight, 4, cleanup, "01.conf: ssh_inflight should be 4");
+
+   /* conf/02: ssh_inflight is not set */
+   MCTF_ASSERT_INT_EQ(pgmoneta_test_load_conf(TEST_CONF_DIR "/ssh/02.conf"), 0,
+                      cleanup, "failed to read 02.conf");
+   config = (struct main_configuration*)shmem;
+   MCTF_ASSERT_INT_EQ(config->ssh_inflight, 16, cleanup, "02.conf: ssh_inflight should default to 16");
+
+cleanup:
+   MCTF_FINISH();
+}
+
+MCTF_TEST(test_ssh_setup_unreachable)
+{
+   struct art* nodes = NULL;
+   struct workflow* wf = NULL;
+   struct main_configuration* config;
+
+   config = (struct main_configuration*)shmem;
+
+   /* The .invalid domain never resolves, so the connection fails before any transfer is set up */
+   pgmoneta_snprintf(config->ssh_hostname, sizeof(config->ssh_hostname), "%s", "pgmoneta.invalid");
+   pgmoneta_snprintf(config->ssh_username, sizeof(config->ssh_username), "%s", "pgmoneta");
+   config->ssh_inflight = 4;
+
+   MCTF_ASSERT(!pgmoneta_art_create(&nodes), cleanup, "Failed to create nodes");
+   pgmoneta_art_insert(nodes, NODE_SERVER_ID, (uintptr_t)PRIMARY_SERVER, ValueInt32);
+   pgmoneta_art_insert(nodes, NODE_LABEL, (uintptr_t)"20991231235956", ValueString);
+
+   for (int i = 0; i < 2; i++)
+   {
+      wf = pgmoneta_storage_create_ssh(i == 0 ? WORKFLOW_TYPE_BACKUP : WORKFLOW_TYPE_WAL_SHIPPING);
+      MCTF_ASSERT_PTR_NONNULL(wf, cleanup, "Failed to create the SSH storage engine");
+      MCTF_ASSERT_STR_EQ(wf->name(), "SSH", cleanup, "unexpected storage engine name");
+      MCTF_ASSERT(wf->setup(wf->name(), nodes) != 0, cleanup, "setup should fail for an unreachable host");
+
+      pgmoneta_workflow_destroy(wf);
+      wf = NULL;
+   }
+
+cleanup:
+   pgmoneta_workflow_destroy(wf);
+   pgmoneta_art_destroy(nodes);
+   MCTF_FINISH();
+}
@@ -28,9 +28,11 @@
  */
 
 #include <pgmoneta.h>
+#include <art.h>
 #include <logging.h>
 #include <tscommon.h>
 #include <mctf.h>
+#include <security.h>
 #include <utils.h>
 #include <stream.h>
 
@@ -141,6 +143,168 @@ cleanup:
    MCTF_FINISH();
 }
 
+MCTF_TEST(test_stream_file_digests)
+{
+   char* dir = NULL;
+   char* from = NULL;
+   char* to = NULL;
+   char* sha512 = NULL;
+   char cmd[MAX_PATH * 2] = {0};
+   char buf[DEFAULT_BUFFER_SIZE] = {0};
+   struct stream_digests digests;
+   FILE* f = NULL;
+   size_t n = 0;
+   uint32_t crc = 0;
+
+   dir = pgmoneta_append(dir, TEST_BASE_DIR);
+   dir = pgmoneta_append(dir, "/stream_digests");
+   from = pgmoneta_append(from, dir);
+   from = pgmoneta_append(from, "/file.txt");
+   to = pgmoneta_append(to, from);
+   to = pgmoneta_append(to, ".gz.aes");
+
+   pgmoneta_mkdir(dir);
+   pgmoneta_snprintf(cmd, sizeof(cmd), "seq 1 200000 > %s", from);
+   system(cmd);
+   MCTF_ASSERT(pgmoneta_exists(from), cleanup, "Failed to create %s", from);
+
+   memset(&digests, 0, sizeof(struct stream_digests));
+   MCTF_ASSERT(!pgmoneta_stream_file(from, to, COMPRESSION_CLIENT_GZIP, ENCRYPTION_AES_256_GCM, &digests), cleanup, "Failed to stream %s", from);
+   MCTF_ASSERT(!pgmoneta_exists(from), cleanup, "Source %s not removed", from);
+   MCTF_ASSERT(pgmoneta_exists(to), cleanup, "Destination %s not created", to);
+
+   /* All digests describe the written file */
+   MCTF_ASSERT_INT_EQ(digests.size, pgmoneta_get_file_size(to), cleanup, "size mismatch");
+
+   MCTF_ASSERT(!pgmoneta_create_sha512_file(to, &sha512), cleanup, "Failed to hash %s", to);
+   MCTF_ASSERT_STR_EQ(digests.sha512, sha512, cleanup, "sha512 mismatch");
+
+   f = fopen(to, "rb");
+   MCTF_ASSERT_PTR_NONNULL(f, cleanup, "Failed to open %s", to);
+   pgmoneta_init_crc32c(&crc);
+   while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+   {
+      pgmoneta_create_crc32c_buffer(buf, n, &crc);
+   }
+   pgmoneta_finalize_crc32c(&crc);
+   MCTF_ASSERT_INT_EQ(digests.crc32c, crc, cleanup, "crc32c mismatch");
+
+cleanup:
+   if (f != NULL)
+   {
+      fclose(f);
+   }
+   pgmoneta_delete_directory(dir);
+   free(sha512);
+   free(dir);
+   free(from);
+   free(to);
+   MCTF_FINISH();
+}
+
+MCTF_TEST(test_stream_directory_digests)
+{
+   char* dir = NULL;
+   char* sha512 = NULL;
+   char path[MAX_PATH] = {0};
+   char cmd[MAX_PATH * 2] = {0};
+   struct art* map = NULL;
+   struct stream_digests* d = NULL;
+
+   dir = pgmoneta_append(dir, TEST_BASE_DIR);
+   dir = pgmoneta_append(dir, "/stream_directory_digests");
+
+   pgmoneta_snprintf(path, sizeof(path), "%s/sub", dir);
+   pgmoneta_mkdir(path);
+   pgmoneta_snprintf(cmd, sizeof(cmd), "seq 1 1000 > %s/a && seq 1 5000 > %s/sub/b", dir, dir);
+   system(cmd);
+
+   MCTF_ASSERT(!pgmoneta_art_create(&map), cleanup, "Failed to create map");
+   MCTF_ASSERT(!pgmoneta_stream_directory(-1, dir, COMPRESSION_CLIENT_GZIP, ENCRYPTION_NONE, NULL, NULL, map), cleanup, "Failed to stream %s", dir);
+
+   pgmoneta_snprintf(path, sizeof(path), "%s/a.gz", dir);
+   d = pgmoneta_stream_digests_get(map, path);
+   MCTF_ASSERT_PTR_NONNULL(d, cleanup, "No digests for %s", path);
+   MCTF_ASSERT_INT_EQ(d->size, pgmoneta_get_file_size(path), cleanup, "size mismatch for %s", path);
+   MCTF_ASSERT(!pgmoneta_create_sha512_file(path, &sha512), cleanup, "Failed to hash %s", path);
+   MCTF_ASSERT_STR_EQ(d->sha512, sha512, cleanup, "sha512 mismatch for %s", path);
+   free(sha512);
+   sha512 = NULL;
+
+   pgmoneta_snprintf(path, sizeof(path), "%s/sub/b.gz", dir);
+   d = pgmoneta_stream_digests_get(map, path);
+   MCTF_ASSERT_PTR_NONNULL(d, cleanup, "No digests for %s", path);
+   MCTF_ASSERT(!pgmoneta_create_sha512_file(path, &sha512), cleanup, "Failed to hash %s", path);
+   MCTF_ASSERT_STR_EQ(d->sha512, sha512, cleanup, "sha512 mismatch for %s", path);
+
+cleanup:
+   pgmoneta_art_destroy(map);
+   pgmoneta_delete_directory(dir);
+   free(sha512);
+   free(dir);
+   MCTF_FINISH();
+}
+
+MCTF_TEST(test_stream_digests_rewrite)
+{
+   char* dir = NULL;
+   char path[MAX_PATH] = {0};
+   char other[MAX_PATH] = {0};
+   struct art* map = NULL;
+   struct stream_digests digests;
+   FILE* f = NULL;
+
+   dir = pgmoneta_append(dir, TEST_BASE_DIR);
+   dir = pgmoneta_append(dir, "/stream_digests_rewrite");
+   pgmoneta_mkdir(dir);
+
+   pgmoneta_snprintf(path, sizeof(path), "%s/file", dir);
+   pgmoneta_snprintf(other, sizeof(other), "%s/other", dir);
+
+   f = fopen(path, "wb");
+   MCTF_ASSERT_PTR_NONNULL(f, cleanup, "Failed to create %s", path);
+   fputs("0123456789", f);
+   fclose(f);
+   f = NULL;
+
+   MCTF_ASSERT(!pgmoneta_art_create(&map), cleanup, "Failed to create map");
+
+   memset(&digests, 0, sizeof(struct stream_digests));
+   digests.size = 10;
+   MCTF_ASSERT(!pgmoneta_stream_digests_add(map, path, &digests), cleanup, "Failed to add digests for %s", path);
+   MCTF_ASSERT_PTR_NONNULL(pgmoneta_stream_digests_get(map, path), cleanup, "Expected a hit for %s", path);
+
+   /* Rewrite in place with the same size, only the modification time changes */
+   SLEEP(20000000L);
+   f = fopen(path, "r+b");
+   MCTF_ASSERT_PTR_NONNULL(f, cleanup, "Failed to open %s", path);
+   fputs("9876543210", f);
+   fclose(f);
+   f = NULL;
+   MCTF_ASSERT_PTR_NULL(pgmoneta_stream_digests_get(map, path), cleanup, "Expected a miss after rewrite of %s", path);
+
+   /* Replace with a file of the same size, the inode changes */
+   MCTF_ASSERT(!pgmoneta_stream_digests_add(map, path, &digests), cleanup, "Failed to add digests for %s", path);
+   MCTF_ASSERT_PTR_NONNULL(pgmoneta_stream_digests_get(map, path), cleanup, "Expected a hit for %s", path);
+   f = fopen(other, "wb");
+   MCTF_ASSERT_PTR_NONNULL(f, cleanup, "Failed to create %s", other);
+   fputs("0123456789", f);
+   fclose(f);
+   f = NULL;
+   MCTF_ASSERT(!rename(other, path), cleanup, "Failed to replace %s", path);
+   MCTF_ASSERT_PTR_NULL(pgmoneta_stream_digests_get(map, path), cleanup, "Expected a miss after replace of %s", path);
+
+cleanup:
+   if (f != NULL)
+   {
+      fclose(f);
+   }
+   pgmoneta_art_destroy(map);
+   pgmoneta_delete_directory(dir);
+   free(dir);
+   MCTF_FINISH();
+}
+
 static char*
 translate_compression(int compression)
 {
@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2026 The pgmoneta community
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or other
+ * materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may
+ * be used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <pgmoneta.h>
+#include <mctf.h>
+#include <shmem.h>
+#include <throttle.h>
+#include <tscommon.h>
+#include <utils.h>
+
+#include <stdatomic.h>
+#include <string.h>
+#include <time.h>
+
+static bool shmem_allocated = false;
+
+MCTF_MODULE_SETUP(throttle)
+{
+   if (shmem == NULL)
+   {
+      pgmoneta_create_shared_memory(sizeof(struct main_configuration), HUGEPAGE_OFF, &shmem);
+      memset(shmem, 0, sizeof(struct main_configuration));
+      shmem_allocated = true;
+   }
+}
+
+MCTF_MODULE_TEARDOWN(throttle)
+{
+   if (shmem_allocated && shmem != NULL)
+   {
+      pgmoneta_destroy_shared_memory(shmem, sizeof(struct main_configuration));
+      shmem = NULL;
+      shmem_allocated = false;
+   }
+}
+
+MCTF_TEST_SETUP(throttle)
+{
+   pgmoneta_test_config_save();
+}
+
+MCTF_TEST_TEARDOWN(throttle)
+{
+   pgmoneta_test_config_restore();
+}
+
+MCTF_TEST(test_throttle_disabled)
+{
+   struct main_configuration* config;
+
+   config = (struct main_configuration*)shmem;
+   config->io_max_rate = 0;
+   config->io_max_iops = 0;
+   pgmoneta_throttle_init(&config->throttle);
+
+   MCTF_ASSERT(!pgmoneta_throttle_enabled(), cleanup, "throttle should be disabled");
+
+   pgmoneta_throttle(THROTTLE_DELETE, 1024 * 1024 * 1024);
+   MCTF_ASSERT_INT_EQ(atomic_load(&config->throttle.waited[THROTTLE_DELETE]), 0, cleanup, "disabled throttle waited");
+
+cleanup:
+   MCTF_FINISH();
+}
+
+MCTF_TEST(test_throttle_priority)
+{
+   struct timespec start_t;
+   struct timespec end_t;
+   double elapsed;
+   struct main_configuration* config;
+
+   config = (struct main_configuration*)shmem;
+   config->io_max_rate = 4 * 1024 * 1024;
+   config->io_max_iops = 0;
+   pgmoneta_throttle_init(&config->throttle);
+
+   MCTF_ASSERT(pgmoneta_throttle_enabled(), cleanup, "throttle should be enabled");
+
+   /* WAL drains the bucket but never waits */
+   clock_gettime(CLOCK_MONOTONIC, &start_t);
+   pgmoneta_throttle(THROTTLE_WAL, 4 * 1024 * 1024);
+   pgmoneta_throttle(THROTTLE_WAL, 1024 * 1024);
+   clock_gettime(CLOCK_MONOTONIC, &end_t);
+
+   elapsed = pgmoneta_compute_duration(start_t, end_t);
+   MCTF_ASSERT(elapsed < 0.1, cleanup, "WAL was throttled");
+   MCTF_ASSERT_INT_EQ(atomic_load(&config->throttle.waited[THROTTLE_WAL]), 0, cleanup, "WAL waited");
+
+   /* A backup waits until the bucket refills above the share kept for WAL */
+   clock_gettime(CLOCK_MONOTONIC, &start_t);
+   pgmoneta_throttle(THROTTLE_BACKUP, 1024);
+   clock_gettime(CLOCK_MONOTONIC, &end_t);
+
+   elapsed = pgmoneta_compute_duration(start_t, end_t);
+   MCTF_ASSERT(elapsed > 0.5, cleanup, "backup was not throttled");
+   MCTF_ASSERT(atomic_load(&config->throttle.waited[THROTTLE_BACKUP]) > 0, cleanup, "backup did not wait");
+
+cleanup:
+   MCTF_FINISH();
+}
+
+MCTF_TEST(test_throttle_debt)
+{
+   long long tokens;
+   long long rate = 4 * 1024 * 1024;
+   struct timespec start_t;
+   struct timespec end_t;
+   double elapsed;
+   struct main_configuration* config;
+
+   config = (struct main_configuration*)shmem;
+   config->io_max_rate = rate;
+   config->io_max_iops = 0;
+   pgmoneta_throttle_init(&config->throttle);
+
+   /* A request of two buckets waits for the second one, and leaves at most a slice of debt */
+   clock_gettime(CLOCK_MONOTONIC, &start_t);
+   pgmoneta_throttle(THROTTLE_VERIFY, 2 * rate);
+   clock_gettime(CLOCK_MONOTONIC, &end_t);
+
+   elapsed = pgmoneta_compute_duration(start_t, end_t);
+   tokens = atomic_load(&config->throttle.bytes.tokens);
+
+   MCTF_ASSERT(elapsed > 0.5, cleanup, "large request was not throttled");
+   MCTF_ASSERT(tokens >= -(rate / 10), cleanup, "large request left a debt of %lld bytes", -tokens);
+
+cleanup:
+   MCTF_FINISH();
+}
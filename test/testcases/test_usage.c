@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2026 The pgmoneta community
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or other
+ * materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may
+ * be used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <pgmoneta.h>
+#include <mctf.h>
+#include <shmem.h>
+#include <tscommon.h>
+#include <usage.h>
+#include <utils.h>
+
+#include <stdio.h>
+#include <string.h>
+
+static bool shmem_allocated = false;
+
+MCTF_MODULE_SETUP(usage)
+{
+   if (shmem == NULL)
+   {
+      pgmoneta_create_shared_memory(sizeof(struct main_configuration), HUGEPAGE_OFF, &shmem);
+      memset(shmem, 0, sizeof(struct main_configuration));
+      shmem_allocated = true;
+   }
+}
+
+MCTF_MODULE_TEARDOWN(usage)
+{
+   if (shmem_allocated && shmem != NULL)
+   {
+      pgmoneta_destroy_shared_memory(shmem, sizeof(struct main_configuration));
+      shmem = NULL;
+      shmem_allocated = false;
+   }
+}
+
+MCTF_TEST_SETUP(usage)
+{
+   pgmoneta_test_config_save();
+}
+
+MCTF_TEST_TEARDOWN(usage)
+{
+   pgmoneta_test_config_restore();
+}
+
+MCTF_TEST(test_usage_add)
+{
+   struct main_configuration* config;
+
+   config = (struct main_configuration*)shmem;
+   config->common.number_of_servers = 1;
+   pgmoneta_usage_init(&config->common.servers[0].usage);
+   atomic_store(&config->used_space, 0);
+
+   pgmoneta_usage_add(0, USAGE_BACKUP, 1000);
+   pgmoneta_usage_add(0, USAGE_WAL, 16);
+   pgmoneta_usage_add(0, USAGE_WAL_SHIPPING_WAL, 32);
+
+   MCTF_ASSERT_INT_EQ(pgmoneta_usage_get(0, USAGE_BACKUP), 1000, cleanup, "backup usage");
+   MCTF_ASSERT_INT_EQ(pgmoneta_usage_get(0, USAGE_WAL), 16, cleanup, "WAL usage");
+   MCTF_ASSERT_INT_EQ(pgmoneta_usage_get(0, USAGE_SERVER), 1016, cleanup, "server usage");
+   MCTF_ASSERT_INT_EQ(pgmoneta_usage_get(0, USAGE_WAL_SHIPPING), 32, cleanup, "WAL shipping usage");
+   MCTF_ASSERT_INT_EQ(pgmoneta_usage_used_space(), 1016, cleanup, "used space");
+
+   /* A removal larger than the snapshot stops at zero until the next reconcile */
+   pgmoneta_usage_add(0, USAGE_BACKUP, -2000);
+
+   MCTF_ASSERT_INT_EQ(pgmoneta_usage_get(0, USAGE_BACKUP), 0, cleanup, "backup usage below zero");
+   MCTF_ASSERT_INT_EQ(pgmoneta_usage_get(0, USAGE_SERVER), 0, cleanup, "server usage below zero");
+
+   /* Unknown servers and types are ignored */
+   pgmoneta_usage_add(1, USAGE_BACKUP, 1000);
+   pgmoneta_usage_add(0, NUMBER_OF_USAGES, 1000);
+
+   MCTF_ASSERT_INT_EQ(pgmoneta_usage_get(1, USAGE_BACKUP), 0, cleanup, "unknown server");
+   MCTF_ASSERT_INT_EQ(pgmoneta_usage_get(0, NUMBER_OF_USAGES), 0, cleanup, "unknown type");
+
+cleanup:
+   MCTF_FINISH();
+}
+
+MCTF_TEST(test_usage_reconcile)
+{
+   char base[MAX_PATH];
+   char path[MAX_PATH];
+   char data[1000];
+   FILE* file = NULL;
+   uint64_t size = 0;
+   struct main_configuration* config;
+
+   config = (struct main_configuration*)shmem;
+   config->common.number_of_servers = 1;
+   pgmoneta_snprintf(base, sizeof(base), "%s/usage", TEST_BASE_DIR);
+   pgmoneta_snprintf(config->base_dir, sizeof(config->base_dir), "%s", base);
+   pgmoneta_snprintf(config->common.servers[0].name, sizeof(config->common.servers[0].name), "primary");
+   pgmoneta_usage_init(&config->common.servers[0].usage);
+   atomic_store(&config->used_space, 0);
+
+   pgmoneta_snprintf(path, sizeof(path), "%s/primary/backup", base);
+   MCTF_ASSERT(pgmoneta_mkdir(path) == 0, cleanup, "directory should be created");
+   pgmoneta_snprintf(path, sizeof(path), "%s/primary/backup/data", base);
+   file = fopen(path, "wb");
+   MCTF_ASSERT_PTR_NONNULL(file, cleanup, "file should be created");
+   memset(data, 1, sizeof(data));
+   fwrite(data, 1, sizeof(data), file);
+   fclose(file);
+   file = NULL;
+
+   pgmoneta_snprintf(path, sizeof(path), "%s/primary/backup/", base);
+   size = pgmoneta_directory_size(path);
+
+   /* A stale counter is corrected */
+   pgmoneta_usage_add(0, USAGE_BACKUP, 5000);
+
+   MCTF_ASSERT(pgmoneta_usage_reconcile() == 0, cleanup, "reconcile should succeed");
+   MCTF_ASSERT_INT_EQ(pgmoneta_usage_get(0, USAGE_BACKUP), size, cleanup, "backup usage after reconcile");
+   MCTF_ASSERT_INT_EQ(pgmoneta_usage_get(0, USAGE_WAL), 0, cleanup, "WAL usage after reconcile");
+
+   /* A delta is applied on top of the reconciled value */
+   pgmoneta_usage_add(0, USAGE_BACKUP, 100);
+   MCTF_ASSERT_INT_EQ(pgmoneta_usage_get(0, USAGE_BACKUP), size + 100, cleanup, "backup usage after a delta");
+
+cleanup:
+   if (file != NULL)
+   {
+      fclose(file);
+   }
+   pgmoneta_delete_directory(base);
+   MCTF_FINISH();
+}
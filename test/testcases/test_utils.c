@@ -31,7 +31,11 @@
 #include <aes.h>
 #include <configuration.h>
 #include <extraction.h>
+#include <info.h>
+#include <json.h>
+#include <logging.h>
 #include <mctf.h>
+#include <prometheus.h>
 #include <shmem.h>
 #include <tscommon.h>
 #include <utils.h>
@@ -41,6 +45,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <fcntl.h>
 #include <stdbool.h>
 #include <time.h>
 #include <sys/types.h>
@@ -2167,3 +2172,190 @@ cleanup:
    pgmoneta_test_teardown();
    MCTF_FINISH();
 }
+
+MCTF_TEST(test_utils_string_builder)
+{
+   struct string_builder* sb = NULL;
+   char* s = NULL;
+   char* expected = NULL;
+   char big[1024];
+
+   MCTF_ASSERT(pgmoneta_string_builder_create(4, &sb) == 0, cleanup, "create failed");
+   MCTF_ASSERT_STR_EQ(sb->str, "", cleanup, "new builder should be empty");
+
+   pgmoneta_string_builder_append(sb, "pgmoneta_state ");
+   pgmoneta_string_builder_append(sb, NULL);
+   pgmoneta_string_builder_append_int(sb, -1);
+   pgmoneta_string_builder_append_char(sb, ' ');
+   pgmoneta_string_builder_append_ulong(sb, 18446744073709551615UL);
+   pgmoneta_string_builder_append_char(sb, ' ');
+   pgmoneta_string_builder_append_double_precision(sb, 3.14159, 4);
+   pgmoneta_string_builder_indent(sb, "x", 2);
+
+   expected = pgmoneta_append(expected, "pgmoneta_state ");
+   expected = pgmoneta_append_int(expected, -1);
+   expected = pgmoneta_append_char(expected, ' ');
+   expected = pgmoneta_append_ulong(expected, 18446744073709551615UL);
+   expected = pgmoneta_append_char(expected, ' ');
+   expected = pgmoneta_append_double_precision(expected, 3.14159, 4);
+   expected = pgmoneta_indent(expected, "x", 2);
+
+   MCTF_ASSERT_STR_EQ(sb->str, expected, cleanup, "builder should match pgmoneta_append");
+   MCTF_ASSERT_INT_EQ((int)sb->length, (int)strlen(expected), cleanup, "length should be tracked");
+
+   /* A format larger than the free space */
+   memset(big, 'a', sizeof(big) - 1);
+   big[sizeof(big) - 1] = '\0';
+   pgmoneta_string_builder_reset(sb);
+   MCTF_ASSERT(pgmoneta_string_builder_format(sb, "[%s]", big) == 0, cleanup, "format failed");
+   MCTF_ASSERT_INT_EQ((int)sb->length, (int)sizeof(big) + 1, cleanup, "format length mismatch");
+   MCTF_ASSERT(sb->str[0] == '[' && sb->str[sb->length - 1] == ']', cleanup, "format content mismatch");
+   MCTF_ASSERT(sb->capacity > sb->length, cleanup, "string should be terminated");
+
+   s = pgmoneta_string_builder_release(sb);
+   sb = NULL;
+   MCTF_ASSERT_PTR_NONNULL(s, cleanup, "release should return the string");
+   MCTF_ASSERT_INT_EQ((int)strlen(s), (int)sizeof(big) + 1, cleanup, "released string mismatch");
+
+   MCTF_ASSERT(pgmoneta_string_builder_create(0, &sb) == 0, cleanup, "create failed");
+   MCTF_ASSERT(pgmoneta_string_builder_release(sb) == NULL, cleanup, "empty builder should release NULL");
+   sb = NULL;
+
+cleanup:
+   pgmoneta_string_builder_destroy(sb);
+   free(s);
+   free(expected);
+   MCTF_FINISH();
+}
+
+/**
+ * Benchmark: render the metrics page and a JSON listing for the
+ * maximum number of servers with 100000 backups in total. Appending
+ * to a string that has to be measured on every call takes minutes
+ * at this size. The timings are logged.
+ */
+MCTF_TEST_MAX(test_utils_string_builder_benchmark, 300)
+{
+   int fd = -1;
+   int backups_per_server = 100000 / NUMBER_OF_SERVERS + 1;
+   int* number_of_backups = NULL;
+   struct backup*** all_backups = NULL;
+   struct json* servers = NULL;
+   struct json* server = NULL;
+   struct json* backups = NULL;
+   struct json* backup = NULL;
+   char* s = NULL;
+   char path[MAX_PATH];
+   FILE* file = NULL;
+   struct timespec start_t;
+   struct timespec end_t;
+   double metrics;
+   double json;
+   struct main_configuration* config;
+
+   config = (struct main_configuration*)shmem;
+
+   /* The servers share the backup directory of the first one, where every backup is valid */
+   pgmoneta_snprintf(config->base_dir, sizeof(config->base_dir), "%s/string_builder", TEST_BASE_DIR);
+   config->common.number_of_servers = NUMBER_OF_SERVERS;
+   config->metrics = 0;
+
+   number_of_backups = (int*)calloc(NUMBER_OF_SERVERS, sizeof(int));
+   all_backups = (struct backup***)calloc(NUMBER_OF_SERVERS, sizeof(struct backup**));
+   MCTF_ASSERT(number_of_backups != NULL && all_backups != NULL, cleanup, "allocation failed");
+
+   /* A struct backup is large, so the servers share the same backups */
+   all_backups[0] = (struct backup**)calloc(backups_per_server, sizeof(struct backup*));
+   MCTF_ASSERT_PTR_NONNULL(all_backups[0], cleanup, "allocation failed");
+
+   for (int j = 0; j < backups_per_server; j++)
+   {
+      all_backups[0][j] = (struct backup*)calloc(1, sizeof(struct backup));
+      MCTF_ASSERT_PTR_NONNULL(all_backups[0][j], cleanup, "allocation failed");
+
+      pgmoneta_snprintf(all_backups[0][j]->label, sizeof(all_backups[0][j]->label), "2026%010d", j);
+      all_backups[0][j]->valid = VALID_TRUE;
+      all_backups[0][j]->backup_size = 1048576;
+      all_backups[0][j]->restore_size = 4194304;
+
+      pgmoneta_snprintf(path, sizeof(path), "%s/server0/backup/%s", config->base_dir, all_backups[0][j]->label);
+      MCTF_ASSERT(pgmoneta_mkdir(path) == 0, cleanup, "backup directory should be created");
+      pgmoneta_snprintf(path, sizeof(path), "%s/server0/backup/%s/backup.sha512", config->base_dir, all_backups[0][j]->label);
+      file = fopen(path, "w");
+      MCTF_ASSERT_PTR_NONNULL(file, cleanup, "backup.sha512 should be created");
+      fclose(file);
+      file = NULL;
+   }
+
+   for (int i = 0; i < NUMBER_OF_SERVERS; i++)
+   {
+      pgmoneta_snprintf(config->common.servers[i].name, sizeof(config->common.servers[i].name), "server%d", i);
+
+      if (i > 0)
+      {
+         pgmoneta_snprintf(path, sizeof(path), "%s/server%d", config->base_dir, i);
+         MCTF_ASSERT(pgmoneta_symlink_file(path, "server0") == 0, cleanup, "server directory should be linked");
+      }
+
+      all_backups[i] = all_backups[0];
+      number_of_backups[i] = backups_per_server;
+   }
+
+   fd = open("/dev/null", O_WRONLY);
+   MCTF_ASSERT(fd != -1, cleanup, "/dev/null should open");
+
+   clock_gettime(CLOCK_MONOTONIC, &start_t);
+   MCTF_ASSERT(pgmoneta_prometheus_metrics(NULL, fd, number_of_backups, all_backups) == 0, cleanup, "metrics failed");
+   clock_gettime(CLOCK_MONOTONIC, &end_t);
+   metrics = pgmoneta_compute_duration(start_t, end_t);
+
+   pgmoneta_json_create(&servers);
+   for (int i = 0; i < NUMBER_OF_SERVERS; i++)
+   {
+      pgmoneta_json_create(&server);
+      pgmoneta_json_create(&backups);
+      for (int j = 0; j < backups_per_server; j++)
+      {
+         pgmoneta_json_create(&backup);
+         pgmoneta_json_put(backup, "Backup", (uintptr_t)all_backups[i][j]->label, ValueString);
+         pgmoneta_json_put(backup, "BackupSize", all_backups[i][j]->backup_size, ValueUInt64);
+         pgmoneta_json_put(backup, "Valid", true, ValueBool);
+         pgmoneta_json_append(backups, (uintptr_t)backup, ValueJSON);
+      }
+      pgmoneta_json_put(server, "Server", (uintptr_t)config->common.servers[i].name, ValueString);
+      pgmoneta_json_put(server, "Backups", (uintptr_t)backups, ValueJSON);
+      pgmoneta_json_append(servers, (uintptr_t)server, ValueJSON);
+   }
+
+   clock_gettime(CLOCK_MONOTONIC, &start_t);
+   s = pgmoneta_json_to_string(servers, FORMAT_JSON, NULL, 0);
+   clock_gettime(CLOCK_MONOTONIC, &end_t);
+   json = pgmoneta_compute_duration(start_t, end_t);
+
+   MCTF_ASSERT_PTR_NONNULL(s, cleanup, "JSON rendering failed");
+   MCTF_ASSERT(strlen(s) > (size_t)NUMBER_OF_SERVERS * backups_per_server * 50, cleanup, "JSON is too short");
+
+   pgmoneta_log_info("string builder %d backups: metrics %.3fs, JSON %.3fs",
+                     NUMBER_OF_SERVERS * backups_per_server, metrics, json);
+
+cleanup:
+   if (fd != -1)
+   {
+      close(fd);
+   }
+   for (int j = 0; all_backups != NULL && all_backups[0] != NULL && j < backups_per_server; j++)
+   {
+      free(all_backups[0][j]);
+   }
+   if (all_backups != NULL)
+   {
+      free(all_backups[0]);
+   }
+   free(all_backups);
+   free(number_of_backups);
+   pgmoneta_json_destroy(servers);
+   free(s);
+   pgmoneta_snprintf(path, sizeof(path), "%s/string_builder", TEST_BASE_DIR);
+   pgmoneta_delete_directory(path);
+   MCTF_FINISH();
+}
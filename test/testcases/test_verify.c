@@ -0,0 +1,761 @@
+/*
+ * Copyright (C) 2026 The pgmoneta community
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or other
+ * materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may
+ * be used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <pgmoneta.h>
+#include <art.h>
+#include <deque.h>
+#include <info.h>
+#include <mctf.h>
+#include <security.h>
+#include <tscommon.h>
+#include <utils.h>
+#include <verify.h>
+#include <workflow.h>
+#include <workflow_funcs.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+#define TREE_FILE_SIZE  (TREE_HASH_LEAF_SIZE * 2 + TREE_HASH_LEAF_SIZE / 2)
+#define TREE_FILE_LABEL "20991231235959"
+#define TREE_FILE_NAME  "base/1/16384"
+
+#define LEDGER_LABEL     "20991231235957"
+#define LINKED_LABEL     "20991231235958"
+#define LEDGER_FILE_SIZE 4096
+#define LEDGER_MTIME     1700000000
+
+static int create_tree_file(char* path);
+static int modify_tree_file(char* path, long offset);
+static int tree_hash_file(char* path, size_t chunk, char** hash);
+static int tree_hash_leaves(char* path, unsigned char** digests, size_t* leaves, char** hash);
+static int create_ledger_file(char* path, size_t size, int seed, time_t mtime);
+static int write_ledger_sha512(char* root, char* a, char* b);
+static int write_ledger(char* path, char* a, long long a_ts, char* b, long long b_ts);
+static int ledger_key(char* path, char* key, size_t size);
+static long long ledger_timestamp(char* path, char* key);
+static int touch_ledger_file(char* path, time_t mtime);
+static int run_verification(void);
+
+MCTF_TEST_SETUP(verify)
+{
+   pgmoneta_test_config_save();
+}
+
+MCTF_TEST_TEARDOWN(verify)
+{
+   pgmoneta_test_config_restore();
+}
+
+MCTF_TEST(test_verify_tree_hash)
+{
+   char path[MAX_PATH] = {0};
+   char* first = NULL;
+   char* second = NULL;
+   char* split = NULL;
+   char* modified = NULL;
+   unsigned char* digests = NULL;
+   unsigned char* modified_digests = NULL;
+   size_t leaves = 0;
+
+   pgmoneta_snprintf(path, sizeof(path), "%s/tree_hash", TEST_BASE_DIR);
+
+   MCTF_ASSERT(!create_tree_file(path), cleanup, "Failed to create %s", path);
+
+   /* The digest does not depend on how the input is fed */
+   MCTF_ASSERT(!tree_hash_file(path, DEFAULT_BUFFER_SIZE, &first), cleanup, "Failed to tree hash %s", path);
+   MCTF_ASSERT(!tree_hash_file(path, 4093, &second), cleanup, "Failed to tree hash %s", path);
+   MCTF_ASSERT_STR_EQ(first, second, cleanup, "tree digest is not stable");
+
+   /* Split verification hashes the leaves independently */
+   MCTF_ASSERT(!tree_hash_leaves(path, &digests, &leaves, &split), cleanup, "Failed to hash the leaves of %s", path);
+   MCTF_ASSERT_INT_EQ(leaves, 3, cleanup, "expected 3 leaves");
+   MCTF_ASSERT_STR_EQ(first, split, cleanup, "leaf digests do not match the tree digest");
+
+   /* A single modified byte only changes its own leaf, and the root */
+   MCTF_ASSERT(!modify_tree_file(path, TREE_HASH_LEAF_SIZE + 12345), cleanup, "Failed to modify %s", path);
+   MCTF_ASSERT(!tree_hash_leaves(path, &modified_digests, &leaves, &modified), cleanup, "Failed to hash the leaves of %s", path);
+   MCTF_ASSERT(strcmp(first, modified), cleanup, "modified leaf not detected");
+   MCTF_ASSERT(!memcmp(digests, modified_digests, TREE_HASH_DIGEST_SIZE), cleanup, "leaf 0 changed");
+   MCTF_ASSERT(memcmp(digests + TREE_HASH_DIGEST_SIZE, modified_digests + TREE_HASH_DIGEST_SIZE, TREE_HASH_DIGEST_SIZE), cleanup, "leaf 1 unchanged");
+   MCTF_ASSERT(!memcmp(digests + 2 * TREE_HASH_DIGEST_SIZE, modified_digests + 2 * TREE_HASH_DIGEST_SIZE, TREE_HASH_DIGEST_SIZE), cleanup, "leaf 2 changed");
+
+cleanup:
+   pgmoneta_delete_file(path, NULL);
+   free(first);
+   free(second);
+   free(split);
+   free(modified);
+   free(digests);
+   free(modified_digests);
+   MCTF_FINISH();
+}
+
+MCTF_TEST(test_verify_tree_split)
+{
+   char* base = NULL;
+   char* tree = NULL;
+   char backup[MAX_PATH] = {0};
+   char target[MAX_PATH] = {0};
+   char path[MAX_PATH] = {0};
+   char line[MAX_PATH] = {0};
+   char bogus[129] = {0};
+   struct art* nodes = NULL;
+   struct workflow* wf = NULL;
+   struct deque* failed = NULL;
+   FILE* f = NULL;
+   struct main_configuration* config;
+
+   config = (struct main_configuration*)shmem;
+   config->common.servers[PRIMARY_SERVER].workers = 2;
+
+   base = pgmoneta_get_server_backup(PRIMARY_SERVER);
+   MCTF_ASSERT_PTR_NONNULL(base, cleanup, "No backup directory");
+
+   pgmoneta_snprintf(backup, sizeof(backup), "%s%s%s", base, pgmoneta_ends_with(base, "/") ? "" : "/", TREE_FILE_LABEL);
+   pgmoneta_snprintf(target, sizeof(target), "%s/tree_split", TEST_BASE_DIR);
+   pgmoneta_snprintf(path, sizeof(path), "%s/base/1", target);
+   pgmoneta_mkdir(backup);
+   pgmoneta_mkdir(path);
+
+   pgmoneta_snprintf(path, sizeof(path), "%s/%s", target, TREE_FILE_NAME);
+   MCTF_ASSERT(!create_tree_file(path), cleanup, "Failed to create %s", path);
+   MCTF_ASSERT(!tree_hash_file(path, DEFAULT_BUFFER_SIZE, &tree), cleanup, "Failed to tree hash %s", path);
+
+   /* The manifest digest is wrong, so only the tree digest can verify the file */
+   memset(bogus, '0', 128);
+   pgmoneta_snprintf(line, sizeof(line), "%s/backup.manifest", backup);
+   f = fopen(line, "w");
+   MCTF_ASSERT_PTR_NONNULL(f, cleanup, "Failed to create %s", line);
+   fprintf(f, "%s,%s\n", TREE_FILE_NAME, bogus);
+   fclose(f);
+   f = NULL;
+
+   pgmoneta_snprintf(line, sizeof(line), "%s/backup.tree", backup);
+   f = fopen(line, "w");
+   MCTF_ASSERT_PTR_NONNULL(f, cleanup, "Failed to create %s", line);
+   fprintf(f, "%s,%s\n", TREE_FILE_NAME, tree);
+   fclose(f);
+   f = NULL;
+
+   for (int i = 0; i < 2; i++)
+   {
+      MCTF_ASSERT(!pgmoneta_art_create(&nodes), cleanup, "Failed to create nodes");
+      pgmoneta_art_insert(nodes, NODE_SERVER_ID, (uintptr_t)PRIMARY_SERVER, ValueInt32);
+      pgmoneta_art_insert(nodes, NODE_LABEL, (uintptr_t)TREE_FILE_LABEL, ValueString);
+      pgmoneta_art_insert(nodes, NODE_TARGET_BASE, (uintptr_t)target, ValueString);
+      pgmoneta_art_insert(nodes, USER_FILES, (uintptr_t)NODE_FAILED, ValueString);
+
+      wf = pgmoneta_create_verify();
+      MCTF_ASSERT_PTR_NONNULL(wf, cleanup, "Failed to create the verify workflow");
+      MCTF_ASSERT(!wf->execute(NULL, nodes), cleanup, "Verify failed");
+
+      failed = (struct deque*)pgmoneta_art_search(nodes, NODE_FAILED);
+      MCTF_ASSERT_PTR_NONNULL(failed, cleanup, "No failed files");
+      if (i == 0)
+      {
+         MCTF_ASSERT_INT_EQ(pgmoneta_deque_size(failed), 0, cleanup, "file not verified by its tree digest");
+
+         /* Modify one leaf, the tree digest no longer matches */
+         MCTF_ASSERT(!modify_tree_file(path, 2 * TREE_HASH_LEAF_SIZE + 1), cleanup, "Failed to modify %s", path);
+      }
+      else
+      {
+         MCTF_ASSERT_INT_EQ(pgmoneta_deque_size(failed), 1, cleanup, "modified leaf not detected");
+      }
+
+      pgmoneta_workflow_destroy(wf);
+      wf = NULL;
+      pgmoneta_art_destroy(nodes);
+      nodes = NULL;
+   }
+
+cleanup:
+   if (f != NULL)
+   {
+      fclose(f);
+   }
+   pgmoneta_workflow_destroy(wf);
+   pgmoneta_art_destroy(nodes);
+   pgmoneta_delete_directory(target);
+   pgmoneta_delete_directory(backup);
+   free(tree);
+   free(base);
+   MCTF_FINISH();
+}
+
+MCTF_TEST(test_verify_ledger)
+{
+   char* server = NULL;
+   char* server_backup = NULL;
+   char* root = NULL;
+   char base[MAX_PATH] = {0};
+   char dir[MAX_PATH] = {0};
+   char data[MAX_PATH] = {0};
+   char ledger[MAX_PATH] = {0};
+   char a[MAX_PATH] = {0};
+   char b[MAX_PATH] = {0};
+   char tmp[MAX_PATH] = {0};
+   char a_key[MISC_LENGTH] = {0};
+   char b_key[MISC_LENGTH] = {0};
+   char b_old[MISC_LENGTH] = {0};
+   struct backup* backup = NULL;
+   struct main_configuration* config;
+
+   config = (struct main_configuration*)shmem;
+
+   pgmoneta_snprintf(base, sizeof(base), "%s/verify_ledger", TEST_BASE_DIR);
+   pgmoneta_snprintf(config->base_dir, sizeof(config->base_dir), "%s", base);
+   config->update_process_title = UPDATE_PROCESS_TITLE_NEVER;
+   config->verification_budget = 0;
+   for (int i = 0; i < config->common.number_of_servers; i++)
+   {
+      config->common.servers[i].online = i == PRIMARY_SERVER;
+   }
+
+   server = pgmoneta_get_server(PRIMARY_SERVER);
+   server_backup = pgmoneta_get_server_backup(PRIMARY_SERVER);
+   root = pgmoneta_get_server_backup_identifier(PRIMARY_SERVER, LEDGER_LABEL);
+   MCTF_ASSERT(server != NULL && server_backup != NULL && root != NULL, cleanup, "No backup directory");
+
+   pgmoneta_snprintf(ledger, sizeof(ledger), "%s%sverification.ledger", server, pgmoneta_ends_with(server, "/") ? "" : "/");
+   pgmoneta_snprintf(dir, sizeof(dir), "%s%s", root, pgmoneta_ends_with(root, "/") ? "" : "/");
+   pgmoneta_snprintf(a, sizeof(a), "%sdata/a", dir);
+   pgmoneta_snprintf(b, sizeof(b), "%sdata/b", dir);
+   pgmoneta_snprintf(tmp, sizeof(tmp), "%sdata/b.tmp", dir);
+   pgmoneta_snprintf(data, sizeof(data), "%sdata", dir);
+   MCTF_ASSERT(!pgmoneta_mkdir(data), cleanup, "Failed to create %s", data);
+
+   MCTF_ASSERT(!create_ledger_file(a, LEDGER_FILE_SIZE, 1, LEDGER_MTIME), cleanup, "Failed to create %s", a);
+   MCTF_ASSERT(!create_ledger_file(b, LEDGER_FILE_SIZE, 2, LEDGER_MTIME), cleanup, "Failed to create %s", b);
+
+   backup = (struct backup*)calloc(1, sizeof(struct backup));
+   MCTF_ASSERT_PTR_NONNULL(backup, cleanup, "allocation should succeed");
+   pgmoneta_snprintf(backup->label, sizeof(backup->label), "%s", LEDGER_LABEL);
+   backup->valid = VALID_TRUE;
+   MCTF_ASSERT(!pgmoneta_save_info(server_backup, backup), cleanup, "info should be saved");
+
+   /* Only the two data files are candidates, so the budget covers exactly one of them */
+   MCTF_ASSERT(!write_ledger_sha512(dir, a, b), cleanup, "Failed to create backup.sha512");
+
+   /* Without a budget every file is verified, and recorded */
+   MCTF_ASSERT(!run_verification(), cleanup, "Verification failed");
+   MCTF_ASSERT(!ledger_key(a, a_key, sizeof(a_key)), cleanup, "Failed to stat %s", a);
+   MCTF_ASSERT(!ledger_key(b, b_key, sizeof(b_key)), cleanup, "Failed to stat %s", b);
+   MCTF_ASSERT(ledger_timestamp(ledger, a_key) > 0, cleanup, "a is not in the ledger");
+   MCTF_ASSERT(ledger_timestamp(ledger, b_key) > 0, cleanup, "b is not in the ledger");
+
+   /* A budget of one file verifies the stalest file, the other entry is a hit and is kept */
+   config->verification_budget = LEDGER_FILE_SIZE;
+   MCTF_ASSERT(!write_ledger(ledger, a_key, 1000, b_key, 2000), cleanup, "Failed to write the ledger");
+   MCTF_ASSERT(!run_verification(), cleanup, "Verification failed");
+   MCTF_ASSERT(ledger_timestamp(ledger, a_key) > 2000, cleanup, "the stalest file was not verified");
+   MCTF_ASSERT(ledger_timestamp(ledger, b_key) == 2000, cleanup, "the budget was not enforced");
+
+   /* A changed mtime, size or inode is a miss, so the file is verified first */
+   for (int i = 0; i < 3; i++)
+   {
+      pgmoneta_snprintf(b_old, sizeof(b_old), "%s", b_key);
+      MCTF_ASSERT(!write_ledger(ledger, a_key, 1000, b_old, 2000), cleanup, "Failed to write the ledger");
+
+      if (i == 0)
+      {
+         MCTF_ASSERT(!touch_ledger_file(b, LEDGER_MTIME + 10), cleanup, "Failed to touch %s", b);
+      }
+      else if (i == 1)
+      {
+         MCTF_ASSERT(!create_ledger_file(b, LEDGER_FILE_SIZE + 1, 3, LEDGER_MTIME + 10), cleanup, "Failed to rewrite %s", b);
+         MCTF_ASSERT(!write_ledger_sha512(dir, a, b), cleanup, "Failed to create backup.sha512");
+      }
+      else
+      {
+         MCTF_ASSERT(!create_ledger_file(tmp, LEDGER_FILE_SIZE + 1, 3, LEDGER_MTIME + 10), cleanup, "Failed to create %s", tmp);
+         MCTF_ASSERT(!rename(tmp, b), cleanup, "Failed to replace %s", b);
+      }
+
+      MCTF_ASSERT(!ledger_key(b, b_key, sizeof(b_key)), cleanup, "Failed to stat %s", b);
+      MCTF_ASSERT(strcmp(b_old, b_key), cleanup, "the key of b did not change (%d)", i);
+
+      MCTF_ASSERT(!run_verification(), cleanup, "Verification failed");
+      MCTF_ASSERT(ledger_timestamp(ledger, b_key) > 2000, cleanup, "the changed file was not verified (%d)", i);
+      MCTF_ASSERT(ledger_timestamp(ledger, b_old) == -1, cleanup, "the stale entry was kept (%d)", i);
+      MCTF_ASSERT(ledger_timestamp(ledger, a_key) == 1000, cleanup, "the budget was not enforced (%d)", i);
+   }
+
+cleanup:
+   pgmoneta_delete_directory(base);
+   free(backup);
+   free(server);
+   free(server_backup);
+   free(root);
+   MCTF_FINISH();
+}
+
+MCTF_TEST(test_verify_linked_corruption)
+{
+   char* server_backup = NULL;
+   char* first = NULL;
+   char* second = NULL;
+   char base[MAX_PATH] = {0};
+   char dirs[2][MAX_PATH] = {0};
+   char a[2][MAX_PATH] = {0};
+   char b[2][MAX_PATH] = {0};
+   char data[MAX_PATH] = {0};
+   char* labels[] = {LEDGER_LABEL, LINKED_LABEL};
+   struct backup* backup = NULL;
+   struct main_configuration* config;
+
+   config = (struct main_configuration*)shmem;
+
+   pgmoneta_snprintf(base, sizeof(base), "%s/verify_linked", TEST_BASE_DIR);
+   pgmoneta_snprintf(config->base_dir, sizeof(config->base_dir), "%s", base);
+   config->update_process_title = UPDATE_PROCESS_TITLE_NEVER;
+   config->verification_budget = 0;
+   for (int i = 0; i < config->common.number_of_servers; i++)
+   {
+      config->common.servers[i].online = i == PRIMARY_SERVER;
+   }
+
+   server_backup = pgmoneta_get_server_backup(PRIMARY_SERVER);
+   first = pgmoneta_get_server_backup_identifier(PRIMARY_SERVER, LEDGER_LABEL);
+   second = pgmoneta_get_server_backup_identifier(PRIMARY_SERVER, LINKED_LABEL);
+   MCTF_ASSERT(server_backup != NULL && first != NULL && second != NULL, cleanup, "No backup directory");
+
+   pgmoneta_snprintf(dirs[0], sizeof(dirs[0]), "%s%s", first, pgmoneta_ends_with(first, "/") ? "" : "/");
+   pgmoneta_snprintf(dirs[1], sizeof(dirs[1]), "%s%s", second, pgmoneta_ends_with(second, "/") ? "" : "/");
+
+   for (int i = 0; i < 2; i++)
+   {
+      pgmoneta_snprintf(data, sizeof(data), "%sdata", dirs[i]);
+      MCTF_ASSERT(!pgmoneta_mkdir(data), cleanup, "Failed to create %s", data);
+      pgmoneta_snprintf(a[i], sizeof(a[i]), "%sdata/a", dirs[i]);
+      pgmoneta_snprintf(b[i], sizeof(b[i]), "%sdata/b", dirs[i]);
+   }
+
+   /* The second backup links a from the first one */
+   MCTF_ASSERT(!create_ledger_file(a[0], LEDGER_FILE_SIZE, 1, LEDGER_MTIME), cleanup, "Failed to create %s", a[0]);
+   MCTF_ASSERT(!create_ledger_file(b[0], LEDGER_FILE_SIZE, 2, LEDGER_MTIME), cleanup, "Failed to create %s", b[0]);
+   MCTF_ASSERT(!link(a[0], a[1]), cleanup, "Failed to link %s", a[1]);
+   MCTF_ASSERT(!create_ledger_file(b[1], LEDGER_FILE_SIZE, 3, LEDGER_MTIME), cleanup, "Failed to create %s", b[1]);
+
+   for (int i = 0; i < 2; i++)
+   {
+      backup = (struct backup*)calloc(1, sizeof(struct backup));
+      MCTF_ASSERT_PTR_NONNULL(backup, cleanup, "allocation should succeed");
+      pgmoneta_snprintf(backup->label, sizeof(backup->label), "%s", labels[i]);
+      backup->valid = VALID_TRUE;
+      MCTF_ASSERT(!pgmoneta_save_info(server_backup, backup), cleanup, "info should be saved");
+      free(backup);
+      backup = NULL;
+
+      /* Only the two data files are candidates */
+      MCTF_ASSERT(!write_ledger_sha512(dirs[i], a[i], b[i]), cleanup, "Failed to create backup.sha512");
+   }
+
+   MCTF_ASSERT(!run_verification(), cleanup, "Verification failed");
+
+   /* The shared file is hashed once, and its corruption invalidates both backups */
+   MCTF_ASSERT(!modify_tree_file(a[0], 17), cleanup, "Failed to modify %s", a[0]);
+   MCTF_ASSERT(run_verification(), cleanup, "Corruption not detected");
+
+   for (int i = 0; i < 2; i++)
+   {
+      MCTF_ASSERT(!pgmoneta_load_info(server_backup, labels[i], &backup) && backup != NULL, cleanup, "Failed to load %s", labels[i]);
+      MCTF_ASSERT_INT_EQ(backup->valid, VALID_FALSE, cleanup, "%s was not invalidated", labels[i]);
+      free(backup);
+      backup = NULL;
+   }
+
+cleanup:
+   pgmoneta_delete_directory(base);
+   free(backup);
+   free(server_backup);
+   free(first);
+   free(second);
+   MCTF_FINISH();
+}
+
+MCTF_TEST(test_verify_budget_size)
+{
+   struct main_configuration* config;
+
+   MCTF_ASSERT_INT_EQ(pgmoneta_test_load_conf(TEST_CONF_DIR "/verify/01.conf"), 0,
+                      cleanup, "failed to read 01.conf");
+   config = (struct main_configuration*)shmem;
+   MCTF_ASSERT(config->verification_budget == 2ULL * 1024 * 1024 * 1024 * 1024,
+               cleanup, "01.conf: 2T should be 2199023255552 bytes");
+
+   MCTF_ASSERT_INT_EQ(pgmoneta_test_load_conf(TEST_CONF_DIR "/verify/02.conf"), 0,
+                      cleanup, "failed to read 02.conf");
+   config = (struct main_configuration*)shmem;
+   MCTF_ASSERT(config->verification_budget == 1024ULL * 1024 * 1024 * 1024,
+               cleanup, "02.conf: 1TB should be 1099511627776 bytes");
+
+cleanup:
+   MCTF_FINISH();
+}
+
+static int
+create_tree_file(char* path)
+{
+   FILE* f = NULL;
+   unsigned char* buffer = NULL;
+   size_t size = 1024 * 1024;
+
+   buffer = malloc(size);
+   f = fopen(path, "wb");
+   if (buffer == NULL || f == NULL)
+   {
+      goto error;
+   }
+
+   for (size_t written = 0; written < TREE_FILE_SIZE; written += size)
+   {
+      for (size_t i = 0; i < size; i++)
+      {
+         buffer[i] = (unsigned char)((i * 31 + written / size) & 0xFF);
+      }
+
+      if (fwrite(buffer, 1, size, f) != size)
+      {
+         goto error;
+      }
+   }
+
+   fclose(f);
+   free(buffer);
+
+   return 0;
+
+error:
+   if (f != NULL)
+   {
+      fclose(f);
+   }
+   free(buffer);
+
+   return 1;
+}
+
+static int
+modify_tree_file(char* path, long offset)
+{
+   FILE* f = NULL;
+   int c = 0;
+
+   f = fopen(path, "r+b");
+   if (f == NULL || fseek(f, offset, SEEK_SET) || (c = fgetc(f)) == EOF)
+   {
+      goto error;
+   }
+
+   if (fseek(f, offset, SEEK_SET) || fputc(c ^ 0xFF, f) == EOF)
+   {
+      goto error;
+   }
+
+   fclose(f);
+
+   return 0;
+
+error:
+   if (f != NULL)
+   {
+      fclose(f);
+   }
+
+   return 1;
+}
+
+static int
+tree_hash_file(char* path, size_t chunk, char** hash)
+{
+   FILE* f = NULL;
+   char* buffer = NULL;
+   size_t n = 0;
+   struct tree_hasher* hasher = NULL;
+
+   *hash = NULL;
+
+   buffer = malloc(chunk);
+   f = fopen(path, "rb");
+   if (buffer == NULL || f == NULL || pgmoneta_tree_hasher_create(&hasher))
+   {
+      goto error;
+   }
+
+   while ((n = fread(buffer, 1, chunk, f)) > 0)
+   {
+      if (pgmoneta_tree_hasher_update(hasher, buffer, n))
+      {
+         goto error;
+      }
+   }
+
+   if (pgmoneta_tree_hasher_final(hasher, hash))
+   {
+      goto error;
+   }
+
+   pgmoneta_tree_hasher_destroy(hasher);
+   fclose(f);
+   free(buffer);
+
+   return 0;
+
+error:
+   pgmoneta_tree_hasher_destroy(hasher);
+   if (f != NULL)
+   {
+      fclose(f);
+   }
+   free(buffer);
+
+   return 1;
+}
+
+static int
+tree_hash_leaves(char* path, unsigned char** digests, size_t* leaves, char** hash)
+{
+   uint64_t size = (uint64_t)pgmoneta_get_file_size(path);
+   size_t n = (size_t)((size + TREE_HASH_LEAF_SIZE - 1) / TREE_HASH_LEAF_SIZE);
+   unsigned char* d = NULL;
+
+   *digests = NULL;
+   *hash = NULL;
+
+   d = malloc(n * TREE_HASH_DIGEST_SIZE);
+   if (d == NULL)
+   {
+      goto error;
+   }
+
+   for (size_t i = 0; i < n; i++)
+   {
+      if (pgmoneta_create_sha512_leaf(path, i, d + i * TREE_HASH_DIGEST_SIZE))
+      {
+         goto error;
+      }
+   }
+
+   if (pgmoneta_create_sha512_tree_root(d, n, size, hash))
+   {
+      goto error;
+   }
+
+   *digests = d;
+   *leaves = n;
+
+   return 0;
+
+error:
+   free(d);
+
+   return 1;
+}
+
+static int
+create_ledger_file(char* path, size_t size, int seed, time_t mtime)
+{
+   FILE* f = NULL;
+
+   f = fopen(path, "wb");
+   if (f == NULL)
+   {
+      return 1;
+   }
+
+   for (size_t i = 0; i < size; i++)
+   {
+      fputc((int)((i * 7 + seed) & 0xFF), f);
+   }
+
+   fclose(f);
+
+   return touch_ledger_file(path, mtime);
+}
+
+static int
+touch_ledger_file(char* path, time_t mtime)
+{
+   struct timeval times[2];
+
+   times[0].tv_sec = mtime;
+   times[0].tv_usec = 0;
+   times[1] = times[0];
+
+   return utimes(path, times) ? 1 : 0;
+}
+
+static int
+write_ledger_sha512(char* root, char* a, char* b)
+{
+   char path[MAX_PATH] = {0};
+   char* files[] = {a, b};
+   char* hash = NULL;
+   FILE* f = NULL;
+
+   pgmoneta_snprintf(path, sizeof(path), "%sbackup.sha512", root);
+
+   f = fopen(path, "w");
+   if (f == NULL)
+   {
+      goto error;
+   }
+
+   for (int i = 0; i < 2; i++)
+   {
+      if (pgmoneta_create_sha512_file(files[i], &hash))
+      {
+         goto error;
+      }
+
+      fprintf(f, "%s *./%s\n", hash, files[i] + strlen(root));
+      free(hash);
+      hash = NULL;
+   }
+
+   fclose(f);
+
+   return 0;
+
+error:
+   if (f != NULL)
+   {
+      fclose(f);
+   }
+   free(hash);
+
+   return 1;
+}
+
+static int
+write_ledger(char* path, char* a, long long a_ts, char* b, long long b_ts)
+{
+   FILE* f = NULL;
+
+   f = fopen(path, "w");
+   if (f == NULL)
+   {
+      return 1;
+   }
+
+   fprintf(f, "%s,%lld\n", a, a_ts);
+   fprintf(f, "%s,%lld\n", b, b_ts);
+   fclose(f);
+
+   return 0;
+}
+
+static int
+ledger_key(char* path, char* key, size_t size)
+{
+   struct stat st;
+
+   if (stat(path, &st))
+   {
+      return 1;
+   }
+
+   /* The same identity the verification ledger records */
+   pgmoneta_snprintf(key, size, "%llu,%llu,%lld,%lld",
+                     (unsigned long long)st.st_dev, (unsigned long long)st.st_ino,
+                     (long long)st.st_size, (long long)st.st_mtime);
+
+   return 0;
+}
+
+static long long
+ledger_timestamp(char* path, char* key)
+{
+   char buffer[MISC_LENGTH];
+   char* sep = NULL;
+   long long ts = -1;
+   FILE* f = NULL;
+
+   f = fopen(path, "r");
+   if (f == NULL)
+   {
+      return -1;
+   }
+
+   while (fgets(&buffer[0], sizeof(buffer), f) != NULL)
+   {
+      buffer[strcspn(&buffer[0], "\n")] = '\0';
+
+      sep = strrchr(&buffer[0], ',');
+      if (sep == NULL)
+      {
+         continue;
+      }
+      *sep = '\0';
+
+      if (!strcmp(&buffer[0], key))
+      {
+         ts = strtoll(sep + 1, NULL, 10);
+         break;
+      }
+   }
+
+   fclose(f);
+
+   return ts;
+}
+
+static int
+run_verification(void)
+{
+   char* argv[] = {"test_verify", NULL};
+   int status = 0;
+   pid_t pid;
+
+   /* The verification process exits when it is done */
+   pid = fork();
+   if (pid == -1)
+   {
+      return 1;
+   }
+
+   if (pid == 0)
+   {
+      pgmoneta_sha512_verification(&argv[0]);
+      _exit(1);
+   }
+
+   if (waitpid(pid, &status, 0) != pid)
+   {
+      return 1;
+   }
+
+   return WIFEXITED(status) && WEXITSTATUS(status) == 0 ? 0 : 1;
+}
@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2026 The pgmoneta community
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or other
+ * materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may
+ * be used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <pgmoneta.h>
+#include <deque.h>
+#include <mctf.h>
+#include <tscommon.h>
+#include <utils.h>
+#include <walbundle.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define WAL_BUNDLE_TEST_SIZE (64 * 1024)
+
+static int
+write_segment(char* directory, char* name, char fill)
+{
+   char path[MAX_PATH];
+   char data[WAL_BUNDLE_TEST_SIZE];
+   FILE* file = NULL;
+
+   pgmoneta_snprintf(path, sizeof(path), "%s/%s", directory, name);
+   memset(&data[0], fill, sizeof(data));
+
+   file = fopen(path, "w");
+   if (file == NULL)
+   {
+      return 1;
+   }
+
+   fwrite(&data[0], 1, sizeof(data), file);
+   fclose(file);
+
+   return 0;
+}
+
+/**
+ * Test: the name of a bundle holds the range of its segments.
+ */
+MCTF_TEST(test_walbundle_name)
+{
+   char* name = NULL;
+
+   name = pgmoneta_wal_bundle_name("000000010000000000000003.zstd", "000000010000000000000007.zstd");
+   MCTF_ASSERT_PTR_NONNULL(name, cleanup, "name should be created");
+   MCTF_ASSERT_STR_EQ(name, "000000010000000000000003-000000010000000000000007.bundle", cleanup, "name should match");
+
+   MCTF_ASSERT(pgmoneta_wal_bundle_ends_before(name, "000000010000000000000008"), cleanup, "bundle should end before the next segment");
+   MCTF_ASSERT(pgmoneta_wal_bundle_ends_before(name, "000000010000000000000009.zstd"), cleanup, "bundle should end before a later segment");
+   MCTF_ASSERT(!pgmoneta_wal_bundle_ends_before(name, "000000010000000000000007"), cleanup, "bundle should hold its last segment");
+   MCTF_ASSERT(!pgmoneta_wal_bundle_ends_before(name, "000000010000000000000005"), cleanup, "bundle should hold a middle segment");
+   MCTF_ASSERT(!pgmoneta_wal_bundle_ends_before(name, "000000010000000000000002"), cleanup, "bundle should not end before a previous segment");
+   MCTF_ASSERT(!pgmoneta_wal_bundle_ends_before("backup.info", "000000010000000000000008"), cleanup, "other objects should not be bundles");
+
+   MCTF_ASSERT(pgmoneta_wal_bundle_covers(name, "000000010000000000000003"), cleanup, "first segment should be covered");
+   MCTF_ASSERT(pgmoneta_wal_bundle_covers(name, "000000010000000000000005.zstd"), cleanup, "middle segment should be covered");
+   MCTF_ASSERT(pgmoneta_wal_bundle_covers(name, "000000010000000000000007"), cleanup, "last segment should be covered");
+   MCTF_ASSERT(!pgmoneta_wal_bundle_covers(name, "000000010000000000000008"), cleanup, "next segment should not be covered");
+   MCTF_ASSERT(!pgmoneta_wal_bundle_covers(name, "000000010000000000000002"), cleanup, "previous segment should not be covered");
+   MCTF_ASSERT(!pgmoneta_wal_bundle_covers("backup.info", "000000010000000000000003"), cleanup, "other objects should not be bundles");
+
+cleanup:
+   free(name);
+   MCTF_FINISH();
+}
+
+/**
+ * Test: a segment is read back out of a bundle through its trailer and index.
+ */
+MCTF_TEST(test_walbundle_extract)
+{
+   char directory[MAX_PATH];
+   char bundle[MAX_PATH];
+   char path[MAX_PATH];
+   char trailer[WAL_BUNDLE_TRAILER_SIZE];
+   char* index = NULL;
+   char* segment = NULL;
+   uint64_t total = 0;
+   uint64_t offset = 0;
+   uint64_t length = 0;
+   FILE* file = NULL;
+   struct deque* files = NULL;
+   struct deque* entries = NULL;
+   struct wal_bundle_entry* entry = NULL;
+
+   pgmoneta_snprintf(directory, sizeof(directory), "%s/walbundle/wal", TEST_BASE_DIR);
+   pgmoneta_snprintf(bundle, sizeof(bundle), "%s/walbundle/test.bundle", TEST_BASE_DIR);
+
+   MCTF_ASSERT(pgmoneta_mkdir(directory) == 0, cleanup, "directory should be created");
+
+   pgmoneta_deque_create(false, &files);
+   for (int i = 0; i < 3; i++)
+   {
+      char name[MISC_LENGTH];
+
+      pgmoneta_snprintf(name, sizeof(name), "00000001000000000000000%d.zstd", i + 1);
+      MCTF_ASSERT(write_segment(directory, name, (char)('a' + i)) == 0, cleanup, "segment should be written");
+      pgmoneta_deque_add(files, name, (uintptr_t)name, ValueString);
+   }
+
+   MCTF_ASSERT(pgmoneta_wal_bundle_create(directory, files, bundle) == 0, cleanup, "bundle should be created");
+
+   /* The reader path of a ranged GET */
+   total = pgmoneta_get_file_size(bundle);
+   file = fopen(bundle, "r");
+   MCTF_ASSERT_PTR_NONNULL(file, cleanup, "bundle should open");
+   fseek(file, (long)(total - WAL_BUNDLE_TRAILER_SIZE), SEEK_SET);
+   MCTF_ASSERT(fread(&trailer[0], 1, sizeof(trailer), file) == sizeof(trailer), cleanup, "trailer should be read");
+   MCTF_ASSERT(pgmoneta_wal_bundle_read_trailer(&trailer[0], sizeof(trailer), total, &offset, &length) == 0, cleanup, "trailer should be valid");
+   MCTF_ASSERT(offset == 3 * WAL_BUNDLE_TEST_SIZE, cleanup, "index should follow the segments");
+
+   index = (char*)malloc(length);
+   MCTF_ASSERT_PTR_NONNULL(index, cleanup, "allocation should succeed");
+   fseek(file, (long)offset, SEEK_SET);
+   MCTF_ASSERT(fread(index, 1, length, file) == length, cleanup, "index should be read");
+   MCTF_ASSERT(pgmoneta_wal_bundle_read_index(index, length, &entries) == 0, cleanup, "index should be valid");
+   MCTF_ASSERT_INT_EQ((int)pgmoneta_deque_size(entries), 3, cleanup, "index should have all segments");
+
+   entry = (struct wal_bundle_entry*)pgmoneta_deque_get(entries, "000000010000000000000002.zstd");
+   MCTF_ASSERT_PTR_NONNULL(entry, cleanup, "segment should be in the index");
+   MCTF_ASSERT(entry->offset == WAL_BUNDLE_TEST_SIZE && entry->size == WAL_BUNDLE_TEST_SIZE, cleanup, "entry should match");
+   MCTF_ASSERT(pgmoneta_deque_get(entries, "000000010000000000000004.zstd") == 0, cleanup, "segment should not be in the index");
+
+   /* A single segment is found by its name without the suffix */
+   MCTF_ASSERT(pgmoneta_wal_bundle_find(entries, "000000010000000000000002") == entry, cleanup, "segment should be found");
+   MCTF_ASSERT_PTR_NULL(pgmoneta_wal_bundle_find(entries, "000000010000000000000004"), cleanup, "segment should not be found");
+
+   segment = (char*)malloc(entry->size);
+   MCTF_ASSERT_PTR_NONNULL(segment, cleanup, "allocation should succeed");
+   fseek(file, (long)entry->offset, SEEK_SET);
+   MCTF_ASSERT(fread(segment, 1, entry->size, file) == entry->size, cleanup, "segment should be read");
+   for (uint64_t i = 0; i < entry->size; i++)
+   {
+      MCTF_ASSERT(segment[i] == 'b', cleanup, "segment should match");
+   }
+
+   /* A damaged trailer is rejected */
+   trailer[WAL_BUNDLE_TRAILER_SIZE - 1] = 'X';
+   MCTF_ASSERT(pgmoneta_wal_bundle_read_trailer(&trailer[0], sizeof(trailer), total, &offset, &length) != 0, cleanup, "trailer should be invalid");
+
+cleanup:
+   if (file != NULL)
+   {
+      fclose(file);
+   }
+   free(index);
+   free(segment);
+   pgmoneta_deque_destroy(files);
+   pgmoneta_deque_destroy(entries);
+   pgmoneta_snprintf(path, sizeof(path), "%s/walbundle", TEST_BASE_DIR);
+   pgmoneta_delete_directory(path);
+   MCTF_FINISH();
+}